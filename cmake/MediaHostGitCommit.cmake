@@ -0,0 +1,30 @@
+# 构建时解析当前提交, 供基准测试记录
+#   -DSOURCE_DIR=<源码目录> -DHEADER=<生成的头文件>
+#   可选 -DBENCH=<基准程序> -DOUT_DIR=<目录>: 运行基准并按提交命名 JSON 结果
+execute_process(COMMAND git rev-parse --short HEAD
+    WORKING_DIRECTORY ${SOURCE_DIR}
+    OUTPUT_VARIABLE MEDIA_HOST_GIT_COMMIT
+    OUTPUT_STRIP_TRAILING_WHITESPACE ERROR_QUIET)
+if(NOT MEDIA_HOST_GIT_COMMIT)
+    set(MEDIA_HOST_GIT_COMMIT unknown)
+endif()
+
+if(BENCH)
+    execute_process(COMMAND ${BENCH}
+            --benchmark_out=${OUT_DIR}/media_host_bench_${MEDIA_HOST_GIT_COMMIT}.json
+            --benchmark_out_format=json
+        RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "media_host_bench failed: ${result}")
+    endif()
+    return()
+endif()
+
+# 内容不变时不改写, 避免每次构建都重新编译基准程序
+set(content "#define MEDIA_HOST_GIT_COMMIT \"${MEDIA_HOST_GIT_COMMIT}\"\n")
+if(EXISTS ${HEADER})
+    file(READ ${HEADER} old)
+endif()
+if(NOT "${old}" STREQUAL "${content}")
+    file(WRITE ${HEADER} "${content}")
+endif()
@@ -0,0 +1,161 @@
+#ifndef HB_MEDIA_BUFPOOL_H
+#define HB_MEDIA_BUFPOOL_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Maximum number of (capacity, alignment) buckets of the pool */
+#define MC_BUFPOOL_MAX_BUCKETS 64
+
+/**
+ * Define one physically contiguous buffer of the pool.
+ **/
+typedef struct _mc_bufpool_buffer {
+    /* Physical address, aligned to align */
+    hb_u64 phys_addr;
+    /* Virtual address of the mapping */
+    hb_u8 *virt_addr;
+    /* Shareable fd of the buffer, -1 if the allocator has none */
+    hb_s32 fd;
+    /* Requested size and the bucket capacity behind it */
+    hb_u32 size;
+    hb_u32 capacity;
+    hb_u32 align;
+    /* Owned by the allocator */
+    void *priv;
+} mc_bufpool_buffer_t;
+
+/**
+ * Define the allocator behind the pool. alloc fills phys_addr,
+ * virt_addr, fd and priv of a buffer of capacity bytes aligned to align
+ * and returns 0 on success, free releases it again.
+ **/
+typedef struct _mc_bufpool_allocator {
+    hb_s32 (*alloc)(void *userdata, hb_u32 capacity, hb_u32 align,
+        mc_bufpool_buffer_t *buf);
+    void (*free)(void *userdata, mc_bufpool_buffer_t *buf);
+    void *userdata;
+} mc_bufpool_allocator_t;
+
+/**
+ * Define the parameters of the buffer pool.
+ **/
+typedef struct _mc_bufpool_params {
+    /**
+     * The allocator, both callbacks NULL for the built-in memfd allocator.
+     * The memfd allocator has page aligned virtual addresses and made up
+     * physical addresses, it stands in for ION/hbmem on a host.
+     *
+     * - Note: It's changable parameter only while the pool holds no buffer.
+     * - Default: memfd allocator
+     */
+    mc_bufpool_allocator_t allocator;
+
+    /**
+     * Maximum bytes kept idle in the pool, a returned buffer beyond it is
+     * freed. 0 keeps every buffer.
+     * Values[>=0]
+     *
+     * - Note: It's changable parameter.
+     * - Default: 0
+     */
+    hb_u64 max_idle_bytes;
+} mc_bufpool_params_t;
+
+/**
+ * Define the statistics of the buffer pool.
+ **/
+typedef struct _mc_bufpool_stats {
+    /* Buffers handed out from idle buffers and from the allocator */
+    hb_u64 hits;
+    hb_u64 misses;
+    /* Buffers freed because of max_idle_bytes or a trim */
+    hb_u64 trimmed;
+    /* Buffers handed out, their requested and their capacity bytes */
+    hb_u32 used_num;
+    hb_u64 used_size;
+    hb_u64 used_bytes;
+    /* Buffers kept idle and their bytes */
+    hb_u32 idle_num;
+    hb_u64 idle_bytes;
+    /* Maximum used plus idle bytes */
+    hb_u64 peak_bytes;
+    hb_u32 buckets;
+    /**
+     * Bytes held but not requested, the rounding of the used buffers plus
+     * the idle buffers, in per mille of all the bytes held.
+     */
+    hb_u32 fragmentation;
+} mc_bufpool_stats_t;
+
+/**
+ * Configure the process wide buffer pool. The pool needs no set up, it
+ * starts with the default parameters on the first buffer.
+ *
+ * @param[in]       pool parameters @see mc_bufpool_params_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_bufpool_configure(const mc_bufpool_params_t *params);
+
+/**
+ * Allocate idle buffers ahead of the first session so it starts without
+ * paying for the allocation.
+ *
+ * @param[in]       buffer size in bytes, Values[>0]
+ * @param[in]       alignment in bytes, Values[power of 2]
+ * @param[in]       number of buffers the bucket should hold idle
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_bufpool_prewarm(hb_u32 size, hb_u32 align, hb_u32 num);
+
+/**
+ * Take a buffer from the pool. Sizes are rounded up to buckets with at
+ * most 1/8 spare bytes, so a session with a slightly different
+ * resolution reuses the buffers of the previous one.
+ *
+ * @param[in]       buffer size in bytes, Values[>0]
+ * @param[in]       alignment in bytes, Values[power of 2]
+ * @param[out]      buffer @see mc_bufpool_buffer_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_bufpool_get(hb_u32 size, hb_u32 align,
+				mc_bufpool_buffer_t *buf);
+
+/**
+ * Return a buffer to the pool.
+ *
+ * @param[in]       buffer got from the pool
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_bufpool_put(const mc_bufpool_buffer_t *buf);
+
+/**
+ * Free idle buffers, the buckets holding the most bytes first, until at
+ * most max_idle_bytes stay idle. 0 frees every idle buffer.
+ *
+ * @param[in]       idle bytes to keep
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_bufpool_trim(hb_u64 max_idle_bytes);
+
+/**
+ * Get the statistics of the buffer pool.
+ *
+ * @param[out]      statistics @see mc_bufpool_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_bufpool_get_stats(mc_bufpool_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_BUFPOOL_H */
@@ -0,0 +1,133 @@
+#ifndef HB_MEDIA_CHUNK_H
+#define HB_MEDIA_CHUNK_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Maximum number of encoder instances sharing one file */
+#define MC_CHUNK_MAX_INSTANCES 8
+
+/**
+ * Read one source picture into an encoder input buffer. It's called from
+ * the thread of each instance, with frames of different chunks at the
+ * same time.
+ *
+ * @param[in]       userdata of mc_chunk_params_t
+ * @param[in]       frame index in the file
+ * @param[in,out]   input buffer of the encoder @see mc_video_frame_buffer_info_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+typedef hb_s32 (*mc_chunk_read_frame_t)(void *userdata, hb_u32 frame,
+				mc_video_frame_buffer_info_t *dst);
+
+/**
+ * Define the parameters of a chunked encoding. The frames are split into
+ * one run of whole GOPs per instance; every instance starts its chunk with
+ * an IDR, so each chunk is a closed GOP sequence and the chunks are joined
+ * into one stream in order.
+ **/
+typedef struct _mc_chunk_params {
+    /**
+     * Number of frames of the file.
+     * Values[>0]
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_u32 frame_num;
+
+    /**
+     * GOP size in frames, the intra period of the encoders. Chunks start
+     * on multiples of it.
+     * Values[>0]
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_u32 gop_size;
+
+    /**
+     * Source of the pictures @see mc_chunk_read_frame_t
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: NULL
+     */
+    mc_chunk_read_frame_t read_frame;
+    void *userdata;
+
+    /**
+     * Timeout in ms of each buffer dequeue.
+     * Values[>=-1]
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_s32 timeout;
+} mc_chunk_params_t;
+
+/**
+ * Define the statistics of a chunked encoding.
+ **/
+typedef struct _mc_chunk_stats {
+    /* Instances given a chunk */
+    hb_s32 chunks;
+    /* First frame and number of frames of each chunk */
+    hb_u32 chunk_start[MC_CHUNK_MAX_INSTANCES];
+    hb_u32 chunk_frames[MC_CHUNK_MAX_INSTANCES];
+    /* Time from the start of each instance to its end of stream in us */
+    hb_u64 busy_us[MC_CHUNK_MAX_INSTANCES];
+    /* Time of the whole encoding in us */
+    hb_u64 wall_us;
+    /* Size of the joined stream */
+    hb_u32 bytes;
+    /* Parameter sets dropped as repeats while joining */
+    hb_u32 dropped_param_sets;
+} mc_chunk_stats_t;
+
+/**
+ * Encode one file on several instances at the same time. The contexts
+ * are filled in like for hb_mm_mc_initialize() with the same encoding
+ * parameters and an IDR refresh; they are initialized, configured and
+ * started here one after the other, run in one thread each and stopped
+ * and released at the end.
+ *
+ * @param[in]       chunk parameters @see mc_chunk_params_t
+ * @param[in]       encoder contexts
+ * @param[in]       number of contexts, Values[1, MC_CHUNK_MAX_INSTANCES]
+ * @param[out]      joined stream, released with free()
+ * @param[out]      joined stream size
+ * @param[out]      statistics, may be NULL @see mc_chunk_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_chunk_encode(const mc_chunk_params_t *params,
+				media_codec_context_t **contexts, hb_s32 num, hb_u8 **stream,
+				hb_u32 *size, mc_chunk_stats_t *stats);
+
+/**
+ * Join the streams of consecutive chunks. A parameter set equal to the
+ * last one of its type already written is dropped, everything else is
+ * copied in order. The joined stream is never larger than the chunks.
+ *
+ * @param[in]       codec id, MEDIA_CODEC_ID_H264 or MEDIA_CODEC_ID_H265
+ * @param[in]       chunk streams
+ * @param[in]       chunk stream sizes
+ * @param[in]       number of chunks
+ * @param[out]      joined stream, as large as all chunks together
+ * @param[out]      joined stream size
+ * @param[out]      dropped parameter sets, may be NULL
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_chunk_join(media_codec_id_t codec_id,
+				const hb_u8 *const *chunks, const hb_u32 *sizes, hb_s32 num,
+				hb_u8 *dst, hb_u32 *size, hb_u32 *dropped);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_CHUNK_H */
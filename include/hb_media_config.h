@@ -0,0 +1,170 @@
+#ifndef HB_MEDIA_CONFIG_H
+#define HB_MEDIA_CONFIG_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Version of the snapshot files written by hb_mm_config_save() */
+#define MC_CONFIG_VERSION 1
+
+/**
+ * Define the sections of a configuration snapshot. Besides the encoding
+ * parameters each section is one side configuration set with its
+ * hb_mm_mc_set_* call between hb_mm_mc_initialize() and
+ * hb_mm_mc_configure().
+ **/
+typedef enum _mc_config_section {
+	MC_CONFIG_SECTION_ENC_PARAMS = 0,
+	MC_CONFIG_SECTION_LONGTERM_REF,
+	MC_CONFIG_SECTION_INTRA_REFRESH,
+	MC_CONFIG_SECTION_MAX_BIT_RATE,
+	MC_CONFIG_SECTION_DEBLK_FILTER,
+	MC_CONFIG_SECTION_SAO,
+	MC_CONFIG_SECTION_ENTROPY,
+	MC_CONFIG_SECTION_VUI_TIMING,
+	MC_CONFIG_SECTION_VUI,
+	MC_CONFIG_SECTION_SLICE,
+	MC_CONFIG_SECTION_3DNR,
+	MC_CONFIG_SECTION_SMART_BG,
+	MC_CONFIG_SECTION_PRED_UNIT,
+	MC_CONFIG_SECTION_TRANSFORM,
+	MC_CONFIG_SECTION_ROI,
+	MC_CONFIG_SECTION_MODE_DECISION,
+	MC_CONFIG_SECTION_EXPLICIT_HEADER,
+	MC_CONFIG_SECTION_TOTAL,
+} mc_config_section_t;
+
+/* Bit of a section in mc_config_snapshot_t.sections */
+#define MC_CONFIG_SECTION_BIT(section) (1U << (section))
+#define MC_CONFIG_SECTION_ALL ((1U << MC_CONFIG_SECTION_TOTAL) - 1)
+
+/**
+ * Define the file formats of a snapshot.
+ **/
+typedef enum _mc_config_format {
+	/* Sections of the raw parameters, checked with a CRC32 */
+	MC_CONFIG_FORMAT_BINARY = 0,
+	/**
+	 * "key = value" lines of the common parameters, followed by every
+	 * section in hex so that nothing is lost. A named value overrides the
+	 * hex one, so the file may be edited by hand.
+	 */
+	MC_CONFIG_FORMAT_TEXT,
+} mc_config_format_t;
+
+/**
+ * Define a configuration snapshot of an encoder.
+ **/
+typedef struct _mc_config_snapshot {
+	/**
+	 * Codec of the snapshot.
+	 * Values[MEDIA_CODEC_ID_H264, MEDIA_CODEC_ID_H265, MEDIA_CODEC_ID_MJPEG,
+	 * MEDIA_CODEC_ID_JPEG]
+	 *
+	 * - Note: It's unchangable parameter.
+	 * - Default: MEDIA_CODEC_ID_NONE
+	 */
+	media_codec_id_t codec_id;
+
+	/**
+	 * Sections present in the snapshot, OR of MC_CONFIG_SECTION_BIT().
+	 * MC_CONFIG_SECTION_ENC_PARAMS is always present.
+	 *
+	 * - Note: It's changable parameter.
+	 * - Default: 0
+	 */
+	hb_u32 sections;
+
+	mc_video_codec_enc_params_t enc_params;
+	mc_video_longterm_ref_mode_t longterm_ref;
+	mc_video_intra_refresh_params_t intra_refresh;
+	hb_u32 max_bit_rate;
+	mc_video_deblk_filter_params_t deblk_filter;
+	mc_h265_sao_params_t sao;
+	mc_h264_entropy_params_t entropy;
+	mc_video_vui_timing_params_t vui_timing;
+	mc_video_vui_params_t vui;
+	mc_video_slice_params_t slice;
+	mc_video_3dnr_enc_params_t noise_reduction;
+	mc_video_smart_bg_enc_params_t smart_bg;
+	mc_video_pred_unit_params_t pred_unit;
+	mc_video_transform_params_t transform;
+	/**
+	 * The ROI map of roi_map_array_count bytes is owned by the snapshot
+	 * after hb_mm_config_capture() or hb_mm_config_load(), free it with
+	 * hb_mm_config_release().
+	 */
+	mc_video_roi_params_t roi;
+	mc_video_mode_decision_params_t mode_decision;
+	hb_s32 explicit_header;
+} mc_config_snapshot_t;
+
+/**
+ * Take a snapshot of an initialized encoder. The encoding parameters are
+ * copied from the context, the side configurations are read back with
+ * their hb_mm_mc_get_* calls. Sections that don't apply to the codec are
+ * left out.
+ *
+ * @param[in]       codec context @see media_codec_context_t
+ * @param[in]       sections to take, OR of MC_CONFIG_SECTION_BIT()
+ * @param[out]      snapshot @see mc_config_snapshot_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_config_capture(media_codec_context_t *context,
+				hb_u32 sections, mc_config_snapshot_t *snap);
+
+/**
+ * Write a snapshot to a file. The file is written next to the path and
+ * renamed over it, a reader never sees half a snapshot.
+ *
+ * @param[in]       file path
+ * @param[in]       snapshot @see mc_config_snapshot_t
+ * @param[in]       file format @see mc_config_format_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_config_save(const char *path,
+				const mc_config_snapshot_t *snap, mc_config_format_t format);
+
+/**
+ * Read a snapshot from a file of either format with one read. A binary
+ * file of another version or with a broken CRC32 is refused.
+ *
+ * @param[in]       file path
+ * @param[out]      snapshot @see mc_config_snapshot_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_config_load(const char *path, mc_config_snapshot_t *snap);
+
+/**
+ * Set up an encoder from a snapshot. The context gets the codec and the
+ * encoding parameters, is initialized unless it already is, gets every
+ * side configuration of the snapshot and is configured. Start it with
+ * hb_mm_mc_start() afterwards.
+ *
+ * @param[in]       codec context, uninitialized or initialized
+ * @param[in]       snapshot @see mc_config_snapshot_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_config_apply(media_codec_context_t *context,
+				const mc_config_snapshot_t *snap);
+
+/**
+ * Free the ROI map owned by a snapshot.
+ *
+ * @param[in]       snapshot @see mc_config_snapshot_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_config_release(mc_config_snapshot_t *snap);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_CONFIG_H */
@@ -0,0 +1,156 @@
+#ifndef HB_MEDIA_DIGEST_H
+#define HB_MEDIA_DIGEST_H
+
+#include "hb_media_basic_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Define the hashes computed for each frame.
+ **/
+typedef enum _mc_digest_algo {
+	MC_DIGEST_ALGO_MD5 = 0,
+	/* 64 bits XXH3 without seed */
+	MC_DIGEST_ALGO_XXH3,
+	MC_DIGEST_ALGO_TOTAL,
+} mc_digest_algo_t;
+
+#define MC_DIGEST_ALGO_BIT(algo) (1U << (algo))
+
+#define MC_DIGEST_MD5_SIZE 16
+
+/**
+ * Define the parameters of a frame digest. The golden file has a version
+ * line followed by one line per frame:
+ * "<frame> <md5 in hex or -> <xxh3 in hex or ->".
+ **/
+typedef struct _mc_digest_params {
+    /**
+     * Hashes computed for each frame, MC_DIGEST_ALGO_BIT() of
+     * mc_digest_algo_t.
+     * Values[>0]
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: MD5 | XXH3
+     */
+    hb_u32 algos;
+
+    /**
+     * Golden file the frames are verified against, read one line per
+     * frame. Only the hashes present in both are compared. NULL verifies
+     * nothing.
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: NULL
+     */
+    const char *golden_file;
+
+    /**
+     * File the digests of the frames are written to, in the golden file
+     * format. NULL records nothing.
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: NULL
+     */
+    const char *record_file;
+} mc_digest_params_t;
+
+/**
+ * Define the digest of one frame.
+ **/
+typedef struct _mc_digest_frame {
+    hb_u32 index;
+    hb_u8 md5[MC_DIGEST_MD5_SIZE];
+    hb_u64 xxh3;
+} mc_digest_frame_t;
+
+/**
+ * Define the verification result against the golden file.
+ **/
+typedef struct _mc_digest_result {
+    /* Frames hashed */
+    hb_u32 frames;
+    /* Frames of the golden file read so far */
+    hb_u32 golden_frames;
+    /* Frames differing from the golden file, or missing from it */
+    hb_u32 mismatched;
+    /* Index of the first mismatched frame, -1 if none */
+    hb_s32 first_mismatch;
+} mc_digest_result_t;
+
+typedef struct _mc_digest mc_digest_t;
+
+/**
+ * Create a frame digest.
+ *
+ * @param[in]       digest parameters @see mc_digest_params_t
+ * @param[out]      frame digest
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_digest_create(const mc_digest_params_t *params,
+				mc_digest_t **digest);
+
+/**
+ * Hash the next part of the current frame. A frame may be handed over in
+ * as many parts as it was dequeued in.
+ *
+ * @param[in]       frame digest
+ * @param[in]       data
+ * @param[in]       data size
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_digest_update(mc_digest_t *digest, const hb_u8 *data,
+				hb_u32 size);
+
+/**
+ * Finish the current frame, verify and record its digest.
+ *
+ * @param[in]       frame digest
+ * @param[out]      digest of the frame, may be NULL @see mc_digest_frame_t
+ *
+ * @return =0 if the frame matches the golden file or nothing is verified,
+ *         1 on mismatch, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_digest_end_frame(mc_digest_t *digest,
+				mc_digest_frame_t *frame);
+
+/**
+ * Get the verification result. Golden frames beyond the hashed ones are
+ * counted as mismatched.
+ *
+ * @param[in]       frame digest
+ * @param[out]      verification result @see mc_digest_result_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_digest_get_result(mc_digest_t *digest,
+				mc_digest_result_t *result);
+
+/**
+ * Destroy the frame digest, flushing the record file.
+ *
+ * @param[in]       frame digest
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_digest_destroy(mc_digest_t *digest);
+
+/**
+ * One shot hashes of a buffer.
+ *
+ * @param[in]       data
+ * @param[in]       data size
+ * @param[out]      hash
+ */
+extern void hb_mm_digest_md5(const hb_u8 *data, hb_u32 size,
+				hb_u8 md5[MC_DIGEST_MD5_SIZE]);
+extern hb_u64 hb_mm_digest_xxh3(const hb_u8 *data, hb_u32 size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_DIGEST_H */
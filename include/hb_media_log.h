@@ -0,0 +1,297 @@
+#ifndef HB_MEDIA_LOG_H
+#define HB_MEDIA_LOG_H
+
+#include "hb_media_basic_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Define the log levels, in the order of the VPU library levels.
+ **/
+typedef enum _mc_log_level {
+	MC_LOG_LEVEL_NONE = 0,
+	MC_LOG_LEVEL_INFO,
+	MC_LOG_LEVEL_WARN,
+	MC_LOG_LEVEL_ERR,
+	MC_LOG_LEVEL_TRACE,
+	MC_LOG_LEVEL_TOTAL,
+} mc_log_level_t;
+
+/* Bit of a level in mc_log_params_t.level_mask */
+#define MC_LOG_LEVEL_BIT(level) (1U << (level))
+
+/* Maximum arguments of one log call and bytes kept of a string argument */
+#define MC_LOG_MAX_ARGS 16
+#define MC_LOG_MAX_STRING 256
+
+/**
+ * Define the parameters of the logger. Every thread writes its records
+ * into a ring of its own without locks, the format string is only
+ * expanded by a background flusher which writes them out in time order.
+ **/
+typedef struct _mc_log_params {
+    /**
+     * Levels written out, OR of MC_LOG_LEVEL_BIT().
+     *
+     * - Note: It's changable parameter.
+     * - Default: MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_WARN) |
+     *            MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_ERR)
+     */
+    hb_u32 level_mask;
+
+    /**
+     * File descriptor written by the flusher.
+     *
+     * - Note: It's changable parameter.
+     * - Default: 2
+     */
+    hb_s32 fd;
+
+    /**
+     * Bytes of the ring of each thread. A record that doesn't fit is
+     * dropped, the writer never waits.
+     * Values[4096, 16777216], power of 2
+     *
+     * - Note: It's changable parameter, for threads logging the first time.
+     * - Default: 65536
+     */
+    hb_u32 ring_size;
+
+    /**
+     * Records per call site and second, the rest is counted and reported
+     * with the next record of the site. 0 for no limit.
+     * Values[>=0]
+     *
+     * - Note: It's changable parameter.
+     * - Default: 0
+     */
+    hb_u32 rate_limit;
+
+    /**
+     * Period of the flusher in ms.
+     * Values[1, 1000]
+     *
+     * - Note: It's changable parameter.
+     * - Default: 10
+     */
+    hb_u32 flush_interval_ms;
+
+    /**
+     * Prefix each line with the time, the thread id and the level.
+     * Values[0, 1]
+     *
+     * - Note: It's changable parameter.
+     * - Default: 0
+     */
+    hb_bool prefix;
+} mc_log_params_t;
+
+/**
+ * Define the statistics of the logger.
+ **/
+typedef struct _mc_log_stats {
+    /* Records written into the rings */
+    hb_u64 written;
+    /* Records dropped because a ring was full */
+    hb_u64 dropped;
+    /* Records held back by the rate limit */
+    hb_u64 limited;
+    /* Records written out by the flusher */
+    hb_u64 flushed;
+    /* Rings of all the threads that ever logged */
+    hb_u32 rings;
+} mc_log_stats_t;
+
+typedef enum _mc_log_arg_type {
+	MC_LOG_ARG_INT = 0,
+	MC_LOG_ARG_UINT,
+	MC_LOG_ARG_DOUBLE,
+	MC_LOG_ARG_STRING,
+	MC_LOG_ARG_POINTER,
+} mc_log_arg_type_t;
+
+/* One argument of a log call, strings are copied into the ring */
+typedef struct _mc_log_arg {
+	hb_u32 type;
+	union {
+		long long i;
+		unsigned long long u;
+		double d;
+		const char *s;
+		const void *p;
+	};
+} mc_log_arg_t;
+
+/* A call site, static at each HB_MM_LOG() */
+typedef struct _mc_log_site {
+	const char *fmt;
+	hb_s32 level;
+	/* Rate limit window in s and the records written in it */
+	hb_u32 window;
+	hb_u32 count;
+	hb_u32 suppressed;
+} mc_log_site_t;
+
+/**
+ * Configure the logger. It needs no set up, it starts with the default
+ * parameters on the first record.
+ *
+ * @param[in]       logger parameters @see mc_log_params_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_log_configure(const mc_log_params_t *params);
+
+/**
+ * Write out every record logged so far by any thread, without waiting for
+ * the flusher. It's called at exit as well.
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_log_flush(void);
+
+/**
+ * Get the statistics of the logger.
+ *
+ * @param[out]      statistics @see mc_log_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_log_get_stats(mc_log_stats_t *stats);
+
+/* Level check of HB_MM_LOG(), before any argument is evaluated */
+extern hb_u32 hb_mm_log_level_mask;
+
+/* Record of HB_MM_LOG() with argc arguments */
+extern void hb_mm_log_write(mc_log_site_t *site, const mc_log_arg_t *args,
+				hb_u32 argc);
+
+static inline mc_log_arg_t hb_mm_log_arg_int(long long v)
+{
+	mc_log_arg_t a;
+	a.type = MC_LOG_ARG_INT;
+	a.i = v;
+	return a;
+}
+
+static inline mc_log_arg_t hb_mm_log_arg_uint(unsigned long long v)
+{
+	mc_log_arg_t a;
+	a.type = MC_LOG_ARG_UINT;
+	a.u = v;
+	return a;
+}
+
+static inline mc_log_arg_t hb_mm_log_arg_double(double v)
+{
+	mc_log_arg_t a;
+	a.type = MC_LOG_ARG_DOUBLE;
+	a.d = v;
+	return a;
+}
+
+static inline mc_log_arg_t hb_mm_log_arg_string(const char *v)
+{
+	mc_log_arg_t a;
+	a.type = MC_LOG_ARG_STRING;
+	a.s = v;
+	return a;
+}
+
+static inline mc_log_arg_t hb_mm_log_arg_pointer(const void *v)
+{
+	mc_log_arg_t a;
+	a.type = MC_LOG_ARG_POINTER;
+	a.p = v;
+	return a;
+}
+
+#ifdef __cplusplus
+}
+
+/* The type of each argument picks its slot, the format is not parsed */
+#define HB_MM_LOG_ARG_FN(type, fn) \
+	static inline mc_log_arg_t hb_mm_log_arg(type v) { return fn(v); }
+HB_MM_LOG_ARG_FN(char, hb_mm_log_arg_int)
+HB_MM_LOG_ARG_FN(signed char, hb_mm_log_arg_int)
+HB_MM_LOG_ARG_FN(short, hb_mm_log_arg_int)
+HB_MM_LOG_ARG_FN(int, hb_mm_log_arg_int)
+HB_MM_LOG_ARG_FN(long, hb_mm_log_arg_int)
+HB_MM_LOG_ARG_FN(long long, hb_mm_log_arg_int)
+HB_MM_LOG_ARG_FN(bool, hb_mm_log_arg_uint)
+HB_MM_LOG_ARG_FN(unsigned char, hb_mm_log_arg_uint)
+HB_MM_LOG_ARG_FN(unsigned short, hb_mm_log_arg_uint)
+HB_MM_LOG_ARG_FN(unsigned int, hb_mm_log_arg_uint)
+HB_MM_LOG_ARG_FN(unsigned long, hb_mm_log_arg_uint)
+HB_MM_LOG_ARG_FN(unsigned long long, hb_mm_log_arg_uint)
+HB_MM_LOG_ARG_FN(double, hb_mm_log_arg_double)
+HB_MM_LOG_ARG_FN(const char *, hb_mm_log_arg_string)
+HB_MM_LOG_ARG_FN(const void *, hb_mm_log_arg_pointer)
+#define MC_LOG_ARG(x) hb_mm_log_arg(x)
+#else
+/* The type of each argument picks its slot, the format is not parsed */
+#define MC_LOG_ARG(x) _Generic((x), \
+	char: hb_mm_log_arg_int, \
+	signed char: hb_mm_log_arg_int, \
+	short: hb_mm_log_arg_int, \
+	int: hb_mm_log_arg_int, \
+	long: hb_mm_log_arg_int, \
+	long long: hb_mm_log_arg_int, \
+	_Bool: hb_mm_log_arg_uint, \
+	unsigned char: hb_mm_log_arg_uint, \
+	unsigned short: hb_mm_log_arg_uint, \
+	unsigned int: hb_mm_log_arg_uint, \
+	unsigned long: hb_mm_log_arg_uint, \
+	unsigned long long: hb_mm_log_arg_uint, \
+	float: hb_mm_log_arg_double, \
+	double: hb_mm_log_arg_double, \
+	char *: hb_mm_log_arg_string, \
+	const char *: hb_mm_log_arg_string, \
+	default: hb_mm_log_arg_pointer)(x)
+#endif /* __cplusplus */
+
+#define MC_LOG_NARG(...) MC_LOG_NARG_(_, ##__VA_ARGS__, 16, 15, 14, 13, \
+	12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define MC_LOG_NARG_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, \
+	_13, _14, _15, _16, n, ...) n
+#define MC_LOG_CAT(a, b) MC_LOG_CAT_(a, b)
+#define MC_LOG_CAT_(a, b) a##b
+#define MC_LOG_ARGS_0()
+#define MC_LOG_ARGS_1(a) MC_LOG_ARG(a),
+#define MC_LOG_ARGS_2(a, ...) MC_LOG_ARG(a), MC_LOG_ARGS_1(__VA_ARGS__)
+#define MC_LOG_ARGS_3(a, ...) MC_LOG_ARG(a), MC_LOG_ARGS_2(__VA_ARGS__)
+#define MC_LOG_ARGS_4(a, ...) MC_LOG_ARG(a), MC_LOG_ARGS_3(__VA_ARGS__)
+#define MC_LOG_ARGS_5(a, ...) MC_LOG_ARG(a), MC_LOG_ARGS_4(__VA_ARGS__)
+#define MC_LOG_ARGS_6(a, ...) MC_LOG_ARG(a), MC_LOG_ARGS_5(__VA_ARGS__)
+#define MC_LOG_ARGS_7(a, ...) MC_LOG_ARG(a), MC_LOG_ARGS_6(__VA_ARGS__)
+#define MC_LOG_ARGS_8(a, ...) MC_LOG_ARG(a), MC_LOG_ARGS_7(__VA_ARGS__)
+#define MC_LOG_ARGS_9(a, ...) MC_LOG_ARG(a), MC_LOG_ARGS_8(__VA_ARGS__)
+#define MC_LOG_ARGS_10(a, ...) MC_LOG_ARG(a), MC_LOG_ARGS_9(__VA_ARGS__)
+#define MC_LOG_ARGS_11(a, ...) MC_LOG_ARG(a), MC_LOG_ARGS_10(__VA_ARGS__)
+#define MC_LOG_ARGS_12(a, ...) MC_LOG_ARG(a), MC_LOG_ARGS_11(__VA_ARGS__)
+#define MC_LOG_ARGS_13(a, ...) MC_LOG_ARG(a), MC_LOG_ARGS_12(__VA_ARGS__)
+#define MC_LOG_ARGS_14(a, ...) MC_LOG_ARG(a), MC_LOG_ARGS_13(__VA_ARGS__)
+#define MC_LOG_ARGS_15(a, ...) MC_LOG_ARG(a), MC_LOG_ARGS_14(__VA_ARGS__)
+#define MC_LOG_ARGS_16(a, ...) MC_LOG_ARG(a), MC_LOG_ARGS_15(__VA_ARGS__)
+
+/**
+ * printf like logging of at most MC_LOG_MAX_ARGS arguments. The format
+ * must be a string literal, it is expanded later by the flusher.
+ */
+#define HB_MM_LOG(level, fmt, ...) \
+	do { \
+		if (__atomic_load_n(&hb_mm_log_level_mask, __ATOMIC_RELAXED) & \
+			(1U << (level))) { \
+			static mc_log_site_t hb_mm_log_site_ = {fmt, level, 0, 0, 0}; \
+			/* One more slot so that the array is never empty */ \
+			const mc_log_arg_t hb_mm_log_args_[] = { \
+				MC_LOG_CAT(MC_LOG_ARGS_, MC_LOG_NARG(__VA_ARGS__))( \
+				__VA_ARGS__) hb_mm_log_arg_int(0)}; \
+			hb_mm_log_write(&hb_mm_log_site_, hb_mm_log_args_, \
+				MC_LOG_NARG(__VA_ARGS__)); \
+		} \
+	} while (0)
+
+#endif /* HB_MEDIA_LOG_H */
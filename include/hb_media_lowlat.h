@@ -0,0 +1,178 @@
+#ifndef HB_MEDIA_LOWLAT_H
+#define HB_MEDIA_LOWLAT_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Define the parameters of the low latency mode. After the first IDR the
+ * encoder sends no intra picture; a rolling row intra refresh cleans the
+ * whole picture once per refresh cycle instead, and the CBR buffer only
+ * holds a few pictures, so every picture gets about the same budget and
+ * the link never has to carry an IDR burst.
+ **/
+typedef struct _mc_lowlat_params {
+    /**
+     * Bitrate of the link.
+     * Values[1,700000]kbps
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_u32 bit_rate;
+
+    /**
+     * Frame rate.
+     * Values[1,240]fps
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_u32 frame_rate;
+
+    /**
+     * Pictures of one intra refresh cycle, rounded so every picture
+     * refreshes the same number of MB(16) or CTU(64) rows.
+     * Values[1,picture rows]
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_u32 refresh_frames;
+
+    /**
+     * Pictures the CBR buffer holds, vbv_buffer_size is at least 10ms.
+     * Values[1,30]
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_u32 budget_frames;
+
+    /**
+     * Most pictures from a loss report until the refresh has cleaned the
+     * picture; a loss healing later requests an IDR. 0 for IDRs only.
+     * Values[>=0]
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_u32 max_recovery_frames;
+
+    /**
+     * Minimum pictures between two IDRs requested for losses.
+     * Values[>=0]
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_u32 min_idr_interval;
+} mc_lowlat_params_t;
+
+/**
+ * Define the statistics of the low latency mode. The link delay is that
+ * of a link carrying bit_rate, sending each picture once it is encoded.
+ **/
+typedef struct _mc_lowlat_stats {
+    /* Pictures and their bytes */
+    hb_u64 frames;
+    hb_u64 bytes;
+    /* Largest picture and standard deviation of the sizes in bytes */
+    hb_u32 max_frame_bytes;
+    hb_u32 frame_bytes_stddev;
+    /* Time pictures wait for the link and take on it in us */
+    hb_u64 avg_link_delay_us;
+    hb_u64 max_link_delay_us;
+    /* Pictures of one refresh cycle */
+    hb_u32 refresh_frames;
+    /* Losses reported, healed by the refresh and by an IDR */
+    hb_u64 losses;
+    hb_u64 refresh_recoveries;
+    hb_u64 idr_recoveries;
+    /* A loss isn't healed yet, the picture healing it */
+    hb_bool recovering;
+    hb_u64 recovery_frame;
+} mc_lowlat_stats_t;
+
+typedef struct _mc_lowlat mc_lowlat_t;
+
+/**
+ * Fill in the rate control and GOP of an H264 or H265 encoder context for
+ * the low latency mode before hb_mm_mc_initialize(). The intra refresh
+ * can only be set on an initialized instance; pass the returned one to
+ * hb_mm_mc_set_intra_refresh_config() before hb_mm_mc_configure().
+ *
+ * @param[in]       low latency parameters @see mc_lowlat_params_t
+ * @param[in,out]   encoder context with codec id, width and height
+ * @param[out]      intra refresh @see mc_video_intra_refresh_params_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_lowlat_preset(const mc_lowlat_params_t *params,
+				media_codec_context_t *context,
+				mc_video_intra_refresh_params_t *refresh);
+
+/**
+ * Create the loss recovery and statistics of an encoder in the low
+ * latency mode.
+ *
+ * @param[in]       encoder instance
+ * @param[in]       low latency parameters @see mc_lowlat_params_t
+ * @param[out]      low latency controller
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_lowlat_create(media_codec_context_t *context,
+				const mc_lowlat_params_t *params, mc_lowlat_t **ll);
+
+/**
+ * Account one encoded picture. Call it with the information of every
+ * dequeued output buffer; pictures are numbered from 0 in this order.
+ *
+ * @param[in]       low latency controller
+ * @param[in]       output buffer information @see media_codec_output_buffer_info_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_lowlat_update(mc_lowlat_t *ll,
+				const media_codec_output_buffer_info_t *info);
+
+/**
+ * Report a picture the receiver lost. The pictures after it are clean
+ * once a whole refresh cycle started after it; when that is more than
+ * max_recovery_frames away an IDR is requested instead.
+ *
+ * @param[in]       low latency controller
+ * @param[in]       number of the lost picture
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_lowlat_report_loss(mc_lowlat_t *ll, hb_u64 frame);
+
+/**
+ * Get the statistics of the low latency mode.
+ *
+ * @param[in]       low latency controller
+ * @param[out]      statistics @see mc_lowlat_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_lowlat_get_stats(mc_lowlat_t *ll,
+				mc_lowlat_stats_t *stats);
+
+/**
+ * Destroy the low latency controller.
+ *
+ * @param[in]       low latency controller
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_lowlat_destroy(mc_lowlat_t *ll);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_LOWLAT_H */
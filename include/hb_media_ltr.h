@@ -0,0 +1,154 @@
+#ifndef HB_MEDIA_LTR_H
+#define HB_MEDIA_LTR_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Define the parameters of the long-term reference controller. It follows
+ * how static the scene is from the skip and intra blocks of the encoded
+ * pictures. While the scene stays static the long-term reference is kept
+ * longer, doubling longterm_pic_period every hold_frames pictures, so the
+ * background stays referenced; motion brings the period back to the
+ * minimum at once. The encoder must be configured with use_longterm.
+ **/
+typedef struct _mc_ltr_params {
+    /**
+     * Skip blocks in per mille of all 8x8 blocks, smoothed over about 8
+     * pictures, from which the scene is static.
+     * Values[1,1000]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 static_skip_permille;
+
+    /**
+     * Intra blocks in per mille of all 16x16 blocks, smoothed the same
+     * way, above which the scene isn't static.
+     * Values[0,1000]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 max_intra_permille;
+
+    /**
+     * Static pictures before the period is doubled again.
+     * Values[>0]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 hold_frames;
+
+    /**
+     * Range of longterm_pic_period.
+     * Values[1,2^31-1], min_pic_period <= max_pic_period
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 min_pic_period;
+    hb_u32 max_pic_period;
+
+    /**
+     * longterm_pic_using_period of a static scene and of a moving one.
+     * Values[0,2^31-1]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 static_using_period;
+    hb_u32 motion_using_period;
+} mc_ltr_params_t;
+
+/**
+ * Define the metrics of the long-term reference controller.
+ **/
+typedef struct _mc_ltr_stats {
+    /* Pictures seen and pictures of a static scene */
+    hb_u64 frames;
+    hb_u64 static_frames;
+    /* Settings sent to the encoder and rejected by it */
+    hb_u64 updates;
+    hb_u64 set_failures;
+    /* Settings of the encoder */
+    hb_u32 pic_period;
+    hb_u32 using_period;
+    /* Smoothed skip and intra blocks in per mille */
+    hb_u32 skip_permille;
+    hb_u32 intra_permille;
+    /* P pictures and their bytes, to compare with a fixed setting */
+    hb_u64 p_frames;
+    hb_u64 p_bytes;
+} mc_ltr_stats_t;
+
+typedef struct _mc_ltr mc_ltr_t;
+
+/**
+ * Create the long-term reference controller of an encoder configured
+ * with use_longterm. The encoder is set to min_pic_period and
+ * motion_using_period until the scene turns out static.
+ *
+ * @param[in]       encoder instance
+ * @param[in]       controller parameters @see mc_ltr_params_t
+ * @param[out]      long-term reference controller
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_ltr_create(media_codec_context_t *context,
+				const mc_ltr_params_t *params, mc_ltr_t **ltr);
+
+/**
+ * Change the thresholds and periods. They are applied from the next
+ * picture on.
+ *
+ * @param[in]       long-term reference controller
+ * @param[in]       controller parameters @see mc_ltr_params_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_ltr_set_params(mc_ltr_t *ltr,
+				const mc_ltr_params_t *params);
+
+/**
+ * Account one encoded picture. Call it with the information of every
+ * dequeued output buffer; a new period is sent to the encoder before the
+ * call returns.
+ *
+ * @param[in]       long-term reference controller
+ * @param[in]       output buffer information @see media_codec_output_buffer_info_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_ltr_update(mc_ltr_t *ltr,
+				const media_codec_output_buffer_info_t *info);
+
+/**
+ * Get the metrics of the long-term reference controller.
+ *
+ * @param[in]       long-term reference controller
+ * @param[out]      metrics @see mc_ltr_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_ltr_get_stats(mc_ltr_t *ltr, mc_ltr_stats_t *stats);
+
+/**
+ * Destroy the long-term reference controller. The encoder keeps the last
+ * setting.
+ *
+ * @param[in]       long-term reference controller
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_ltr_destroy(mc_ltr_t *ltr);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_LTR_H */
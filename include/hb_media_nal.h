@@ -0,0 +1,75 @@
+#ifndef HB_MEDIA_NAL_H
+#define HB_MEDIA_NAL_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Define one NAL unit found in an Annex-B byte stream.
+ **/
+typedef struct _mc_nal_unit {
+    /**
+     * Offset of the start code in the scanned buffer.
+     */
+    hb_u32 offset;
+
+    /**
+     * Size in bytes of the NAL unit including its start code.
+     */
+    hb_u32 size;
+
+    /**
+     * Size in bytes of the start code, 3 or 4.
+     */
+    hb_u32 start_code_size;
+
+    /**
+     * NAL unit type.
+     * @see mc_h264_nal_unit_type_t
+     * @see mc_h265_nal_unit_type_t
+     */
+    hb_s32 type;
+} mc_nal_unit_t;
+
+/**
+ * Find the next NAL unit of an Annex-B byte stream.
+ *
+ * @param[in]       codec id, MEDIA_CODEC_ID_H264 or MEDIA_CODEC_ID_H265
+ * @param[in]       byte stream
+ * @param[in]       byte stream size
+ * @param[in,out]   scan position, set to 0 before the first call
+ * @param[out]      the found NAL unit @see mc_nal_unit_t
+ *
+ * @return 1 if a NAL unit is found, 0 at the end of the stream,
+ *         negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_nal_next(media_codec_id_t codec_id, const hb_u8 *data,
+				hb_u32 size, hb_u32 *pos, mc_nal_unit_t *nal);
+
+/**
+ * Check whether the NAL unit type is a parameter set (VPS/SPS/PPS).
+ *
+ * @param[in]       codec id, MEDIA_CODEC_ID_H264 or MEDIA_CODEC_ID_H265
+ * @param[in]       NAL unit type
+ *
+ * @return 1 if it's a parameter set, otherwise 0
+ */
+extern hb_bool hb_mm_nal_is_param_set(media_codec_id_t codec_id, hb_s32 type);
+
+/**
+ * Check whether the NAL unit type is an IDR (or IRAP for H265) slice.
+ *
+ * @param[in]       codec id, MEDIA_CODEC_ID_H264 or MEDIA_CODEC_ID_H265
+ * @param[in]       NAL unit type
+ *
+ * @return 1 if it's a key picture, otherwise 0
+ */
+extern hb_bool hb_mm_nal_is_key(media_codec_id_t codec_id, hb_s32 type);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_NAL_H */
@@ -0,0 +1,48 @@
+#ifndef HB_MEDIA_PIXFMT_H
+#define HB_MEDIA_PIXFMT_H
+
+#include "hb_media_codec.h"
+#include "hb_media_simd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Define a source picture in one of the YUV 4:2:0 formats. Plane 2 is
+ * unused for NV12/NV21.
+ **/
+typedef struct _mc_video_planes {
+    /**
+     * Plane start addresses.
+     */
+    const hb_u8 *data[3];
+
+    /**
+     * Plane strides in bytes.
+     */
+    hb_s32 stride[3];
+} mc_video_planes_t;
+
+/**
+ * Convert a picture between MC_PIXEL_FORMAT_YUV420P, MC_PIXEL_FORMAT_NV12
+ * and MC_PIXEL_FORMAT_NV21, writing straight into the planes of an
+ * encoder input buffer. The destination format, size and strides are
+ * taken from the frame buffer. If vir_ptr[1]/vir_ptr[2] are NULL the
+ * planes are laid out contiguously after vir_ptr[0], the same way the
+ * test harness lays out external frame buffers.
+ *
+ * @param[in]       source format
+ * @param[in]       source planes @see mc_video_planes_t
+ * @param[in,out]   destination frame buffer @see mc_video_frame_buffer_info_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_pixfmt_convert(mc_pixel_format_t src_fmt,
+				const mc_video_planes_t *src,
+				mc_video_frame_buffer_info_t *dst);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_PIXFMT_H */
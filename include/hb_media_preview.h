@@ -0,0 +1,106 @@
+#ifndef HB_MEDIA_PREVIEW_H
+#define HB_MEDIA_PREVIEW_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* H265 temporal sub-layers */
+#define MC_PREVIEW_MAX_LAYERS 7
+
+/**
+ * Define the preview speeds, the share of the pictures to show.
+ **/
+typedef enum _mc_preview_speed {
+	MC_PREVIEW_SPEED_1X = 0,
+	MC_PREVIEW_SPEED_2X,
+	MC_PREVIEW_SPEED_4X,
+	MC_PREVIEW_SPEED_8X,
+	/* Key pictures only */
+	MC_PREVIEW_SPEED_KEYFRAMES,
+	MC_PREVIEW_SPEED_TOTAL,
+} mc_preview_speed_t;
+
+/**
+ * Define the picture structure of a stream sample, counted from the NAL
+ * unit headers of whole pictures.
+ **/
+typedef struct _mc_preview_probe {
+    /* Pictures, counted by their first slice */
+    hb_u32 pictures;
+    /* IDR/IRAP pictures */
+    hb_u32 key_pictures;
+    /* Pictures no other picture refers to */
+    hb_u32 non_ref_pictures;
+    /* Pictures per temporal id, all in layer 0 for H264 */
+    hb_u32 layer_pictures[MC_PREVIEW_MAX_LAYERS];
+    /* sps_max_sub_layers of H265, 1 for H264 */
+    hb_u32 max_sub_layers;
+} mc_preview_probe_t;
+
+/**
+ * Define the decoder settings chosen for a preview speed.
+ **/
+typedef struct _mc_preview_plan {
+    /* skip_mode of mc_h264_dec_config_t or mc_h265_dec_config_t */
+    hb_u32 skip_mode;
+    /* Temporal layer selection of mc_h265_dec_config_t */
+    hb_u32 dec_temporal_id_mode;
+    hb_u32 target_dec_temporal_id_plus1;
+    /* Expected decoded pictures per 1000, 0 without a probe */
+    hb_u32 decoded_permille;
+} mc_preview_plan_t;
+
+/**
+ * Count the pictures of a stream sample, e.g. its first GOPs. The counts
+ * add up over calls, so the probe is zeroed before the first one. NAL
+ * units must not be split between calls.
+ *
+ * @param[in]       codec id, MEDIA_CODEC_ID_H264 or MEDIA_CODEC_ID_H265
+ * @param[in]       Annex-B byte stream
+ * @param[in]       byte stream size
+ * @param[in,out]   picture counts @see mc_preview_probe_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_preview_probe(media_codec_id_t codec_id,
+				const hb_u8 *data, hb_u32 size, mc_preview_probe_t *probe);
+
+/**
+ * Choose the decoder settings for a preview speed. Of the temporal layer
+ * targets (H265 only), skipping non-reference pictures and skipping
+ * non-key pictures, the one decoding the most pictures while still
+ * dropping enough for the speed is taken; key pictures only if none
+ * drops enough. Without a probe the speeds above 1x skip non-reference
+ * pictures.
+ *
+ * @param[in]       codec id, MEDIA_CODEC_ID_H264 or MEDIA_CODEC_ID_H265
+ * @param[in]       preview speed @see mc_preview_speed_t
+ * @param[in]       picture counts of the stream, may be NULL
+ * @param[out]      decoder settings @see mc_preview_plan_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_preview_plan(media_codec_id_t codec_id,
+				mc_preview_speed_t speed, const mc_preview_probe_t *probe,
+				mc_preview_plan_t *plan);
+
+/**
+ * Write the decoder settings into the decoding parameters of a context
+ * before hb_mm_mc_configure(). The settings are unchangable in the same
+ * sequence, another speed needs the decoder configured again.
+ *
+ * @param[in]       decoder settings @see mc_preview_plan_t
+ * @param[in,out]   decoder context
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_preview_apply(const mc_preview_plan_t *plan,
+				media_codec_context_t *context);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_PREVIEW_H */
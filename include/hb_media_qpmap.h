@@ -0,0 +1,206 @@
+#ifndef HB_MEDIA_QPMAP_H
+#define HB_MEDIA_QPMAP_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Define the parameters of the QP map generator. For every input picture
+ * the generator measures the luma variance and the difference to the
+ * previous picture of each map block and writes one QP per block in
+ * raster scan order, the layout of vframe_buf.qp_map_array. Static blocks
+ * get a higher QP since the reference already carries them, moving blocks
+ * a lower one; flat blocks get a lower QP than textured ones.
+ **/
+typedef struct _mc_qpmap_params {
+    /**
+     * Luma width and height in pixels.
+     * Values[>0]
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_s32 width;
+    hb_s32 height;
+
+    /**
+     * Alignment of the coded picture, 16 for H264 macroblocks and 64 for
+     * H265 CTUs. The map covers the aligned picture.
+     * Values[16, 32, 64]
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 align;
+
+    /**
+     * Size of the square picture area one map entry applies to, 16 for
+     * H264 and 32 or 64 for H265 depending on the chip.
+     * Values[16, 32, 64], not larger than align
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 block_size;
+
+    /**
+     * Number of maps in the pool. A map is reused pool_num pictures later,
+     * so it must be at least the number of input buffers the encoder can
+     * hold plus one.
+     * Values[1,32]
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 pool_num;
+
+    /**
+     * QP of an average block and the range every map entry is clipped to.
+     * Values[0,51]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 base_qp;
+    hb_u32 min_qp;
+    hb_u32 max_qp;
+
+    /**
+     * Spatial adaptation strength in 1/8 QP per doubling of the block
+     * variance relative to the picture average, 0 to disable.
+     * Values[0,64]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 aq_strength;
+
+    /**
+     * Mean absolute difference to the previous picture per pixel in 1/16
+     * levels below which a block is static and above which it is moving.
+     * Values[static_threshold <= motion_threshold]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 static_threshold;
+    hb_u32 motion_threshold;
+
+    /**
+     * QP added to static blocks and subtracted from moving blocks.
+     * Values[0,51]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 static_qp_offset;
+    hb_u32 motion_qp_offset;
+} mc_qpmap_params_t;
+
+/**
+ * Define the statistics of the QP map generator.
+ **/
+typedef struct _mc_qpmap_stats {
+    /* Maps generated */
+    hb_u64 frames;
+    /* Static and moving blocks of the last map */
+    hb_u32 last_static_blocks;
+    hb_u32 last_moving_blocks;
+    /* Average QP of the last map in 1/100 */
+    hb_u32 last_avg_qp;
+    /* Total and maximum generation time per picture in us */
+    hb_u64 cost_us;
+    hb_u64 max_cost_us;
+} mc_qpmap_stats_t;
+
+typedef struct _mc_qpmap_generator mc_qpmap_generator_t;
+
+/**
+ * Get the number of map entries, the qp_map_array_count of the pictures.
+ *
+ * @param[in]       QP map parameters @see mc_qpmap_params_t
+ *
+ * @return >0 number of entries, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_qpmap_get_count(const mc_qpmap_params_t *params);
+
+/**
+ * Create the QP map generator. The map pool and the previous picture are
+ * allocated here, generating a map doesn't allocate.
+ *
+ * @param[in]       QP map parameters @see mc_qpmap_params_t
+ * @param[out]      QP map generator
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_qpmap_create(const mc_qpmap_params_t *params,
+				mc_qpmap_generator_t **gen);
+
+/**
+ * Change the QP range, strength and thresholds. The geometry and the pool
+ * can't change.
+ *
+ * @param[in]       QP map generator
+ * @param[in]       QP map parameters @see mc_qpmap_params_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_qpmap_set_params(mc_qpmap_generator_t *gen,
+				const mc_qpmap_params_t *params);
+
+/**
+ * Generate the map of one picture into the next map of the pool. The
+ * first picture has no previous one and only gets the spatial adaptation.
+ *
+ * @param[in]       QP map generator
+ * @param[in]       luma plane
+ * @param[in]       luma stride in bytes
+ * @param[out]      map, valid until pool_num more maps are generated
+ * @param[out]      number of map entries
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_qpmap_generate(mc_qpmap_generator_t *gen,
+				const hb_u8 *luma, hb_s32 stride, hb_byte *map, hb_u32 *count);
+
+/**
+ * Generate the map of a filled encoder input buffer and attach it with
+ * qp_map_valid, qp_map_array and qp_map_array_count. Call it after the
+ * picture is filled and before it is queued.
+ *
+ * @param[in]       QP map generator
+ * @param[in]       filled input buffer @see media_codec_buffer_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_qpmap_apply(mc_qpmap_generator_t *gen,
+				media_codec_buffer_t *buffer);
+
+/**
+ * Get the statistics of the QP map generator.
+ *
+ * @param[in]       QP map generator
+ * @param[out]      statistics @see mc_qpmap_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_qpmap_get_stats(mc_qpmap_generator_t *gen,
+				mc_qpmap_stats_t *stats);
+
+/**
+ * Destroy the QP map generator. Maps attached to queued pictures become
+ * invalid, destroy it after the encoder is stopped.
+ *
+ * @param[in]       QP map generator
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_qpmap_destroy(mc_qpmap_generator_t *gen);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_QPMAP_H */
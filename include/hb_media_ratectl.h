@@ -0,0 +1,192 @@
+#ifndef HB_MEDIA_RATECTL_H
+#define HB_MEDIA_RATECTL_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Maximum length of the sliding window in pictures */
+#define MC_RATECTL_MAX_WINDOW 1024
+
+/**
+ * Define the parameters of the rate control supervisor. It follows the
+ * encoded picture sizes over a sliding window and retunes the bit_rate of
+ * the CBR or AVBR rate control at every GOP boundary, so the window rate
+ * stays below a ceiling even when the encoder overshoots its own target
+ * for a while. The encoder must be configured in H264CBR, H264AVBR,
+ * H265CBR or H265AVBR mode.
+ **/
+typedef struct _mc_ratectl_params {
+    /**
+     * Frame rate used to turn picture sizes into bitrates.
+     * Values[1,240]fps
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 frame_rate;
+
+    /**
+     * Length of the sliding window.
+     * Values[1,MC_RATECTL_MAX_WINDOW * 1000 / frame_rate]ms
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 window_ms;
+
+    /**
+     * Bitrate the encoder is steered back to while there's room.
+     * Values[min_bit_rate,ceiling_bit_rate]kbps
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 target_bit_rate;
+
+    /**
+     * Bitrate of the window that must never be passed, and the lowest
+     * bitrate the encoder is set to.
+     * Values[>0]kbps
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 ceiling_bit_rate;
+    hb_u32 min_bit_rate;
+
+    /**
+     * Margin below the ceiling the window rate is steered to, in per
+     * mille of the ceiling.
+     * Values[0,500]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 headroom_permille;
+
+    /**
+     * Largest change of the bitrate at one GOP boundary in per mille of
+     * the current bitrate.
+     * Values[1,1000]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 max_step_permille;
+
+    /**
+     * Pictures per GOP when the stream has no periodic I picture, 0 to
+     * only adjust at I and IDR pictures.
+     * Values[>=0]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 gop_frames;
+
+    /**
+     * Skip blocks in per mille of all 8x8 blocks of the last GOP above
+     * which the bitrate isn't raised, the scene has nothing to spend it on.
+     * 0 to raise it regardless.
+     * Values[0,1000]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 static_skip_permille;
+} mc_ratectl_params_t;
+
+/**
+ * Define the metrics of the rate control supervisor.
+ **/
+typedef struct _mc_ratectl_stats {
+    /* Pictures and GOPs seen */
+    hb_u64 frames;
+    hb_u64 gops;
+    /* Bitrate decreases and increases sent to the encoder */
+    hb_u64 decreases;
+    hb_u64 increases;
+    /* Pictures after which the window rate was above the ceiling */
+    hb_u64 overflows;
+    /* Rate control settings the encoder rejected */
+    hb_u64 set_failures;
+    /* Bitrate the encoder is set to in kbps */
+    hb_u32 bit_rate;
+    /* Window rate after the last picture and its maximum in kbps */
+    hb_u32 window_bit_rate;
+    hb_u32 max_window_bit_rate;
+    /* Rate, average QP, intra and skip blocks of the last GOP */
+    hb_u32 last_gop_bit_rate;
+    hb_u32 last_gop_avg_qp;
+    hb_u32 last_gop_intra_permille;
+    hb_u32 last_gop_skip_permille;
+} mc_ratectl_stats_t;
+
+typedef struct _mc_ratectl mc_ratectl_t;
+
+/**
+ * Create the rate control supervisor of a started encoder. The current
+ * rate control parameters are read from the encoder; for H265AVBR the
+ * ceiling is also set as max bitrate where the chip supports it.
+ *
+ * @param[in]       started encoder instance
+ * @param[in]       supervisor parameters @see mc_ratectl_params_t
+ * @param[out]      rate control supervisor
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_ratectl_create(media_codec_context_t *context,
+				const mc_ratectl_params_t *params, mc_ratectl_t **rc);
+
+/**
+ * Change the bitrates, margins and thresholds. The frame rate and the
+ * window can't change.
+ *
+ * @param[in]       rate control supervisor
+ * @param[in]       supervisor parameters @see mc_ratectl_params_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_ratectl_set_params(mc_ratectl_t *rc,
+				const mc_ratectl_params_t *params);
+
+/**
+ * Account one encoded picture. Call it with the information of every
+ * dequeued output buffer; at a GOP boundary the bitrate of the encoder
+ * is adjusted before the call returns.
+ *
+ * @param[in]       rate control supervisor
+ * @param[in]       output buffer information @see media_codec_output_buffer_info_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_ratectl_update(mc_ratectl_t *rc,
+				const media_codec_output_buffer_info_t *info);
+
+/**
+ * Get the metrics of the rate control supervisor.
+ *
+ * @param[in]       rate control supervisor
+ * @param[out]      metrics @see mc_ratectl_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_ratectl_get_stats(mc_ratectl_t *rc,
+				mc_ratectl_stats_t *stats);
+
+/**
+ * Destroy the rate control supervisor. The encoder keeps the last bitrate.
+ *
+ * @param[in]       rate control supervisor
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_ratectl_destroy(mc_ratectl_t *rc);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_RATECTL_H */
@@ -0,0 +1,157 @@
+#ifndef HB_MEDIA_RINGBUF_H
+#define HB_MEDIA_RINGBUF_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Define the parameters of the pre-event ring buffer. The ring buffer
+ * keeps the last encoded access units of one H264/H265 stream in a fixed
+ * memory arena. Nothing is written to storage until an event is
+ * triggered; then the pre-roll and the post-roll are written as one
+ * playable Annex-B clip.
+ **/
+typedef struct _mr_ringbuf_params {
+    /**
+     * Codec ID. Only support H264 and H265.
+     * Values[MEDIA_CODEC_ID_H264,MEDIA_CODEC_ID_H265]
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: MEDIA_CODEC_ID_NONE
+     */
+    media_codec_id_t codec_id;
+
+    /**
+     * Size in bytes of the arena holding the access units.
+     * Values[>0]
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 arena_size;
+
+    /**
+     * Maximum number of access units held in the arena.
+     * Values[>0]
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 max_frames;
+
+    /**
+     * Duration in ms kept before the trigger. Whole GOPs are evicted
+     * once the remaining ones still cover the pre-roll.
+     * Values[>=0]
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 pre_roll_ms;
+
+    /**
+     * Duration in ms recorded after the trigger.
+     * Values[>=0]
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 post_roll_ms;
+} mr_ringbuf_params_t;
+
+/**
+ * Define the statistics of the pre-event ring buffer.
+ **/
+typedef struct _mr_ringbuf_stats {
+    /* Access units currently held */
+    hb_u32 frames;
+    /* Bytes currently held */
+    hb_u32 bytes;
+    /* Duration in ms currently held */
+    hb_u64 duration_ms;
+    /* GOPs evicted */
+    hb_u64 gops_evicted;
+    /* Access units dropped while waiting for an IDR after an overflow */
+    hb_u64 frames_dropped;
+    /* Clips written */
+    hb_u32 clips_written;
+    /* Clips written early because the arena ran out during post-roll */
+    hb_u32 clips_truncated;
+    /* Bytes of the last clip */
+    hb_u64 last_clip_bytes;
+} mr_ringbuf_stats_t;
+
+typedef struct _mr_ringbuf mr_ringbuf_t;
+
+/**
+ * Create the ring buffer. The arena is allocated here and never again.
+ *
+ * @param[in]       ring buffer parameters @see mr_ringbuf_params_t
+ * @param[out]      ring buffer
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_rb_create(const mr_ringbuf_params_t *params,
+				mr_ringbuf_t **rb);
+
+/**
+ * Push one encoded access unit. If a clip is pending and its post-roll
+ * is complete, the clip is written before returning.
+ *
+ * @param[in]       ring buffer
+ * @param[in]       access unit data
+ * @param[in]       access unit size in bytes
+ * @param[in]       presentation time in ms
+ * @param[in]       whether the access unit is an IDR
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_rb_push(mr_ringbuf_t *rb, const hb_u8 *data,
+				hb_u32 size, hb_u64 pts, hb_bool is_idr);
+
+/**
+ * Trigger an event. The clip starts at the oldest IDR held and ends
+ * post_roll_ms after the newest access unit.
+ *
+ * @param[in]       ring buffer
+ * @param[in]       clip file name
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_rb_trigger(mr_ringbuf_t *rb, const char *file_name);
+
+/**
+ * Write the pending clip now, even if the post-roll isn't complete.
+ *
+ * @param[in]       ring buffer
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_rb_flush(mr_ringbuf_t *rb);
+
+/**
+ * Get the statistics of the ring buffer.
+ *
+ * @param[in]       ring buffer
+ * @param[out]      statistics @see mr_ringbuf_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_rb_get_stats(mr_ringbuf_t *rb, mr_ringbuf_stats_t *stats);
+
+/**
+ * Destroy the ring buffer. A pending clip is discarded.
+ *
+ * @param[in]       ring buffer
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_rb_destroy(mr_ringbuf_t *rb);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_RINGBUF_H */
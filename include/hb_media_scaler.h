@@ -0,0 +1,73 @@
+#ifndef HB_MEDIA_SCALER_H
+#define HB_MEDIA_SCALER_H
+
+#include "hb_media_codec.h"
+#include "hb_media_pixfmt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Define the scaling filters.
+ **/
+typedef enum _mc_scale_filter {
+    MC_SCALE_FILTER_NONE = -1,
+    /* Bilinear, any ratio */
+    MC_SCALE_FILTER_BILINEAR,
+    /*
+     * Box average for integer down scaling ratios, e.g. 3840x2160 to
+     * 1920x1080 or 1920x1080 to 640x360. Falls back to bilinear for
+     * other ratios.
+     */
+    MC_SCALE_FILTER_AREA,
+    MC_SCALE_FILTER_TOTAL
+} mc_scale_filter_t;
+
+typedef struct _mc_scaler mc_scaler_t;
+
+/**
+ * Create a scaler for one source and destination geometry. All tables
+ * and row buffers are allocated here.
+ *
+ * @param[in]       source width and height in luma samples
+ * @param[in]       destination width and height in luma samples
+ * @param[in]       filter @see mc_scale_filter_t
+ * @param[out]      scaler
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_scaler_create(hb_s32 src_width, hb_s32 src_height,
+				hb_s32 dst_width, hb_s32 dst_height,
+				mc_scale_filter_t filter, mc_scaler_t **scaler);
+
+/**
+ * Scale a YUV 4:2:0 picture straight into the planes of an encoder input
+ * buffer. The destination format and strides are taken from the frame
+ * buffer the same way as hb_mm_pixfmt_convert(); when it differs from the
+ * source format the picture is scaled first and converted afterwards.
+ *
+ * @param[in]       scaler
+ * @param[in]       source format
+ * @param[in]       source planes @see mc_video_planes_t
+ * @param[in,out]   destination frame buffer @see mc_video_frame_buffer_info_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_scaler_process(mc_scaler_t *scaler,
+				mc_pixel_format_t src_fmt, const mc_video_planes_t *src,
+				mc_video_frame_buffer_info_t *dst);
+
+/**
+ * Destroy the scaler.
+ *
+ * @param[in]       scaler
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_scaler_destroy(mc_scaler_t *scaler);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_SCALER_H */
@@ -0,0 +1,165 @@
+#ifndef HB_MEDIA_SCENECUT_H
+#define HB_MEDIA_SCENECUT_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Define the parameters of the scene cut detector. Each input picture is
+ * reduced to an 8x smaller luma plane; a cut is found when both the
+ * luma histogram and the SAD of that plane change a lot against the
+ * previous picture. The detector also owns the IDR cadence: run the
+ * encoder without periodic IDR (intra_period 0) and set idr_interval
+ * here, an IDR on a cut then restarts the interval instead of being
+ * followed shortly by the periodic one.
+ **/
+typedef struct _mc_scenecut_params {
+    /**
+     * Luma width and height in pixels.
+     * Values[>0]
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_s32 width;
+    hb_s32 height;
+
+    /**
+     * Histogram difference in per mille of the samples that moved to
+     * another bin above which the picture can be a cut.
+     * Values[0,1000]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 hist_threshold;
+
+    /**
+     * Mean absolute difference of the reduced plane in 1/16 levels above
+     * which the picture can be a cut.
+     * Values[>=0]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 sad_threshold;
+
+    /**
+     * Minimum pictures from the last IDR to an IDR caused by a cut, so
+     * flashes and strobes don't turn into IDR bursts.
+     * Values[>=0]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 min_cut_interval;
+
+    /**
+     * Pictures between two IDRs without a cut, 0 for IDRs on cuts only.
+     * Values[>=0]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 idr_interval;
+} mc_scenecut_params_t;
+
+/**
+ * Define the statistics of the scene cut detector.
+ **/
+typedef struct _mc_scenecut_stats {
+    /* Pictures checked */
+    hb_u64 frames;
+    /* IDRs requested on cuts and by the interval */
+    hb_u64 cuts;
+    hb_u64 periodic;
+    /* Cuts ignored because of min_cut_interval */
+    hb_u64 ignored;
+    /* Histogram and SAD difference of the last picture */
+    hb_u32 last_hist_diff;
+    hb_u32 last_sad_diff;
+    /* Total and maximum detection time per picture in us */
+    hb_u64 cost_us;
+    hb_u64 max_cost_us;
+} mc_scenecut_stats_t;
+
+typedef struct _mc_scenecut_detector mc_scenecut_detector_t;
+
+/**
+ * Create the scene cut detector. The reduced planes are allocated here.
+ *
+ * @param[in]       scene cut parameters @see mc_scenecut_params_t
+ * @param[out]      scene cut detector
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_scenecut_create(const mc_scenecut_params_t *params,
+				mc_scenecut_detector_t **det);
+
+/**
+ * Change the thresholds and intervals. The size can't change.
+ *
+ * @param[in]       scene cut detector
+ * @param[in]       scene cut parameters @see mc_scenecut_params_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_scenecut_set_params(mc_scenecut_detector_t *det,
+				const mc_scenecut_params_t *params);
+
+/**
+ * Decide whether one picture should be an IDR, because it starts a new
+ * scene or the IDR interval is over. The first picture is the IDR the
+ * encoder starts with and is never requested.
+ *
+ * @param[in]       scene cut detector
+ * @param[in]       luma plane
+ * @param[in]       luma stride in bytes
+ * @param[out]      whether an IDR should be requested
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_scenecut_detect(mc_scenecut_detector_t *det,
+				const hb_u8 *luma, hb_s32 stride, hb_bool *idr);
+
+/**
+ * Run the detector on a filled encoder input buffer and call
+ * hb_mm_mc_request_idr_frame() when it should be an IDR. Call it after
+ * the picture is filled and before it is queued.
+ *
+ * @param[in]       scene cut detector
+ * @param[in]       codec context
+ * @param[in]       filled input buffer @see media_codec_buffer_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_scenecut_apply(mc_scenecut_detector_t *det,
+				media_codec_context_t *context, media_codec_buffer_t *buffer);
+
+/**
+ * Get the statistics of the scene cut detector.
+ *
+ * @param[in]       scene cut detector
+ * @param[out]      statistics @see mc_scenecut_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_scenecut_get_stats(mc_scenecut_detector_t *det,
+				mc_scenecut_stats_t *stats);
+
+/**
+ * Destroy the scene cut detector.
+ *
+ * @param[in]       scene cut detector
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_scenecut_destroy(mc_scenecut_detector_t *det);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_SCENECUT_H */
@@ -0,0 +1,164 @@
+#ifndef HB_MEDIA_SEGMENT_H
+#define HB_MEDIA_SEGMENT_H
+
+#include "hb_media_basic_types.h"
+#include "hb_media_recorder.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Define the parameters of the segment writer. The writer takes the
+ * encoded access units of one stream and splits them into segment files
+ * without stopping the encoder: the next segment is opened and
+ * pre-allocated in the background, the switch happens at the first IDR
+ * after a limit is hit and the old segment is finalized in the background.
+ **/
+typedef struct _mr_segment_params {
+    /**
+     * printf style pattern of the segment file name. It must contain one
+     * unsigned conversion for the segment index, for example
+     * "/userdata/record_%05u.h265".
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: NULL
+     */
+    const char *output_file_pattern;
+
+    /**
+     * Index of the first segment file.
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 first_index;
+
+    /**
+     * Specify the maximum duration in ms of one segment. The rotation
+     * happens at the first IDR once it's reached.
+     * Values[>=0], <=0 means no limit
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_s32 max_file_duration;
+
+    /**
+     * Specify the maximum size in bytes of one segment. The rotation
+     * happens at the first IDR once it's reached.
+     * Values[>=0], <=0 means no limit
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_s32 max_file_size;
+
+    /**
+     * Bytes pre-allocated with fallocate for every new segment. The
+     * unused tail is cut off when the segment is finalized.
+     * Values[>=0], 0 means max_file_size
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 prealloc_size;
+
+    /**
+     * Flush the segment data to storage before it's closed.
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_bool sync_on_close;
+
+    /**
+     * Listener notified from the background thread once a segment is
+     * finalized. The event is MR_EVENT_INFO with
+     * MR_INFO_MAX_DURATION_REACHED or MR_INFO_MAX_FILESIZE_REACHED and
+     * the message is the index of the finalized segment.
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: NULL
+     */
+    media_recorder_listener listener;
+    void *userdata;
+} mr_segment_params_t;
+
+/**
+ * Define the statistics of the segment writer.
+ **/
+typedef struct _mr_segment_stats {
+    /* Number of access units written */
+    hb_u64 frames_written;
+    /* Number of bytes written into all segments */
+    hb_u64 bytes_written;
+    /* Number of segment switches */
+    hb_u32 rotations;
+    /* Switches which had to wait for the next segment to be opened */
+    hb_u32 late_rotations;
+    /* Switches put off to a later IDR as the next segment couldn't be
+     * opened */
+    hb_u32 failed_rotations;
+    /* Worst time in us spent in the write path for a switch */
+    hb_u32 max_switch_us;
+    /* Index of the segment currently written */
+    hb_u32 current_index;
+} mr_segment_stats_t;
+
+typedef struct _mr_segment_writer mr_segment_writer_t;
+
+/**
+ * Create the segment writer, open the first segment and start the
+ * background thread which prepares and finalizes segments.
+ *
+ * @param[in]       segment parameters @see mr_segment_params_t
+ * @param[out]      segment writer
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_seg_create(const mr_segment_params_t *params,
+				mr_segment_writer_t **writer);
+
+/**
+ * Write one encoded access unit. When a limit has been reached and the
+ * access unit is an IDR, it's written into the next segment. If the next
+ * segment couldn't be opened, it stays in the current one and the switch
+ * is tried again at the following IDR.
+ *
+ * @param[in]       segment writer
+ * @param[in]       access unit data
+ * @param[in]       access unit size in bytes
+ * @param[in]       presentation time in ms
+ * @param[in]       whether the access unit is an IDR
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_seg_write(mr_segment_writer_t *writer,
+				const hb_u8 *data, hb_u32 size, hb_u64 pts, hb_bool is_idr);
+
+/**
+ * Get the statistics of the segment writer.
+ *
+ * @param[in]       segment writer
+ * @param[out]      statistics @see mr_segment_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_seg_get_stats(mr_segment_writer_t *writer,
+				mr_segment_stats_t *stats);
+
+/**
+ * Finalize the current segment, stop the background thread and free
+ * the writer. The pre-opened next segment is removed.
+ *
+ * @param[in]       segment writer
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_seg_destroy(mr_segment_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_SEGMENT_H */
@@ -0,0 +1,206 @@
+#ifndef HB_MEDIA_SEI_H
+#define HB_MEDIA_SEI_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Most bytes of one user data SEI payload the injector writes.
+ **/
+#define MC_SEI_PAYLOAD_MAX 256
+
+/**
+ * Most payloads waiting for their picture, as many as the encoder takes
+ * before it has encoded one.
+ **/
+#define MC_SEI_POOL_MAX 5
+
+/**
+ * Fields of @see mc_sei_meta_t which are set.
+ **/
+#define MC_SEI_META_TIME (1 << 0)
+#define MC_SEI_META_GPS (1 << 1)
+#define MC_SEI_META_SENSOR (1 << 2)
+
+/**
+ * Define the metadata of one picture. The injector carries it in a user
+ * data SEI of the picture; the payload is the UUID as 32 hex digits, '+'
+ * and "HBM1" followed by ";key=value" text of the set fields.
+ **/
+typedef struct _mc_sei_meta {
+    /* MC_SEI_META_ bits of the set fields */
+    hb_u32 flags;
+    /* Set by the injector: pts of the input buffer and number of the
+     * picture, counted from the first attached one */
+    hb_u64 pts;
+    hb_u64 frame_seq;
+    /* Capture time in us */
+    hb_u64 capture_time_us;
+    /* Position in 1e-7 degrees and altitude in mm */
+    hb_s32 latitude_e7;
+    hb_s32 longitude_e7;
+    hb_s32 altitude_mm;
+    /* Camera sensor */
+    hb_u32 sensor_id;
+} mc_sei_meta_t;
+
+/**
+ * Define the parameters of the SEI metadata injector and extractor.
+ **/
+typedef struct _mc_sei_params {
+    /**
+     * UUID of the user data SEI. The extractor skips user data with
+     * another one.
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_u8 uuid[16];
+
+    /**
+     * Payloads preallocated for the pictures between
+     * hb_mm_sei_attach() and hb_mm_sei_frame_done().
+     * Values[1,MC_SEI_POOL_MAX]
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_u32 pool_size;
+} mc_sei_params_t;
+
+/**
+ * Define the statistics of the injector and the extractor.
+ **/
+typedef struct _mc_sei_stats {
+    /* Payloads inserted and their largest size */
+    hb_u64 injected;
+    hb_u32 max_payload;
+    /* Pictures without metadata as the pool was full, and as the payload
+     * couldn't be built or the encoder didn't take it */
+    hb_u64 pool_exhausted;
+    hb_u64 insert_failures;
+    /* Payloads extracted, with another UUID and unreadable ones */
+    hb_u64 extracted;
+    hb_u64 foreign;
+    hb_u64 malformed;
+} mc_sei_stats_t;
+
+typedef struct _mc_sei_injector mc_sei_injector_t;
+typedef struct _mc_sei_extractor mc_sei_extractor_t;
+
+/**
+ * Create the SEI metadata injector of an H264 or H265 encoder and
+ * preallocate its payloads.
+ *
+ * @param[in]       encoder instance
+ * @param[in]       injector parameters @see mc_sei_params_t
+ * @param[out]      SEI metadata injector
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_sei_injector_create(media_codec_context_t *context,
+				const mc_sei_params_t *params, mc_sei_injector_t **inj);
+
+/**
+ * Attach the metadata to an input buffer right before it's queued, so
+ * the encoder puts the SEI into its picture. No memory is allocated.
+ * Call it for every queued picture, with NULL metadata for the pictures
+ * without any. The payload is held until the output of the same pts, so
+ * the pictures in the encoder need distinct pts.
+ *
+ * @param[in]       SEI metadata injector
+ * @param[in]       input buffer about to be queued @see media_codec_buffer_t
+ * @param[in]       metadata @see mc_sei_meta_t, can be NULL
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_sei_attach(mc_sei_injector_t *inj,
+				const media_codec_buffer_t *buffer,
+				const mc_sei_meta_t *meta);
+
+/**
+ * Give back the payload of an encoded picture. Call it for every dequeued
+ * output buffer; the payload is found by the pts, so pictures leaving
+ * the encoder in another order, e.g. with B pictures, are handled.
+ *
+ * @param[in]       SEI metadata injector
+ * @param[in]       output buffer @see media_codec_buffer_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_sei_frame_done(mc_sei_injector_t *inj,
+				const media_codec_buffer_t *output);
+
+/**
+ * Get the statistics of the injector.
+ *
+ * @param[in]       SEI metadata injector
+ * @param[out]      statistics @see mc_sei_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_sei_injector_get_stats(mc_sei_injector_t *inj,
+				mc_sei_stats_t *stats);
+
+/**
+ * Destroy the SEI metadata injector.
+ *
+ * @param[in]       SEI metadata injector
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_sei_injector_destroy(mc_sei_injector_t *inj);
+
+/**
+ * Create the SEI metadata extractor of an H264 or H265 decoder.
+ *
+ * @param[in]       decoder instance
+ * @param[in]       extractor parameters, only the uuid is used
+ * @param[out]      SEI metadata extractor
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_sei_extractor_create(media_codec_context_t *context,
+				const mc_sei_params_t *params, mc_sei_extractor_t **ext);
+
+/**
+ * Get the metadata of the next decoded picture with a payload of the
+ * UUID from hb_mm_mc_get_user_data(). User data with another UUID or
+ * that can't be read is released and skipped.
+ *
+ * @param[in]       SEI metadata extractor
+ * @param[out]      metadata @see mc_sei_meta_t
+ * @param[in]       timeout in ms
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_sei_extract(mc_sei_extractor_t *ext,
+				mc_sei_meta_t *meta, hb_s32 timeout);
+
+/**
+ * Get the statistics of the extractor.
+ *
+ * @param[in]       SEI metadata extractor
+ * @param[out]      statistics @see mc_sei_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_sei_extractor_get_stats(mc_sei_extractor_t *ext,
+				mc_sei_stats_t *stats);
+
+/**
+ * Destroy the SEI metadata extractor.
+ *
+ * @param[in]       SEI metadata extractor
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_sei_extractor_destroy(mc_sei_extractor_t *ext);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_SEI_H */
@@ -0,0 +1,151 @@
+#ifndef HB_MEDIA_SESSION_H
+#define HB_MEDIA_SESSION_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Maximum number of encoder instances a session manager owns */
+#define MC_SESSION_MAX_INSTANCES 32
+
+/**
+ * Define the parameters of the session manager. The manager keeps
+ * encoder instances configured after their stream ended; a new stream of
+ * the same shape takes one over instead of going through
+ * hb_mm_mc_release(), hb_mm_mc_initialize() and hb_mm_mc_configure().
+ * The shape is codec, resolution, pix_fmt, frame_buf_count,
+ * bitstream_buf_count and external_frame_buf.
+ **/
+typedef struct _mc_session_params {
+    /**
+     * Maximum number of idle instances over all shapes. An instance
+     * coming back beyond it is released.
+     * Values[0, MC_SESSION_MAX_INSTANCES]
+     *
+     * - Note: It's changable parameter.
+     * - Default: 0
+     */
+    hb_u32 max_idle;
+} mc_session_params_t;
+
+/**
+ * Define the statistics of the session manager.
+ **/
+typedef struct _mc_session_stats {
+    /* Instances handed out, configured with the same parameters */
+    hb_u64 ready;
+    /* Instances of the same shape configured again with new parameters */
+    hb_u64 reconfigured;
+    /* Instances initialized for the request */
+    hb_u64 cold;
+    /* Instances released because the manager was full or they failed */
+    hb_u64 evicted;
+    /* Instances handed out and idle */
+    hb_u32 used_num;
+    hb_u32 idle_num;
+    /* Total hand out time of ready and of other instances in us */
+    hb_u64 ready_cost_us;
+    hb_u64 cold_cost_us;
+    /**
+     * Total time from the hand out to the first picture, reported with
+     * hb_mm_session_first_frame(), of ready and of other instances in us.
+     */
+    hb_u64 ready_ttff_us;
+    hb_u64 ready_ttff_num;
+    hb_u64 cold_ttff_us;
+    hb_u64 cold_ttff_num;
+} mc_session_stats_t;
+
+typedef struct _mc_session_manager mc_session_manager_t;
+
+/**
+ * Create the session manager.
+ *
+ * @param[in]       session parameters @see mc_session_params_t
+ * @param[out]      session manager
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_session_create(const mc_session_params_t *params,
+				mc_session_manager_t **mgr);
+
+/**
+ * Initialize and configure idle instances of a template ahead of the
+ * first stream. Only codec_id, encoder and video_enc_params of the
+ * template are used.
+ *
+ * @param[in]       session manager
+ * @param[in]       template context @see media_codec_context_t
+ * @param[in]       number of idle instances of the template
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_session_prewarm(mc_session_manager_t *mgr,
+				const media_codec_context_t *tmpl, hb_u32 num);
+
+/**
+ * Take a configured encoder instance for the template. An idle instance
+ * with the same parameters is handed out right away, one of the same
+ * shape is configured again, otherwise a new one is initialized. The
+ * context is owned by the manager, start it with hb_mm_mc_start().
+ *
+ * @param[in]       session manager
+ * @param[in]       template context @see media_codec_context_t
+ * @param[out]      configured codec context
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_session_acquire(mc_session_manager_t *mgr,
+				const media_codec_context_t *tmpl, media_codec_context_t **context);
+
+/**
+ * Report the first encoded picture of an instance for the time to first
+ * frame statistics. Later calls of the same stream are ignored.
+ *
+ * @param[in]       session manager
+ * @param[in]       codec context got from hb_mm_session_acquire()
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_session_first_frame(mc_session_manager_t *mgr,
+				media_codec_context_t *context);
+
+/**
+ * Give an instance back after its stream. It is stopped and configured
+ * again for the next stream of the same parameters.
+ *
+ * @param[in]       session manager
+ * @param[in]       codec context got from hb_mm_session_acquire()
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_session_release(mc_session_manager_t *mgr,
+				media_codec_context_t *context);
+
+/**
+ * Get the statistics of the session manager.
+ *
+ * @param[in]       session manager
+ * @param[out]      statistics @see mc_session_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_session_get_stats(mc_session_manager_t *mgr,
+				mc_session_stats_t *stats);
+
+/**
+ * Release the idle instances and destroy the session manager. Every
+ * instance must have been given back.
+ *
+ * @param[in]       session manager
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_session_destroy(mc_session_manager_t *mgr);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_SESSION_H */
@@ -0,0 +1,50 @@
+#ifndef HB_MEDIA_SIMD_H
+#define HB_MEDIA_SIMD_H
+
+#include "hb_media_basic_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Define the instruction sets used by the host side pixel kernels.
+ **/
+typedef enum _mc_simd_isa {
+    MC_SIMD_ISA_NONE = -1,
+    MC_SIMD_ISA_C,
+    MC_SIMD_ISA_SSE2,
+    MC_SIMD_ISA_AVX2,
+    MC_SIMD_ISA_NEON,
+    MC_SIMD_ISA_TOTAL
+} mc_simd_isa_t;
+
+/**
+ * Get the best instruction set of the pixel kernels on this CPU, capped
+ * by hb_mm_simd_set_isa().
+ *
+ * @return @see mc_simd_isa_t
+ */
+extern mc_simd_isa_t hb_mm_simd_get_isa(void);
+
+/**
+ * Cap the instruction set of the pixel kernels. It's for benchmarking
+ * and verification. MC_SIMD_ISA_NONE removes the cap.
+ *
+ * @param[in]       instruction set @see mc_simd_isa_t
+ */
+extern void hb_mm_simd_set_isa(mc_simd_isa_t isa);
+
+/**
+ * Get the name of the instruction set.
+ *
+ * @param[in]       instruction set @see mc_simd_isa_t
+ *
+ * @return name string
+ */
+extern const char *hb_mm_simd_isa_name(mc_simd_isa_t isa);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_SIMD_H */
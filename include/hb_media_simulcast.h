@@ -0,0 +1,131 @@
+#ifndef HB_MEDIA_SIMULCAST_H
+#define HB_MEDIA_SIMULCAST_H
+
+#include "hb_media_codec.h"
+#include "hb_media_scaler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Maximum number of renditions, one encoder instance each */
+#define MC_SIMULCAST_MAX_OUTPUTS 4
+
+/**
+ * Define the parameters of the simulcast feeder. One source picture is
+ * scaled into the input buffers of several started encoder instances and
+ * queued to all of them with the same pts. Each instance encodes at the
+ * width, height and pixel format of its video_enc_params; the caller
+ * drains the output buffers of each instance as usual.
+ **/
+typedef struct _mc_simulcast_params {
+    /**
+     * Source picture width and height.
+     * Values[>0]
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_s32 src_width;
+    hb_s32 src_height;
+
+    /**
+     * Scaling filter @see mc_scale_filter_t
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: MC_SCALE_FILTER_BILINEAR
+     */
+    mc_scale_filter_t filter;
+
+    /**
+     * Timeout in ms to dequeue one input buffer.
+     * Values[>=-1]
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_s32 timeout;
+} mc_simulcast_params_t;
+
+/**
+ * Define the statistics of the simulcast feeder.
+ **/
+typedef struct _mc_simulcast_stats {
+    /* Source pictures queued to every instance */
+    hb_u64 frames;
+    /* Feeds that returned early because an input buffer wasn't ready */
+    hb_u64 stalls;
+    /* Total and maximum scaling time per instance in us */
+    hb_u64 scale_us[MC_SIMULCAST_MAX_OUTPUTS];
+    hb_u64 max_scale_us[MC_SIMULCAST_MAX_OUTPUTS];
+} mc_simulcast_stats_t;
+
+typedef struct _mc_simulcast mc_simulcast_t;
+
+/**
+ * Create the simulcast feeder. The scalers of all instances are created
+ * here.
+ *
+ * @param[in]       simulcast parameters @see mc_simulcast_params_t
+ * @param[in]       started encoder instances
+ * @param[in]       number of instances, Values[1, MC_SIMULCAST_MAX_OUTPUTS]
+ * @param[out]      simulcast feeder
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_simulcast_create(const mc_simulcast_params_t *params,
+				media_codec_context_t **contexts, hb_s32 num,
+				mc_simulcast_t **sc);
+
+/**
+ * Feed one source picture to all instances in lockstep. Input buffers are
+ * dequeued from every instance before anything is queued, so either all
+ * instances get the picture or none does. Buffers already dequeued are
+ * kept for the next call if one instance times out.
+ *
+ * @param[in]       simulcast feeder
+ * @param[in]       source format
+ * @param[in]       source planes @see mc_video_planes_t
+ * @param[in]       presentation time shared by all instances
+ *
+ * @return =0 on success, HB_MEDIA_ERR_WAIT_TIMEOUT if an instance had no
+ *         free input buffer, other negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_simulcast_feed(mc_simulcast_t *sc,
+				mc_pixel_format_t src_fmt, const mc_video_planes_t *src,
+				hb_u64 pts);
+
+/**
+ * Queue an end of stream input buffer to all instances.
+ *
+ * @param[in]       simulcast feeder
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_simulcast_end(mc_simulcast_t *sc);
+
+/**
+ * Get the statistics of the simulcast feeder.
+ *
+ * @param[in]       simulcast feeder
+ * @param[out]      statistics @see mc_simulcast_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_simulcast_get_stats(mc_simulcast_t *sc,
+				mc_simulcast_stats_t *stats);
+
+/**
+ * Destroy the simulcast feeder. Input buffers still held after a stall are
+ * queued back to their instances empty. The instances aren't stopped.
+ *
+ * @param[in]       simulcast feeder
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_simulcast_destroy(mc_simulcast_t *sc);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_SIMULCAST_H */
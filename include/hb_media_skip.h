@@ -0,0 +1,149 @@
+#ifndef HB_MEDIA_SKIP_H
+#define HB_MEDIA_SKIP_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Define the parameters of the static scene skip detector. Each input
+ * picture is compared block by block against the last picture that was
+ * encoded; when almost no block changed the picture is skipped with
+ * hb_mm_mc_skip_pic() and the decoder repeats the previous one.
+ **/
+typedef struct _mc_skip_params {
+    /**
+     * Luma width and height in pixels.
+     * Values[>0]
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_s32 width;
+    hb_s32 height;
+
+    /**
+     * SAD of a 16x16 luma block above which the block counts as changed.
+     * Blocks cut by the picture border use a proportional threshold.
+     * Values[>0]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 block_sad_threshold;
+
+    /**
+     * Changed blocks in per mille of all blocks up to which the picture
+     * is still static.
+     * Values[0,1000]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 changed_permille;
+
+    /**
+     * Maximum number of consecutive skipped pictures, 0 for no limit.
+     * Values[>=0]
+     *
+     * - Note: It's changable parameter in the same sequence.
+     * - Default: 0
+     */
+    hb_u32 max_skip_frames;
+} mc_skip_params_t;
+
+/**
+ * Define the statistics of the static scene skip detector.
+ **/
+typedef struct _mc_skip_stats {
+    /* Pictures checked */
+    hb_u64 frames;
+    /* Pictures skipped */
+    hb_u64 skipped;
+    /* Static pictures encoded because of max_skip_frames */
+    hb_u64 forced;
+    /* Changed blocks of the last picture, counting stops at the limit */
+    hb_u32 last_changed_blocks;
+    /* Total and maximum detection time per picture in us */
+    hb_u64 cost_us;
+    hb_u64 max_cost_us;
+} mc_skip_stats_t;
+
+typedef struct _mc_skip_detector mc_skip_detector_t;
+
+/**
+ * Create the skip detector. The reference picture is allocated here.
+ *
+ * @param[in]       skip parameters @see mc_skip_params_t
+ * @param[out]      skip detector
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_skip_create(const mc_skip_params_t *params,
+				mc_skip_detector_t **det);
+
+/**
+ * Change the thresholds. The size can't change.
+ *
+ * @param[in]       skip detector
+ * @param[in]       skip parameters @see mc_skip_params_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_skip_set_params(mc_skip_detector_t *det,
+				const mc_skip_params_t *params);
+
+/**
+ * Decide whether one picture can be skipped. When it can't, the picture
+ * becomes the new reference. The first picture is never skipped.
+ *
+ * @param[in]       skip detector
+ * @param[in]       luma plane
+ * @param[in]       luma stride in bytes
+ * @param[out]      whether the picture should be skipped
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_skip_detect(mc_skip_detector_t *det, const hb_u8 *luma,
+				hb_s32 stride, hb_bool *skip);
+
+/**
+ * Run the detector on a dequeued encoder input buffer and call
+ * hb_mm_mc_skip_pic() for it if it is static. Call it after the picture
+ * is filled and before it is queued.
+ *
+ * @param[in]       skip detector
+ * @param[in]       codec context
+ * @param[in]       filled input buffer @see media_codec_buffer_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_skip_apply(mc_skip_detector_t *det,
+				media_codec_context_t *context, media_codec_buffer_t *buffer);
+
+/**
+ * Get the statistics of the skip detector.
+ *
+ * @param[in]       skip detector
+ * @param[out]      statistics @see mc_skip_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_skip_get_stats(mc_skip_detector_t *det,
+				mc_skip_stats_t *stats);
+
+/**
+ * Destroy the skip detector.
+ *
+ * @param[in]       skip detector
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_skip_destroy(mc_skip_detector_t *det);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_SKIP_H */
@@ -0,0 +1,198 @@
+#ifndef HB_MEDIA_SLICESTREAM_H
+#define HB_MEDIA_SLICESTREAM_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Bytes of the header in front of every slice on the socket sink.
+ **/
+#define MC_SLICESTREAM_HEADER_SIZE 40
+
+/**
+ * First bytes of the header on the socket sink, "HBSL".
+ **/
+#define MC_SLICESTREAM_HEADER_MAGIC 0x4842534CU
+
+/**
+ * Define the sinks of the slice streamer.
+ **/
+typedef enum _mc_slicestream_sink {
+    /* Annex-B bytes in stream order, the slices of a picture simply
+     * follow each other */
+    MC_SLICESTREAM_SINK_FILE = 0,
+    /* Stream socket, every slice behind a header @see mc_slice_info_t */
+    MC_SLICESTREAM_SINK_SOCKET,
+    /* Connected datagram socket, RTP packets of RFC 6184(H264) or RFC
+     * 7798(H265); the marker bit ends the picture */
+    MC_SLICESTREAM_SINK_RTP,
+    MC_SLICESTREAM_SINK_TOTAL,
+} mc_slicestream_sink_t;
+
+/**
+ * Define the parameters of the slice streamer. It forwards every output
+ * buffer of an H264 or H265 encoder to the sink as soon as it's dequeued.
+ * With the slice interrupt of @see mc_video_slice_params_t each buffer
+ * holds one slice, so the first bytes of a picture leave before the rest
+ * of it is encoded; whole picture buffers work the same way.
+ **/
+typedef struct _mc_slicestream_params {
+    /**
+     * Sink type.
+     * Values[MC_SLICESTREAM_SINK_FILE,MC_SLICESTREAM_SINK_RTP]
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: MC_SLICESTREAM_SINK_FILE
+     */
+    mc_slicestream_sink_t sink;
+
+    /**
+     * Codec of the stream, MEDIA_CODEC_ID_H264 or MEDIA_CODEC_ID_H265.
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: MEDIA_CODEC_ID_H264
+     */
+    media_codec_id_t codec_id;
+
+    /**
+     * File or connected socket written to. The streamer doesn't close it.
+     * Values[>=0]
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_s32 fd;
+
+    /**
+     * Largest RTP packet including its 12 bytes header, larger NAL units
+     * are sent as fragmentation units.
+     * Values[64,65507], 0 means 1400
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_u32 mtu;
+
+    /**
+     * RTP payload type and SSRC. The RTP timestamp is the pts in ms on
+     * the 90kHz clock.
+     * Values[96,127] for the payload type
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_u32 payload_type;
+    hb_u32 ssrc;
+} mc_slicestream_params_t;
+
+/**
+ * Define where one output buffer belongs in its picture. On the socket
+ * sink it's sent in front of the slice data in network byte order:
+ * magic(4) frame_index(4) slice_idx(4) slice_count(4) slice_num(4)
+ * offset(4) size(4) pts(8) flags(4), flags bit 0 is last and bit 1 key.
+ **/
+typedef struct _mc_slice_info {
+    /* Picture number from 0 and its pts */
+    hb_u32 frame_index;
+    hb_u64 pts;
+    /* First slice of the buffer, slices in it and slices of the picture */
+    hb_u32 slice_idx;
+    hb_u32 slice_count;
+    hb_u32 slice_num;
+    /* Bytes of the picture before the buffer and bytes of the buffer */
+    hb_u32 offset;
+    hb_u32 size;
+    /* The buffer completes the picture */
+    hb_bool last;
+    /* The picture is an IDR or IRAP one */
+    hb_bool key;
+} mc_slice_info_t;
+
+/**
+ * Define the statistics of the slice streamer.
+ **/
+typedef struct _mc_slicestream_stats {
+    /* Pictures completed, buffers and bytes forwarded */
+    hb_u64 frames;
+    hb_u64 buffers;
+    hb_u64 bytes;
+    /* Most slices of one picture */
+    hb_u32 max_slices;
+    /* Pictures a new one started in before all their slices came */
+    hb_u64 incomplete_frames;
+    /* RTP packets and the NAL units fragmented over several of them */
+    hb_u64 packets;
+    hb_u64 fragmented_units;
+    /* Writes the sink failed */
+    hb_u64 write_errors;
+} mc_slicestream_stats_t;
+
+typedef struct _mc_slicestream mc_slicestream_t;
+
+/**
+ * Create the slice streamer.
+ *
+ * @param[in]       streamer parameters @see mc_slicestream_params_t
+ * @param[out]      slice streamer
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_slicestream_create(const mc_slicestream_params_t *params,
+				mc_slicestream_t **stream);
+
+/**
+ * Forward one output buffer to the sink before it's queued back to the
+ * encoder. The slices are counted from the NAL units of the buffer
+ * against the slice number of the output information; without it the
+ * buffer is taken as a whole picture.
+ *
+ * @param[in]       slice streamer
+ * @param[in]       output buffer @see media_codec_buffer_t
+ * @param[in]       output buffer information, can be NULL
+ * @param[out]      where the buffer belongs @see mc_slice_info_t, can be NULL
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_slicestream_write(mc_slicestream_t *stream,
+				const media_codec_buffer_t *buffer,
+				const media_codec_output_buffer_info_t *info,
+				mc_slice_info_t *slice);
+
+/**
+ * Read the header a socket sink sent in front of a slice.
+ *
+ * @param[in]       MC_SLICESTREAM_HEADER_SIZE bytes of header
+ * @param[out]      where the slice belongs @see mc_slice_info_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_slicestream_parse_header(const hb_u8 *data,
+				mc_slice_info_t *slice);
+
+/**
+ * Get the statistics of the slice streamer.
+ *
+ * @param[in]       slice streamer
+ * @param[out]      statistics @see mc_slicestream_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_slicestream_get_stats(mc_slicestream_t *stream,
+				mc_slicestream_stats_t *stats);
+
+/**
+ * Destroy the slice streamer.
+ *
+ * @param[in]       slice streamer
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_slicestream_destroy(mc_slicestream_t *stream);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_SLICESTREAM_H */
@@ -0,0 +1,114 @@
+#ifndef HB_MEDIA_STARTUP_H
+#define HB_MEDIA_STARTUP_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Define the parameters of an encoder start up. The start up runs from an
+ * uninitialized context to the first encoded picture.
+ **/
+typedef struct _mc_startup_params {
+    /**
+     * Configuration snapshot applied to the context, @see hb_mm_config_load().
+     * NULL keeps the parameters of the context.
+     *
+     * - Note: It's changable parameter.
+     * - Default: NULL
+     */
+    const char *config_file;
+
+    /**
+     * Input file of raw pictures, the first one is read into the first
+     * input buffer. NULL queues a blank picture.
+     *
+     * - Note: It's changable parameter.
+     * - Default: NULL
+     */
+    const char *input_file;
+
+    /**
+     * Buffers pre-warmed in the buffer pool, @see hb_mm_bufpool_prewarm().
+     * 0 of prewarm_num pre-warms nothing.
+     *
+     * - Note: It's changable parameter.
+     * - Default: 0
+     */
+    hb_u32 prewarm_size;
+    hb_u32 prewarm_align;
+    hb_u32 prewarm_num;
+
+    /**
+     * Overlap the snapshot parsing, the input file opening with the read
+     * of the first picture and the pre-warming with hb_mm_mc_initialize()
+     * on helper threads. The context is initialized with its own codec_id,
+     * which must match the one of the snapshot.
+     * Values[0, 1]
+     *
+     * - Note: It's changable parameter.
+     * - Default: 0
+     */
+    hb_bool early_start;
+
+    /**
+     * Timeout of each dequeue in ms.
+     * Values[>0]
+     *
+     * - Note: It's changable parameter.
+     * - Default: 0
+     */
+    hb_s32 timeout;
+} mc_startup_params_t;
+
+/**
+ * Define the time spent in each stage of a start up in us.
+ **/
+typedef struct _mc_startup_stats {
+    /**
+     * Snapshot parsing, file opening and pre-warming. With early_start it
+     * is only the wait for the helper threads after hb_mm_mc_initialize().
+     */
+    hb_u64 prepare_us;
+    hb_u64 initialize_us;
+    /* hb_mm_mc_configure(), with the side configurations of the snapshot */
+    hb_u64 configure_us;
+    hb_u64 start_us;
+    /* The first hb_mm_mc_dequeue_input_buffer() and the picture fill */
+    hb_u64 first_input_us;
+    /* From the first queued picture to the first output without stream_end */
+    hb_u64 first_output_us;
+    /* From the call to the first output */
+    hb_u64 total_us;
+} mc_startup_stats_t;
+
+/**
+ * Start an encoder and encode the first picture, timing each stage. The
+ * context is left started and the first output is handed to the caller,
+ * who writes it out, gives it back with hb_mm_mc_queue_output_buffer()
+ * and goes on with the second picture. It's the IDR with the parameter
+ * sets the rest of the stream refers to.
+ *
+ * @param[in]       uninitialized codec context @see media_codec_context_t
+ * @param[in]       start up parameters @see mc_startup_params_t
+ * @param[out]      fd of the input file behind the first picture, -1
+ *                  without input file. The caller closes it.
+ * @param[out]      first output buffer @see media_codec_buffer_t
+ * @param[out]      first output buffer information
+ *                  @see media_codec_output_buffer_info_t
+ * @param[out]      stage times @see mc_startup_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_startup_run(media_codec_context_t *context,
+				const mc_startup_params_t *params, hb_s32 *input_fd,
+				media_codec_buffer_t *output,
+				media_codec_output_buffer_info_t *output_info,
+				mc_startup_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_STARTUP_H */
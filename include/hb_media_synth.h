@@ -0,0 +1,94 @@
+#ifndef HB_MEDIA_SYNTH_H
+#define HB_MEDIA_SYNTH_H
+
+#include "hb_media_codec.h"
+#include "hb_media_simd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define MC_SYNTH_MAX_BLOCKS 32
+#define MC_SYNTH_MAX_NOISE 64
+
+/**
+ * Define the content of a synthetic input source. A picture is a moving
+ * luma gradient with flat chroma, moving blocks on top of it and luma
+ * noise. Every scene picks its own gradient, colors and block paths; the
+ * same parameters and frame index always give the same picture, at any
+ * instruction set.
+ **/
+typedef struct _mc_synth_params {
+    /**
+     * Seed of the scene contents.
+     *
+     * - Note: It's changable parameter.
+     * - Default: 0
+     */
+    hb_u32 seed;
+
+    /**
+     * Number of moving blocks.
+     * Values[0, MC_SYNTH_MAX_BLOCKS]
+     *
+     * - Note: It's changable parameter.
+     * - Default: 0
+     */
+    hb_u32 block_num;
+
+    /**
+     * Block edge in pixels, clipped to the picture.
+     * Values[>0 when block_num > 0]
+     *
+     * - Note: It's changable parameter.
+     * - Default: 0
+     */
+    hb_u32 block_size;
+
+    /**
+     * Maximum block and gradient motion in pixels per frame.
+     * Values[0, 64]
+     *
+     * - Note: It's changable parameter.
+     * - Default: 0
+     */
+    hb_u32 motion;
+
+    /**
+     * Luma noise amplitude, each pixel moves by up to +/- noise.
+     * Values[0, MC_SYNTH_MAX_NOISE]
+     *
+     * - Note: It's changable parameter.
+     * - Default: 0
+     */
+    hb_u32 noise;
+
+    /**
+     * Frames starting a new scene, ascending. Frame 0 always starts one.
+     *
+     * - Note: It's changable parameter.
+     * - Default: NULL
+     */
+    const hb_u32 *scene_cuts;
+    hb_u32 scene_cut_num;
+} mc_synth_params_t;
+
+/**
+ * Generate a picture straight into the planes of an encoder input buffer.
+ * The format (MC_PIXEL_FORMAT_YUV420P, MC_PIXEL_FORMAT_NV12 or
+ * MC_PIXEL_FORMAT_NV21), size and strides are taken from the frame buffer,
+ * laid out as for hb_mm_pixfmt_convert().
+ *
+ * @param[in]       source parameters @see mc_synth_params_t
+ * @param[in]       frame index
+ * @param[in,out]   destination frame buffer @see mc_video_frame_buffer_info_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_synth_fill(const mc_synth_params_t *params, hb_u32 frame,
+				mc_video_frame_buffer_info_t *dst);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_SYNTH_H */
@@ -0,0 +1,156 @@
+#ifndef HB_MEDIA_TELEMETRY_H
+#define HB_MEDIA_TELEMETRY_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Define the columns of the telemetry file. The file has a 4 KiB header
+ * followed by chunks of MC_TELEMETRY_CHUNK_FRAMES pictures; inside a chunk
+ * every column is one contiguous array, so a reader maps the file and
+ * scans a single column without touching the others.
+ **/
+typedef enum _mc_telemetry_column {
+	MC_TELEMETRY_COLUMN_NONE = -1,
+	/* hb_u64, time the input picture was queued in us */
+	MC_TELEMETRY_COLUMN_QUEUE_US,
+	/* hb_u64, time the output stream was dequeued in us */
+	MC_TELEMETRY_COLUMN_DEQUEUE_US,
+	/* hb_u32, frame_cycle */
+	MC_TELEMETRY_COLUMN_FRAME_CYCLE,
+	/* hb_u32, enc_pic_byte */
+	MC_TELEMETRY_COLUMN_ENC_PIC_BYTE,
+	/* hb_u8, avg_mb_qp */
+	MC_TELEMETRY_COLUMN_AVG_MB_QP,
+	/* hb_s8, nalu_type */
+	MC_TELEMETRY_COLUMN_NALU_TYPE,
+	/* hb_u8, pic_skipped */
+	MC_TELEMETRY_COLUMN_PIC_SKIPPED,
+	/* hb_u8, temporal_id */
+	MC_TELEMETRY_COLUMN_TEMPORAL_ID,
+	MC_TELEMETRY_COLUMN_TOTAL,
+} mc_telemetry_column_t;
+
+/* Pictures per chunk */
+#define MC_TELEMETRY_CHUNK_FRAMES 4096
+
+/**
+ * Define the statistics of the telemetry writer.
+ **/
+typedef struct _mc_telemetry_stats {
+    /* Pictures written */
+    hb_u64 frames;
+    /* Pictures dropped because the file was full */
+    hb_u64 dropped;
+} mc_telemetry_stats_t;
+
+typedef struct _mc_telemetry_writer mc_telemetry_writer_t;
+typedef struct _mc_telemetry_reader mc_telemetry_reader_t;
+
+/**
+ * Create the telemetry file and map it. The file is sized for capacity
+ * pictures up front as a sparse file, writing a picture afterwards
+ * neither allocates nor locks. One writer per file.
+ *
+ * @param[in]       file path, an existing file is replaced
+ * @param[in]       maximum number of pictures, Values[>0]
+ * @param[out]      telemetry writer
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_telemetry_create(const char *path, hb_u64 capacity,
+				mc_telemetry_writer_t **writer);
+
+/**
+ * Append the telemetry of one encoded picture. Call it from the output
+ * dequeue path with the information of the dequeued buffer. The picture
+ * count in the header is published after the columns, so a reader
+ * mapping the file at the same time only sees complete pictures.
+ *
+ * @param[in]       telemetry writer
+ * @param[in]       output buffer information @see media_codec_output_buffer_info_t
+ * @param[in]       time the input picture was queued in us
+ * @param[in]       time the output stream was dequeued in us
+ *
+ * @return =0 on success, HB_MEDIA_ERR_INSUFFICIENT_RES once the file is
+ *         full, other negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_telemetry_write(mc_telemetry_writer_t *writer,
+				const media_codec_output_buffer_info_t *info, hb_u64 queue_us,
+				hb_u64 dequeue_us);
+
+/**
+ * Get the statistics of the telemetry writer.
+ *
+ * @param[in]       telemetry writer
+ * @param[out]      statistics @see mc_telemetry_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_telemetry_get_stats(mc_telemetry_writer_t *writer,
+				mc_telemetry_stats_t *stats);
+
+/**
+ * Unmap the telemetry file and cut it after the last used chunk.
+ *
+ * @param[in]       telemetry writer
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_telemetry_destroy(mc_telemetry_writer_t *writer);
+
+/**
+ * Map a telemetry file read only. It may still be written.
+ *
+ * @param[in]       file path
+ * @param[out]      telemetry reader
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_telemetry_open(const char *path,
+				mc_telemetry_reader_t **reader);
+
+/**
+ * Get the number of complete pictures in the file.
+ *
+ * @param[in]       telemetry reader
+ * @param[out]      number of pictures
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_telemetry_get_frames(mc_telemetry_reader_t *reader,
+				hb_u64 *frames);
+
+/**
+ * Get one column of one chunk. The data points into the mapping and
+ * holds num values of the column type, num is smaller than
+ * MC_TELEMETRY_CHUNK_FRAMES only in the last chunk.
+ *
+ * @param[in]       telemetry reader
+ * @param[in]       column @see mc_telemetry_column_t
+ * @param[in]       chunk index, Values[0, frames / MC_TELEMETRY_CHUNK_FRAMES]
+ * @param[out]      column values
+ * @param[out]      number of values
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_telemetry_get_column(mc_telemetry_reader_t *reader,
+				mc_telemetry_column_t column, hb_u64 chunk, const void **data,
+				hb_u32 *num);
+
+/**
+ * Unmap the telemetry file.
+ *
+ * @param[in]       telemetry reader
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_telemetry_close(mc_telemetry_reader_t *reader);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_TELEMETRY_H */
@@ -0,0 +1,183 @@
+#ifndef HB_MEDIA_TLAYER_H
+#define HB_MEDIA_TLAYER_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Temporal layers of a dyadic GOP of at most MC_MAX_GOP_NUM pictures */
+#define MC_TLAYER_MAX_LAYERS 4
+
+/**
+ * Define the parameters of a dyadic temporal hierarchy. A GOP of
+ * 2^(layers-1) P pictures is built; picture n of the GOP is in layer
+ * layers-1-ctz(n) and refers to picture n-2^ctz(n), which is always in a
+ * lower layer. So no picture refers to its own layer or a higher one and
+ * every layer above 0 can be dropped together with the layers above it.
+ **/
+typedef struct _mc_tlayer_gop_params {
+    /**
+     * Number of temporal layers.
+     * Values[1,MC_TLAYER_MAX_LAYERS]
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_u32 layers;
+
+    /**
+     * QP of the pictures in layer 0.
+     * Values[0,51]
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_u32 base_qp;
+
+    /**
+     * QP added per layer above 0, clipped to 51.
+     * Values[0,51]
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_u32 qp_step;
+} mc_tlayer_gop_params_t;
+
+/**
+ * Define the parameters of the temporal layer dropper. It decides for
+ * every encoded picture whether it is passed on, from the backlog of the
+ * sink: reaching high_watermark drops the highest layer still passed at
+ * once, falling to low_watermark passes one layer more again from the
+ * next picture of layer 0 on, where no picture refers to a dropped one.
+ **/
+typedef struct _mc_tlayer_drop_params {
+    /**
+     * Codec of the stream, MEDIA_CODEC_ID_H264 or MEDIA_CODEC_ID_H265.
+     * H265 pictures carry their temporal id, H264 pictures are counted
+     * from the last key picture. As the H264 layer is only counted, an
+     * H264 picture is dropped only if its nal_ref_idc is 0, so no
+     * frame_num gap is left.
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    media_codec_id_t codec_id;
+
+    /**
+     * Temporal layers of the stream @see mc_tlayer_gop_params_t.
+     * The intra period must be a multiple of the GOP size.
+     * Values[1,MC_TLAYER_MAX_LAYERS]
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_u32 layers;
+
+    /**
+     * Sink backlog, e.g. queued pictures or buffered bytes, from which
+     * one more layer is dropped and up to which one is passed again.
+     * Values[low_watermark < high_watermark]
+     *
+     * - Note: It's unchangable parameter.
+     * - Default: 0
+     */
+    hb_u32 high_watermark;
+    hb_u32 low_watermark;
+} mc_tlayer_drop_params_t;
+
+/**
+ * Define the statistics of the temporal layer dropper.
+ **/
+typedef struct _mc_tlayer_drop_stats {
+    /* Pictures checked */
+    hb_u64 pictures;
+    /* Pictures dropped, in total and per layer */
+    hb_u64 dropped;
+    hb_u64 layer_dropped[MC_TLAYER_MAX_LAYERS];
+    /* Bytes dropped */
+    hb_u64 dropped_bytes;
+    /* H264 pictures of a dropped layer passed as reference pictures */
+    hb_u64 ref_kept;
+    /* Layers dropped now and at most */
+    hb_u32 level;
+    hb_u32 max_level;
+} mc_tlayer_drop_stats_t;
+
+typedef struct _mc_tlayer_dropper mc_tlayer_dropper_t;
+
+/**
+ * Fill in a custom GOP with a dyadic temporal hierarchy and select it
+ * with gop_preset_idx 0. The other GOP parameters are kept.
+ *
+ * @param[in]       hierarchy parameters @see mc_tlayer_gop_params_t
+ * @param[in,out]   GOP parameters of the encoder @see mc_video_gop_params_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_tlayer_build_gop(const mc_tlayer_gop_params_t *params,
+				mc_video_gop_params_t *gop);
+
+/**
+ * Get the temporal layer of a picture of the dyadic hierarchy.
+ *
+ * @param[in]       number of temporal layers
+ * @param[in]       picture index counted from the last key picture
+ *
+ * @return temporal id, 0 for the key picture
+ */
+extern hb_u32 hb_mm_tlayer_get_id(hb_u32 layers, hb_u32 index);
+
+/**
+ * Create the temporal layer dropper.
+ *
+ * @param[in]       dropper parameters @see mc_tlayer_drop_params_t
+ * @param[out]      dropper
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_tlayer_dropper_create(const mc_tlayer_drop_params_t *params,
+				mc_tlayer_dropper_t **dropper);
+
+/**
+ * Decide whether one encoded picture is dropped. Every picture of the
+ * stream goes through here in order, the dropped ones included. Layer 0
+ * and the parameter sets are never dropped.
+ *
+ * @param[in]       dropper
+ * @param[in]       encoded picture, Annex-B byte stream
+ * @param[in]       encoded picture size
+ * @param[in]       current backlog of the sink
+ * @param[out]      whether the picture should be dropped
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_tlayer_dropper_check(mc_tlayer_dropper_t *dropper,
+				const hb_u8 *data, hb_u32 size, hb_u32 backlog, hb_bool *drop);
+
+/**
+ * Get the statistics of the dropper.
+ *
+ * @param[in]       dropper
+ * @param[out]      statistics @see mc_tlayer_drop_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_tlayer_dropper_get_stats(mc_tlayer_dropper_t *dropper,
+				mc_tlayer_drop_stats_t *stats);
+
+/**
+ * Destroy the dropper.
+ *
+ * @param[in]       dropper
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_tlayer_dropper_destroy(mc_tlayer_dropper_t *dropper);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_TLAYER_H */
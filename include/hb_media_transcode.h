@@ -0,0 +1,108 @@
+#ifndef HB_MEDIA_TRANSCODE_H
+#define HB_MEDIA_TRANSCODE_H
+
+#include "hb_media_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Maximum encoder frame_buf_count, one decoded frame in flight each */
+#define MC_TRANSCODE_MAX_INFLIGHT 31
+
+/**
+ * Define the parameters of the transcoder. Decoded frames are queued to
+ * the encoder by their physical address and dma-buf fd, without a CPU
+ * copy; the encoder must be started with external_frame_buf. A decoded
+ * frame goes back to the decoder when the encoder hands its input buffer
+ * out again, so at most the encoder's frame_buf_count frames are in
+ * flight and the decoder keeps at least one buffer to decode into.
+ **/
+typedef struct _mc_transcode_params {
+    /**
+     * Timeout in ms to dequeue one encoder input buffer or one decoded
+     * frame.
+     * Values[>=-1]
+     *
+     * - Note: It's unchangable parameters in the same sequence.
+     * - Default: 0
+     */
+    hb_s32 timeout;
+} mc_transcode_params_t;
+
+/**
+ * Define the statistics of the transcoder.
+ **/
+typedef struct _mc_transcode_stats {
+    /* Decoded frames queued to the encoder */
+    hb_u64 frames;
+    /* Decoded frames returned to the decoder */
+    hb_u64 released;
+    /* Pumps that returned early waiting for the encoder or the decoder */
+    hb_u64 encoder_stalls;
+    hb_u64 decoder_stalls;
+    /* Decoded frames held by the encoder now and at most */
+    hb_u32 inflight;
+    hb_u32 max_inflight;
+    /* The end of stream was queued to the encoder */
+    hb_bool eos;
+} mc_transcode_stats_t;
+
+typedef struct _mc_transcode mc_transcode_t;
+
+/**
+ * Create the transcoder between a started decoder and a started encoder.
+ * The decoder frame_buf_count must exceed the encoder's.
+ *
+ * @param[in]       transcoder parameters @see mc_transcode_params_t
+ * @param[in]       started decoder instance
+ * @param[in]       started encoder instance with external_frame_buf
+ * @param[out]      transcoder
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_transcode_create(const mc_transcode_params_t *params,
+				media_codec_context_t *decoder, media_codec_context_t *encoder,
+				mc_transcode_t **tc);
+
+/**
+ * Move one decoded frame to the encoder. An encoder input buffer is
+ * dequeued first, which returns the decoded frame it held before; the
+ * buffer is kept for the next call if no decoded frame is ready. The end
+ * of the decoded frames is queued to the encoder as the end of stream.
+ * The caller keeps feeding the decoder and draining the encoder.
+ *
+ * @param[in]       transcoder
+ *
+ * @return =0 on success, HB_MEDIA_ERR_WAIT_TIMEOUT if the encoder or the
+ *         decoder had nothing ready, other negative HB_MEDIA_ERROR in case
+ *         of failure
+ */
+extern hb_s32 hb_mm_transcode_pump(mc_transcode_t *tc);
+
+/**
+ * Get the statistics of the transcoder.
+ *
+ * @param[in]       transcoder
+ * @param[out]      statistics @see mc_transcode_stats_t
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_transcode_get_stats(mc_transcode_t *tc,
+				mc_transcode_stats_t *stats);
+
+/**
+ * Destroy the transcoder. Decoded frames still held are returned to the
+ * decoder, so the encoder must have reached the end of stream or been
+ * stopped. The instances aren't stopped.
+ *
+ * @param[in]       transcoder
+ *
+ * @return =0 on success, negative HB_MEDIA_ERROR in case of failure
+ */
+extern hb_s32 hb_mm_transcode_destroy(mc_transcode_t *tc);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* HB_MEDIA_TRANSCODE_H */
@@ -6,7 +6,9 @@
 #include <time.h>
 #include <iostream>
 #include "hb_media_codec.h"
+#include "hb_media_config.h"
 #include "hb_media_error.h"
+#include "hb_media_synth.h"
 
 // 这是一个编码示例
 #define MAX_FILE_PATH 512
@@ -44,8 +46,8 @@ Uint64 osal_gettime(void)
 static void do_sync_encoding(void *arg)
 {
     hb_s32 ret = 0;
-    FILE *inFile;
-    FILE *outFile;
+    FILE *inFile = NULL;
+    FILE *outFile = NULL;
     int noMoreInput = 0;
     int lastStream = 0;
     Uint64 lastTime = 0;
@@ -56,9 +58,25 @@ static void do_sync_encoding(void *arg)
     char *inputFileName = ctx->inputFileName;
     char *outputFileName = ctx->outputFileName;
     media_codec_state_t state = MEDIA_CODEC_STATE_NONE;
+    // 输入文件为 "synth" 时直接在输入缓冲区中生成图像, 不读文件
+    int synth = (strcmp(inputFileName, "synth") == 0);
+    hb_u32 synthFrame = 0;
+    const hb_u32 synthCuts[] = {0, 150};
+    mc_synth_params_t synthParams;
+    memset(&synthParams, 0x00, sizeof(synthParams));
+    synthParams.seed = 1;
+    synthParams.block_num = 8;
+    synthParams.block_size = 128;
+    synthParams.motion = 8;
+    synthParams.noise = 4;
+    synthParams.scene_cuts = synthCuts;
+    synthParams.scene_cut_num = sizeof(synthCuts) / sizeof(synthCuts[0]);
 
-    inFile = fopen(inputFileName, "rb");
-    if (!inFile)
+    if (!synth)
+    {
+        inFile = fopen(inputFileName, "rb");
+    }
+    if (!synth && !inFile)
     {
         printf("Failed to open input file.\n");
         goto ERR;
@@ -73,20 +91,25 @@ static void do_sync_encoding(void *arg)
 
     // get current time
     lastTime = osal_gettime();
-    ret = hb_mm_mc_initialize(context);
-    if (ret)
-    {
-        printf("hb_mm_mc_initialize failed\n");
-        goto ERR;
-    }
-    cout << "hb_mm_mc_initialize success!" << endl;
-    ret = hb_mm_mc_configure(context);
-    if (ret)
+    // 从配置快照启动时已经初始化并配置好了
+    hb_mm_mc_get_state(context, &state);
+    if (state != MEDIA_CODEC_STATE_CONFIGURED)
     {
-        printf("hb_mm_mc_configure failed\n");
-        goto ERR;
+        ret = hb_mm_mc_initialize(context);
+        if (ret)
+        {
+            printf("hb_mm_mc_initialize failed\n");
+            goto ERR;
+        }
+        cout << "hb_mm_mc_initialize success!" << endl;
+        ret = hb_mm_mc_configure(context);
+        if (ret)
+        {
+            printf("hb_mm_mc_configure failed\n");
+            goto ERR;
+        }
+        cout << "hb_mm_mc_configure success!" << endl;
     }
-    cout << "hb_mm_mc_configure success!" << endl;
     mc_av_codec_startup_params_t startup_params;
     startup_params.video_enc_startup_params.receive_frame_number = 0;
     ret = hb_mm_mc_start(context, &startup_params);
@@ -116,7 +139,21 @@ static void do_sync_encoding(void *arg)
             if (!ret)
             {
                 curTime = osal_gettime();
-                if ((curTime - lastTime) < (uint32_t)ctx->duration)
+                if (((curTime - lastTime) < (uint32_t)ctx->duration) && synth)
+                {
+                    ret = hb_mm_synth_fill(&synthParams, synthFrame++,
+                                           &inputBuffer.vframe_buf);
+                    if (ret)
+                    {
+                        printf("Failed to generate input frame\n");
+                        ret = 0;
+                    }
+                    else
+                    {
+                        ret = inputBuffer.vframe_buf.size;
+                    }
+                }
+                else if ((curTime - lastTime) < (uint32_t)ctx->duration)
                 {
                     ret = fread(inputBuffer.vframe_buf.vir_ptr[0], 1,
                                 inputBuffer.vframe_buf.size, inFile);
@@ -240,8 +277,9 @@ ERR:
 
 int main(int argc, char *argv[])
 {
-    if (argc != 4) {
-        printf("Usage: %s <input_file> <output_file> <duration_ms>\n", argv[0]);
+    if (argc != 4 && argc != 5) {
+        printf("Usage: %s <input_file> <output_file> <duration_ms> [config_file]\n", argv[0]);
+        printf("  input_file \"synth\" generates the frames instead of reading them\n");
         return -1;
     }
 
@@ -257,29 +295,48 @@ int main(int argc, char *argv[])
     mc_video_codec_enc_params_t *params;
     media_codec_context_t context;
     memset(&context, 0x00, sizeof(media_codec_context_t));
-    context.codec_id = MEDIA_CODEC_ID_H265;
-    context.encoder = 1;
-    params = &context.video_enc_params;
-    params->width = 1920;
-    params->height = 1080;
-    params->pix_fmt = MC_PIXEL_FORMAT_YUV420P;
-    params->frame_buf_count = 5;
-    params->external_frame_buf = false;
-    params->bitstream_buf_count = 5;
-    params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
-    ret = hb_mm_mc_get_rate_control_config(&context, &params->rc_params);
-    if (ret)
+    if (argc == 5)
     {
-        return -1;
+        // 配置快照: 一次读入, 一次调用完成初始化和配置
+        mc_config_snapshot_t snap;
+        ret = hb_mm_config_load(argv[4], &snap);
+        if (ret == 0)
+        {
+            ret = hb_mm_config_apply(&context, &snap);
+            hb_mm_config_release(&snap);
+        }
+        if (ret)
+        {
+            printf("Failed to apply config %s\n", argv[4]);
+            return -1;
+        }
+    }
+    else
+    {
+        context.codec_id = MEDIA_CODEC_ID_H265;
+        context.encoder = 1;
+        params = &context.video_enc_params;
+        params->width = 1920;
+        params->height = 1080;
+        params->pix_fmt = MC_PIXEL_FORMAT_YUV420P;
+        params->frame_buf_count = 5;
+        params->external_frame_buf = false;
+        params->bitstream_buf_count = 5;
+        params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
+        ret = hb_mm_mc_get_rate_control_config(&context, &params->rc_params);
+        if (ret)
+        {
+            return -1;
+        }
+        params->rc_params.h265_cbr_params.bit_rate = 8000;
+        params->rc_params.h265_cbr_params.frame_rate = 30;
+        params->rc_params.h265_cbr_params.intra_period = 30;
+        params->gop_params.decoding_refresh_type = 2;
+        params->gop_params.gop_preset_idx = 2;
+        params->rot_degree = MC_CCW_0;
+        params->mir_direction = MC_DIRECTION_NONE;
+        params->frame_cropping_flag = false;
     }
-    params->rc_params.h265_cbr_params.bit_rate = 8000;
-    params->rc_params.h265_cbr_params.frame_rate = 30;
-    params->rc_params.h265_cbr_params.intra_period = 30;
-    params->gop_params.decoding_refresh_type = 2;
-    params->gop_params.gop_preset_idx = 2;
-    params->rot_degree = MC_CCW_0;
-    params->mir_direction = MC_DIRECTION_NONE;
-    params->frame_cropping_flag = false;
     // 输入的参数
 
     MediaCodecTestContext ctx;
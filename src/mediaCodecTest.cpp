@@ -1,8 +1,28 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include "hb_media_bufpool.h"
+#include "hb_media_chunk.h"
 #include "hb_media_codec.h"
+#include "hb_media_config.h"
+#include "hb_media_digest.h"
 #include "hb_media_error.h"
+#include "hb_media_log.h"
+#include "hb_media_lowlat.h"
+#include "hb_media_ltr.h"
+#include "hb_media_preview.h"
+#include "hb_media_qpmap.h"
+#include "hb_media_ratectl.h"
+#include "hb_media_scenecut.h"
+#include "hb_media_sei.h"
+#include "hb_media_session.h"
+#include "hb_media_skip.h"
+#include "hb_media_slicestream.h"
+#include "hb_media_startup.h"
+#include "hb_media_synth.h"
+#include "hb_media_telemetry.h"
+#include "hb_media_tlayer.h"
+#include "hb_media_transcode.h"
 #include "include/common.h"
 #ifdef __cplusplus
 extern "C" {
@@ -13,6 +33,8 @@ extern "C" {
 }
 #endif				/* __cplusplus */
 
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 #include <sys/syscall.h>
@@ -71,13 +93,18 @@ typedef struct MediaCodecTestContext {
     // resource
     FILE *inFile;
     FILE *outFile;
-    FILE *inMd5File;
-    int ionFd;
+    // per-frame digests of the output, verified against inputMd5FileName
+    mc_digest_t *digest;
+    // frames generated into the input buffers instead of read from inFile
+    const mc_synth_params_t *synth;
+    hb_u32 synthFrame;
     char *inputFileName;
     char *outputFileName;
     char *inputMd5FileName;
     ExternalFrameBuffer *exFb;
     ExternalStreamBuffer *exBs;
+    // pool buffers behind exFb and exBs
+    mc_bufpool_buffer_t *exPool;
     int abnormal;
     int workMode;
 
@@ -105,12 +132,45 @@ typedef struct MediaCodecTestContext {
     uint32_t force_idr_header;
     int enable_idr_num;
     int req_idr_num;
+    mc_scenecut_detector_t *sceneCutDetector;
     int skip_pic_num;
+    mc_skip_detector_t *skipDetector;
+    // temporal layers dropped in front of a sink taking sinkPermille
+    // pictures per encoded picture
+    mc_tlayer_dropper_t *tlayerDropper;
+    hb_u32 sinkPermille;
+    hb_u32 sinkBacklogMilli;
     int insert_userData_num;
     int enable_explicit_header;
     int qpmap_enable;
     hb_byte qpmap_array;
     hb_u32 qpmap_count;
+    mc_qpmap_generator_t *qpmapGenerator;
+    mc_ratectl_params_t *ratectlParams;
+    mc_ratectl_t *ratectl;
+    // long-term reference controller, created once the encoder started
+    mc_ltr_params_t *ltrParams;
+    mc_ltr_t *ltr;
+    // low latency loss recovery, created once the encoder started; the
+    // picture lowlatLossFrame is reported lost once it is encoded
+    mc_lowlat_params_t *lowlatParams;
+    mc_lowlat_t *lowlat;
+    hb_u64 lowlatLossFrame;
+    // every output buffer forwarded as soon as it's dequeued
+    mc_slicestream_t *sliceStream;
+    // capture metadata in a user data SEI of every picture, read back on
+    // decoding
+    mc_sei_injector_t *seiInjector;
+    mc_sei_extractor_t *seiExtractor;
+    const char *telemetryFileName;
+    mc_telemetry_writer_t *telemetry;
+    // queue time of every input buffer, indexed by src_idx
+    hb_u64 telemetryQueueUs[32];
+    // configured instances of the session manager instead of initializing
+    mc_session_manager_t *sessionMgr;
+    // from initializing or taking the instance to the first output
+    hb_u64 setupStartUs;
+    hb_u64 ttffUs;
 
     // for dynamic parameters
     ENC_CONFIG_MESSAGE dynamicMessage;
@@ -173,13 +233,85 @@ typedef struct MediaCodecTestContext {
     int lastFrame; // encoder
 } MediaCodecTestContext;
 
+typedef decltype(ExternalFrameBuffer::buf) IonBuffer;
+
+// The hbmem module is opened once for the test case, the pool keeps ION
+// buffers idle across sessions and they must not outlive it
+static int gIonModuleOpened = 0;
+
+// ION buffers behind the process wide buffer pool
+static hb_s32 pool_ion_alloc(void *userdata, hb_u32 capacity, hb_u32 align,
+        mc_bufpool_buffer_t *buf) {
+    IonBuffer *ion;
+    (void)userdata;
+    (void)align; // ION buffers are page aligned
+    if (!gIonModuleOpened) {
+        return -1;
+    }
+    ion = (IonBuffer *)calloc(1, sizeof(IonBuffer));
+    if (ion == NULL) {
+        return -1;
+    }
+    ion->size = capacity;
+    if (allocate_ion_mem(1, ion) != 0) {
+        free(ion);
+        return -1;
+    }
+    buf->phys_addr = ion->phys_addr;
+    buf->virt_addr = (hb_u8 *)ion->virt_addr;
+    buf->fd = ion->fd;
+    buf->priv = ion;
+    return 0;
+}
+
+static void pool_ion_free(void *userdata, mc_bufpool_buffer_t *buf) {
+    IonBuffer *ion = (IonBuffer *)buf->priv;
+    (void)userdata;
+    release_ion_mem(1, ion);
+    free(ion);
+}
+
+static int get_pool_buffer(hb_u32 size, mc_bufpool_buffer_t *pool,
+        IonBuffer *ion) {
+    int ret = hb_mm_bufpool_get(size, 4096, pool);
+    if (ret == 0) {
+        *ion = *(IonBuffer *)pool->priv;
+        ion->size = size;
+    }
+    return ret;
+}
+
 class MediaCodecTest:public testing::Test {
 protected:
 static void SetUpTestCase() {
+    mc_bufpool_params_t poolParams;
+    mc_log_params_t logParams;
     std::cout<<"Setup MediaCodecTest test case"<<std::endl;
+    gIonModuleOpened = (hb_mem_module_open() == 0);
+    memset(&poolParams, 0x00, sizeof(poolParams));
+    poolParams.allocator.alloc = pool_ion_alloc;
+    poolParams.allocator.free = pool_ion_free;
+    poolParams.max_idle_bytes = 256 * 1024 * 1024;
+    hb_mm_bufpool_configure(&poolParams);
+    // the select cost and per-frame steps are recorded off the hot path
+    memset(&logParams, 0x00, sizeof(logParams));
+    logParams.level_mask = MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_INFO) |
+        MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_WARN) |
+        MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_ERR);
+    logParams.fd = STDOUT_FILENO;
+    logParams.ring_size = 1 << 20;
+    logParams.flush_interval_ms = 10;
+    hb_mm_log_configure(&logParams);
 }
 
 static void TearDownTestCase() {
+    // the idle pooled buffers go before the module that allocated them
+    hb_mm_bufpool_trim(0);
+    if (gIonModuleOpened) {
+        hb_mem_module_close();
+        gIonModuleOpened = 0;
+    }
+    hb_mm_log_flush();
     std::cout<<"Tear down MediaCodecTest test case"<<std::endl;
 }
 
@@ -322,6 +454,13 @@ static float get_system_time_ms(void) {
     return sys_us/1000.0;
 }
 
+static hb_u64 get_system_time_us(void) {
+    struct timespec tp;
+
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (hb_u64)tp.tv_sec * 1000000 + tp.tv_nsec / 1000;
+}
+
 static void set_message(MediaCodecTestContext *ctx) {
     ASSERT_NE(ctx, nullptr);
     media_codec_context_t *context = ctx->context;
@@ -907,30 +1046,37 @@ static int check_and_init_test(MediaCodecTestContext *ctx) {
         return -1;
     }
 
-    ctx->inFile = fopen(inputFileName, "rb");
-    EXPECT_NE(ctx->inFile, nullptr);
+    if (ctx->synth == NULL) {
+        ctx->inFile = fopen(inputFileName, "rb");
+        EXPECT_NE(ctx->inFile, nullptr);
+    }
     ctx->outFile = fopen(outputFileName, "wb+");
     EXPECT_NE(ctx->outFile, nullptr);
-    if (ctx->inFile == NULL || ctx->outFile == NULL) {
+    if ((ctx->inFile == NULL && ctx->synth == NULL) || ctx->outFile == NULL) {
         return -1;
     }
 
     if (ctx->md5Test == TRUE) {
-        if (inputMd5FileName) {
-            ctx->inMd5File = fopen(inputMd5FileName, "rb");
-        }
-        EXPECT_NE(ctx->inMd5File, nullptr);
-        if (ctx->inMd5File == NULL) {
+        mc_digest_params_t digestParams;
+        char recordFileName[MAX_FILE_PATH];
+        // the digests of this run are kept next to the output, a new
+        // golden file once the output is checked
+        snprintf(recordFileName, sizeof(recordFileName), "%s.digest",
+            outputFileName);
+        memset(&digestParams, 0x00, sizeof(digestParams));
+        digestParams.algos = MC_DIGEST_ALGO_BIT(MC_DIGEST_ALGO_MD5) |
+            MC_DIGEST_ALGO_BIT(MC_DIGEST_ALGO_XXH3);
+        digestParams.golden_file = inputMd5FileName;
+        digestParams.record_file = recordFileName;
+        ret = hb_mm_digest_create(&digestParams, &ctx->digest);
+        EXPECT_EQ(ret, 0);
+        if (ret != 0) {
             return -1;
         }
     }
 
-    // allocate ion buffers
-    ret = hb_mem_module_open();
-    EXPECT_EQ(ret, 0);
-    if (ret == 0) {
-        ctx->ionFd = 1;
-    }
+    // ion buffers come from the hbmem module opened for the test case
+    EXPECT_TRUE(gIonModuleOpened);
 
     if (ctx->context->encoder == TRUE) {
         printf("%s[%d:%d] Thread use %s buffer mode, %d rc mode\n", TAG, getpid(), gettid(),
@@ -944,17 +1090,32 @@ static int check_and_init_test(MediaCodecTestContext *ctx) {
             if (ctx->exFb == NULL) {
                 return -1;
             }
+            ctx->exPool = (mc_bufpool_buffer_t *)calloc(
+                ctx->context->video_enc_params.frame_buf_count, sizeof(mc_bufpool_buffer_t));
+            EXPECT_NE(ctx->exPool, nullptr);
+            if (ctx->exPool == NULL) {
+                return -1;
+            }
             for (Uint32 i=0; i<ctx->context->video_enc_params.frame_buf_count; i++) {
-                ctx->exFb[i].buf.size = ctx->context->video_enc_params.width
-                    * ctx->context->video_enc_params.height * 3/2; // only for yuv420;
-                ret = allocate_ion_mem(ctx->ionFd, &ctx->exFb[i].buf);
+                ret = get_pool_buffer(ctx->context->video_enc_params.width
+                    * ctx->context->video_enc_params.height * 3/2, // only for yuv420;
+                    &ctx->exPool[i], &ctx->exFb[i].buf);
                 EXPECT_EQ(ret, 0);
                 if (ret != 0) {
                     return ret;
                 }
                 ctx->exFb[i].valid = 1;
                 ctx->exFb[i].src_idx = i;
-                if (ctx->readonce != 0) {
+                if (ctx->readonce != 0 && ctx->synth != NULL) {
+                    mc_video_frame_buffer_info_t synthFrame;
+                    memset(&synthFrame, 0x00, sizeof(synthFrame));
+                    synthFrame.vir_ptr[0] = (hb_u8 *)ctx->exFb[i].buf.virt_addr;
+                    synthFrame.width = ctx->context->video_enc_params.width;
+                    synthFrame.height = ctx->context->video_enc_params.height;
+                    synthFrame.pix_fmt = ctx->context->video_enc_params.pix_fmt;
+                    ret = hb_mm_synth_fill(ctx->synth, i, &synthFrame);
+                    EXPECT_EQ(ret, 0);
+                } else if (ctx->readonce != 0) {
                     ret = fread((void *)ctx->exFb[i].buf.virt_addr, 1,
                         ctx->exFb[i].buf.size, ctx->inFile);
                     if (ret <= 0) {
@@ -981,9 +1142,15 @@ static int check_and_init_test(MediaCodecTestContext *ctx) {
                 return -1;
             }
 
+            ctx->exPool = (mc_bufpool_buffer_t *)calloc(
+                ctx->context->video_dec_params.bitstream_buf_count, sizeof(mc_bufpool_buffer_t));
+            EXPECT_NE(ctx->exPool, nullptr);
+            if (ctx->exPool == NULL) {
+                return -1;
+            }
             for (Uint32 i=0; i<ctx->context->video_dec_params.bitstream_buf_count; i++) {
-                ctx->exBs[i].buf.size = ctx->context->video_dec_params.bitstream_buf_size;
-                ret = allocate_ion_mem(ctx->ionFd, &ctx->exBs[i].buf);
+                ret = get_pool_buffer(ctx->context->video_dec_params.bitstream_buf_size,
+                    &ctx->exPool[i], &ctx->exBs[i].buf);
                 EXPECT_EQ(ret, 0);
                 if (ret != 0) {
                     return ret;
@@ -1040,13 +1207,13 @@ static int check_and_init_test(MediaCodecTestContext *ctx) {
 
 static int check_and_release_test(MediaCodecTestContext *ctx) {
     int32_t ret = 0;
-    int md5Match, wholeFileSize = 0;
-    uint8_t *md5Buffer = NULL;
+    mc_digest_result_t digestResult;
     EXPECT_NE(ctx, nullptr);
     EXPECT_NE(ctx->context, nullptr);
-    EXPECT_NE(ctx->inFile, nullptr);
+    EXPECT_TRUE(ctx->inFile != NULL || ctx->synth != NULL);
     EXPECT_NE(ctx->outFile, nullptr);
-    if (ctx == NULL || ctx->context == NULL || ctx->inFile == NULL ||
+    if (ctx == NULL || ctx->context == NULL ||
+        (ctx->inFile == NULL && ctx->synth == NULL) ||
         ctx->outFile == NULL) {
         return -1;
     }
@@ -1062,46 +1229,40 @@ static int check_and_release_test(MediaCodecTestContext *ctx) {
         if (ctx->context->video_enc_params.external_frame_buf) {
             if (ctx->exFb) {
                 for (Uint32 i=0; i<ctx->context->video_enc_params.frame_buf_count; i++) {
-                    ret = release_ion_mem(ctx->ionFd, &ctx->exFb[i].buf);
-                    EXPECT_EQ(ret, 0);
+                    if (ctx->exPool && ctx->exPool[i].virt_addr != NULL) {
+                        ret = hb_mm_bufpool_put(&ctx->exPool[i]);
+                        EXPECT_EQ(ret, 0);
+                    }
                 }
                 free(ctx->exFb);
+                free(ctx->exPool);
             }
         }
     } else {
         if (ctx->context->video_dec_params.external_bitstream_buf) {
             if (ctx->exBs) {
                 for (Uint32 i=0; i<ctx->context->video_dec_params.bitstream_buf_count; i++) {
-                    ret = release_ion_mem(ctx->ionFd, &ctx->exBs[i].buf);
-                    EXPECT_EQ(ret, 0);
+                    if (ctx->exPool && ctx->exPool[i].virt_addr != NULL) {
+                        ret = hb_mm_bufpool_put(&ctx->exPool[i]);
+                        EXPECT_EQ(ret, 0);
+                    }
                 }
                 free(ctx->exBs);
+                free(ctx->exPool);
             }
         }
     }
 
-    if (ctx->ionFd)
-        hb_mem_module_close();
-
-    if (ctx->md5Test && ctx->inMd5File) {
-        fseek(ctx->outFile, 0, SEEK_END);
-        wholeFileSize = ftell(ctx->outFile);
-        fseek(ctx->outFile, 0, SEEK_SET);
-        md5Buffer = (uint8_t *)malloc(wholeFileSize);
-        EXPECT_NE(md5Buffer, nullptr);
-        if (md5Buffer == NULL) {
-            return -1;
-        }
-        if (fread(md5Buffer, wholeFileSize, 1, ctx->outFile) <= 0) {
-            printf("%s no output data read.\n", TAG);
-        }
-        md5Match = compare_md5_value(MD5_SIZE, ctx->inMd5File,
-            md5Buffer, wholeFileSize);
-        free(md5Buffer);
-
-        fclose(ctx->inMd5File);
-        EXPECT_EQ(md5Match, 1);
-        if (md5Match != 1) {
+    if (ctx->md5Test && ctx->digest) {
+        EXPECT_EQ(hb_mm_digest_get_result(ctx->digest, &digestResult), 0);
+        EXPECT_EQ(hb_mm_digest_destroy(ctx->digest), 0);
+        ctx->digest = NULL;
+        printf("%s[%d:%d] %u frames, %u golden, %u mismatched from frame %d\n",
+            TAG, getpid(), gettid(), digestResult.frames,
+            digestResult.golden_frames, digestResult.mismatched,
+            digestResult.first_mismatch);
+        EXPECT_EQ(digestResult.mismatched, 0U);
+        if (digestResult.mismatched != 0) {
             return -1;
         }
     }
@@ -1124,10 +1285,11 @@ static int read_input_frames(MediaCodecTestContext *ctx,
     size_t bufSize = 0;
     EXPECT_NE(ctx, nullptr);
     EXPECT_NE(ctx->context, nullptr);
-    EXPECT_NE(ctx->inFile, nullptr);
+    EXPECT_TRUE(ctx->inFile != NULL || ctx->synth != NULL);
     EXPECT_NE(ctx->outFile, nullptr);
     EXPECT_NE(inputBuffer, nullptr);
-    if (ctx == NULL || ctx->context == NULL || ctx->inFile == NULL ||
+    if (ctx == NULL || ctx->context == NULL ||
+        (ctx->inFile == NULL && ctx->synth == NULL) ||
         ctx->outFile == NULL || inputBuffer == NULL) {
         printf("%s[%d:%d] Invalid parameters(%s).\n",
             TAG, getpid(), gettid(), __FUNCTION__);
@@ -1192,23 +1354,35 @@ static int read_input_frames(MediaCodecTestContext *ctx,
         return ret;
     }
 
-    do {
-        ret = fread(bufPtr, 1, bufSize, ctx->inFile);
-        if (ret <= 0 && doRewind == FALSE) {
-            printf("%s[%d:%d] Failed to read input file (size=%d)\n",
-                TAG, getpid(), gettid(), bufSize);
-        }
+    if (ctx->synth) {
+        ret = hb_mm_synth_fill(ctx->synth, ctx->synthFrame++,
+            &inputBuffer->vframe_buf);
+        EXPECT_EQ(ret, 0);
+        ret = (ret == 0) ? (Int32)bufSize : 0;
+    } else {
+        do {
+            ret = fread(bufPtr, 1, bufSize, ctx->inFile);
+            if (ret <= 0 && doRewind == FALSE) {
+                printf("%s[%d:%d] Failed to read input file (size=%d)\n",
+                    TAG, getpid(), gettid(), bufSize);
+            }
 
-        if (ret <= 0 && doRewind == TRUE) {
-            if(fseek(ctx->inFile, 0, SEEK_SET)) {
-                printf("%s Failed to rewind input file (pid=%d, tid=%d)\n",
-                    TAG, getpid(), gettid());
-                break;
+            if (ret <= 0 && doRewind == TRUE) {
+                if(fseek(ctx->inFile, 0, SEEK_SET)) {
+                    printf("%s Failed to rewind input file (pid=%d, tid=%d)\n",
+                        TAG, getpid(), gettid());
+                    break;
+                }
             }
-        }
-    } while (ret == 0 && doRewind == TRUE);
+        } while (ret == 0 && doRewind == TRUE);
+    }
 
-    if (ctx->qpmap_enable) {
+    if (ctx->qpmapGenerator) {
+        if (hb_mm_qpmap_apply(ctx->qpmapGenerator, inputBuffer) != 0) {
+            printf("%s[%d:%d] Failed to generate qp map\n",
+                TAG, getpid(), gettid());
+        }
+    } else if (ctx->qpmap_enable) {
         inputBuffer->vframe_buf.qp_map_valid = 1;
         inputBuffer->vframe_buf.qp_map_array = ctx->qpmap_array;
         inputBuffer->vframe_buf.qp_map_array_count = ctx->qpmap_count;
@@ -1227,19 +1401,40 @@ static int write_output_streams(MediaCodecTestContext *ctx,
     int32_t ret = 0;
     EXPECT_NE(ctx, nullptr);
     EXPECT_NE(ctx->context, nullptr);
-    EXPECT_NE(ctx->inFile, nullptr);
+    EXPECT_TRUE(ctx->inFile != NULL || ctx->synth != NULL);
     EXPECT_NE(ctx->outFile, nullptr);
     EXPECT_NE(outputBuffer, nullptr);
-    if (ctx == NULL || ctx->context == NULL || ctx->inFile == NULL ||
+    if (ctx == NULL || ctx->context == NULL ||
+        (ctx->inFile == NULL && ctx->synth == NULL) ||
         ctx->outFile == NULL || outputBuffer == NULL) {
         printf("%s[%d:%d] Invalid parameters(%s).\n",
             TAG, getpid(), gettid(), __FUNCTION__);
         return -1;
     }
+    if (ctx->tlayerDropper && !outputBuffer->vstream_buf.stream_end) {
+        hb_bool drop = FALSE;
+        EXPECT_EQ(hb_mm_tlayer_dropper_check(ctx->tlayerDropper,
+            outputBuffer->vstream_buf.vir_ptr, outputBuffer->vstream_buf.size,
+            ctx->sinkBacklogMilli / 1000, &drop), 0);
+        if (!drop) {
+            ctx->sinkBacklogMilli += 1000;
+        }
+        ctx->sinkBacklogMilli = (ctx->sinkBacklogMilli > ctx->sinkPermille) ?
+            (ctx->sinkBacklogMilli - ctx->sinkPermille) : 0;
+        if (drop) {
+            return ret;
+        }
+    }
     if (!ctx->stabilityTest && !ctx->pfTest) {
         fwrite(outputBuffer->vstream_buf.vir_ptr, outputBuffer->vstream_buf.size,
             1, ctx->outFile);
     }
+    if (ctx->digest && !outputBuffer->vstream_buf.stream_end) {
+        EXPECT_EQ(hb_mm_digest_update(ctx->digest,
+            outputBuffer->vstream_buf.vir_ptr,
+            outputBuffer->vstream_buf.size), 0);
+        hb_mm_digest_end_frame(ctx->digest, NULL);
+    }
 
     return ret;
 }
@@ -1250,7 +1445,8 @@ static int do_encode_params_setting(MediaCodecTestContext *ctx,
     int32_t ret = 0;
     EXPECT_NE(ctx, nullptr);
     EXPECT_NE(ctx->context, nullptr);
-    if (ctx == NULL || ctx->context == NULL || ctx->inFile == NULL ||
+    if (ctx == NULL || ctx->context == NULL ||
+        (ctx->inFile == NULL && ctx->synth == NULL) ||
         ctx->outFile == NULL || inputBuffer == NULL) {
         printf("%s[%d:%d] Invalid parameters(%s).\n",
             TAG, getpid(), gettid(), __FUNCTION__);
@@ -1273,6 +1469,14 @@ static int do_encode_params_setting(MediaCodecTestContext *ctx,
             return ret;
         }
     }
+    if (ctx->sceneCutDetector) {
+        ret = hb_mm_scenecut_apply(ctx->sceneCutDetector, context,
+            inputBuffer);
+        EXPECT_EQ(ret, (int32_t)0);
+        if (ret) {
+            return ret;
+        }
+    }
     if (ctx->input_num == ctx->skip_pic_num) {
         ret = hb_mm_mc_skip_pic(context, inputBuffer->vframe_buf.src_idx);
         EXPECT_EQ(ret, (int32_t)0);
@@ -1280,6 +1484,13 @@ static int do_encode_params_setting(MediaCodecTestContext *ctx,
             return ret;
         }
     }
+    if (ctx->skipDetector) {
+        ret = hb_mm_skip_apply(ctx->skipDetector, context, inputBuffer);
+        EXPECT_EQ(ret, (int32_t)0);
+        if (ret) {
+            return ret;
+        }
+    }
     if (ctx->input_num == ctx->enable_idr_num) {
         ret = hb_mm_mc_enable_idr_frame(context, 1);
         EXPECT_EQ(ret, (int32_t)0);
@@ -1323,6 +1534,14 @@ static void do_sync_encoding(void *arg) {
     ctx->workMode = THREAD_WORK_MODE_SYNC;
     ASSERT_EQ(check_and_init_test(ctx), 0);
     context = ctx->context;
+    if (ctx->ratectlParams) {
+        ASSERT_EQ(hb_mm_ratectl_create(context, ctx->ratectlParams,
+            &ctx->ratectl), 0);
+    }
+    if (ctx->telemetryFileName) {
+        ASSERT_EQ(hb_mm_telemetry_create(ctx->telemetryFileName, 1 << 20,
+            &ctx->telemetry), 0);
+    }
 
     //get start time
     ctx->testStartTime = osal_gettime();
@@ -1331,8 +1550,15 @@ static void do_sync_encoding(void *arg) {
         printf("%s[%d:%d] Step %d initialize (outFile=%s, FileFd=%p)\n",
             TAG, getpid(), gettid(), step++, ctx->outputFileName, ctx->outFile);
     }
-    ret = hb_mm_mc_initialize(context);
-    ASSERT_EQ(ret, (int32_t)0);
+    ctx->setupStartUs = get_system_time_us();
+    if (ctx->sessionMgr) {
+        ret = hb_mm_session_acquire(ctx->sessionMgr, ctx->context, &context);
+        ASSERT_EQ(ret, (int32_t)0);
+        ctx->context = context;
+    } else {
+        ret = hb_mm_mc_initialize(context);
+        ASSERT_EQ(ret, (int32_t)0);
+    }
     set_message(ctx);
 
     media_codec_callback_t callback;
@@ -1345,8 +1571,10 @@ static void do_sync_encoding(void *arg) {
     if (ctx->testLog) {
         printf("%s[%d:%d] Step %d configure\n", TAG, getpid(), gettid(), step++);
     }
-    ret = hb_mm_mc_configure(context);
-    ASSERT_EQ(ret, (int32_t)0);
+    if (!ctx->sessionMgr) {
+        ret = hb_mm_mc_configure(context);
+        ASSERT_EQ(ret, (int32_t)0);
+    }
 
     if (ctx->testLog) {
         printf("%s[%d:%d] Step %d start\n", TAG, getpid(), gettid(), step++);
@@ -1355,18 +1583,25 @@ static void do_sync_encoding(void *arg) {
     startup_params.video_enc_startup_params.receive_frame_number = 0;
     ret = hb_mm_mc_start(context, &startup_params);
     ASSERT_EQ(ret, (int32_t)0);
+    if (ctx->ltrParams) {
+        ASSERT_EQ(hb_mm_ltr_create(context, ctx->ltrParams, &ctx->ltr), 0);
+    }
+    if (ctx->lowlatParams) {
+        ASSERT_EQ(hb_mm_lowlat_create(context, ctx->lowlatParams,
+            &ctx->lowlat), 0);
+    }
 
     do {
         if (!ctx->lastFrame) {
             if (ctx->testLog) {
-                printf("%s[%d:%d] Step %d dequeue input\n", TAG, getpid(), gettid(), step++);
+                HB_MM_LOG(MC_LOG_LEVEL_INFO, "%s[%d:%d] Step %d dequeue input\n", TAG, getpid(), gettid(), step++);
             }
             // process input buffers
             memset(&inputBuffer, 0x00, sizeof(media_codec_buffer_t));
             ret = hb_mm_mc_dequeue_input_buffer(context, &inputBuffer, 3000);
             //EXPECT_EQ(ret, (int32_t)0);
             if (ctx->testLog) {
-                printf("%s[%d:%d] input buffer viraddr %p phy addr %p, size = %d\n",
+                HB_MM_LOG(MC_LOG_LEVEL_INFO, "%s[%d:%d] input buffer viraddr %p phy addr %p, size = %d\n",
                     TAG, getpid(), gettid(), inputBuffer.vframe_buf.vir_ptr[0],
                     inputBuffer.vframe_buf.phy_ptr[0],
                     inputBuffer.vframe_buf.size);
@@ -1374,7 +1609,7 @@ static void do_sync_encoding(void *arg) {
 
             if (!ret) {
                 if (ctx->testLog) {
-                    printf("%s[%d:%d] Step %d feed input\n", TAG, getpid(), gettid(), step++);
+                    HB_MM_LOG(MC_LOG_LEVEL_INFO, "%s[%d:%d] Step %d feed input\n", TAG, getpid(), gettid(), step++);
                 }
                 ret = read_input_frames(ctx, &inputBuffer);
                 if (ret <= 0) {
@@ -1387,11 +1622,26 @@ static void do_sync_encoding(void *arg) {
 
                 ctx->input_num++;
                 ASSERT_EQ(do_encode_params_setting(ctx, &inputBuffer), 0);
+                if (ctx->seiInjector && !inputBuffer.vframe_buf.frame_end) {
+                    mc_sei_meta_t seiMeta;
+                    memset(&seiMeta, 0x00, sizeof(seiMeta));
+                    seiMeta.flags = MC_SEI_META_TIME;
+                    seiMeta.capture_time_us = get_system_time_us();
+                    ret = hb_mm_sei_attach(ctx->seiInjector, &inputBuffer,
+                        &seiMeta);
+                    EXPECT_TRUE(ret == 0 ||
+                        ret == (int32_t)HB_MEDIA_ERR_INSUFFICIENT_RES);
+                }
 
                 if (ctx->testLog) {
-                    printf("%s[%d:%d] Step %d queue input (size=%d)\n",
+                    HB_MM_LOG(MC_LOG_LEVEL_INFO, "%s[%d:%d] Step %d queue input (size=%d)\n",
                         TAG, getpid(), gettid(), step++, inputBuffer.vframe_buf.size);
                 }
+                if (ctx->telemetry && (inputBuffer.vframe_buf.src_idx >= 0) &&
+                    (inputBuffer.vframe_buf.src_idx < 32)) {
+                    ctx->telemetryQueueUs[inputBuffer.vframe_buf.src_idx] =
+                        get_system_time_us();
+                }
                 ret = hb_mm_mc_queue_input_buffer(context, &inputBuffer, 100);
                 EXPECT_EQ(ret, (int32_t)0);
                 if (ret != 0) {
@@ -1415,7 +1665,7 @@ static void do_sync_encoding(void *arg) {
 
         if (!ctx->lastStream) {
             if (ctx->testLog) {
-                printf("%s[%d:%d] Step %d dequeue output\n", TAG, getpid(), gettid(), step++);
+                HB_MM_LOG(MC_LOG_LEVEL_INFO, "%s[%d:%d] Step %d dequeue output\n", TAG, getpid(), gettid(), step++);
             }
             // process output buffers
             memset(&outputBuffer, 0x00, sizeof(media_codec_buffer_t));
@@ -1423,14 +1673,14 @@ static void do_sync_encoding(void *arg) {
             ret = hb_mm_mc_dequeue_output_buffer(context, &outputBuffer, &info, 3000);
             //EXPECT_EQ(ret, (int32_t)0);
             if (ctx->testLog) {
-                printf("%s[%d:%d] output bufferviraddr %p phy addr %x, size = %d, outFile = %p\n",
+                HB_MM_LOG(MC_LOG_LEVEL_INFO, "%s[%d:%d] output bufferviraddr %p phy addr %x, size = %d, outFile = %p\n",
                     TAG, getpid(), gettid(), outputBuffer.vstream_buf.vir_ptr,
                     outputBuffer.vstream_buf.phy_ptr, outputBuffer.vstream_buf.size,
                     ctx->outFile);
             }
             if (!ret) {
                 if (ctx->testLog) {
-                    printf("%s[%d:%d] Step %d write output file\n",
+                    HB_MM_LOG(MC_LOG_LEVEL_INFO, "%s[%d:%d] Step %d write output file\n",
                         TAG, getpid(), gettid(), step++);
                 }
                 if (ctx->delaytest) {
@@ -1442,6 +1692,43 @@ static void do_sync_encoding(void *arg) {
                     }
                 }
                 ASSERT_EQ(write_output_streams(ctx, &outputBuffer), 0);
+                if (ctx->sliceStream && !outputBuffer.vstream_buf.stream_end) {
+                    EXPECT_EQ(hb_mm_slicestream_write(ctx->sliceStream,
+                        &outputBuffer, &info, NULL), 0);
+                }
+                if (ctx->seiInjector && !outputBuffer.vstream_buf.stream_end) {
+                    EXPECT_EQ(hb_mm_sei_frame_done(ctx->seiInjector,
+                        &outputBuffer), 0);
+                }
+                if (ctx->ratectl && !outputBuffer.vstream_buf.stream_end) {
+                    EXPECT_EQ(hb_mm_ratectl_update(ctx->ratectl, &info), 0);
+                }
+                if (ctx->ltr && !outputBuffer.vstream_buf.stream_end) {
+                    EXPECT_EQ(hb_mm_ltr_update(ctx->ltr, &info), 0);
+                }
+                if (ctx->lowlat && !outputBuffer.vstream_buf.stream_end) {
+                    mc_lowlat_stats_t llStats;
+                    EXPECT_EQ(hb_mm_lowlat_update(ctx->lowlat, &info), 0);
+                    EXPECT_EQ(hb_mm_lowlat_get_stats(ctx->lowlat, &llStats), 0);
+                    if (ctx->lowlatLossFrame &&
+                        (llStats.frames == ctx->lowlatLossFrame + 1)) {
+                        EXPECT_EQ(hb_mm_lowlat_report_loss(ctx->lowlat,
+                            ctx->lowlatLossFrame), 0);
+                    }
+                }
+                if (!ctx->ttffUs && !outputBuffer.vstream_buf.stream_end) {
+                    ctx->ttffUs = get_system_time_us() - ctx->setupStartUs;
+                    if (ctx->sessionMgr) {
+                        EXPECT_EQ(hb_mm_session_first_frame(ctx->sessionMgr,
+                            context), 0);
+                    }
+                }
+                if (ctx->telemetry && !outputBuffer.vstream_buf.stream_end) {
+                    hb_u32 srcIdx = info.video_stream_info.enc_src_idx;
+                    EXPECT_EQ(hb_mm_telemetry_write(ctx->telemetry, &info,
+                        (srcIdx < 32) ? ctx->telemetryQueueUs[srcIdx] : 0,
+                        get_system_time_us()), 0);
+                }
                 if (ctx->testLog) {
                     printf("%s[%d:%d] Step %d queue output\n", TAG, getpid(), gettid(), step++);
                 }
@@ -1470,7 +1757,11 @@ static void do_sync_encoding(void *arg) {
         }
     }while(TRUE);
 
-    if (!ctx->testAbnormalQuit) {
+    if (ctx->sessionMgr) {
+        // the instance goes back configured for the next stream
+        ret = hb_mm_session_release(ctx->sessionMgr, context);
+        EXPECT_EQ(ret, (int32_t)0);
+    } else if (!ctx->testAbnormalQuit) {
         ret = hb_mm_mc_stop(context);
         EXPECT_EQ(ret, (int32_t)0);
 
@@ -1487,7 +1778,7 @@ static void on_encoder_input_buffer_available(hb_ptr userdata, media_codec_buffe
     hb_s32 ret = 0;
     ASSERT_NE(asyncCtx, nullptr);
     ASSERT_NE(asyncCtx->context, nullptr);
-    ASSERT_NE(asyncCtx->inFile, nullptr);
+    ASSERT_TRUE(asyncCtx->inFile != NULL || asyncCtx->synth != NULL);
     ASSERT_NE(inputBuffer, nullptr);
 
     if (asyncCtx->targetFps <= 0) {
@@ -1642,10 +1933,10 @@ static void do_poll_encoding_select(void *arg) {
         FD_ZERO(&readFds);
         FD_SET(pollFd, &readFds);
         t1 = get_system_time_ms();
-        printf("%s[%d:%d] start select: %5f\n", TAG, getpid(), gettid(), t1);
+        HB_MM_LOG(MC_LOG_LEVEL_INFO, "%s[%d:%d] start select: %5f\n", TAG, getpid(), gettid(), t1);
         ret = select(pollFd+1, &readFds, NULL, NULL, NULL);
         t2 = get_system_time_ms();
-        printf("%s[%d:%d] select cost: %5f\n", TAG, getpid(), gettid(), t2 -t1);
+        HB_MM_LOG(MC_LOG_LEVEL_INFO, "%s[%d:%d] select cost: %5f\n", TAG, getpid(), gettid(), t2 -t1);
         if (ret < 0) {
             printf("%s[%d:%d] Failed to select fd = %d.(err %s)\n",
                 TAG, getpid(), gettid(), pollFd, strerror(errno));
@@ -1685,6 +1976,11 @@ static void do_poll_encoding_select(void *arg) {
                                 TAG, getpid(), gettid(), step++);
                         }
                         ASSERT_EQ(write_output_streams(ctx, &outputBuffer), 0);
+                        if (ctx->sliceStream &&
+                            !outputBuffer.vstream_buf.stream_end) {
+                            EXPECT_EQ(hb_mm_slicestream_write(ctx->sliceStream,
+                                &outputBuffer, &info, NULL), 0);
+                        }
                         if (ctx->testLog) {
                             printf("%s[%d:%d] Step %d queue output\n",
                                 TAG, getpid(), gettid(), step++);
@@ -2188,6 +2484,12 @@ static int write_output_frames(MediaCodecTestContext *ctx,
         fwrite(outputBuffer->vframe_buf.vir_ptr[0], outputBuffer->vframe_buf.size,
             1, ctx->outFile);
     }
+    if (ctx->digest) {
+        EXPECT_EQ(hb_mm_digest_update(ctx->digest,
+            outputBuffer->vframe_buf.vir_ptr[0],
+            outputBuffer->vframe_buf.size), 0);
+        hb_mm_digest_end_frame(ctx->digest, NULL);
+    }
 
     return ret;
 }
@@ -2206,6 +2508,19 @@ static int do_decode_params_checking(MediaCodecTestContext *ctx,
     }
     context = ctx->context;
 
+    if (ctx->seiExtractor) {
+        mc_sei_meta_t seiMeta;
+        while (!hb_mm_sei_extract(ctx->seiExtractor, &seiMeta, 0)) {
+            if (ctx->testLog) {
+                printf("%s[%d:%d] SEI picture %llu pts %llu captured at "
+                    "%llu us\n", TAG, getpid(), gettid(),
+                    (unsigned long long)seiMeta.frame_seq,
+                    (unsigned long long)seiMeta.pts,
+                    (unsigned long long)seiMeta.capture_time_us);
+            }
+        }
+    }
+
     if (ctx->enable_get_userdata) {
         mc_user_data_buffer_t userdata = {0};
         ret = hb_mm_mc_get_user_data(context, &userdata, 0);
@@ -2555,10 +2870,10 @@ static void do_poll_decoding_select(void *arg) {
         FD_ZERO(&readFds);
         FD_SET(pollFd, &readFds);
         t1 = get_system_time_ms();
-        printf("%s[%d:%d] start select: %5f\n", TAG, getpid(), gettid(), t1);
+        HB_MM_LOG(MC_LOG_LEVEL_INFO, "%s[%d:%d] start select: %5f\n", TAG, getpid(), gettid(), t1);
         ret = select(pollFd+1, &readFds, NULL, NULL, NULL);
         t2 = get_system_time_ms();
-        printf("%s[%d:%d] select cost: %5f\n", TAG, getpid(), gettid(), t2 -t1);
+        HB_MM_LOG(MC_LOG_LEVEL_INFO, "%s[%d:%d] select cost: %5f\n", TAG, getpid(), gettid(), t2 -t1);
         if (ret < 0) {
             printf("%s[%d:%d] Failed to select fd = %d.(err %s)\n", TAG, getpid(), gettid(), pollFd, strerror(errno));
             ctx->abnormal = TRUE;
@@ -2740,6 +3055,99 @@ static void do_poll_decoding(void *arg) {
     ASSERT_EQ(check_and_release_test(ctx), 0);
 }
 
+// Decode and encode in one process: the decoded frames go to the encoder
+// by address through the transcoder, nothing is written in between
+static void do_sync_transcoding(MediaCodecTestContext *decCtx,
+                media_codec_context_t *encoder, const char *outputFileName) {
+    media_codec_buffer_t inputBuffer;
+    media_codec_buffer_t outputBuffer;
+    media_codec_output_buffer_info_t info;
+    mc_av_codec_startup_params_t startup_params;
+    mc_transcode_params_t tcParams;
+    mc_transcode_stats_t stats;
+    mc_transcode_t *tc = NULL;
+    FILE *outFile = NULL;
+    int ret = 0, lastStream = 0;
+
+    decCtx->workMode = THREAD_WORK_MODE_SYNC;
+    ASSERT_EQ(check_and_init_test(decCtx), 0);
+    outFile = fopen(outputFileName, "wb");
+    ASSERT_NE(outFile, nullptr);
+    decCtx->testStartTime = osal_gettime();
+
+    memset(&startup_params, 0x00, sizeof(mc_av_codec_startup_params_t));
+    ASSERT_EQ(hb_mm_mc_initialize(decCtx->context), (int32_t)0);
+    ASSERT_EQ(hb_mm_mc_configure(decCtx->context), (int32_t)0);
+    ASSERT_EQ(hb_mm_mc_start(decCtx->context, &startup_params), (int32_t)0);
+    ASSERT_EQ(hb_mm_mc_initialize(encoder), (int32_t)0);
+    ASSERT_EQ(hb_mm_mc_configure(encoder), (int32_t)0);
+    ASSERT_EQ(hb_mm_mc_start(encoder, &startup_params), (int32_t)0);
+
+    memset(&tcParams, 0x00, sizeof(tcParams));
+    tcParams.timeout = 10;
+    ASSERT_EQ(hb_mm_transcode_create(&tcParams, decCtx->context, encoder,
+        &tc), (int32_t)0);
+
+    memset(&stats, 0x00, sizeof(stats));
+    do {
+        if (!decCtx->lastStream) {
+            memset(&inputBuffer, 0x00, sizeof(media_codec_buffer_t));
+            ret = hb_mm_mc_dequeue_input_buffer(decCtx->context,
+                &inputBuffer, 10);
+            if (!ret) {
+                ret = read_input_streams(decCtx, &inputBuffer);
+                if (ret <= 0) {
+                    inputBuffer.vstream_buf.stream_end = TRUE;
+                    inputBuffer.vstream_buf.size = 0;
+                    decCtx->lastStream = 1;
+                }
+                ret = hb_mm_mc_queue_input_buffer(decCtx->context,
+                    &inputBuffer, 100);
+                ASSERT_EQ(ret, (int32_t)0);
+            }
+        }
+
+        if (!stats.eos) {
+            ret = hb_mm_transcode_pump(tc);
+            if (ret != (int32_t)HB_MEDIA_ERR_WAIT_TIMEOUT) {
+                ASSERT_EQ(ret, (int32_t)0);
+            }
+            hb_mm_transcode_get_stats(tc, &stats);
+        }
+
+        memset(&outputBuffer, 0x00, sizeof(media_codec_buffer_t));
+        memset(&info, 0x00, sizeof(media_codec_output_buffer_info_t));
+        ret = hb_mm_mc_dequeue_output_buffer(encoder, &outputBuffer, &info, 10);
+        if (!ret) {
+            if (outputBuffer.vstream_buf.size > 0) {
+                fwrite(outputBuffer.vstream_buf.vir_ptr, 1,
+                    outputBuffer.vstream_buf.size, outFile);
+            }
+            lastStream = outputBuffer.vstream_buf.stream_end;
+            ret = hb_mm_mc_queue_output_buffer(encoder, &outputBuffer, 100);
+            EXPECT_EQ(ret, (int32_t)0);
+        }
+    } while (!lastStream);
+
+    printf("%s[%d:%d] Transcoded %llu frames, at most %u in flight, "
+        "stalls %llu(encoder) %llu(decoder)\n", TAG, getpid(), gettid(),
+        (unsigned long long)stats.frames, stats.max_inflight,
+        (unsigned long long)stats.encoder_stalls,
+        (unsigned long long)stats.decoder_stalls);
+    EXPECT_GT(stats.frames, 0U);
+    EXPECT_LE(stats.max_inflight,
+        encoder->video_enc_params.frame_buf_count);
+
+    // the encoder reached the end, the frames it held go back now
+    EXPECT_EQ(hb_mm_transcode_destroy(tc), (int32_t)0);
+    EXPECT_EQ(hb_mm_mc_stop(encoder), (int32_t)0);
+    EXPECT_EQ(hb_mm_mc_release(encoder), (int32_t)0);
+    EXPECT_EQ(hb_mm_mc_stop(decCtx->context), (int32_t)0);
+    EXPECT_EQ(hb_mm_mc_release(decCtx->context), (int32_t)0);
+    fclose(outFile);
+    ASSERT_EQ(check_and_release_test(decCtx), 0);
+}
+
 static media_codec_id_t get_codec_id(int32_t testCodec) {
     return testCodec == TEST_CODEC_ID_H265 ?
         MEDIA_CODEC_ID_H265 : MEDIA_CODEC_ID_H264;
@@ -7474,7 +7882,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_320x240_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -7543,7 +7951,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_352x288_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -7608,7 +8016,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_640x368_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -7672,7 +8080,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_640x480_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -7736,7 +8144,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_1280x720_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -7865,7 +8273,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_1920x1080_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -7994,7 +8402,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_1920x1088_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -8058,7 +8466,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_3840x2160_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -8123,7 +8531,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_3840x2160_420p_vlc_buf) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -8187,7 +8595,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_320x240_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -8256,7 +8664,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_352x288_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -8320,7 +8728,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_640x368_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -8384,7 +8792,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_640x480_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -8448,7 +8856,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_1280x720_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -8512,7 +8920,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_1920x1080_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -8576,7 +8984,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_3840x2160_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -8640,7 +9048,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_4096x2160_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -8702,7 +9110,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_NV12) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -8764,7 +9172,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_NV21) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -8826,7 +9234,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_NV12) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -8888,7 +9296,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_NV21) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -8952,7 +9360,7 @@ TEST_F(MediaCodecTest, test_encoding_case_frame_buf_max) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -9016,7 +9424,7 @@ TEST_F(MediaCodecTest, test_encoding_case_frame_buf_min) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -9080,7 +9488,7 @@ TEST_F(MediaCodecTest, test_encoding_case_bs_buf_max) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -9144,7 +9552,7 @@ TEST_F(MediaCodecTest, test_encoding_case_bs_buf_min) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -9210,7 +9618,7 @@ TEST_F(MediaCodecTest, test_encoding_case_bs_buf_full) {
     ctx.bitfullTest = 1;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -9275,7 +9683,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_external_frame) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -9287,14 +9695,13 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_external_frame) {
     }
 }
 
-TEST_F(MediaCodecTest, test_encoding_case_h265_external_frame) {
-    hb_s32 ret = 0;
+TEST_F(MediaCodecTest, test_encoding_case_h264_external_frame_pool_reuse) {
     char outputFileName[MAX_FILE_PATH];
     char inputFileName[MAX_FILE_PATH];
-    mTestCodec = TEST_CODEC_ID_H265;
+    mTestCodec = TEST_CODEC_ID_H264;
     char dedicatedInputPrefix[MAX_FILE_PATH] = "";
     char dedicatedOutputPrefix[MAX_FILE_PATH] = "";
-    char dedicatedSuffix[MAX_FILE_PATH] = "external_frame";
+    char dedicatedSuffix[MAX_FILE_PATH] = "external_frame_pool";
     char inputSuffix[MAX_FILE_PATH] = ".yuv";
     char outputSuffix[MAX_FILE_PATH] = ".";
     snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
@@ -9306,73 +9713,64 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_external_frame) {
     snprintf(outputFileName, MAX_FILE_PATH, "%s%s_%s%s%s",
         dedicatedOutputPrefix, mGlobalPixFmtName[mTestPixFmt], dedicatedSuffix,
         outputSuffix, mGlobalCodecName[mTestCodec]);
-    mc_video_codec_enc_params_t *params;
-    media_codec_context_t *context = (media_codec_context_t *)malloc(sizeof(media_codec_context_t ));
-    ASSERT_NE(context, nullptr);
-    memset(context, 0x00, sizeof(media_codec_context_t));
-    context->codec_id = get_codec_id(mTestCodec);
-    context->encoder = TRUE;
-    params = &context->video_enc_params;
-    params->width = mTestWidth;
-    params->height = mTestHeight;
-    params->pix_fmt = mTestPixFmt;
-    params->frame_buf_count = 5;
-    params->external_frame_buf = TRUE;
-    params->bitstream_buf_count = 5;
-    params->rot_degree = MC_CCW_0;
-    params->mir_direction = MC_DIRECTION_NONE;
-    params->frame_cropping_flag = FALSE;
 
-    params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
-    ret = hb_mm_mc_get_rate_control_config(context, &params->rc_params);
-    ASSERT_EQ(ret, (int32_t)0);
-    params->rc_params.h265_cbr_params.intra_period = 20;
-    params->rc_params.h265_cbr_params.intra_qp = 20;
-    params->rc_params.h265_cbr_params.bit_rate = 1000;
-    params->rc_params.h265_cbr_params.frame_rate = 30;
-    params->rc_params.h265_cbr_params.initial_rc_qp = 20;
-    params->rc_params.h265_cbr_params.vbv_buffer_size = 20;
-    params->rc_params.h265_cbr_params.ctu_level_rc_enalbe = 0;
-    params->rc_params.h265_cbr_params.min_qp_I = 8;
-    params->rc_params.h265_cbr_params.max_qp_I = 50;
-    params->rc_params.h265_cbr_params.min_qp_P = 8;
-    params->rc_params.h265_cbr_params.max_qp_P = 50;
-    params->rc_params.h265_cbr_params.min_qp_B = 8;
-    params->rc_params.h265_cbr_params.max_qp_B = 50;
-    params->rc_params.h265_cbr_params.hvs_qp_enable = 1;
-    params->rc_params.h265_cbr_params.hvs_qp_scale = 2;
-    params->rc_params.h265_cbr_params.max_delta_qp = 10;
-    params->rc_params.h265_cbr_params.qp_map_enable = 0;
-    params->gop_params.decoding_refresh_type = 2;
-    params->gop_params.gop_preset_idx = 2;
+    // the frame buffers are in the pool before the first session
+    mc_bufpool_stats_t before, after;
+    ASSERT_EQ(hb_mm_bufpool_prewarm(mTestWidth * mTestHeight * 3 / 2, 4096, 5), 0);
+    ASSERT_EQ(hb_mm_bufpool_get_stats(&before), 0);
 
-    MediaCodecTestContext ctx;
-    memset(&ctx, 0x00, sizeof(ctx));
-    ctx.context = context;
-    ctx.inputFileName = inputFileName;
-    ctx.outputFileName = outputFileName;
-    ctx.testLog = mTestLog;
-    ctx.md5Test = mTestMd5;
-    char inputMd5FileName[MAX_FILE_PATH];
-    if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
-        snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
-            dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
-            dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
-        ctx.inputMd5FileName = inputMd5FileName;
-    }
-    do_sync_encoding(&ctx);
-    if (context != NULL) {
+    // the second session reconfigures and reuses the buffers of the first
+    for (int session = 0; session < 2; session++) {
+        mc_video_codec_enc_params_t *params;
+        media_codec_context_t *context = (media_codec_context_t *)malloc(sizeof(media_codec_context_t ));
+        ASSERT_NE(context, nullptr);
+        memset(context, 0x00, sizeof(media_codec_context_t));
+        context->codec_id = get_codec_id(mTestCodec);
+        context->encoder = TRUE;
+        params = &context->video_enc_params;
+        params->width = mTestWidth;
+        params->height = mTestHeight;
+        params->pix_fmt = mTestPixFmt;
+        params->frame_buf_count = 5;
+        params->external_frame_buf = TRUE;
+        params->bitstream_buf_count = 5;
+        params->rc_params.mode = MC_AV_RC_MODE_H264CBR;
+        ASSERT_EQ(get_rc_params(context, &params->rc_params),
+            (int32_t)0);
+        params->gop_params.decoding_refresh_type = 2;
+        params->gop_params.gop_preset_idx = 2;
+        params->rot_degree = MC_CCW_0;
+        params->mir_direction = MC_DIRECTION_NONE;
+        params->frame_cropping_flag = FALSE;
+
+        MediaCodecTestContext ctx;
+        memset(&ctx, 0x00, sizeof(ctx));
+        ctx.context = context;
+        ctx.inputFileName = inputFileName;
+        ctx.outputFileName = outputFileName;
+        ctx.testLog = mTestLog;
+        do_sync_encoding(&ctx);
         free(context);
     }
+
+    ASSERT_EQ(hb_mm_bufpool_get_stats(&after), 0);
+    printf("%s pool %llu hits %llu misses, %u idle buffers, %llu peak bytes, "
+        "fragmentation %u permille\n", TAG,
+        (unsigned long long)(after.hits - before.hits),
+        (unsigned long long)(after.misses - before.misses), after.idle_num,
+        (unsigned long long)after.peak_bytes, after.fragmentation);
+    EXPECT_EQ(after.hits - before.hits, 10ULL);
+    EXPECT_EQ(after.misses, before.misses);
+    EXPECT_EQ(after.used_num, 0U);
 }
 
-TEST_F(MediaCodecTest, test_encoding_case_rot_90) {
+TEST_F(MediaCodecTest, test_encoding_case_h264_session_reuse) {
     char outputFileName[MAX_FILE_PATH];
     char inputFileName[MAX_FILE_PATH];
+    mTestCodec = TEST_CODEC_ID_H264;
     char dedicatedInputPrefix[MAX_FILE_PATH] = "";
     char dedicatedOutputPrefix[MAX_FILE_PATH] = "";
-    char dedicatedSuffix[MAX_FILE_PATH] = "rot90";
+    char dedicatedSuffix[MAX_FILE_PATH] = "session_reuse";
     char inputSuffix[MAX_FILE_PATH] = ".yuv";
     char outputSuffix[MAX_FILE_PATH] = ".";
     snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
@@ -9397,33 +9795,290 @@ TEST_F(MediaCodecTest, test_encoding_case_rot_90) {
     params->frame_buf_count = 5;
     params->external_frame_buf = FALSE;
     params->bitstream_buf_count = 5;
-    if (context->codec_id == MEDIA_CODEC_ID_H264) {
-        params->rc_params.mode = MC_AV_RC_MODE_H264CBR;
-    } else {
-        params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
-    }
+    params->rc_params.mode = MC_AV_RC_MODE_H264CBR;
     ASSERT_EQ(get_rc_params(context, &params->rc_params),
         (int32_t)0);
     params->gop_params.decoding_refresh_type = 2;
     params->gop_params.gop_preset_idx = 2;
-    params->rot_degree = MC_CCW_90;
+    params->rot_degree = MC_CCW_0;
     params->mir_direction = MC_DIRECTION_NONE;
     params->frame_cropping_flag = FALSE;
 
-    MediaCodecTestContext ctx;
-    memset(&ctx, 0x00, sizeof(ctx));
-    ctx.context = context;
-    ctx.inputFileName = inputFileName;
-    ctx.outputFileName = outputFileName;
-    ctx.testLog = mTestLog;
-    ctx.md5Test = mTestMd5;
-    char inputMd5FileName[MAX_FILE_PATH];
-    if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
-        snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
-            dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
-            dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
-        ctx.inputMd5FileName = inputMd5FileName;
+    // a plain session first, then two streams on one recycled instance
+    hb_u64 ttffUs[3];
+    mc_session_params_t sessionParams;
+    mc_session_manager_t *mgr = NULL;
+    memset(&sessionParams, 0x00, sizeof(sessionParams));
+    sessionParams.max_idle = 1;
+    ASSERT_EQ(hb_mm_session_create(&sessionParams, &mgr), 0);
+    for (int stream = 0; stream < 3; stream++) {
+        MediaCodecTestContext ctx;
+        memset(&ctx, 0x00, sizeof(ctx));
+        ctx.context = context;
+        ctx.inputFileName = inputFileName;
+        ctx.outputFileName = outputFileName;
+        ctx.testLog = mTestLog;
+        ctx.sessionMgr = (stream > 0) ? mgr : NULL;
+        do_sync_encoding(&ctx);
+        ttffUs[stream] = ctx.ttffUs;
+    }
+
+    mc_session_stats_t stats;
+    ASSERT_EQ(hb_mm_session_get_stats(mgr, &stats), 0);
+    printf("%s time to first frame %llu us plain, %llu us cold, %llu us "
+        "recycled\n", TAG, (unsigned long long)ttffUs[0],
+        (unsigned long long)ttffUs[1], (unsigned long long)ttffUs[2]);
+    EXPECT_EQ(stats.cold, 1ULL);
+    EXPECT_EQ(stats.ready, 1ULL);
+    EXPECT_LT(ttffUs[2], ttffUs[0]);
+    EXPECT_EQ(hb_mm_session_destroy(mgr), 0);
+    if (context != NULL) {
+        free(context);
+    }
+}
+
+TEST_F(MediaCodecTest, test_encoding_case_h265_startup_ttff) {
+    char configFileName[MAX_FILE_PATH];
+    char inputFileName[MAX_FILE_PATH];
+    char outputFileName[MAX_FILE_PATH];
+    mTestCodec = TEST_CODEC_ID_H265;
+    char dedicatedInputPrefix[MAX_FILE_PATH] = "";
+    char inputSuffix[MAX_FILE_PATH] = ".yuv";
+    snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mInputPrefix, G_DEFAULT_VIDEO_INPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(inputFileName, MAX_FILE_PATH, "%s%s%s",
+        dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt], inputSuffix);
+    snprintf(configFileName, MAX_FILE_PATH, "%s%s%dx%d_startup.cfg",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(outputFileName, MAX_FILE_PATH, "%s%s%dx%d_startup.%s",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight,
+        mGlobalCodecName[mTestCodec]);
+
+    // the parameters come from a snapshot, parsed while the codec starts
+    mc_config_snapshot_t snap;
+    mc_video_codec_enc_params_t *params = &snap.enc_params;
+    memset(&snap, 0x00, sizeof(snap));
+    snap.codec_id = MEDIA_CODEC_ID_H265;
+    params->width = mTestWidth;
+    params->height = mTestHeight;
+    params->pix_fmt = mTestPixFmt;
+    params->frame_buf_count = 5;
+    params->external_frame_buf = FALSE;
+    params->bitstream_buf_count = 5;
+    params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    params->rc_params.h265_cbr_params.intra_period = 30;
+    params->rc_params.h265_cbr_params.intra_qp = 30;
+    params->rc_params.h265_cbr_params.bit_rate = 5000;
+    params->rc_params.h265_cbr_params.frame_rate = 30;
+    params->rc_params.h265_cbr_params.initial_rc_qp = 20;
+    params->rc_params.h265_cbr_params.vbv_buffer_size = 3000;
+    params->rc_params.h265_cbr_params.ctu_level_rc_enalbe = 1;
+    params->rc_params.h265_cbr_params.min_qp_I = 8;
+    params->rc_params.h265_cbr_params.max_qp_I = 50;
+    params->rc_params.h265_cbr_params.min_qp_P = 8;
+    params->rc_params.h265_cbr_params.max_qp_P = 50;
+    params->rc_params.h265_cbr_params.min_qp_B = 8;
+    params->rc_params.h265_cbr_params.max_qp_B = 50;
+    params->rc_params.h265_cbr_params.max_delta_qp = 10;
+    params->gop_params.decoding_refresh_type = 2;
+    params->gop_params.gop_preset_idx = 2;
+    params->rot_degree = MC_CCW_0;
+    params->mir_direction = MC_DIRECTION_NONE;
+    params->frame_cropping_flag = FALSE;
+    ASSERT_EQ(hb_mm_config_save(configFileName, &snap,
+        MC_CONFIG_FORMAT_BINARY), 0);
+
+    mc_startup_params_t startupParams;
+    memset(&startupParams, 0x00, sizeof(startupParams));
+    startupParams.config_file = configFileName;
+    startupParams.input_file = inputFileName;
+    startupParams.prewarm_size = mTestWidth * mTestHeight * 3 / 2;
+    startupParams.prewarm_align = 4096;
+    startupParams.prewarm_num = 5;
+    startupParams.timeout = 100;
+    for (int early = 0; early < 2; early++) {
+        media_codec_context_t context;
+        mc_startup_stats_t stats;
+        media_codec_buffer_t output;
+        media_codec_output_buffer_info_t outputInfo;
+        hb_s32 fd = -1;
+        memset(&context, 0x00, sizeof(context));
+        context.codec_id = MEDIA_CODEC_ID_H265;
+        context.encoder = TRUE;
+        startupParams.early_start = early;
+        ASSERT_EQ(hb_mm_startup_run(&context, &startupParams, &fd, &output,
+            &outputInfo, &stats), (int32_t)0);
+
+        // the stream starts with the first picture: VPS, SPS, PPS and IDR
+        hb_u8 *data = output.vstream_buf.vir_ptr;
+        ASSERT_GE(output.vstream_buf.size, 5U);
+        EXPECT_EQ(data[0], 0x00);
+        EXPECT_EQ(data[1], 0x00);
+        EXPECT_EQ(data[2], 0x00);
+        EXPECT_EQ(data[3], 0x01);
+        EXPECT_EQ((data[4] >> 1) & 0x3f, 32);
+        FILE *outFile = fopen(outputFileName, "wb");
+        ASSERT_NE(outFile, nullptr);
+        EXPECT_EQ(fwrite(data, 1, output.vstream_buf.size, outFile),
+            (size_t)output.vstream_buf.size);
+        fclose(outFile);
+        EXPECT_EQ(hb_mm_mc_queue_output_buffer(&context, &output, 100),
+            (int32_t)0);
+        printf("%s %s start: prepare %llu, initialize %llu, configure %llu, "
+            "start %llu, first input %llu, first output %llu, total %llu us\n",
+            TAG, early ? "early" : "serial",
+            (unsigned long long)stats.prepare_us,
+            (unsigned long long)stats.initialize_us,
+            (unsigned long long)stats.configure_us,
+            (unsigned long long)stats.start_us,
+            (unsigned long long)stats.first_input_us,
+            (unsigned long long)stats.first_output_us,
+            (unsigned long long)stats.total_us);
+        close(fd);
+        EXPECT_EQ(hb_mm_mc_stop(&context), (int32_t)0);
+        EXPECT_EQ(hb_mm_mc_release(&context), (int32_t)0);
+        ASSERT_EQ(hb_mm_bufpool_trim(0), 0);
+    }
+    unlink(configFileName);
+}
+
+TEST_F(MediaCodecTest, test_encoding_case_h265_external_frame) {
+    hb_s32 ret = 0;
+    char outputFileName[MAX_FILE_PATH];
+    char inputFileName[MAX_FILE_PATH];
+    mTestCodec = TEST_CODEC_ID_H265;
+    char dedicatedInputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedOutputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedSuffix[MAX_FILE_PATH] = "external_frame";
+    char inputSuffix[MAX_FILE_PATH] = ".yuv";
+    char outputSuffix[MAX_FILE_PATH] = ".";
+    snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mInputPrefix, G_DEFAULT_VIDEO_INPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(inputFileName, MAX_FILE_PATH, "%s%s%s",
+        dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt], inputSuffix);
+    snprintf(dedicatedOutputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(outputFileName, MAX_FILE_PATH, "%s%s_%s%s%s",
+        dedicatedOutputPrefix, mGlobalPixFmtName[mTestPixFmt], dedicatedSuffix,
+        outputSuffix, mGlobalCodecName[mTestCodec]);
+    mc_video_codec_enc_params_t *params;
+    media_codec_context_t *context = (media_codec_context_t *)malloc(sizeof(media_codec_context_t ));
+    ASSERT_NE(context, nullptr);
+    memset(context, 0x00, sizeof(media_codec_context_t));
+    context->codec_id = get_codec_id(mTestCodec);
+    context->encoder = TRUE;
+    params = &context->video_enc_params;
+    params->width = mTestWidth;
+    params->height = mTestHeight;
+    params->pix_fmt = mTestPixFmt;
+    params->frame_buf_count = 5;
+    params->external_frame_buf = TRUE;
+    params->bitstream_buf_count = 5;
+    params->rot_degree = MC_CCW_0;
+    params->mir_direction = MC_DIRECTION_NONE;
+    params->frame_cropping_flag = FALSE;
+
+    params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    ret = hb_mm_mc_get_rate_control_config(context, &params->rc_params);
+    ASSERT_EQ(ret, (int32_t)0);
+    params->rc_params.h265_cbr_params.intra_period = 20;
+    params->rc_params.h265_cbr_params.intra_qp = 20;
+    params->rc_params.h265_cbr_params.bit_rate = 1000;
+    params->rc_params.h265_cbr_params.frame_rate = 30;
+    params->rc_params.h265_cbr_params.initial_rc_qp = 20;
+    params->rc_params.h265_cbr_params.vbv_buffer_size = 20;
+    params->rc_params.h265_cbr_params.ctu_level_rc_enalbe = 0;
+    params->rc_params.h265_cbr_params.min_qp_I = 8;
+    params->rc_params.h265_cbr_params.max_qp_I = 50;
+    params->rc_params.h265_cbr_params.min_qp_P = 8;
+    params->rc_params.h265_cbr_params.max_qp_P = 50;
+    params->rc_params.h265_cbr_params.min_qp_B = 8;
+    params->rc_params.h265_cbr_params.max_qp_B = 50;
+    params->rc_params.h265_cbr_params.hvs_qp_enable = 1;
+    params->rc_params.h265_cbr_params.hvs_qp_scale = 2;
+    params->rc_params.h265_cbr_params.max_delta_qp = 10;
+    params->rc_params.h265_cbr_params.qp_map_enable = 0;
+    params->gop_params.decoding_refresh_type = 2;
+    params->gop_params.gop_preset_idx = 2;
+
+    MediaCodecTestContext ctx;
+    memset(&ctx, 0x00, sizeof(ctx));
+    ctx.context = context;
+    ctx.inputFileName = inputFileName;
+    ctx.outputFileName = outputFileName;
+    ctx.testLog = mTestLog;
+    ctx.md5Test = mTestMd5;
+    char inputMd5FileName[MAX_FILE_PATH];
+    if (ctx.md5Test) {
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
+        snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
+            dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
+            dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
+        ctx.inputMd5FileName = inputMd5FileName;
+    }
+    do_sync_encoding(&ctx);
+    if (context != NULL) {
+        free(context);
+    }
+}
+
+TEST_F(MediaCodecTest, test_encoding_case_rot_90) {
+    char outputFileName[MAX_FILE_PATH];
+    char inputFileName[MAX_FILE_PATH];
+    char dedicatedInputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedOutputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedSuffix[MAX_FILE_PATH] = "rot90";
+    char inputSuffix[MAX_FILE_PATH] = ".yuv";
+    char outputSuffix[MAX_FILE_PATH] = ".";
+    snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mInputPrefix, G_DEFAULT_VIDEO_INPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(inputFileName, MAX_FILE_PATH, "%s%s%s",
+        dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt], inputSuffix);
+    snprintf(dedicatedOutputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(outputFileName, MAX_FILE_PATH, "%s%s_%s%s%s",
+        dedicatedOutputPrefix, mGlobalPixFmtName[mTestPixFmt], dedicatedSuffix,
+        outputSuffix, mGlobalCodecName[mTestCodec]);
+    mc_video_codec_enc_params_t *params;
+    media_codec_context_t *context = (media_codec_context_t *)malloc(sizeof(media_codec_context_t ));
+    ASSERT_NE(context, nullptr);
+    memset(context, 0x00, sizeof(media_codec_context_t));
+    context->codec_id = get_codec_id(mTestCodec);
+    context->encoder = TRUE;
+    params = &context->video_enc_params;
+    params->width = mTestWidth;
+    params->height = mTestHeight;
+    params->pix_fmt = mTestPixFmt;
+    params->frame_buf_count = 5;
+    params->external_frame_buf = FALSE;
+    params->bitstream_buf_count = 5;
+    if (context->codec_id == MEDIA_CODEC_ID_H264) {
+        params->rc_params.mode = MC_AV_RC_MODE_H264CBR;
+    } else {
+        params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    }
+    ASSERT_EQ(get_rc_params(context, &params->rc_params),
+        (int32_t)0);
+    params->gop_params.decoding_refresh_type = 2;
+    params->gop_params.gop_preset_idx = 2;
+    params->rot_degree = MC_CCW_90;
+    params->mir_direction = MC_DIRECTION_NONE;
+    params->frame_cropping_flag = FALSE;
+
+    MediaCodecTestContext ctx;
+    memset(&ctx, 0x00, sizeof(ctx));
+    ctx.context = context;
+    ctx.inputFileName = inputFileName;
+    ctx.outputFileName = outputFileName;
+    ctx.testLog = mTestLog;
+    ctx.md5Test = mTestMd5;
+    char inputMd5FileName[MAX_FILE_PATH];
+    if (ctx.md5Test) {
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
+        snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
+            dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
+            dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
+        ctx.inputMd5FileName = inputMd5FileName;
     }
     do_sync_encoding(&ctx);
     if (context != NULL) {
@@ -9483,7 +10138,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_rot_180) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -9547,7 +10202,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_rot_270) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -9611,7 +10266,7 @@ TEST_F(MediaCodecTest, test_encoding_case_mir_hor) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -9674,7 +10329,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_mir_ver) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -9738,7 +10393,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_mir_hor_ver) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -9802,7 +10457,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_rot_270_mir_ver) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -9870,7 +10525,7 @@ TEST_F(MediaCodecTest, test_encoding_case_crop) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -9950,7 +10605,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_cbr) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -10030,7 +10685,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_cbr_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -10110,7 +10765,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_avbr) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -10190,7 +10845,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_avbr_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -10257,7 +10912,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_vbr) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -10324,7 +10979,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_vbr_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -10392,7 +11047,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_fixqp) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -10460,7 +11115,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_fixqp_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -10533,7 +11188,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_qpmap) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -10608,7 +11263,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_qpmap_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -10690,7 +11345,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_cbr) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -10770,7 +11425,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_cbr_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -10850,7 +11505,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_dynamic_off) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -10934,7 +11589,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_dynamic_bitrate) {
     ctx.rc_params_dynamic.h265_cbr_params.bit_rate = 3000;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -11018,7 +11673,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_dynamic_fps) {
     ctx.rc_params_dynamic.h265_cbr_params.frame_rate = 60;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -11102,7 +11757,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_dynamic_intra_period) {
     ctx.rc_params_dynamic.h265_cbr_params.intra_period = 40;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -11186,7 +11841,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_dynamic_intra_qp) {
     ctx.rc_params_dynamic.h265_cbr_params.intra_qp = 30;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -11270,7 +11925,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_dynamic_initial_qp) {
     ctx.rc_params_dynamic.h265_cbr_params.initial_rc_qp = 20;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -11354,7 +12009,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_dynamic_vbv) {
     ctx.rc_params_dynamic.h265_cbr_params.vbv_buffer_size = 20;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -11438,7 +12093,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_dynamic_ctu) {
     ctx.rc_params_dynamic.h265_cbr_params.ctu_level_rc_enalbe = 1;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -11522,7 +12177,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_dynamic_hvs_disable) {
     ctx.rc_params_dynamic.h265_cbr_params.hvs_qp_enable = 0;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -11606,7 +12261,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_dynamic_hvs_scale) {
     ctx.rc_params_dynamic.h265_cbr_params.hvs_qp_scale = 4;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -11690,7 +12345,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_dynamic_hvs_max) {
     ctx.rc_params_dynamic.h265_cbr_params.max_delta_qp = 5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -11790,7 +12445,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_dynamic_qp_map_enable) {
     }
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -11874,7 +12529,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_with_qpmap) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -11886,6 +12541,304 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_with_qpmap) {
     }
 }
 
+TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_with_generated_qpmap) {
+    hb_s32 ret = 0;
+    char outputFileName[MAX_FILE_PATH];
+    char inputFileName[MAX_FILE_PATH];
+    mTestCodec = TEST_CODEC_ID_H265;
+    char dedicatedInputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedOutputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedSuffix[MAX_FILE_PATH] = "cbr_gen_qpmap";
+    char inputSuffix[MAX_FILE_PATH] = ".yuv";
+    char outputSuffix[MAX_FILE_PATH] = ".";
+    snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mInputPrefix, G_DEFAULT_VIDEO_INPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(inputFileName, MAX_FILE_PATH, "%s%s%s",
+        dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt], inputSuffix);
+    snprintf(dedicatedOutputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(outputFileName, MAX_FILE_PATH, "%s%s_%s%s%s",
+        dedicatedOutputPrefix, mGlobalPixFmtName[mTestPixFmt], dedicatedSuffix,
+        outputSuffix, mGlobalCodecName[mTestCodec]);
+    mc_video_codec_enc_params_t *params;
+    media_codec_context_t *context = (media_codec_context_t *)malloc(sizeof(media_codec_context_t ));
+    ASSERT_NE(context, nullptr);
+    memset(context, 0x00, sizeof(media_codec_context_t));
+    context->codec_id = get_codec_id(mTestCodec);
+    context->encoder = TRUE;
+    params = &context->video_enc_params;
+    params->width = mTestWidth;
+    params->height = mTestHeight;
+    params->pix_fmt = mTestPixFmt;
+    params->frame_buf_count = 5;
+    params->external_frame_buf = FALSE;
+    params->bitstream_buf_count = 5;
+    params->rot_degree = MC_CCW_0;
+    params->mir_direction = MC_DIRECTION_NONE;
+    params->frame_cropping_flag = FALSE;
+
+    params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    ret = hb_mm_mc_get_rate_control_config(context, &params->rc_params);
+    ASSERT_EQ(ret, (int32_t)0);
+    params->rc_params.h265_cbr_params.intra_period = 20;
+    params->rc_params.h265_cbr_params.intra_qp = 20;
+    params->rc_params.h265_cbr_params.bit_rate = 1000;
+    params->rc_params.h265_cbr_params.frame_rate = 30;
+    params->rc_params.h265_cbr_params.initial_rc_qp = 20;
+    params->rc_params.h265_cbr_params.vbv_buffer_size = 20;
+    params->rc_params.h265_cbr_params.ctu_level_rc_enalbe = 0;
+    params->rc_params.h265_cbr_params.min_qp_I = 8;
+    params->rc_params.h265_cbr_params.max_qp_I = 50;
+    params->rc_params.h265_cbr_params.min_qp_P = 8;
+    params->rc_params.h265_cbr_params.max_qp_P = 50;
+    params->rc_params.h265_cbr_params.min_qp_B = 8;
+    params->rc_params.h265_cbr_params.max_qp_B = 50;
+    params->rc_params.h265_cbr_params.hvs_qp_enable = 0;
+    params->rc_params.h265_cbr_params.hvs_qp_scale = 2;
+    params->rc_params.h265_cbr_params.max_delta_qp = 10;
+    params->rc_params.h265_cbr_params.qp_map_enable = 1;
+    params->gop_params.decoding_refresh_type = 2;
+    params->gop_params.gop_preset_idx = 2;
+
+    // static background up by 4, moving blocks down by 3 around qp 30
+    mc_qpmap_params_t qpmapParams;
+    memset(&qpmapParams, 0x00, sizeof(qpmapParams));
+    qpmapParams.width = mTestWidth;
+    qpmapParams.height = mTestHeight;
+    qpmapParams.align = 64;
+#ifdef J5
+    qpmapParams.block_size = 64;
+#else
+    qpmapParams.block_size = 32;
+#endif
+    qpmapParams.pool_num = params->frame_buf_count + 1;
+    qpmapParams.base_qp = 30;
+    qpmapParams.min_qp = 8;
+    qpmapParams.max_qp = 50;
+    qpmapParams.aq_strength = 8;
+    qpmapParams.static_threshold = 8;
+    qpmapParams.motion_threshold = 32;
+    qpmapParams.static_qp_offset = 4;
+    qpmapParams.motion_qp_offset = 3;
+
+    MediaCodecTestContext ctx;
+    memset(&ctx, 0x00, sizeof(ctx));
+    ctx.context = context;
+    ctx.inputFileName = inputFileName;
+    ctx.outputFileName = outputFileName;
+    ctx.testLog = mTestLog;
+    ASSERT_EQ(hb_mm_qpmap_create(&qpmapParams, &ctx.qpmapGenerator), 0);
+    do_sync_encoding(&ctx);
+
+    mc_qpmap_stats_t qpmapStats;
+    ASSERT_EQ(hb_mm_qpmap_get_stats(ctx.qpmapGenerator, &qpmapStats), 0);
+    printf("%s generated %llu qp maps, last %u static %u moving blocks, "
+        "avg qp %u.%02u, generation avg %llu us max %llu us\n", TAG,
+        (unsigned long long)qpmapStats.frames, qpmapStats.last_static_blocks,
+        qpmapStats.last_moving_blocks, qpmapStats.last_avg_qp / 100,
+        qpmapStats.last_avg_qp % 100, (unsigned long long)(qpmapStats.frames ?
+        qpmapStats.cost_us / qpmapStats.frames : 0),
+        (unsigned long long)qpmapStats.max_cost_us);
+    EXPECT_EQ(hb_mm_qpmap_destroy(ctx.qpmapGenerator), 0);
+    if (context != NULL) {
+        free(context);
+    }
+}
+
+TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_with_ratectl) {
+    hb_s32 ret = 0;
+    char outputFileName[MAX_FILE_PATH];
+    char inputFileName[MAX_FILE_PATH];
+    mTestCodec = TEST_CODEC_ID_H265;
+    char dedicatedInputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedOutputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedSuffix[MAX_FILE_PATH] = "cbr_ratectl";
+    char inputSuffix[MAX_FILE_PATH] = ".yuv";
+    char outputSuffix[MAX_FILE_PATH] = ".";
+    snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mInputPrefix, G_DEFAULT_VIDEO_INPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(inputFileName, MAX_FILE_PATH, "%s%s%s",
+        dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt], inputSuffix);
+    snprintf(dedicatedOutputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(outputFileName, MAX_FILE_PATH, "%s%s_%s%s%s",
+        dedicatedOutputPrefix, mGlobalPixFmtName[mTestPixFmt], dedicatedSuffix,
+        outputSuffix, mGlobalCodecName[mTestCodec]);
+    mc_video_codec_enc_params_t *params;
+    media_codec_context_t *context = (media_codec_context_t *)malloc(sizeof(media_codec_context_t ));
+    ASSERT_NE(context, nullptr);
+    memset(context, 0x00, sizeof(media_codec_context_t));
+    context->codec_id = get_codec_id(mTestCodec);
+    context->encoder = TRUE;
+    params = &context->video_enc_params;
+    params->width = mTestWidth;
+    params->height = mTestHeight;
+    params->pix_fmt = mTestPixFmt;
+    params->frame_buf_count = 5;
+    params->external_frame_buf = FALSE;
+    params->bitstream_buf_count = 5;
+    params->rot_degree = MC_CCW_0;
+    params->mir_direction = MC_DIRECTION_NONE;
+    params->frame_cropping_flag = FALSE;
+
+    params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    ret = hb_mm_mc_get_rate_control_config(context, &params->rc_params);
+    ASSERT_EQ(ret, (int32_t)0);
+    params->rc_params.h265_cbr_params.intra_period = 20;
+    params->rc_params.h265_cbr_params.intra_qp = 20;
+    params->rc_params.h265_cbr_params.bit_rate = 1000;
+    params->rc_params.h265_cbr_params.frame_rate = 30;
+    params->rc_params.h265_cbr_params.initial_rc_qp = 20;
+    params->rc_params.h265_cbr_params.vbv_buffer_size = 20;
+    params->rc_params.h265_cbr_params.ctu_level_rc_enalbe = 0;
+    params->rc_params.h265_cbr_params.min_qp_I = 8;
+    params->rc_params.h265_cbr_params.max_qp_I = 50;
+    params->rc_params.h265_cbr_params.min_qp_P = 8;
+    params->rc_params.h265_cbr_params.max_qp_P = 50;
+    params->rc_params.h265_cbr_params.min_qp_B = 8;
+    params->rc_params.h265_cbr_params.max_qp_B = 50;
+#ifdef J5
+    params->rc_params.h265_cbr_params.hvs_qp_enable = 0;
+#else
+    params->rc_params.h265_cbr_params.hvs_qp_enable = 1;
+#endif
+    params->rc_params.h265_cbr_params.hvs_qp_scale = 2;
+    params->rc_params.h265_cbr_params.max_delta_qp = 10;
+    params->gop_params.decoding_refresh_type = 2;
+    params->gop_params.gop_preset_idx = 2;
+
+    // hold 1 s windows under 1100 kbps while the encoder aims at 1000
+    mc_ratectl_params_t ratectlParams;
+    memset(&ratectlParams, 0x00, sizeof(ratectlParams));
+    ratectlParams.frame_rate = 30;
+    ratectlParams.window_ms = 1000;
+    ratectlParams.target_bit_rate = 1000;
+    ratectlParams.ceiling_bit_rate = 1100;
+    ratectlParams.min_bit_rate = 200;
+    ratectlParams.headroom_permille = 50;
+    ratectlParams.max_step_permille = 200;
+    ratectlParams.static_skip_permille = 900;
+
+    MediaCodecTestContext ctx;
+    memset(&ctx, 0x00, sizeof(ctx));
+    ctx.context = context;
+    ctx.inputFileName = inputFileName;
+    ctx.outputFileName = outputFileName;
+    ctx.testLog = mTestLog;
+    ctx.ratectlParams = &ratectlParams;
+    do_sync_encoding(&ctx);
+
+    mc_ratectl_stats_t ratectlStats;
+    ASSERT_NE(ctx.ratectl, nullptr);
+    ASSERT_EQ(hb_mm_ratectl_get_stats(ctx.ratectl, &ratectlStats), 0);
+    printf("%s %llu pictures %llu gops, bit rate %u kbps after %llu decreases "
+        "%llu increases, window max %u kbps, %llu overflows\n", TAG,
+        (unsigned long long)ratectlStats.frames,
+        (unsigned long long)ratectlStats.gops, ratectlStats.bit_rate,
+        (unsigned long long)ratectlStats.decreases,
+        (unsigned long long)ratectlStats.increases,
+        ratectlStats.max_window_bit_rate,
+        (unsigned long long)ratectlStats.overflows);
+    EXPECT_EQ(hb_mm_ratectl_destroy(ctx.ratectl), 0);
+    if (context != NULL) {
+        free(context);
+    }
+}
+
+TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_with_telemetry) {
+    hb_s32 ret = 0;
+    char outputFileName[MAX_FILE_PATH];
+    char inputFileName[MAX_FILE_PATH];
+    mTestCodec = TEST_CODEC_ID_H265;
+    char dedicatedInputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedOutputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedSuffix[MAX_FILE_PATH] = "cbr_telemetry";
+    char inputSuffix[MAX_FILE_PATH] = ".yuv";
+    char outputSuffix[MAX_FILE_PATH] = ".";
+    snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mInputPrefix, G_DEFAULT_VIDEO_INPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(inputFileName, MAX_FILE_PATH, "%s%s%s",
+        dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt], inputSuffix);
+    snprintf(dedicatedOutputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(outputFileName, MAX_FILE_PATH, "%s%s_%s%s%s",
+        dedicatedOutputPrefix, mGlobalPixFmtName[mTestPixFmt], dedicatedSuffix,
+        outputSuffix, mGlobalCodecName[mTestCodec]);
+    mc_video_codec_enc_params_t *params;
+    media_codec_context_t *context = (media_codec_context_t *)malloc(sizeof(media_codec_context_t ));
+    ASSERT_NE(context, nullptr);
+    memset(context, 0x00, sizeof(media_codec_context_t));
+    context->codec_id = get_codec_id(mTestCodec);
+    context->encoder = TRUE;
+    params = &context->video_enc_params;
+    params->width = mTestWidth;
+    params->height = mTestHeight;
+    params->pix_fmt = mTestPixFmt;
+    params->frame_buf_count = 5;
+    params->external_frame_buf = FALSE;
+    params->bitstream_buf_count = 5;
+    params->rot_degree = MC_CCW_0;
+    params->mir_direction = MC_DIRECTION_NONE;
+    params->frame_cropping_flag = FALSE;
+
+    params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    ret = hb_mm_mc_get_rate_control_config(context, &params->rc_params);
+    ASSERT_EQ(ret, (int32_t)0);
+    params->rc_params.h265_cbr_params.intra_period = 20;
+    params->rc_params.h265_cbr_params.intra_qp = 20;
+    params->rc_params.h265_cbr_params.bit_rate = 1000;
+    params->rc_params.h265_cbr_params.frame_rate = 30;
+    params->rc_params.h265_cbr_params.initial_rc_qp = 20;
+    params->rc_params.h265_cbr_params.vbv_buffer_size = 20;
+    params->rc_params.h265_cbr_params.ctu_level_rc_enalbe = 0;
+    params->rc_params.h265_cbr_params.min_qp_I = 8;
+    params->rc_params.h265_cbr_params.max_qp_I = 50;
+    params->rc_params.h265_cbr_params.min_qp_P = 8;
+    params->rc_params.h265_cbr_params.max_qp_P = 50;
+    params->rc_params.h265_cbr_params.min_qp_B = 8;
+    params->rc_params.h265_cbr_params.max_qp_B = 50;
+#ifdef J5
+    params->rc_params.h265_cbr_params.hvs_qp_enable = 0;
+#else
+    params->rc_params.h265_cbr_params.hvs_qp_enable = 1;
+#endif
+    params->rc_params.h265_cbr_params.hvs_qp_scale = 2;
+    params->rc_params.h265_cbr_params.max_delta_qp = 10;
+    params->gop_params.decoding_refresh_type = 2;
+    params->gop_params.gop_preset_idx = 2;
+
+    char telemetryFileName[MAX_FILE_PATH];
+    snprintf(telemetryFileName, MAX_FILE_PATH, "%s.tlm", outputFileName);
+
+    MediaCodecTestContext ctx;
+    memset(&ctx, 0x00, sizeof(ctx));
+    ctx.context = context;
+    ctx.inputFileName = inputFileName;
+    ctx.outputFileName = outputFileName;
+    ctx.testLog = mTestLog;
+    ctx.telemetryFileName = telemetryFileName;
+    do_sync_encoding(&ctx);
+
+    mc_telemetry_stats_t telemetryStats;
+    ASSERT_NE(ctx.telemetry, nullptr);
+    ASSERT_EQ(hb_mm_telemetry_get_stats(ctx.telemetry, &telemetryStats), 0);
+    EXPECT_EQ(telemetryStats.dropped, 0ULL);
+    EXPECT_EQ(hb_mm_telemetry_destroy(ctx.telemetry), 0);
+
+    // every encoded picture made it into the file
+    mc_telemetry_reader_t *reader = NULL;
+    hb_u64 frames = 0;
+    ASSERT_EQ(hb_mm_telemetry_open(telemetryFileName, &reader), 0);
+    EXPECT_EQ(hb_mm_telemetry_get_frames(reader, &frames), 0);
+    EXPECT_EQ(frames, telemetryStats.frames);
+    printf("%s %llu pictures in %s\n", TAG, (unsigned long long)frames,
+        telemetryFileName);
+    EXPECT_EQ(hb_mm_telemetry_close(reader), 0);
+    if (context != NULL) {
+        free(context);
+    }
+}
+
 TEST_F(MediaCodecTest, test_encoding_case_h265_avbr) {
     hb_s32 ret = 0;
     char outputFileName[MAX_FILE_PATH];
@@ -11954,7 +12907,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_avbr) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -12034,7 +12987,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_avbr_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -12120,7 +13073,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_avbr_and_tranrate) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -12205,7 +13158,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_avbr_and_tranrate_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -12293,7 +13246,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_avbr_and_tranrate_dynamic)
     ctx.max_bitrate_dynamic = 2000;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -12379,7 +13332,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_avbr_dynamic_intra_period) {
     ctx.rc_params_dynamic.h265_avbr_params.intra_period = 10;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -12463,7 +13416,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_avbr_dynamic_fps) {
     ctx.rc_params_dynamic.h265_avbr_params.frame_rate = 15;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -12547,7 +13500,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_avbr_dynamic_bitrate) {
     ctx.rc_params_dynamic.h265_avbr_params.bit_rate = 4000;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -12614,7 +13567,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_vbr) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -12681,7 +13634,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_vbr_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -12752,7 +13705,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_vbr_dynamic_intra_period) {
     ctx.rc_params_dynamic.h265_vbr_params.intra_period = 40;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -12824,7 +13777,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_vbr_dynamic_fps) {
     ctx.rc_params_dynamic.h265_vbr_params.frame_rate = 40;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -12892,7 +13845,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_fixqp) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -12960,7 +13913,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_fixqp_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -13032,7 +13985,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_fixqp_dynamic_intra_period) {
     ctx.rc_params_dynamic.h265_fixqp_params.intra_period = 40;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -13106,7 +14059,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_fixqp_dynamic_qp) {
     ctx.rc_params_dynamic.h265_fixqp_params.force_qp_P = 15;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -13185,7 +14138,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_qpmap) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -13266,7 +14219,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_qpmap_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -13342,7 +14295,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_qpmap_3) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -13436,7 +14389,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_qpmap_dynamic) {
     }
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -13520,7 +14473,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_profile) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -13602,7 +14555,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_profile_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -13682,7 +14635,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_profile) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -13765,7 +14718,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_profile_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -13848,7 +14801,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_profile_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -13931,7 +14884,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_profile_3) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -14014,7 +14967,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_profile_4) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -14094,7 +15047,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_lossless) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -14175,7 +15128,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_trans_skip) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -14256,7 +15209,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_tmvp) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -14337,7 +15290,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_wpp) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -14418,7 +15371,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_wpp_off) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -14499,7 +15452,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_gop_ref_0) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -14580,7 +15533,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_gop_ref_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -14661,7 +15614,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_gop_ref_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -14726,7 +15679,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_gop_preset_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -14791,7 +15744,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_gop_preset_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -14856,7 +15809,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_gop_preset_3) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -14921,7 +15874,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_gop_preset_4) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -14986,7 +15939,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_gop_preset_5) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -15051,7 +16004,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_gop_preset_6) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -15116,7 +16069,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_gop_preset_7) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -15181,7 +16134,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_gop_preset_8) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -15246,7 +16199,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_gop_preset_9) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -15322,7 +16275,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_gop_custom) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -15407,7 +16360,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_gop_custom) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -15484,7 +16437,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_gop_custom_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -15562,7 +16515,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_gop_custom_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -15692,16 +16645,94 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_gop_custom_3) {
     ctx.inputFileName = inputFileName;
     ctx.outputFileName = outputFileName;
     ctx.testLog = mTestLog;
-    ctx.md5Test = mTestMd5;
-    char inputMd5FileName[MAX_FILE_PATH];
-    if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
-        snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
-            dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
-            dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
-        ctx.inputMd5FileName = inputMd5FileName;
-    }
+    ctx.md5Test = mTestMd5;
+    char inputMd5FileName[MAX_FILE_PATH];
+    if (ctx.md5Test) {
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
+        snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
+            dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
+            dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
+        ctx.inputMd5FileName = inputMd5FileName;
+    }
+    do_sync_encoding(&ctx);
+    if (context != NULL) {
+        free(context);
+    }
+}
+
+TEST_F(MediaCodecTest, test_encoding_effect_case_h265_gop_tlayer_drop) {
+    char outputFileName[MAX_FILE_PATH];
+    char inputFileName[MAX_FILE_PATH];
+    mTestCodec = TEST_CODEC_ID_H265;
+    char dedicatedInputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedOutputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedSuffix[MAX_FILE_PATH] = "gopTlayerDrop";
+    char inputSuffix[MAX_FILE_PATH] = ".yuv";
+    char outputSuffix[MAX_FILE_PATH] = ".";
+    snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mInputPrefix, G_DEFAULT_VIDEO_INPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(inputFileName, MAX_FILE_PATH, "%s%s%s",
+        dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt], inputSuffix);
+    snprintf(dedicatedOutputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(outputFileName, MAX_FILE_PATH, "%s%s_%s%s%s",
+        dedicatedOutputPrefix, mGlobalPixFmtName[mTestPixFmt], dedicatedSuffix,
+        outputSuffix, mGlobalCodecName[mTestCodec]);
+    mc_video_codec_enc_params_t *params;
+    media_codec_context_t *context = (media_codec_context_t *)malloc(sizeof(media_codec_context_t ));
+    ASSERT_NE(context, nullptr);
+    memset(context, 0x00, sizeof(media_codec_context_t));
+    context->codec_id = get_codec_id(mTestCodec);
+    context->encoder = TRUE;
+    params = &context->video_enc_params;
+    params->width = mTestWidth;
+    params->height = mTestHeight;
+    params->pix_fmt = mTestPixFmt;
+    params->frame_buf_count = 5;
+    params->external_frame_buf = FALSE;
+    params->bitstream_buf_count = 5;
+    params->rot_degree = MC_CCW_0;
+    params->mir_direction = MC_DIRECTION_NONE;
+    params->frame_cropping_flag = FALSE;
+    params->h265_enc_config.wpp_enable = 1;
+
+    params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    ASSERT_EQ(get_rc_params(context, &params->rc_params),
+        (int32_t)0);
+    params->gop_params.decoding_refresh_type = 2;
+    mc_tlayer_gop_params_t gopParams;
+    gopParams.layers = 3;
+    gopParams.base_qp = 25;
+    gopParams.qp_step = 3;
+    ASSERT_EQ(hb_mm_tlayer_build_gop(&gopParams, &params->gop_params), 0);
+
+    // the sink takes 3 of 5 pictures, the top layer has to go
+    mc_tlayer_drop_params_t dropParams;
+    mc_tlayer_drop_stats_t dropStats;
+    dropParams.codec_id = context->codec_id;
+    dropParams.layers = gopParams.layers;
+    dropParams.high_watermark = 4;
+    dropParams.low_watermark = 1;
+
+    MediaCodecTestContext ctx;
+    memset(&ctx, 0x00, sizeof(ctx));
+    ctx.context = context;
+    ctx.inputFileName = inputFileName;
+    ctx.outputFileName = outputFileName;
+    ctx.testLog = mTestLog;
+    ctx.sinkPermille = 600;
+    ASSERT_EQ(hb_mm_tlayer_dropper_create(&dropParams, &ctx.tlayerDropper), 0);
     do_sync_encoding(&ctx);
+    ASSERT_EQ(hb_mm_tlayer_dropper_get_stats(ctx.tlayerDropper, &dropStats), 0);
+    printf("Dropped %llu of %llu pictures(layer 1: %llu, layer 2: %llu), "
+        "%llu bytes\n", (unsigned long long)dropStats.dropped,
+        (unsigned long long)dropStats.pictures,
+        (unsigned long long)dropStats.layer_dropped[1],
+        (unsigned long long)dropStats.layer_dropped[2],
+        (unsigned long long)dropStats.dropped_bytes);
+    EXPECT_GT(dropStats.dropped, 0U);
+    EXPECT_EQ(dropStats.layer_dropped[0], 0U);
+    hb_mm_tlayer_dropper_destroy(ctx.tlayerDropper);
     if (context != NULL) {
         free(context);
     }
@@ -15769,7 +16800,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_longterm_ref) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -15844,7 +16875,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_longterm_ref) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -15856,6 +16887,200 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_longterm_ref) {
     }
 }
 
+TEST_F(MediaCodecTest, test_encoding_effect_case_h265_longterm_ref_auto) {
+    hb_s32 ret = 0;
+    char outputFileName[MAX_FILE_PATH];
+    char inputFileName[MAX_FILE_PATH];
+    mTestCodec = TEST_CODEC_ID_H265;
+    char dedicatedInputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedOutputPrefix[MAX_FILE_PATH] = "";
+    const char *dedicatedSuffix[2] = {"longRefFixed", "longRefAuto"};
+    char inputSuffix[MAX_FILE_PATH] = ".yuv";
+    char outputSuffix[MAX_FILE_PATH] = ".";
+    snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mInputPrefix, G_DEFAULT_VIDEO_INPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(inputFileName, MAX_FILE_PATH, "%s%s%s",
+        dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt], inputSuffix);
+    snprintf(dedicatedOutputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight);
+
+    // run 0 pins the controller to the fixed setting and only measures
+    mc_ltr_params_t ltrParams[2];
+    mc_ltr_stats_t ltrStats[2];
+    memset(ltrParams, 0x00, sizeof(ltrParams));
+    ltrParams[0].static_skip_permille = 1000;
+    ltrParams[0].hold_frames = 1;
+    ltrParams[0].min_pic_period = 30;
+    ltrParams[0].max_pic_period = 30;
+    ltrParams[0].static_using_period = 20;
+    ltrParams[0].motion_using_period = 20;
+    ltrParams[1].static_skip_permille = 850;
+    ltrParams[1].max_intra_permille = 20;
+    ltrParams[1].hold_frames = 15;
+    ltrParams[1].min_pic_period = 30;
+    ltrParams[1].max_pic_period = 240;
+    ltrParams[1].static_using_period = 4;
+    ltrParams[1].motion_using_period = 20;
+    for (int run = 0; run < 2; run++) {
+        snprintf(outputFileName, MAX_FILE_PATH, "%s%s_%s%s%s",
+            dedicatedOutputPrefix, mGlobalPixFmtName[mTestPixFmt],
+            dedicatedSuffix[run], outputSuffix, mGlobalCodecName[mTestCodec]);
+        mc_video_codec_enc_params_t *params;
+        media_codec_context_t *context = (media_codec_context_t *)malloc(sizeof(media_codec_context_t ));
+        ASSERT_NE(context, nullptr);
+        memset(context, 0x00, sizeof(media_codec_context_t));
+        context->codec_id = get_codec_id(mTestCodec);
+        context->encoder = TRUE;
+        params = &context->video_enc_params;
+        params->width = mTestWidth;
+        params->height = mTestHeight;
+        params->pix_fmt = mTestPixFmt;
+        params->frame_buf_count = 5;
+        params->external_frame_buf = FALSE;
+        params->bitstream_buf_count = 5;
+        params->rot_degree = MC_CCW_0;
+        params->mir_direction = MC_DIRECTION_NONE;
+        params->frame_cropping_flag = FALSE;
+
+        params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
+        ASSERT_EQ(get_rc_params(context, &params->rc_params),
+            (int32_t)0);
+        params->gop_params.decoding_refresh_type = 2;
+        params->gop_params.gop_preset_idx = 2;
+
+        MediaCodecTestContext ctx;
+        memset(&ctx, 0x00, sizeof(ctx));
+        ctx.context = context;
+        ctx.inputFileName = inputFileName;
+        ctx.outputFileName = outputFileName;
+        mc_video_longterm_ref_mode_t *ref_mode = &ctx.ref_mode;
+        ret = hb_mm_mc_get_longterm_ref_mode(context, ref_mode);
+        ASSERT_EQ(ret, (int32_t)0);
+        ref_mode->use_longterm = 1;
+        ref_mode->longterm_pic_period = 30;
+        ref_mode->longterm_pic_using_period = 20;
+        ctx.message = ENC_CONFIG_LONGTERM_REF;
+        ctx.ltrParams = &ltrParams[run];
+        ctx.testLog = mTestLog;
+        do_sync_encoding(&ctx);
+        ASSERT_NE(ctx.ltr, nullptr);
+        ASSERT_EQ(hb_mm_ltr_get_stats(ctx.ltr, &ltrStats[run]), 0);
+        EXPECT_EQ(hb_mm_ltr_destroy(ctx.ltr), 0);
+        printf("%s %s: %llu P pictures of %llu bytes on average, %llu static, "
+            "%llu period changes, last period %u/%u\n", TAG,
+            dedicatedSuffix[run], (unsigned long long)ltrStats[run].p_frames,
+            (unsigned long long)((ltrStats[run].p_frames == 0) ? 0 :
+            ltrStats[run].p_bytes / ltrStats[run].p_frames),
+            (unsigned long long)ltrStats[run].static_frames,
+            (unsigned long long)ltrStats[run].updates,
+            ltrStats[run].pic_period, ltrStats[run].using_period);
+        free(context);
+    }
+    EXPECT_EQ(ltrStats[0].updates, 0U);
+    EXPECT_EQ(ltrStats[0].p_frames, ltrStats[1].p_frames);
+    if (ltrStats[0].p_bytes > 0) {
+        printf("%s P picture bytes %+.1f%% against the fixed setting\n", TAG,
+            100.0 * ((double)ltrStats[1].p_bytes - ltrStats[0].p_bytes) /
+            ltrStats[0].p_bytes);
+    }
+}
+
+TEST_F(MediaCodecTest, test_encoding_case_h265_low_latency) {
+    char outputFileName[MAX_FILE_PATH];
+    char inputFileName[MAX_FILE_PATH];
+    mTestCodec = TEST_CODEC_ID_H265;
+    char dedicatedInputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedOutputPrefix[MAX_FILE_PATH] = "";
+    const char *dedicatedSuffix[2] = {"cbrGop", "lowLatency"};
+    char inputSuffix[MAX_FILE_PATH] = ".yuv";
+    char outputSuffix[MAX_FILE_PATH] = ".";
+    snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mInputPrefix, G_DEFAULT_VIDEO_INPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(inputFileName, MAX_FILE_PATH, "%s%s%s",
+        dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt], inputSuffix);
+    snprintf(dedicatedOutputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight);
+
+    // run 0 is the usual CBR with an IDR every 30 pictures, only measured
+    mc_lowlat_params_t llParams;
+    mc_lowlat_stats_t llStats[2];
+    memset(&llParams, 0x00, sizeof(llParams));
+    llParams.bit_rate = 2000;
+    llParams.frame_rate = 30;
+    llParams.refresh_frames = (mTestHeight + 63) / 64;
+    llParams.budget_frames = 2;
+    llParams.max_recovery_frames = 15;
+    llParams.min_idr_interval = 30;
+    for (int run = 0; run < 2; run++) {
+        snprintf(outputFileName, MAX_FILE_PATH, "%s%s_%s%s%s",
+            dedicatedOutputPrefix, mGlobalPixFmtName[mTestPixFmt],
+            dedicatedSuffix[run], outputSuffix, mGlobalCodecName[mTestCodec]);
+        mc_video_codec_enc_params_t *params;
+        media_codec_context_t *context = (media_codec_context_t *)malloc(sizeof(media_codec_context_t ));
+        ASSERT_NE(context, nullptr);
+        memset(context, 0x00, sizeof(media_codec_context_t));
+        context->codec_id = get_codec_id(mTestCodec);
+        context->encoder = TRUE;
+        params = &context->video_enc_params;
+        params->width = mTestWidth;
+        params->height = mTestHeight;
+        params->pix_fmt = mTestPixFmt;
+        params->frame_buf_count = 5;
+        params->external_frame_buf = FALSE;
+        params->bitstream_buf_count = 5;
+        params->rot_degree = MC_CCW_0;
+        params->mir_direction = MC_DIRECTION_NONE;
+        params->frame_cropping_flag = FALSE;
+
+        MediaCodecTestContext ctx;
+        memset(&ctx, 0x00, sizeof(ctx));
+        if (run == 0) {
+            params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
+            ASSERT_EQ(get_rc_params(context, &params->rc_params),
+                (int32_t)0);
+            params->rc_params.h265_cbr_params.bit_rate = llParams.bit_rate;
+            params->rc_params.h265_cbr_params.frame_rate =
+                llParams.frame_rate;
+            params->rc_params.h265_cbr_params.intra_period = 30;
+            params->gop_params.decoding_refresh_type = 2;
+            params->gop_params.gop_preset_idx = 2;
+        } else {
+            ASSERT_EQ(hb_mm_lowlat_preset(&llParams, context,
+                &ctx.intra_refr), 0);
+            ctx.message = ENC_CONFIG_INTRA_REFRESH;
+            // in the middle of a refresh cycle
+            ctx.lowlatLossFrame = 40 + (llParams.refresh_frames / 2);
+        }
+
+        ctx.context = context;
+        ctx.inputFileName = inputFileName;
+        ctx.outputFileName = outputFileName;
+        ctx.lowlatParams = &llParams;
+        ctx.testLog = mTestLog;
+        do_sync_encoding(&ctx);
+        ASSERT_NE(ctx.lowlat, nullptr);
+        ASSERT_EQ(hb_mm_lowlat_get_stats(ctx.lowlat, &llStats[run]), 0);
+        EXPECT_EQ(hb_mm_lowlat_destroy(ctx.lowlat), 0);
+        printf("%s %s: %llu pictures, %llu bytes on average, largest %u, "
+            "deviation %u, link delay %llu/%lluus avg/max\n", TAG,
+            dedicatedSuffix[run], (unsigned long long)llStats[run].frames,
+            (unsigned long long)((llStats[run].frames == 0) ? 0 :
+            llStats[run].bytes / llStats[run].frames),
+            llStats[run].max_frame_bytes, llStats[run].frame_bytes_stddev,
+            (unsigned long long)llStats[run].avg_link_delay_us,
+            (unsigned long long)llStats[run].max_link_delay_us);
+        free(context);
+    }
+    EXPECT_EQ(llStats[0].frames, llStats[1].frames);
+    // the refresh heals the loss without an IDR, within one more cycle
+    if (llStats[1].frames > (40 + (3 * llStats[1].refresh_frames))) {
+        EXPECT_EQ(llStats[1].losses, 1U);
+        EXPECT_EQ(llStats[1].refresh_recoveries, 1U);
+        EXPECT_EQ(llStats[1].idr_recoveries, 0U);
+    }
+    EXPECT_LE(llStats[1].max_frame_bytes, llStats[0].max_frame_bytes);
+}
+
 TEST_F(MediaCodecTest, test_encoding_effect_case_longterm_ref_dynamic) {
     hb_s32 ret = 0;
     char outputFileName[MAX_FILE_PATH];
@@ -15923,7 +17148,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_longterm_ref_dynamic) {
     ctx.ref_mode_dynamic.longterm_pic_using_period = 5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -15996,7 +17221,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_intra_refresh_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -16069,7 +17294,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_intra_refresh_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -16142,7 +17367,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_intra_refresh_3) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -16216,7 +17441,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_intra_refresh_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -16290,7 +17515,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_intra_refresh_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -16364,7 +17589,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_intra_refresh_3) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -16443,7 +17668,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_intra_refresh_4) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -16517,7 +17742,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_deblk_filter) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -16591,7 +17816,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_deblk_filter_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -16665,7 +17890,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_deblk_filter_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -16741,7 +17966,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_deblk_filter) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -16817,7 +18042,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_deblk_filter_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -16893,7 +18118,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_deblk_filter_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -16987,7 +18212,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_deblk_filter_dynamic) {
     }
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -17061,7 +18286,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_sao) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -17133,7 +18358,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_entropy) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -17224,7 +18449,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_vui) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -17317,7 +18542,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_vui) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -17410,7 +18635,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_vui_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -17511,7 +18736,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_vui_dynamic) {
 
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -17584,7 +18809,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_vui_timing) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -17659,7 +18884,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_vui_timing) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -17732,7 +18957,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_slice) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -17808,7 +19033,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_slice) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -17884,7 +19109,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_slice_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -17896,6 +19121,104 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_slice_2) {
     }
 }
 
+TEST_F(MediaCodecTest, test_encoding_effect_case_h265_slice_stream) {
+    hb_s32 ret = 0;
+    char outputFileName[MAX_FILE_PATH];
+    char streamFileName[MAX_FILE_PATH];
+    char inputFileName[MAX_FILE_PATH];
+    mTestCodec = TEST_CODEC_ID_H265;
+    char dedicatedInputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedOutputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedSuffix[MAX_FILE_PATH] = "sliceStream";
+    char inputSuffix[MAX_FILE_PATH] = ".yuv";
+    char outputSuffix[MAX_FILE_PATH] = ".";
+    snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mInputPrefix, G_DEFAULT_VIDEO_INPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(inputFileName, MAX_FILE_PATH, "%s%s%s",
+        dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt], inputSuffix);
+    snprintf(dedicatedOutputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(outputFileName, MAX_FILE_PATH, "%s%s_%s%s%s",
+        dedicatedOutputPrefix, mGlobalPixFmtName[mTestPixFmt], dedicatedSuffix,
+        outputSuffix, mGlobalCodecName[mTestCodec]);
+    snprintf(streamFileName, MAX_FILE_PATH, "%s%s_%s_sink%s%s",
+        dedicatedOutputPrefix, mGlobalPixFmtName[mTestPixFmt], dedicatedSuffix,
+        outputSuffix, mGlobalCodecName[mTestCodec]);
+    mc_video_codec_enc_params_t *params;
+    media_codec_context_t *context = (media_codec_context_t *)malloc(sizeof(media_codec_context_t ));
+    ASSERT_NE(context, nullptr);
+    memset(context, 0x00, sizeof(media_codec_context_t));
+    context->codec_id = get_codec_id(mTestCodec);
+    context->encoder = TRUE;
+    params = &context->video_enc_params;
+    params->width = mTestWidth;
+    params->height = mTestHeight;
+    params->pix_fmt = mTestPixFmt;
+    params->frame_buf_count = 5;
+    params->external_frame_buf = FALSE;
+    params->bitstream_buf_count = 5;
+    params->rot_degree = MC_CCW_0;
+    params->mir_direction = MC_DIRECTION_NONE;
+    params->frame_cropping_flag = FALSE;
+    params->h265_enc_config.wpp_enable = 0;
+    params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    ASSERT_EQ(get_rc_params(context, &params->rc_params),
+        (int32_t)0);
+    params->gop_params.decoding_refresh_type = 2;
+    params->gop_params.gop_preset_idx = 2;
+
+    MediaCodecTestContext ctx;
+    memset(&ctx, 0x00, sizeof(ctx));
+    ctx.context = context;
+    ctx.inputFileName = inputFileName;
+    ctx.outputFileName = outputFileName;
+    mc_video_slice_params_t *slice = &ctx.slice;
+    ret = hb_mm_mc_get_slice_config(context, slice);
+    ASSERT_EQ(ret, (int32_t)0);
+#ifdef J5
+    // with the slice interrupt every slice is dequeued on its own
+    slice->h265_slice.h265_independent_slice_mode = 2;
+#else
+    slice->h265_slice.h265_independent_slice_mode = 1;
+#endif
+    slice->h265_slice.h265_independent_slice_arg = 20;
+    ctx.message = ENC_CONFIG_SLICE;
+    ctx.testLog = mTestLog;
+
+    // the file sink gets the same bytes as the output file
+    mc_slicestream_params_t ssParams;
+    mc_slicestream_stats_t ssStats;
+    memset(&ssParams, 0x00, sizeof(ssParams));
+    ssParams.sink = MC_SLICESTREAM_SINK_FILE;
+    ssParams.codec_id = context->codec_id;
+    ssParams.fd = open(streamFileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(ssParams.fd, 0);
+    ASSERT_EQ(hb_mm_slicestream_create(&ssParams, &ctx.sliceStream), 0);
+#ifdef J5
+    do_poll_encoding(&ctx);
+#else
+    do_sync_encoding(&ctx);
+#endif
+    ASSERT_EQ(hb_mm_slicestream_get_stats(ctx.sliceStream, &ssStats), 0);
+    EXPECT_EQ(hb_mm_slicestream_destroy(ctx.sliceStream), 0);
+    close(ssParams.fd);
+    printf("%s %llu pictures in %llu buffers, up to %u slices, "
+        "%llu incomplete\n", TAG, (unsigned long long)ssStats.frames,
+        (unsigned long long)ssStats.buffers, ssStats.max_slices,
+        (unsigned long long)ssStats.incomplete_frames);
+    EXPECT_GT(ssStats.frames, 0U);
+    EXPECT_EQ(ssStats.incomplete_frames, 0U);
+    EXPECT_EQ(ssStats.write_errors, 0U);
+    struct stat outStat, streamStat;
+    ASSERT_EQ(stat(outputFileName, &outStat), 0);
+    ASSERT_EQ(stat(streamFileName, &streamStat), 0);
+    EXPECT_EQ((hb_u64)streamStat.st_size, ssStats.bytes);
+    EXPECT_EQ(streamStat.st_size, outStat.st_size);
+    if (context != NULL) {
+        free(context);
+    }
+}
+
 #ifdef J5
 TEST_F(MediaCodecTest, test_encoding_effect_case_h265_slice_3) {
     hb_s32 ret = 0;
@@ -17961,7 +19284,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_slice_3) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -18037,7 +19360,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_slice_4) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -18120,7 +19443,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_slice_dynamic_with_int) {
     ctx.slice_dynamic.h265_slice.h265_independent_slice_arg = 80;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -18205,7 +19528,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_slice_dynamic_without_int)
     ctx.slice_dynamic.h265_slice.h265_independent_slice_arg = 80;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -18279,7 +19602,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_3dnr_off) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -18353,7 +19676,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_3dnr_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -18430,7 +19753,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_3dnr_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -18507,7 +19830,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_smart_bg_off) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -18584,7 +19907,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_smart_bg_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -18661,7 +19984,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_smart_bg_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -18739,7 +20062,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_smart_bg_off) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -18817,7 +20140,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_smart_bg_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -18889,7 +20212,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_pred_unit) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -18969,7 +20292,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_pred_unit_0) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -19045,7 +20368,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_pred_unit_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -19121,7 +20444,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_pred_unit_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -19197,7 +20520,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_pred_unit_3) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -19273,7 +20596,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_pred_unit_4) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -19353,7 +20676,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_pred_unit_dynamic_intra) {
     ctx.pred_unit_dynamic.h265_pred_unit.intra_nxn_enable = 0;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -19433,7 +20756,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_pred_unit_dynamic_constrai
     ctx.pred_unit_dynamic.h265_pred_unit.constrained_intra_pred_flag = 1;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -19513,7 +20836,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_pred_unit_dynamic_merge) {
     ctx.pred_unit_dynamic.h265_pred_unit.max_num_merge = 1;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -19641,7 +20964,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h264_transform) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -19899,7 +21222,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_transform) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -20161,7 +21484,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_transform_dynamic) {
     ctx.transform_dynamic.h265_transform.user_scaling_list_enable = 0;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -20241,7 +21564,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_roi) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -20331,7 +21654,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_cbr_with_qpmap_val) {
     }
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -20419,7 +21742,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_avbr_with_qpmap_val) {
     }
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -20507,7 +21830,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_roi) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -20604,7 +21927,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_roi_dynamic) {
     }
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -20690,7 +22013,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_roi_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -20781,7 +22104,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_roi_ex_mode_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -20870,7 +22193,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_roi_ex_mode_1_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -20963,7 +22286,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_roi_ex_mode_1_dynamic) {
     ctx.roiEx_dynamic.roi_delta_qp = 3;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -21047,7 +22370,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_roi_ex_mode_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -21134,7 +22457,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_roi_ex_mode_2_dynamic) {
     ctx.roiEx_dynamic.roi_val = 14;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -21223,7 +22546,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_roi_avg_qp) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -21316,7 +22639,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_roi_avg_qp) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -21411,7 +22734,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_roi_avg_qp_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -21504,7 +22827,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_roi_avg_qp_3) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -21600,7 +22923,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_roi_avg_qp_dynamic) {
     ctx.roi_avg_qp_dynamic = 3;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -21696,7 +23019,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_mode_decision_off) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -21792,7 +23115,7 @@ TEST_F(MediaCodecTest, test_encoding_effect_case_h265_mode_decision_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -21855,12 +23178,89 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_insert_user_data) {
     ctx.inputFileName = inputFileName;
     ctx.outputFileName = outputFileName;
     ctx.insert_userData_num = 15;
-    ctx.message = ENC_CONFIG_INSERT_USERDATA;
+    ctx.message = ENC_CONFIG_INSERT_USERDATA;
+    ctx.testLog = mTestLog;
+    ctx.md5Test = mTestMd5;
+    char inputMd5FileName[MAX_FILE_PATH];
+    if (ctx.md5Test) {
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
+        snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
+            dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
+            dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
+        ctx.inputMd5FileName = inputMd5FileName;
+    }
+    do_sync_encoding(&ctx);
+    if (context != NULL) {
+        free(context);
+    }
+}
+
+TEST_F(MediaCodecTest, test_encoding_case_h265_insert_user_data) {
+    hb_s32 ret = 0;
+    char outputFileName[MAX_FILE_PATH];
+    char inputFileName[MAX_FILE_PATH];
+    mTestCodec = TEST_CODEC_ID_H265;
+    char dedicatedInputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedOutputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedSuffix[MAX_FILE_PATH] = "userdata";
+    char inputSuffix[MAX_FILE_PATH] = ".yuv";
+    char outputSuffix[MAX_FILE_PATH] = ".";
+    snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mInputPrefix, G_DEFAULT_VIDEO_INPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(inputFileName, MAX_FILE_PATH, "%s%s%s",
+        dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt], inputSuffix);
+    snprintf(dedicatedOutputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(outputFileName, MAX_FILE_PATH, "%s%s_%s%s%s",
+        dedicatedOutputPrefix, mGlobalPixFmtName[mTestPixFmt], dedicatedSuffix,
+        outputSuffix, mGlobalCodecName[mTestCodec]);
+    mc_video_codec_enc_params_t *params;
+    media_codec_context_t *context = (media_codec_context_t *)malloc(sizeof(media_codec_context_t ));
+    ASSERT_NE(context, nullptr);
+    memset(context, 0x00, sizeof(media_codec_context_t));
+    context->codec_id = get_codec_id(mTestCodec);
+    context->encoder = TRUE;
+    params = &context->video_enc_params;
+    params->width = mTestWidth;
+    params->height = mTestHeight;
+    params->pix_fmt = mTestPixFmt;
+    params->frame_buf_count = 5;
+    params->external_frame_buf = FALSE;
+    params->bitstream_buf_count = 5;
+    params->rot_degree = MC_CCW_0;
+    params->mir_direction = MC_DIRECTION_NONE;
+    params->frame_cropping_flag = FALSE;
+    params->h265_enc_config.wpp_enable = 1;
+
+    if (context->codec_id == MEDIA_CODEC_ID_H264) {
+        params->rc_params.mode = MC_AV_RC_MODE_H264CBR;
+    } else {
+        params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    }
+    ASSERT_EQ(get_rc_params(context, &params->rc_params),
+        (int32_t)0);
+    params->gop_params.decoding_refresh_type = 2;
+    params->gop_params.gop_preset_idx = 2;
+
+    MediaCodecTestContext ctx;
+    memset(&ctx, 0x00, sizeof(ctx));
+    ctx.context = context;
+    ctx.inputFileName = inputFileName;
+    ctx.outputFileName = outputFileName;
+    mc_video_slice_params_t *slice = &ctx.slice;
+    ret = hb_mm_mc_get_slice_config(context, slice);
+    ASSERT_EQ(ret, (int32_t)0);
+    slice->h265_slice.h265_dependent_slice_mode = 0;
+    slice->h265_slice.h265_dependent_slice_arg = 0;
+    slice->h265_slice.h265_independent_slice_mode = 0;
+    slice->h265_slice.h265_independent_slice_arg = 0;
+    ctx.insert_userData_num = 15;
+    ctx.message = (ENC_CONFIG_MESSAGE)(ENC_CONFIG_SLICE | ENC_CONFIG_INSERT_USERDATA);
     ctx.testLog = mTestLog;
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -21872,14 +23272,13 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_insert_user_data) {
     }
 }
 
-TEST_F(MediaCodecTest, test_encoding_case_h265_insert_user_data) {
-    hb_s32 ret = 0;
+TEST_F(MediaCodecTest, test_encoding_case_h265_insert_user_data_2) {
     char outputFileName[MAX_FILE_PATH];
     char inputFileName[MAX_FILE_PATH];
     mTestCodec = TEST_CODEC_ID_H265;
     char dedicatedInputPrefix[MAX_FILE_PATH] = "";
     char dedicatedOutputPrefix[MAX_FILE_PATH] = "";
-    char dedicatedSuffix[MAX_FILE_PATH] = "userdata";
+    char dedicatedSuffix[MAX_FILE_PATH] = "userdata2";
     char inputSuffix[MAX_FILE_PATH] = ".yuv";
     char outputSuffix[MAX_FILE_PATH] = ".";
     snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
@@ -21924,20 +23323,12 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_insert_user_data) {
     ctx.context = context;
     ctx.inputFileName = inputFileName;
     ctx.outputFileName = outputFileName;
-    mc_video_slice_params_t *slice = &ctx.slice;
-    ret = hb_mm_mc_get_slice_config(context, slice);
-    ASSERT_EQ(ret, (int32_t)0);
-    slice->h265_slice.h265_dependent_slice_mode = 0;
-    slice->h265_slice.h265_dependent_slice_arg = 0;
-    slice->h265_slice.h265_independent_slice_mode = 0;
-    slice->h265_slice.h265_independent_slice_arg = 0;
-    ctx.insert_userData_num = 15;
-    ctx.message = (ENC_CONFIG_MESSAGE)(ENC_CONFIG_SLICE | ENC_CONFIG_INSERT_USERDATA);
+    ctx.message = ENC_CONFIG_INSERT_USERDATA;
     ctx.testLog = mTestLog;
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -21949,13 +23340,14 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_insert_user_data) {
     }
 }
 
-TEST_F(MediaCodecTest, test_encoding_case_h265_insert_user_data_2) {
+TEST_F(MediaCodecTest, test_encoding_case_h265_sei_metadata) {
     char outputFileName[MAX_FILE_PATH];
     char inputFileName[MAX_FILE_PATH];
+    char decodedFileName[MAX_FILE_PATH];
     mTestCodec = TEST_CODEC_ID_H265;
     char dedicatedInputPrefix[MAX_FILE_PATH] = "";
     char dedicatedOutputPrefix[MAX_FILE_PATH] = "";
-    char dedicatedSuffix[MAX_FILE_PATH] = "userdata2";
+    char dedicatedSuffix[MAX_FILE_PATH] = "seiMeta";
     char inputSuffix[MAX_FILE_PATH] = ".yuv";
     char outputSuffix[MAX_FILE_PATH] = ".";
     snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
@@ -21967,6 +23359,9 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_insert_user_data_2) {
     snprintf(outputFileName, MAX_FILE_PATH, "%s%s_%s%s%s",
         dedicatedOutputPrefix, mGlobalPixFmtName[mTestPixFmt], dedicatedSuffix,
         outputSuffix, mGlobalCodecName[mTestCodec]);
+    snprintf(decodedFileName, MAX_FILE_PATH, "%s%s_%s_decoded%s",
+        dedicatedOutputPrefix, mGlobalPixFmtName[mTestPixFmt], dedicatedSuffix,
+        inputSuffix);
     mc_video_codec_enc_params_t *params;
     media_codec_context_t *context = (media_codec_context_t *)malloc(sizeof(media_codec_context_t ));
     ASSERT_NE(context, nullptr);
@@ -21984,34 +23379,74 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_insert_user_data_2) {
     params->mir_direction = MC_DIRECTION_NONE;
     params->frame_cropping_flag = FALSE;
     params->h265_enc_config.wpp_enable = 1;
-
-    if (context->codec_id == MEDIA_CODEC_ID_H264) {
-        params->rc_params.mode = MC_AV_RC_MODE_H264CBR;
-    } else {
-        params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
-    }
+    params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
     ASSERT_EQ(get_rc_params(context, &params->rc_params),
         (int32_t)0);
     params->gop_params.decoding_refresh_type = 2;
     params->gop_params.gop_preset_idx = 2;
 
+    // as many payloads as frame buffers, every queued picture gets one
+    mc_sei_params_t seiParams;
+    mc_sei_stats_t injStats, extStats;
+    const hb_u8 uuid[16] = {0xdc, 0x45, 0xe9, 0xbd, 0xe6, 0xd9, 0x48, 0xb7,
+        0x96, 0x2c, 0xd8, 0x20, 0xd9, 0x23, 0xee, 0xef};
+    memset(&seiParams, 0x00, sizeof(seiParams));
+    memcpy(seiParams.uuid, uuid, sizeof(uuid));
+    seiParams.pool_size = MC_SEI_POOL_MAX;
+
     MediaCodecTestContext ctx;
     memset(&ctx, 0x00, sizeof(ctx));
     ctx.context = context;
     ctx.inputFileName = inputFileName;
     ctx.outputFileName = outputFileName;
-    ctx.message = ENC_CONFIG_INSERT_USERDATA;
     ctx.testLog = mTestLog;
-    ctx.md5Test = mTestMd5;
-    char inputMd5FileName[MAX_FILE_PATH];
-    if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
-        snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
-            dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
-            dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
-        ctx.inputMd5FileName = inputMd5FileName;
-    }
+    ASSERT_EQ(hb_mm_sei_injector_create(context, &seiParams,
+        &ctx.seiInjector), 0);
     do_sync_encoding(&ctx);
+    ASSERT_EQ(hb_mm_sei_injector_get_stats(ctx.seiInjector, &injStats), 0);
+    EXPECT_EQ(hb_mm_sei_injector_destroy(ctx.seiInjector), 0);
+    printf("%s %llu SEI payloads of up to %u bytes, %llu pictures "
+        "without\n", TAG, (unsigned long long)injStats.injected,
+        injStats.max_payload,
+        (unsigned long long)(injStats.pool_exhausted +
+        injStats.insert_failures));
+    EXPECT_GT(injStats.injected, 0U);
+    EXPECT_EQ(injStats.insert_failures, 0U);
+
+    // decode the stream and read every payload back
+    mc_video_codec_dec_params_t *decParams;
+    memset(context, 0x00, sizeof(media_codec_context_t));
+    context->codec_id = get_codec_id(mTestCodec);
+    context->encoder = FALSE;
+    decParams = &context->video_dec_params;
+    decParams->feed_mode = mTestFeedMode;
+    decParams->pix_fmt = mTestPixFmt;
+    decParams->bitstream_buf_size = mTestWidth * mTestHeight * 3 / 2;
+    decParams->bitstream_buf_count = 6;
+    decParams->frame_buf_count = 6;
+    decParams->h265_dec_config.bandwidth_Opt = TRUE;
+    decParams->h265_dec_config.reorder_enable = TRUE;
+    decParams->h265_dec_config.skip_mode = 0x0;
+    decParams->h265_dec_config.cra_as_bla = FALSE;
+    decParams->h265_dec_config.dec_temporal_id_mode = 0;
+    decParams->h265_dec_config.target_dec_temporal_id_plus1 = 0;
+
+    memset(&ctx, 0x00, sizeof(ctx));
+    ctx.context = context;
+    ctx.inputFileName = outputFileName;
+    ctx.outputFileName = decodedFileName;
+    ctx.testLog = mTestLog;
+    ASSERT_EQ(hb_mm_sei_extractor_create(context, &seiParams,
+        &ctx.seiExtractor), 0);
+    do_sync_decoding(&ctx);
+    ASSERT_EQ(hb_mm_sei_extractor_get_stats(ctx.seiExtractor, &extStats), 0);
+    EXPECT_EQ(hb_mm_sei_extractor_destroy(ctx.seiExtractor), 0);
+    printf("%s %llu SEI payloads read back, %llu foreign, %llu malformed\n",
+        TAG, (unsigned long long)extStats.extracted,
+        (unsigned long long)extStats.foreign,
+        (unsigned long long)extStats.malformed);
+    EXPECT_EQ(extStats.extracted, injStats.injected);
+    EXPECT_EQ(extStats.malformed, 0U);
     if (context != NULL) {
         free(context);
     }
@@ -22072,7 +23507,7 @@ TEST_F(MediaCodecTest, test_encoding_case_enable_idr) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -22139,7 +23574,7 @@ TEST_F(MediaCodecTest, test_encoding_case_disable_idr) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -22207,7 +23642,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_req_idr) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -22276,7 +23711,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_req_idr_header_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -22345,7 +23780,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_req_idr_header_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -22416,7 +23851,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_enable_explicit_header) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -22487,7 +23922,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_disable_explicit_header) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -22562,7 +23997,7 @@ TEST_F(MediaCodecTest,
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -22631,7 +24066,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_req_idr) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -22701,7 +24136,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_req_idr_header_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -22771,7 +24206,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_req_idr_header_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -22845,7 +24280,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_req_idr_header_3) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -22917,7 +24352,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_enable_explicit_header) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -22989,7 +24424,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_disable_explicit_header) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -23065,7 +24500,7 @@ TEST_F(MediaCodecTest,
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -23133,7 +24568,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h264_skip_pic) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -23202,7 +24637,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_skip_pic) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -23214,6 +24649,160 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_skip_pic) {
     }
 }
 
+TEST_F(MediaCodecTest, test_encoding_case_h265_static_skip) {
+    char outputFileName[MAX_FILE_PATH];
+    char inputFileName[MAX_FILE_PATH];
+    mTestCodec = TEST_CODEC_ID_H265;
+    char dedicatedInputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedOutputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedSuffix[MAX_FILE_PATH] = "staticSkip";
+    char inputSuffix[MAX_FILE_PATH] = ".yuv";
+    char outputSuffix[MAX_FILE_PATH] = ".";
+    snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mInputPrefix, G_DEFAULT_VIDEO_INPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(inputFileName, MAX_FILE_PATH, "%s%s%s",
+        dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt], inputSuffix);
+    snprintf(dedicatedOutputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(outputFileName, MAX_FILE_PATH, "%s%s_%s%s%s",
+        dedicatedOutputPrefix, mGlobalPixFmtName[mTestPixFmt], dedicatedSuffix,
+        outputSuffix, mGlobalCodecName[mTestCodec]);
+    mc_video_codec_enc_params_t *params;
+    media_codec_context_t *context = (media_codec_context_t *)malloc(sizeof(media_codec_context_t ));
+    ASSERT_NE(context, nullptr);
+    memset(context, 0x00, sizeof(media_codec_context_t));
+    context->codec_id = get_codec_id(mTestCodec);
+    context->encoder = TRUE;
+    params = &context->video_enc_params;
+    params->width = mTestWidth;
+    params->height = mTestHeight;
+    params->pix_fmt = mTestPixFmt;
+    params->frame_buf_count = 5;
+    params->external_frame_buf = FALSE;
+    params->bitstream_buf_count = 5;
+    params->rot_degree = MC_CCW_0;
+    params->mir_direction = MC_DIRECTION_NONE;
+    params->frame_cropping_flag = FALSE;
+
+    params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    ASSERT_EQ(get_rc_params(context, &params->rc_params),
+        (int32_t)0);
+    params->gop_params.decoding_refresh_type = 2;
+    params->gop_params.gop_preset_idx = 2;
+
+    // blocks averaging more than 2 levels of change count as moving
+    mc_skip_params_t skipParams;
+    memset(&skipParams, 0x00, sizeof(skipParams));
+    skipParams.width = mTestWidth;
+    skipParams.height = mTestHeight;
+    skipParams.block_sad_threshold = 16 * 16 * 2;
+    skipParams.changed_permille = 2;
+    skipParams.max_skip_frames = 30;
+
+    MediaCodecTestContext ctx;
+    memset(&ctx, 0x00, sizeof(ctx));
+    ctx.context = context;
+    ctx.inputFileName = inputFileName;
+    ctx.outputFileName = outputFileName;
+    ctx.testLog = mTestLog;
+    ASSERT_EQ(hb_mm_skip_create(&skipParams, &ctx.skipDetector), 0);
+    do_sync_encoding(&ctx);
+
+    mc_skip_stats_t skipStats;
+    ASSERT_EQ(hb_mm_skip_get_stats(ctx.skipDetector, &skipStats), 0);
+    printf("%s skipped %llu/%llu pictures, %llu forced, detection avg %llu us "
+        "max %llu us\n", TAG, (unsigned long long)skipStats.skipped,
+        (unsigned long long)skipStats.frames,
+        (unsigned long long)skipStats.forced,
+        (unsigned long long)(skipStats.frames ?
+        skipStats.cost_us / skipStats.frames : 0),
+        (unsigned long long)skipStats.max_cost_us);
+    EXPECT_EQ(hb_mm_skip_destroy(ctx.skipDetector), 0);
+    if (context != NULL) {
+        free(context);
+    }
+}
+
+TEST_F(MediaCodecTest, test_encoding_case_h265_scene_cut_idr) {
+    char outputFileName[MAX_FILE_PATH];
+    char inputFileName[MAX_FILE_PATH];
+    mTestCodec = TEST_CODEC_ID_H265;
+    char dedicatedInputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedOutputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedSuffix[MAX_FILE_PATH] = "sceneCutIdr";
+    char inputSuffix[MAX_FILE_PATH] = ".yuv";
+    char outputSuffix[MAX_FILE_PATH] = ".";
+    snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mInputPrefix, G_DEFAULT_VIDEO_INPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(inputFileName, MAX_FILE_PATH, "%s%s%s",
+        dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt], inputSuffix);
+    snprintf(dedicatedOutputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(outputFileName, MAX_FILE_PATH, "%s%s_%s%s%s",
+        dedicatedOutputPrefix, mGlobalPixFmtName[mTestPixFmt], dedicatedSuffix,
+        outputSuffix, mGlobalCodecName[mTestCodec]);
+    mc_video_codec_enc_params_t *params;
+    media_codec_context_t *context = (media_codec_context_t *)malloc(sizeof(media_codec_context_t ));
+    ASSERT_NE(context, nullptr);
+    memset(context, 0x00, sizeof(media_codec_context_t));
+    context->codec_id = get_codec_id(mTestCodec);
+    context->encoder = TRUE;
+    params = &context->video_enc_params;
+    params->width = mTestWidth;
+    params->height = mTestHeight;
+    params->pix_fmt = mTestPixFmt;
+    params->frame_buf_count = 5;
+    params->external_frame_buf = FALSE;
+    params->bitstream_buf_count = 5;
+    params->rot_degree = MC_CCW_0;
+    params->mir_direction = MC_DIRECTION_NONE;
+    params->frame_cropping_flag = FALSE;
+
+    params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    ASSERT_EQ(get_rc_params(context, &params->rc_params),
+        (int32_t)0);
+    params->gop_params.decoding_refresh_type = 2;
+    params->gop_params.gop_preset_idx = 2;
+
+    // the detector owns the IDR cadence, the encoder has none of its own
+    params->rc_params.h265_cbr_params.intra_period = 0;
+    mc_scenecut_params_t sceneCutParams;
+    memset(&sceneCutParams, 0x00, sizeof(sceneCutParams));
+    sceneCutParams.width = mTestWidth;
+    sceneCutParams.height = mTestHeight;
+    sceneCutParams.hist_threshold = 300;
+    sceneCutParams.sad_threshold = 16 * 20;
+    sceneCutParams.min_cut_interval = 5;
+    sceneCutParams.idr_interval = 30;
+
+    MediaCodecTestContext ctx;
+    memset(&ctx, 0x00, sizeof(ctx));
+    ctx.context = context;
+    ctx.inputFileName = inputFileName;
+    ctx.outputFileName = outputFileName;
+    ctx.testLog = mTestLog;
+    ASSERT_EQ(hb_mm_scenecut_create(&sceneCutParams, &ctx.sceneCutDetector),
+        0);
+    do_sync_encoding(&ctx);
+
+    mc_scenecut_stats_t sceneCutStats;
+    ASSERT_EQ(hb_mm_scenecut_get_stats(ctx.sceneCutDetector, &sceneCutStats),
+        0);
+    printf("%s %llu pictures, %llu IDRs on cuts %llu periodic %llu ignored, "
+        "detection avg %llu us max %llu us\n", TAG,
+        (unsigned long long)sceneCutStats.frames,
+        (unsigned long long)sceneCutStats.cuts,
+        (unsigned long long)sceneCutStats.periodic,
+        (unsigned long long)sceneCutStats.ignored,
+        (unsigned long long)(sceneCutStats.frames ?
+        sceneCutStats.cost_us / sceneCutStats.frames : 0),
+        (unsigned long long)sceneCutStats.max_cost_us);
+    EXPECT_EQ(hb_mm_scenecut_destroy(ctx.sceneCutDetector), 0);
+    if (context != NULL) {
+        free(context);
+    }
+}
+
 TEST_F(MediaCodecTest, test_encoding_case_poll) {
     char outputFileName[MAX_FILE_PATH];
     char inputFileName[MAX_FILE_PATH];
@@ -23267,7 +24856,7 @@ TEST_F(MediaCodecTest, test_encoding_case_poll) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -23331,7 +24920,7 @@ TEST_F(MediaCodecTest, test_encoding_case_async) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -23406,7 +24995,7 @@ TEST_F(MediaCodecTest, test_encoding_case_multi_2_instance) {
         ctx[i].testLog = mTestLog;
         ctx[i].md5Test = mTestMd5;
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -23490,7 +25079,7 @@ TEST_F(MediaCodecTest, test_encoding_case_multi_4_instance) {
         ctx[i].testLog = mTestLog;
         ctx[i].md5Test = mTestMd5;
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -23574,7 +25163,7 @@ TEST_F(MediaCodecTest, test_encoding_case_multi_h264_h265) {
         ctx[i].testLog = mTestLog;
         ctx[i].md5Test = mTestMd5;
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -23658,7 +25247,7 @@ TEST_F(MediaCodecTest, test_encoding_case_multi_2_h264_2_h265) {
         ctx[i].testLog = mTestLog;
         ctx[i].md5Test = mTestMd5;
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -23734,7 +25323,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h264_320x240_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(dedicatedSuffix, MAX_FILE_PATH, "%s", "dec");
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
@@ -23803,7 +25392,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h264_352x288_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(dedicatedSuffix, MAX_FILE_PATH, "%s", "dec");
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
@@ -23872,7 +25461,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h264_640x368_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(dedicatedSuffix, MAX_FILE_PATH, "%s", "dec");
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
@@ -23941,7 +25530,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h264_640x480_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(dedicatedSuffix, MAX_FILE_PATH, "%s", "dec");
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
@@ -24010,7 +25599,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h264_1280x720_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(dedicatedSuffix, MAX_FILE_PATH, "%s", "dec");
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
@@ -24079,7 +25668,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h264_1920x1080_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(dedicatedSuffix, MAX_FILE_PATH, "%s", "dec");
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
@@ -24148,7 +25737,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h264_3840x2160_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(dedicatedSuffix, MAX_FILE_PATH, "%s", "dec");
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
@@ -24218,7 +25807,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h264_3840x2160_420p_vlc_buf) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(dedicatedSuffix, MAX_FILE_PATH, "%s", "dec");
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
@@ -24287,7 +25876,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h265_320x240_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(dedicatedSuffix, MAX_FILE_PATH, "%s", "dec");
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
@@ -24356,7 +25945,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h265_352x288_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(dedicatedSuffix, MAX_FILE_PATH, "%s", "dec");
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
@@ -24425,7 +26014,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h265_640x368_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(dedicatedSuffix, MAX_FILE_PATH, "%s", "dec");
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
@@ -24494,7 +26083,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h265_640x480_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(dedicatedSuffix, MAX_FILE_PATH, "%s", "dec");
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
@@ -24563,7 +26152,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h265_1280x720_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(dedicatedSuffix, MAX_FILE_PATH, "%s", "dec");
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
@@ -24632,7 +26221,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h265_1920x1080_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(dedicatedSuffix, MAX_FILE_PATH, "%s", "dec");
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
@@ -24701,7 +26290,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h265_3840x2160_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(dedicatedSuffix, MAX_FILE_PATH, "%s", "dec");
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
@@ -24770,7 +26359,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h265_4096x2160_420p) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(dedicatedSuffix, MAX_FILE_PATH, "%s", "dec");
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
@@ -24836,7 +26425,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h264_feed_stream) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -24901,7 +26490,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h265_feed_stream) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -24967,7 +26556,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h265_feed_stream_abnormal) {
     ctx.feedingSize = 4096;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -25033,7 +26622,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h265_feed_external_stream) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -25097,7 +26686,7 @@ TEST_F(MediaCodecTest, test_decoding_case_nv12) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -25161,7 +26750,7 @@ TEST_F(MediaCodecTest, test_decoding_case_nv21) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -25224,7 +26813,7 @@ TEST_F(MediaCodecTest, test_decoding_case_bs_size_min) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -25287,7 +26876,7 @@ TEST_F(MediaCodecTest, test_decoding_case_bs_size_abnormal) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -25350,7 +26939,7 @@ TEST_F(MediaCodecTest, test_decoding_case_bs_size_max) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -25417,7 +27006,7 @@ TEST_F(MediaCodecTest, test_decoding_case_bs_cnt_min) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -25480,7 +27069,7 @@ TEST_F(MediaCodecTest, test_decoding_case_bs_cnt_max) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -25543,7 +27132,7 @@ TEST_F(MediaCodecTest, test_decoding_case_fb_cnt_min) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -25606,7 +27195,7 @@ TEST_F(MediaCodecTest, test_decoding_case_fb_cnt_max) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -25669,7 +27258,7 @@ TEST_F(MediaCodecTest, test_decoding_case_seq_change) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -25734,7 +27323,7 @@ TEST_F(MediaCodecTest, test_decoding_case_seq_change_1920x1080) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -25798,7 +27387,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h264_bw_opt_off) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -25862,7 +27451,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h264_reorder_off) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -25926,7 +27515,7 @@ TEST_F(MediaCodecTest, test_decoding_effect_case_h264_skip_mode_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -25990,7 +27579,7 @@ TEST_F(MediaCodecTest, test_decoding_effect_case_h264_skip_mode_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -26054,7 +27643,7 @@ TEST_F(MediaCodecTest, test_decoding_effect_case_h264_skip_mode_3) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -26118,7 +27707,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h265_bw_opt_off) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -26182,7 +27771,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h265_reorder_off) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -26246,7 +27835,7 @@ TEST_F(MediaCodecTest, test_decoding_effect_case_h265_skip_mode_1) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -26310,7 +27899,7 @@ TEST_F(MediaCodecTest, test_decoding_effect_case_h265_skip_mode_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -26378,7 +27967,7 @@ TEST_F(MediaCodecTest, test_decoding_effect_case_h265_skip_mode_3) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -26442,7 +28031,7 @@ TEST_F(MediaCodecTest, test_decoding_effect_case_h265_cra_as_bla) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -26507,7 +28096,7 @@ TEST_F(MediaCodecTest, test_decoding_case_get_userdata) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -26571,7 +28160,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h265_temp_id) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -26635,7 +28224,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h265_temp_id_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -26703,7 +28292,7 @@ TEST_F(MediaCodecTest, test_decoding_case_h265_temp_id_3) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -26715,6 +28304,75 @@ TEST_F(MediaCodecTest, test_decoding_case_h265_temp_id_3) {
     }
 }
 
+TEST_F(MediaCodecTest, test_decoding_case_h265_preview_4x) {
+    char outputFileName[MAX_FILE_PATH];
+    char inputFileName[MAX_FILE_PATH];
+    mTestCodec = TEST_CODEC_ID_H265;
+    char dedicatedInputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedOutputPrefix[MAX_FILE_PATH] = "";
+    char dedicatedSuffix[MAX_FILE_PATH] = "preview4x";
+    char inputSuffix[MAX_FILE_PATH] = "tempId.";
+    char outputSuffix[MAX_FILE_PATH] = ".yuv";
+    snprintf(dedicatedInputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mInputPrefix, G_DEFAULT_VIDEO_INPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(inputFileName, MAX_FILE_PATH, "%s%s%s",
+        dedicatedInputPrefix, inputSuffix, mGlobalCodecName[mTestCodec]);
+    snprintf(dedicatedOutputPrefix, MAX_FILE_PATH, "%s%s%dx%d_",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight);
+    snprintf(outputFileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
+        dedicatedOutputPrefix, mGlobalPixFmtName[mTestPixFmt], dedicatedSuffix,
+        mGlobalCodecName[mTestCodec], outputSuffix);
+
+    // the first MB of the stream tells the temporal layers
+    mc_preview_probe_t probe;
+    mc_preview_plan_t plan;
+    hb_u32 sampleSize = 0;
+    hb_u8 *sample = (hb_u8 *)malloc(1024 * 1024);
+    ASSERT_NE(sample, nullptr);
+    FILE *inFile = fopen(inputFileName, "rb");
+    ASSERT_NE(inFile, nullptr);
+    sampleSize = fread(sample, 1, 1024 * 1024, inFile);
+    fclose(inFile);
+    memset(&probe, 0x00, sizeof(probe));
+    ASSERT_EQ(hb_mm_preview_probe(get_codec_id(mTestCodec), sample,
+        sampleSize, &probe), 0);
+    free(sample);
+    ASSERT_EQ(hb_mm_preview_plan(get_codec_id(mTestCodec),
+        MC_PREVIEW_SPEED_4X, &probe, &plan), 0);
+    printf("Preview 4x of %u pictures in %u layers: skip_mode=%u, "
+        "target_dec_temporal_id_plus1=%u, %u per 1000 decoded\n",
+        probe.pictures, probe.max_sub_layers, plan.skip_mode,
+        plan.target_dec_temporal_id_plus1, plan.decoded_permille);
+
+    mc_video_codec_dec_params_t *params;
+    media_codec_context_t *context = (media_codec_context_t *)malloc(sizeof(media_codec_context_t ));
+    ASSERT_NE(context, nullptr);
+    memset(context, 0x00, sizeof(media_codec_context_t));
+    context->codec_id = get_codec_id(mTestCodec);
+    context->encoder = FALSE;
+    params = &context->video_dec_params;
+    params->feed_mode = mTestFeedMode;
+    params->pix_fmt = mTestPixFmt;
+    params->bitstream_buf_size = mTestWidth * mTestHeight * 3 / 2;
+    params->bitstream_buf_count = 6;
+    params->frame_buf_count = 6;
+    params->h265_dec_config.bandwidth_Opt = TRUE;
+    params->h265_dec_config.reorder_enable = TRUE;
+    params->h265_dec_config.cra_as_bla = FALSE;
+    ASSERT_EQ(hb_mm_preview_apply(&plan, context), 0);
+
+    MediaCodecTestContext ctx;
+    memset(&ctx, 0x00, sizeof(ctx));
+    ctx.context = context;
+    ctx.inputFileName = inputFileName;
+    ctx.outputFileName = outputFileName;
+    ctx.testLog = mTestLog;
+    do_sync_decoding(&ctx);
+    if (context != NULL) {
+        free(context);
+    }
+}
+
 TEST_F(MediaCodecTest, test_decoding_case_external_frame) {
     char outputFileName[MAX_FILE_PATH];
     char inputFileName[MAX_FILE_PATH];
@@ -26767,7 +28425,7 @@ TEST_F(MediaCodecTest, test_decoding_case_external_frame) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -26832,7 +28490,7 @@ TEST_F(MediaCodecTest, test_decoding_case_external_frame_2) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -26895,7 +28553,7 @@ TEST_F(MediaCodecTest, test_decoding_case_poll) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -26958,7 +28616,7 @@ TEST_F(MediaCodecTest, test_decoding_case_async) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -27032,7 +28690,7 @@ TEST_F(MediaCodecTest, test_decoding_case_multi_2_h264) {
         ctx[i].testLog = mTestLog;
         ctx[i].md5Test = mTestMd5;
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -27116,7 +28774,7 @@ TEST_F(MediaCodecTest, test_decoding_case_multi_4_h264) {
         ctx[i].testLog = mTestLog;
         ctx[i].md5Test = mTestMd5;
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -27200,7 +28858,7 @@ TEST_F(MediaCodecTest, test_decoding_case_multi_2_h265) {
         ctx[i].testLog = mTestLog;
         ctx[i].md5Test = mTestMd5;
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -27284,7 +28942,7 @@ TEST_F(MediaCodecTest, test_decoding_case_multi_2_h264_2_h265) {
         ctx[i].testLog = mTestLog;
         ctx[i].md5Test = mTestMd5;
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -27363,7 +29021,7 @@ TEST_F(MediaCodecTest, test_encoding_decoding_case_multi_2) {
     ctx.duration = mTestTime;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = "enc.md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = "enc.digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -27422,7 +29080,7 @@ TEST_F(MediaCodecTest, test_encoding_decoding_case_multi_2) {
     ctx2.duration = mTestTime;
     char inputMd5FileName2[MAX_FILE_PATH];
     if (ctx2.md5Test) {
-        char inputMd5Suffix2[MAX_FILE_PATH] = "dec.md5";
+        char inputMd5Suffix2[MAX_FILE_PATH] = "dec.digest";
         snprintf(inputMd5FileName2, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix2, mGlobalPixFmtName[mTestPixFmt],
             dedicatedSuffix2, mGlobalCodecName[mTestCodec], inputMd5Suffix2);
@@ -27508,7 +29166,7 @@ TEST_F(MediaCodecTest,
         ctx.md5Test = mTestMd5;
         char inputMd5FileName[MAX_FILE_PATH];
         if (ctx.md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -27572,7 +29230,7 @@ TEST_F(MediaCodecTest,
         ctx.md5Test = mTestMd5;
         char inputMd5FileName[MAX_FILE_PATH];
         if (ctx.md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -27651,7 +29309,7 @@ TEST_F(MediaCodecTest,
         ctx.md5Test = mTestMd5;
         char inputMd5FileName[MAX_FILE_PATH];
         if (ctx.md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -27716,7 +29374,7 @@ TEST_F(MediaCodecTest,
         ctx.md5Test = mTestMd5;
         char inputMd5FileName[MAX_FILE_PATH];
         if (ctx.md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -27794,7 +29452,7 @@ TEST_F(MediaCodecTest,
         ctx.md5Test = mTestMd5;
         char inputMd5FileName[MAX_FILE_PATH];
         if (ctx.md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -27858,7 +29516,7 @@ TEST_F(MediaCodecTest,
         ctx.md5Test = mTestMd5;
         char inputMd5FileName[MAX_FILE_PATH];
         if (ctx.md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -27937,7 +29595,7 @@ TEST_F(MediaCodecTest, test_encoding_decoding_abnormal_quitting) {
         ctx.md5Test = mTestMd5;
         char inputMd5FileName[MAX_FILE_PATH];
         if (ctx.md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -28004,7 +29662,7 @@ TEST_F(MediaCodecTest, test_encoding_decoding_abnormal_quitting) {
         ctx.md5Test = mTestMd5;
         char inputMd5FileName[MAX_FILE_PATH];
         if (ctx.md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -28082,7 +29740,7 @@ TEST_F(MediaCodecTest,
         ctx.md5Test = mTestMd5;
         char inputMd5FileName[MAX_FILE_PATH];
         if (ctx.md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -28152,7 +29810,7 @@ TEST_F(MediaCodecTest,
             ctx.md5Test = mTestMd5;
             char inputMd5FileName[MAX_FILE_PATH];
             if (ctx.md5Test) {
-                char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+                char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
                 snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
                     dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                     dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -28222,7 +29880,7 @@ TEST_F(MediaCodecTest,
                 ctx.md5Test = mTestMd5;
                 char inputMd5FileName[MAX_FILE_PATH];
                 if (ctx.md5Test) {
-                    char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+                    char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
                     snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
                         dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                         dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -28286,7 +29944,7 @@ TEST_F(MediaCodecTest,
                 ctx.md5Test = mTestMd5;
                 char inputMd5FileName[MAX_FILE_PATH];
                 if (ctx.md5Test) {
-                    char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+                    char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
                     snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
                         dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                         dedicatedSuffix, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -28378,7 +30036,7 @@ TEST_F(MediaCodecTest, test_encoding_case_async_pf) {
             ctx[i].targetFps = params->rc_params.h265_cbr_params.frame_rate;
         }
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -28466,7 +30124,7 @@ TEST_F(MediaCodecTest, test_encoding_case_poll_multi_thread) {
             ctx[i].targetFps = params->rc_params.h265_cbr_params.frame_rate;
         }
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -28549,7 +30207,7 @@ TEST_F(MediaCodecTest, test_decoding_case_async_pf) {
         ctx[i].duration = mTestTime;
         ctx[i].md5Test = 0;
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -28634,7 +30292,7 @@ TEST_F(MediaCodecTest, test_decoding_case_poll_multi_thread) {
         ctx[i].duration = mTestTime;
         ctx[i].md5Test = 0;
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -28719,7 +30377,7 @@ TEST_F(MediaCodecTest, test_stability_single_encoding_case) {
         ctx[i].pfTest = mTestPF;
         ctx[i].md5Test = 0;
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -28746,6 +30404,62 @@ TEST_F(MediaCodecTest, test_stability_single_encoding_case) {
     }
 }
 
+// Encoder throughput without the input file, the frames are generated in
+// the input buffers
+TEST_F(MediaCodecTest, test_stability_single_encoding_case_synth) {
+    media_codec_context_t context;
+    MediaCodecTestContext ctx;
+    mc_video_codec_enc_params_t *params;
+    mc_synth_params_t synth;
+    const hb_u32 sceneCuts[] = {0, 60, 150};
+    char inputFileName[MAX_FILE_PATH] = "synth";
+    char outputFileName[MAX_FILE_PATH];
+    char dedicatedSuffix[MAX_FILE_PATH] = "stabilitySynth";
+
+    mTestCodec = TEST_CODEC_ID_H265;
+    snprintf(outputFileName, MAX_FILE_PATH, "%s%s%dx%d_%s_%s.%s",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight,
+        mGlobalPixFmtName[mTestPixFmt], dedicatedSuffix,
+        mGlobalCodecName[mTestCodec]);
+    memset(&context, 0x00, sizeof(context));
+    context.codec_id = get_codec_id(mTestCodec);
+    context.encoder = TRUE;
+    params = &context.video_enc_params;
+    params->width = mTestWidth;
+    params->height = mTestHeight;
+    params->pix_fmt = mTestPixFmt;
+    params->frame_buf_count = 5;
+    params->external_frame_buf = mTestBufMode;
+    params->bitstream_buf_count = 5;
+    params->rc_params.mode = (mc_video_rate_control_mode_t)mTestRCMode;
+    ASSERT_EQ(get_rc_params(&context, &params->rc_params), (int32_t)0);
+    params->gop_params.decoding_refresh_type = 2;
+    params->gop_params.gop_preset_idx = mTestGopIdx;
+    params->rot_degree = MC_CCW_0;
+    params->mir_direction = MC_DIRECTION_NONE;
+    params->frame_cropping_flag = FALSE;
+
+    memset(&synth, 0x00, sizeof(synth));
+    synth.seed = 1;
+    synth.block_num = 8;
+    synth.block_size = 64;
+    synth.motion = 8;
+    synth.noise = 4;
+    synth.scene_cuts = sceneCuts;
+    synth.scene_cut_num = sizeof(sceneCuts) / sizeof(sceneCuts[0]);
+
+    memset(&ctx, 0x00, sizeof(ctx));
+    ctx.context = &context;
+    ctx.inputFileName = inputFileName;
+    ctx.outputFileName = outputFileName;
+    ctx.synth = &synth;
+    ctx.testLog = mTestLog;
+    ctx.duration = mTestTime;
+    ctx.stabilityTest = 1;
+    ctx.pfTest = mTestPF;
+    do_sync_encoding(&ctx);
+}
+
 TEST_F(MediaCodecTest, test_stability_multi_encoding_case) {
     pthread_t thread_id[MAX_VPU_INSTANCE];
     void* retVal[MAX_VPU_INSTANCE];
@@ -28831,7 +30545,7 @@ TEST_F(MediaCodecTest, test_stability_multi_encoding_case) {
         ctx[i].frametime = mTestFrameRate ? (1000000/mTestFrameRate) : 0; //us
         ctx[i].readonce = mTestReadOnce;
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -28923,7 +30637,7 @@ TEST_F(MediaCodecTest, test_stability_multi_encoding_case_gopI) {
         ctx[i].delaytime = mTestDelayTime;
         ctx[i].workMode = mTestWorkMode;
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -29016,7 +30730,7 @@ TEST_F(MediaCodecTest, test_stability_single_decoding_case) {
         ctx[i].stabilityTest = 1;
         ctx[i].md5Test = 0;
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -29114,7 +30828,7 @@ TEST_F(MediaCodecTest, test_stability_multi_decoding_case) {
         ctx[i].frametime = mTestFrameRate ? (1000000/mTestFrameRate) : 0; //us
         ctx[i].readonce = mTestReadOnce;
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -29242,7 +30956,7 @@ TEST_F(MediaCodecTest, test_stability_single_encoding_case_with_parameter_settin
             ctx[i].targetFps = params->rc_params.h265_cbr_params.frame_rate;
         }
         if (ctx[i].md5Test) {
-            char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+            char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
             snprintf(inputMd5FileName[i], MAX_FILE_PATH, "%s%s_%s_%d_%s%s",
                 dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
                 dedicatedSuffix, i, mGlobalCodecName[mTestCodec], inputMd5Suffix);
@@ -29262,6 +30976,158 @@ TEST_F(MediaCodecTest, test_stability_single_encoding_case_with_parameter_settin
     }
 }
 
+TEST_F(MediaCodecTest, test_transcoding_h264_to_h265_zero_copy) {
+    media_codec_context_t decoder;
+    media_codec_context_t encoder;
+    MediaCodecTestContext ctx;
+    mc_video_codec_dec_params_t *decParams;
+    mc_video_codec_enc_params_t *encParams;
+    char inputFileName[MAX_FILE_PATH];
+    char outputFileName[MAX_FILE_PATH];
+    char unusedFileName[MAX_FILE_PATH];
+
+    snprintf(inputFileName, MAX_FILE_PATH, "%s%s%dx%d_normal.%s",
+        mInputPrefix, G_DEFAULT_VIDEO_INPUT_SUFFIX, mTestWidth, mTestHeight,
+        mGlobalCodecName[TEST_CODEC_ID_H264]);
+    snprintf(outputFileName, MAX_FILE_PATH, "%s%s%dx%d_transcoded.%s",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight,
+        mGlobalCodecName[TEST_CODEC_ID_H265]);
+    // the decoder context opens an output file nothing is written to
+    snprintf(unusedFileName, MAX_FILE_PATH, "%s.yuv", outputFileName);
+
+    memset(&decoder, 0x00, sizeof(media_codec_context_t));
+    decoder.codec_id = MEDIA_CODEC_ID_H264;
+    decoder.encoder = FALSE;
+    decParams = &decoder.video_dec_params;
+    decParams->feed_mode = mTestFeedMode;
+    decParams->pix_fmt = MC_PIXEL_FORMAT_NV12;
+    decParams->bitstream_buf_size = ((mTestWidth * mTestHeight * 3 / 2) +
+        0x3FF) & (~0x3FF);
+    decParams->bitstream_buf_count = 6;
+    // one more than the encoder can hold, the decoder never starves
+    decParams->frame_buf_count = 6;
+    decParams->external_bitstream_buf = FALSE;
+    decParams->h264_dec_config.bandwidth_Opt = TRUE;
+    decParams->h264_dec_config.reorder_enable = TRUE;
+    decParams->h264_dec_config.skip_mode = 0;
+
+    memset(&encoder, 0x00, sizeof(media_codec_context_t));
+    encoder.codec_id = MEDIA_CODEC_ID_H265;
+    encoder.encoder = TRUE;
+    encParams = &encoder.video_enc_params;
+    encParams->width = mTestWidth;
+    encParams->height = mTestHeight;
+    encParams->pix_fmt = MC_PIXEL_FORMAT_NV12;
+    encParams->frame_buf_count = 5;
+    encParams->external_frame_buf = TRUE;
+    encParams->bitstream_buf_count = 5;
+    encParams->rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    ASSERT_EQ(get_rc_params(&encoder, &encParams->rc_params), (int32_t)0);
+    encParams->gop_params.decoding_refresh_type = 2;
+    encParams->gop_params.gop_preset_idx = 2;
+    encParams->rot_degree = MC_CCW_0;
+    encParams->mir_direction = MC_DIRECTION_NONE;
+    encParams->frame_cropping_flag = FALSE;
+
+    memset(&ctx, 0x00, sizeof(ctx));
+    ctx.context = &decoder;
+    ctx.inputFileName = inputFileName;
+    ctx.outputFileName = unusedFileName;
+    ctx.testLog = mTestLog;
+    ctx.duration = mTestTime;
+    do_sync_transcoding(&ctx, &encoder, outputFileName);
+}
+
+// frames of the chunked encoding read by offset, from every instance thread
+static hb_s32 read_chunk_frame(void *userdata, hb_u32 frame,
+                mc_video_frame_buffer_info_t *dst) {
+    int fd = *(int *)userdata;
+    off_t offset = (off_t)frame * dst->size;
+    return (pread(fd, dst->vir_ptr[0], dst->size, offset) ==
+        (ssize_t)dst->size) ? 0 : (int32_t)HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+}
+
+TEST_F(MediaCodecTest, test_encoding_gop_chunks_on_all_instances) {
+    media_codec_context_t contexts[MAX_VPU_INSTANCE];
+    media_codec_context_t *ctxList[MAX_VPU_INSTANCE];
+    mc_video_codec_enc_params_t *params;
+    mc_chunk_params_t chunkParams;
+    mc_chunk_stats_t single, parallel;
+    char inputFileName[MAX_FILE_PATH];
+    char outputFileName[MAX_FILE_PATH];
+    hb_u8 *stream = NULL;
+    hb_u32 size = 0;
+    struct stat st;
+    FILE *outFile;
+    int fd, i, num;
+
+    snprintf(inputFileName, MAX_FILE_PATH, "%s%s%dx%d_%s.yuv",
+        mInputPrefix, G_DEFAULT_VIDEO_INPUT_SUFFIX, mTestWidth, mTestHeight,
+        mGlobalPixFmtName[mTestPixFmt]);
+    snprintf(outputFileName, MAX_FILE_PATH, "%s%s%dx%d_%s_chunks.%s",
+        mOutputPrefix, G_DEFAULT_VIDEO_OUTPUT_SUFFIX, mTestWidth, mTestHeight,
+        mGlobalPixFmtName[mTestPixFmt], mGlobalCodecName[TEST_CODEC_ID_H265]);
+    fd = open(inputFileName, O_RDONLY);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(fstat(fd, &st), 0);
+
+    num = (MAX_VPU_INSTANCE > MC_CHUNK_MAX_INSTANCES) ?
+        MC_CHUNK_MAX_INSTANCES : MAX_VPU_INSTANCE;
+    for (i = 0; i < num; i++) {
+        memset(&contexts[i], 0x00, sizeof(media_codec_context_t));
+        contexts[i].codec_id = MEDIA_CODEC_ID_H265;
+        contexts[i].encoder = TRUE;
+        params = &contexts[i].video_enc_params;
+        params->width = mTestWidth;
+        params->height = mTestHeight;
+        params->pix_fmt = mTestPixFmt;
+        params->frame_buf_count = 5;
+        params->external_frame_buf = FALSE;
+        params->bitstream_buf_count = 5;
+        params->rc_params.mode = MC_AV_RC_MODE_H265CBR;
+        ASSERT_EQ(get_rc_params(&contexts[i], &params->rc_params), (int32_t)0);
+        params->rc_params.h265_cbr_params.intra_period = 30;
+        // IDR refresh without open GOPs, every chunk decodes on its own
+        params->gop_params.decoding_refresh_type = 2;
+        params->gop_params.gop_preset_idx = 1;
+        params->rot_degree = MC_CCW_0;
+        params->mir_direction = MC_DIRECTION_NONE;
+        params->frame_cropping_flag = FALSE;
+        ctxList[i] = &contexts[i];
+    }
+
+    memset(&chunkParams, 0x00, sizeof(chunkParams));
+    chunkParams.frame_num = st.st_size / (mTestWidth * mTestHeight * 3 / 2);
+    chunkParams.gop_size = 30;
+    chunkParams.read_frame = read_chunk_frame;
+    chunkParams.userdata = &fd;
+    chunkParams.timeout = 100;
+    ASSERT_GT(chunkParams.frame_num, 0U);
+
+    // the same file on one instance is the baseline of the speedup
+    ASSERT_EQ(hb_mm_chunk_encode(&chunkParams, ctxList, 1, &stream, &size,
+        &single), (int32_t)0);
+    free(stream);
+    ASSERT_EQ(hb_mm_chunk_encode(&chunkParams, ctxList, num, &stream, &size,
+        &parallel), (int32_t)0);
+    outFile = fopen(outputFileName, "wb");
+    ASSERT_NE(outFile, nullptr);
+    EXPECT_EQ(fwrite(stream, 1, size, outFile), (size_t)size);
+    fclose(outFile);
+    free(stream);
+    close(fd);
+
+    printf("%s %u frames in %d chunks: %llu us vs %llu us on one instance, "
+        "speedup %.2fx, %u parameter sets dropped\n", TAG,
+        chunkParams.frame_num, parallel.chunks,
+        (unsigned long long)parallel.wall_us,
+        (unsigned long long)single.wall_us,
+        (double)single.wall_us / (parallel.wall_us ? parallel.wall_us : 1),
+        parallel.dropped_param_sets);
+    // at least the VPS, SPS and PPS every later chunk starts with
+    EXPECT_GE(parallel.dropped_param_sets, (hb_u32)(parallel.chunks - 1) * 3);
+}
+
 TEST_F(MediaCodecTest, test_encoding_case_h265_use_cfg) {
     char outputFileName[MAX_FILE_PATH];
     char inputFileName[MAX_FILE_PATH];
@@ -29314,7 +31180,7 @@ TEST_F(MediaCodecTest, test_encoding_case_h265_use_cfg) {
     ctx.md5Test = mTestMd5;
     char inputMd5FileName[MAX_FILE_PATH];
     if (ctx.md5Test) {
-        char inputMd5Suffix[MAX_FILE_PATH] = ".md5";
+        char inputMd5Suffix[MAX_FILE_PATH] = ".digest";
         snprintf(inputMd5FileName, MAX_FILE_PATH, "%s%s_%s_%s%s",
             dedicatedInputPrefix, mGlobalPixFmtName[mTestPixFmt],
             mGlobalCodecName[mTestCodec], dedicatedSuffix, inputMd5Suffix);
@@ -0,0 +1,888 @@
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "hb_media_bufpool.h"
+#include "hb_media_codec.h"
+#include "hb_media_config.h"
+#include "hb_media_digest.h"
+#include "hb_media_log.h"
+#include "hb_media_nal.h"
+#include "hb_media_pixfmt.h"
+#include "hb_media_qpmap.h"
+#include "hb_media_scaler.h"
+#include "hb_media_scenecut.h"
+#include "hb_media_skip.h"
+#include "hb_media_slicestream.h"
+#include "hb_media_startup.h"
+#include "hb_media_synth.h"
+#include "hb_media_telemetry.h"
+#include "mediaHostFake.h"
+#include "media_host_git_commit.h"
+
+namespace mediaCodec {
+namespace bench {
+
+// args: width, height, source format, destination format, instruction set
+static void BM_pixfmt_convert(benchmark::State& state) {
+    const int width = state.range(0), height = state.range(1);
+    const mc_pixel_format_t srcFmt = (mc_pixel_format_t)state.range(2);
+    const mc_pixel_format_t dstFmt = (mc_pixel_format_t)state.range(3);
+    const size_t frameSize = (size_t)width * height * 3 / 2;
+    std::vector<uint8_t> srcBuf(frameSize, 0x80), dstBuf(frameSize);
+    mc_video_planes_t src;
+    mc_video_frame_buffer_info_t dst;
+
+    hb_mm_simd_set_isa((mc_simd_isa_t)state.range(4));
+    if (hb_mm_simd_get_isa() != (mc_simd_isa_t)state.range(4)) {
+        state.SkipWithError("instruction set not available");
+        hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+        return;
+    }
+
+    memset(&src, 0x00, sizeof(src));
+    src.data[0] = srcBuf.data();
+    src.data[1] = srcBuf.data() + width * height;
+    src.data[2] = srcBuf.data() + width * height * 5 / 4;
+    src.stride[0] = width;
+    src.stride[1] = (srcFmt == MC_PIXEL_FORMAT_YUV420P) ? width / 2 : width;
+    src.stride[2] = width / 2;
+    memset(&dst, 0x00, sizeof(dst));
+    dst.width = width;
+    dst.height = height;
+    dst.pix_fmt = dstFmt;
+
+    for (auto _ : state) {
+        dst.vir_ptr[0] = dstBuf.data();
+        dst.vir_ptr[1] = NULL;
+        dst.vir_ptr[2] = NULL;
+        hb_mm_pixfmt_convert(srcFmt, &src, &dst);
+        benchmark::ClobberMemory();
+    }
+    // read plus write of one frame
+    state.SetBytesProcessed(state.iterations() * frameSize * 2);
+    state.SetLabel(hb_mm_simd_isa_name(hb_mm_simd_get_isa()));
+    hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+}
+
+static void pixfmt_args(benchmark::internal::Benchmark* b) {
+    const int sizes[][2] = {{1920, 1080}, {3840, 2160}};
+    const int convs[][2] = {
+        {MC_PIXEL_FORMAT_YUV420P, MC_PIXEL_FORMAT_NV12},
+        {MC_PIXEL_FORMAT_NV12, MC_PIXEL_FORMAT_YUV420P},
+        {MC_PIXEL_FORMAT_NV12, MC_PIXEL_FORMAT_NV21},
+    };
+    const int isas[] = {MC_SIMD_ISA_C, MC_SIMD_ISA_SSE2, MC_SIMD_ISA_AVX2,
+        MC_SIMD_ISA_NEON};
+    b->ArgNames({"w", "h", "src", "dst", "isa"});
+    for (auto& size : sizes) {
+        for (auto& conv : convs) {
+            for (int isa : isas) {
+                b->Args({size[0], size[1], conv[0], conv[1], isa});
+            }
+        }
+    }
+}
+BENCHMARK(BM_pixfmt_convert)->Apply(pixfmt_args);
+
+// args: destination width, height, filter, instruction set; NV12 1080p source
+static void BM_scaler_process(benchmark::State& state) {
+    const int srcW = 1920, srcH = 1080;
+    const int width = state.range(0), height = state.range(1);
+    std::vector<uint8_t> srcBuf(srcW * srcH * 3 / 2, 0x80);
+    std::vector<uint8_t> dstBuf(width * height * 3 / 2);
+    mc_video_planes_t src;
+    mc_video_frame_buffer_info_t dst;
+    mc_scaler_t *scaler = NULL;
+
+    hb_mm_simd_set_isa((mc_simd_isa_t)state.range(3));
+    if ((hb_mm_simd_get_isa() != (mc_simd_isa_t)state.range(3)) ||
+        (hb_mm_scaler_create(srcW, srcH, width, height,
+        (mc_scale_filter_t)state.range(2), &scaler) != 0)) {
+        state.SkipWithError("scaler not available");
+        hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+        return;
+    }
+
+    memset(&src, 0x00, sizeof(src));
+    src.data[0] = srcBuf.data();
+    src.data[1] = srcBuf.data() + srcW * srcH;
+    src.stride[0] = srcW;
+    src.stride[1] = srcW;
+    memset(&dst, 0x00, sizeof(dst));
+    dst.width = width;
+    dst.height = height;
+    dst.pix_fmt = MC_PIXEL_FORMAT_NV12;
+
+    for (auto _ : state) {
+        dst.vir_ptr[0] = dstBuf.data();
+        dst.vir_ptr[1] = NULL;
+        hb_mm_scaler_process(scaler, MC_PIXEL_FORMAT_NV12, &src, &dst);
+        benchmark::ClobberMemory();
+    }
+    // source pixels consumed
+    state.SetItemsProcessed(state.iterations() * srcW * srcH);
+    state.SetLabel(hb_mm_simd_isa_name(hb_mm_simd_get_isa()));
+    hb_mm_scaler_destroy(scaler);
+    hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+}
+
+static void scaler_args(benchmark::internal::Benchmark* b) {
+    const int sizes[][3] = {
+        {1280, 720, MC_SCALE_FILTER_BILINEAR},
+        {960, 540, MC_SCALE_FILTER_BILINEAR},
+        {960, 540, MC_SCALE_FILTER_AREA},
+        {640, 360, MC_SCALE_FILTER_AREA},
+    };
+    const int isas[] = {MC_SIMD_ISA_C, MC_SIMD_ISA_SSE2, MC_SIMD_ISA_AVX2,
+        MC_SIMD_ISA_NEON};
+    b->ArgNames({"w", "h", "filter", "isa"});
+    for (auto& size : sizes) {
+        for (int isa : isas) {
+            b->Args({size[0], size[1], size[2], isa});
+        }
+    }
+}
+BENCHMARK(BM_scaler_process)->Apply(scaler_args);
+
+// args: instruction set; a static 1080p scene, every picture is scanned whole
+static void BM_skip_detect(benchmark::State& state) {
+    const int width = 1920, height = 1080;
+    std::vector<uint8_t> luma(width * height, 0x80);
+    mc_skip_params_t params;
+    mc_skip_detector_t *det = NULL;
+    hb_bool skip;
+
+    hb_mm_simd_set_isa((mc_simd_isa_t)state.range(0));
+    memset(&params, 0x00, sizeof(params));
+    params.width = width;
+    params.height = height;
+    params.block_sad_threshold = 16 * 16 * 2;
+    if ((hb_mm_simd_get_isa() != (mc_simd_isa_t)state.range(0)) ||
+        (hb_mm_skip_create(&params, &det) != 0)) {
+        state.SkipWithError("instruction set not available");
+        hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+        return;
+    }
+    hb_mm_skip_detect(det, luma.data(), width, &skip);
+
+    for (auto _ : state) {
+        hb_mm_skip_detect(det, luma.data(), width, &skip);
+        benchmark::DoNotOptimize(skip);
+    }
+    // current plus reference luma
+    state.SetBytesProcessed(state.iterations() * width * height * 2);
+    state.SetLabel(hb_mm_simd_isa_name(hb_mm_simd_get_isa()));
+    hb_mm_skip_destroy(det);
+    hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+}
+BENCHMARK(BM_skip_detect)->ArgName("isa")->DenseRange(MC_SIMD_ISA_C,
+    MC_SIMD_ISA_NEON);
+
+// args: instruction set; 1080p H265 map in 32x32 blocks of a static scene
+static void BM_qpmap_generate(benchmark::State& state) {
+    const int width = 1920, height = 1080;
+    std::vector<uint8_t> luma(width * height, 0x80);
+    mc_qpmap_params_t params;
+    mc_qpmap_generator_t *gen = NULL;
+    hb_byte map;
+    hb_u32 count;
+
+    hb_mm_simd_set_isa((mc_simd_isa_t)state.range(0));
+    memset(&params, 0x00, sizeof(params));
+    params.width = width;
+    params.height = height;
+    params.align = 64;
+    params.block_size = 32;
+    params.pool_num = 4;
+    params.base_qp = 30;
+    params.max_qp = 51;
+    params.aq_strength = 8;
+    params.static_threshold = 8;
+    params.motion_threshold = 32;
+    params.static_qp_offset = 4;
+    params.motion_qp_offset = 3;
+    if ((hb_mm_simd_get_isa() != (mc_simd_isa_t)state.range(0)) ||
+        (hb_mm_qpmap_create(&params, &gen) != 0)) {
+        state.SkipWithError("instruction set not available");
+        hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+        return;
+    }
+
+    for (auto _ : state) {
+        hb_mm_qpmap_generate(gen, luma.data(), width, &map, &count);
+        benchmark::DoNotOptimize(map);
+    }
+    // current plus previous luma
+    state.SetBytesProcessed(state.iterations() * width * height * 2);
+    state.SetLabel(hb_mm_simd_isa_name(hb_mm_simd_get_isa()));
+    hb_mm_qpmap_destroy(gen);
+    hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+}
+BENCHMARK(BM_qpmap_generate)->ArgName("isa")->DenseRange(MC_SIMD_ISA_C,
+    MC_SIMD_ISA_NEON);
+
+// args: instruction set; 1080p, every picture is reduced and compared
+static void BM_scenecut_detect(benchmark::State& state) {
+    const int width = 1920, height = 1080;
+    std::vector<uint8_t> luma(width * height, 0x80);
+    mc_scenecut_params_t params;
+    mc_scenecut_detector_t *det = NULL;
+    hb_bool idr;
+
+    hb_mm_simd_set_isa((mc_simd_isa_t)state.range(0));
+    memset(&params, 0x00, sizeof(params));
+    params.width = width;
+    params.height = height;
+    params.hist_threshold = 300;
+    params.sad_threshold = 16 * 20;
+    if ((hb_mm_simd_get_isa() != (mc_simd_isa_t)state.range(0)) ||
+        (hb_mm_scenecut_create(&params, &det) != 0)) {
+        state.SkipWithError("instruction set not available");
+        hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+        return;
+    }
+
+    for (auto _ : state) {
+        hb_mm_scenecut_detect(det, luma.data(), width, &idr);
+        benchmark::DoNotOptimize(idr);
+    }
+    state.SetBytesProcessed(state.iterations() * width * height);
+    state.SetLabel(hb_mm_simd_isa_name(hb_mm_simd_get_isa()));
+    hb_mm_scenecut_destroy(det);
+    hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+}
+BENCHMARK(BM_scenecut_detect)->ArgName("isa")->DenseRange(MC_SIMD_ISA_C,
+    MC_SIMD_ISA_NEON);
+
+// one picture appended from the output dequeue path
+static void BM_telemetry_write(benchmark::State& state) {
+    const hb_u64 capacity = 1 << 22;
+    char path[64];
+    media_codec_output_buffer_info_t info;
+    mc_telemetry_writer_t *writer = NULL;
+    hb_u64 i = 0;
+
+    snprintf(path, sizeof(path), "/tmp/media_host_bench_%d.tlm", getpid());
+    if (hb_mm_telemetry_create(path, capacity, &writer) != 0) {
+        state.SkipWithError("telemetry file not available");
+        return;
+    }
+    memset(&info, 0x00, sizeof(info));
+    for (auto _ : state) {
+        info.video_stream_info.enc_pic_byte = (hb_u32)i;
+        if (hb_mm_telemetry_write(writer, &info, i, i + 1) != 0) {
+            state.PauseTiming();
+            hb_mm_telemetry_destroy(writer);
+            hb_mm_telemetry_create(path, capacity, &writer);
+            state.ResumeTiming();
+        }
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+    hb_mm_telemetry_destroy(writer);
+    unlink(path);
+}
+BENCHMARK(BM_telemetry_write);
+
+// args: early start. The fake codec sleeps setupUs in initialize and
+// configure, the input file and the pre-warm stand in for a 1080p camera
+static void BM_startup(benchmark::State& state) {
+    const hb_s32 width = 1920, height = 1080;
+    const size_t frameSize = (size_t)width * height * 3 / 2;
+    std::vector<uint8_t> picture(frameSize, 0x80);
+    char inputPath[64], configPath[64];
+    media_codec_context_t context;
+    mc_config_snapshot_t snap;
+    mc_startup_params_t params;
+    mc_startup_stats_t stats, sum;
+    media_codec_buffer_t output;
+    media_codec_output_buffer_info_t outputInfo;
+    FILE *file;
+    hb_s32 fd;
+
+    snprintf(inputPath, sizeof(inputPath), "/tmp/media_host_bench_%d.yuv",
+        getpid());
+    snprintf(configPath, sizeof(configPath), "/tmp/media_host_bench_%d.cfg",
+        getpid());
+    file = fopen(inputPath, "wb");
+    if (file == NULL) {
+        state.SkipWithError("input file not available");
+        return;
+    }
+    fwrite(picture.data(), 1, picture.size(), file);
+    fclose(file);
+    memset(&snap, 0x00, sizeof(snap));
+    snap.codec_id = MEDIA_CODEC_ID_H265;
+    snap.enc_params.width = width;
+    snap.enc_params.height = height;
+    snap.enc_params.pix_fmt = MC_PIXEL_FORMAT_NV12;
+    snap.enc_params.rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    hb_mm_config_save(configPath, &snap, MC_CONFIG_FORMAT_TEXT);
+
+    memset(&params, 0x00, sizeof(params));
+    params.config_file = configPath;
+    params.input_file = inputPath;
+    params.prewarm_size = frameSize;
+    params.prewarm_align = 4096;
+    params.prewarm_num = 5;
+    params.early_start = (hb_bool)state.range(0);
+    params.timeout = 100;
+    gFakeCodecCalls.setupUs = 2000;
+    memset(&sum, 0x00, sizeof(sum));
+    for (auto _ : state) {
+        state.PauseTiming();
+        hb_mm_bufpool_trim(0);
+        memset(&context, 0x00, sizeof(context));
+        context.codec_id = MEDIA_CODEC_ID_H265;
+        context.encoder = 1;
+        gFakeEncoders[0] = FakeEncoder();
+        gFakeEncoders[0].context = &context;
+        state.ResumeTiming();
+        if (hb_mm_startup_run(&context, &params, &fd, &output, &outputInfo,
+            &stats) != 0) {
+            state.SkipWithError("start up failed");
+            break;
+        }
+        state.PauseTiming();
+        hb_mm_mc_queue_output_buffer(&context, &output, 100);
+        close(fd);
+        hb_mm_mc_stop(&context);
+        hb_mm_mc_release(&context);
+        sum.prepare_us += stats.prepare_us;
+        sum.initialize_us += stats.initialize_us;
+        sum.configure_us += stats.configure_us;
+        sum.start_us += stats.start_us;
+        sum.first_input_us += stats.first_input_us;
+        sum.first_output_us += stats.first_output_us;
+        sum.total_us += stats.total_us;
+        state.ResumeTiming();
+    }
+    state.counters["prepare_us"] = benchmark::Counter(sum.prepare_us,
+        benchmark::Counter::kAvgIterations);
+    state.counters["init_us"] = benchmark::Counter(sum.initialize_us,
+        benchmark::Counter::kAvgIterations);
+    state.counters["config_us"] = benchmark::Counter(sum.configure_us,
+        benchmark::Counter::kAvgIterations);
+    state.counters["start_us"] = benchmark::Counter(sum.start_us,
+        benchmark::Counter::kAvgIterations);
+    state.counters["input_us"] = benchmark::Counter(sum.first_input_us,
+        benchmark::Counter::kAvgIterations);
+    state.counters["output_us"] = benchmark::Counter(sum.first_output_us,
+        benchmark::Counter::kAvgIterations);
+    state.counters["ttff_us"] = benchmark::Counter(sum.total_us,
+        benchmark::Counter::kAvgIterations);
+    gFakeCodecCalls.setupUs = 0;
+    hb_mm_bufpool_trim(0);
+    unlink(inputPath);
+    unlink(configPath);
+}
+BENCHMARK(BM_startup)->ArgName("early")->DenseRange(0, 1)->UseRealTime();
+
+// one hot path record per iteration, the rings are drained to /dev/null
+// every 4096 records out of the timing
+static void BM_log_write(benchmark::State& state) {
+    static mc_log_params_t params;
+    mc_log_stats_t before, after;
+    hb_u32 frame = 0;
+
+    if (state.thread_index() == 0) {
+        memset(&params, 0x00, sizeof(params));
+        params.level_mask = MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_INFO) |
+            MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_WARN) |
+            MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_ERR);
+        params.fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+        params.ring_size = 1 << 20;
+        params.flush_interval_ms = 1;
+        hb_mm_log_configure(&params);
+    }
+    hb_mm_log_get_stats(&before);
+    for (auto _ : state) {
+        HB_MM_LOG(MC_LOG_LEVEL_INFO, "%s frame %u size %d time %.3f ms\n",
+            "[MediaHostBench]", frame, 4096, 1.5);
+        if ((++frame & 4095) == 0) {
+            state.PauseTiming();
+            hb_mm_log_flush();
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        hb_mm_log_flush();
+        hb_mm_log_get_stats(&after);
+        state.counters["dropped"] = (double)(after.dropped - before.dropped);
+        close(params.fd);
+        params.level_mask = MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_WARN) |
+            MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_ERR);
+        params.fd = 2;
+        hb_mm_log_configure(&params);
+    }
+}
+BENCHMARK(BM_log_write)->ThreadRange(1, 4);
+
+// args: mmap. 1080p NV12 pictures of a file in the page cache copied into
+// the input buffer, by fread() as read_input_frames() does or from a mapping
+static void BM_frame_read(benchmark::State& state) {
+    const size_t frameSize = 1920 * 1080 * 3 / 2;
+    const size_t frames = 8;
+    std::vector<uint8_t> picture(frameSize, 0x80), input(frameSize);
+    char path[64];
+    uint8_t *map = NULL;
+    FILE *file;
+    size_t i = 0;
+    int fd = -1;
+
+    snprintf(path, sizeof(path), "/tmp/media_host_bench_%d.yuv", getpid());
+    file = fopen(path, "wb");
+    if (file == NULL) {
+        state.SkipWithError("input file not available");
+        return;
+    }
+    for (i = 0; i < frames; i++) {
+        fwrite(picture.data(), 1, picture.size(), file);
+    }
+    fclose(file);
+    file = NULL;
+    if (state.range(0)) {
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+        map = (fd < 0) ? (uint8_t *)MAP_FAILED : (uint8_t *)mmap(NULL,
+            frameSize * frames, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    } else {
+        file = fopen(path, "rb");
+    }
+    if ((file == NULL) && (map == (uint8_t *)MAP_FAILED || map == NULL)) {
+        state.SkipWithError("input file not available");
+        if (fd >= 0) {
+            close(fd);
+        }
+        unlink(path);
+        return;
+    }
+    i = 0;
+    for (auto _ : state) {
+        if (map != NULL) {
+            memcpy(input.data(), map + (i % frames) * frameSize, frameSize);
+        } else if (fread(input.data(), 1, frameSize, file) != frameSize) {
+            rewind(file);
+            fread(input.data(), 1, frameSize, file);
+        }
+        benchmark::DoNotOptimize(input.data());
+        benchmark::ClobberMemory();
+        i++;
+    }
+    state.SetBytesProcessed(state.iterations() * frameSize);
+    if (map != NULL) {
+        munmap(map, frameSize * frames);
+        close(fd);
+    } else {
+        fclose(file);
+    }
+    unlink(path);
+}
+BENCHMARK(BM_frame_read)->ArgName("mmap")->DenseRange(0, 1);
+
+// args: write. Encoded pictures of 64 KiB appended to the output file by
+// fwrite() as write_output_streams() does or by write(), the file is
+// rewound every 256 pictures to stay small
+static void BM_output_write(benchmark::State& state) {
+    const size_t streamSize = 64 * 1024;
+    std::vector<uint8_t> stream(streamSize, 0x5a);
+    char path[64];
+    FILE *file = NULL;
+    size_t i = 0;
+    int fd = -1;
+
+    snprintf(path, sizeof(path), "/tmp/media_host_bench_%d.h265", getpid());
+    if (state.range(0)) {
+        fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    } else {
+        file = fopen(path, "wb");
+    }
+    if ((file == NULL) && (fd < 0)) {
+        state.SkipWithError("output file not available");
+        return;
+    }
+    for (auto _ : state) {
+        if ((++i & 255) == 0) {
+            state.PauseTiming();
+            if (file != NULL) {
+                rewind(file);
+            } else {
+                lseek(fd, 0, SEEK_SET);
+            }
+            state.ResumeTiming();
+        }
+        if (file != NULL) {
+            fwrite(stream.data(), 1, streamSize, file);
+        } else if (write(fd, stream.data(), streamSize) != (ssize_t)streamSize) {
+            state.SkipWithError("write failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * streamSize);
+    if (file != NULL) {
+        fclose(file);
+    } else {
+        close(fd);
+    }
+    unlink(path);
+}
+BENCHMARK(BM_output_write)->ArgName("write")->DenseRange(0, 1);
+
+// a 1 MiB H265 stream of 4 KiB slices, each key picture behind its
+// VPS/SPS/PPS
+static void BM_nal_scan(benchmark::State& state) {
+    const hb_u32 sliceSize = 4096;
+    static const hb_s32 types[] = {MC_H265_NALU_TYPE_VPS,
+        MC_H265_NALU_TYPE_SPS, MC_H265_NALU_TYPE_PPS, MC_H265_NALU_TYPE_IDR,
+        MC_H265_NALU_TYPE_P, MC_H265_NALU_TYPE_P, MC_H265_NALU_TYPE_P};
+    std::vector<uint8_t> stream;
+    mc_nal_unit_t nal;
+    hb_u32 pos, i, j;
+    hb_u64 units = 0;
+
+    for (i = 0; stream.size() < (1 << 20); i++) {
+        hb_s32 type = types[i % (sizeof(types) / sizeof(types[0]))];
+        hb_u32 size = (type >= MC_H265_NALU_TYPE_VPS) ? 24 : sliceSize;
+        stream.insert(stream.end(), {0, 0, 0, 1, (uint8_t)(type << 1), 1});
+        for (j = 0; j < size; j++) {
+            // never two zero bytes in a row, as after emulation prevention
+            stream.push_back((uint8_t)((i * 131 + j * 29) | 1));
+        }
+    }
+    for (auto _ : state) {
+        pos = 0;
+        while (hb_mm_nal_next(MEDIA_CODEC_ID_H265, stream.data(),
+            stream.size(), &pos, &nal) == 1) {
+            units++;
+        }
+        benchmark::DoNotOptimize(units);
+    }
+    state.SetBytesProcessed(state.iterations() * stream.size());
+}
+BENCHMARK(BM_nal_scan);
+
+static void fake_context_init(media_codec_context_t *context, hb_s32 width,
+        hb_s32 height) {
+    memset(context, 0x00, sizeof(*context));
+    context->codec_id = MEDIA_CODEC_ID_H265;
+    context->encoder = 1;
+    context->video_enc_params.width = width;
+    context->video_enc_params.height = height;
+    context->video_enc_params.pix_fmt = MC_PIXEL_FORMAT_NV12;
+}
+
+// One picture through the stand-in encoder: input dequeue and queue, then
+// output dequeue and queue
+static hb_s32 fake_round_trip(media_codec_context_t *context,
+        FakeEncoder *fake, hb_u64 pts) {
+    media_codec_output_buffer_info_t info;
+    media_codec_buffer_t buffer;
+    hb_s32 ret;
+
+    memset(&buffer, 0x00, sizeof(buffer));
+    ret = hb_mm_mc_dequeue_input_buffer(context, &buffer, 100);
+    if (ret != 0) {
+        return ret;
+    }
+    buffer.vframe_buf.pts = pts;
+    ret = hb_mm_mc_queue_input_buffer(context, &buffer, 100);
+    if (ret != 0) {
+        return ret;
+    }
+    memset(&buffer, 0x00, sizeof(buffer));
+    memset(&info, 0x00, sizeof(info));
+    ret = hb_mm_mc_dequeue_output_buffer(context, &buffer, &info, 100);
+    if (ret != 0) {
+        return ret;
+    }
+    ret = hb_mm_mc_queue_output_buffer(context, &buffer, 100);
+    // the stand-in keeps every pts, start over once all came out
+    if (fake->outputs == 4096) {
+        fake->pts.clear();
+        fake->outputs = 0;
+    }
+    return ret;
+}
+
+// args: width of a 16:9 picture
+static void BM_queue_round_trip(benchmark::State& state) {
+    media_codec_context_t context;
+    FakeEncoder *fake = &gFakeEncoders[0];
+    hb_u64 pts = 0;
+
+    fake_context_init(&context, (hb_s32)state.range(0),
+        (hb_s32)state.range(0) * 9 / 16);
+    *fake = FakeEncoder();
+    fake->context = &context;
+    for (auto _ : state) {
+        if (fake_round_trip(&context, fake, pts++) != 0) {
+            state.SkipWithError("round trip failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    *fake = FakeEncoder();
+}
+BENCHMARK(BM_queue_round_trip)->ArgName("width")->Arg(320)->Arg(1920);
+
+typedef struct ScalingJob {
+    media_codec_context_t context;
+    FakeEncoder *fake;
+    hb_u64 trips;
+    hb_s32 ret;
+} ScalingJob;
+
+static void *scaling_worker(void *arg) {
+    ScalingJob *job = (ScalingJob *)arg;
+    hb_u64 i;
+
+    job->ret = 0;
+    for (i = 0; (i < job->trips) && (job->ret == 0); i++) {
+        job->ret = fake_round_trip(&job->context, job->fake, i);
+    }
+    return NULL;
+}
+
+// args: instances. 640x360 round trips of each instance on its own thread,
+// items per second over all instances show how they scale
+static void BM_instance_scaling(benchmark::State& state) {
+    const int instances = (int)state.range(0);
+    ScalingJob jobs[FAKE_ENCODER_NUM];
+    pthread_t threads[FAKE_ENCODER_NUM];
+    int i;
+
+    for (i = 0; i < instances; i++) {
+        fake_context_init(&jobs[i].context, 640, 360);
+        gFakeEncoders[i] = FakeEncoder();
+        gFakeEncoders[i].context = &jobs[i].context;
+        jobs[i].fake = &gFakeEncoders[i];
+        jobs[i].trips = 256;
+    }
+    for (auto _ : state) {
+        for (i = 0; i < instances; i++) {
+            pthread_create(&threads[i], NULL, scaling_worker, &jobs[i]);
+        }
+        for (i = 0; i < instances; i++) {
+            pthread_join(threads[i], NULL);
+        }
+        for (i = 0; i < instances; i++) {
+            if (jobs[i].ret != 0) {
+                state.SkipWithError("round trip failed");
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * instances * jobs[0].trips);
+    for (i = 0; i < instances; i++) {
+        gFakeEncoders[i] = FakeEncoder();
+    }
+}
+BENCHMARK(BM_instance_scaling)->ArgName("instances")
+    ->DenseRange(1, FAKE_ENCODER_NUM)->UseRealTime();
+
+// args: algo. A 256 KiB encoded picture hashed in 4 KiB parts
+static void BM_digest_frame(benchmark::State& state) {
+    const size_t streamSize = 256 * 1024, part = 4096;
+    std::vector<uint8_t> stream(streamSize);
+    mc_digest_params_t params;
+    mc_digest_t *digest = NULL;
+    size_t i;
+
+    for (i = 0; i < streamSize; i++) {
+        stream[i] = (uint8_t)(i * 131);
+    }
+    memset(&params, 0x00, sizeof(params));
+    params.algos = MC_DIGEST_ALGO_BIT(state.range(0));
+    if (hb_mm_digest_create(&params, &digest) != 0) {
+        state.SkipWithError("digest not available");
+        return;
+    }
+    for (auto _ : state) {
+        for (i = 0; i < streamSize; i += part) {
+            hb_mm_digest_update(digest, stream.data() + i, part);
+        }
+        hb_mm_digest_end_frame(digest, NULL);
+    }
+    state.SetBytesProcessed(state.iterations() * streamSize);
+    hb_mm_digest_destroy(digest);
+}
+BENCHMARK(BM_digest_frame)->ArgName("algo")->DenseRange(MC_DIGEST_ALGO_MD5,
+    MC_DIGEST_ALGO_XXH3);
+
+// 1080p NV12 frames drawn straight into the input buffer, noise is the
+// costly part
+static void BM_synth_fill(benchmark::State& state) {
+    const int width = 1920, height = 1080;
+    std::vector<uint8_t> buf(width * height * 3 / 2);
+    mc_synth_params_t params;
+    mc_video_frame_buffer_info_t frame;
+    hb_u32 index = 0;
+
+    hb_mm_simd_set_isa((mc_simd_isa_t)state.range(1));
+    if (hb_mm_simd_get_isa() != (mc_simd_isa_t)state.range(1)) {
+        state.SkipWithError("isa not available");
+        hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+        return;
+    }
+    memset(&params, 0x00, sizeof(params));
+    params.seed = 1;
+    params.block_num = 8;
+    params.block_size = 128;
+    params.motion = 8;
+    params.noise = state.range(0);
+    memset(&frame, 0x00, sizeof(frame));
+    frame.width = width;
+    frame.height = height;
+    frame.pix_fmt = MC_PIXEL_FORMAT_NV12;
+
+    for (auto _ : state) {
+        frame.vir_ptr[0] = buf.data();
+        frame.vir_ptr[1] = NULL;
+        hb_mm_synth_fill(&params, index++, &frame);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * buf.size());
+    state.SetLabel(hb_mm_simd_isa_name(hb_mm_simd_get_isa()));
+    hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+}
+
+static void synth_args(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"noise", "isa"});
+    for (int noise : {0, 4}) {
+        for (int isa = MC_SIMD_ISA_C; isa <= MC_SIMD_ISA_NEON; isa++) {
+            b->Args({noise, isa});
+        }
+    }
+}
+BENCHMARK(BM_synth_fill)->Apply(synth_args);
+
+static hb_u64 bench_now_us(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (hb_u64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void *slice_drain(void *arg) {
+    int fd = *(int *)arg;
+    uint8_t buf[64 * 1024];
+
+    while (read(fd, buf, sizeof(buf)) > 0) {
+    }
+    return NULL;
+}
+
+// args: slices, sliced. A 3840x2160 picture of 64 KiB in slices over a
+// stream socket drained by a thread. Encoding a slice stands in as the MD5
+// of its rows of the NV12 source; sliced forwards each slice as soon as
+// it's done, otherwise the whole picture goes once all are done.
+// first_byte_us is from the start of the picture to the first write.
+static void BM_slice_first_byte(benchmark::State& state) {
+    const int width = 3840, height = 2160;
+    const hb_u32 slices = (hb_u32)state.range(0);
+    const bool sliced = state.range(1) != 0;
+    const size_t frameSize = (size_t)width * height * 3 / 2;
+    const hb_u32 sliceBytes = 64 * 1024 / slices;
+    std::vector<uint8_t> source(frameSize, 0x80);
+    std::vector<std::vector<uint8_t>> stream(slices);
+    std::vector<uint8_t> picture;
+    media_codec_output_buffer_info_t info;
+    media_codec_buffer_t buffer;
+    mc_slicestream_params_t params;
+    mc_slicestream_t *ss = NULL;
+    hb_u8 md5[MC_DIGEST_MD5_SIZE];
+    hb_u64 start, firstByte = 0, pts = 0;
+    size_t rows = frameSize / width / slices;
+    pthread_t drain;
+    int fds[2];
+    hb_u32 i, j;
+
+    for (i = 0; i < slices; i++) {
+        stream[i].insert(stream[i].end(), {0x00, 0x00, 0x00, 0x01,
+            (uint8_t)(MC_H265_NALU_TYPE_P << 1), 0x01});
+        for (j = 2; j < sliceBytes; j++) {
+            stream[i].push_back((uint8_t)((i * 131 + j * 29) | 1));
+        }
+        picture.insert(picture.end(), stream[i].begin(), stream[i].end());
+    }
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        state.SkipWithError("socket not available");
+        return;
+    }
+    memset(&params, 0x00, sizeof(params));
+    params.sink = MC_SLICESTREAM_SINK_SOCKET;
+    params.codec_id = MEDIA_CODEC_ID_H265;
+    params.fd = fds[0];
+    if (hb_mm_slicestream_create(&params, &ss) != 0) {
+        state.SkipWithError("slice streamer not available");
+        close(fds[0]);
+        close(fds[1]);
+        return;
+    }
+    pthread_create(&drain, NULL, slice_drain, &fds[1]);
+    for (auto _ : state) {
+        start = bench_now_us();
+        for (i = 0; i < slices; i++) {
+            hb_mm_digest_md5(source.data() + i * rows * width,
+                rows * width, md5);
+            benchmark::DoNotOptimize(md5);
+            if (!sliced) {
+                continue;
+            }
+            memset(&buffer, 0x00, sizeof(buffer));
+            buffer.vstream_buf.vir_ptr = stream[i].data();
+            buffer.vstream_buf.size = stream[i].size();
+            buffer.vstream_buf.pts = pts;
+            memset(&info, 0x00, sizeof(info));
+            info.video_stream_info.slice_idx = i;
+            info.video_stream_info.independent_slice_num = slices;
+            hb_mm_slicestream_write(ss, &buffer, &info, NULL);
+            if (i == 0) {
+                firstByte += bench_now_us() - start;
+            }
+        }
+        if (!sliced) {
+            memset(&buffer, 0x00, sizeof(buffer));
+            buffer.vstream_buf.vir_ptr = picture.data();
+            buffer.vstream_buf.size = picture.size();
+            buffer.vstream_buf.pts = pts;
+            hb_mm_slicestream_write(ss, &buffer, NULL, NULL);
+            firstByte += bench_now_us() - start;
+        }
+        pts += 33;
+    }
+    state.counters["first_byte_us"] = benchmark::Counter((double)firstByte,
+        benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations());
+    hb_mm_slicestream_destroy(ss);
+    close(fds[0]);
+    pthread_join(drain, NULL);
+    close(fds[1]);
+}
+BENCHMARK(BM_slice_first_byte)->ArgNames({"slices", "sliced"})
+    ->ArgsProduct({{8, 34}, {0, 1}})->UseRealTime();
+
+}  // namespace bench
+}  // namespace mediaCodec
+
+// The commit the binary was built at goes into the context of the
+// results, --benchmark_out_format=json keeps them per commit
+int main(int argc, char **argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::AddCustomContext("git_commit", MEDIA_HOST_GIT_COMMIT);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
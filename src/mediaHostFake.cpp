@@ -0,0 +1,482 @@
+#include "mediaHostFake.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include "hb_media_error.h"
+
+FakeEncoder gFakeEncoders[FAKE_ENCODER_NUM];
+FakeDecoder gFakeDecoders[FAKE_DECODER_NUM];
+FakeCodecCalls gFakeCodecCalls;
+static std::map<media_codec_context_t *, media_codec_state_t> gFakeStates;
+static hb_s32 gFakeInstanceIndex;
+static std::map<std::pair<media_codec_context_t *, std::string>,
+    std::vector<uint8_t>> gFakeSideConfigs;
+
+static FakeEncoder *find_fake_encoder(media_codec_context_t *context) {
+    for (auto& fake : gFakeEncoders) {
+        if (fake.context == context) {
+            return &fake;
+        }
+    }
+    return NULL;
+}
+
+static FakeDecoder *find_fake_decoder(media_codec_context_t *context) {
+    for (auto& fake : gFakeDecoders) {
+        if (fake.context == context) {
+            return &fake;
+        }
+    }
+    return NULL;
+}
+
+// Hand out a free slot, the caller puts its own planes behind it
+static hb_s32 fake_dequeue_external(FakeEncoder *fake,
+        mc_video_codec_enc_params_t *params, media_codec_buffer_t *buffer) {
+    size_t i;
+    if (fake->slotBusy.empty()) {
+        fake->slotBusy.assign(params->frame_buf_count, false);
+        fake->slotPhys.assign(params->frame_buf_count, 0);
+    }
+    for (i = 0; i < fake->slotBusy.size(); i++) {
+        if (!fake->slotBusy[i]) {
+            break;
+        }
+    }
+    if (i == fake->slotBusy.size()) {
+        return HB_MEDIA_ERR_WAIT_TIMEOUT;
+    }
+    fake->slotBusy[i] = true;
+    fake->slotPhys[i] = 0;
+    buffer->type = MC_VIDEO_FRAME_BUFFER;
+    buffer->vframe_buf.src_idx = i;
+    buffer->vframe_buf.width = params->width;
+    buffer->vframe_buf.height = params->height;
+    buffer->vframe_buf.pix_fmt = params->pix_fmt;
+    buffer->vframe_buf.size = (size_t)params->width * params->height * 3 / 2;
+    return 0;
+}
+
+extern "C" hb_s32 hb_mm_mc_dequeue_input_buffer(media_codec_context_t *context,
+        media_codec_buffer_t *buffer, hb_s32 timeout) {
+    FakeEncoder *fake = find_fake_encoder(context);
+    mc_video_codec_enc_params_t *params = &context->video_enc_params;
+    (void)timeout;
+    if (fake == NULL) {
+        return HB_MEDIA_ERR_INVALID_INSTANCE;
+    }
+    if (fake->timeouts > 0) {
+        fake->timeouts--;
+        return HB_MEDIA_ERR_WAIT_TIMEOUT;
+    }
+    if (params->external_frame_buf) {
+        return fake_dequeue_external(fake, params, buffer);
+    }
+    fake->frame.assign((size_t)params->width * params->height * 3 / 2, 0);
+    buffer->type = MC_VIDEO_FRAME_BUFFER;
+    buffer->vframe_buf.vir_ptr[0] = fake->frame.data();
+    buffer->vframe_buf.width = params->width;
+    buffer->vframe_buf.height = params->height;
+    buffer->vframe_buf.pix_fmt = params->pix_fmt;
+    buffer->vframe_buf.size = fake->frame.size();
+    return 0;
+}
+
+extern "C" hb_s32 hb_mm_mc_skip_pic(media_codec_context_t *context,
+        hb_s32 src_idx) {
+    FakeEncoder *fake = find_fake_encoder(context);
+    if (fake == NULL) {
+        return HB_MEDIA_ERR_INVALID_INSTANCE;
+    }
+    fake->skipped.push_back(src_idx);
+    return 0;
+}
+
+extern "C" hb_s32 hb_mm_mc_request_idr_frame(media_codec_context_t *context) {
+    FakeEncoder *fake = find_fake_encoder(context);
+    if (fake == NULL) {
+        return HB_MEDIA_ERR_INVALID_INSTANCE;
+    }
+    fake->idrRequests.push_back(fake->pts.size());
+    return 0;
+}
+
+extern "C" hb_s32 hb_mm_mc_insert_user_data(media_codec_context_t *context,
+        hb_u8 *data, hb_u32 length) {
+    FakeEncoder *fake = find_fake_encoder(context);
+    if (fake == NULL) {
+        return HB_MEDIA_ERR_INVALID_INSTANCE;
+    }
+    if ((data == NULL) || (length == 0) || (length > 1024)) {
+        return HB_MEDIA_ERR_INVALID_PARAMS;
+    }
+    fake->userData.push_back(std::vector<uint8_t>(data, data + length));
+    fake->userDataFrames.push_back(fake->pts.size());
+    return 0;
+}
+
+extern "C" hb_s32 hb_mm_mc_get_user_data(media_codec_context_t *context,
+        mc_user_data_buffer_t *params, hb_s32 timeout) {
+    FakeDecoder *fake = find_fake_decoder(context);
+    (void)timeout;
+    if (fake == NULL) {
+        return HB_MEDIA_ERR_INVALID_INSTANCE;
+    }
+    if (fake->userDataNext == fake->userData.size()) {
+        return HB_MEDIA_ERR_WAIT_TIMEOUT;
+    }
+    std::vector<uint8_t> &data = fake->userData[fake->userDataNext++];
+    params->user_data_valid = 1;
+    params->size = data.size();
+    params->virt_addr = data.data();
+    return 0;
+}
+
+extern "C" hb_s32 hb_mm_mc_release_user_data(media_codec_context_t *context,
+        const mc_user_data_buffer_t *params) {
+    FakeDecoder *fake = find_fake_decoder(context);
+    (void)params;
+    if (fake == NULL) {
+        return HB_MEDIA_ERR_INVALID_INSTANCE;
+    }
+    fake->userDataReleases++;
+    return 0;
+}
+
+extern "C" hb_s32 hb_mm_mc_queue_input_buffer(media_codec_context_t *context,
+        media_codec_buffer_t *buffer, hb_s32 timeout) {
+    FakeEncoder *fake = find_fake_encoder(context);
+    (void)timeout;
+    if (fake == NULL) {
+        return HB_MEDIA_ERR_INVALID_INSTANCE;
+    }
+    if (buffer->vframe_buf.frame_end) {
+        fake->frameEnd = true;
+    } else {
+        fake->pts.push_back(buffer->vframe_buf.pts);
+    }
+    if (context->video_enc_params.external_frame_buf) {
+        hb_s32 idx = buffer->vframe_buf.src_idx;
+        if (buffer->vframe_buf.frame_end) {
+            fake->slotBusy[idx] = false;
+        } else {
+            fake->slotPhys[idx] = buffer->vframe_buf.phy_ptr[0];
+            fake->pending.push_back(idx);
+            fake->inputPhys.push_back(buffer->vframe_buf.phy_ptr[0]);
+        }
+    }
+    return 0;
+}
+
+static hb_s32 fake_decoder_dequeue(FakeDecoder *fake,
+        media_codec_buffer_t *buffer) {
+    size_t size = (size_t)fake->width * fake->height * 3 / 2;
+    int i;
+    if (fake->held.empty()) {
+        fake->held.assign(fake->frameBufCount, false);
+        fake->frames.assign(fake->frameBufCount, std::vector<uint8_t>(size));
+    }
+    for (i = 0; i < fake->frameBufCount; i++) {
+        if (!fake->held[i]) {
+            break;
+        }
+    }
+    if (i == fake->frameBufCount) {
+        return HB_MEDIA_ERR_WAIT_TIMEOUT;
+    }
+    fake->held[i] = true;
+    buffer->type = MC_VIDEO_FRAME_BUFFER;
+    buffer->vframe_buf.src_idx = i;
+    buffer->vframe_buf.width = fake->width;
+    buffer->vframe_buf.height = fake->height;
+    buffer->vframe_buf.pix_fmt = fake->pixFmt;
+    if (fake->decoded == fake->total) {
+        buffer->vframe_buf.frame_end = 1;
+        return 0;
+    }
+    memset(fake->frames[i].data(), fake->decoded, size);
+    buffer->vframe_buf.vir_ptr[0] = fake->frames[i].data();
+    buffer->vframe_buf.vir_ptr[1] = fake->frames[i].data() +
+        fake->width * fake->height;
+    buffer->vframe_buf.phy_ptr[0] = FAKE_DECODER_PHYS(i);
+    buffer->vframe_buf.phy_ptr[1] = FAKE_DECODER_PHYS(i) +
+        fake->width * fake->height;
+    buffer->vframe_buf.fd[0] = 100 + i;
+    buffer->vframe_buf.size = size;
+    buffer->vframe_buf.stride = fake->width;
+    buffer->vframe_buf.vstride = fake->height;
+    buffer->vframe_buf.pts = fake->decoded++;
+    return 0;
+}
+
+static hb_s32 fake_decoder_queue(FakeDecoder *fake,
+        media_codec_buffer_t *buffer) {
+    hb_s32 idx = buffer->vframe_buf.src_idx;
+    size_t i;
+    if ((idx < 0) || (idx >= fake->frameBufCount) || !fake->held[idx]) {
+        return HB_MEDIA_ERR_INVALID_PARAMS;
+    }
+    fake->held[idx] = false;
+    for (auto& enc : gFakeEncoders) {
+        for (i = 0; i < enc.slotBusy.size(); i++) {
+            if (enc.slotBusy[i] && (enc.slotPhys[i] == FAKE_DECODER_PHYS(idx))) {
+                fake->earlyReturns++;
+            }
+        }
+    }
+    return 0;
+}
+
+extern "C" hb_s32 hb_mm_mc_dequeue_output_buffer(media_codec_context_t *context,
+        media_codec_buffer_t *buffer, media_codec_output_buffer_info_t *info,
+        hb_s32 timeout) {
+    FakeEncoder *fake = find_fake_encoder(context);
+    FakeDecoder *decoder = find_fake_decoder(context);
+    (void)timeout;
+    if (decoder != NULL) {
+        return fake_decoder_dequeue(decoder, buffer);
+    }
+    if (fake == NULL) {
+        return HB_MEDIA_ERR_INVALID_INSTANCE;
+    }
+    if (fake->outputs == fake->pts.size() && !fake->frameEnd) {
+        return HB_MEDIA_ERR_WAIT_TIMEOUT;
+    }
+    fake->stream.assign(64, 0);
+    buffer->type = MC_VIDEO_STREAM_BUFFER;
+    buffer->vstream_buf.vir_ptr = fake->stream.data();
+    buffer->vstream_buf.size = fake->stream.size();
+    if (fake->outputs == fake->pts.size()) {
+        buffer->vstream_buf.stream_end = 1;
+    } else {
+        buffer->vstream_buf.pts = fake->pts[fake->outputs++];
+        info->video_stream_info.enc_pic_byte = fake->stream.size();
+        // the oldest queued input buffer is encoded and free again
+        if (!fake->pending.empty()) {
+            fake->slotBusy[fake->pending.front()] = false;
+            fake->slotPhys[fake->pending.front()] = 0;
+            fake->pending.erase(fake->pending.begin());
+        }
+    }
+    return 0;
+}
+
+extern "C" hb_s32 hb_mm_mc_queue_output_buffer(media_codec_context_t *context,
+        media_codec_buffer_t *buffer, hb_s32 timeout) {
+    FakeDecoder *decoder = find_fake_decoder(context);
+    FakeEncoder *fake;
+    (void)timeout;
+    if (decoder != NULL) {
+        return fake_decoder_queue(decoder, buffer);
+    }
+    fake = find_fake_encoder(context);
+    if (fake == NULL) {
+        return HB_MEDIA_ERR_INVALID_INSTANCE;
+    }
+    if (!buffer->vstream_buf.stream_end) {
+        fake->outputReturns++;
+    }
+    return 0;
+}
+
+extern "C" hb_s32 hb_mm_mc_get_rate_control_config(
+        media_codec_context_t *context, mc_rate_control_params_t *params) {
+    if (find_fake_encoder(context) == NULL) {
+        return HB_MEDIA_ERR_INVALID_INSTANCE;
+    }
+    *params = context->video_enc_params.rc_params;
+    return 0;
+}
+
+extern "C" hb_s32 hb_mm_mc_set_rate_control_config(
+        media_codec_context_t *context, const mc_rate_control_params_t *params) {
+    FakeEncoder *fake = find_fake_encoder(context);
+    if (fake == NULL) {
+        return HB_MEDIA_ERR_INVALID_INSTANCE;
+    }
+    context->video_enc_params.rc_params = *params;
+    switch (params->mode) {
+    case MC_AV_RC_MODE_H264CBR:
+        fake->bitRates.push_back(params->h264_cbr_params.bit_rate);
+        break;
+    case MC_AV_RC_MODE_H264AVBR:
+        fake->bitRates.push_back(params->h264_avbr_params.bit_rate);
+        break;
+    case MC_AV_RC_MODE_H265CBR:
+        fake->bitRates.push_back(params->h265_cbr_params.bit_rate);
+        break;
+    case MC_AV_RC_MODE_H265AVBR:
+        fake->bitRates.push_back(params->h265_avbr_params.bit_rate);
+        break;
+    default:
+        break;
+    }
+    return 0;
+}
+
+extern "C" hb_s32 hb_mm_mc_set_max_bit_rate_config(
+        media_codec_context_t *context, hb_u32 params) {
+    FakeEncoder *fake = find_fake_encoder(context);
+    if (fake == NULL) {
+        return HB_MEDIA_ERR_INVALID_INSTANCE;
+    }
+    fake->maxBitRate = params;
+    return 0;
+}
+
+static hb_s32 fake_transition(media_codec_context_t *context,
+        media_codec_state_t from, media_codec_state_t to) {
+    auto it = gFakeStates.find(context);
+    media_codec_state_t state = (it == gFakeStates.end()) ?
+        MEDIA_CODEC_STATE_UNINITIALIZED : it->second;
+    if (state != from) {
+        return HB_MEDIA_ERR_OPERATION_NOT_ALLOWED;
+    }
+    if (to == MEDIA_CODEC_STATE_UNINITIALIZED) {
+        gFakeStates.erase(context);
+    } else {
+        gFakeStates[context] = to;
+    }
+    return 0;
+}
+
+extern "C" hb_s32 hb_mm_mc_initialize(media_codec_context_t *context) {
+    hb_s32 ret = fake_transition(context, MEDIA_CODEC_STATE_UNINITIALIZED,
+        MEDIA_CODEC_STATE_INITIALIZED);
+    if (ret == 0) {
+        context->instance_index = gFakeInstanceIndex++;
+        gFakeCodecCalls.initialize++;
+        usleep(gFakeCodecCalls.setupUs);
+    }
+    return ret;
+}
+
+extern "C" hb_s32 hb_mm_mc_configure(media_codec_context_t *context) {
+    // configuring again before the start is allowed like stop, configure
+    hb_s32 ret = fake_transition(context, MEDIA_CODEC_STATE_INITIALIZED,
+        MEDIA_CODEC_STATE_CONFIGURED);
+    if (ret != 0) {
+        ret = fake_transition(context, MEDIA_CODEC_STATE_CONFIGURED,
+            MEDIA_CODEC_STATE_CONFIGURED);
+    }
+    if (ret == 0) {
+        gFakeCodecCalls.configure++;
+        usleep(gFakeCodecCalls.setupUs);
+    }
+    return ret;
+}
+
+extern "C" hb_s32 hb_mm_mc_start(media_codec_context_t *context,
+        const mc_av_codec_startup_params_t *info) {
+    hb_s32 ret = fake_transition(context, MEDIA_CODEC_STATE_CONFIGURED,
+        MEDIA_CODEC_STATE_STARTED);
+    (void)info;
+    gFakeCodecCalls.start += (ret == 0);
+    return ret;
+}
+
+extern "C" hb_s32 hb_mm_mc_stop(media_codec_context_t *context) {
+    hb_s32 ret = fake_transition(context, MEDIA_CODEC_STATE_STARTED,
+        MEDIA_CODEC_STATE_INITIALIZED);
+    gFakeCodecCalls.stop += (ret == 0);
+    return ret;
+}
+
+extern "C" hb_s32 hb_mm_mc_release(media_codec_context_t *context) {
+    if (gFakeStates.find(context) == gFakeStates.end()) {
+        return HB_MEDIA_ERR_INVALID_INSTANCE;
+    }
+    gFakeStates.erase(context);
+    for (auto it = gFakeSideConfigs.begin(); it != gFakeSideConfigs.end();) {
+        it = (it->first.first == context) ? gFakeSideConfigs.erase(it) :
+            std::next(it);
+    }
+    gFakeCodecCalls.release++;
+    return 0;
+}
+
+extern "C" hb_s32 hb_mm_mc_get_state(media_codec_context_t *context,
+        media_codec_state_t *state) {
+    auto it = gFakeStates.find(context);
+    *state = (it == gFakeStates.end()) ? MEDIA_CODEC_STATE_UNINITIALIZED :
+        it->second;
+    return 0;
+}
+
+static hb_s32 fake_get_side_config(media_codec_context_t *context,
+        const char *name, void *params, size_t size) {
+    auto it = gFakeSideConfigs.find(std::make_pair(context, std::string(name)));
+    if (gFakeStates.find(context) == gFakeStates.end()) {
+        return HB_MEDIA_ERR_OPERATION_NOT_ALLOWED;
+    }
+    if (it == gFakeSideConfigs.end()) {
+        memset(params, 0x00, size);
+    } else {
+        memcpy(params, it->second.data(), size);
+    }
+    return 0;
+}
+
+static hb_s32 fake_set_side_config(media_codec_context_t *context,
+        const char *name, const void *params, size_t size) {
+    const uint8_t *bytes = (const uint8_t *)params;
+    if (gFakeStates.find(context) == gFakeStates.end()) {
+        return HB_MEDIA_ERR_OPERATION_NOT_ALLOWED;
+    }
+    gFakeSideConfigs[std::make_pair(context, std::string(name))].assign(bytes,
+        bytes + size);
+    gFakeCodecCalls.sideConfig++;
+    return 0;
+}
+
+#define FAKE_SIDE_CONFIG(call, type) \
+    extern "C" hb_s32 hb_mm_mc_get_##call(media_codec_context_t *context, \
+            type *params) { \
+        return fake_get_side_config(context, #call, params, sizeof(*params)); \
+    } \
+    extern "C" hb_s32 hb_mm_mc_set_##call(media_codec_context_t *context, \
+            const type *params) { \
+        return fake_set_side_config(context, #call, params, sizeof(*params)); \
+    }
+
+FAKE_SIDE_CONFIG(longterm_ref_mode, mc_video_longterm_ref_mode_t)
+FAKE_SIDE_CONFIG(intra_refresh_config, mc_video_intra_refresh_params_t)
+FAKE_SIDE_CONFIG(deblk_filter_config, mc_video_deblk_filter_params_t)
+FAKE_SIDE_CONFIG(sao_config, mc_h265_sao_params_t)
+FAKE_SIDE_CONFIG(entropy_config, mc_h264_entropy_params_t)
+FAKE_SIDE_CONFIG(vui_timing_config, mc_video_vui_timing_params_t)
+FAKE_SIDE_CONFIG(vui_config, mc_video_vui_params_t)
+FAKE_SIDE_CONFIG(slice_config, mc_video_slice_params_t)
+FAKE_SIDE_CONFIG(3dnr_enc_config, mc_video_3dnr_enc_params_t)
+FAKE_SIDE_CONFIG(smart_bg_enc_config, mc_video_smart_bg_enc_params_t)
+FAKE_SIDE_CONFIG(pred_unit_config, mc_video_pred_unit_params_t)
+FAKE_SIDE_CONFIG(transform_config, mc_video_transform_params_t)
+FAKE_SIDE_CONFIG(roi_config, mc_video_roi_params_t)
+FAKE_SIDE_CONFIG(mode_decision_config, mc_video_mode_decision_params_t)
+
+extern "C" hb_s32 hb_mm_mc_get_max_bit_rate_config(
+        media_codec_context_t *context, hb_u32 *params) {
+    FakeEncoder *fake = find_fake_encoder(context);
+    if (fake == NULL) {
+        return HB_MEDIA_ERR_INVALID_INSTANCE;
+    }
+    *params = fake->maxBitRate;
+    return 0;
+}
+
+extern "C" hb_s32 hb_mm_mc_get_explicit_header_config(
+        media_codec_context_t *context, hb_s32 *status) {
+    return fake_get_side_config(context, "explicit_header", status,
+        sizeof(*status));
+}
+
+extern "C" hb_s32 hb_mm_mc_set_explicit_header_config(
+        media_codec_context_t *context, hb_s32 status) {
+    return fake_set_side_config(context, "explicit_header", &status,
+        sizeof(status));
+}
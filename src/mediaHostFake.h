@@ -0,0 +1,84 @@
+#ifndef MEDIA_HOST_FAKE_H
+#define MEDIA_HOST_FAKE_H
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "hb_media_codec.h"
+
+// Stand-in for the libmultimedia calls the host modules make, so the host
+// tests and benchmarks don't need the real library. Every instance is
+// looked up by its context.
+struct FakeEncoder {
+    media_codec_context_t *context;
+    std::vector<uint8_t> frame;
+    std::vector<hb_u64> pts;
+    int timeouts;
+    bool frameEnd;
+    std::vector<hb_s32> skipped;
+    // number of pictures queued when each IDR was requested
+    std::vector<size_t> idrRequests;
+    std::vector<hb_u32> bitRates;
+    hb_u32 maxBitRate;
+    // output buffers dequeued, one per queued picture, and given back
+    size_t outputs;
+    size_t outputReturns;
+    std::vector<uint8_t> stream;
+    // with external_frame_buf: input buffers from dequeue until encoded,
+    // the physical address queued in each and the queue order
+    std::vector<bool> slotBusy;
+    std::vector<hb_u64> slotPhys;
+    std::vector<hb_s32> pending;
+    std::vector<hb_u64> inputPhys;
+    // user data inserted and the number of pictures queued before each
+    std::vector<std::vector<uint8_t>> userData;
+    std::vector<size_t> userDataFrames;
+};
+
+#define FAKE_ENCODER_NUM 4
+
+extern FakeEncoder gFakeEncoders[FAKE_ENCODER_NUM];
+
+// Decoder handing out total frames from frameBufCount buffers, then a
+// frame_end buffer. Buffers held by the caller aren't decoded into.
+struct FakeDecoder {
+    media_codec_context_t *context;
+    hb_s32 width;
+    hb_s32 height;
+    mc_pixel_format_t pixFmt;
+    int frameBufCount;
+    int total;
+    int decoded;
+    std::vector<std::vector<uint8_t>> frames;
+    std::vector<bool> held;
+    // frames returned while an encoder had not encoded them yet
+    int earlyReturns;
+    // user data handed out in order and the buffers given back
+    std::vector<std::vector<uint8_t>> userData;
+    size_t userDataNext;
+    int userDataReleases;
+};
+
+#define FAKE_DECODER_NUM 1
+#define FAKE_DECODER_PHYS(idx) (0x40000000ULL + ((hb_u64)(idx) << 24))
+
+extern FakeDecoder gFakeDecoders[FAKE_DECODER_NUM];
+
+// Calls of the codec life cycle stand-ins over all contexts. setupUs is
+// slept in initialize and configure to stand in for their allocations.
+// sideConfig counts the side configuration setters, which are only
+// allowed on initialized contexts.
+struct FakeCodecCalls {
+    int initialize;
+    int configure;
+    int start;
+    int stop;
+    int release;
+    int sideConfig;
+    int setupUs;
+};
+
+extern FakeCodecCalls gFakeCodecCalls;
+
+#endif /* MEDIA_HOST_FAKE_H */
@@ -0,0 +1,2998 @@
+#include <gtest/gtest.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "hb_media_bufpool.h"
+#include "hb_media_chunk.h"
+#include "hb_media_codec.h"
+#include "hb_media_config.h"
+#include "hb_media_digest.h"
+#include "hb_media_error.h"
+#include "hb_media_log.h"
+#include "hb_media_lowlat.h"
+#include "hb_media_ltr.h"
+#include "hb_media_nal.h"
+#include "hb_media_pixfmt.h"
+#include "hb_media_preview.h"
+#include "hb_media_qpmap.h"
+#include "hb_media_ratectl.h"
+#include "hb_media_scenecut.h"
+#include "hb_media_ringbuf.h"
+#include "hb_media_scaler.h"
+#include "hb_media_segment.h"
+#include "hb_media_sei.h"
+#include "hb_media_session.h"
+#include "hb_media_simulcast.h"
+#include "hb_media_skip.h"
+#include "hb_media_slicestream.h"
+#include "hb_media_startup.h"
+#include "hb_media_synth.h"
+#include "hb_media_telemetry.h"
+#include "hb_media_tlayer.h"
+#include "hb_media_transcode.h"
+#include "mediaHostFake.h"
+
+#define TAG "[MediaHostTest]"
+
+using namespace ::testing;
+
+namespace mediaCodec {
+namespace test {
+
+class MediaHostTest:public testing::Test {
+protected:
+virtual void SetUp() {
+    snprintf(mTmpDir, sizeof(mTmpDir), "/tmp/media_host_test_XXXXXX");
+    ASSERT_NE(mkdtemp(mTmpDir), nullptr);
+}
+
+virtual void TearDown() {
+    DIR *dir = opendir(mTmpDir);
+    struct dirent *entry;
+    char path[512];
+    if (dir == NULL) {
+        return;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", mTmpDir, entry->d_name);
+        unlink(path);
+    }
+    closedir(dir);
+    rmdir(mTmpDir);
+}
+
+public:
+    char mTmpDir[256];
+};
+
+static off_t get_file_size(const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return -1;
+    }
+    return st.st_size;
+}
+
+typedef struct SegmentListenerContext {
+    int events;
+    int lastIndex;
+} SegmentListenerContext;
+
+static void on_segment_message(hb_s32 event_type, hb_s32 event,
+        hb_s32 message, void *user) {
+    SegmentListenerContext *ctx = (SegmentListenerContext *)user;
+    EXPECT_EQ(event_type, MR_EVENT_INFO);
+    EXPECT_EQ(event, MR_INFO_MAX_FILESIZE_REACHED);
+    ctx->events++;
+    ctx->lastIndex = message;
+}
+
+TEST_F(MediaHostTest, test_segment_rotation_at_idr) {
+    const int gop = 10, frameSize = 1000, totalFrames = 20000;
+    char pattern[512], path[512];
+    uint8_t frame[frameSize];
+    mr_segment_params_t params;
+    mr_segment_writer_t *writer = NULL;
+    mr_segment_stats_t stats;
+    SegmentListenerContext listenerCtx;
+    off_t total = 0;
+    int i;
+
+    snprintf(pattern, sizeof(pattern), "%s/seg_%%05u.h265", mTmpDir);
+    memset(&params, 0x00, sizeof(params));
+    memset(&listenerCtx, 0x00, sizeof(listenerCtx));
+    params.output_file_pattern = pattern;
+    params.max_file_size = frameSize * 5;
+    params.listener = on_segment_message;
+    params.userdata = &listenerCtx;
+    ASSERT_EQ(hb_mm_seg_create(&params, &writer), 0);
+
+    for (i = 0; i < totalFrames; i++) {
+        memset(frame, (i % gop) == 0 ? 0xA5 : 0x5A, sizeof(frame));
+        ASSERT_EQ(hb_mm_seg_write(writer, frame, frameSize, i * 33,
+            (i % gop) == 0), 0);
+    }
+    ASSERT_EQ(hb_mm_seg_get_stats(writer, &stats), 0);
+    ASSERT_EQ(hb_mm_seg_destroy(writer), 0);
+
+    // every GOP after the first one starts a new segment
+    EXPECT_EQ(stats.frames_written, (hb_u64)totalFrames);
+    EXPECT_EQ(stats.rotations, (hb_u32)(totalFrames / gop - 1));
+    EXPECT_EQ(listenerCtx.events, (int)stats.rotations);
+    printf("%s %u rotations, %u late, max switch %u us\n", TAG,
+        stats.rotations, stats.late_rotations, stats.max_switch_us);
+
+    for (i = 0; i <= (int)stats.rotations; i++) {
+        FILE *fp;
+        uint8_t first = 0;
+        snprintf(path, sizeof(path), pattern, i);
+        EXPECT_EQ(get_file_size(path), (off_t)(gop * frameSize));
+        total += get_file_size(path);
+        fp = fopen(path, "rb");
+        ASSERT_NE(fp, nullptr);
+        ASSERT_EQ(fread(&first, 1, 1, fp), (size_t)1);
+        EXPECT_EQ(first, 0xA5);
+        fclose(fp);
+    }
+    EXPECT_EQ(total, (off_t)totalFrames * frameSize);
+
+    // the pre-opened segment must not be left behind
+    snprintf(path, sizeof(path), pattern, stats.rotations + 1);
+    EXPECT_EQ(access(path, F_OK), -1);
+}
+
+TEST_F(MediaHostTest, test_segment_failed_pre_open) {
+    const int gop = 2, frameSize = 1000;
+    char pattern[512], path[512];
+    uint8_t frame[frameSize];
+    mr_segment_params_t params;
+    mr_segment_writer_t *writer = NULL;
+    mr_segment_stats_t stats;
+    int i;
+
+    // a directory in the place of the second segment makes its open fail
+    snprintf(pattern, sizeof(pattern), "%s/seg_%%05u.h265", mTmpDir);
+    snprintf(path, sizeof(path), pattern, 1);
+    ASSERT_EQ(mkdir(path, 0755), 0);
+    memset(&params, 0x00, sizeof(params));
+    params.output_file_pattern = pattern;
+    params.max_file_size = frameSize;
+    ASSERT_EQ(hb_mm_seg_create(&params, &writer), 0);
+
+    memset(frame, 0xA5, sizeof(frame));
+    for (i = 0; i < 4; i++) {
+        ASSERT_EQ(hb_mm_seg_write(writer, frame, frameSize, i * 33,
+            (i % gop) == 0), 0);
+    }
+    ASSERT_EQ(hb_mm_seg_get_stats(writer, &stats), 0);
+    EXPECT_EQ(stats.rotations, 0U);
+    EXPECT_EQ(stats.failed_rotations, 1U);
+    EXPECT_EQ(stats.frames_written, 4U);
+
+    // once the open works again the next IDR switches
+    ASSERT_EQ(rmdir(path), 0);
+    for (; (i < 1000) && (stats.rotations == 0U); i++) {
+        ASSERT_EQ(hb_mm_seg_write(writer, frame, frameSize, i * 33,
+            (i % gop) == 0), 0);
+        ASSERT_EQ(hb_mm_seg_get_stats(writer, &stats), 0);
+        usleep(1000);
+    }
+    ASSERT_EQ(hb_mm_seg_destroy(writer), 0);
+    EXPECT_EQ(stats.rotations, 1U);
+    EXPECT_EQ(stats.frames_written, (hb_u64)i);
+    snprintf(path, sizeof(path), pattern, 0);
+    EXPECT_EQ(get_file_size(path), (off_t)(i - 1) * frameSize);
+    snprintf(path, sizeof(path), pattern, 1);
+    EXPECT_EQ(get_file_size(path), (off_t)frameSize);
+}
+
+TEST_F(MediaHostTest, test_segment_invalid_params) {
+    mr_segment_params_t params;
+    mr_segment_writer_t *writer = NULL;
+    memset(&params, 0x00, sizeof(params));
+    EXPECT_EQ(hb_mm_seg_create(&params, &writer),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+    EXPECT_EQ(hb_mm_seg_create(NULL, &writer),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+    EXPECT_EQ(hb_mm_seg_write(NULL, NULL, 0, 0, 0),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+}
+
+// Build an H265 access unit: parameter sets + IDR slice, or a trail slice.
+static uint32_t make_h265_access_unit(uint8_t *buf, uint32_t payload, int idr) {
+    static const uint8_t header[] = {
+        0, 0, 0, 1, 0x40, 0x01, 0x0c,   // VPS
+        0, 0, 0, 1, 0x42, 0x01, 0x01,   // SPS
+        0, 0, 0, 1, 0x44, 0x01, 0xc1,   // PPS
+    };
+    uint32_t size = 0;
+    if (idr) {
+        memcpy(buf, header, sizeof(header));
+        size = sizeof(header);
+    }
+    buf[size++] = 0;
+    buf[size++] = 0;
+    buf[size++] = 1;
+    buf[size++] = idr ? (MC_H265_NALU_TYPE_IDR << 1) : (1 << 1);
+    buf[size++] = 0x01;
+    memset(buf + size, 0x80, payload);
+    return size + payload;
+}
+
+TEST_F(MediaHostTest, test_nal_scan) {
+    uint8_t buf[256];
+    uint32_t size = make_h265_access_unit(buf, 16, 1);
+    int32_t expectTypes[] = {MC_H265_NALU_TYPE_VPS, MC_H265_NALU_TYPE_SPS,
+        MC_H265_NALU_TYPE_PPS, MC_H265_NALU_TYPE_IDR};
+    mc_nal_unit_t nal;
+    uint32_t pos = 0, total = 0;
+    int n = 0;
+
+    while (hb_mm_nal_next(MEDIA_CODEC_ID_H265, buf, size, &pos, &nal) > 0) {
+        ASSERT_LT(n, 4);
+        EXPECT_EQ(nal.type, expectTypes[n]);
+        EXPECT_EQ(nal.offset, total);
+        total += nal.size;
+        n++;
+    }
+    EXPECT_EQ(n, 4);
+    EXPECT_EQ(total, size);
+    EXPECT_TRUE(hb_mm_nal_is_key(MEDIA_CODEC_ID_H265, MC_H265_NALU_TYPE_IDR));
+    EXPECT_FALSE(hb_mm_nal_is_key(MEDIA_CODEC_ID_H265, MC_H265_NALU_TYPE_P));
+    EXPECT_TRUE(hb_mm_nal_is_param_set(MEDIA_CODEC_ID_H264,
+        MC_H264_NALU_TYPE_SPS));
+}
+
+static int count_clip_pictures(const char *path, int *idrs, int *firstType) {
+    FILE *fp = fopen(path, "rb");
+    uint8_t *data;
+    long size;
+    mc_nal_unit_t nal;
+    uint32_t pos = 0;
+    int pictures = 0;
+    if (fp == NULL) {
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    data = (uint8_t *)malloc(size);
+    if (fread(data, 1, size, fp) != (size_t)size) {
+        size = 0;
+    }
+    fclose(fp);
+    *idrs = 0;
+    *firstType = -1;
+    while (hb_mm_nal_next(MEDIA_CODEC_ID_H265, data, size, &pos, &nal) > 0) {
+        if (*firstType < 0) {
+            *firstType = nal.type;
+        }
+        if (nal.type == MC_H265_NALU_TYPE_IDR) {
+            (*idrs)++;
+        }
+        if (!hb_mm_nal_is_param_set(MEDIA_CODEC_ID_H265, nal.type)) {
+            pictures++;
+        }
+    }
+    free(data);
+    return pictures;
+}
+
+TEST_F(MediaHostTest, test_ringbuf_pre_and_post_roll) {
+    const int gop = 30, frameMs = 33, payload = 2000;
+    char clipPath[512];
+    uint8_t au[payload + 64];
+    mr_ringbuf_params_t params;
+    mr_ringbuf_t *rb = NULL;
+    mr_ringbuf_stats_t stats;
+    int i, idrs, firstType, pictures;
+
+    memset(&params, 0x00, sizeof(params));
+    params.codec_id = MEDIA_CODEC_ID_H265;
+    params.arena_size = 4 * 1024 * 1024;
+    params.max_frames = 1024;
+    params.pre_roll_ms = 2000;
+    params.post_roll_ms = 1000;
+    ASSERT_EQ(hb_mm_rb_create(&params, &rb), 0);
+
+    // frames before the first IDR can't be decoded and are dropped
+    ASSERT_EQ(hb_mm_rb_push(rb, au, make_h265_access_unit(au, payload, 0),
+        0, 0), 0);
+    for (i = 0; i < 300; i++) {
+        ASSERT_EQ(hb_mm_rb_push(rb, au, make_h265_access_unit(au, payload,
+            (i % gop) == 0), (i + 1) * frameMs, (i % gop) == 0), 0);
+    }
+    ASSERT_EQ(hb_mm_rb_get_stats(rb, &stats), 0);
+    EXPECT_EQ(stats.frames_dropped, (hb_u64)1);
+    EXPECT_GE(stats.duration_ms, (hb_u64)params.pre_roll_ms);
+    EXPECT_LT(stats.duration_ms, (hb_u64)(params.pre_roll_ms + gop * frameMs));
+    EXPECT_EQ(stats.clips_written, (hb_u32)0);
+
+    snprintf(clipPath, sizeof(clipPath), "%s/event.h265", mTmpDir);
+    ASSERT_EQ(hb_mm_rb_trigger(rb, clipPath), 0);
+    EXPECT_EQ(hb_mm_rb_trigger(rb, clipPath),
+        (int32_t)HB_MEDIA_ERR_OPERATION_NOT_ALLOWED);
+    for (; i < 400; i++) {
+        ASSERT_EQ(hb_mm_rb_push(rb, au, make_h265_access_unit(au, payload,
+            (i % gop) == 0), (i + 1) * frameMs, (i % gop) == 0), 0);
+    }
+    ASSERT_EQ(hb_mm_rb_get_stats(rb, &stats), 0);
+    ASSERT_EQ(stats.clips_written, (hb_u32)1);
+    EXPECT_EQ(stats.clips_truncated, (hb_u32)0);
+    EXPECT_EQ(get_file_size(clipPath), (off_t)stats.last_clip_bytes);
+
+    pictures = count_clip_pictures(clipPath, &idrs, &firstType);
+    EXPECT_EQ(firstType, MC_H265_NALU_TYPE_VPS);
+    EXPECT_GE(pictures * frameMs,
+        (int)(params.pre_roll_ms + params.post_roll_ms));
+    EXPECT_GE(idrs, 3);
+    ASSERT_EQ(hb_mm_rb_destroy(rb), 0);
+}
+
+TEST_F(MediaHostTest, test_ringbuf_arena_pressure) {
+    const int gop = 10, payload = 10000;
+    char clipPath[512];
+    uint8_t au[payload + 64];
+    mr_ringbuf_params_t params;
+    mr_ringbuf_t *rb = NULL;
+    mr_ringbuf_stats_t stats;
+    int i, idrs, firstType;
+
+    memset(&params, 0x00, sizeof(params));
+    params.codec_id = MEDIA_CODEC_ID_H265;
+    params.arena_size = 25 * payload + 100;
+    params.max_frames = 64;
+    params.pre_roll_ms = 100000;
+    ASSERT_EQ(hb_mm_rb_create(&params, &rb), 0);
+    for (i = 0; i < 1000; i++) {
+        ASSERT_EQ(hb_mm_rb_push(rb, au, make_h265_access_unit(au, payload,
+            (i % gop) == 0), i * 33, (i % gop) == 0), 0);
+    }
+    ASSERT_EQ(hb_mm_rb_get_stats(rb, &stats), 0);
+    EXPECT_GT(stats.gops_evicted, (hb_u64)0);
+    EXPECT_LE(stats.bytes, params.arena_size);
+
+    snprintf(clipPath, sizeof(clipPath), "%s/pressure.h265", mTmpDir);
+    ASSERT_EQ(hb_mm_rb_trigger(rb, clipPath), 0);
+    ASSERT_EQ(hb_mm_rb_get_stats(rb, &stats), 0);
+    EXPECT_EQ(stats.clips_written, (hb_u32)1);
+    EXPECT_EQ(count_clip_pictures(clipPath, &idrs, &firstType),
+        (int)stats.frames);
+    EXPECT_EQ(firstType, MC_H265_NALU_TYPE_VPS);
+    ASSERT_EQ(hb_mm_rb_destroy(rb), 0);
+}
+
+static void fill_random(uint8_t *buf, size_t size, uint32_t seed) {
+    size_t i;
+    for (i = 0; i < size; i++) {
+        seed = seed * 1103515245 + 12345;
+        buf[i] = (uint8_t)(seed >> 16);
+    }
+}
+
+TEST_F(MediaHostTest, test_pixfmt_convert_all_isa) {
+    const int width = 203, height = 37, cw = (width + 1) / 2, ch = (height + 1) / 2;
+    const int lstride = 256;
+    mc_simd_isa_t isas[] = {MC_SIMD_ISA_C, MC_SIMD_ISA_SSE2, MC_SIMD_ISA_AVX2,
+        MC_SIMD_ISA_NEON};
+    std::vector<uint8_t> y(lstride * height), u(cw * ch), v(cw * ch);
+    std::vector<uint8_t> nv12(lstride * height * 2), nv21(lstride * height * 2),
+        back(lstride * height * 2);
+    mc_video_planes_t src;
+    mc_video_frame_buffer_info_t dst;
+    int i, row, col;
+
+    fill_random(y.data(), y.size(), 1);
+    fill_random(u.data(), u.size(), 2);
+    fill_random(v.data(), v.size(), 3);
+
+    for (i = 0; i < (int)(sizeof(isas) / sizeof(isas[0])); i++) {
+        hb_mm_simd_set_isa(isas[i]);
+        printf("%s pixfmt kernels: %s\n", TAG,
+            hb_mm_simd_isa_name(hb_mm_simd_get_isa()));
+
+        // YUV420P -> NV12 with padded strides
+        memset(&src, 0x00, sizeof(src));
+        src.data[0] = y.data();
+        src.data[1] = u.data();
+        src.data[2] = v.data();
+        src.stride[0] = lstride;
+        src.stride[1] = cw;
+        src.stride[2] = cw;
+        memset(&dst, 0x00, sizeof(dst));
+        dst.vir_ptr[0] = nv12.data();
+        dst.width = width;
+        dst.height = height;
+        dst.pix_fmt = MC_PIXEL_FORMAT_NV12;
+        dst.stride = lstride;
+        ASSERT_EQ(hb_mm_pixfmt_convert(MC_PIXEL_FORMAT_YUV420P, &src, &dst), 0);
+        ASSERT_EQ(dst.vir_ptr[1], nv12.data() + lstride * height);
+        for (row = 0; row < ch; row++) {
+            for (col = 0; col < cw; col++) {
+                ASSERT_EQ(dst.vir_ptr[1][row * lstride + 2 * col], u[row * cw + col]);
+                ASSERT_EQ(dst.vir_ptr[1][row * lstride + 2 * col + 1],
+                    v[row * cw + col]);
+            }
+        }
+
+        // NV12 -> NV21
+        memset(&src, 0x00, sizeof(src));
+        src.data[0] = nv12.data();
+        src.data[1] = nv12.data() + lstride * height;
+        src.stride[0] = lstride;
+        src.stride[1] = lstride;
+        memset(&dst, 0x00, sizeof(dst));
+        dst.vir_ptr[0] = nv21.data();
+        dst.width = width;
+        dst.height = height;
+        dst.pix_fmt = MC_PIXEL_FORMAT_NV21;
+        ASSERT_EQ(hb_mm_pixfmt_convert(MC_PIXEL_FORMAT_NV12, &src, &dst), 0);
+
+        // NV21 -> YUV420P, must give the original planes back
+        memset(&src, 0x00, sizeof(src));
+        src.data[0] = nv21.data();
+        src.data[1] = nv21.data() + width * height;
+        src.stride[0] = width;
+        src.stride[1] = 2 * cw;
+        memset(&dst, 0x00, sizeof(dst));
+        dst.vir_ptr[0] = back.data();
+        dst.width = width;
+        dst.height = height;
+        dst.pix_fmt = MC_PIXEL_FORMAT_YUV420P;
+        dst.stride = width;
+        dst.vstride = cw;
+        ASSERT_EQ(hb_mm_pixfmt_convert(MC_PIXEL_FORMAT_NV21, &src, &dst), 0);
+        for (row = 0; row < height; row++) {
+            ASSERT_EQ(memcmp(back.data() + row * width, y.data() + row * lstride,
+                width), 0);
+        }
+        EXPECT_EQ(memcmp(dst.vir_ptr[1], u.data(), u.size()), 0);
+        EXPECT_EQ(memcmp(dst.vir_ptr[2], v.data(), v.size()), 0);
+    }
+    hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+
+    dst.pix_fmt = MC_PIXEL_FORMAT_YUV422P;
+    EXPECT_EQ(hb_mm_pixfmt_convert(MC_PIXEL_FORMAT_NV12, &src, &dst),
+        (int32_t)HB_MEDIA_ERR_UNSUPPORTED_FEATURE);
+}
+
+static void fill_planes(mc_video_planes_t *planes, mc_pixel_format_t fmt,
+        uint8_t *buf, int width, int height) {
+    int cw = (width + 1) / 2, ch = (height + 1) / 2;
+    memset(planes, 0x00, sizeof(*planes));
+    planes->data[0] = buf;
+    planes->data[1] = buf + width * height;
+    planes->stride[0] = width;
+    if (fmt == MC_PIXEL_FORMAT_YUV420P) {
+        planes->data[2] = buf + width * height + cw * ch;
+        planes->stride[1] = cw;
+        planes->stride[2] = cw;
+    } else {
+        planes->stride[1] = 2 * cw;
+    }
+}
+
+TEST_F(MediaHostTest, test_scaler_all_isa) {
+    const struct {
+        int srcW, srcH, dstW, dstH;
+        mc_scale_filter_t filter;
+        mc_pixel_format_t srcFmt, dstFmt;
+    } cases[] = {
+        {642, 362, 320, 180, MC_SCALE_FILTER_BILINEAR, MC_PIXEL_FORMAT_NV12,
+            MC_PIXEL_FORMAT_NV12},
+        {640, 360, 427, 241, MC_SCALE_FILTER_BILINEAR, MC_PIXEL_FORMAT_YUV420P,
+            MC_PIXEL_FORMAT_YUV420P},
+        {640, 360, 320, 180, MC_SCALE_FILTER_AREA, MC_PIXEL_FORMAT_NV12,
+            MC_PIXEL_FORMAT_NV12},
+        {960, 540, 320, 180, MC_SCALE_FILTER_AREA, MC_PIXEL_FORMAT_YUV420P,
+            MC_PIXEL_FORMAT_NV12},
+        {640, 360, 320, 120, MC_SCALE_FILTER_AREA, MC_PIXEL_FORMAT_NV21,
+            MC_PIXEL_FORMAT_YUV420P},
+    };
+    mc_simd_isa_t isas[] = {MC_SIMD_ISA_SSE2, MC_SIMD_ISA_AVX2,
+        MC_SIMD_ISA_NEON};
+    mc_video_planes_t src;
+    mc_video_frame_buffer_info_t dst;
+    mc_scaler_t *scaler = NULL;
+    size_t i, j;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        std::vector<uint8_t> in(cases[i].srcW * cases[i].srcH * 2);
+        std::vector<uint8_t> ref(cases[i].dstW * cases[i].dstH * 2, 0);
+        std::vector<uint8_t> out(ref.size(), 0);
+        fill_random(in.data(), in.size(), (uint32_t)i + 1);
+        fill_planes(&src, cases[i].srcFmt, in.data(), cases[i].srcW,
+            cases[i].srcH);
+        ASSERT_EQ(hb_mm_scaler_create(cases[i].srcW, cases[i].srcH,
+            cases[i].dstW, cases[i].dstH, cases[i].filter, &scaler), 0);
+
+        memset(&dst, 0x00, sizeof(dst));
+        dst.width = cases[i].dstW;
+        dst.height = cases[i].dstH;
+        dst.pix_fmt = cases[i].dstFmt;
+        dst.vir_ptr[0] = ref.data();
+        hb_mm_simd_set_isa(MC_SIMD_ISA_C);
+        ASSERT_EQ(hb_mm_scaler_process(scaler, cases[i].srcFmt, &src, &dst), 0);
+
+        for (j = 0; j < sizeof(isas) / sizeof(isas[0]); j++) {
+            hb_mm_simd_set_isa(isas[j]);
+            if (hb_mm_simd_get_isa() != isas[j]) {
+                continue;
+            }
+            memset(out.data(), 0x00, out.size());
+            memset(&dst, 0x00, sizeof(dst));
+            dst.width = cases[i].dstW;
+            dst.height = cases[i].dstH;
+            dst.pix_fmt = cases[i].dstFmt;
+            dst.vir_ptr[0] = out.data();
+            ASSERT_EQ(hb_mm_scaler_process(scaler, cases[i].srcFmt, &src,
+                &dst), 0);
+            EXPECT_EQ(memcmp(out.data(), ref.data(), ref.size()), 0)
+                << "case " << i << " " << hb_mm_simd_isa_name(isas[j]);
+        }
+        hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+        ASSERT_EQ(hb_mm_scaler_destroy(scaler), 0);
+    }
+
+    // 2:1 area keeps a 2x2 checkerboard at its mean
+    std::vector<uint8_t> board(64 * 32 * 3 / 2), half(32 * 16 * 3 / 2);
+    for (i = 0; i < 64 * 32; i++) {
+        board[i] = (((i % 64) + (i / 64)) & 1) ? 200 : 100;
+    }
+    memset(board.data() + 64 * 32, 128, 64 * 32 / 2);
+    fill_planes(&src, MC_PIXEL_FORMAT_NV12, board.data(), 64, 32);
+    ASSERT_EQ(hb_mm_scaler_create(64, 32, 32, 16, MC_SCALE_FILTER_AREA,
+        &scaler), 0);
+    memset(&dst, 0x00, sizeof(dst));
+    dst.width = 32;
+    dst.height = 16;
+    dst.pix_fmt = MC_PIXEL_FORMAT_NV12;
+    dst.vir_ptr[0] = half.data();
+    ASSERT_EQ(hb_mm_scaler_process(scaler, MC_PIXEL_FORMAT_NV12, &src, &dst), 0);
+    for (i = 0; i < half.size(); i++) {
+        ASSERT_EQ(half[i], (i < 32 * 16) ? 150 : 128) << "offset " << i;
+    }
+    dst.width = 31;
+    EXPECT_EQ(hb_mm_scaler_process(scaler, MC_PIXEL_FORMAT_NV12, &src, &dst),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+    ASSERT_EQ(hb_mm_scaler_destroy(scaler), 0);
+}
+
+TEST_F(MediaHostTest, test_simulcast_lockstep) {
+    const int srcW = 640, srcH = 360;
+    const int sizes[][2] = {{640, 360}, {320, 180}, {160, 90}};
+    const mc_pixel_format_t fmts[] = {MC_PIXEL_FORMAT_NV12,
+        MC_PIXEL_FORMAT_NV12, MC_PIXEL_FORMAT_YUV420P};
+    media_codec_context_t contexts[3];
+    media_codec_context_t *ctxList[3];
+    std::vector<uint8_t> in(srcW * srcH * 3 / 2);
+    mc_simulcast_params_t params;
+    mc_simulcast_stats_t stats;
+    mc_video_planes_t src;
+    mc_simulcast_t *sc = NULL;
+    hb_u64 pts;
+    int i;
+    size_t j, luma;
+
+    for (i = 0; i < 3; i++) {
+        memset(&contexts[i], 0x00, sizeof(contexts[i]));
+        contexts[i].codec_id = MEDIA_CODEC_ID_H265;
+        contexts[i].encoder = 1;
+        contexts[i].video_enc_params.width = sizes[i][0];
+        contexts[i].video_enc_params.height = sizes[i][1];
+        contexts[i].video_enc_params.pix_fmt = fmts[i];
+        ctxList[i] = &contexts[i];
+        gFakeEncoders[i] = FakeEncoder();
+        gFakeEncoders[i].context = &contexts[i];
+    }
+    memset(in.data(), 90, srcW * srcH);
+    for (j = srcW * srcH; j < in.size(); j += 2) {
+        in[j] = 60;
+        in[j + 1] = 200;
+    }
+    fill_planes(&src, MC_PIXEL_FORMAT_NV12, in.data(), srcW, srcH);
+
+    memset(&params, 0x00, sizeof(params));
+    params.src_width = srcW;
+    params.src_height = srcH;
+    params.filter = MC_SCALE_FILTER_AREA;
+    ASSERT_EQ(hb_mm_simulcast_create(&params, ctxList, 3, &sc), 0);
+
+    for (pts = 0; pts < 10; pts++) {
+        if (pts == 4) {
+            // one instance is behind, nobody may get the picture
+            gFakeEncoders[2].timeouts = 1;
+            ASSERT_EQ(hb_mm_simulcast_feed(sc, MC_PIXEL_FORMAT_NV12, &src, pts),
+                (int32_t)HB_MEDIA_ERR_WAIT_TIMEOUT);
+            for (i = 0; i < 3; i++) {
+                ASSERT_EQ(gFakeEncoders[i].pts.size(), (size_t)pts);
+            }
+        }
+        ASSERT_EQ(hb_mm_simulcast_feed(sc, MC_PIXEL_FORMAT_NV12, &src, pts), 0);
+    }
+    ASSERT_EQ(hb_mm_simulcast_end(sc), 0);
+    ASSERT_EQ(hb_mm_simulcast_get_stats(sc, &stats), 0);
+    EXPECT_EQ(stats.frames, (hb_u64)10);
+    EXPECT_EQ(stats.stalls, (hb_u64)1);
+
+    for (i = 0; i < 3; i++) {
+        FakeEncoder *fake = &gFakeEncoders[i];
+        ASSERT_EQ(fake->pts.size(), (size_t)10);
+        for (pts = 0; pts < 10; pts++) {
+            EXPECT_EQ(fake->pts[pts], pts);
+        }
+        EXPECT_TRUE(fake->frameEnd);
+        // the last dequeued buffer is the end of stream one, fed nothing
+        luma = (size_t)sizes[i][0] * sizes[i][1];
+        EXPECT_EQ(fake->frame.size(), luma * 3 / 2);
+    }
+    ASSERT_EQ(hb_mm_simulcast_destroy(sc), 0);
+
+    // a flat source scales to the same flat picture in every rendition
+    for (i = 0; i < 3; i++) {
+        gFakeEncoders[i] = FakeEncoder();
+        gFakeEncoders[i].context = &contexts[i];
+    }
+    params.filter = MC_SCALE_FILTER_BILINEAR;
+    ASSERT_EQ(hb_mm_simulcast_create(&params, ctxList, 3, &sc), 0);
+    ASSERT_EQ(hb_mm_simulcast_feed(sc, MC_PIXEL_FORMAT_NV12, &src, 0), 0);
+    for (i = 0; i < 3; i++) {
+        std::vector<uint8_t>& frame = gFakeEncoders[i].frame;
+        luma = (size_t)sizes[i][0] * sizes[i][1];
+        for (j = 0; j < luma; j++) {
+            ASSERT_EQ(frame[j], 90);
+        }
+        if (fmts[i] == MC_PIXEL_FORMAT_YUV420P) {
+            EXPECT_EQ(frame[luma], 60);
+            EXPECT_EQ(frame[luma + luma / 4], 200);
+        } else {
+            EXPECT_EQ(frame[luma], 60);
+            EXPECT_EQ(frame[luma + 1], 200);
+        }
+    }
+    // the buffers held by a stall are given back on destroy
+    gFakeEncoders[2].timeouts = 1;
+    ASSERT_EQ(hb_mm_simulcast_feed(sc, MC_PIXEL_FORMAT_NV12, &src, 1),
+        (int32_t)HB_MEDIA_ERR_WAIT_TIMEOUT);
+    ASSERT_EQ(hb_mm_simulcast_destroy(sc), 0);
+    EXPECT_EQ(gFakeEncoders[0].pts.size(), (size_t)2);
+    EXPECT_EQ(gFakeEncoders[1].pts.size(), (size_t)2);
+    EXPECT_EQ(gFakeEncoders[2].pts.size(), (size_t)1);
+}
+
+TEST_F(MediaHostTest, test_skip_static_scene) {
+    const int width = 320, height = 180;
+    mc_simd_isa_t isas[] = {MC_SIMD_ISA_C, MC_SIMD_ISA_SSE2, MC_SIMD_ISA_AVX2,
+        MC_SIMD_ISA_NEON};
+    std::vector<uint8_t> base(width * height), noisy(width * height),
+        moved(width * height);
+    mc_skip_params_t params;
+    mc_skip_stats_t stats;
+    mc_skip_detector_t *det = NULL;
+    hb_bool skip;
+    size_t i;
+    int row, col;
+
+    fill_random(base.data(), base.size(), 7);
+    // sensor noise of one level
+    for (i = 0; i < base.size(); i++) {
+        noisy[i] = (base[i] < 255 && (i & 1)) ? base[i] + 1 : base[i];
+    }
+    // a 24x24 object crossing four blocks and the bottom border
+    moved = base;
+    for (row = 160; row < 180; row++) {
+        for (col = 100; col < 124; col++) {
+            moved[row * width + col] ^= 0x80;
+        }
+    }
+
+    memset(&params, 0x00, sizeof(params));
+    params.width = width;
+    params.height = height;
+    params.block_sad_threshold = 16 * 16 * 2;
+    params.changed_permille = 10;
+    params.max_skip_frames = 3;
+
+    for (i = 0; i < sizeof(isas) / sizeof(isas[0]); i++) {
+        hb_mm_simd_set_isa(isas[i]);
+        if (hb_mm_simd_get_isa() != isas[i]) {
+            continue;
+        }
+        ASSERT_EQ(hb_mm_skip_create(&params, &det), 0);
+        // the first picture is always encoded
+        ASSERT_EQ(hb_mm_skip_detect(det, base.data(), width, &skip), 0);
+        EXPECT_FALSE(skip);
+        // static until max_skip_frames forces one picture out
+        for (row = 0; row < 5; row++) {
+            ASSERT_EQ(hb_mm_skip_detect(det, noisy.data(), width, &skip), 0);
+            EXPECT_EQ(skip != 0, row != 3) << "picture " << row;
+        }
+        ASSERT_EQ(hb_mm_skip_detect(det, moved.data(), width, &skip), 0);
+        EXPECT_FALSE(skip);
+        ASSERT_EQ(hb_mm_skip_get_stats(det, &stats), 0);
+        EXPECT_EQ(stats.last_changed_blocks, (hb_u32)4)
+            << hb_mm_simd_isa_name(isas[i]);
+        EXPECT_EQ(stats.frames, (hb_u64)7);
+        EXPECT_EQ(stats.skipped, (hb_u64)4);
+        EXPECT_EQ(stats.forced, (hb_u64)1);
+        // the moved picture is the reference now
+        ASSERT_EQ(hb_mm_skip_detect(det, moved.data(), width, &skip), 0);
+        EXPECT_TRUE(skip);
+        ASSERT_EQ(hb_mm_skip_destroy(det), 0);
+    }
+    hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+
+    params.changed_permille = 1001;
+    EXPECT_EQ(hb_mm_skip_create(&params, &det),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+}
+
+TEST_F(MediaHostTest, test_skip_apply_on_input_buffer) {
+    const int width = 64, height = 48;
+    media_codec_context_t context;
+    media_codec_buffer_t buffer;
+    mc_skip_params_t params;
+    mc_skip_detector_t *det = NULL;
+    int i;
+
+    memset(&context, 0x00, sizeof(context));
+    context.encoder = 1;
+    context.video_enc_params.width = width;
+    context.video_enc_params.height = height;
+    context.video_enc_params.pix_fmt = MC_PIXEL_FORMAT_NV12;
+    gFakeEncoders[0] = FakeEncoder();
+    gFakeEncoders[0].context = &context;
+
+    memset(&params, 0x00, sizeof(params));
+    params.width = width;
+    params.height = height;
+    params.block_sad_threshold = 64;
+    ASSERT_EQ(hb_mm_skip_create(&params, &det), 0);
+    for (i = 0; i < 4; i++) {
+        memset(&buffer, 0x00, sizeof(buffer));
+        ASSERT_EQ(hb_mm_mc_dequeue_input_buffer(&context, &buffer, 0), 0);
+        buffer.vframe_buf.src_idx = i;
+        memset(buffer.vframe_buf.vir_ptr[0], (i >= 2) ? 200 : 16,
+            width * height);
+        ASSERT_EQ(hb_mm_skip_apply(det, &context, &buffer), 0);
+    }
+    // 0 is the first picture and 2 changed, 1 and 3 repeat them
+    ASSERT_EQ(gFakeEncoders[0].skipped.size(), (size_t)2);
+    EXPECT_EQ(gFakeEncoders[0].skipped[0], 1);
+    EXPECT_EQ(gFakeEncoders[0].skipped[1], 3);
+    ASSERT_EQ(hb_mm_skip_destroy(det), 0);
+}
+
+TEST_F(MediaHostTest, test_qpmap_static_and_moving_blocks) {
+    const int width = 320, height = 180;
+    mc_simd_isa_t isas[] = {MC_SIMD_ISA_C, MC_SIMD_ISA_SSE2, MC_SIMD_ISA_AVX2,
+        MC_SIMD_ISA_NEON};
+    std::vector<uint8_t> base(width * height), moved(width * height);
+    std::vector<uint8_t> ref;
+    mc_qpmap_params_t params;
+    mc_qpmap_stats_t stats;
+    mc_qpmap_generator_t *gen = NULL;
+    hb_byte map, first;
+    hb_u32 count;
+    size_t i;
+    int row, col;
+
+    // flat left half, noise on the right half
+    fill_random(base.data(), base.size(), 11);
+    for (row = 0; row < height; row++) {
+        memset(&base[row * width], 0x80, width / 2);
+    }
+    // an object moving inside the map entry at column 7, row 2
+    moved = base;
+    for (row = 70; row < 90; row++) {
+        for (col = 228; col < 250; col++) {
+            moved[row * width + col] ^= 0x55;
+        }
+    }
+
+    memset(&params, 0x00, sizeof(params));
+    params.width = width;
+    params.height = height;
+    params.align = 64;
+    params.block_size = 32;
+    params.pool_num = 3;
+    params.base_qp = 30;
+    params.min_qp = 10;
+    params.max_qp = 45;
+    params.aq_strength = 8;
+    params.static_threshold = 8;
+    params.motion_threshold = 32;
+    params.static_qp_offset = 4;
+    params.motion_qp_offset = 3;
+    // the entry count of the encoder tests, 64 aligned in 32x32 blocks
+    EXPECT_EQ(hb_mm_qpmap_get_count(&params),
+        (((width + 0x3f) & ~0x3f) >> 5) * (((height + 0x3f) & ~0x3f) >> 5));
+
+    for (i = 0; i < sizeof(isas) / sizeof(isas[0]); i++) {
+        hb_mm_simd_set_isa(isas[i]);
+        if (hb_mm_simd_get_isa() != isas[i]) {
+            continue;
+        }
+        ASSERT_EQ(hb_mm_qpmap_create(&params, &gen), 0);
+        ASSERT_EQ(hb_mm_qpmap_generate(gen, base.data(), width, &map, &count),
+            0);
+        ASSERT_EQ(count, (hb_u32)60);
+        first = map;
+        // no previous picture, flat entries below the textured ones
+        EXPECT_LT(map[0], map[9]);
+        EXPECT_LT(map[50], map[59]);
+        ASSERT_EQ(hb_mm_qpmap_generate(gen, moved.data(), width, &map, &count),
+            0);
+        EXPECT_NE(map, first);
+        EXPECT_EQ(map[2 * 10 + 7], first[2 * 10 + 7] - 3)
+            << hb_mm_simd_isa_name(isas[i]);
+        EXPECT_EQ(map[0], first[0] + 4);
+        EXPECT_EQ(map[59], first[59] + 4);
+        ASSERT_EQ(hb_mm_qpmap_get_stats(gen, &stats), 0);
+        EXPECT_EQ(stats.last_moving_blocks, (hb_u32)1);
+        EXPECT_EQ(stats.last_static_blocks, (hb_u32)59);
+        // every instruction set writes the same map
+        if (ref.empty()) {
+            ref.assign(map, map + count);
+        } else {
+            EXPECT_EQ(memcmp(ref.data(), map, count), 0)
+                << hb_mm_simd_isa_name(isas[i]);
+        }
+        // the pool wraps after pool_num maps
+        ASSERT_EQ(hb_mm_qpmap_generate(gen, moved.data(), width, &map, &count),
+            0);
+        ASSERT_EQ(hb_mm_qpmap_generate(gen, moved.data(), width, &map, &count),
+            0);
+        EXPECT_EQ(map, first);
+        ASSERT_EQ(hb_mm_qpmap_destroy(gen), 0);
+    }
+    hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+
+    params.block_size = 64;
+    params.align = 32;
+    EXPECT_EQ(hb_mm_qpmap_create(&params, &gen),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+}
+
+TEST_F(MediaHostTest, test_qpmap_apply_on_input_buffer) {
+    const int width = 64, height = 48;
+    media_codec_context_t context;
+    media_codec_buffer_t buffer;
+    mc_qpmap_params_t params;
+    mc_qpmap_generator_t *gen = NULL;
+    hb_u32 i;
+
+    memset(&context, 0x00, sizeof(context));
+    context.encoder = 1;
+    context.video_enc_params.width = width;
+    context.video_enc_params.height = height;
+    context.video_enc_params.pix_fmt = MC_PIXEL_FORMAT_NV12;
+    gFakeEncoders[0] = FakeEncoder();
+    gFakeEncoders[0].context = &context;
+
+    memset(&params, 0x00, sizeof(params));
+    params.width = width;
+    params.height = height;
+    params.align = 16;
+    params.block_size = 16;
+    params.pool_num = 2;
+    params.base_qp = 26;
+    params.max_qp = 51;
+    params.static_qp_offset = 5;
+    params.static_threshold = 1;
+    params.motion_threshold = 1;
+    ASSERT_EQ(hb_mm_qpmap_create(&params, &gen), 0);
+    memset(&buffer, 0x00, sizeof(buffer));
+    ASSERT_EQ(hb_mm_mc_dequeue_input_buffer(&context, &buffer, 0), 0);
+    memset(buffer.vframe_buf.vir_ptr[0], 16, width * height);
+    ASSERT_EQ(hb_mm_qpmap_apply(gen, &buffer), 0);
+    ASSERT_EQ(hb_mm_qpmap_apply(gen, &buffer), 0);
+    EXPECT_TRUE(buffer.vframe_buf.qp_map_valid != 0);
+    ASSERT_EQ(buffer.vframe_buf.qp_map_array_count, (hb_u32)12);
+    for (i = 0; i < buffer.vframe_buf.qp_map_array_count; i++) {
+        EXPECT_EQ(buffer.vframe_buf.qp_map_array[i], 31);
+    }
+    ASSERT_EQ(hb_mm_qpmap_destroy(gen), 0);
+}
+
+static void feed_gop(mc_ratectl_t *rc, int frames, hb_u32 bytes,
+        hb_u32 skipBlocks) {
+    media_codec_output_buffer_info_t info;
+    int i;
+
+    for (i = 0; i < frames; i++) {
+        memset(&info, 0x00, sizeof(info));
+        info.video_stream_info.nalu_type =
+            (i == 0) ? MC_H265_NALU_TYPE_I : MC_H265_NALU_TYPE_P;
+        info.video_stream_info.enc_pic_byte = bytes;
+        info.video_stream_info.avg_mb_qp = 30;
+        info.video_stream_info.skip_block_num = skipBlocks;
+        ASSERT_EQ(hb_mm_ratectl_update(rc, &info), 0);
+    }
+}
+
+TEST_F(MediaHostTest, test_ratectl_window_ceiling) {
+    const int width = 640, height = 360;
+    const hb_u32 blocks8 = (width / 8) * (height / 8);
+    media_codec_context_t context;
+    mc_ratectl_params_t params;
+    mc_ratectl_stats_t stats;
+    mc_ratectl_t *rc = NULL;
+
+    memset(&context, 0x00, sizeof(context));
+    context.encoder = 1;
+    context.video_enc_params.width = width;
+    context.video_enc_params.height = height;
+    context.video_enc_params.rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    context.video_enc_params.rc_params.h265_cbr_params.bit_rate = 1000;
+    gFakeEncoders[0] = FakeEncoder();
+    gFakeEncoders[0].context = &context;
+
+    memset(&params, 0x00, sizeof(params));
+    params.frame_rate = 30;
+    params.window_ms = 1000;
+    params.target_bit_rate = 1000;
+    params.ceiling_bit_rate = 1200;
+    params.min_bit_rate = 200;
+    params.headroom_permille = 100;
+    params.max_step_permille = 200;
+    params.static_skip_permille = 900;
+    ASSERT_EQ(hb_mm_ratectl_create(&context, &params, &rc), 0);
+
+    // 1440 kbps, the window is steered to 1080 but one step is 20%
+    feed_gop(rc, 30, 6000, 0);
+    ASSERT_EQ(hb_mm_ratectl_get_stats(rc, &stats), 0);
+    EXPECT_EQ(stats.window_bit_rate, (hb_u32)1440);
+    EXPECT_EQ(stats.overflows, (hb_u64)30);
+    feed_gop(rc, 30, 3000, 0);
+    ASSERT_EQ(gFakeEncoders[0].bitRates.size(), (size_t)1);
+    EXPECT_EQ(gFakeEncoders[0].bitRates[0], (hb_u32)800);
+    // the window sinks below the ceiling after 10 of the smaller pictures
+    ASSERT_EQ(hb_mm_ratectl_get_stats(rc, &stats), 0);
+    EXPECT_EQ(stats.overflows, (hb_u64)39);
+    EXPECT_EQ(stats.last_gop_bit_rate, (hb_u32)1440);
+    EXPECT_EQ(stats.last_gop_avg_qp, (hb_u32)30);
+
+    // 720 kbps leaves room, back up by one step of 800
+    feed_gop(rc, 30, 3000, blocks8);
+    ASSERT_EQ(gFakeEncoders[0].bitRates.size(), (size_t)2);
+    EXPECT_EQ(gFakeEncoders[0].bitRates[1], (hb_u32)960);
+    // the static GOP doesn't get more bits
+    feed_gop(rc, 1, 3000, 0);
+    ASSERT_EQ(gFakeEncoders[0].bitRates.size(), (size_t)2);
+    ASSERT_EQ(hb_mm_ratectl_get_stats(rc, &stats), 0);
+    EXPECT_EQ(stats.gops, (hb_u64)3);
+    EXPECT_EQ(stats.decreases, (hb_u64)1);
+    EXPECT_EQ(stats.increases, (hb_u64)1);
+    EXPECT_EQ(stats.bit_rate, (hb_u32)960);
+    EXPECT_EQ(stats.max_window_bit_rate, (hb_u32)1440);
+    EXPECT_EQ(stats.last_gop_skip_permille, (hb_u32)1000);
+    EXPECT_EQ(context.video_enc_params.rc_params.h265_cbr_params.bit_rate,
+        (hb_u32)960);
+    ASSERT_EQ(hb_mm_ratectl_destroy(rc), 0);
+
+    context.video_enc_params.rc_params.mode = MC_AV_RC_MODE_H265FIXQP;
+    EXPECT_EQ(hb_mm_ratectl_create(&context, &params, &rc),
+        (int32_t)HB_MEDIA_ERR_UNSUPPORTED_FEATURE);
+    context.video_enc_params.rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    params.window_ms = 60000;
+    EXPECT_EQ(hb_mm_ratectl_create(&context, &params, &rc),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+}
+
+// a horizontal gradient or a dark flat scene, both with some noise
+static void fill_scene(uint8_t *luma, int width, int height, int scene,
+        uint32_t seed) {
+    int row, col;
+
+    fill_random(luma, (size_t)width * height, seed);
+    for (row = 0; row < height; row++) {
+        for (col = 0; col < width; col++) {
+            luma[row * width + col] = (uint8_t)(((scene == 0) ?
+                (col * 200 / width) + 20 : 30) + (luma[row * width + col] & 7));
+        }
+    }
+}
+
+TEST_F(MediaHostTest, test_scenecut_idr_cadence) {
+    const int width = 330, height = 190;
+    mc_simd_isa_t isas[] = {MC_SIMD_ISA_C, MC_SIMD_ISA_SSE2, MC_SIMD_ISA_AVX2,
+        MC_SIMD_ISA_NEON};
+    // a cut at 3, a cut back at 5 too close to it, periodic IDR at 9
+    const int scenes[] = {0, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0};
+    const int expected[] = {0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 0};
+    const int pictures = sizeof(scenes) / sizeof(scenes[0]);
+    std::vector<uint8_t> luma(width * height);
+    std::vector<hb_u32> diffs, refDiffs;
+    mc_scenecut_params_t params;
+    mc_scenecut_stats_t stats;
+    mc_scenecut_detector_t *det = NULL;
+    hb_bool idr;
+    size_t i;
+    int n;
+
+    memset(&params, 0x00, sizeof(params));
+    params.width = width;
+    params.height = height;
+    params.hist_threshold = 300;
+    params.sad_threshold = 16 * 20;
+    params.min_cut_interval = 3;
+    params.idr_interval = 6;
+
+    for (i = 0; i < sizeof(isas) / sizeof(isas[0]); i++) {
+        hb_mm_simd_set_isa(isas[i]);
+        if (hb_mm_simd_get_isa() != isas[i]) {
+            continue;
+        }
+        ASSERT_EQ(hb_mm_scenecut_create(&params, &det), 0);
+        diffs.clear();
+        for (n = 0; n < pictures; n++) {
+            fill_scene(luma.data(), width, height, scenes[n], n + 1);
+            ASSERT_EQ(hb_mm_scenecut_detect(det, luma.data(), width, &idr), 0);
+            EXPECT_EQ(idr != 0, expected[n] != 0) << "picture " << n << " "
+                << hb_mm_simd_isa_name(isas[i]);
+            ASSERT_EQ(hb_mm_scenecut_get_stats(det, &stats), 0);
+            diffs.push_back(stats.last_hist_diff);
+            diffs.push_back(stats.last_sad_diff);
+        }
+        EXPECT_EQ(stats.cuts, (hb_u64)1);
+        EXPECT_EQ(stats.periodic, (hb_u64)1);
+        EXPECT_EQ(stats.ignored, (hb_u64)1);
+        // every instruction set reduces the planes the same way
+        if (refDiffs.empty()) {
+            refDiffs = diffs;
+        } else {
+            EXPECT_EQ(diffs, refDiffs) << hb_mm_simd_isa_name(isas[i]);
+        }
+        ASSERT_EQ(hb_mm_scenecut_destroy(det), 0);
+    }
+    hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+
+    params.hist_threshold = 1001;
+    EXPECT_EQ(hb_mm_scenecut_create(&params, &det),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+}
+
+TEST_F(MediaHostTest, test_scenecut_apply_requests_idr) {
+    const int width = 64, height = 48;
+    media_codec_context_t context;
+    media_codec_buffer_t buffer;
+    mc_scenecut_params_t params;
+    mc_scenecut_detector_t *det = NULL;
+    int i;
+
+    memset(&context, 0x00, sizeof(context));
+    context.encoder = 1;
+    context.video_enc_params.width = width;
+    context.video_enc_params.height = height;
+    context.video_enc_params.pix_fmt = MC_PIXEL_FORMAT_NV12;
+    gFakeEncoders[0] = FakeEncoder();
+    gFakeEncoders[0].context = &context;
+
+    memset(&params, 0x00, sizeof(params));
+    params.width = width;
+    params.height = height;
+    params.hist_threshold = 500;
+    params.sad_threshold = 16 * 64;
+    ASSERT_EQ(hb_mm_scenecut_create(&params, &det), 0);
+    for (i = 0; i < 4; i++) {
+        memset(&buffer, 0x00, sizeof(buffer));
+        ASSERT_EQ(hb_mm_mc_dequeue_input_buffer(&context, &buffer, 0), 0);
+        memset(buffer.vframe_buf.vir_ptr[0], (i >= 2) ? 200 : 16,
+            width * height);
+        buffer.vframe_buf.pts = i;
+        ASSERT_EQ(hb_mm_scenecut_apply(det, &context, &buffer), 0);
+        ASSERT_EQ(hb_mm_mc_queue_input_buffer(&context, &buffer, 0), 0);
+    }
+    // requested right before picture 2 is queued
+    ASSERT_EQ(gFakeEncoders[0].idrRequests.size(), (size_t)1);
+    EXPECT_EQ(gFakeEncoders[0].idrRequests[0], (size_t)2);
+    ASSERT_EQ(hb_mm_scenecut_destroy(det), 0);
+}
+
+TEST_F(MediaHostTest, test_telemetry_columns_round_trip) {
+    const hb_u64 capacity = 10000, liveFrames = 5000;
+    char path[512];
+    media_codec_output_buffer_info_t info;
+    mc_telemetry_writer_t *writer = NULL;
+    mc_telemetry_reader_t *reader = NULL;
+    mc_telemetry_stats_t stats;
+    const void *data;
+    hb_u64 i, frames = 0, chunk;
+    hb_u32 j, num;
+
+    snprintf(path, sizeof(path), "%s/enc.tlm", mTmpDir);
+    ASSERT_EQ(hb_mm_telemetry_create(path, capacity, &writer), 0);
+    memset(&info, 0x00, sizeof(info));
+    for (i = 0; i < capacity; i++) {
+        info.video_stream_info.frame_cycle = (hb_u32)(i * 3);
+        info.video_stream_info.enc_pic_byte = (hb_u32)(1000 + i);
+        info.video_stream_info.avg_mb_qp = (hb_u32)(i % 52);
+        info.video_stream_info.nalu_type = (i % 30) ? MC_H265_NALU_TYPE_P :
+            MC_H265_NALU_TYPE_IDR;
+        info.video_stream_info.pic_skipped = (hb_u32)(i % 2);
+        info.video_stream_info.temporal_id = (hb_u32)(i % 4);
+        ASSERT_EQ(hb_mm_telemetry_write(writer, &info, i * 33333,
+            i * 33333 + 5000), 0);
+        if (i + 1 == liveFrames) {
+            // a reader can follow the writer while it is running
+            ASSERT_EQ(hb_mm_telemetry_open(path, &reader), 0);
+            EXPECT_EQ(hb_mm_telemetry_get_frames(reader, &frames), 0);
+            EXPECT_EQ(frames, liveFrames);
+            EXPECT_EQ(hb_mm_telemetry_close(reader), 0);
+        }
+    }
+    EXPECT_EQ(hb_mm_telemetry_write(writer, &info, 0, 0),
+        (int32_t)HB_MEDIA_ERR_INSUFFICIENT_RES);
+    ASSERT_EQ(hb_mm_telemetry_get_stats(writer, &stats), 0);
+    EXPECT_EQ(stats.frames, capacity);
+    EXPECT_EQ(stats.dropped, 1ULL);
+    ASSERT_EQ(hb_mm_telemetry_destroy(writer), 0);
+
+    ASSERT_EQ(hb_mm_telemetry_open(path, &reader), 0);
+    ASSERT_EQ(hb_mm_telemetry_get_frames(reader, &frames), 0);
+    ASSERT_EQ(frames, capacity);
+    for (chunk = 0, i = 0; i < frames; chunk++) {
+        const hb_u64 *queueUs, *dequeueUs;
+        const hb_u32 *bytes;
+        const hb_s8 *nalu;
+        const hb_u8 *qp, *tid;
+        ASSERT_EQ(hb_mm_telemetry_get_column(reader,
+            MC_TELEMETRY_COLUMN_QUEUE_US, chunk, &data, &num), 0);
+        queueUs = (const hb_u64 *)data;
+        ASSERT_EQ(hb_mm_telemetry_get_column(reader,
+            MC_TELEMETRY_COLUMN_DEQUEUE_US, chunk, &data, &num), 0);
+        dequeueUs = (const hb_u64 *)data;
+        ASSERT_EQ(hb_mm_telemetry_get_column(reader,
+            MC_TELEMETRY_COLUMN_ENC_PIC_BYTE, chunk, &data, &num), 0);
+        bytes = (const hb_u32 *)data;
+        ASSERT_EQ(hb_mm_telemetry_get_column(reader,
+            MC_TELEMETRY_COLUMN_NALU_TYPE, chunk, &data, &num), 0);
+        nalu = (const hb_s8 *)data;
+        ASSERT_EQ(hb_mm_telemetry_get_column(reader,
+            MC_TELEMETRY_COLUMN_AVG_MB_QP, chunk, &data, &num), 0);
+        qp = (const hb_u8 *)data;
+        ASSERT_EQ(hb_mm_telemetry_get_column(reader,
+            MC_TELEMETRY_COLUMN_TEMPORAL_ID, chunk, &data, &num), 0);
+        tid = (const hb_u8 *)data;
+        ASSERT_EQ(num, (hb_u32)std::min<hb_u64>(frames - i,
+            MC_TELEMETRY_CHUNK_FRAMES));
+        for (j = 0; j < num; j++, i++) {
+            EXPECT_EQ(queueUs[j], i * 33333);
+            EXPECT_EQ(dequeueUs[j] - queueUs[j], 5000ULL);
+            EXPECT_EQ(bytes[j], (hb_u32)(1000 + i));
+            EXPECT_EQ(nalu[j], (i % 30) ? MC_H265_NALU_TYPE_P :
+                MC_H265_NALU_TYPE_IDR);
+            EXPECT_EQ(qp[j], (hb_u8)(i % 52));
+            EXPECT_EQ(tid[j], (hb_u8)(i % 4));
+        }
+    }
+    EXPECT_EQ(hb_mm_telemetry_get_column(reader,
+        MC_TELEMETRY_COLUMN_QUEUE_US, chunk, &data, &num),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+    EXPECT_EQ(hb_mm_telemetry_close(reader), 0);
+
+    // 3 chunks of 28 bytes per picture after the 4 KiB header
+    EXPECT_EQ(get_file_size(path),
+        (off_t)(4096 + 3 * MC_TELEMETRY_CHUNK_FRAMES * 28));
+}
+
+// overwrite one 32 bits field of the file header
+static void patch_u32(const char *path, off_t offset, uint32_t value) {
+    int fd = open(path, O_WRONLY);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(pwrite(fd, &value, sizeof(value), offset),
+        (ssize_t)sizeof(value));
+    close(fd);
+}
+
+TEST_F(MediaHostTest, test_telemetry_corrupt_header) {
+    // chunk_size and the width and offset of the last column on disk
+    const off_t chunkSizeAt = 16;
+    const off_t widthAt = 48 + 24 * (MC_TELEMETRY_COLUMN_TOTAL - 1) + 16;
+    const off_t offsetAt = widthAt + 4;
+    char path[512];
+    media_codec_output_buffer_info_t info;
+    mc_telemetry_writer_t *writer = NULL;
+    mc_telemetry_reader_t *reader = NULL;
+    hb_u64 i, frames = 0;
+
+    snprintf(path, sizeof(path), "%s/enc.tlm", mTmpDir);
+    ASSERT_EQ(hb_mm_telemetry_create(path, 100, &writer), 0);
+    memset(&info, 0x00, sizeof(info));
+    for (i = 0; i < 100; i++) {
+        ASSERT_EQ(hb_mm_telemetry_write(writer, &info, i, i), 0);
+    }
+    ASSERT_EQ(hb_mm_telemetry_destroy(writer), 0);
+
+    patch_u32(path, chunkSizeAt, 0);
+    EXPECT_EQ(hb_mm_telemetry_open(path, &reader),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+    patch_u32(path, chunkSizeAt, 28 * MC_TELEMETRY_CHUNK_FRAMES);
+    patch_u32(path, offsetAt, 0xFFFFF000U);
+    EXPECT_EQ(hb_mm_telemetry_open(path, &reader),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+    // the last column runs past the end of the chunk by one picture
+    patch_u32(path, offsetAt, 27 * MC_TELEMETRY_CHUNK_FRAMES + 1);
+    EXPECT_EQ(hb_mm_telemetry_open(path, &reader),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+    patch_u32(path, offsetAt, 27 * MC_TELEMETRY_CHUNK_FRAMES);
+    patch_u32(path, widthAt, 2);
+    EXPECT_EQ(hb_mm_telemetry_open(path, &reader),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+
+    // restored, the file reads again
+    patch_u32(path, widthAt, 1);
+    ASSERT_EQ(hb_mm_telemetry_open(path, &reader), 0);
+    EXPECT_EQ(hb_mm_telemetry_get_frames(reader, &frames), 0);
+    EXPECT_EQ(frames, 100ULL);
+    EXPECT_EQ(hb_mm_telemetry_close(reader), 0);
+}
+
+typedef struct PoolAllocatorContext {
+    int allocs;
+    int frees;
+} PoolAllocatorContext;
+
+static hb_s32 pool_heap_alloc(void *userdata, hb_u32 capacity, hb_u32 align,
+        mc_bufpool_buffer_t *buf) {
+    PoolAllocatorContext *ctx = (PoolAllocatorContext *)userdata;
+    if (posix_memalign((void **)&buf->virt_addr, align, capacity) != 0) {
+        return -1;
+    }
+    buf->phys_addr = (hb_u64)(uintptr_t)buf->virt_addr;
+    ctx->allocs++;
+    return 0;
+}
+
+static void pool_heap_free(void *userdata, mc_bufpool_buffer_t *buf) {
+    PoolAllocatorContext *ctx = (PoolAllocatorContext *)userdata;
+    free(buf->virt_addr);
+    ctx->frees++;
+}
+
+TEST_F(MediaHostTest, test_bufpool_reuse_across_sessions) {
+    const hb_u32 size1088 = 1920 * 1088 * 3 / 2, size1080 = 1920 * 1080 * 3 / 2;
+    const int bufNum = 5;
+    mc_bufpool_params_t params;
+    mc_bufpool_stats_t before, stats;
+    mc_bufpool_buffer_t bufs[bufNum];
+    int i;
+
+    // built-in memfd allocator, shareable fds and aligned physical addresses
+    memset(&params, 0x00, sizeof(params));
+    ASSERT_EQ(hb_mm_bufpool_trim(0), 0);
+    ASSERT_EQ(hb_mm_bufpool_configure(&params), 0);
+    ASSERT_EQ(hb_mm_bufpool_get_stats(&before), 0);
+    ASSERT_EQ(hb_mm_bufpool_prewarm(size1088, 64 * 1024, bufNum), 0);
+    ASSERT_EQ(hb_mm_bufpool_get_stats(&stats), 0);
+    EXPECT_EQ(stats.idle_num, (hb_u32)bufNum);
+    for (i = 0; i < bufNum; i++) {
+        ASSERT_EQ(hb_mm_bufpool_get(size1088, 64 * 1024, &bufs[i]), 0);
+        EXPECT_GE(bufs[i].fd, 0);
+        EXPECT_EQ(bufs[i].phys_addr % (64 * 1024), 0ULL);
+        EXPECT_GE(bufs[i].capacity, size1088);
+        memset(bufs[i].virt_addr, i, size1088);
+    }
+    ASSERT_EQ(hb_mm_bufpool_get_stats(&stats), 0);
+    EXPECT_EQ(stats.hits - before.hits, (hb_u64)bufNum);
+    EXPECT_EQ(stats.misses, before.misses);
+    for (i = 0; i < bufNum; i++) {
+        ASSERT_EQ(hb_mm_bufpool_put(&bufs[i]), 0);
+    }
+
+    // a slightly smaller session lands in the same bucket
+    for (i = 0; i < bufNum; i++) {
+        ASSERT_EQ(hb_mm_bufpool_get(size1080, 64 * 1024, &bufs[i]), 0);
+    }
+    ASSERT_EQ(hb_mm_bufpool_get_stats(&stats), 0);
+    EXPECT_EQ(stats.hits - before.hits, (hb_u64)bufNum * 2);
+    EXPECT_EQ(stats.misses, before.misses);
+    EXPECT_EQ(stats.used_size, (hb_u64)size1080 * bufNum);
+    EXPECT_EQ(stats.fragmentation, (hb_u32)(((stats.used_bytes -
+        stats.used_size) * 1000) / stats.used_bytes));
+    printf("%s %u buffers of %u bytes in %u buckets, fragmentation %u "
+        "permille\n", TAG, stats.used_num, bufs[0].capacity, stats.buckets,
+        stats.fragmentation);
+    for (i = 0; i < bufNum; i++) {
+        ASSERT_EQ(hb_mm_bufpool_put(&bufs[i]), 0);
+    }
+    EXPECT_EQ(hb_mm_bufpool_put(&bufs[0]),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+
+    // the allocator can't change under buffers, then idle bytes are capped
+    PoolAllocatorContext allocCtx;
+    memset(&allocCtx, 0x00, sizeof(allocCtx));
+    params.allocator.alloc = pool_heap_alloc;
+    params.allocator.free = pool_heap_free;
+    params.allocator.userdata = &allocCtx;
+    params.max_idle_bytes = 2 * 1024 * 1024;
+    EXPECT_EQ(hb_mm_bufpool_configure(&params),
+        (int32_t)HB_MEDIA_ERR_OPERATION_NOT_ALLOWED);
+    ASSERT_EQ(hb_mm_bufpool_trim(0), 0);
+    ASSERT_EQ(hb_mm_bufpool_configure(&params), 0);
+    for (i = 0; i < bufNum; i++) {
+        ASSERT_EQ(hb_mm_bufpool_get(512 * 1024, 4096, &bufs[i]), 0);
+    }
+    for (i = 0; i < bufNum; i++) {
+        ASSERT_EQ(hb_mm_bufpool_put(&bufs[i]), 0);
+    }
+    ASSERT_EQ(hb_mm_bufpool_get_stats(&stats), 0);
+    EXPECT_EQ(allocCtx.allocs, bufNum);
+    EXPECT_EQ(allocCtx.frees, 1);
+    EXPECT_EQ(stats.idle_bytes, 2ULL * 1024 * 1024);
+    EXPECT_EQ(stats.fragmentation, 1000U);
+    ASSERT_EQ(hb_mm_bufpool_trim(0), 0);
+    EXPECT_EQ(allocCtx.frees, bufNum);
+
+    memset(&params, 0x00, sizeof(params));
+    EXPECT_EQ(hb_mm_bufpool_configure(&params), 0);
+}
+
+TEST_F(MediaHostTest, test_session_reuse_by_shape) {
+    media_codec_context_t tmpl, other;
+    media_codec_context_t *ctx[3];
+    mc_session_params_t params;
+    mc_session_manager_t *mgr = NULL;
+    mc_session_stats_t stats;
+    FakeCodecCalls calls;
+    int i;
+
+    memset(&tmpl, 0x00, sizeof(tmpl));
+    tmpl.codec_id = MEDIA_CODEC_ID_H265;
+    tmpl.encoder = 1;
+    tmpl.video_enc_params.width = 1920;
+    tmpl.video_enc_params.height = 1080;
+    tmpl.video_enc_params.pix_fmt = MC_PIXEL_FORMAT_NV12;
+    tmpl.video_enc_params.frame_buf_count = 5;
+    tmpl.video_enc_params.bitstream_buf_count = 5;
+    tmpl.video_enc_params.rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    tmpl.video_enc_params.rc_params.h265_cbr_params.bit_rate = 4000;
+    gFakeCodecCalls = FakeCodecCalls();
+    gFakeCodecCalls.setupUs = 2000;
+
+    memset(&params, 0x00, sizeof(params));
+    params.max_idle = 2;
+    ASSERT_EQ(hb_mm_session_create(&params, &mgr), 0);
+    ASSERT_EQ(hb_mm_session_prewarm(mgr, &tmpl, 2), 0);
+    EXPECT_EQ(gFakeCodecCalls.initialize, 2);
+
+    // two ready instances, the third stream of the shape starts cold
+    for (i = 0; i < 3; i++) {
+        ASSERT_EQ(hb_mm_session_acquire(mgr, &tmpl, &ctx[i]), 0);
+        ASSERT_EQ(hb_mm_mc_start(ctx[i], NULL), 0);
+        ASSERT_EQ(hb_mm_session_first_frame(mgr, ctx[i]), 0);
+    }
+    ASSERT_EQ(hb_mm_session_get_stats(mgr, &stats), 0);
+    EXPECT_EQ(stats.ready, 2ULL);
+    EXPECT_EQ(stats.cold, 1ULL);
+    EXPECT_EQ(stats.used_num, 3U);
+    EXPECT_EQ(hb_mm_session_destroy(mgr),
+        (int32_t)HB_MEDIA_ERR_OPERATION_NOT_ALLOWED);
+
+    // only max_idle come back, they are stopped and configured again
+    calls = gFakeCodecCalls;
+    for (i = 0; i < 3; i++) {
+        ASSERT_EQ(hb_mm_session_release(mgr, ctx[i]), 0);
+    }
+    EXPECT_EQ(hb_mm_session_release(mgr, ctx[0]),
+        (int32_t)HB_MEDIA_ERR_INVALID_INSTANCE);
+    EXPECT_EQ(gFakeCodecCalls.stop - calls.stop, 2);
+    EXPECT_EQ(gFakeCodecCalls.configure - calls.configure, 2);
+    EXPECT_EQ(gFakeCodecCalls.release - calls.release, 1);
+
+    // same shape with another bit rate is configured, not initialized
+    calls = gFakeCodecCalls;
+    other = tmpl;
+    other.video_enc_params.rc_params.h265_cbr_params.bit_rate = 2000;
+    ASSERT_EQ(hb_mm_session_acquire(mgr, &other, &ctx[0]), 0);
+    EXPECT_EQ(ctx[0]->video_enc_params.rc_params.h265_cbr_params.bit_rate,
+        2000U);
+    ASSERT_EQ(hb_mm_session_acquire(mgr, &tmpl, &ctx[1]), 0);
+    EXPECT_EQ(gFakeCodecCalls.initialize, calls.initialize);
+    EXPECT_EQ(gFakeCodecCalls.configure - calls.configure, 1);
+    for (i = 0; i < 2; i++) {
+        ASSERT_EQ(hb_mm_mc_start(ctx[i], NULL), 0);
+        ASSERT_EQ(hb_mm_session_first_frame(mgr, ctx[i]), 0);
+        ASSERT_EQ(hb_mm_session_release(mgr, ctx[i]), 0);
+    }
+
+    ASSERT_EQ(hb_mm_session_get_stats(mgr, &stats), 0);
+    EXPECT_EQ(stats.ready, 3ULL);
+    EXPECT_EQ(stats.reconfigured, 1ULL);
+    EXPECT_EQ(stats.evicted, 1ULL);
+    EXPECT_EQ(stats.idle_num, 2U);
+    ASSERT_EQ(stats.ready_ttff_num, 3ULL);
+    ASSERT_EQ(stats.cold_ttff_num, 2ULL);
+    printf("%s time to first frame %llu us ready, %llu us cold\n", TAG,
+        (unsigned long long)(stats.ready_ttff_us / stats.ready_ttff_num),
+        (unsigned long long)(stats.cold_ttff_us / stats.cold_ttff_num));
+    EXPECT_LT(stats.ready_ttff_us / stats.ready_ttff_num,
+        stats.cold_ttff_us / stats.cold_ttff_num);
+    ASSERT_EQ(hb_mm_session_destroy(mgr), 0);
+    EXPECT_EQ(gFakeCodecCalls.release, gFakeCodecCalls.initialize);
+}
+
+static void expect_same_snapshot(const mc_config_snapshot_t *a,
+        const mc_config_snapshot_t *b) {
+    EXPECT_EQ(a->codec_id, b->codec_id);
+    EXPECT_EQ(a->sections, b->sections);
+    EXPECT_EQ(memcmp(&a->enc_params, &b->enc_params, sizeof(a->enc_params)),
+        0);
+    EXPECT_EQ(memcmp(&a->longterm_ref, &b->longterm_ref,
+        sizeof(a->longterm_ref)), 0);
+    EXPECT_EQ(memcmp(&a->deblk_filter, &b->deblk_filter,
+        sizeof(a->deblk_filter)), 0);
+    EXPECT_EQ(memcmp(&a->vui, &b->vui, sizeof(a->vui)), 0);
+    EXPECT_EQ(a->max_bit_rate, b->max_bit_rate);
+    EXPECT_EQ(a->explicit_header, b->explicit_header);
+    EXPECT_EQ(a->roi.roi_enable, b->roi.roi_enable);
+    ASSERT_EQ(a->roi.roi_map_array_count, b->roi.roi_map_array_count);
+    EXPECT_EQ(memcmp(a->roi.roi_map_array, b->roi.roi_map_array,
+        a->roi.roi_map_array_count), 0);
+}
+
+TEST_F(MediaHostTest, test_config_snapshot_round_trip) {
+    char binPath[512], textPath[512];
+    media_codec_context_t context, fresh;
+    mc_config_snapshot_t snap, loaded;
+    mc_video_longterm_ref_mode_t ltr = {1, 30, 4};
+    mc_video_deblk_filter_params_t deblk;
+    mc_video_roi_params_t roi;
+    hb_u8 roiMap[120];
+    media_codec_state_t state;
+    FakeCodecCalls calls;
+    hb_s32 header = 1;
+    FILE *file;
+    hb_u32 i;
+
+    memset(&context, 0x00, sizeof(context));
+    context.codec_id = MEDIA_CODEC_ID_H265;
+    context.encoder = 1;
+    context.video_enc_params.width = 1920;
+    context.video_enc_params.height = 1080;
+    context.video_enc_params.pix_fmt = MC_PIXEL_FORMAT_NV12;
+    context.video_enc_params.frame_buf_count = 5;
+    context.video_enc_params.bitstream_buf_count = 5;
+    context.video_enc_params.rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    context.video_enc_params.rc_params.h265_cbr_params.bit_rate = 8000;
+    context.video_enc_params.rc_params.h265_cbr_params.frame_rate = 30;
+    context.video_enc_params.rc_params.h265_cbr_params.vbv_buffer_size = 3000;
+    context.video_enc_params.rc_params.h265_cbr_params.hvs_qp_scale = -2;
+    context.video_enc_params.gop_params.gop_preset_idx = 2;
+    gFakeEncoders[0] = FakeEncoder();
+    gFakeEncoders[0].context = &context;
+    ASSERT_EQ(hb_mm_mc_initialize(&context), 0);
+    memset(&deblk, 0x5a, sizeof(deblk));
+    for (i = 0; i < sizeof(roiMap); i++) {
+        roiMap[i] = (hb_u8)(i % 52);
+    }
+    roi.roi_enable = 1;
+    roi.roi_map_array = roiMap;
+    roi.roi_map_array_count = sizeof(roiMap);
+    ASSERT_EQ(hb_mm_mc_set_longterm_ref_mode(&context, &ltr), 0);
+    ASSERT_EQ(hb_mm_mc_set_deblk_filter_config(&context, &deblk), 0);
+    ASSERT_EQ(hb_mm_mc_set_roi_config(&context, &roi), 0);
+    ASSERT_EQ(hb_mm_mc_set_explicit_header_config(&context, header), 0);
+    ASSERT_EQ(hb_mm_mc_set_max_bit_rate_config(&context, 12000), 0);
+
+    // H264 only sections are left out of an H265 snapshot
+    ASSERT_EQ(hb_mm_config_capture(&context, MC_CONFIG_SECTION_ALL, &snap), 0);
+    EXPECT_EQ(snap.sections & MC_CONFIG_SECTION_BIT(MC_CONFIG_SECTION_ENTROPY),
+        0U);
+    EXPECT_NE(snap.sections & MC_CONFIG_SECTION_BIT(MC_CONFIG_SECTION_SAO), 0U);
+    EXPECT_EQ(snap.max_bit_rate, 12000U);
+    ASSERT_NE(snap.roi.roi_map_array, roiMap);
+    EXPECT_EQ(memcmp(snap.roi.roi_map_array, roiMap, sizeof(roiMap)), 0);
+
+    snprintf(binPath, sizeof(binPath), "%s/enc.cfg", mTmpDir);
+    snprintf(textPath, sizeof(textPath), "%s/enc.txt", mTmpDir);
+    ASSERT_EQ(hb_mm_config_save(binPath, &snap, MC_CONFIG_FORMAT_BINARY), 0);
+    ASSERT_EQ(hb_mm_config_load(binPath, &loaded), 0);
+    expect_same_snapshot(&snap, &loaded);
+    ASSERT_EQ(hb_mm_config_release(&loaded), 0);
+    ASSERT_EQ(hb_mm_config_save(textPath, &snap, MC_CONFIG_FORMAT_TEXT), 0);
+    ASSERT_EQ(hb_mm_config_load(textPath, &loaded), 0);
+    expect_same_snapshot(&snap, &loaded);
+    ASSERT_EQ(hb_mm_config_release(&loaded), 0);
+
+    // a named value edited by hand overrides the hex section
+    file = fopen(textPath, "a");
+    ASSERT_NE(file, nullptr);
+    fprintf(file, "\n# lower bit rate\n  rc.h265_cbr.bit_rate = 4000\r\n");
+    fprintf(file, "rc.h265_cbr.hvs_qp_scale = -4\n");
+    fclose(file);
+    ASSERT_EQ(hb_mm_config_load(textPath, &loaded), 0);
+    EXPECT_EQ(loaded.enc_params.rc_params.h265_cbr_params.bit_rate, 4000U);
+    EXPECT_EQ(loaded.enc_params.rc_params.h265_cbr_params.hvs_qp_scale, -4);
+    EXPECT_EQ(loaded.enc_params.rc_params.h265_cbr_params.vbv_buffer_size,
+        3000);
+    ASSERT_EQ(hb_mm_config_release(&loaded), 0);
+    file = fopen(textPath, "a");
+    ASSERT_NE(file, nullptr);
+    fprintf(file, "rc.h264_cbr.bit_rate = 4000\n");
+    fclose(file);
+    EXPECT_EQ(hb_mm_config_load(textPath, &loaded),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+
+    // a flipped bit of the binary file is caught
+    file = fopen(binPath, "r+b");
+    ASSERT_NE(file, nullptr);
+    fseek(file, 100, SEEK_SET);
+    i = (hb_u32)fgetc(file);
+    fseek(file, 100, SEEK_SET);
+    fputc((int)(i ^ 0x01), file);
+    fclose(file);
+    EXPECT_EQ(hb_mm_config_load(binPath, &loaded),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+
+    // one call sets up another encoder ready to start
+    ASSERT_EQ(hb_mm_config_save(binPath, &snap, MC_CONFIG_FORMAT_BINARY), 0);
+    ASSERT_EQ(hb_mm_config_load(binPath, &loaded), 0);
+    memset(&fresh, 0x00, sizeof(fresh));
+    gFakeEncoders[1] = FakeEncoder();
+    gFakeEncoders[1].context = &fresh;
+    calls = gFakeCodecCalls;
+    ASSERT_EQ(hb_mm_config_apply(&fresh, &loaded), 0);
+    ASSERT_EQ(hb_mm_mc_get_state(&fresh, &state), 0);
+    EXPECT_EQ(state, MEDIA_CODEC_STATE_CONFIGURED);
+    EXPECT_EQ(gFakeCodecCalls.initialize - calls.initialize, 1);
+    EXPECT_EQ(gFakeCodecCalls.configure - calls.configure, 1);
+    // every side section but the max bit rate, which isn't counted
+    EXPECT_EQ(gFakeCodecCalls.sideConfig - calls.sideConfig,
+        __builtin_popcount(loaded.sections) - 2);
+    EXPECT_EQ(gFakeEncoders[1].maxBitRate, 12000U);
+    EXPECT_EQ(memcmp(&fresh.video_enc_params, &context.video_enc_params,
+        sizeof(fresh.video_enc_params)), 0);
+    memset(&ltr, 0x00, sizeof(ltr));
+    ASSERT_EQ(hb_mm_mc_get_longterm_ref_mode(&fresh, &ltr), 0);
+    EXPECT_EQ(ltr.longterm_pic_period, 30U);
+    EXPECT_EQ(hb_mm_config_apply(&fresh, &loaded),
+        (int32_t)HB_MEDIA_ERR_OPERATION_NOT_ALLOWED);
+    ASSERT_EQ(hb_mm_config_release(&loaded), 0);
+    ASSERT_EQ(hb_mm_config_release(&snap), 0);
+    ASSERT_EQ(hb_mm_mc_release(&fresh), 0);
+    ASSERT_EQ(hb_mm_mc_release(&context), 0);
+}
+
+TEST_F(MediaHostTest, test_startup_stages) {
+    const hb_s32 width = 64, height = 32;
+    const size_t frameSize = width * height * 3 / 2;
+    char inputPath[512], configPath[512];
+    std::vector<uint8_t> input(frameSize * 2);
+    media_codec_context_t context;
+    mc_config_snapshot_t snap;
+    mc_startup_params_t params;
+    mc_startup_stats_t stats;
+    media_codec_buffer_t output;
+    media_codec_output_buffer_info_t outputInfo;
+    mc_bufpool_stats_t pool;
+    media_codec_state_t state;
+    FakeEncoder *fake = &gFakeEncoders[0];
+    hb_s32 fd, early;
+    FILE *file;
+    size_t i;
+
+    for (i = 0; i < input.size(); i++) {
+        input[i] = (uint8_t)(i * 7);
+    }
+    snprintf(inputPath, sizeof(inputPath), "%s/input.yuv", mTmpDir);
+    file = fopen(inputPath, "wb");
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(fwrite(input.data(), 1, input.size(), file), input.size());
+    fclose(file);
+    memset(&snap, 0x00, sizeof(snap));
+    snap.codec_id = MEDIA_CODEC_ID_H265;
+    snap.enc_params.width = width;
+    snap.enc_params.height = height;
+    snap.enc_params.pix_fmt = MC_PIXEL_FORMAT_NV12;
+    snap.enc_params.rc_params.mode = MC_AV_RC_MODE_H265CBR;
+    snap.enc_params.rc_params.h265_cbr_params.bit_rate = 1000;
+    snprintf(configPath, sizeof(configPath), "%s/enc.cfg", mTmpDir);
+    ASSERT_EQ(hb_mm_config_save(configPath, &snap, MC_CONFIG_FORMAT_BINARY),
+        0);
+
+    memset(&params, 0x00, sizeof(params));
+    params.config_file = configPath;
+    params.input_file = inputPath;
+    params.prewarm_size = frameSize;
+    params.prewarm_align = 4096;
+    params.prewarm_num = 3;
+    params.timeout = 100;
+    gFakeCodecCalls.setupUs = 1000;
+    ASSERT_EQ(hb_mm_bufpool_trim(0), 0);
+    for (early = 0; early < 2; early++) {
+        // early start initializes with the codec known up front
+        memset(&context, 0x00, sizeof(context));
+        context.codec_id = early ? MEDIA_CODEC_ID_H265 : MEDIA_CODEC_ID_NONE;
+        context.encoder = early;
+        *fake = FakeEncoder();
+        fake->context = &context;
+        params.early_start = early;
+        ASSERT_EQ(hb_mm_startup_run(&context, &params, &fd, &output,
+            &outputInfo, &stats), 0);
+
+        // started with the first picture of the file encoded
+        ASSERT_EQ(hb_mm_mc_get_state(&context, &state), 0);
+        EXPECT_EQ(state, MEDIA_CODEC_STATE_STARTED);
+        EXPECT_EQ(context.video_enc_params.rc_params.h265_cbr_params.bit_rate,
+            1000U);
+        ASSERT_EQ(fake->frame.size(), frameSize);
+        EXPECT_TRUE(std::equal(fake->frame.begin(), fake->frame.end(),
+            input.begin()));
+        EXPECT_EQ(fake->pts.size(), 1U);
+        EXPECT_EQ(fake->outputs, 1U);
+        // the first picture is left to the caller to write and give back
+        EXPECT_EQ(fake->outputReturns, 0U);
+        EXPECT_FALSE(output.vstream_buf.stream_end);
+        EXPECT_EQ(output.vstream_buf.vir_ptr, fake->stream.data());
+        EXPECT_EQ(output.vstream_buf.size, (hb_u32)fake->stream.size());
+        EXPECT_EQ(outputInfo.video_stream_info.enc_pic_byte,
+            (hb_u32)fake->stream.size());
+        ASSERT_EQ(hb_mm_mc_queue_output_buffer(&context, &output, 100), 0);
+        EXPECT_EQ(fake->outputReturns, 1U);
+        ASSERT_GE(fd, 0);
+        EXPECT_EQ(lseek(fd, 0, SEEK_CUR), (off_t)frameSize);
+        close(fd);
+        ASSERT_EQ(hb_mm_bufpool_get_stats(&pool), 0);
+        EXPECT_EQ(pool.idle_num, params.prewarm_num);
+
+        EXPECT_GE(stats.initialize_us, 1000ULL);
+        EXPECT_GE(stats.configure_us, 1000ULL);
+        EXPECT_EQ(stats.total_us, stats.prepare_us + stats.initialize_us +
+            stats.configure_us + stats.start_us + stats.first_input_us +
+            stats.first_output_us);
+        printf("%s %s start: prepare %llu, initialize %llu, configure %llu, "
+            "start %llu, first input %llu, first output %llu, total %llu us\n",
+            TAG, early ? "early" : "serial",
+            (unsigned long long)stats.prepare_us,
+            (unsigned long long)stats.initialize_us,
+            (unsigned long long)stats.configure_us,
+            (unsigned long long)stats.start_us,
+            (unsigned long long)stats.first_input_us,
+            (unsigned long long)stats.first_output_us,
+            (unsigned long long)stats.total_us);
+        ASSERT_EQ(hb_mm_mc_stop(&context), 0);
+        ASSERT_EQ(hb_mm_mc_release(&context), 0);
+    }
+
+    // a failed stage leaves nothing behind
+    params.input_file = "/nonexistent/input.yuv";
+    memset(&context, 0x00, sizeof(context));
+    fake->context = &context;
+    params.early_start = 1;
+    context.codec_id = MEDIA_CODEC_ID_H265;
+    context.encoder = 1;
+    EXPECT_EQ(hb_mm_startup_run(&context, &params, &fd, &output,
+        &outputInfo, &stats), (int32_t)HB_MEDIA_ERR_FILE_OPERATION_FAILURE);
+    EXPECT_EQ(fd, -1);
+    ASSERT_EQ(hb_mm_mc_get_state(&context, &state), 0);
+    EXPECT_EQ(state, MEDIA_CODEC_STATE_UNINITIALIZED);
+    gFakeCodecCalls.setupUs = 0;
+    ASSERT_EQ(hb_mm_bufpool_trim(0), 0);
+}
+
+#define LOG_THREADS 4
+#define LOG_RECORDS 100
+
+static void *log_writer(void *arg) {
+    int id = (int)(intptr_t)arg, i;
+    for (i = 0; i < LOG_RECORDS; i++) {
+        HB_MM_LOG(MC_LOG_LEVEL_INFO, "writer %d record %d %s\n", id, i,
+            (i & 1) ? "odd" : "even");
+    }
+    return NULL;
+}
+
+static std::string read_file(const char *path) {
+    std::string text;
+    char buf[4096];
+    size_t n;
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return text;
+    }
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
+        text.append(buf, n);
+    }
+    fclose(file);
+    return text;
+}
+
+TEST_F(MediaHostTest, test_log_ring_flush) {
+    pthread_t threads[LOG_THREADS];
+    mc_log_params_t params, defaults;
+    mc_log_stats_t before, after;
+    char path[512], expect[64];
+    int next[LOG_THREADS] = {0};
+    int fd, id, record, i;
+    char word[8];
+    std::string text, line;
+    size_t pos, end;
+    char scratch[8] = "scratch";
+
+    snprintf(path, sizeof(path), "%s/log.txt", mTmpDir);
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    ASSERT_GE(fd, 0);
+    memset(&params, 0x00, sizeof(params));
+    params.level_mask = MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_INFO) |
+        MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_WARN) |
+        MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_ERR);
+    params.fd = fd;
+    params.ring_size = 65536;
+    params.flush_interval_ms = 10;
+    defaults = params;
+    defaults.level_mask = MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_WARN) |
+        MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_ERR);
+    defaults.fd = 2;
+    params.ring_size = 1000;
+    EXPECT_EQ(hb_mm_log_configure(&params),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+    params.ring_size = 65536;
+    ASSERT_EQ(hb_mm_log_configure(&params), 0);
+    ASSERT_EQ(hb_mm_log_get_stats(&before), 0);
+
+    // records of each thread come out whole and in order
+    for (i = 0; i < LOG_THREADS; i++) {
+        ASSERT_EQ(pthread_create(&threads[i], NULL, log_writer,
+            (void *)(intptr_t)i), 0);
+    }
+    for (i = 0; i < LOG_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    // strings are copied at the call, not read at the flush
+    HB_MM_LOG(MC_LOG_LEVEL_INFO, "copy %s|%5.2f|%x|%*d|%%|%lu\n", scratch,
+        2.5, 255U, 4, 7, (unsigned long)42);
+    strcpy(scratch, "changed");
+    HB_MM_LOG(MC_LOG_LEVEL_TRACE, "masked %d\n", 1);
+    ASSERT_EQ(hb_mm_log_flush(), 0);
+    ASSERT_EQ(hb_mm_log_get_stats(&after), 0);
+    EXPECT_EQ(after.written - before.written,
+        (hb_u64)(LOG_THREADS * LOG_RECORDS + 1));
+    EXPECT_EQ(after.dropped, before.dropped);
+    EXPECT_GE(after.flushed - before.flushed,
+        (hb_u64)(LOG_THREADS * LOG_RECORDS + 1));
+    EXPECT_GE(after.rings, (hb_u32)1);
+
+    text = read_file(path);
+    for (pos = 0; (end = text.find('\n', pos)) != std::string::npos;
+        pos = end + 1) {
+        line = text.substr(pos, end - pos);
+        if (sscanf(line.c_str(), "writer %d record %d %7s", &id, &record,
+            word) != 3) {
+            continue;
+        }
+        ASSERT_GE(id, 0);
+        ASSERT_LT(id, LOG_THREADS);
+        EXPECT_EQ(record, next[id]);
+        EXPECT_STREQ(word, (record & 1) ? "odd" : "even");
+        next[id] = record + 1;
+    }
+    for (i = 0; i < LOG_THREADS; i++) {
+        EXPECT_EQ(next[i], LOG_RECORDS);
+    }
+    EXPECT_NE(text.find("copy scratch| 2.50|ff|   7|%|42\n"),
+        std::string::npos);
+    EXPECT_EQ(text.find("masked"), std::string::npos);
+
+    // over the limit of a site within a second only the count goes out
+    params.rate_limit = 3;
+    ASSERT_EQ(hb_mm_log_configure(&params), 0);
+    ASSERT_EQ(hb_mm_log_get_stats(&before), 0);
+    for (i = 0; i <= 10; i++) {
+        if (i == 10) {
+            ASSERT_EQ(hb_mm_log_get_stats(&after), 0);
+            EXPECT_GE(after.limited - before.limited, (hb_u64)1);
+            sleep(1);
+        }
+        HB_MM_LOG(MC_LOG_LEVEL_WARN, "limited %d\n", i);
+    }
+    ASSERT_EQ(hb_mm_log_flush(), 0);
+    text = read_file(path);
+    snprintf(expect, sizeof(expect), "%llu records suppressed",
+        (unsigned long long)(after.limited - before.limited));
+    EXPECT_NE(text.find(expect), std::string::npos);
+    EXPECT_NE(text.find("limited 10\n"), std::string::npos);
+
+    ASSERT_EQ(hb_mm_log_configure(&defaults), 0);
+    close(fd);
+}
+
+static void digest_frames(mc_digest_t *digest,
+        const std::vector<uint8_t> &stream, const size_t *sizes, int num) {
+    size_t offset = 0, part;
+    int i;
+    for (i = 0; i < num; i++) {
+        // every frame comes in three parts, as slices would
+        part = sizes[i] / 3;
+        ASSERT_EQ(hb_mm_digest_update(digest, stream.data() + offset, part),
+            0);
+        ASSERT_EQ(hb_mm_digest_update(digest, stream.data() + offset + part,
+            part), 0);
+        ASSERT_EQ(hb_mm_digest_update(digest,
+            stream.data() + offset + 2 * part, sizes[i] - 2 * part), 0);
+        offset += sizes[i];
+        EXPECT_GE(hb_mm_digest_end_frame(digest, NULL), 0);
+    }
+}
+
+TEST_F(MediaHostTest, test_digest_golden_frames) {
+    const size_t sizes[] = {3, 240, 241, 4096, 100000, 1025};
+    const int num = sizeof(sizes) / sizeof(sizes[0]);
+    std::vector<uint8_t> stream;
+    mc_digest_params_t params;
+    mc_digest_result_t result;
+    mc_digest_frame_t frame;
+    mc_digest_t *digest = NULL;
+    char goldenPath[512];
+    hb_u8 md5[MC_DIGEST_MD5_SIZE];
+    const hb_u8 abc[] = {'a', 'b', 'c'};
+    const hb_u8 md5Abc[MC_DIGEST_MD5_SIZE] = {0x90, 0x01, 0x50, 0x98, 0x3c,
+        0xd2, 0x4f, 0xb0, 0xd6, 0x96, 0x3f, 0x7d, 0x28, 0xe1, 0x7f, 0x72};
+    size_t i, total = 0;
+
+    // reference values of both hashes
+    hb_mm_digest_md5(abc, sizeof(abc), md5);
+    EXPECT_EQ(memcmp(md5, md5Abc, sizeof(md5)), 0);
+    EXPECT_EQ(hb_mm_digest_xxh3(NULL, 0), 0x2d06800538d394c2ULL);
+    EXPECT_EQ(hb_mm_digest_xxh3(abc, sizeof(abc)), 0x78af5f94892f3950ULL);
+    for (i = 0; i < 100000; i++) {
+        stream.push_back((uint8_t)(i * 7));
+    }
+    EXPECT_EQ(hb_mm_digest_xxh3(stream.data(), 100000), 0x01271d2740e5fca3ULL);
+
+    // the streamed digest of a frame matches the one shot hashes
+    memset(&params, 0x00, sizeof(params));
+    params.algos = MC_DIGEST_ALGO_BIT(MC_DIGEST_ALGO_MD5) |
+        MC_DIGEST_ALGO_BIT(MC_DIGEST_ALGO_XXH3);
+    ASSERT_EQ(hb_mm_digest_create(&params, &digest), 0);
+    ASSERT_EQ(hb_mm_digest_update(digest, stream.data(), 5000), 0);
+    ASSERT_EQ(hb_mm_digest_update(digest, stream.data() + 5000, 95000), 0);
+    ASSERT_EQ(hb_mm_digest_end_frame(digest, &frame), 0);
+    hb_mm_digest_md5(stream.data(), 100000, md5);
+    EXPECT_EQ(memcmp(frame.md5, md5, sizeof(md5)), 0);
+    EXPECT_EQ(frame.xxh3, 0x01271d2740e5fca3ULL);
+    EXPECT_EQ(hb_mm_digest_destroy(digest), 0);
+
+    // record the golden file, then verify the same frames against it
+    for (i = 0; i < (size_t)num; i++) {
+        total += sizes[i];
+    }
+    stream.resize(total);
+    for (i = 0; i < total; i++) {
+        stream[i] = (uint8_t)(i * 131 + (i >> 8));
+    }
+    snprintf(goldenPath, sizeof(goldenPath), "%s/golden.digest", mTmpDir);
+    params.record_file = goldenPath;
+    ASSERT_EQ(hb_mm_digest_create(&params, &digest), 0);
+    digest_frames(digest, stream, sizes, num);
+    ASSERT_EQ(hb_mm_digest_destroy(digest), 0);
+    params.record_file = NULL;
+    params.golden_file = goldenPath;
+    ASSERT_EQ(hb_mm_digest_create(&params, &digest), 0);
+    digest_frames(digest, stream, sizes, num);
+    ASSERT_EQ(hb_mm_digest_get_result(digest, &result), 0);
+    EXPECT_EQ(result.frames, (hb_u32)num);
+    EXPECT_EQ(result.golden_frames, (hb_u32)num);
+    EXPECT_EQ(result.mismatched, 0U);
+    EXPECT_EQ(result.first_mismatch, -1);
+    EXPECT_EQ(hb_mm_digest_end_frame(digest, NULL),
+        (int32_t)HB_MEDIA_ERR_OPERATION_NOT_ALLOWED);
+    ASSERT_EQ(hb_mm_digest_destroy(digest), 0);
+
+    // a bad byte points at its frame, xxh3 alone still verifies
+    stream[sizes[0] + sizes[1] + sizes[2] + 100] ^= 1;
+    params.algos = MC_DIGEST_ALGO_BIT(MC_DIGEST_ALGO_XXH3);
+    ASSERT_EQ(hb_mm_digest_create(&params, &digest), 0);
+    digest_frames(digest, stream, sizes, num);
+    ASSERT_EQ(hb_mm_digest_get_result(digest, &result), 0);
+    EXPECT_EQ(result.mismatched, 1U);
+    EXPECT_EQ(result.first_mismatch, 3);
+    ASSERT_EQ(hb_mm_digest_destroy(digest), 0);
+
+    // missing frames at the end count as mismatched
+    ASSERT_EQ(hb_mm_digest_create(&params, &digest), 0);
+    digest_frames(digest, stream, sizes, 2);
+    ASSERT_EQ(hb_mm_digest_get_result(digest, &result), 0);
+    EXPECT_EQ(result.frames, 2U);
+    EXPECT_EQ(result.golden_frames, (hb_u32)num);
+    EXPECT_EQ(result.mismatched, (hb_u32)(num - 2));
+    EXPECT_EQ(result.first_mismatch, 2);
+    ASSERT_EQ(hb_mm_digest_destroy(digest), 0);
+}
+
+static void synth_frame(const mc_synth_params_t *params, hb_u32 index,
+        mc_pixel_format_t fmt, int width, int height, int stride,
+        std::vector<uint8_t> &buf) {
+    mc_video_frame_buffer_info_t frame;
+
+    buf.assign(stride * height * 2, 0x00);
+    memset(&frame, 0x00, sizeof(frame));
+    frame.vir_ptr[0] = buf.data();
+    frame.width = width;
+    frame.height = height;
+    frame.stride = stride;
+    frame.pix_fmt = fmt;
+    ASSERT_EQ(hb_mm_synth_fill(params, index, &frame), 0);
+}
+
+static int count_diff(const std::vector<uint8_t> &a,
+        const std::vector<uint8_t> &b) {
+    size_t i;
+    int diff = 0;
+
+    for (i = 0; i < a.size(); i++) {
+        diff += (a[i] != b[i]);
+    }
+    return diff;
+}
+
+TEST_F(MediaHostTest, test_synth_deterministic) {
+    const int width = 203, height = 37, stride = 256;
+    const hb_u32 cuts[] = {0, 5};
+    mc_simd_isa_t isas[] = {MC_SIMD_ISA_SSE2, MC_SIMD_ISA_AVX2,
+        MC_SIMD_ISA_NEON};
+    mc_pixel_format_t fmts[] = {MC_PIXEL_FORMAT_YUV420P,
+        MC_PIXEL_FORMAT_NV12, MC_PIXEL_FORMAT_NV21};
+    std::vector<uint8_t> ref, out, next;
+    mc_synth_params_t params;
+    mc_video_frame_buffer_info_t frame;
+    int i, f;
+
+    memset(&params, 0x00, sizeof(params));
+    params.seed = 7;
+    params.block_num = 3;
+    params.block_size = 16;
+    params.motion = 5;
+    params.noise = 6;
+    params.scene_cuts = cuts;
+    params.scene_cut_num = sizeof(cuts) / sizeof(cuts[0]);
+
+    // every instruction set draws the same bytes as the C kernels
+    for (f = 0; f < (int)(sizeof(fmts) / sizeof(fmts[0])); f++) {
+        hb_mm_simd_set_isa(MC_SIMD_ISA_C);
+        synth_frame(&params, 3, fmts[f], width, height, stride, ref);
+        for (i = 0; i < (int)(sizeof(isas) / sizeof(isas[0])); i++) {
+            hb_mm_simd_set_isa(isas[i]);
+            synth_frame(&params, 3, fmts[f], width, height, stride, out);
+            EXPECT_EQ(count_diff(ref, out), 0) << "fmt " << fmts[f] << " "
+                << hb_mm_simd_isa_name(hb_mm_simd_get_isa());
+        }
+    }
+    hb_mm_simd_set_isa(MC_SIMD_ISA_NONE);
+
+    // the same frame repeats, the next one moves a little
+    synth_frame(&params, 3, MC_PIXEL_FORMAT_NV12, width, height, stride, ref);
+    synth_frame(&params, 3, MC_PIXEL_FORMAT_NV12, width, height, stride, out);
+    EXPECT_EQ(count_diff(ref, out), 0);
+    synth_frame(&params, 4, MC_PIXEL_FORMAT_NV12, width, height, stride, next);
+    EXPECT_GT(count_diff(ref, next), 0);
+
+    // NV21 swaps the chroma bytes of NV12
+    synth_frame(&params, 3, MC_PIXEL_FORMAT_NV21, width, height, stride, out);
+    EXPECT_EQ(memcmp(ref.data(), out.data(), stride * height), 0);
+    EXPECT_EQ(ref[stride * height], out[stride * height + 1]);
+    EXPECT_EQ(ref[stride * height + 1], out[stride * height]);
+
+    // without noise and motion consecutive frames of a scene are equal,
+    // a scene cut changes the whole picture
+    params.noise = 0;
+    params.motion = 0;
+    synth_frame(&params, 3, MC_PIXEL_FORMAT_NV12, width, height, stride, ref);
+    synth_frame(&params, 4, MC_PIXEL_FORMAT_NV12, width, height, stride, out);
+    EXPECT_EQ(count_diff(ref, out), 0);
+    synth_frame(&params, 5, MC_PIXEL_FORMAT_NV12, width, height, stride, next);
+    EXPECT_GT(count_diff(ref, next), width * height / 2);
+
+    // the padding of the strides is left alone
+    for (i = 0; i < height; i++) {
+        EXPECT_EQ(ref[i * stride + width], 0x00);
+    }
+
+    memset(&frame, 0x00, sizeof(frame));
+    frame.vir_ptr[0] = ref.data();
+    frame.width = width;
+    frame.height = height;
+    frame.pix_fmt = MC_PIXEL_FORMAT_YUV422P;
+    EXPECT_EQ(hb_mm_synth_fill(&params, 0, &frame),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+    frame.pix_fmt = MC_PIXEL_FORMAT_NV12;
+    params.block_size = 0;
+    EXPECT_EQ(hb_mm_synth_fill(&params, 0, &frame),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+    params.block_size = 16;
+    params.noise = MC_SYNTH_MAX_NOISE + 1;
+    EXPECT_EQ(hb_mm_synth_fill(&params, 0, &frame),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+}
+
+TEST_F(MediaHostTest, test_transcode_zero_copy) {
+    media_codec_context_t decoder, encoder;
+    mc_transcode_params_t params;
+    mc_transcode_stats_t stats;
+    mc_transcode_t *tc = NULL;
+    media_codec_buffer_t output;
+    media_codec_output_buffer_info_t info;
+    int i, ret, stalls = 0;
+    size_t n;
+
+    memset(&decoder, 0x00, sizeof(decoder));
+    decoder.codec_id = MEDIA_CODEC_ID_H264;
+    decoder.video_dec_params.frame_buf_count = 5;
+    memset(&encoder, 0x00, sizeof(encoder));
+    encoder.codec_id = MEDIA_CODEC_ID_H265;
+    encoder.encoder = 1;
+    encoder.video_enc_params.width = 64;
+    encoder.video_enc_params.height = 32;
+    encoder.video_enc_params.pix_fmt = MC_PIXEL_FORMAT_NV12;
+    encoder.video_enc_params.frame_buf_count = 3;
+    encoder.video_enc_params.external_frame_buf = 1;
+    gFakeEncoders[0] = FakeEncoder();
+    gFakeEncoders[0].context = &encoder;
+    gFakeDecoders[0] = FakeDecoder();
+    gFakeDecoders[0].context = &decoder;
+    gFakeDecoders[0].width = 64;
+    gFakeDecoders[0].height = 32;
+    gFakeDecoders[0].pixFmt = MC_PIXEL_FORMAT_NV12;
+    gFakeDecoders[0].frameBufCount = 5;
+    gFakeDecoders[0].total = 20;
+
+    memset(&params, 0x00, sizeof(params));
+    ASSERT_EQ(hb_mm_transcode_create(&params, &decoder, &encoder, &tc), 0);
+    // the encoder drains every other pump, so input buffers run out
+    memset(&stats, 0x00, sizeof(stats));
+    for (i = 0; i < 1000; i++) {
+        ret = stats.eos ? 0 : hb_mm_transcode_pump(tc);
+        if (ret == (int32_t)HB_MEDIA_ERR_WAIT_TIMEOUT) {
+            stalls++;
+        } else {
+            ASSERT_EQ(ret, 0);
+        }
+        ASSERT_EQ(hb_mm_transcode_get_stats(tc, &stats), 0);
+        EXPECT_LE(stats.inflight, 3U);
+        if ((i % 2) == 1) {
+            memset(&output, 0x00, sizeof(output));
+            memset(&info, 0x00, sizeof(info));
+            if (hb_mm_mc_dequeue_output_buffer(&encoder, &output, &info,
+                0) == 0) {
+                hb_mm_mc_queue_output_buffer(&encoder, &output, 0);
+                if (output.vstream_buf.stream_end) {
+                    break;
+                }
+            }
+        }
+    }
+    EXPECT_TRUE(stats.eos);
+    EXPECT_GT(stalls, 0);
+    EXPECT_EQ(stats.frames, 20U);
+    EXPECT_EQ(stats.max_inflight, 3U);
+    EXPECT_EQ(stats.encoder_stalls, (hb_u64)stalls);
+
+    // the encoder got the decoder's buffers in order, nothing was copied
+    ASSERT_EQ(gFakeEncoders[0].pts.size(), 20U);
+    for (n = 0; n < 20; n++) {
+        EXPECT_EQ(gFakeEncoders[0].pts[n], (hb_u64)n);
+        EXPECT_EQ(gFakeEncoders[0].inputPhys[n] & 0xFFFFFFULL, 0U);
+        EXPECT_GE(gFakeEncoders[0].inputPhys[n], FAKE_DECODER_PHYS(0));
+    }
+    EXPECT_TRUE(gFakeEncoders[0].frameEnd);
+    EXPECT_EQ(hb_mm_transcode_pump(tc),
+        (int32_t)HB_MEDIA_ERR_OPERATION_NOT_ALLOWED);
+
+    // every decoded frame goes back after it was encoded, never before
+    ASSERT_EQ(hb_mm_transcode_destroy(tc), 0);
+    EXPECT_EQ(gFakeDecoders[0].earlyReturns, 0);
+    for (i = 0; i < 5; i++) {
+        EXPECT_FALSE(gFakeDecoders[0].held[i]);
+    }
+
+    // the decoder needs one buffer more than the encoder can hold
+    decoder.video_dec_params.frame_buf_count = 3;
+    EXPECT_EQ(hb_mm_transcode_create(&params, &decoder, &encoder, &tc),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+    decoder.video_dec_params.frame_buf_count = 5;
+    encoder.video_enc_params.external_frame_buf = 0;
+    EXPECT_EQ(hb_mm_transcode_create(&params, &decoder, &encoder, &tc),
+        (int32_t)HB_MEDIA_ERR_INVALID_INSTANCE);
+    gFakeDecoders[0] = FakeDecoder();
+}
+
+static void append_nal(std::vector<uint8_t> &stream, int type, uint8_t tag,
+        bool longStartCode) {
+    if (longStartCode) {
+        stream.push_back(0x00);
+    }
+    stream.insert(stream.end(), {0x00, 0x00, 0x01, (uint8_t)(type << 1), 0x01,
+        tag, 0x80});
+}
+
+static hb_s32 chunk_read_frame(void *userdata, hb_u32 frame,
+        mc_video_frame_buffer_info_t *dst) {
+    __atomic_add_fetch((int *)userdata, 1, __ATOMIC_RELAXED);
+    memset(dst->vir_ptr[0], (int)frame, dst->size);
+    return 0;
+}
+
+TEST_F(MediaHostTest, test_chunk_join_and_encode) {
+    std::vector<uint8_t> chunks[3], joined;
+    const hb_u8 *chunkPtrs[3];
+    hb_u32 sizes[3], size = 0, dropped = 0, pos = 0, total = 0;
+    std::vector<int> types;
+    const int expected[] = {32, 33, 34, 19, 1, 19, 1, 34, 19, 1};
+    media_codec_context_t contexts[4];
+    media_codec_context_t *ctxList[4];
+    mc_chunk_params_t params;
+    mc_chunk_stats_t stats;
+    mc_nal_unit_t nal;
+    hb_u8 *stream = NULL;
+    int i, reads = 0, starts;
+    size_t n;
+
+    // the repeats of the second chunk go even with a longer start code,
+    // the changed PPS of the third chunk stays
+    for (i = 0; i < 3; i++) {
+        append_nal(chunks[i], 32, 1, i == 1);
+        append_nal(chunks[i], 33, 2, false);
+        append_nal(chunks[i], 34, (i == 2) ? 4 : 3, false);
+        append_nal(chunks[i], 19, 5, true);
+        append_nal(chunks[i], 1, 6, false);
+        chunkPtrs[i] = chunks[i].data();
+        sizes[i] = chunks[i].size();
+        total += sizes[i];
+    }
+    joined.resize(total);
+    ASSERT_EQ(hb_mm_chunk_join(MEDIA_CODEC_ID_H265, chunkPtrs, sizes, 3,
+        joined.data(), &size, &dropped), 0);
+    EXPECT_EQ(dropped, 5U);
+    while (hb_mm_nal_next(MEDIA_CODEC_ID_H265, joined.data(), size, &pos,
+        &nal) == 1) {
+        types.push_back(nal.type);
+    }
+    ASSERT_EQ(types.size(), sizeof(expected) / sizeof(expected[0]));
+    for (n = 0; n < types.size(); n++) {
+        EXPECT_EQ(types[n], expected[n]);
+    }
+    // the first chunk is copied as it is
+    EXPECT_EQ(memcmp(joined.data(), chunks[0].data(), chunks[0].size()), 0);
+
+    // 50 frames in GOPs of 8 over four instances, each chunk starts a GOP
+    for (i = 0; i < 4; i++) {
+        memset(&contexts[i], 0x00, sizeof(contexts[i]));
+        contexts[i].codec_id = MEDIA_CODEC_ID_H265;
+        contexts[i].encoder = 1;
+        contexts[i].video_enc_params.width = 64;
+        contexts[i].video_enc_params.height = 32;
+        contexts[i].video_enc_params.pix_fmt = MC_PIXEL_FORMAT_NV12;
+        contexts[i].video_enc_params.gop_params.decoding_refresh_type = 2;
+        ctxList[i] = &contexts[i];
+        gFakeEncoders[i] = FakeEncoder();
+        gFakeEncoders[i].context = &contexts[i];
+    }
+    memset(&params, 0x00, sizeof(params));
+    params.frame_num = 50;
+    params.gop_size = 8;
+    params.read_frame = chunk_read_frame;
+    params.userdata = &reads;
+    starts = gFakeCodecCalls.start;
+    ASSERT_EQ(hb_mm_chunk_encode(&params, ctxList, 4, &stream, &size, &stats),
+        0);
+    EXPECT_EQ(reads, 50);
+    EXPECT_EQ(gFakeCodecCalls.start - starts, 4);
+    ASSERT_EQ(stats.chunks, 4);
+    const hb_u32 chunkStart[] = {0, 8, 24, 40}, chunkFrames[] = {8, 16, 16, 10};
+    for (i = 0; i < 4; i++) {
+        EXPECT_EQ(stats.chunk_start[i], chunkStart[i]);
+        EXPECT_EQ(stats.chunk_frames[i], chunkFrames[i]);
+        ASSERT_EQ(gFakeEncoders[i].pts.size(), (size_t)chunkFrames[i]);
+        EXPECT_EQ(gFakeEncoders[i].pts[0], (hb_u64)chunkStart[i]);
+        EXPECT_TRUE(gFakeEncoders[i].frameEnd);
+        EXPECT_GT(stats.busy_us[i], 0U);
+    }
+    // the fake writes 64 bytes per picture and at the end of stream
+    EXPECT_EQ(size, (50U + 4U) * 64U);
+    EXPECT_EQ(stats.bytes, size);
+    EXPECT_GE(stats.wall_us, stats.busy_us[0]);
+    free(stream);
+
+    // fewer GOPs than instances leave instances idle
+    params.frame_num = 10;
+    for (i = 0; i < 4; i++) {
+        gFakeEncoders[i] = FakeEncoder();
+        gFakeEncoders[i].context = &contexts[i];
+    }
+    ASSERT_EQ(hb_mm_chunk_encode(&params, ctxList, 4, &stream, &size, &stats),
+        0);
+    EXPECT_EQ(stats.chunks, 2);
+    EXPECT_EQ(gFakeEncoders[2].pts.size(), 0U);
+    free(stream);
+
+    contexts[1].video_enc_params.gop_params.decoding_refresh_type = 1;
+    EXPECT_EQ(hb_mm_chunk_encode(&params, ctxList, 4, &stream, &size, &stats),
+        (int32_t)HB_MEDIA_ERR_INVALID_INSTANCE);
+}
+
+TEST_F(MediaHostTest, test_preview_speed_plans) {
+    std::vector<uint8_t> h265, h264;
+    mc_preview_probe_t probe;
+    mc_preview_plan_t plan;
+    media_codec_context_t context;
+    int i, tid;
+
+    // dyadic GOPs of 8 in 4 temporal layers, the top layer unreferenced
+    h265.insert(h265.end(), {0x00, 0x00, 0x01, 33 << 1, 0x01, 0x07, 0x80});
+    for (i = 0; i < 64; i++) {
+        tid = (i % 8 == 0) ? 0 : ((i % 4 == 0) ? 1 : ((i % 2 == 0) ? 2 : 3));
+        h265.insert(h265.end(), {0x00, 0x00, 0x00, 0x01,
+            (uint8_t)(((i == 0) ? 19 : ((tid == 3) ? 0 : 1)) << 1),
+            (uint8_t)(tid + 1), 0x80, 0x11});
+        if (i == 5) {
+            // a second slice isn't another picture
+            h265.insert(h265.end(), {0x00, 0x00, 0x01, 0x00, (uint8_t)(tid + 1),
+                0x00, 0x11});
+        }
+    }
+    memset(&probe, 0x00, sizeof(probe));
+    ASSERT_EQ(hb_mm_preview_probe(MEDIA_CODEC_ID_H265, h265.data(),
+        h265.size(), &probe), 0);
+    EXPECT_EQ(probe.pictures, 64U);
+    EXPECT_EQ(probe.key_pictures, 1U);
+    EXPECT_EQ(probe.non_ref_pictures, 32U);
+    EXPECT_EQ(probe.max_sub_layers, 4U);
+    EXPECT_EQ(probe.layer_pictures[0], 8U);
+    EXPECT_EQ(probe.layer_pictures[1], 8U);
+    EXPECT_EQ(probe.layer_pictures[2], 16U);
+    EXPECT_EQ(probe.layer_pictures[3], 32U);
+
+    // each doubling drops one more temporal layer
+    const hb_u32 plus1[] = {0, 3, 2, 1};
+    const hb_u32 permille[] = {1000, 500, 250, 125};
+    for (i = MC_PREVIEW_SPEED_1X; i <= MC_PREVIEW_SPEED_8X; i++) {
+        ASSERT_EQ(hb_mm_preview_plan(MEDIA_CODEC_ID_H265,
+            (mc_preview_speed_t)i, &probe, &plan), 0);
+        EXPECT_EQ(plan.skip_mode, 0U);
+        EXPECT_EQ(plan.target_dec_temporal_id_plus1, plus1[i]);
+        EXPECT_EQ(plan.decoded_permille, permille[i]);
+    }
+    ASSERT_EQ(hb_mm_preview_plan(MEDIA_CODEC_ID_H265,
+        MC_PREVIEW_SPEED_KEYFRAMES, &probe, &plan), 0);
+    EXPECT_EQ(plan.skip_mode, 1U);
+    EXPECT_EQ(plan.target_dec_temporal_id_plus1, 0U);
+    EXPECT_EQ(plan.decoded_permille, 15U);
+
+    memset(&context, 0x00, sizeof(context));
+    context.codec_id = MEDIA_CODEC_ID_H265;
+    ASSERT_EQ(hb_mm_preview_plan(MEDIA_CODEC_ID_H265, MC_PREVIEW_SPEED_4X,
+        &probe, &plan), 0);
+    ASSERT_EQ(hb_mm_preview_apply(&plan, &context), 0);
+    EXPECT_EQ(context.video_dec_params.h265_dec_config.dec_temporal_id_mode,
+        0U);
+    EXPECT_EQ(context.video_dec_params.h265_dec_config.
+        target_dec_temporal_id_plus1, 2U);
+    context.codec_id = MEDIA_CODEC_ID_H264;
+    EXPECT_EQ(hb_mm_preview_apply(&plan, &context),
+        (int32_t)HB_MEDIA_ERR_UNSUPPORTED_FEATURE);
+
+    // H264 without layers: every other picture is unreferenced, 4x falls
+    // back to key pictures
+    for (i = 0; i < 32; i++) {
+        h264.insert(h264.end(), {0x00, 0x00, 0x01,
+            (uint8_t)((i == 0) ? 0x65 : ((i % 2 == 1) ? 0x01 : 0x41)), 0x88,
+            0x11});
+    }
+    memset(&probe, 0x00, sizeof(probe));
+    ASSERT_EQ(hb_mm_preview_probe(MEDIA_CODEC_ID_H264, h264.data(),
+        h264.size(), &probe), 0);
+    EXPECT_EQ(probe.pictures, 32U);
+    EXPECT_EQ(probe.non_ref_pictures, 16U);
+    ASSERT_EQ(hb_mm_preview_plan(MEDIA_CODEC_ID_H264, MC_PREVIEW_SPEED_2X,
+        &probe, &plan), 0);
+    EXPECT_EQ(plan.skip_mode, 2U);
+    EXPECT_EQ(plan.decoded_permille, 500U);
+    ASSERT_EQ(hb_mm_preview_plan(MEDIA_CODEC_ID_H264, MC_PREVIEW_SPEED_4X,
+        &probe, &plan), 0);
+    EXPECT_EQ(plan.skip_mode, 1U);
+    EXPECT_EQ(plan.decoded_permille, 31U);
+    ASSERT_EQ(hb_mm_preview_apply(&plan, &context), 0);
+    EXPECT_EQ(context.video_dec_params.h264_dec_config.skip_mode, 1U);
+
+    // without a probe the faster speeds skip unreferenced pictures
+    ASSERT_EQ(hb_mm_preview_plan(MEDIA_CODEC_ID_H264, MC_PREVIEW_SPEED_8X,
+        NULL, &plan), 0);
+    EXPECT_EQ(plan.skip_mode, 2U);
+    EXPECT_EQ(plan.decoded_permille, 0U);
+    EXPECT_EQ(hb_mm_preview_plan(MEDIA_CODEC_ID_MJPEG, MC_PREVIEW_SPEED_2X,
+        NULL, &plan), (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+    context.encoder = 1;
+    EXPECT_EQ(hb_mm_preview_apply(&plan, &context),
+        (int32_t)HB_MEDIA_ERR_INVALID_INSTANCE);
+}
+
+TEST_F(MediaHostTest, test_tlayer_gop_and_dropper) {
+    mc_tlayer_gop_params_t gp;
+    mc_video_gop_params_t gop;
+    mc_tlayer_drop_params_t dp;
+    mc_tlayer_drop_stats_t stats;
+    mc_tlayer_dropper_t *dropper = NULL;
+    std::vector<uint8_t> au;
+    bool passed[64];
+    hb_bool drop;
+    hb_u32 backlogMilli = 0, n, ref;
+    int i, tid;
+
+    // GOP of 8 in 4 layers, every picture refers to a lower layer
+    memset(&gop, 0x00, sizeof(gop));
+    gop.gop_preset_idx = 2;
+    gop.decoding_refresh_type = 2;
+    gp.layers = 4;
+    gp.base_qp = 30;
+    gp.qp_step = 8;
+    ASSERT_EQ(hb_mm_tlayer_build_gop(&gp, &gop), 0);
+    EXPECT_EQ(gop.gop_preset_idx, 0U);
+    EXPECT_EQ(gop.decoding_refresh_type, 2);
+    ASSERT_EQ(gop.custom_gop_size, 8);
+    const hb_u32 tids[] = {3, 2, 3, 1, 3, 2, 3, 0};
+    const hb_s32 refs[] = {0, 0, 2, 0, 4, 4, 6, 0};
+    for (i = 0; i < 8; i++) {
+        EXPECT_EQ(gop.custom_gop_pic_param[i].pic_type, 1U);
+        EXPECT_EQ(gop.custom_gop_pic_param[i].poc_offset, i + 1);
+        EXPECT_EQ(gop.custom_gop_pic_param[i].temporal_id, tids[i]);
+        EXPECT_EQ(gop.custom_gop_pic_param[i].ref_pocL0, refs[i]);
+        EXPECT_EQ(gop.custom_gop_pic_param[i].pic_qp,
+            (tids[i] == 3) ? 51U : 30 + tids[i] * 8);
+        if (refs[i] > 0) {
+            EXPECT_LT(tids[refs[i] - 1], tids[i]);
+        }
+    }
+    gp.layers = 1;
+    ASSERT_EQ(hb_mm_tlayer_build_gop(&gp, &gop), 0);
+    EXPECT_EQ(gop.custom_gop_size, 1);
+    EXPECT_EQ(gop.custom_gop_pic_param[0].temporal_id, 0U);
+    gp.layers = MC_TLAYER_MAX_LAYERS + 1;
+    EXPECT_EQ(hb_mm_tlayer_build_gop(&gp, &gop),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+
+    // H265 in 3 layers to a sink taking 0.6 pictures per picture
+    dp.codec_id = MEDIA_CODEC_ID_H265;
+    dp.layers = 3;
+    dp.high_watermark = 4;
+    dp.low_watermark = 1;
+    ASSERT_EQ(hb_mm_tlayer_dropper_create(&dp, &dropper), 0);
+    au.assign({0x00, 0x00, 0x00, 0x01, 32 << 1, 0x01, 0x0c});
+    ASSERT_EQ(hb_mm_tlayer_dropper_check(dropper, au.data(), au.size(), 100,
+        &drop), 0);
+    EXPECT_FALSE(drop);
+    for (i = 0; i < 64; i++) {
+        tid = hb_mm_tlayer_get_id(3, i);
+        au.assign({0x00, 0x00, 0x00, 0x01,
+            (uint8_t)(((i == 0) ? 19 : 1) << 1), (uint8_t)(tid + 1), 0x80});
+        ASSERT_EQ(hb_mm_tlayer_dropper_check(dropper, au.data(), au.size(),
+            backlogMilli / 1000, &drop), 0);
+        passed[i] = !drop;
+        if (!drop) {
+            backlogMilli += 1000;
+        }
+        backlogMilli = (backlogMilli > 600) ? (backlogMilli - 600) : 0;
+        EXPECT_LT(backlogMilli / 1000, dp.high_watermark + 2);
+    }
+    // what passes refers to pictures that passed
+    for (i = 1; i < 64; i++) {
+        n = i % 4;
+        ref = (n == 0) ? (i - 4) : (i - (n & (0U - n)));
+        if (passed[i]) {
+            EXPECT_TRUE(passed[ref]) << "picture " << i;
+        }
+        if (hb_mm_tlayer_get_id(3, i) == 0) {
+            EXPECT_TRUE(passed[i]);
+        }
+    }
+    ASSERT_EQ(hb_mm_tlayer_dropper_get_stats(dropper, &stats), 0);
+    EXPECT_EQ(stats.pictures, 64U);
+    EXPECT_GT(stats.dropped, 0U);
+    EXPECT_EQ(stats.layer_dropped[0], 0U);
+    EXPECT_GT(stats.layer_dropped[2], stats.layer_dropped[1]);
+    EXPECT_EQ(stats.max_level, 2U);
+    EXPECT_EQ(stats.ref_kept, 0U);
+    EXPECT_EQ(hb_mm_tlayer_dropper_destroy(dropper), 0);
+
+    dp.low_watermark = dp.high_watermark;
+    EXPECT_EQ(hb_mm_tlayer_dropper_create(&dp, &dropper),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+}
+
+TEST_F(MediaHostTest, test_tlayer_dropper_h264_keeps_references) {
+    mc_tlayer_drop_params_t dp;
+    mc_tlayer_drop_stats_t stats;
+    mc_tlayer_dropper_t *dropper = NULL;
+    std::vector<uint8_t> au;
+    hb_bool drop;
+    uint8_t nal;
+    int i, dropped = 0;
+
+    // H264 pictures are counted from the IDR; only the top layer is left
+    // unreferenced, layer 1 is a reference for the top layer
+    dp.codec_id = MEDIA_CODEC_ID_H264;
+    dp.layers = 3;
+    dp.high_watermark = 4;
+    dp.low_watermark = 1;
+    ASSERT_EQ(hb_mm_tlayer_dropper_create(&dp, &dropper), 0);
+    for (i = 0; i < 16; i++) {
+        nal = (i == 0) ? 0x65 : ((i % 2) ? 0x01 : 0x41);
+        au.assign({0x00, 0x00, 0x00, 0x01, nal, 0x88});
+        ASSERT_EQ(hb_mm_tlayer_dropper_check(dropper, au.data(), au.size(),
+            10, &drop), 0);
+        if (drop) {
+            // nal_ref_idc of everything dropped is 0
+            EXPECT_EQ(nal & 0x60, 0) << "picture " << i;
+            dropped++;
+        }
+        EXPECT_EQ(!drop, i % 2 == 0) << "picture " << i;
+    }
+    ASSERT_EQ(hb_mm_tlayer_dropper_get_stats(dropper, &stats), 0);
+    EXPECT_EQ(stats.max_level, 2U);
+    EXPECT_EQ(stats.dropped, 8U);
+    EXPECT_EQ(stats.layer_dropped[2], 8U);
+    EXPECT_EQ(stats.dropped_bytes, 8U * 6);
+    // the layer 1 pictures are passed as references
+    EXPECT_EQ(stats.ref_kept, 4U);
+    EXPECT_EQ(dropped, 8);
+    EXPECT_EQ(hb_mm_tlayer_dropper_destroy(dropper), 0);
+}
+
+static void feed_ltr(mc_ltr_t *ltr, int frames, hb_u32 skipBlocks,
+        hb_u32 intraBlocks) {
+    media_codec_output_buffer_info_t info;
+    int i;
+
+    for (i = 0; i < frames; i++) {
+        memset(&info, 0x00, sizeof(info));
+        info.video_stream_info.nalu_type = MC_H265_NALU_TYPE_P;
+        info.video_stream_info.enc_pic_byte = 1000;
+        info.video_stream_info.skip_block_num = skipBlocks;
+        info.video_stream_info.intra_block_num = intraBlocks;
+        ASSERT_EQ(hb_mm_ltr_update(ltr, &info), 0);
+    }
+}
+
+TEST_F(MediaHostTest, test_ltr_static_scene_period) {
+    const int width = 640, height = 360;
+    const hb_u32 blocks8 = (width / 8) * (height / 8);
+    media_codec_context_t context;
+    media_codec_output_buffer_info_t info;
+    mc_video_longterm_ref_mode_t mode;
+    mc_ltr_params_t params;
+    mc_ltr_stats_t stats;
+    mc_ltr_t *ltr = NULL;
+
+    memset(&context, 0x00, sizeof(context));
+    context.codec_id = MEDIA_CODEC_ID_H265;
+    context.encoder = 1;
+    context.video_enc_params.width = width;
+    context.video_enc_params.height = height;
+    gFakeEncoders[0] = FakeEncoder();
+    gFakeEncoders[0].context = &context;
+    ASSERT_EQ(hb_mm_mc_initialize(&context), 0);
+    memset(&mode, 0x00, sizeof(mode));
+    mode.use_longterm = 1;
+    mode.longterm_pic_period = 30;
+    mode.longterm_pic_using_period = 20;
+    ASSERT_EQ(hb_mm_mc_set_longterm_ref_mode(&context, &mode), 0);
+
+    memset(&params, 0x00, sizeof(params));
+    params.static_skip_permille = 800;
+    params.max_intra_permille = 20;
+    params.hold_frames = 10;
+    params.min_pic_period = 10;
+    params.max_pic_period = 80;
+    params.static_using_period = 5;
+    params.motion_using_period = 20;
+    ASSERT_EQ(hb_mm_ltr_create(&context, &params, &ltr), 0);
+    ASSERT_EQ(hb_mm_mc_get_longterm_ref_mode(&context, &mode), 0);
+    EXPECT_EQ(mode.longterm_pic_period, 10U);
+    EXPECT_EQ(mode.longterm_pic_using_period, 20U);
+
+    // the IDR isn't a scene sample, then 10 static pictures per doubling
+    memset(&info, 0x00, sizeof(info));
+    info.video_stream_info.nalu_type = MC_H265_NALU_TYPE_IDR;
+    info.video_stream_info.enc_pic_byte = 50000;
+    ASSERT_EQ(hb_mm_ltr_update(ltr, &info), 0);
+    feed_ltr(ltr, 9, blocks8, 0);
+    ASSERT_EQ(hb_mm_mc_get_longterm_ref_mode(&context, &mode), 0);
+    EXPECT_EQ(mode.longterm_pic_period, 10U);
+    feed_ltr(ltr, 1, blocks8, 0);
+    ASSERT_EQ(hb_mm_mc_get_longterm_ref_mode(&context, &mode), 0);
+    EXPECT_EQ(mode.longterm_pic_period, 20U);
+    EXPECT_EQ(mode.longterm_pic_using_period, 5U);
+    EXPECT_EQ(mode.use_longterm, 1U);
+    feed_ltr(ltr, 40, blocks8, 0);
+    ASSERT_EQ(hb_mm_ltr_get_stats(ltr, &stats), 0);
+    EXPECT_EQ(stats.pic_period, 80U);
+    EXPECT_EQ(stats.updates, 4U);
+    EXPECT_EQ(stats.static_frames, 50U);
+    EXPECT_EQ(stats.skip_permille, 1000U);
+
+    // smoothing lets one moving picture pass, the second one resets
+    feed_ltr(ltr, 1, 0, 0);
+    ASSERT_EQ(hb_mm_mc_get_longterm_ref_mode(&context, &mode), 0);
+    EXPECT_EQ(mode.longterm_pic_period, 80U);
+    feed_ltr(ltr, 1, 0, 0);
+    ASSERT_EQ(hb_mm_mc_get_longterm_ref_mode(&context, &mode), 0);
+    EXPECT_EQ(mode.longterm_pic_period, 10U);
+    EXPECT_EQ(mode.longterm_pic_using_period, 20U);
+    // intra blocks alone mean motion too
+    params.static_skip_permille = 1;
+    ASSERT_EQ(hb_mm_ltr_set_params(ltr, &params), 0);
+    feed_ltr(ltr, 30, blocks8, 920);
+    ASSERT_EQ(hb_mm_ltr_get_stats(ltr, &stats), 0);
+    EXPECT_EQ(stats.pic_period, 10U);
+    EXPECT_EQ(stats.updates, 5U);
+    EXPECT_EQ(stats.frames, 83U);
+    EXPECT_EQ(stats.p_frames, 82U);
+    EXPECT_EQ(stats.p_bytes, 82000U);
+    ASSERT_EQ(hb_mm_ltr_destroy(ltr), 0);
+
+    params.min_pic_period = 100;
+    EXPECT_EQ(hb_mm_ltr_create(&context, &params, &ltr),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+    params.min_pic_period = 10;
+    mode.use_longterm = 0;
+    ASSERT_EQ(hb_mm_mc_set_longterm_ref_mode(&context, &mode), 0);
+    EXPECT_EQ(hb_mm_ltr_create(&context, &params, &ltr),
+        (int32_t)HB_MEDIA_ERR_OPERATION_NOT_ALLOWED);
+    ASSERT_EQ(hb_mm_mc_release(&context), 0);
+}
+
+static void feed_lowlat(mc_lowlat_t *ll, hb_s32 type,
+        int frames, hb_u32 bytes) {
+    media_codec_output_buffer_info_t info;
+    int i;
+
+    for (i = 0; i < frames; i++) {
+        memset(&info, 0x00, sizeof(info));
+        info.video_stream_info.nalu_type = type;
+        info.video_stream_info.enc_pic_byte = bytes;
+        ASSERT_EQ(hb_mm_lowlat_update(ll, &info), 0);
+    }
+}
+
+TEST_F(MediaHostTest, test_lowlat_preset_and_recovery) {
+    media_codec_context_t context;
+    mc_video_intra_refresh_params_t refresh;
+    mc_lowlat_params_t params;
+    mc_lowlat_stats_t stats;
+    mc_lowlat_t *ll = NULL;
+
+    memset(&context, 0x00, sizeof(context));
+    context.codec_id = MEDIA_CODEC_ID_H264;
+    context.encoder = 1;
+    context.video_enc_params.width = 640;
+    context.video_enc_params.height = 360;
+    memset(&params, 0x00, sizeof(params));
+    params.bit_rate = 1000;
+    params.frame_rate = 30;
+    params.refresh_frames = 8;
+    params.budget_frames = 2;
+    params.max_recovery_frames = 10;
+    params.min_idr_interval = 30;
+    // 23 MB rows, 3 per picture
+    ASSERT_EQ(hb_mm_lowlat_preset(&params, &context, &refresh), 0);
+    EXPECT_EQ(context.video_enc_params.rc_params.mode, MC_AV_RC_MODE_H264CBR);
+    EXPECT_EQ(context.video_enc_params.rc_params.h264_cbr_params.intra_period,
+        0U);
+    EXPECT_EQ(
+        context.video_enc_params.rc_params.h264_cbr_params.vbv_buffer_size,
+        66U);
+    EXPECT_EQ(refresh.intra_refresh_mode, 1U);
+    EXPECT_EQ(refresh.intra_refresh_arg, 3U);
+
+    // 6 CTU rows, one per picture
+    context.codec_id = MEDIA_CODEC_ID_H265;
+    params.refresh_frames = 6;
+    ASSERT_EQ(hb_mm_lowlat_preset(&params, &context, &refresh), 0);
+    EXPECT_EQ(context.video_enc_params.rc_params.mode, MC_AV_RC_MODE_H265CBR);
+    EXPECT_EQ(context.video_enc_params.rc_params.h265_cbr_params.intra_period,
+        0U);
+    EXPECT_EQ(
+        context.video_enc_params.rc_params.h265_cbr_params.ctu_level_rc_enalbe,
+        1U);
+    EXPECT_EQ(context.video_enc_params.gop_params.decoding_refresh_type, 2U);
+    EXPECT_EQ(refresh.intra_refresh_arg, 1U);
+
+    gFakeEncoders[0] = FakeEncoder();
+    gFakeEncoders[0].context = &context;
+    ASSERT_EQ(hb_mm_mc_initialize(&context), 0);
+    ASSERT_EQ(hb_mm_lowlat_create(&context, &params, &ll), 0);
+    // 100ms on the link for the IDR, the P pictures wait behind it
+    feed_lowlat(ll, MC_H265_NALU_TYPE_IDR, 1, 12500);
+    feed_lowlat(ll, MC_H265_NALU_TYPE_P, 9, 1250);
+    ASSERT_EQ(hb_mm_lowlat_get_stats(ll, &stats), 0);
+    EXPECT_EQ(stats.frames, 10U);
+    EXPECT_EQ(stats.refresh_frames, 6U);
+    EXPECT_EQ(stats.max_frame_bytes, 12500U);
+    EXPECT_EQ(stats.frame_bytes_stddev, 3375U);
+    EXPECT_EQ(stats.max_link_delay_us, 100000U);
+
+    // the cycle starting at picture 6 heals picture 4 at 12
+    ASSERT_EQ(hb_mm_lowlat_report_loss(ll, 4), 0);
+    ASSERT_EQ(hb_mm_lowlat_get_stats(ll, &stats), 0);
+    EXPECT_TRUE(stats.recovering);
+    EXPECT_EQ(stats.recovery_frame, 12U);
+    feed_lowlat(ll, MC_H265_NALU_TYPE_P, 2, 1250);
+    ASSERT_EQ(hb_mm_lowlat_get_stats(ll, &stats), 0);
+    EXPECT_TRUE(stats.recovering);
+    feed_lowlat(ll, MC_H265_NALU_TYPE_P, 1, 1250);
+    ASSERT_EQ(hb_mm_lowlat_get_stats(ll, &stats), 0);
+    EXPECT_FALSE(stats.recovering);
+    EXPECT_EQ(stats.refresh_recoveries, 1U);
+    EXPECT_TRUE(gFakeEncoders[0].idrRequests.empty());
+
+    // only an IDR heals a lost IDR
+    ASSERT_EQ(hb_mm_lowlat_report_loss(ll, 0), 0);
+    ASSERT_EQ(gFakeEncoders[0].idrRequests.size(), (size_t)1);
+    feed_lowlat(ll, MC_H265_NALU_TYPE_P, 1, 1250);
+    feed_lowlat(ll, MC_H265_NALU_TYPE_IDR, 1, 12500);
+    ASSERT_EQ(hb_mm_lowlat_get_stats(ll, &stats), 0);
+    EXPECT_FALSE(stats.recovering);
+    EXPECT_EQ(stats.recovery_frame, 14U);
+    EXPECT_EQ(stats.idr_recoveries, 1U);
+    EXPECT_EQ(stats.losses, 2U);
+    EXPECT_EQ(hb_mm_lowlat_report_loss(ll, 15),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+    ASSERT_EQ(hb_mm_lowlat_destroy(ll), 0);
+
+    // without a recovery budget, a second IDR is only sent after 30
+    params.max_recovery_frames = 0;
+    ASSERT_EQ(hb_mm_lowlat_create(&context, &params, &ll), 0);
+    feed_lowlat(ll, MC_H265_NALU_TYPE_IDR, 1, 12500);
+    feed_lowlat(ll, MC_H265_NALU_TYPE_P, 5, 1250);
+    ASSERT_EQ(hb_mm_lowlat_report_loss(ll, 3), 0);
+    ASSERT_EQ(gFakeEncoders[0].idrRequests.size(), (size_t)2);
+    feed_lowlat(ll, MC_H265_NALU_TYPE_IDR, 1, 12500);
+    feed_lowlat(ll, MC_H265_NALU_TYPE_P, 3, 1250);
+    ASSERT_EQ(hb_mm_lowlat_report_loss(ll, 8), 0);
+    ASSERT_EQ(gFakeEncoders[0].idrRequests.size(), (size_t)2);
+    ASSERT_EQ(hb_mm_lowlat_get_stats(ll, &stats), 0);
+    EXPECT_EQ(stats.recovery_frame, 18U);
+    EXPECT_EQ(stats.idr_recoveries, 1U);
+    ASSERT_EQ(hb_mm_lowlat_destroy(ll), 0);
+
+    params.refresh_frames = 7;
+    EXPECT_EQ(hb_mm_lowlat_create(&context, &params, &ll),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+    ASSERT_EQ(hb_mm_mc_release(&context), 0);
+    context.encoder = 0;
+    params.refresh_frames = 6;
+    EXPECT_EQ(hb_mm_lowlat_preset(&params, &context, &refresh),
+        (int32_t)HB_MEDIA_ERR_INVALID_INSTANCE);
+}
+
+// an H265 NAL unit of size bytes after its start code, never two zero
+// bytes in a row
+static void append_slice_nal(std::vector<uint8_t> &stream, int type,
+        hb_u32 size) {
+    hb_u32 j;
+
+    stream.insert(stream.end(), {0x00, 0x00, 0x00, 0x01, (uint8_t)(type << 1),
+        0x01});
+    for (j = 2; j < size; j++) {
+        stream.push_back((uint8_t)((j * 29 + type) | 1));
+    }
+}
+
+static hb_s32 write_slice(mc_slicestream_t *ss, std::vector<uint8_t> &data,
+        hb_u32 sliceIdx, hb_u32 sliceNum, hb_u64 pts, mc_slice_info_t *slice) {
+    media_codec_output_buffer_info_t info;
+    media_codec_buffer_t buffer;
+
+    memset(&buffer, 0x00, sizeof(buffer));
+    buffer.type = MC_VIDEO_STREAM_BUFFER;
+    buffer.vstream_buf.vir_ptr = data.data();
+    buffer.vstream_buf.size = data.size();
+    buffer.vstream_buf.pts = pts;
+    memset(&info, 0x00, sizeof(info));
+    info.video_stream_info.slice_idx = sliceIdx;
+    info.video_stream_info.independent_slice_num = sliceNum;
+    return hb_mm_slicestream_write(ss, &buffer, &info, slice);
+}
+
+TEST_F(MediaHostTest, test_slicestream_sinks) {
+    std::vector<uint8_t> slices[3], p0, received, joined;
+    hb_u8 header[MC_SLICESTREAM_HEADER_SIZE], packet[256];
+    mc_slicestream_params_t params;
+    mc_slicestream_stats_t stats;
+    mc_slice_info_t slice, parsed;
+    mc_slicestream_t *ss = NULL;
+    hb_u32 offset = 0;
+    int fds[2], i, packets;
+    ssize_t n;
+
+    // an IDR picture of 3 slices, the first one behind the parameter sets
+    append_slice_nal(slices[0], MC_H265_NALU_TYPE_VPS, 24);
+    append_slice_nal(slices[0], MC_H265_NALU_TYPE_SPS, 24);
+    append_slice_nal(slices[0], MC_H265_NALU_TYPE_PPS, 8);
+    append_slice_nal(slices[0], MC_H265_NALU_TYPE_IDR, 300);
+    append_slice_nal(slices[1], MC_H265_NALU_TYPE_IDR, 1000);
+    append_slice_nal(slices[2], MC_H265_NALU_TYPE_IDR, 150);
+    append_slice_nal(p0, MC_H265_NALU_TYPE_P, 100);
+
+    // every slice leaves behind its header on the socket at once
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    memset(&params, 0x00, sizeof(params));
+    params.sink = MC_SLICESTREAM_SINK_SOCKET;
+    params.codec_id = MEDIA_CODEC_ID_H265;
+    params.fd = fds[0];
+    ASSERT_EQ(hb_mm_slicestream_create(&params, &ss), 0);
+    for (i = 0; i < 3; i++) {
+        ASSERT_EQ(write_slice(ss, slices[i], i, 3, 40, &slice), 0);
+        EXPECT_EQ(slice.frame_index, 0U);
+        EXPECT_EQ(slice.slice_idx, (hb_u32)i);
+        EXPECT_EQ(slice.slice_count, 1U);
+        EXPECT_EQ(slice.offset, offset);
+        EXPECT_EQ(slice.last, (i == 2) ? 1 : 0);
+        ASSERT_EQ(read(fds[1], header, sizeof(header)),
+            (ssize_t)sizeof(header));
+        ASSERT_EQ(hb_mm_slicestream_parse_header(header, &parsed), 0);
+        EXPECT_EQ(parsed.slice_idx, (hb_u32)i);
+        EXPECT_EQ(parsed.slice_num, 3U);
+        EXPECT_EQ(parsed.offset, offset);
+        EXPECT_EQ(parsed.size, (hb_u32)slices[i].size());
+        EXPECT_EQ(parsed.pts, 40U);
+        EXPECT_EQ(parsed.last, slice.last);
+        EXPECT_TRUE(parsed.key);
+        received.resize(parsed.size);
+        ASSERT_EQ(read(fds[1], received.data(), received.size()),
+            (ssize_t)received.size());
+        EXPECT_EQ(received, slices[i]);
+        offset += parsed.size;
+    }
+    // the second slice of the next picture never comes
+    ASSERT_EQ(write_slice(ss, p0, 0, 2, 80, &slice), 0);
+    EXPECT_EQ(slice.frame_index, 1U);
+    EXPECT_FALSE(slice.key);
+    ASSERT_EQ(write_slice(ss, p0, 0, 2, 120, &slice), 0);
+    EXPECT_EQ(slice.frame_index, 2U);
+    ASSERT_EQ(hb_mm_slicestream_get_stats(ss, &stats), 0);
+    EXPECT_EQ(stats.frames, 1U);
+    EXPECT_EQ(stats.buffers, 5U);
+    EXPECT_EQ(stats.max_slices, 3U);
+    EXPECT_EQ(stats.incomplete_frames, 1U);
+    ASSERT_EQ(hb_mm_slicestream_destroy(ss), 0);
+    close(fds[0]);
+    close(fds[1]);
+
+    // 1000 bytes in fragments of 185 bytes, the marker on the last one
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_DGRAM, 0, fds), 0);
+    params.sink = MC_SLICESTREAM_SINK_RTP;
+    params.fd = fds[0];
+    params.mtu = 200;
+    params.payload_type = 96;
+    params.ssrc = 0x1234;
+    ASSERT_EQ(hb_mm_slicestream_create(&params, &ss), 0);
+    ASSERT_EQ(write_slice(ss, slices[1], 1, 2, 40, NULL), 0);
+    ASSERT_EQ(write_slice(ss, slices[2], 1, 2, 40, NULL), 0);
+    for (packets = 0; packets < 6; packets++) {
+        n = recv(fds[1], packet, sizeof(packet), MSG_DONTWAIT);
+        ASSERT_GT(n, 15);
+        EXPECT_LE(n, 200);
+        EXPECT_EQ(packet[0], 0x80);
+        EXPECT_EQ(packet[1], 96);
+        EXPECT_EQ((packet[2] << 8) | packet[3], packets);
+        EXPECT_EQ(packet[7], 40 * 90 % 256);
+        EXPECT_EQ(packet[12] >> 1, 49);
+        EXPECT_EQ(packet[14] & 0x3F, MC_H265_NALU_TYPE_IDR);
+        EXPECT_EQ((packet[14] & 0x80) != 0, packets == 0);
+        EXPECT_EQ((packet[14] & 0x40) != 0, packets == 5);
+        if (packets == 0) {
+            joined.assign(slices[1].begin() + 4, slices[1].begin() + 6);
+        }
+        joined.insert(joined.end(), packet + 15, packet + n);
+    }
+    EXPECT_EQ(joined, std::vector<uint8_t>(slices[1].begin() + 4,
+        slices[1].end()));
+    // the fragments don't end the picture, the next small slice does
+    n = recv(fds[1], packet, sizeof(packet), MSG_DONTWAIT);
+    EXPECT_EQ(n, (ssize_t)(12 + slices[2].size() - 4));
+    EXPECT_EQ(packet[1], 0x80 | 96);
+    EXPECT_EQ(recv(fds[1], packet, sizeof(packet), MSG_DONTWAIT), -1);
+    ASSERT_EQ(hb_mm_slicestream_get_stats(ss, &stats), 0);
+    EXPECT_EQ(stats.packets, 7U);
+    EXPECT_EQ(stats.fragmented_units, 1U);
+    EXPECT_EQ(stats.frames, 1U);
+    ASSERT_EQ(hb_mm_slicestream_destroy(ss), 0);
+    close(fds[0]);
+    close(fds[1]);
+
+    // a whole picture without output information
+    ASSERT_EQ(pipe(fds), 0);
+    params.sink = MC_SLICESTREAM_SINK_FILE;
+    params.fd = fds[1];
+    ASSERT_EQ(hb_mm_slicestream_create(&params, &ss), 0);
+    joined.clear();
+    for (i = 0; i < 3; i++) {
+        joined.insert(joined.end(), slices[i].begin(), slices[i].end());
+    }
+    media_codec_buffer_t buffer;
+    memset(&buffer, 0x00, sizeof(buffer));
+    buffer.vstream_buf.vir_ptr = joined.data();
+    buffer.vstream_buf.size = joined.size();
+    ASSERT_EQ(hb_mm_slicestream_write(ss, &buffer, NULL, &slice), 0);
+    EXPECT_EQ(slice.slice_count, 3U);
+    EXPECT_EQ(slice.slice_num, 3U);
+    EXPECT_TRUE(slice.last);
+    received.resize(joined.size());
+    ASSERT_EQ(read(fds[0], received.data(), received.size()),
+        (ssize_t)received.size());
+    EXPECT_EQ(received, joined);
+    ASSERT_EQ(hb_mm_slicestream_destroy(ss), 0);
+    close(fds[0]);
+    close(fds[1]);
+
+    params.sink = MC_SLICESTREAM_SINK_RTP;
+    params.payload_type = 0;
+    EXPECT_EQ(hb_mm_slicestream_create(&params, &ss),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+    header[0] = 0;
+    EXPECT_EQ(hb_mm_slicestream_parse_header(header, &parsed),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+}
+
+// what a decoder hands back for an inserted payload: the UUID in binary,
+// then the text
+static std::vector<uint8_t> sei_decoded(const std::vector<uint8_t> &inserted,
+        bool keepPlus) {
+    std::vector<uint8_t> out;
+    unsigned int byte;
+    size_t i;
+
+    for (i = 0; i < 16; i++) {
+        sscanf((const char *)&inserted[i * 2], "%2x", &byte);
+        out.push_back((uint8_t)byte);
+    }
+    out.insert(out.end(), inserted.begin() + (keepPlus ? 32 : 33),
+        inserted.end());
+    return out;
+}
+
+TEST_F(MediaHostTest, test_sei_inject_and_extract) {
+    const hb_u8 uuid[16] = {0xdc, 0x45, 0xe9, 0xbd, 0xe6, 0xd9, 0x48, 0xb7,
+        0x96, 0x2c, 0xd8, 0x20, 0xd9, 0x23, 0xee, 0xef};
+    media_codec_context_t encoder, decoder;
+    media_codec_buffer_t buffer, output;
+    mc_sei_params_t params;
+    mc_sei_stats_t stats;
+    mc_sei_meta_t meta, got;
+    mc_sei_injector_t *inj = NULL;
+    mc_sei_extractor_t *ext = NULL;
+    int i;
+
+    memset(&encoder, 0x00, sizeof(encoder));
+    encoder.codec_id = MEDIA_CODEC_ID_H265;
+    encoder.encoder = 1;
+    encoder.video_enc_params.width = 64;
+    encoder.video_enc_params.height = 48;
+    encoder.video_enc_params.pix_fmt = MC_PIXEL_FORMAT_NV12;
+    gFakeEncoders[0] = FakeEncoder();
+    gFakeEncoders[0].context = &encoder;
+    memset(&params, 0x00, sizeof(params));
+    memcpy(params.uuid, uuid, sizeof(uuid));
+    params.pool_size = 2;
+    ASSERT_EQ(hb_mm_sei_injector_create(&encoder, &params, &inj), 0);
+
+    // pictures 0 and 2 carry metadata, the pool holds both until encoded
+    memset(&meta, 0x00, sizeof(meta));
+    meta.flags = MC_SEI_META_TIME | MC_SEI_META_GPS | MC_SEI_META_SENSOR;
+    meta.capture_time_us = 1700000000123456ULL;
+    meta.latitude_e7 = 312304560;
+    meta.longitude_e7 = -1214737010;
+    meta.altitude_mm = -1500;
+    meta.sensor_id = 3;
+    for (i = 0; i < 4; i++) {
+        memset(&buffer, 0x00, sizeof(buffer));
+        ASSERT_EQ(hb_mm_mc_dequeue_input_buffer(&encoder, &buffer, 0), 0);
+        buffer.vframe_buf.pts = 100 + i;
+        if (i == 3) {
+            EXPECT_EQ(hb_mm_sei_attach(inj, &buffer, &meta),
+                (int32_t)HB_MEDIA_ERR_INSUFFICIENT_RES);
+        } else {
+            ASSERT_EQ(hb_mm_sei_attach(inj, &buffer,
+                (i == 1) ? NULL : &meta), 0);
+        }
+        ASSERT_EQ(hb_mm_mc_queue_input_buffer(&encoder, &buffer, 0), 0);
+    }
+    // picture 2 is encoded before picture 0 and only frees its own payload
+    memset(&output, 0x00, sizeof(output));
+    output.vstream_buf.pts = 102;
+    ASSERT_EQ(hb_mm_sei_frame_done(inj, &output), 0);
+    meta.flags = 0;
+    memset(&buffer, 0x00, sizeof(buffer));
+    buffer.vframe_buf.pts = 104;
+    ASSERT_EQ(hb_mm_sei_attach(inj, &buffer, &meta), 0);
+    buffer.vframe_buf.pts = 105;
+    EXPECT_EQ(hb_mm_sei_attach(inj, &buffer, &meta),
+        (int32_t)HB_MEDIA_ERR_INSUFFICIENT_RES);
+    // the end of stream frees nothing, picture 0 does
+    output.vstream_buf.pts = 100;
+    output.vstream_buf.stream_end = 1;
+    ASSERT_EQ(hb_mm_sei_frame_done(inj, &output), 0);
+    buffer.vframe_buf.pts = 106;
+    EXPECT_EQ(hb_mm_sei_attach(inj, &buffer, &meta),
+        (int32_t)HB_MEDIA_ERR_INSUFFICIENT_RES);
+    output.vstream_buf.stream_end = 0;
+    ASSERT_EQ(hb_mm_sei_frame_done(inj, &output), 0);
+    buffer.vframe_buf.pts = 107;
+    ASSERT_EQ(hb_mm_sei_attach(inj, &buffer, &meta), 0);
+    ASSERT_EQ(hb_mm_sei_injector_get_stats(inj, &stats), 0);
+    EXPECT_EQ(stats.injected, 4U);
+    EXPECT_EQ(stats.pool_exhausted, 3U);
+    ASSERT_EQ(gFakeEncoders[0].userData.size(), (size_t)4);
+    EXPECT_EQ(gFakeEncoders[0].userDataFrames,
+        std::vector<size_t>({0, 2, 4, 4}));
+    EXPECT_STREQ((const char *)gFakeEncoders[0].userData[0].data(),
+        "dc45e9bde6d948b7962cd820d923eeef+HBM1;s=0;p=100;"
+        "t=1700000000123456;g=312304560,-1214737010,-1500;i=3");
+    EXPECT_STREQ((const char *)gFakeEncoders[0].userData[2].data(),
+        "dc45e9bde6d948b7962cd820d923eeef+HBM1;s=4;p=104");
+    EXPECT_EQ(stats.max_payload,
+        (hb_u32)gFakeEncoders[0].userData[0].size());
+    ASSERT_EQ(hb_mm_sei_injector_destroy(inj), 0);
+
+    memset(&decoder, 0x00, sizeof(decoder));
+    decoder.codec_id = MEDIA_CODEC_ID_H265;
+    gFakeDecoders[0] = FakeDecoder();
+    gFakeDecoders[0].context = &decoder;
+    std::vector<std::vector<uint8_t>> &userData = gFakeDecoders[0].userData;
+    userData.push_back(sei_decoded(gFakeEncoders[0].userData[0], false));
+    userData.push_back(std::vector<uint8_t>(20, 0x11));
+    userData.push_back(sei_decoded(gFakeEncoders[0].userData[1], true));
+    userData.push_back(sei_decoded(gFakeEncoders[0].userData[2], false));
+    userData.back().resize(userData.back().size() - 5);
+    ASSERT_EQ(hb_mm_sei_extractor_create(&decoder, &params, &ext), 0);
+    ASSERT_EQ(hb_mm_sei_extract(ext, &got, 0), 0);
+    EXPECT_EQ(got.flags, (hb_u32)(MC_SEI_META_TIME | MC_SEI_META_GPS |
+        MC_SEI_META_SENSOR));
+    EXPECT_EQ(got.frame_seq, 0U);
+    EXPECT_EQ(got.pts, 100U);
+    EXPECT_EQ(got.capture_time_us, meta.capture_time_us);
+    EXPECT_EQ(got.latitude_e7, meta.latitude_e7);
+    EXPECT_EQ(got.longitude_e7, meta.longitude_e7);
+    EXPECT_EQ(got.altitude_mm, meta.altitude_mm);
+    EXPECT_EQ(got.sensor_id, 3U);
+    // the foreign UUID is skipped, the '+' may stay in front of the text
+    ASSERT_EQ(hb_mm_sei_extract(ext, &got, 0), 0);
+    EXPECT_EQ(got.frame_seq, 2U);
+    EXPECT_EQ(got.pts, 102U);
+    // the cut off pts is skipped too
+    EXPECT_EQ(hb_mm_sei_extract(ext, &got, 0),
+        (int32_t)HB_MEDIA_ERR_WAIT_TIMEOUT);
+    ASSERT_EQ(hb_mm_sei_extractor_get_stats(ext, &stats), 0);
+    EXPECT_EQ(stats.extracted, 2U);
+    EXPECT_EQ(stats.foreign, 1U);
+    EXPECT_EQ(stats.malformed, 1U);
+    EXPECT_EQ(gFakeDecoders[0].userDataReleases, 4);
+    ASSERT_EQ(hb_mm_sei_extractor_destroy(ext), 0);
+
+    EXPECT_EQ(hb_mm_sei_extractor_create(&encoder, &params, &ext),
+        (int32_t)HB_MEDIA_ERR_INVALID_INSTANCE);
+    params.pool_size = MC_SEI_POOL_MAX + 1;
+    EXPECT_EQ(hb_mm_sei_injector_create(&encoder, &params, &inj),
+        (int32_t)HB_MEDIA_ERR_INVALID_PARAMS);
+    gFakeEncoders[0] = FakeEncoder();
+    gFakeDecoders[0] = FakeDecoder();
+}
+
+}  // namespace test
+}  // namespace mediaCodec
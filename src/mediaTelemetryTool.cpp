@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "hb_media_codec.h"
+#include "hb_media_error.h"
+#include "hb_media_telemetry.h"
+
+// 汇总编码遥测文件, 打印每一列的分位数
+#define TAG "[MediaTelemetryTool]"
+
+static const double gPercentiles[] = {50.0, 90.0, 99.0, 99.9};
+#define PERCENTILE_NUM (sizeof(gPercentiles) / sizeof(gPercentiles[0]))
+
+static hb_u64 get_time_us(void)
+{
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (hb_u64)tp.tv_sec * 1000000 + tp.tv_nsec / 1000;
+}
+
+static void print_header(void)
+{
+    size_t i;
+    printf("%-16s %10s %10s", "column", "count", "min");
+    for (i = 0; i < PERCENTILE_NUM; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "p%g", gPercentiles[i]);
+        printf(" %10s", name);
+    }
+    printf(" %10s %12s\n", "max", "mean");
+}
+
+// 通用列: 用 nth_element 求分位数, 会重排 values
+static void print_values(const char *name, std::vector<hb_u64> &values)
+{
+    hb_u64 sum = 0, value;
+    size_t i, rank;
+
+    if (values.empty()) {
+        printf("%-16s %10d\n", name, 0);
+        return;
+    }
+    for (i = 0; i < values.size(); i++) {
+        sum += values[i];
+    }
+    printf("%-16s %10zu %10llu", name, values.size(),
+        (unsigned long long)*std::min_element(values.begin(), values.end()));
+    // 分位数递增, 每次只需在上一次的右侧继续划分
+    for (i = 0, rank = 0; i < PERCENTILE_NUM; i++) {
+        size_t next = (size_t)(gPercentiles[i] / 100.0 * (values.size() - 1));
+        std::nth_element(values.begin() + rank, values.begin() + next,
+            values.end());
+        rank = next;
+        value = values[next];
+        printf(" %10llu", (unsigned long long)value);
+    }
+    printf(" %10llu %12.2f\n",
+        (unsigned long long)*std::max_element(values.begin() + rank,
+        values.end()), (double)sum / values.size());
+}
+
+// 8 位列: 直接用直方图
+static void print_histogram(const char *name, const hb_u64 hist[256])
+{
+    hb_u64 count = 0, sum = 0, seen;
+    int i, min = -1, max = 0;
+    size_t p;
+
+    for (i = 0; i < 256; i++) {
+        if (hist[i] == 0) {
+            continue;
+        }
+        min = (min < 0) ? i : min;
+        max = i;
+        count += hist[i];
+        sum += hist[i] * i;
+    }
+    if (count == 0) {
+        printf("%-16s %10d\n", name, 0);
+        return;
+    }
+    printf("%-16s %10llu %10d", name, (unsigned long long)count, min);
+    for (p = 0; p < PERCENTILE_NUM; p++) {
+        hb_u64 rank = (hb_u64)(gPercentiles[p] / 100.0 * (count - 1));
+        for (i = 0, seen = 0; i < 256; i++) {
+            seen += hist[i];
+            if (seen > rank) {
+                break;
+            }
+        }
+        printf(" %10d", i);
+    }
+    printf(" %10d %12.2f\n", max, (double)sum / count);
+}
+
+static bool is_intra(hb_s8 type)
+{
+    return (type == MC_H264_NALU_TYPE_I) || (type == MC_H264_NALU_TYPE_IDR) ||
+        (type == MC_H265_NALU_TYPE_IDR);
+}
+
+int main(int argc, char *argv[])
+{
+    mc_telemetry_reader_t *reader = NULL;
+    std::vector<hb_u64> latency, cycle, bytes, intraBytes, interBytes;
+    hb_u64 qpHist[256], tidHist[256], skipped = 0;
+    hb_u64 frames = 0, chunk, start;
+    const void *data;
+    hb_u32 i, num;
+    hb_s32 ret;
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <telemetry file>\n", argv[0]);
+        return 1;
+    }
+    start = get_time_us();
+    ret = hb_mm_telemetry_open(argv[1], &reader);
+    if (ret != 0) {
+        fprintf(stderr, "%s Fail to open %s(ret=%d).\n", TAG, argv[1], ret);
+        return 1;
+    }
+    hb_mm_telemetry_get_frames(reader, &frames);
+    latency.reserve(frames);
+    cycle.reserve(frames);
+    bytes.reserve(frames);
+    memset(qpHist, 0x00, sizeof(qpHist));
+    memset(tidHist, 0x00, sizeof(tidHist));
+
+    for (chunk = 0; chunk * MC_TELEMETRY_CHUNK_FRAMES < frames; chunk++) {
+        const hb_u64 *queueUs, *dequeueUs;
+        const hb_u32 *frameCycle, *picByte;
+        const hb_u8 *qp, *skip, *tid;
+        const hb_s8 *nalu;
+
+        hb_mm_telemetry_get_column(reader, MC_TELEMETRY_COLUMN_QUEUE_US,
+            chunk, &data, &num);
+        queueUs = (const hb_u64 *)data;
+        hb_mm_telemetry_get_column(reader, MC_TELEMETRY_COLUMN_DEQUEUE_US,
+            chunk, &data, &num);
+        dequeueUs = (const hb_u64 *)data;
+        hb_mm_telemetry_get_column(reader, MC_TELEMETRY_COLUMN_FRAME_CYCLE,
+            chunk, &data, &num);
+        frameCycle = (const hb_u32 *)data;
+        hb_mm_telemetry_get_column(reader, MC_TELEMETRY_COLUMN_ENC_PIC_BYTE,
+            chunk, &data, &num);
+        picByte = (const hb_u32 *)data;
+        hb_mm_telemetry_get_column(reader, MC_TELEMETRY_COLUMN_AVG_MB_QP,
+            chunk, &data, &num);
+        qp = (const hb_u8 *)data;
+        hb_mm_telemetry_get_column(reader, MC_TELEMETRY_COLUMN_NALU_TYPE,
+            chunk, &data, &num);
+        nalu = (const hb_s8 *)data;
+        hb_mm_telemetry_get_column(reader, MC_TELEMETRY_COLUMN_PIC_SKIPPED,
+            chunk, &data, &num);
+        skip = (const hb_u8 *)data;
+        hb_mm_telemetry_get_column(reader, MC_TELEMETRY_COLUMN_TEMPORAL_ID,
+            chunk, &data, &num);
+        tid = (const hb_u8 *)data;
+
+        for (i = 0; i < num; i++) {
+            // 0 表示没有对应的入队时间
+            if ((queueUs[i] != 0) && (dequeueUs[i] >= queueUs[i])) {
+                latency.push_back(dequeueUs[i] - queueUs[i]);
+            }
+            cycle.push_back(frameCycle[i]);
+            bytes.push_back(picByte[i]);
+            if (is_intra(nalu[i])) {
+                intraBytes.push_back(picByte[i]);
+            } else {
+                interBytes.push_back(picByte[i]);
+            }
+            qpHist[qp[i]]++;
+            tidHist[tid[i]]++;
+            skipped += skip[i];
+        }
+    }
+    hb_mm_telemetry_close(reader);
+
+    printf("%s %s: %llu pictures, %llu skipped\n", TAG, argv[1],
+        (unsigned long long)frames, (unsigned long long)skipped);
+    print_header();
+    print_values("latency_us", latency);
+    print_values("frame_cycle", cycle);
+    print_values("enc_pic_byte", bytes);
+    print_values("intra_byte", intraBytes);
+    print_values("inter_byte", interBytes);
+    print_histogram("avg_mb_qp", qpHist);
+    print_histogram("temporal_id", tidHist);
+    printf("%s done in %llu ms\n", TAG,
+        (unsigned long long)((get_time_us() - start) / 1000));
+
+    return 0;
+}
@@ -0,0 +1,366 @@
+#include <stdlib.h>
+
+#include "media_block.h"
+#include "media_common.h"
+#include "media_simd.h"
+
+static void blk_sad_c(const hb_u8 *a, hb_s32 a_stride, const hb_u8 *b,
+		hb_s32 b_stride, hb_s32 width, hb_s32 rows, hb_u32 *sad)
+{
+	hb_s32 x, y, blocks;
+
+	blocks = (width + MEDIA_BLOCK_SIZE - 1) / MEDIA_BLOCK_SIZE;
+	for (x = 0; x < blocks; x++) {
+		sad[x] = 0;
+	}
+	for (y = 0; y < rows; y++) {
+		for (x = 0; x < width; x++) {
+			sad[x / MEDIA_BLOCK_SIZE] += (hb_u32)abs(a[x] - b[x]);
+		}
+		a += a_stride;
+		b += b_stride;
+	}
+}
+
+static void blk_var_c(const hb_u8 *src, hb_s32 stride, hb_s32 width,
+		hb_s32 rows, hb_u32 *sum, hb_u32 *sqsum)
+{
+	hb_s32 x, y, blocks;
+
+	blocks = (width + MEDIA_BLOCK_SIZE - 1) / MEDIA_BLOCK_SIZE;
+	for (x = 0; x < blocks; x++) {
+		sum[x] = 0;
+		sqsum[x] = 0;
+	}
+	for (y = 0; y < rows; y++) {
+		for (x = 0; x < width; x++) {
+			sum[x / MEDIA_BLOCK_SIZE] += src[x];
+			sqsum[x / MEDIA_BLOCK_SIZE] += (hb_u32)src[x] * src[x];
+		}
+		src += stride;
+	}
+}
+
+static hb_u8 blk_mean(hb_u32 sum, hb_u32 n)
+{
+	return (hb_u8)((sum + (n >> 1)) / n);
+}
+
+static void blk_down_c(const hb_u8 *src, hb_s32 stride, hb_s32 width,
+		hb_s32 rows, hb_u8 *dst)
+{
+	hb_s32 x, y, cols;
+	hb_u32 sum;
+
+	for (x = 0; x < width; x += MEDIA_BLOCK_DOWN) {
+		cols = width - x;
+		cols = (cols > MEDIA_BLOCK_DOWN) ? MEDIA_BLOCK_DOWN : cols;
+		sum = 0;
+		for (y = 0; y < rows; y++) {
+			const hb_u8 *p = src + ((size_t)y * stride) + x;
+			hb_s32 i;
+
+			for (i = 0; i < cols; i++) {
+				sum += p[i];
+			}
+		}
+		dst[x / MEDIA_BLOCK_DOWN] = blk_mean(sum, (hb_u32)(rows * cols));
+	}
+}
+
+#if defined(MEDIA_SIMD_X86)
+static void blk_sad_sse2(const hb_u8 *a, hb_s32 a_stride, const hb_u8 *b,
+		hb_s32 b_stride, hb_s32 width, hb_s32 rows, hb_u32 *sad)
+{
+	__m128i acc;
+	hb_s32 x, y;
+
+	for (x = 0; (x + 16) <= width; x += 16) {
+		acc = _mm_setzero_si128();
+		for (y = 0; y < rows; y++) {
+			acc = _mm_add_epi64(acc, _mm_sad_epu8(
+				_mm_loadu_si128((const __m128i *)(a + ((size_t)y * a_stride) + x)),
+				_mm_loadu_si128((const __m128i *)(b + ((size_t)y * b_stride) + x))));
+		}
+		sad[x / 16] = (hb_u32)(_mm_cvtsi128_si32(acc) +
+			_mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+	}
+	if (x < width) {
+		blk_sad_c(a + x, a_stride, b + x, b_stride, width - x, rows,
+			sad + (x / 16));
+	}
+}
+
+static hb_u32 blk_sum_epi32_sse2(__m128i v)
+{
+	v = _mm_add_epi32(v, _mm_srli_si128(v, 8));
+	v = _mm_add_epi32(v, _mm_srli_si128(v, 4));
+	return (hb_u32)_mm_cvtsi128_si32(v);
+}
+
+static void blk_var_sse2(const hb_u8 *src, hb_s32 stride, hb_s32 width,
+		hb_s32 rows, hb_u32 *sum, hb_u32 *sqsum)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i v, lo, hi, s, sq;
+	hb_s32 x, y;
+
+	for (x = 0; (x + 16) <= width; x += 16) {
+		s = _mm_setzero_si128();
+		sq = _mm_setzero_si128();
+		for (y = 0; y < rows; y++) {
+			v = _mm_loadu_si128((const __m128i *)(src +
+				((size_t)y * stride) + x));
+			s = _mm_add_epi64(s, _mm_sad_epu8(v, zero));
+			lo = _mm_unpacklo_epi8(v, zero);
+			hi = _mm_unpackhi_epi8(v, zero);
+			sq = _mm_add_epi32(sq, _mm_add_epi32(_mm_madd_epi16(lo, lo),
+				_mm_madd_epi16(hi, hi)));
+		}
+		sum[x / 16] = (hb_u32)(_mm_cvtsi128_si32(s) +
+			_mm_cvtsi128_si32(_mm_srli_si128(s, 8)));
+		sqsum[x / 16] = blk_sum_epi32_sse2(sq);
+	}
+	if (x < width) {
+		blk_var_c(src + x, stride, width - x, rows, sum + (x / 16),
+			sqsum + (x / 16));
+	}
+}
+
+static void blk_down_sse2(const hb_u8 *src, hb_s32 stride, hb_s32 width,
+		hb_s32 rows, hb_u8 *dst)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const hb_u32 n = (hb_u32)rows * 8;
+	__m128i acc;
+	hb_s32 x, y;
+
+	/* psadbw against zero sums each 8 byte half */
+	for (x = 0; (x + 16) <= width; x += 16) {
+		acc = _mm_setzero_si128();
+		for (y = 0; y < rows; y++) {
+			acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128(
+				(const __m128i *)(src + ((size_t)y * stride) + x)), zero));
+		}
+		dst[x / 8] = blk_mean((hb_u32)_mm_cvtsi128_si32(acc), n);
+		dst[(x / 8) + 1] = blk_mean(
+			(hb_u32)_mm_cvtsi128_si32(_mm_srli_si128(acc, 8)), n);
+	}
+	if (x < width) {
+		blk_down_c(src + x, stride, width - x, rows, dst + (x / 8));
+	}
+}
+
+MEDIA_TARGET_AVX2
+static void blk_sad_avx2(const hb_u8 *a, hb_s32 a_stride, const hb_u8 *b,
+		hb_s32 b_stride, hb_s32 width, hb_s32 rows, hb_u32 *sad)
+{
+	__m256i acc;
+	__m128i lo, hi;
+	hb_s32 x, y;
+
+	/* two blocks per load, each 128 bit lane holds the two halves of one */
+	for (x = 0; (x + 32) <= width; x += 32) {
+		acc = _mm256_setzero_si256();
+		for (y = 0; y < rows; y++) {
+			acc = _mm256_add_epi64(acc, _mm256_sad_epu8(
+				_mm256_loadu_si256((const __m256i *)(a +
+				((size_t)y * a_stride) + x)),
+				_mm256_loadu_si256((const __m256i *)(b +
+				((size_t)y * b_stride) + x))));
+		}
+		lo = _mm256_castsi256_si128(acc);
+		hi = _mm256_extracti128_si256(acc, 1);
+		sad[x / 16] = (hb_u32)(_mm_cvtsi128_si32(lo) +
+			_mm_cvtsi128_si32(_mm_srli_si128(lo, 8)));
+		sad[(x / 16) + 1] = (hb_u32)(_mm_cvtsi128_si32(hi) +
+			_mm_cvtsi128_si32(_mm_srli_si128(hi, 8)));
+	}
+	if (x < width) {
+		blk_sad_sse2(a + x, a_stride, b + x, b_stride, width - x, rows,
+			sad + (x / 16));
+	}
+}
+
+MEDIA_TARGET_AVX2
+static void blk_var_avx2(const hb_u8 *src, hb_s32 stride, hb_s32 width,
+		hb_s32 rows, hb_u32 *sum, hb_u32 *sqsum)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i v, lo, hi, s, sq;
+	__m128i s0, s1;
+	hb_s32 x, y;
+
+	/* unpack stays inside the 128 bit lanes, one block per lane */
+	for (x = 0; (x + 32) <= width; x += 32) {
+		s = _mm256_setzero_si256();
+		sq = _mm256_setzero_si256();
+		for (y = 0; y < rows; y++) {
+			v = _mm256_loadu_si256((const __m256i *)(src +
+				((size_t)y * stride) + x));
+			s = _mm256_add_epi64(s, _mm256_sad_epu8(v, zero));
+			lo = _mm256_unpacklo_epi8(v, zero);
+			hi = _mm256_unpackhi_epi8(v, zero);
+			sq = _mm256_add_epi32(sq, _mm256_add_epi32(
+				_mm256_madd_epi16(lo, lo), _mm256_madd_epi16(hi, hi)));
+		}
+		s0 = _mm256_castsi256_si128(s);
+		s1 = _mm256_extracti128_si256(s, 1);
+		sum[x / 16] = (hb_u32)(_mm_cvtsi128_si32(s0) +
+			_mm_cvtsi128_si32(_mm_srli_si128(s0, 8)));
+		sum[(x / 16) + 1] = (hb_u32)(_mm_cvtsi128_si32(s1) +
+			_mm_cvtsi128_si32(_mm_srli_si128(s1, 8)));
+		sqsum[x / 16] = blk_sum_epi32_sse2(_mm256_castsi256_si128(sq));
+		sqsum[(x / 16) + 1] = blk_sum_epi32_sse2(
+			_mm256_extracti128_si256(sq, 1));
+	}
+	if (x < width) {
+		blk_var_sse2(src + x, stride, width - x, rows, sum + (x / 16),
+			sqsum + (x / 16));
+	}
+}
+
+MEDIA_TARGET_AVX2
+static void blk_down_avx2(const hb_u8 *src, hb_s32 stride, hb_s32 width,
+		hb_s32 rows, hb_u8 *dst)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const hb_u32 n = (hb_u32)rows * 8;
+	__m256i acc;
+	__m128i lo, hi;
+	hb_s32 x, y;
+
+	for (x = 0; (x + 32) <= width; x += 32) {
+		acc = _mm256_setzero_si256();
+		for (y = 0; y < rows; y++) {
+			acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_loadu_si256(
+				(const __m256i *)(src + ((size_t)y * stride) + x)), zero));
+		}
+		lo = _mm256_castsi256_si128(acc);
+		hi = _mm256_extracti128_si256(acc, 1);
+		dst[x / 8] = blk_mean((hb_u32)_mm_cvtsi128_si32(lo), n);
+		dst[(x / 8) + 1] = blk_mean(
+			(hb_u32)_mm_cvtsi128_si32(_mm_srli_si128(lo, 8)), n);
+		dst[(x / 8) + 2] = blk_mean((hb_u32)_mm_cvtsi128_si32(hi), n);
+		dst[(x / 8) + 3] = blk_mean(
+			(hb_u32)_mm_cvtsi128_si32(_mm_srli_si128(hi, 8)), n);
+	}
+	if (x < width) {
+		blk_down_sse2(src + x, stride, width - x, rows, dst + (x / 8));
+	}
+}
+#endif
+
+#if defined(MEDIA_SIMD_NEON)
+static hb_u32 blk_sum_u16_neon(uint16x8_t v)
+{
+	uint64x2_t s = vpaddlq_u32(vpaddlq_u16(v));
+
+	return (hb_u32)(vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1));
+}
+
+static void blk_sad_neon(const hb_u8 *a, hb_s32 a_stride, const hb_u8 *b,
+		hb_s32 b_stride, hb_s32 width, hb_s32 rows, hb_u32 *sad)
+{
+	uint8x16_t va, vb;
+	uint16x8_t acc;
+	hb_s32 x, y;
+
+	/* at most 16 rows of 2 * 255 per lane, 16 bit is enough */
+	for (x = 0; (x + 16) <= width; x += 16) {
+		acc = vdupq_n_u16(0);
+		for (y = 0; y < rows; y++) {
+			va = vld1q_u8(a + ((size_t)y * a_stride) + x);
+			vb = vld1q_u8(b + ((size_t)y * b_stride) + x);
+			acc = vabal_u8(acc, vget_low_u8(va), vget_low_u8(vb));
+			acc = vabal_u8(acc, vget_high_u8(va), vget_high_u8(vb));
+		}
+		sad[x / 16] = blk_sum_u16_neon(acc);
+	}
+	if (x < width) {
+		blk_sad_c(a + x, a_stride, b + x, b_stride, width - x, rows,
+			sad + (x / 16));
+	}
+}
+
+static void blk_var_neon(const hb_u8 *src, hb_s32 stride, hb_s32 width,
+		hb_s32 rows, hb_u32 *sum, hb_u32 *sqsum)
+{
+	uint8x16_t v;
+	uint16x8_t s;
+	uint32x4_t sq;
+	uint64x2_t t;
+	hb_s32 x, y;
+
+	for (x = 0; (x + 16) <= width; x += 16) {
+		s = vdupq_n_u16(0);
+		sq = vdupq_n_u32(0);
+		for (y = 0; y < rows; y++) {
+			v = vld1q_u8(src + ((size_t)y * stride) + x);
+			s = vpadalq_u8(s, v);
+			sq = vpadalq_u16(sq, vmull_u8(vget_low_u8(v), vget_low_u8(v)));
+			sq = vpadalq_u16(sq, vmull_u8(vget_high_u8(v), vget_high_u8(v)));
+		}
+		sum[x / 16] = blk_sum_u16_neon(s);
+		t = vpaddlq_u32(sq);
+		sqsum[x / 16] = (hb_u32)(vgetq_lane_u64(t, 0) + vgetq_lane_u64(t, 1));
+	}
+	if (x < width) {
+		blk_var_c(src + x, stride, width - x, rows, sum + (x / 16),
+			sqsum + (x / 16));
+	}
+}
+
+static void blk_down_neon(const hb_u8 *src, hb_s32 stride, hb_s32 width,
+		hb_s32 rows, hb_u8 *dst)
+{
+	const hb_u32 n = (hb_u32)rows * 8;
+	uint16x8_t acc;
+	uint64x2_t s;
+	hb_s32 x, y;
+
+	for (x = 0; (x + 16) <= width; x += 16) {
+		acc = vdupq_n_u16(0);
+		for (y = 0; y < rows; y++) {
+			acc = vpadalq_u8(acc, vld1q_u8(src + ((size_t)y * stride) + x));
+		}
+		s = vpaddlq_u32(vpaddlq_u16(acc));
+		dst[x / 8] = blk_mean((hb_u32)vgetq_lane_u64(s, 0), n);
+		dst[(x / 8) + 1] = blk_mean((hb_u32)vgetq_lane_u64(s, 1), n);
+	}
+	if (x < width) {
+		blk_down_c(src + x, stride, width - x, rows, dst + (x / 8));
+	}
+}
+#endif
+
+void media_block_get_kernels(media_block_kernels_t *k)
+{
+	k->sad = blk_sad_c;
+	k->var = blk_var_c;
+	k->down = blk_down_c;
+
+	switch (media_simd_isa()) {
+#if defined(MEDIA_SIMD_X86)
+	case MC_SIMD_ISA_AVX2:
+		k->sad = blk_sad_avx2;
+		k->var = blk_var_avx2;
+		k->down = blk_down_avx2;
+		break;
+	case MC_SIMD_ISA_SSE2:
+		k->sad = blk_sad_sse2;
+		k->var = blk_var_sse2;
+		k->down = blk_down_sse2;
+		break;
+#endif
+#if defined(MEDIA_SIMD_NEON)
+	case MC_SIMD_ISA_NEON:
+		k->sad = blk_sad_neon;
+		k->var = blk_var_neon;
+		k->down = blk_down_neon;
+		break;
+#endif
+	default:
+		break;
+	}
+}
@@ -0,0 +1,46 @@
+#ifndef MEDIA_BLOCK_H
+#define MEDIA_BLOCK_H
+
+#include "hb_media_basic_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Width of the blocks of the block kernels */
+#define MEDIA_BLOCK_SIZE 16
+/* Downscaling factor of the down kernel */
+#define MEDIA_BLOCK_DOWN 8
+
+typedef void (*media_block_sad_fn)(const hb_u8 *a, hb_s32 a_stride,
+		const hb_u8 *b, hb_s32 b_stride, hb_s32 width, hb_s32 rows,
+		hb_u32 *sad);
+
+typedef void (*media_block_var_fn)(const hb_u8 *src, hb_s32 stride,
+		hb_s32 width, hb_s32 rows, hb_u32 *sum, hb_u32 *sqsum);
+
+typedef void (*media_block_down_fn)(const hb_u8 *src, hb_s32 stride,
+		hb_s32 width, hb_s32 rows, hb_u8 *dst);
+
+typedef struct _media_block_kernels {
+	/*
+	 * SAD of every MEDIA_BLOCK_SIZE wide block of one block row. The last
+	 * block may be narrower. rows is at most MEDIA_BLOCK_SIZE.
+	 */
+	media_block_sad_fn sad;
+	/* Sum and sum of squares of every block of one block row, same layout */
+	media_block_var_fn var;
+	/*
+	 * Rounded mean of every MEDIA_BLOCK_DOWN wide block of rows rows, at
+	 * most MEDIA_BLOCK_DOWN, into one byte each. The last may be narrower.
+	 */
+	media_block_down_fn down;
+} media_block_kernels_t;
+
+/* The block kernels of the instruction set in use. */
+extern void media_block_get_kernels(media_block_kernels_t *k);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* MEDIA_BLOCK_H */
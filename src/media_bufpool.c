@@ -0,0 +1,414 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "hb_media_bufpool.h"
+#include "media_common.h"
+
+#define TAG "[MEDIABUFPOOL]"
+
+#define BUFPOOL_PAGE_SIZE 4096U
+/* Largest buffer, keeps the rounding inside 32 bits */
+#define BUFPOOL_MAX_SIZE (1U << 31)
+/* First made up physical address of the memfd allocator */
+#define BUFPOOL_MEMFD_PHYS_BASE 0x80000000ULL
+
+typedef struct _bufpool_bucket {
+	hb_u32 capacity;
+	hb_u32 align;
+	hb_u32 used_num;
+	/* Idle buffers, taken from the end so the last returned is reused */
+	mc_bufpool_buffer_t *idle;
+	hb_u32 idle_num;
+	hb_u32 idle_cap;
+} bufpool_bucket_t;
+
+typedef struct _bufpool {
+	mc_bufpool_params_t params;
+	bufpool_bucket_t buckets[MC_BUFPOOL_MAX_BUCKETS];
+	hb_u32 bucket_num;
+	mc_bufpool_stats_t stats;
+} bufpool_t;
+
+static pthread_mutex_t bufpool_lock = PTHREAD_MUTEX_INITIALIZER;
+static bufpool_t bufpool;
+static hb_u64 bufpool_memfd_phys = BUFPOOL_MEMFD_PHYS_BASE;
+
+static hb_s32 bufpool_memfd_alloc(void *userdata, hb_u32 capacity,
+		hb_u32 align, mc_bufpool_buffer_t *buf)
+{
+	hb_u64 phys;
+	void *virt;
+	hb_s32 fd;
+
+	(void)userdata;
+	fd = memfd_create("hb_bufpool", MFD_CLOEXEC);
+	if (fd < 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to create the memfd.(%s)\n",
+			TAG, __FUNCTION__, __LINE__, strerror(errno));
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	virt = MAP_FAILED;
+	if (ftruncate(fd, (off_t)capacity) == 0) {
+		virt = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED,
+			fd, 0);
+	}
+	if (virt == MAP_FAILED) {
+		VLOG(ERR, "%s <%s:%d> Fail to map %u bytes.(%s)\n",
+			TAG, __FUNCTION__, __LINE__, capacity, strerror(errno));
+		close(fd);
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	phys = __atomic_fetch_add(&bufpool_memfd_phys,
+		(hb_u64)capacity + align, __ATOMIC_RELAXED);
+	buf->phys_addr = (phys + align - 1) & ~((hb_u64)align - 1);
+	buf->virt_addr = (hb_u8 *)virt;
+	buf->fd = fd;
+	buf->priv = NULL;
+
+	return 0;
+}
+
+static void bufpool_memfd_free(void *userdata, mc_bufpool_buffer_t *buf)
+{
+	(void)userdata;
+	munmap(buf->virt_addr, buf->capacity);
+	close(buf->fd);
+}
+
+static const mc_bufpool_allocator_t *bufpool_allocator(void)
+{
+	static const mc_bufpool_allocator_t memfd = {
+		bufpool_memfd_alloc, bufpool_memfd_free, NULL
+	};
+
+	return (bufpool.params.allocator.alloc != NULL) ?
+		&bufpool.params.allocator : &memfd;
+}
+
+/* Round up to pages, and above 8 pages to 8 steps per power of 2 */
+static hb_u32 bufpool_round(hb_u32 size)
+{
+	hb_u32 step = BUFPOOL_PAGE_SIZE;
+
+	if (size > (BUFPOOL_PAGE_SIZE * 8)) {
+		step = 1U << (28 - __builtin_clz(size));
+	}
+	return (size + step - 1) & ~(step - 1);
+}
+
+static hb_bool bufpool_check(hb_u32 size, hb_u32 align)
+{
+	return (size > 0) && (size <= BUFPOOL_MAX_SIZE) && (align > 0) &&
+		((align & (align - 1)) == 0);
+}
+
+/* Find the bucket of a shape, or add it. Called with the lock held. */
+static bufpool_bucket_t *bufpool_get_bucket(hb_u32 capacity, hb_u32 align,
+		hb_bool add)
+{
+	bufpool_bucket_t *b, *empty = NULL;
+	hb_u32 i;
+
+	for (i = 0; i < bufpool.bucket_num; i++) {
+		b = &bufpool.buckets[i];
+		if ((b->capacity == capacity) && (b->align == align)) {
+			return b;
+		}
+		if ((empty == NULL) && (b->used_num == 0) && (b->idle_num == 0)) {
+			empty = b;
+		}
+	}
+	if (!add) {
+		return NULL;
+	}
+	if (bufpool.bucket_num < MC_BUFPOOL_MAX_BUCKETS) {
+		empty = &bufpool.buckets[bufpool.bucket_num++];
+	}
+	if (empty != NULL) {
+		empty->capacity = capacity;
+		empty->align = align;
+	}
+
+	return empty;
+}
+
+static void bufpool_update_peak(void)
+{
+	hb_u64 held = bufpool.stats.used_bytes + bufpool.stats.idle_bytes;
+
+	if (held > bufpool.stats.peak_bytes) {
+		bufpool.stats.peak_bytes = held;
+	}
+}
+
+/* Keep an idle buffer. Called with the lock held. */
+static hb_bool bufpool_push_idle(bufpool_bucket_t *b,
+		const mc_bufpool_buffer_t *buf)
+{
+	mc_bufpool_buffer_t *idle;
+	hb_u32 cap;
+
+	if (b->idle_num == b->idle_cap) {
+		cap = (b->idle_cap > 0) ? (b->idle_cap * 2) : 8;
+		idle = (mc_bufpool_buffer_t *)realloc(b->idle, sizeof(*idle) * cap);
+		if (idle == NULL) {
+			return FALSE;
+		}
+		b->idle = idle;
+		b->idle_cap = cap;
+	}
+	b->idle[b->idle_num++] = *buf;
+	bufpool.stats.idle_num++;
+	bufpool.stats.idle_bytes += buf->capacity;
+
+	return TRUE;
+}
+
+/* Allocate one buffer of a bucket shape without the lock */
+static hb_s32 bufpool_alloc(const mc_bufpool_allocator_t *allocator,
+		hb_u32 capacity, hb_u32 align, mc_bufpool_buffer_t *buf)
+{
+	hb_s32 ret;
+
+	memset(buf, 0x00, sizeof(*buf));
+	buf->fd = -1;
+	buf->capacity = capacity;
+	buf->align = align;
+	ret = allocator->alloc(allocator->userdata, capacity, align, buf);
+	if (ret != 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to allocate %u bytes(ret=%d).\n",
+			TAG, __FUNCTION__, __LINE__, capacity, ret);
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	buf->capacity = capacity;
+	buf->align = align;
+
+	return 0;
+}
+
+hb_s32 hb_mm_bufpool_configure(const mc_bufpool_params_t *params)
+{
+	hb_u32 i, held = 0;
+	hb_s32 ret = 0;
+
+	if ((params == NULL) ||
+		((params->allocator.alloc == NULL) != (params->allocator.free == NULL))) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(params=%p).\n",
+			TAG, __FUNCTION__, __LINE__, params);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	pthread_mutex_lock(&bufpool_lock);
+	/* buckets being filled without the lock count too */
+	for (i = 0; i < bufpool.bucket_num; i++) {
+		held += bufpool.buckets[i].used_num + bufpool.buckets[i].idle_num;
+	}
+	if ((held > 0) && (memcmp(&params->allocator, &bufpool.params.allocator,
+		sizeof(params->allocator)) != 0)) {
+		VLOG(ERR, "%s <%s:%d> Can't change the allocator of %u buffers.\n",
+			TAG, __FUNCTION__, __LINE__, held);
+		ret = HB_MEDIA_ERR_OPERATION_NOT_ALLOWED;
+	} else {
+		bufpool.params = *params;
+	}
+	pthread_mutex_unlock(&bufpool_lock);
+
+	return ret;
+}
+
+hb_s32 hb_mm_bufpool_prewarm(hb_u32 size, hb_u32 align, hb_u32 num)
+{
+	const mc_bufpool_allocator_t *allocator;
+	mc_bufpool_buffer_t buf;
+	bufpool_bucket_t *b;
+	hb_u32 capacity;
+	hb_s32 ret = 0;
+
+	if (!bufpool_check(size, align)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(size=%u, align=%u).\n",
+			TAG, __FUNCTION__, __LINE__, size, align);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	capacity = bufpool_round(size);
+
+	pthread_mutex_lock(&bufpool_lock);
+	b = bufpool_get_bucket(capacity, align, TRUE);
+	if (b != NULL) {
+		b->used_num++;
+	}
+	while ((b != NULL) && (b->idle_num < num)) {
+		allocator = bufpool_allocator();
+		pthread_mutex_unlock(&bufpool_lock);
+		ret = bufpool_alloc(allocator, capacity, align, &buf);
+		pthread_mutex_lock(&bufpool_lock);
+		if (ret != 0) {
+			break;
+		}
+		if (!bufpool_push_idle(b, &buf)) {
+			allocator->free(allocator->userdata, &buf);
+			ret = HB_MEDIA_ERR_INSUFFICIENT_RES;
+			break;
+		}
+	}
+	if (b != NULL) {
+		b->used_num--;
+	} else {
+		ret = HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	bufpool_update_peak();
+	bufpool.stats.buckets = bufpool.bucket_num;
+	pthread_mutex_unlock(&bufpool_lock);
+
+	return ret;
+}
+
+hb_s32 hb_mm_bufpool_get(hb_u32 size, hb_u32 align, mc_bufpool_buffer_t *buf)
+{
+	const mc_bufpool_allocator_t *allocator;
+	bufpool_bucket_t *b;
+	hb_u32 capacity;
+	hb_s32 ret = 0;
+
+	if ((buf == NULL) || !bufpool_check(size, align)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(size=%u, align=%u).\n",
+			TAG, __FUNCTION__, __LINE__, size, align);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	capacity = bufpool_round(size);
+
+	pthread_mutex_lock(&bufpool_lock);
+	b = bufpool_get_bucket(capacity, align, TRUE);
+	if (b == NULL) {
+		pthread_mutex_unlock(&bufpool_lock);
+		VLOG(ERR, "%s <%s:%d> All %d buckets are in use.\n",
+			TAG, __FUNCTION__, __LINE__, MC_BUFPOOL_MAX_BUCKETS);
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	/* holds the bucket while the lock is dropped */
+	b->used_num++;
+	if (b->idle_num > 0) {
+		*buf = b->idle[--b->idle_num];
+		bufpool.stats.idle_num--;
+		bufpool.stats.idle_bytes -= capacity;
+		bufpool.stats.hits++;
+	} else {
+		/* the allocator may be slow, other sessions go on meanwhile */
+		allocator = bufpool_allocator();
+		pthread_mutex_unlock(&bufpool_lock);
+		ret = bufpool_alloc(allocator, capacity, align, buf);
+		pthread_mutex_lock(&bufpool_lock);
+		if (ret == 0) {
+			bufpool.stats.misses++;
+		} else {
+			b->used_num--;
+		}
+	}
+	if (ret == 0) {
+		buf->size = size;
+		bufpool.stats.used_num++;
+		bufpool.stats.used_size += size;
+		bufpool.stats.used_bytes += capacity;
+		bufpool_update_peak();
+	}
+	bufpool.stats.buckets = bufpool.bucket_num;
+	pthread_mutex_unlock(&bufpool_lock);
+
+	return ret;
+}
+
+hb_s32 hb_mm_bufpool_put(const mc_bufpool_buffer_t *buf)
+{
+	const mc_bufpool_allocator_t *allocator;
+	bufpool_bucket_t *b;
+	hb_bool keep;
+
+	if ((buf == NULL) || (buf->virt_addr == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	pthread_mutex_lock(&bufpool_lock);
+	b = bufpool_get_bucket(buf->capacity, buf->align, FALSE);
+	if ((b == NULL) || (b->used_num == 0)) {
+		pthread_mutex_unlock(&bufpool_lock);
+		VLOG(ERR, "%s <%s:%d> Buffer %p isn't from the pool.\n",
+			TAG, __FUNCTION__, __LINE__, buf->virt_addr);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	b->used_num--;
+	bufpool.stats.used_num--;
+	bufpool.stats.used_size -= buf->size;
+	bufpool.stats.used_bytes -= buf->capacity;
+	keep = (bufpool.params.max_idle_bytes == 0) ||
+		((bufpool.stats.idle_bytes + buf->capacity) <=
+		bufpool.params.max_idle_bytes);
+	if (!keep || !bufpool_push_idle(b, buf)) {
+		allocator = bufpool_allocator();
+		allocator->free(allocator->userdata, (mc_bufpool_buffer_t *)buf);
+		bufpool.stats.trimmed++;
+	}
+	pthread_mutex_unlock(&bufpool_lock);
+
+	return 0;
+}
+
+hb_s32 hb_mm_bufpool_trim(hb_u64 max_idle_bytes)
+{
+	const mc_bufpool_allocator_t *allocator;
+	bufpool_bucket_t *b, *largest;
+	hb_u32 i;
+
+	pthread_mutex_lock(&bufpool_lock);
+	allocator = bufpool_allocator();
+	while (bufpool.stats.idle_bytes > max_idle_bytes) {
+		largest = NULL;
+		for (i = 0; i < bufpool.bucket_num; i++) {
+			b = &bufpool.buckets[i];
+			if ((b->idle_num > 0) && ((largest == NULL) ||
+				((hb_u64)b->idle_num * b->capacity >
+				(hb_u64)largest->idle_num * largest->capacity))) {
+				largest = b;
+			}
+		}
+		/* the oldest idle buffer of the bucket goes first */
+		allocator->free(allocator->userdata, &largest->idle[0]);
+		memmove(&largest->idle[0], &largest->idle[1],
+			sizeof(largest->idle[0]) * (largest->idle_num - 1));
+		largest->idle_num--;
+		bufpool.stats.idle_num--;
+		bufpool.stats.idle_bytes -= largest->capacity;
+		bufpool.stats.trimmed++;
+		if (largest->idle_num == 0) {
+			free(largest->idle);
+			largest->idle = NULL;
+			largest->idle_cap = 0;
+		}
+	}
+	pthread_mutex_unlock(&bufpool_lock);
+
+	return 0;
+}
+
+hb_s32 hb_mm_bufpool_get_stats(mc_bufpool_stats_t *stats)
+{
+	hb_u64 held;
+
+	if (stats == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	pthread_mutex_lock(&bufpool_lock);
+	*stats = bufpool.stats;
+	pthread_mutex_unlock(&bufpool_lock);
+	held = stats->used_bytes + stats->idle_bytes;
+	stats->fragmentation = (held == 0) ? 0 : (hb_u32)(((held -
+		stats->used_size) * 1000) / held);
+
+	return 0;
+}
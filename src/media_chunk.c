@@ -0,0 +1,332 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hb_media_chunk.h"
+#include "hb_media_nal.h"
+#include "media_common.h"
+
+#define TAG "[MEDIACHUNK]"
+
+/* VPS, SPS and PPS */
+#define CHUNK_PARAM_SET_TYPES 3
+
+typedef struct _ck_worker {
+	const mc_chunk_params_t *params;
+	media_codec_context_t *context;
+	hb_u32 start;
+	hb_u32 end;
+	hb_u8 *data;
+	hb_u32 size;
+	hb_u32 capacity;
+	hb_u64 busy_us;
+	hb_s32 ret;
+} chunk_worker_t;
+
+typedef struct _ck_param_set {
+	hb_s32 type;
+	/* Payload after the start code, in the joined stream */
+	const hb_u8 *payload;
+	hb_u32 size;
+} chunk_param_set_t;
+
+static hb_u64 chunk_get_time_us(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+	return ((hb_u64)tp.tv_sec * 1000000) + ((hb_u64)tp.tv_nsec / 1000);
+}
+
+static hb_s32 chunk_append(chunk_worker_t *w, const hb_u8 *data, hb_u32 size)
+{
+	hb_u8 *grown;
+	hb_u32 capacity;
+
+	if ((w->size + size) > w->capacity) {
+		capacity = (w->capacity > 0) ? w->capacity : 65536;
+		while (capacity < (w->size + size)) {
+			capacity *= 2;
+		}
+		grown = (hb_u8 *)realloc(w->data, capacity);
+		if (grown == NULL) {
+			return HB_MEDIA_ERR_INSUFFICIENT_RES;
+		}
+		w->data = grown;
+		w->capacity = capacity;
+	}
+	memcpy(w->data + w->size, data, size);
+	w->size += size;
+
+	return 0;
+}
+
+/* Feed the frames of one chunk and collect its stream until the end */
+static hb_s32 chunk_encode(chunk_worker_t *w)
+{
+	const mc_chunk_params_t *params = w->params;
+	media_codec_buffer_t input, output;
+	media_codec_output_buffer_info_t info;
+	hb_u32 next = w->start;
+	hb_bool inputEnd = FALSE, outputEnd = FALSE;
+	hb_s32 ret;
+
+	while (!outputEnd) {
+		if (!inputEnd) {
+			memset(&input, 0x00, sizeof(input));
+			ret = hb_mm_mc_dequeue_input_buffer(w->context, &input,
+				params->timeout);
+			if (ret == 0) {
+				if (next < w->end) {
+					ret = params->read_frame(params->userdata, next,
+						&input.vframe_buf);
+					if (ret != 0) {
+						VLOG(ERR, "%s <%s:%d> Failed to read frame %u(%d).\n",
+							TAG, __FUNCTION__, __LINE__, next, ret);
+						return ret;
+					}
+					input.vframe_buf.pts = next++;
+					input.vframe_buf.frame_end = FALSE;
+				} else {
+					input.vframe_buf.size = 0;
+					input.vframe_buf.frame_end = TRUE;
+					inputEnd = TRUE;
+				}
+				ret = hb_mm_mc_queue_input_buffer(w->context, &input,
+					params->timeout);
+			}
+			if ((ret != 0) && (ret != HB_MEDIA_ERR_WAIT_TIMEOUT)) {
+				return ret;
+			}
+		}
+
+		memset(&output, 0x00, sizeof(output));
+		memset(&info, 0x00, sizeof(info));
+		ret = hb_mm_mc_dequeue_output_buffer(w->context, &output, &info,
+			params->timeout);
+		if (ret == HB_MEDIA_ERR_WAIT_TIMEOUT) {
+			continue;
+		}
+		if (ret != 0) {
+			return ret;
+		}
+		ret = chunk_append(w, output.vstream_buf.vir_ptr,
+			output.vstream_buf.size);
+		outputEnd = output.vstream_buf.stream_end;
+		if (hb_mm_mc_queue_output_buffer(w->context, &output,
+			params->timeout) != 0) {
+			ret = HB_MEDIA_ERR_INVALID_BUFFER;
+		}
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+static void *chunk_worker_run(void *arg)
+{
+	chunk_worker_t *w = (chunk_worker_t *)arg;
+	hb_u64 start = chunk_get_time_us();
+
+	w->ret = chunk_encode(w);
+	w->busy_us = chunk_get_time_us() - start;
+
+	return NULL;
+}
+
+static hb_s32 chunk_param_set_slot(media_codec_id_t codec_id, hb_s32 type)
+{
+	if (codec_id == MEDIA_CODEC_ID_H264) {
+		return (type == 7) ? 1 : 2;
+	}
+	return type - 32;
+}
+
+hb_s32 hb_mm_chunk_join(media_codec_id_t codec_id,
+		const hb_u8 *const *chunks, const hb_u32 *sizes, hb_s32 num,
+		hb_u8 *dst, hb_u32 *size, hb_u32 *dropped)
+{
+	chunk_param_set_t last[CHUNK_PARAM_SET_TYPES];
+	chunk_param_set_t *ps;
+	mc_nal_unit_t nal;
+	hb_u32 pos, copied, out = 0, drops = 0, payload;
+	hb_s32 i, ret;
+
+	if ((chunks == NULL) || (sizes == NULL) || (num <= 0) || (dst == NULL) ||
+		(size == NULL) || ((codec_id != MEDIA_CODEC_ID_H264) &&
+		(codec_id != MEDIA_CODEC_ID_H265))) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(codec=%d, num=%d).\n",
+			TAG, __FUNCTION__, __LINE__, codec_id, num);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	memset(last, 0x00, sizeof(last));
+	for (i = 0; i < num; i++) {
+		if ((chunks[i] == NULL) && (sizes[i] > 0)) {
+			return HB_MEDIA_ERR_INVALID_PARAMS;
+		}
+		pos = 0;
+		copied = 0;
+		while ((ret = hb_mm_nal_next(codec_id, chunks[i], sizes[i], &pos,
+			&nal)) == 1) {
+			if (!hb_mm_nal_is_param_set(codec_id, nal.type)) {
+				continue;
+			}
+			ps = &last[chunk_param_set_slot(codec_id, nal.type)];
+			payload = nal.size - nal.start_code_size;
+			if ((ps->payload != NULL) && (ps->size == payload) &&
+				(memcmp(ps->payload, chunks[i] + nal.offset +
+				nal.start_code_size, payload) == 0)) {
+				/* flush what precedes the repeat, skip the repeat */
+				memcpy(dst + out, chunks[i] + copied, nal.offset - copied);
+				out += nal.offset - copied;
+				copied = nal.offset + nal.size;
+				drops++;
+				continue;
+			}
+			memcpy(dst + out, chunks[i] + copied,
+				nal.offset + nal.size - copied);
+			out += nal.offset + nal.size - copied;
+			copied = nal.offset + nal.size;
+			ps->payload = dst + out - payload;
+			ps->size = payload;
+		}
+		if (ret < 0) {
+			return ret;
+		}
+		memcpy(dst + out, chunks[i] + copied, sizes[i] - copied);
+		out += sizes[i] - copied;
+	}
+
+	*size = out;
+	if (dropped != NULL) {
+		*dropped = drops;
+	}
+	return 0;
+}
+
+hb_s32 hb_mm_chunk_encode(const mc_chunk_params_t *params,
+		media_codec_context_t **contexts, hb_s32 num, hb_u8 **stream,
+		hb_u32 *size, mc_chunk_stats_t *stats)
+{
+	chunk_worker_t workers[MC_CHUNK_MAX_INSTANCES];
+	pthread_t threads[MC_CHUNK_MAX_INSTANCES];
+	mc_av_codec_startup_params_t startup;
+	mc_chunk_stats_t st;
+	const hb_u8 *chunks[MC_CHUNK_MAX_INSTANCES];
+	hb_u32 sizes[MC_CHUNK_MAX_INSTANCES];
+	hb_u32 gops, total = 0;
+	hb_u64 start;
+	hb_s32 i, chunkNum, started = 0, spawned = 0, ret = 0;
+
+	if ((params == NULL) || (contexts == NULL) || (stream == NULL) ||
+		(size == NULL) || (num <= 0) || (num > MC_CHUNK_MAX_INSTANCES) ||
+		(params->frame_num == 0) || (params->gop_size == 0) ||
+		(params->read_frame == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(params=%p, num=%d).\n",
+			TAG, __FUNCTION__, __LINE__, params, num);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	gops = (params->frame_num + params->gop_size - 1) / params->gop_size;
+	chunkNum = ((hb_u32)num < gops) ? num : (hb_s32)gops;
+	for (i = 0; i < chunkNum; i++) {
+		if ((contexts[i] == NULL) || !contexts[i]->encoder ||
+			(contexts[i]->codec_id != contexts[0]->codec_id) ||
+			(contexts[i]->video_enc_params.gop_params.decoding_refresh_type
+			!= 2)) {
+			VLOG(ERR, "%s <%s:%d> Instance %d isn't an IDR refreshed encoder "
+				"like instance 0.\n", TAG, __FUNCTION__, __LINE__, i);
+			return HB_MEDIA_ERR_INVALID_INSTANCE;
+		}
+	}
+
+	memset(workers, 0x00, sizeof(workers));
+	memset(&st, 0x00, sizeof(st));
+	st.chunks = chunkNum;
+	for (i = 0; i < chunkNum; i++) {
+		workers[i].params = params;
+		workers[i].context = contexts[i];
+		workers[i].start = (gops * i / chunkNum) * params->gop_size;
+		workers[i].end = (gops * (i + 1) / chunkNum) * params->gop_size;
+		if (workers[i].end > params->frame_num) {
+			workers[i].end = params->frame_num;
+		}
+		st.chunk_start[i] = workers[i].start;
+		st.chunk_frames[i] = workers[i].end - workers[i].start;
+	}
+
+	start = chunk_get_time_us();
+	/* the setup isn't thread safe, only the buffer loops run in parallel */
+	memset(&startup, 0x00, sizeof(startup));
+	for (started = 0; started < chunkNum; started++) {
+		ret = hb_mm_mc_initialize(contexts[started]);
+		if (ret == 0) {
+			ret = hb_mm_mc_configure(contexts[started]);
+			if (ret == 0) {
+				ret = hb_mm_mc_start(contexts[started], &startup);
+			}
+			if (ret != 0) {
+				hb_mm_mc_release(contexts[started]);
+			}
+		}
+		if (ret != 0) {
+			VLOG(ERR, "%s <%s:%d> Failed to start instance %d(%d).\n",
+				TAG, __FUNCTION__, __LINE__, started, ret);
+			break;
+		}
+	}
+	if (ret == 0) {
+		for (spawned = 0; spawned < chunkNum; spawned++) {
+			if (pthread_create(&threads[spawned], NULL, chunk_worker_run,
+				&workers[spawned]) != 0) {
+				ret = HB_MEDIA_ERR_INSUFFICIENT_RES;
+				break;
+			}
+		}
+	}
+	for (i = 0; i < spawned; i++) {
+		pthread_join(threads[i], NULL);
+		if ((ret == 0) && (workers[i].ret != 0)) {
+			VLOG(ERR, "%s <%s:%d> Instance %d failed(%d).\n",
+				TAG, __FUNCTION__, __LINE__, i, workers[i].ret);
+			ret = workers[i].ret;
+		}
+		st.busy_us[i] = workers[i].busy_us;
+	}
+	for (i = 0; i < started; i++) {
+		hb_mm_mc_stop(contexts[i]);
+		hb_mm_mc_release(contexts[i]);
+	}
+
+	if (ret == 0) {
+		for (i = 0; i < chunkNum; i++) {
+			chunks[i] = workers[i].data;
+			sizes[i] = workers[i].size;
+			total += workers[i].size;
+		}
+		*stream = (hb_u8 *)malloc((total > 0) ? total : 1);
+		if (*stream == NULL) {
+			ret = HB_MEDIA_ERR_INSUFFICIENT_RES;
+		} else {
+			ret = hb_mm_chunk_join(contexts[0]->codec_id, chunks, sizes,
+				chunkNum, *stream, size, &st.dropped_param_sets);
+			if (ret != 0) {
+				free(*stream);
+				*stream = NULL;
+			}
+		}
+	}
+	st.wall_us = chunk_get_time_us() - start;
+	st.bytes = (ret == 0) ? *size : 0;
+	for (i = 0; i < chunkNum; i++) {
+		free(workers[i].data);
+	}
+	if (stats != NULL) {
+		*stats = st;
+	}
+
+	return ret;
+}
@@ -0,0 +1,15 @@
+#ifndef MEDIA_COMMON_H
+#define MEDIA_COMMON_H
+
+#include "hb_media_basic_types.h"
+#include "hb_media_error.h"
+#include "media_log.h"
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#endif /* MEDIA_COMMON_H */
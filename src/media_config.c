@@ -0,0 +1,1120 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hb_media_config.h"
+#include "media_common.h"
+
+#define TAG "[MEDIACONFIG]"
+
+#define CONFIG_MAGIC 0x46434248U /* "HBCF" */
+
+/* Codecs a section applies to */
+#define CONFIG_CODEC_H264 (1U << 0)
+#define CONFIG_CODEC_H265 (1U << 1)
+#define CONFIG_CODEC_MJPEG (1U << 2)
+#define CONFIG_CODEC_JPEG (1U << 3)
+#define CONFIG_CODEC_H26X (CONFIG_CODEC_H264 | CONFIG_CODEC_H265)
+#define CONFIG_CODEC_ALL (CONFIG_CODEC_H26X | CONFIG_CODEC_MJPEG | \
+	CONFIG_CODEC_JPEG)
+
+/* Little endian on disk, the host and the SoC agree */
+typedef struct _config_header {
+	hb_u32 magic;
+	hb_u32 version;
+	hb_u32 header_size;
+	hb_s32 codec_id;
+	hb_u32 sections;
+	hb_u32 section_num;
+	hb_u32 total_size;
+	/* CRC32 of everything behind the header */
+	hb_u32 crc32;
+} config_header_t;
+
+/* Followed by size bytes of payload, padded to 4 bytes */
+typedef struct _config_section_header {
+	hb_u16 id;
+	hb_u16 reserved;
+	hb_u32 size;
+} config_section_header_t;
+
+/* Payload of the ROI section, followed by the map */
+typedef struct _config_roi_payload {
+	hb_u32 roi_enable;
+	hb_u32 roi_map_array_count;
+} config_roi_payload_t;
+
+typedef hb_s32 (*config_get_fn)(media_codec_context_t *context, void *params);
+typedef hb_s32 (*config_set_fn)(media_codec_context_t *context,
+		const void *params);
+
+typedef struct _config_section_desc {
+	const char *name;
+	hb_u32 offset;
+	hb_u32 size;
+	hb_u32 codecs;
+	config_get_fn get;
+	config_set_fn set;
+} config_section_desc_t;
+
+#define CONFIG_SIDE_CALLS(call, type) \
+static hb_s32 config_get_##call(media_codec_context_t *context, \
+		void *params) \
+{ \
+	return hb_mm_mc_get_##call(context, (type *)params); \
+} \
+static hb_s32 config_set_##call(media_codec_context_t *context, \
+		const void *params) \
+{ \
+	return hb_mm_mc_set_##call(context, (const type *)params); \
+}
+
+CONFIG_SIDE_CALLS(longterm_ref_mode, mc_video_longterm_ref_mode_t)
+CONFIG_SIDE_CALLS(intra_refresh_config, mc_video_intra_refresh_params_t)
+CONFIG_SIDE_CALLS(deblk_filter_config, mc_video_deblk_filter_params_t)
+CONFIG_SIDE_CALLS(sao_config, mc_h265_sao_params_t)
+CONFIG_SIDE_CALLS(entropy_config, mc_h264_entropy_params_t)
+CONFIG_SIDE_CALLS(vui_timing_config, mc_video_vui_timing_params_t)
+CONFIG_SIDE_CALLS(vui_config, mc_video_vui_params_t)
+CONFIG_SIDE_CALLS(slice_config, mc_video_slice_params_t)
+CONFIG_SIDE_CALLS(3dnr_enc_config, mc_video_3dnr_enc_params_t)
+CONFIG_SIDE_CALLS(smart_bg_enc_config, mc_video_smart_bg_enc_params_t)
+CONFIG_SIDE_CALLS(pred_unit_config, mc_video_pred_unit_params_t)
+CONFIG_SIDE_CALLS(transform_config, mc_video_transform_params_t)
+CONFIG_SIDE_CALLS(roi_config, mc_video_roi_params_t)
+CONFIG_SIDE_CALLS(mode_decision_config, mc_video_mode_decision_params_t)
+
+static hb_s32 config_get_max_bit_rate(media_codec_context_t *context,
+		void *params)
+{
+	return hb_mm_mc_get_max_bit_rate_config(context, (hb_u32 *)params);
+}
+
+static hb_s32 config_set_max_bit_rate(media_codec_context_t *context,
+		const void *params)
+{
+	return hb_mm_mc_set_max_bit_rate_config(context, *(const hb_u32 *)params);
+}
+
+static hb_s32 config_get_explicit_header(media_codec_context_t *context,
+		void *params)
+{
+	return hb_mm_mc_get_explicit_header_config(context, (hb_s32 *)params);
+}
+
+static hb_s32 config_set_explicit_header(media_codec_context_t *context,
+		const void *params)
+{
+	return hb_mm_mc_set_explicit_header_config(context,
+		*(const hb_s32 *)params);
+}
+
+#define CONFIG_SECTION(name, member, codecs, get, set) \
+	{name, offsetof(mc_config_snapshot_t, member), \
+	sizeof(((mc_config_snapshot_t *)0)->member), codecs, get, set}
+
+/* Indexed by mc_config_section_t */
+static const config_section_desc_t config_sections[MC_CONFIG_SECTION_TOTAL] = {
+	CONFIG_SECTION("enc_params", enc_params, CONFIG_CODEC_ALL, NULL, NULL),
+	CONFIG_SECTION("longterm_ref", longterm_ref, CONFIG_CODEC_H26X,
+		config_get_longterm_ref_mode, config_set_longterm_ref_mode),
+	CONFIG_SECTION("intra_refresh", intra_refresh, CONFIG_CODEC_H26X,
+		config_get_intra_refresh_config, config_set_intra_refresh_config),
+	CONFIG_SECTION("max_bit_rate", max_bit_rate, CONFIG_CODEC_H265,
+		config_get_max_bit_rate, config_set_max_bit_rate),
+	CONFIG_SECTION("deblk_filter", deblk_filter, CONFIG_CODEC_H26X,
+		config_get_deblk_filter_config, config_set_deblk_filter_config),
+	CONFIG_SECTION("sao", sao, CONFIG_CODEC_H265,
+		config_get_sao_config, config_set_sao_config),
+	CONFIG_SECTION("entropy", entropy, CONFIG_CODEC_H264,
+		config_get_entropy_config, config_set_entropy_config),
+	CONFIG_SECTION("vui_timing", vui_timing, CONFIG_CODEC_H26X,
+		config_get_vui_timing_config, config_set_vui_timing_config),
+	CONFIG_SECTION("vui", vui, CONFIG_CODEC_H26X,
+		config_get_vui_config, config_set_vui_config),
+	CONFIG_SECTION("slice", slice, CONFIG_CODEC_ALL,
+		config_get_slice_config, config_set_slice_config),
+	CONFIG_SECTION("3dnr", noise_reduction, CONFIG_CODEC_H26X,
+		config_get_3dnr_enc_config, config_set_3dnr_enc_config),
+	CONFIG_SECTION("smart_bg", smart_bg, CONFIG_CODEC_H26X,
+		config_get_smart_bg_enc_config, config_set_smart_bg_enc_config),
+	CONFIG_SECTION("pred_unit", pred_unit, CONFIG_CODEC_H26X,
+		config_get_pred_unit_config, config_set_pred_unit_config),
+	CONFIG_SECTION("transform", transform, CONFIG_CODEC_H26X,
+		config_get_transform_config, config_set_transform_config),
+	CONFIG_SECTION("roi", roi, CONFIG_CODEC_H26X,
+		config_get_roi_config, config_set_roi_config),
+	CONFIG_SECTION("mode_decision", mode_decision, CONFIG_CODEC_H265,
+		config_get_mode_decision_config, config_set_mode_decision_config),
+	CONFIG_SECTION("explicit_header", explicit_header, CONFIG_CODEC_H26X,
+		config_get_explicit_header, config_set_explicit_header),
+};
+
+/* A named 32 bit value of the text format */
+typedef struct _config_field_desc {
+	const char *name;
+	hb_u32 offset;
+	mc_config_section_t section;
+	/* Only valid in this rate control mode, MC_AV_RC_MODE_NONE for all */
+	mc_video_rate_control_mode_t rc_mode;
+	hb_bool is_signed;
+} config_field_desc_t;
+
+#define CONFIG_FIELD(name, member, section, rc_mode, is_signed) \
+	{name, offsetof(mc_config_snapshot_t, member), section, rc_mode, \
+	is_signed}
+#define CONFIG_ENC_FIELD(name, member, is_signed) \
+	CONFIG_FIELD(name, enc_params.member, MC_CONFIG_SECTION_ENC_PARAMS, \
+	MC_AV_RC_MODE_NONE, is_signed)
+#define CONFIG_RC_FIELD(prefix, member, rc_mode, field, is_signed) \
+	CONFIG_FIELD("rc." prefix "." #field, \
+	enc_params.rc_params.member.field, MC_CONFIG_SECTION_ENC_PARAMS, \
+	rc_mode, is_signed)
+#define CONFIG_RC_BITRATE_FIELDS(prefix, member, rc_mode, level_rc) \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, intra_period, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, intra_qp, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, bit_rate, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, frame_rate, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, initial_rc_qp, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, vbv_buffer_size, TRUE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, level_rc, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, min_qp_I, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, max_qp_I, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, min_qp_P, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, max_qp_P, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, min_qp_B, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, max_qp_B, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, hvs_qp_enable, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, hvs_qp_scale, TRUE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, max_delta_qp, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, qp_map_enable, TRUE)
+#define CONFIG_RC_VBR_FIELDS(prefix, member, rc_mode) \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, intra_period, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, intra_qp, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, frame_rate, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, qp_map_enable, TRUE)
+#define CONFIG_RC_FIXQP_FIELDS(prefix, member, rc_mode) \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, intra_period, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, frame_rate, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, force_qp_I, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, force_qp_P, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, force_qp_B, FALSE)
+#define CONFIG_RC_QPMAP_FIELDS(prefix, member, rc_mode) \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, intra_period, FALSE), \
+	CONFIG_RC_FIELD(prefix, member, rc_mode, frame_rate, FALSE)
+
+/**
+ * The common parameters, written in this order. rc.mode comes before the
+ * fields of the modes so the loader knows which one is valid.
+ */
+static const config_field_desc_t config_fields[] = {
+	CONFIG_ENC_FIELD("enc.width", width, TRUE),
+	CONFIG_ENC_FIELD("enc.height", height, TRUE),
+	CONFIG_ENC_FIELD("enc.pix_fmt", pix_fmt, TRUE),
+	CONFIG_ENC_FIELD("enc.frame_buf_count", frame_buf_count, FALSE),
+	CONFIG_ENC_FIELD("enc.external_frame_buf", external_frame_buf, TRUE),
+	CONFIG_ENC_FIELD("enc.bitstream_buf_count", bitstream_buf_count, FALSE),
+	CONFIG_ENC_FIELD("enc.bitstream_buf_size", bitstream_buf_size, FALSE),
+	CONFIG_ENC_FIELD("enc.rot_degree", rot_degree, TRUE),
+	CONFIG_ENC_FIELD("enc.mir_direction", mir_direction, TRUE),
+	CONFIG_ENC_FIELD("enc.frame_cropping_flag", frame_cropping_flag, FALSE),
+	CONFIG_ENC_FIELD("enc.crop_rect.x_pos", crop_rect.x_pos, FALSE),
+	CONFIG_ENC_FIELD("enc.crop_rect.y_pos", crop_rect.y_pos, FALSE),
+	CONFIG_ENC_FIELD("enc.crop_rect.width", crop_rect.width, FALSE),
+	CONFIG_ENC_FIELD("enc.crop_rect.height", crop_rect.height, FALSE),
+	CONFIG_ENC_FIELD("enc.enable_user_pts", enable_user_pts, TRUE),
+	CONFIG_ENC_FIELD("gop.decoding_refresh_type",
+		gop_params.decoding_refresh_type, TRUE),
+	CONFIG_ENC_FIELD("gop.gop_preset_idx", gop_params.gop_preset_idx, FALSE),
+	CONFIG_ENC_FIELD("gop.custom_gop_size", gop_params.custom_gop_size, TRUE),
+	CONFIG_ENC_FIELD("rc.mode", rc_params.mode, TRUE),
+	CONFIG_RC_BITRATE_FIELDS("h264_cbr", h264_cbr_params,
+		MC_AV_RC_MODE_H264CBR, mb_level_rc_enalbe),
+	CONFIG_RC_VBR_FIELDS("h264_vbr", h264_vbr_params, MC_AV_RC_MODE_H264VBR),
+	CONFIG_RC_BITRATE_FIELDS("h264_avbr", h264_avbr_params,
+		MC_AV_RC_MODE_H264AVBR, mb_level_rc_enalbe),
+	CONFIG_RC_FIXQP_FIELDS("h264_fixqp", h264_fixqp_params,
+		MC_AV_RC_MODE_H264FIXQP),
+	CONFIG_RC_QPMAP_FIELDS("h264_qpmap", h264_qpmap_params,
+		MC_AV_RC_MODE_H264QPMAP),
+	CONFIG_RC_BITRATE_FIELDS("h265_cbr", h265_cbr_params,
+		MC_AV_RC_MODE_H265CBR, ctu_level_rc_enalbe),
+	CONFIG_RC_VBR_FIELDS("h265_vbr", h265_vbr_params, MC_AV_RC_MODE_H265VBR),
+	CONFIG_RC_BITRATE_FIELDS("h265_avbr", h265_avbr_params,
+		MC_AV_RC_MODE_H265AVBR, ctu_level_rc_enalbe),
+	CONFIG_RC_FIXQP_FIELDS("h265_fixqp", h265_fixqp_params,
+		MC_AV_RC_MODE_H265FIXQP),
+	CONFIG_RC_QPMAP_FIELDS("h265_qpmap", h265_qpmap_params,
+		MC_AV_RC_MODE_H265QPMAP),
+	CONFIG_FIELD("longterm_ref.use_longterm", longterm_ref.use_longterm,
+		MC_CONFIG_SECTION_LONGTERM_REF, MC_AV_RC_MODE_NONE, FALSE),
+	CONFIG_FIELD("longterm_ref.longterm_pic_period",
+		longterm_ref.longterm_pic_period, MC_CONFIG_SECTION_LONGTERM_REF,
+		MC_AV_RC_MODE_NONE, FALSE),
+	CONFIG_FIELD("longterm_ref.longterm_pic_using_period",
+		longterm_ref.longterm_pic_using_period,
+		MC_CONFIG_SECTION_LONGTERM_REF, MC_AV_RC_MODE_NONE, FALSE),
+	CONFIG_FIELD("intra_refresh.intra_refresh_mode",
+		intra_refresh.intra_refresh_mode, MC_CONFIG_SECTION_INTRA_REFRESH,
+		MC_AV_RC_MODE_NONE, TRUE),
+	CONFIG_FIELD("intra_refresh.intra_refresh_arg",
+		intra_refresh.intra_refresh_arg, MC_CONFIG_SECTION_INTRA_REFRESH,
+		MC_AV_RC_MODE_NONE, FALSE),
+	CONFIG_FIELD("max_bit_rate", max_bit_rate, MC_CONFIG_SECTION_MAX_BIT_RATE,
+		MC_AV_RC_MODE_NONE, FALSE),
+	CONFIG_FIELD("explicit_header", explicit_header,
+		MC_CONFIG_SECTION_EXPLICIT_HEADER, MC_AV_RC_MODE_NONE, TRUE),
+};
+
+#define CONFIG_FIELD_NUM (sizeof(config_fields) / sizeof(config_fields[0]))
+
+static hb_u32 config_codec_bit(media_codec_id_t codec_id)
+{
+	switch (codec_id) {
+	case MEDIA_CODEC_ID_H264:
+		return CONFIG_CODEC_H264;
+	case MEDIA_CODEC_ID_H265:
+		return CONFIG_CODEC_H265;
+	case MEDIA_CODEC_ID_MJPEG:
+		return CONFIG_CODEC_MJPEG;
+	case MEDIA_CODEC_ID_JPEG:
+		return CONFIG_CODEC_JPEG;
+	default:
+		return 0;
+	}
+}
+
+static hb_u32 config_crc32(const hb_u8 *data, hb_u32 size)
+{
+	/* Half byte table of the reflected 0x04c11db7 polynomial */
+	static const hb_u32 table[16] = {
+		0x00000000U, 0x1db71064U, 0x3b6e20c8U, 0x26d930acU,
+		0x76dc4190U, 0x6b6b51f4U, 0x4db26158U, 0x5005713cU,
+		0xedb88320U, 0xf00f9344U, 0xd6d6a3e8U, 0xcb61b38cU,
+		0x9b64c2b0U, 0x86d3d2d4U, 0xa00ae278U, 0xbdbdf21cU,
+	};
+	hb_u32 crc = 0xffffffffU;
+	hb_u32 i;
+
+	for (i = 0; i < size; i++) {
+		crc ^= data[i];
+		crc = (crc >> 4) ^ table[crc & 0xf];
+		crc = (crc >> 4) ^ table[crc & 0xf];
+	}
+	return ~crc;
+}
+
+static hb_u32 config_payload_size(const mc_config_snapshot_t *snap,
+		mc_config_section_t section)
+{
+	if (section == MC_CONFIG_SECTION_ROI) {
+		return sizeof(config_roi_payload_t) +
+			((snap->roi.roi_map_array != NULL) ?
+			snap->roi.roi_map_array_count : 0);
+	}
+	return config_sections[section].size;
+}
+
+static void config_payload_write(const mc_config_snapshot_t *snap,
+		mc_config_section_t section, hb_u8 *out)
+{
+	const config_section_desc_t *desc = &config_sections[section];
+	config_roi_payload_t roi;
+
+	if (section == MC_CONFIG_SECTION_ROI) {
+		roi.roi_enable = snap->roi.roi_enable;
+		roi.roi_map_array_count = snap->roi.roi_map_array_count;
+		if (snap->roi.roi_map_array == NULL) {
+			roi.roi_map_array_count = 0;
+		}
+		memcpy(out, &roi, sizeof(roi));
+		if (roi.roi_map_array_count > 0) {
+			memcpy(out + sizeof(roi), snap->roi.roi_map_array,
+				roi.roi_map_array_count);
+		}
+		return;
+	}
+	memcpy(out, (const hb_u8 *)snap + desc->offset, desc->size);
+	if (section == MC_CONFIG_SECTION_ENC_PARAMS) {
+		/* The QP maps of the QPMAP modes come with every picture */
+		mc_rate_control_params_t *rc = &((mc_video_codec_enc_params_t *)
+			out)->rc_params;
+		if (rc->mode == MC_AV_RC_MODE_H264QPMAP) {
+			rc->h264_qpmap_params.qp_map_array = NULL;
+		} else if (rc->mode == MC_AV_RC_MODE_H265QPMAP) {
+			rc->h265_qpmap_params.qp_map_array = NULL;
+		}
+	}
+}
+
+static hb_s32 config_payload_read(mc_config_snapshot_t *snap,
+		mc_config_section_t section, const hb_u8 *in, hb_u32 size)
+{
+	const config_section_desc_t *desc = &config_sections[section];
+	config_roi_payload_t roi;
+
+	if (section == MC_CONFIG_SECTION_ROI) {
+		if (size < sizeof(roi)) {
+			VLOG(ERR, "%s <%s:%d> Invalid roi section size %u.\n",
+				TAG, __FUNCTION__, __LINE__, size);
+			return HB_MEDIA_ERR_INVALID_PARAMS;
+		}
+		memcpy(&roi, in, sizeof(roi));
+		if (roi.roi_map_array_count != size - sizeof(roi)) {
+			VLOG(ERR, "%s <%s:%d> Invalid roi map size %u of %u.\n",
+				TAG, __FUNCTION__, __LINE__,
+				(hb_u32)(size - sizeof(roi)), roi.roi_map_array_count);
+			return HB_MEDIA_ERR_INVALID_PARAMS;
+		}
+		free(snap->roi.roi_map_array);
+		snap->roi.roi_map_array = NULL;
+		if (roi.roi_map_array_count > 0) {
+			snap->roi.roi_map_array = malloc(roi.roi_map_array_count);
+			if (snap->roi.roi_map_array == NULL) {
+				VLOG(ERR, "%s <%s:%d> Fail to allocate roi map of %u.\n",
+					TAG, __FUNCTION__, __LINE__, roi.roi_map_array_count);
+				return HB_MEDIA_ERR_INSUFFICIENT_RES;
+			}
+			memcpy(snap->roi.roi_map_array, in + sizeof(roi),
+				roi.roi_map_array_count);
+		}
+		snap->roi.roi_enable = roi.roi_enable;
+		snap->roi.roi_map_array_count = roi.roi_map_array_count;
+	} else {
+		if (size != desc->size) {
+			VLOG(ERR, "%s <%s:%d> Invalid %s section size %u(expect %u).\n",
+				TAG, __FUNCTION__, __LINE__, desc->name, size, desc->size);
+			return HB_MEDIA_ERR_INVALID_PARAMS;
+		}
+		memcpy((hb_u8 *)snap + desc->offset, in, size);
+	}
+	snap->sections |= MC_CONFIG_SECTION_BIT(section);
+	return 0;
+}
+
+static hb_s32 config_check_snapshot(const mc_config_snapshot_t *snap)
+{
+	if ((snap == NULL) || (config_codec_bit(snap->codec_id) == 0) ||
+		((snap->sections & ~MC_CONFIG_SECTION_ALL) != 0)) {
+		VLOG(ERR, "%s <%s:%d> Invalid snapshot.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	return 0;
+}
+
+static hb_u32 config_align4(hb_u32 size)
+{
+	return (size + 3) & ~3U;
+}
+
+static hb_s32 config_encode_binary(const mc_config_snapshot_t *snap,
+		hb_u8 **data, hb_u32 *size)
+{
+	config_header_t header;
+	config_section_header_t sh;
+	hb_u32 total = sizeof(header), sections, pos, i;
+	hb_u8 *buf;
+
+	/* The encoding parameters are always there */
+	sections = snap->sections | MC_CONFIG_SECTION_BIT(
+		MC_CONFIG_SECTION_ENC_PARAMS);
+	memset(&header, 0x00, sizeof(header));
+	for (i = 0; i < MC_CONFIG_SECTION_TOTAL; i++) {
+		if (sections & MC_CONFIG_SECTION_BIT(i)) {
+			total += sizeof(sh) + config_align4(config_payload_size(snap,
+				(mc_config_section_t)i));
+			header.section_num++;
+		}
+	}
+	buf = calloc(1, total);
+	if (buf == NULL) {
+		VLOG(ERR, "%s <%s:%d> Fail to allocate %u bytes.\n",
+			TAG, __FUNCTION__, __LINE__, total);
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	for (i = 0, pos = sizeof(header); i < MC_CONFIG_SECTION_TOTAL; i++) {
+		if ((sections & MC_CONFIG_SECTION_BIT(i)) == 0) {
+			continue;
+		}
+		sh.id = (hb_u16)i;
+		sh.reserved = 0;
+		sh.size = config_payload_size(snap, (mc_config_section_t)i);
+		memcpy(buf + pos, &sh, sizeof(sh));
+		config_payload_write(snap, (mc_config_section_t)i,
+			buf + pos + sizeof(sh));
+		pos += sizeof(sh) + config_align4(sh.size);
+	}
+	header.magic = CONFIG_MAGIC;
+	header.version = MC_CONFIG_VERSION;
+	header.header_size = sizeof(header);
+	header.codec_id = snap->codec_id;
+	header.sections = sections;
+	header.total_size = total;
+	header.crc32 = config_crc32(buf + sizeof(header), total - sizeof(header));
+	memcpy(buf, &header, sizeof(header));
+
+	*data = buf;
+	*size = total;
+	return 0;
+}
+
+static hb_s32 config_decode_binary(const hb_u8 *data, hb_u32 size,
+		mc_config_snapshot_t *snap)
+{
+	config_header_t header;
+	config_section_header_t sh;
+	hb_u32 pos, i;
+	hb_s32 ret;
+
+	if (size < sizeof(header)) {
+		VLOG(ERR, "%s <%s:%d> Truncated header(%u bytes).\n",
+			TAG, __FUNCTION__, __LINE__, size);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	memcpy(&header, data, sizeof(header));
+	if (header.version != MC_CONFIG_VERSION) {
+		VLOG(ERR, "%s <%s:%d> Unsupported version %u(expect %u).\n",
+			TAG, __FUNCTION__, __LINE__, header.version, MC_CONFIG_VERSION);
+		return HB_MEDIA_ERR_UNSUPPORTED_FEATURE;
+	}
+	if ((header.header_size < sizeof(header)) ||
+		(header.header_size > size) || (header.total_size != size)) {
+		VLOG(ERR, "%s <%s:%d> Invalid sizes %u/%u of a %u bytes file.\n",
+			TAG, __FUNCTION__, __LINE__, header.header_size,
+			header.total_size, size);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (config_crc32(data + sizeof(header), size - sizeof(header)) !=
+		header.crc32) {
+		VLOG(ERR, "%s <%s:%d> CRC32 mismatch.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	snap->codec_id = (media_codec_id_t)header.codec_id;
+	for (i = 0, pos = header.header_size; i < header.section_num; i++) {
+		if (size - pos < sizeof(sh)) {
+			VLOG(ERR, "%s <%s:%d> Truncated section %u.\n",
+				TAG, __FUNCTION__, __LINE__, i);
+			return HB_MEDIA_ERR_INVALID_PARAMS;
+		}
+		memcpy(&sh, data + pos, sizeof(sh));
+		pos += sizeof(sh);
+		if (size - pos < sh.size) {
+			VLOG(ERR, "%s <%s:%d> Truncated section %u of %u bytes.\n",
+				TAG, __FUNCTION__, __LINE__, sh.id, sh.size);
+			return HB_MEDIA_ERR_INVALID_PARAMS;
+		}
+		/* Sections of later versions are skipped */
+		if (sh.id < MC_CONFIG_SECTION_TOTAL) {
+			ret = config_payload_read(snap, (mc_config_section_t)sh.id,
+				data + pos, sh.size);
+			if (ret != 0) {
+				return ret;
+			}
+		}
+		pos += (config_align4(sh.size) < size - pos) ?
+			config_align4(sh.size) : (size - pos);
+	}
+	if ((snap->sections & MC_CONFIG_SECTION_BIT(
+		MC_CONFIG_SECTION_ENC_PARAMS)) == 0) {
+		VLOG(ERR, "%s <%s:%d> No encoding parameters.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	return 0;
+}
+
+static hb_s32 config_field_valid(const mc_config_snapshot_t *snap,
+		const config_field_desc_t *field)
+{
+	return (field->rc_mode == MC_AV_RC_MODE_NONE) ||
+		(field->rc_mode == snap->enc_params.rc_params.mode);
+}
+
+static hb_s32 config_encode_text(const mc_config_snapshot_t *snap,
+		hb_u8 **data, hb_u32 *size)
+{
+	static const char hex[] = "0123456789abcdef";
+	hb_u32 sections, cap, pos, payload, i, j;
+	hb_u8 *buf, *bytes;
+	hb_s32 value;
+
+	sections = snap->sections | MC_CONFIG_SECTION_BIT(
+		MC_CONFIG_SECTION_ENC_PARAMS);
+	/* One line of at most 96 bytes per field, two digits per hex byte */
+	cap = 256 + CONFIG_FIELD_NUM * 96;
+	for (i = 0; i < MC_CONFIG_SECTION_TOTAL; i++) {
+		if (sections & MC_CONFIG_SECTION_BIT(i)) {
+			cap += 64 + 2 * config_payload_size(snap, (mc_config_section_t)i);
+		}
+	}
+	buf = malloc(cap);
+	if (buf == NULL) {
+		VLOG(ERR, "%s <%s:%d> Fail to allocate %u bytes.\n",
+			TAG, __FUNCTION__, __LINE__, cap);
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	pos = (hb_u32)snprintf((char *)buf, cap,
+		"# hb media encoder configuration snapshot\n"
+		"version = %d\ncodec_id = %d\n", MC_CONFIG_VERSION, snap->codec_id);
+	for (i = 0; i < CONFIG_FIELD_NUM; i++) {
+		if (((sections & MC_CONFIG_SECTION_BIT(config_fields[i].section)) ==
+			0) || !config_field_valid(snap, &config_fields[i])) {
+			continue;
+		}
+		memcpy(&value, (const hb_u8 *)snap + config_fields[i].offset,
+			sizeof(value));
+		if (config_fields[i].is_signed) {
+			pos += (hb_u32)snprintf((char *)buf + pos, cap - pos,
+				"%s = %d\n", config_fields[i].name, value);
+		} else {
+			pos += (hb_u32)snprintf((char *)buf + pos, cap - pos,
+				"%s = %u\n", config_fields[i].name, (hb_u32)value);
+		}
+	}
+	for (i = 0; i < MC_CONFIG_SECTION_TOTAL; i++) {
+		if ((sections & MC_CONFIG_SECTION_BIT(i)) == 0) {
+			continue;
+		}
+		payload = config_payload_size(snap, (mc_config_section_t)i);
+		bytes = malloc(payload);
+		if (bytes == NULL) {
+			free(buf);
+			VLOG(ERR, "%s <%s:%d> Fail to allocate %u bytes.\n",
+				TAG, __FUNCTION__, __LINE__, payload);
+			return HB_MEDIA_ERR_INSUFFICIENT_RES;
+		}
+		config_payload_write(snap, (mc_config_section_t)i, bytes);
+		pos += (hb_u32)snprintf((char *)buf + pos, cap - pos, "hex.%s = ",
+			config_sections[i].name);
+		for (j = 0; j < payload; j++) {
+			buf[pos++] = (hb_u8)hex[bytes[j] >> 4];
+			buf[pos++] = (hb_u8)hex[bytes[j] & 0xf];
+		}
+		buf[pos++] = '\n';
+		free(bytes);
+	}
+
+	*data = buf;
+	*size = pos;
+	return 0;
+}
+
+static hb_s32 config_hex_digit(char c)
+{
+	if ((c >= '0') && (c <= '9')) {
+		return c - '0';
+	}
+	if ((c >= 'a') && (c <= 'f')) {
+		return c - 'a' + 10;
+	}
+	if ((c >= 'A') && (c <= 'F')) {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+static hb_s32 config_parse_hex(mc_config_snapshot_t *snap,
+		mc_config_section_t section, const char *value, hb_u32 line)
+{
+	hb_u32 len = (hb_u32)strlen(value), i;
+	hb_s32 hi, lo, ret;
+	hb_u8 *bytes;
+
+	if (len % 2 != 0) {
+		VLOG(ERR, "%s <%s:%d> Odd hex digits at line %u.\n",
+			TAG, __FUNCTION__, __LINE__, line);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	bytes = malloc(len / 2 + 1);
+	if (bytes == NULL) {
+		VLOG(ERR, "%s <%s:%d> Fail to allocate %u bytes.\n",
+			TAG, __FUNCTION__, __LINE__, len / 2 + 1);
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	for (i = 0; i < len / 2; i++) {
+		hi = config_hex_digit(value[2 * i]);
+		lo = config_hex_digit(value[2 * i + 1]);
+		if ((hi < 0) || (lo < 0)) {
+			free(bytes);
+			VLOG(ERR, "%s <%s:%d> Invalid hex digit at line %u.\n",
+				TAG, __FUNCTION__, __LINE__, line);
+			return HB_MEDIA_ERR_INVALID_PARAMS;
+		}
+		bytes[i] = (hb_u8)((hi << 4) | lo);
+	}
+	ret = config_payload_read(snap, section, bytes, len / 2);
+	free(bytes);
+	return ret;
+}
+
+static hb_s32 config_parse_value(const char *value, hb_bool is_signed,
+		hb_s32 *out)
+{
+	long long v;
+	char *end;
+
+	errno = 0;
+	v = strtoll(value, &end, 0);
+	if ((errno != 0) || (end == value) || (*end != '\0')) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (is_signed ? ((v < INT_MIN) || (v > INT_MAX)) :
+		((v < 0) || (v > (long long)UINT_MAX))) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	*out = (hb_s32)(hb_u32)v;
+	return 0;
+}
+
+static char *config_trim(char *s)
+{
+	char *end;
+
+	while ((*s == ' ') || (*s == '\t')) {
+		s++;
+	}
+	end = s + strlen(s);
+	while ((end > s) && ((end[-1] == ' ') || (end[-1] == '\t') ||
+		(end[-1] == '\r'))) {
+		end--;
+	}
+	*end = '\0';
+	return s;
+}
+
+typedef struct _config_line {
+	char *key;
+	char *value;
+	hb_u32 line;
+} config_line_t;
+
+static hb_s32 config_apply_field(mc_config_snapshot_t *snap,
+		const config_line_t *l)
+{
+	hb_s32 value, ret;
+	hb_u32 i;
+
+	for (i = 0; i < CONFIG_FIELD_NUM; i++) {
+		if (strcmp(l->key, config_fields[i].name) == 0) {
+			break;
+		}
+	}
+	if (i == CONFIG_FIELD_NUM) {
+		VLOG(WARN, "%s <%s:%d> Skip unknown %s at line %u.\n",
+			TAG, __FUNCTION__, __LINE__, l->key, l->line);
+		return 0;
+	}
+	if (!config_field_valid(snap, &config_fields[i])) {
+		VLOG(ERR, "%s <%s:%d> %s doesn't match rc.mode %d at line %u.\n",
+			TAG, __FUNCTION__, __LINE__, l->key,
+			snap->enc_params.rc_params.mode, l->line);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	ret = config_parse_value(l->value, config_fields[i].is_signed, &value);
+	if (ret != 0) {
+		VLOG(ERR, "%s <%s:%d> Invalid value of %s at line %u.\n",
+			TAG, __FUNCTION__, __LINE__, l->key, l->line);
+		return ret;
+	}
+	memcpy((hb_u8 *)snap + config_fields[i].offset, &value, sizeof(value));
+	snap->sections |= MC_CONFIG_SECTION_BIT(config_fields[i].section);
+	return 0;
+}
+
+/**
+ * Two passes over the "key = value" lines: the header and the hex
+ * sections first, then the named values on top of them.
+ */
+static hb_s32 config_decode_text(char *text, mc_config_snapshot_t *snap)
+{
+	hb_s32 version = -1, codec_id = -1, ret = 0;
+	hb_u32 line_num = 1, num = 0, line, i, j;
+	config_line_t *lines;
+	char *cur, *next, *eq, *key;
+
+	for (cur = text; (cur = strchr(cur, '\n')) != NULL; cur++) {
+		line_num++;
+	}
+	lines = malloc(line_num * sizeof(*lines));
+	if (lines == NULL) {
+		VLOG(ERR, "%s <%s:%d> Fail to allocate %u lines.\n",
+			TAG, __FUNCTION__, __LINE__, line_num);
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	for (cur = text, line = 1; cur != NULL; cur = next, line++) {
+		next = strchr(cur, '\n');
+		if (next != NULL) {
+			*next++ = '\0';
+		}
+		key = config_trim(cur);
+		if ((*key == '\0') || (*key == '#')) {
+			continue;
+		}
+		eq = strchr(key, '=');
+		if (eq == NULL) {
+			VLOG(ERR, "%s <%s:%d> Missing '=' at line %u.\n",
+				TAG, __FUNCTION__, __LINE__, line);
+			free(lines);
+			return HB_MEDIA_ERR_INVALID_PARAMS;
+		}
+		*eq = '\0';
+		lines[num].key = config_trim(key);
+		lines[num].value = config_trim(eq + 1);
+		lines[num].line = line;
+		num++;
+	}
+
+	for (i = 0; (i < num) && (ret == 0); i++) {
+		if (strcmp(lines[i].key, "version") == 0) {
+			ret = config_parse_value(lines[i].value, TRUE, &version);
+		} else if (strcmp(lines[i].key, "codec_id") == 0) {
+			ret = config_parse_value(lines[i].value, TRUE, &codec_id);
+		} else if (strncmp(lines[i].key, "hex.", 4) == 0) {
+			for (j = 0; j < MC_CONFIG_SECTION_TOTAL; j++) {
+				if (strcmp(lines[i].key + 4, config_sections[j].name) == 0) {
+					break;
+				}
+			}
+			if ((j == MC_CONFIG_SECTION_TOTAL) ||
+				(version != MC_CONFIG_VERSION)) {
+				/* Layouts of other versions differ, the names don't */
+				VLOG(WARN, "%s <%s:%d> Skip %s of version %d.\n",
+					TAG, __FUNCTION__, __LINE__, lines[i].key, version);
+			} else {
+				ret = config_parse_hex(snap, (mc_config_section_t)j,
+					lines[i].value, lines[i].line);
+			}
+			continue;
+		} else {
+			continue;
+		}
+		if (ret != 0) {
+			VLOG(ERR, "%s <%s:%d> Invalid value of %s at line %u.\n",
+				TAG, __FUNCTION__, __LINE__, lines[i].key, lines[i].line);
+		}
+	}
+	for (i = 0; (i < num) && (ret == 0); i++) {
+		if ((strcmp(lines[i].key, "version") != 0) &&
+			(strcmp(lines[i].key, "codec_id") != 0) &&
+			(strncmp(lines[i].key, "hex.", 4) != 0)) {
+			ret = config_apply_field(snap, &lines[i]);
+		}
+	}
+	free(lines);
+	if (ret != 0) {
+		return ret;
+	}
+	if (codec_id < 0) {
+		VLOG(ERR, "%s <%s:%d> Missing codec_id.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	snap->codec_id = (media_codec_id_t)codec_id;
+	snap->sections |= MC_CONFIG_SECTION_BIT(MC_CONFIG_SECTION_ENC_PARAMS);
+	return 0;
+}
+
+hb_s32 hb_mm_config_capture(media_codec_context_t *context,
+		hb_u32 sections, mc_config_snapshot_t *snap)
+{
+	const config_section_desc_t *desc;
+	mc_video_roi_params_t roi;
+	hb_u32 codecs, i;
+	hb_s32 ret;
+
+	if ((context == NULL) || (snap == NULL) || !context->encoder ||
+		(config_codec_bit(context->codec_id) == 0)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	memset(snap, 0x00, sizeof(*snap));
+	snap->codec_id = context->codec_id;
+	snap->enc_params = context->video_enc_params;
+	snap->sections = MC_CONFIG_SECTION_BIT(MC_CONFIG_SECTION_ENC_PARAMS);
+	codecs = config_codec_bit(context->codec_id);
+
+	for (i = MC_CONFIG_SECTION_ENC_PARAMS + 1; i < MC_CONFIG_SECTION_TOTAL;
+		i++) {
+		desc = &config_sections[i];
+		if (((sections & MC_CONFIG_SECTION_BIT(i)) == 0) ||
+			((desc->codecs & codecs) == 0)) {
+			continue;
+		}
+		if (i == MC_CONFIG_SECTION_ROI) {
+			memset(&roi, 0x00, sizeof(roi));
+			ret = desc->get(context, &roi);
+			snap->roi.roi_enable = roi.roi_enable;
+			snap->sections |= MC_CONFIG_SECTION_BIT(i);
+			/* The map belongs to the codec, keep a copy */
+			if ((ret == 0) && (roi.roi_map_array != NULL) &&
+				(roi.roi_map_array_count > 0)) {
+				snap->roi.roi_map_array = malloc(roi.roi_map_array_count);
+				if (snap->roi.roi_map_array == NULL) {
+					ret = HB_MEDIA_ERR_INSUFFICIENT_RES;
+				} else {
+					memcpy(snap->roi.roi_map_array, roi.roi_map_array,
+						roi.roi_map_array_count);
+					snap->roi.roi_map_array_count = roi.roi_map_array_count;
+				}
+			}
+		} else {
+			ret = desc->get(context, (hb_u8 *)snap + desc->offset);
+			snap->sections |= MC_CONFIG_SECTION_BIT(i);
+		}
+		if (ret != 0) {
+			VLOG(ERR, "%s <%s:%d> Fail to get %s(ret=%d).\n",
+				TAG, __FUNCTION__, __LINE__, desc->name, ret);
+			hb_mm_config_release(snap);
+			return ret;
+		}
+	}
+	return 0;
+}
+
+static hb_s32 config_write_file(const char *path, const hb_u8 *data,
+		hb_u32 size)
+{
+	char tmp[PATH_MAX];
+	hb_u32 done = 0;
+	ssize_t n;
+	hb_s32 fd;
+
+	if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) {
+		VLOG(ERR, "%s <%s:%d> Too long path %s.\n",
+			TAG, __FUNCTION__, __LINE__, path);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	fd = open(tmp, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to open %s(%s).\n",
+			TAG, __FUNCTION__, __LINE__, tmp, strerror(errno));
+		return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+	}
+	while (done < size) {
+		n = write(fd, data + done, size - done);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+		done += (hb_u32)n;
+	}
+	if ((done < size) || (fsync(fd) != 0)) {
+		VLOG(ERR, "%s <%s:%d> Fail to write %s(%s).\n",
+			TAG, __FUNCTION__, __LINE__, tmp, strerror(errno));
+		close(fd);
+		unlink(tmp);
+		return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+	}
+	close(fd);
+	if (rename(tmp, path) != 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to rename %s(%s).\n",
+			TAG, __FUNCTION__, __LINE__, tmp, strerror(errno));
+		unlink(tmp);
+		return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+	}
+	return 0;
+}
+
+hb_s32 hb_mm_config_save(const char *path,
+		const mc_config_snapshot_t *snap, mc_config_format_t format)
+{
+	hb_u8 *data = NULL;
+	hb_u32 size = 0;
+	hb_s32 ret;
+
+	if ((path == NULL) || ((format != MC_CONFIG_FORMAT_BINARY) &&
+		(format != MC_CONFIG_FORMAT_TEXT))) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	ret = config_check_snapshot(snap);
+	if (ret != 0) {
+		return ret;
+	}
+	if (format == MC_CONFIG_FORMAT_BINARY) {
+		ret = config_encode_binary(snap, &data, &size);
+	} else {
+		ret = config_encode_text(snap, &data, &size);
+	}
+	if (ret == 0) {
+		ret = config_write_file(path, data, size);
+	}
+	free(data);
+	return ret;
+}
+
+hb_s32 hb_mm_config_load(const char *path, mc_config_snapshot_t *snap)
+{
+	struct stat st;
+	hb_u8 *data;
+	hb_u32 size, done = 0;
+	ssize_t n;
+	hb_s32 fd, ret;
+
+	if ((path == NULL) || (snap == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to open %s(%s).\n",
+			TAG, __FUNCTION__, __LINE__, path, strerror(errno));
+		return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+	}
+	if ((fstat(fd, &st) != 0) || (st.st_size > (off_t)INT_MAX)) {
+		VLOG(ERR, "%s <%s:%d> Fail to stat %s(%s).\n",
+			TAG, __FUNCTION__, __LINE__, path, strerror(errno));
+		close(fd);
+		return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+	}
+	size = (hb_u32)st.st_size;
+	/* One more byte to terminate the text format */
+	data = malloc(size + 1);
+	if (data == NULL) {
+		VLOG(ERR, "%s <%s:%d> Fail to allocate %u bytes.\n",
+			TAG, __FUNCTION__, __LINE__, size + 1);
+		close(fd);
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	/* A single read unless it is interrupted */
+	while (done < size) {
+		n = read(fd, data + done, size - done);
+		if ((n < 0) && (errno == EINTR)) {
+			continue;
+		}
+		if (n <= 0) {
+			break;
+		}
+		done += (hb_u32)n;
+	}
+	close(fd);
+	if (done < size) {
+		VLOG(ERR, "%s <%s:%d> Fail to read %s(%s).\n",
+			TAG, __FUNCTION__, __LINE__, path, strerror(errno));
+		free(data);
+		return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+	}
+	data[size] = '\0';
+
+	memset(snap, 0x00, sizeof(*snap));
+	if ((size >= sizeof(hb_u32)) && (*(const hb_u32 *)data == CONFIG_MAGIC)) {
+		ret = config_decode_binary(data, size, snap);
+	} else {
+		ret = config_decode_text((char *)data, snap);
+	}
+	free(data);
+	if (ret == 0) {
+		ret = config_check_snapshot(snap);
+	}
+	if (ret != 0) {
+		hb_mm_config_release(snap);
+	}
+	return ret;
+}
+
+hb_s32 hb_mm_config_apply(media_codec_context_t *context,
+		const mc_config_snapshot_t *snap)
+{
+	media_codec_state_t state = MEDIA_CODEC_STATE_NONE;
+	const config_section_desc_t *desc;
+	hb_bool initialized = FALSE;
+	hb_u32 codecs, i;
+	hb_s32 ret;
+
+	if (context == NULL) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	ret = config_check_snapshot(snap);
+	if (ret != 0) {
+		return ret;
+	}
+	ret = hb_mm_mc_get_state(context, &state);
+	if (ret != 0) {
+		return ret;
+	}
+	if (state == MEDIA_CODEC_STATE_UNINITIALIZED) {
+		context->codec_id = snap->codec_id;
+		context->encoder = TRUE;
+		context->video_enc_params = snap->enc_params;
+		ret = hb_mm_mc_initialize(context);
+		if (ret != 0) {
+			VLOG(ERR, "%s <%s:%d> Fail to initialize(ret=%d).\n",
+				TAG, __FUNCTION__, __LINE__, ret);
+			return ret;
+		}
+		initialized = TRUE;
+	} else if ((state == MEDIA_CODEC_STATE_INITIALIZED) &&
+		(context->codec_id == snap->codec_id) && context->encoder) {
+		context->video_enc_params = snap->enc_params;
+	} else {
+		VLOG(ERR, "%s <%s:%d> Invalid state %d of codec %d.\n",
+			TAG, __FUNCTION__, __LINE__, state, context->codec_id);
+		return HB_MEDIA_ERR_OPERATION_NOT_ALLOWED;
+	}
+
+	codecs = config_codec_bit(snap->codec_id);
+	for (i = MC_CONFIG_SECTION_ENC_PARAMS + 1; i < MC_CONFIG_SECTION_TOTAL;
+		i++) {
+		desc = &config_sections[i];
+		if ((snap->sections & MC_CONFIG_SECTION_BIT(i)) == 0) {
+			continue;
+		}
+		if ((desc->codecs & codecs) == 0) {
+			VLOG(WARN, "%s <%s:%d> Skip %s of codec %d.\n",
+				TAG, __FUNCTION__, __LINE__, desc->name, snap->codec_id);
+			continue;
+		}
+		ret = desc->set(context, (const hb_u8 *)snap + desc->offset);
+		if (ret != 0) {
+			VLOG(ERR, "%s <%s:%d> Fail to set %s(ret=%d).\n",
+				TAG, __FUNCTION__, __LINE__, desc->name, ret);
+			goto ERR;
+		}
+	}
+	ret = hb_mm_mc_configure(context);
+	if (ret != 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to configure(ret=%d).\n",
+			TAG, __FUNCTION__, __LINE__, ret);
+		goto ERR;
+	}
+	return 0;
+
+ERR:
+	/* Leave the context as it came */
+	if (initialized) {
+		hb_mm_mc_release(context);
+	}
+	return ret;
+}
+
+hb_s32 hb_mm_config_release(mc_config_snapshot_t *snap)
+{
+	if (snap == NULL) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	free(snap->roi.roi_map_array);
+	snap->roi.roi_map_array = NULL;
+	snap->roi.roi_map_array_count = 0;
+	return 0;
+}
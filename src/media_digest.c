@@ -0,0 +1,685 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "hb_media_digest.h"
+#include "media_common.h"
+
+#define TAG "[MEDIADIGEST]"
+
+#define DIGEST_VERSION 1
+#define DIGEST_LINE_SIZE 128
+
+#define MD5_BLOCK 64
+
+#define XXH_PRIME32_1 0x9E3779B1U
+#define XXH_PRIME32_2 0x85EBCA77U
+#define XXH_PRIME32_3 0xC2B2AE3DU
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+#define XXH_PRIME_MX1 0x165667919E3779F9ULL
+#define XXH_PRIME_MX2 0x9FB21C651E98DF25ULL
+#define XXH_STRIPE 64
+#define XXH_SECRET_SIZE 192
+#define XXH_SECRET_LIMIT (XXH_SECRET_SIZE - XXH_STRIPE)
+/* Stripes between two scrambles of the accumulators */
+#define XXH_BLOCK_STRIPES (XXH_SECRET_LIMIT / 8)
+/* Stripes buffered by the streaming state */
+#define XXH_BUFFER_STRIPES 4
+#define XXH_BUFFER_SIZE (XXH_BUFFER_STRIPES * XXH_STRIPE)
+#define XXH_MIDSIZE_MAX 240
+
+typedef struct _md5_state {
+	hb_u32 h[4];
+	hb_u64 length;
+	hb_u8 block[MD5_BLOCK];
+} md5_state_t;
+
+typedef struct _xxh3_state {
+	hb_u64 acc[8];
+	hb_u64 length;
+	hb_u32 stripes;
+	hb_u32 buffered;
+	hb_u8 buffer[XXH_BUFFER_SIZE];
+} xxh3_state_t;
+
+struct _mc_digest {
+	hb_u32 algos;
+	FILE *golden;
+	FILE *record;
+	md5_state_t md5;
+	xxh3_state_t xxh3;
+	mc_digest_result_t result;
+	hb_bool finished;
+};
+
+static const hb_u32 md5_k[64] = {
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a,
+	0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+	0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340,
+	0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+	0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+	0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+	0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92,
+	0xffeff47d, 0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+	0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+static const hb_u8 md5_r[64] = {
+	7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+	5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+	4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+	6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+};
+
+static const hb_u8 xxh3_secret[XXH_SECRET_SIZE] = {
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c,
+	0xf7, 0x21, 0xad, 0x1c, 0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb,
+	0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f, 0xcb, 0x79, 0xe6, 0x4e,
+	0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6,
+	0x81, 0x3a, 0x26, 0x4c, 0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb,
+	0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3, 0x71, 0x64, 0x48, 0x97,
+	0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7,
+	0xc7, 0x0b, 0x4f, 0x1d, 0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+	0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64, 0xea, 0xc5, 0xac, 0x83,
+	0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26,
+	0x29, 0xd4, 0x68, 0x9e, 0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc,
+	0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce, 0x45, 0xcb, 0x3a, 0x8f,
+	0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+static hb_u32 digest_read32(const hb_u8 *p)
+{
+	return (hb_u32)p[0] | ((hb_u32)p[1] << 8) | ((hb_u32)p[2] << 16) |
+		((hb_u32)p[3] << 24);
+}
+
+static hb_u64 digest_read64(const hb_u8 *p)
+{
+	return (hb_u64)digest_read32(p) | ((hb_u64)digest_read32(p + 4) << 32);
+}
+
+static hb_u32 digest_rotl32(hb_u32 v, hb_u32 n)
+{
+	return (v << n) | (v >> (32 - n));
+}
+
+static hb_u64 digest_rotl64(hb_u64 v, hb_u32 n)
+{
+	return (v << n) | (v >> (64 - n));
+}
+
+static void md5_init(md5_state_t *st)
+{
+	st->h[0] = 0x67452301;
+	st->h[1] = 0xefcdab89;
+	st->h[2] = 0x98badcfe;
+	st->h[3] = 0x10325476;
+	st->length = 0;
+}
+
+static void md5_block(hb_u32 h[4], const hb_u8 *block)
+{
+	hb_u32 m[16], a = h[0], b = h[1], c = h[2], d = h[3], f, t;
+	hb_u32 i, g;
+
+	for (i = 0; i < 16; i++) {
+		m[i] = digest_read32(block + i * 4);
+	}
+	for (i = 0; i < 64; i++) {
+		if (i < 16) {
+			f = (b & c) | (~b & d);
+			g = i;
+		} else if (i < 32) {
+			f = (d & b) | (~d & c);
+			g = (5 * i + 1) & 15;
+		} else if (i < 48) {
+			f = b ^ c ^ d;
+			g = (3 * i + 5) & 15;
+		} else {
+			f = c ^ (b | ~d);
+			g = (7 * i) & 15;
+		}
+		t = d;
+		d = c;
+		c = b;
+		b = b + digest_rotl32(a + f + md5_k[i] + m[g], md5_r[i]);
+		a = t;
+	}
+	h[0] += a;
+	h[1] += b;
+	h[2] += c;
+	h[3] += d;
+}
+
+static void md5_update(md5_state_t *st, const hb_u8 *data, hb_u32 size)
+{
+	hb_u32 used = (hb_u32)(st->length & (MD5_BLOCK - 1)), n;
+
+	st->length += size;
+	if (used > 0) {
+		n = MD5_BLOCK - used;
+		if (size < n) {
+			memcpy(st->block + used, data, size);
+			return;
+		}
+		memcpy(st->block + used, data, n);
+		md5_block(st->h, st->block);
+		data += n;
+		size -= n;
+	}
+	for (; size >= MD5_BLOCK; data += MD5_BLOCK, size -= MD5_BLOCK) {
+		md5_block(st->h, data);
+	}
+	memcpy(st->block, data, size);
+}
+
+static void md5_final(md5_state_t *st, hb_u8 out[MC_DIGEST_MD5_SIZE])
+{
+	hb_u8 pad[MD5_BLOCK + 8];
+	hb_u64 bits = st->length * 8;
+	hb_u32 used = (hb_u32)(st->length & (MD5_BLOCK - 1)), n, i;
+
+	n = (used < 56) ? (56 - used) : (120 - used);
+	memset(pad, 0x00, sizeof(pad));
+	pad[0] = 0x80;
+	for (i = 0; i < 8; i++) {
+		pad[n + i] = (hb_u8)(bits >> (i * 8));
+	}
+	md5_update(st, pad, n + 8);
+	for (i = 0; i < 16; i++) {
+		out[i] = (hb_u8)(st->h[i / 4] >> ((i % 4) * 8));
+	}
+}
+
+static hb_u64 xxh3_mul128_fold64(hb_u64 a, hb_u64 b)
+{
+	unsigned __int128 product = (unsigned __int128)a * b;
+
+	return (hb_u64)product ^ (hb_u64)(product >> 64);
+}
+
+static hb_u64 xxh64_avalanche(hb_u64 h)
+{
+	h ^= h >> 33;
+	h *= XXH_PRIME64_2;
+	h ^= h >> 29;
+	h *= XXH_PRIME64_3;
+	return h ^ (h >> 32);
+}
+
+static hb_u64 xxh3_avalanche(hb_u64 h)
+{
+	h ^= h >> 37;
+	h *= XXH_PRIME_MX1;
+	return h ^ (h >> 32);
+}
+
+static hb_u64 xxh3_rrmxmx(hb_u64 h, hb_u64 len)
+{
+	h ^= digest_rotl64(h, 49) ^ digest_rotl64(h, 24);
+	h *= XXH_PRIME_MX2;
+	h ^= (h >> 35) + len;
+	h *= XXH_PRIME_MX2;
+	return h ^ (h >> 28);
+}
+
+static hb_u64 xxh3_mix16(const hb_u8 *data, const hb_u8 *secret)
+{
+	return xxh3_mul128_fold64(digest_read64(data) ^ digest_read64(secret),
+		digest_read64(data + 8) ^ digest_read64(secret + 8));
+}
+
+/* Inputs up to XXH_MIDSIZE_MAX bytes are hashed in one go */
+static hb_u64 xxh3_short(const hb_u8 *data, hb_u64 len)
+{
+	const hb_u8 *secret = xxh3_secret;
+	hb_u64 acc, lo, hi;
+	hb_u32 i, rounds;
+
+	if (len == 0) {
+		return xxh64_avalanche(digest_read64(secret + 56) ^
+			digest_read64(secret + 64));
+	}
+	if (len <= 3) {
+		acc = ((hb_u64)data[0] << 16) | ((hb_u64)data[len >> 1] << 24) |
+			(hb_u64)data[len - 1] | (len << 8);
+		return xxh64_avalanche(acc ^ (hb_u64)(digest_read32(secret) ^
+			digest_read32(secret + 4)));
+	}
+	if (len <= 8) {
+		acc = (hb_u64)digest_read32(data + len - 4) +
+			((hb_u64)digest_read32(data) << 32);
+		return xxh3_rrmxmx(acc ^ (digest_read64(secret + 8) ^
+			digest_read64(secret + 16)), len);
+	}
+	if (len <= 16) {
+		lo = digest_read64(data) ^ (digest_read64(secret + 24) ^
+			digest_read64(secret + 32));
+		hi = digest_read64(data + len - 8) ^ (digest_read64(secret + 40) ^
+			digest_read64(secret + 48));
+		acc = len + __builtin_bswap64(lo) + hi + xxh3_mul128_fold64(lo, hi);
+		return xxh3_avalanche(acc);
+	}
+	acc = len * XXH_PRIME64_1;
+	if (len <= 128) {
+		if (len > 32) {
+			if (len > 64) {
+				if (len > 96) {
+					acc += xxh3_mix16(data + 48, secret + 96);
+					acc += xxh3_mix16(data + len - 64, secret + 112);
+				}
+				acc += xxh3_mix16(data + 32, secret + 64);
+				acc += xxh3_mix16(data + len - 48, secret + 80);
+			}
+			acc += xxh3_mix16(data + 16, secret + 32);
+			acc += xxh3_mix16(data + len - 32, secret + 48);
+		}
+		acc += xxh3_mix16(data, secret);
+		acc += xxh3_mix16(data + len - 16, secret + 16);
+		return xxh3_avalanche(acc);
+	}
+	rounds = (hb_u32)len / 16;
+	for (i = 0; i < 8; i++) {
+		acc += xxh3_mix16(data + 16 * i, secret + 16 * i);
+	}
+	acc = xxh3_avalanche(acc);
+	for (i = 8; i < rounds; i++) {
+		acc += xxh3_mix16(data + 16 * i, secret + 16 * (i - 8) + 3);
+	}
+	acc += xxh3_mix16(data + len - 16, secret + 136 - 17);
+	return xxh3_avalanche(acc);
+}
+
+static void xxh3_accumulate_stripe(hb_u64 acc[8], const hb_u8 *data,
+		const hb_u8 *secret)
+{
+	hb_u64 value, key;
+	hb_u32 i;
+
+	for (i = 0; i < 8; i++) {
+		value = digest_read64(data + 8 * i);
+		key = value ^ digest_read64(secret + 8 * i);
+		acc[i ^ 1] += value;
+		acc[i] += (key & 0xffffffffULL) * (key >> 32);
+	}
+}
+
+static void xxh3_scramble(hb_u64 acc[8])
+{
+	const hb_u8 *secret = xxh3_secret + XXH_SECRET_LIMIT;
+	hb_u32 i;
+
+	for (i = 0; i < 8; i++) {
+		acc[i] = ((acc[i] ^ (acc[i] >> 47)) ^ digest_read64(secret + 8 * i)) *
+			XXH_PRIME32_1;
+	}
+}
+
+/* stripes continue the block at *done stripes, scrambling at its end */
+static void xxh3_consume(hb_u64 acc[8], hb_u32 *done, const hb_u8 *data,
+		hb_u32 stripes)
+{
+	hb_u32 i;
+
+	for (i = 0; i < stripes; i++) {
+		xxh3_accumulate_stripe(acc, data + i * XXH_STRIPE,
+			xxh3_secret + *done * 8);
+		if (++*done == XXH_BLOCK_STRIPES) {
+			xxh3_scramble(acc);
+			*done = 0;
+		}
+	}
+}
+
+static hb_u64 xxh3_merge(const hb_u64 acc[8], hb_u64 len)
+{
+	const hb_u8 *secret = xxh3_secret + 11;
+	hb_u64 h = len * XXH_PRIME64_1;
+	hb_u32 i;
+
+	for (i = 0; i < 4; i++) {
+		h += xxh3_mul128_fold64(acc[2 * i] ^ digest_read64(secret + 16 * i),
+			acc[2 * i + 1] ^ digest_read64(secret + 16 * i + 8));
+	}
+	return xxh3_avalanche(h);
+}
+
+static void xxh3_init(xxh3_state_t *st)
+{
+	st->acc[0] = XXH_PRIME32_3;
+	st->acc[1] = XXH_PRIME64_1;
+	st->acc[2] = XXH_PRIME64_2;
+	st->acc[3] = XXH_PRIME64_3;
+	st->acc[4] = XXH_PRIME64_4;
+	st->acc[5] = XXH_PRIME32_2;
+	st->acc[6] = XXH_PRIME64_5;
+	st->acc[7] = XXH_PRIME32_1;
+	st->length = 0;
+	st->stripes = 0;
+	st->buffered = 0;
+}
+
+/**
+ * At least one byte always stays buffered, so the last stripe is hashed
+ * by xxh3_final() the way the one shot hash does. Once data went through
+ * the buffer, its last stripe stays at the end of the buffer.
+ */
+static void xxh3_update(xxh3_state_t *st, const hb_u8 *data, hb_u32 size)
+{
+	hb_u32 n;
+
+	st->length += size;
+	if (st->buffered + size <= XXH_BUFFER_SIZE) {
+		memcpy(st->buffer + st->buffered, data, size);
+		st->buffered += size;
+		return;
+	}
+	if (st->buffered > 0) {
+		n = XXH_BUFFER_SIZE - st->buffered;
+		memcpy(st->buffer + st->buffered, data, n);
+		data += n;
+		size -= n;
+		xxh3_consume(st->acc, &st->stripes, st->buffer, XXH_BUFFER_STRIPES);
+		st->buffered = 0;
+	}
+	if (size > XXH_BUFFER_SIZE) {
+		n = (size - 1) / XXH_STRIPE;
+		xxh3_consume(st->acc, &st->stripes, data, n);
+		data += n * XXH_STRIPE;
+		size -= n * XXH_STRIPE;
+		memcpy(st->buffer + XXH_BUFFER_SIZE - XXH_STRIPE, data - XXH_STRIPE,
+			XXH_STRIPE);
+	}
+	memcpy(st->buffer, data, size);
+	st->buffered = size;
+}
+
+static hb_u64 xxh3_final(const xxh3_state_t *st)
+{
+	hb_u8 last[XXH_STRIPE];
+	hb_u64 acc[8];
+	hb_u32 done = st->stripes, n;
+
+	if (st->length <= XXH_MIDSIZE_MAX) {
+		return xxh3_short(st->buffer, st->length);
+	}
+	memcpy(acc, st->acc, sizeof(acc));
+	if (st->buffered >= XXH_STRIPE) {
+		n = (st->buffered - 1) / XXH_STRIPE;
+		xxh3_consume(acc, &done, st->buffer, n);
+		memcpy(last, st->buffer + st->buffered - XXH_STRIPE, XXH_STRIPE);
+	} else {
+		n = XXH_STRIPE - st->buffered;
+		memcpy(last, st->buffer + XXH_BUFFER_SIZE - n, n);
+		memcpy(last + n, st->buffer, st->buffered);
+	}
+	xxh3_accumulate_stripe(acc, last, xxh3_secret + XXH_SECRET_LIMIT - 7);
+	return xxh3_merge(acc, st->length);
+}
+
+void hb_mm_digest_md5(const hb_u8 *data, hb_u32 size,
+		hb_u8 md5[MC_DIGEST_MD5_SIZE])
+{
+	md5_state_t st;
+
+	md5_init(&st);
+	md5_update(&st, data, size);
+	md5_final(&st, md5);
+}
+
+hb_u64 hb_mm_digest_xxh3(const hb_u8 *data, hb_u32 size)
+{
+	xxh3_state_t st;
+
+	if (size <= XXH_MIDSIZE_MAX) {
+		return xxh3_short(data, size);
+	}
+	xxh3_init(&st);
+	xxh3_update(&st, data, size);
+	return xxh3_final(&st);
+}
+
+static void digest_reset(mc_digest_t *digest)
+{
+	md5_init(&digest->md5);
+	xxh3_init(&digest->xxh3);
+}
+
+hb_s32 hb_mm_digest_create(const mc_digest_params_t *params,
+		mc_digest_t **digest)
+{
+	mc_digest_t *d;
+	char line[DIGEST_LINE_SIZE];
+	hb_s32 version = 0;
+
+	if ((params == NULL) || (digest == NULL) || (params->algos == 0) ||
+		((params->algos & ~((1U << MC_DIGEST_ALGO_TOTAL) - 1)) != 0)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	d = calloc(1, sizeof(*d));
+	if (d == NULL) {
+		VLOG(ERR, "%s <%s:%d> Fail to allocate the digest.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	d->algos = params->algos;
+	d->result.first_mismatch = -1;
+	digest_reset(d);
+	if (params->golden_file != NULL) {
+		d->golden = fopen(params->golden_file, "re");
+		if (d->golden == NULL) {
+			VLOG(ERR, "%s <%s:%d> Fail to open %s(%s).\n",
+				TAG, __FUNCTION__, __LINE__, params->golden_file,
+				strerror(errno));
+			hb_mm_digest_destroy(d);
+			return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+		}
+		if ((fgets(line, sizeof(line), d->golden) == NULL) ||
+			(sscanf(line, "# hb_mm_digest %d", &version) != 1) ||
+			(version != DIGEST_VERSION)) {
+			VLOG(ERR, "%s <%s:%d> %s isn't a version %d digest file.\n",
+				TAG, __FUNCTION__, __LINE__, params->golden_file,
+				DIGEST_VERSION);
+			hb_mm_digest_destroy(d);
+			return HB_MEDIA_ERR_INVALID_PARAMS;
+		}
+	}
+	if (params->record_file != NULL) {
+		d->record = fopen(params->record_file, "we");
+		if (d->record == NULL) {
+			VLOG(ERR, "%s <%s:%d> Fail to open %s(%s).\n",
+				TAG, __FUNCTION__, __LINE__, params->record_file,
+				strerror(errno));
+			hb_mm_digest_destroy(d);
+			return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+		}
+		fprintf(d->record, "# hb_mm_digest %d\n", DIGEST_VERSION);
+	}
+	*digest = d;
+	return 0;
+}
+
+hb_s32 hb_mm_digest_update(mc_digest_t *digest, const hb_u8 *data,
+		hb_u32 size)
+{
+	if ((digest == NULL) || ((data == NULL) && (size > 0))) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (digest->algos & MC_DIGEST_ALGO_BIT(MC_DIGEST_ALGO_MD5)) {
+		md5_update(&digest->md5, data, size);
+	}
+	if (digest->algos & MC_DIGEST_ALGO_BIT(MC_DIGEST_ALGO_XXH3)) {
+		xxh3_update(&digest->xxh3, data, size);
+	}
+	return 0;
+}
+
+static void digest_format(const mc_digest_t *digest,
+		const mc_digest_frame_t *frame, char *line, hb_u32 size)
+{
+	hb_u32 pos, i;
+
+	pos = (hb_u32)snprintf(line, size, "%u ", frame->index);
+	if (digest->algos & MC_DIGEST_ALGO_BIT(MC_DIGEST_ALGO_MD5)) {
+		for (i = 0; i < MC_DIGEST_MD5_SIZE; i++) {
+			pos += (hb_u32)snprintf(line + pos, size - pos, "%02x",
+				frame->md5[i]);
+		}
+	} else {
+		pos += (hb_u32)snprintf(line + pos, size - pos, "-");
+	}
+	if (digest->algos & MC_DIGEST_ALGO_BIT(MC_DIGEST_ALGO_XXH3)) {
+		snprintf(line + pos, size - pos, " %016llx\n",
+			(unsigned long long)frame->xxh3);
+	} else {
+		snprintf(line + pos, size - pos, " -\n");
+	}
+}
+
+/* Hashes missing on either side are skipped, none in common mismatches */
+static hb_bool digest_match(const char *expect, const char *actual)
+{
+	char expect_md5[40], expect_xxh3[24], actual_md5[40], actual_xxh3[24];
+	hb_u32 expect_index, actual_index;
+	hb_bool compared = FALSE;
+
+	if ((sscanf(expect, "%u %39s %23s", &expect_index, expect_md5,
+		expect_xxh3) != 3) || (sscanf(actual, "%u %39s %23s",
+		&actual_index, actual_md5, actual_xxh3) != 3) ||
+		(expect_index != actual_index)) {
+		return FALSE;
+	}
+	if ((strcmp(expect_md5, "-") != 0) && (strcmp(actual_md5, "-") != 0)) {
+		if (strcasecmp(expect_md5, actual_md5) != 0) {
+			return FALSE;
+		}
+		compared = TRUE;
+	}
+	if ((strcmp(expect_xxh3, "-") != 0) && (strcmp(actual_xxh3, "-") != 0)) {
+		if (strcasecmp(expect_xxh3, actual_xxh3) != 0) {
+			return FALSE;
+		}
+		compared = TRUE;
+	}
+	return compared;
+}
+
+static void digest_mismatch(mc_digest_t *digest, hb_u32 index)
+{
+	if (digest->result.first_mismatch < 0) {
+		digest->result.first_mismatch = (hb_s32)index;
+	}
+	digest->result.mismatched++;
+}
+
+hb_s32 hb_mm_digest_end_frame(mc_digest_t *digest, mc_digest_frame_t *frame)
+{
+	char line[DIGEST_LINE_SIZE], expect[DIGEST_LINE_SIZE];
+	mc_digest_frame_t current;
+	hb_s32 ret = 0;
+
+	if (digest == NULL) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (digest->finished) {
+		VLOG(ERR, "%s <%s:%d> The result was already taken.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_OPERATION_NOT_ALLOWED;
+	}
+	memset(&current, 0x00, sizeof(current));
+	current.index = digest->result.frames++;
+	if (digest->algos & MC_DIGEST_ALGO_BIT(MC_DIGEST_ALGO_MD5)) {
+		md5_final(&digest->md5, current.md5);
+	}
+	if (digest->algos & MC_DIGEST_ALGO_BIT(MC_DIGEST_ALGO_XXH3)) {
+		current.xxh3 = xxh3_final(&digest->xxh3);
+	}
+	digest_reset(digest);
+	digest_format(digest, &current, line, sizeof(line));
+	if (digest->record != NULL) {
+		fputs(line, digest->record);
+	}
+	if (digest->golden != NULL) {
+		if (fgets(expect, sizeof(expect), digest->golden) != NULL) {
+			digest->result.golden_frames++;
+			if (!digest_match(expect, line)) {
+				ret = 1;
+			}
+		} else {
+			ret = 1;
+		}
+		if (ret != 0) {
+			if (digest->result.mismatched == 0) {
+				VLOG(ERR, "%s <%s:%d> Frame %u mismatches the golden file.\n",
+					TAG, __FUNCTION__, __LINE__, current.index);
+			}
+			digest_mismatch(digest, current.index);
+		}
+	}
+	if (frame != NULL) {
+		*frame = current;
+	}
+	return ret;
+}
+
+hb_s32 hb_mm_digest_get_result(mc_digest_t *digest,
+		mc_digest_result_t *result)
+{
+	char expect[DIGEST_LINE_SIZE];
+
+	if ((digest == NULL) || (result == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (!digest->finished && (digest->golden != NULL)) {
+		while (fgets(expect, sizeof(expect), digest->golden) != NULL) {
+			digest->result.golden_frames++;
+			digest_mismatch(digest, digest->result.golden_frames - 1);
+		}
+	}
+	digest->finished = TRUE;
+	*result = digest->result;
+	return 0;
+}
+
+hb_s32 hb_mm_digest_destroy(mc_digest_t *digest)
+{
+	hb_s32 ret = 0;
+
+	if (digest == NULL) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (digest->golden != NULL) {
+		fclose(digest->golden);
+	}
+	if ((digest->record != NULL) && (fclose(digest->record) != 0)) {
+		VLOG(ERR, "%s <%s:%d> Fail to write the record file(%s).\n",
+			TAG, __FUNCTION__, __LINE__, strerror(errno));
+		ret = HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+	}
+	free(digest);
+	return ret;
+}
@@ -0,0 +1,536 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hb_media_log.h"
+#include "media_common.h"
+
+#define TAG "[MEDIALOG]"
+
+#define LOG_RING_MIN 4096U
+#define LOG_RING_MAX (16U << 20)
+#define LOG_INTERVAL_MAX 1000U
+/* Bytes formatted before the flusher writes them out */
+#define LOG_OUT_SIZE 65536U
+#define LOG_LINE_MAX 4096U
+#define LOG_CACHE_LINE 64
+
+/* argc of the filler in front of a record that wrapped around the ring */
+#define LOG_RECORD_PAD 0xffffU
+
+/* Followed by argc mc_log_arg_t and the strings they refer to */
+typedef struct _log_record {
+	/* Bytes of the record, a multiple of 8 */
+	hb_u32 size;
+	hb_u16 argc;
+	hb_u16 reserved;
+	/* Records of the site held back by the rate limit before this one */
+	hb_u32 suppressed;
+	hb_s32 tid;
+	hb_u64 time_ns;
+	const mc_log_site_t *site;
+} log_record_t;
+
+/* One producer, the owning thread, and one consumer, the flusher */
+typedef struct _log_ring {
+	hb_u64 head __attribute__((aligned(LOG_CACHE_LINE)));
+	hb_u64 written;
+	hb_u64 dropped;
+	hb_u64 tail __attribute__((aligned(LOG_CACHE_LINE)));
+	hb_u8 *data;
+	hb_u32 size;
+	hb_s32 tid;
+	/* Cleared when the thread exits, a new thread of the same ring size
+	 * takes it over */
+	hb_s32 owned;
+	struct _log_ring *next;
+} log_ring_t;
+
+hb_u32 hb_mm_log_level_mask = MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_WARN) |
+	MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_ERR);
+
+static mc_log_params_t log_params = {
+	MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_WARN) | MC_LOG_LEVEL_BIT(MC_LOG_LEVEL_ERR),
+	STDERR_FILENO, 65536, 0, 10, FALSE
+};
+static pthread_once_t log_once = PTHREAD_ONCE_INIT;
+static pthread_key_t log_key;
+/* Pushed at the front, never unlinked */
+static log_ring_t *log_rings;
+static __thread log_ring_t *log_ring;
+/* Serializes the consumers: the flusher, hb_mm_log_flush() and exit */
+static pthread_mutex_t log_flush_lock = PTHREAD_MUTEX_INITIALIZER;
+static char log_out[LOG_OUT_SIZE];
+static hb_u64 log_limited;
+static hb_u64 log_flushed;
+
+static const char *const log_level_names[MC_LOG_LEVEL_TOTAL] = {
+	"NONE", "INFO", "WARN", "ERR", "TRACE",
+};
+
+static hb_u64 log_get_time_ns(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_REALTIME, &tp);
+	return ((hb_u64)tp.tv_sec * 1000000000ULL) + (hb_u64)tp.tv_nsec;
+}
+
+static hb_u32 log_align8(hb_u32 size)
+{
+	return (size + 7) & ~7U;
+}
+
+static void log_write_fd(hb_s32 fd, const char *buf, hb_u32 size)
+{
+	hb_u32 done = 0;
+	ssize_t n;
+
+	while (done < size) {
+		n = write(fd, buf + done, size - done);
+		if ((n < 0) && (errno == EINTR)) {
+			continue;
+		}
+		if (n <= 0) {
+			return;
+		}
+		done += (hb_u32)n;
+	}
+}
+
+static hb_u32 log_emit(char *out, hb_u32 cap, hb_u32 pos, const char *spec,
+		const mc_log_arg_t *arg, char conv)
+{
+	int n;
+
+	if (pos + 1 >= cap) {
+		return pos;
+	}
+	if (arg == NULL) {
+		n = snprintf(out + pos, cap - pos, "<?>");
+	} else if (strchr("di", conv) != NULL) {
+		n = snprintf(out + pos, cap - pos, spec, (arg->type ==
+			MC_LOG_ARG_DOUBLE) ? (long long)arg->d : arg->i);
+	} else if (strchr("uoxX", conv) != NULL) {
+		n = snprintf(out + pos, cap - pos, spec, (arg->type ==
+			MC_LOG_ARG_DOUBLE) ? (unsigned long long)arg->d : arg->u);
+	} else if (conv == 'c') {
+		n = snprintf(out + pos, cap - pos, spec, (int)arg->i);
+	} else if (strchr("eEfFgGaA", conv) != NULL) {
+		n = snprintf(out + pos, cap - pos, spec, (arg->type ==
+			MC_LOG_ARG_DOUBLE) ? arg->d : (arg->type == MC_LOG_ARG_INT) ?
+			(double)arg->i : (double)arg->u);
+	} else if (conv == 's') {
+		n = snprintf(out + pos, cap - pos, spec,
+			(arg->type == MC_LOG_ARG_STRING) ? arg->s : "<?>");
+	} else {
+		n = snprintf(out + pos, cap - pos, spec, arg->p);
+	}
+	if (n < 0) {
+		return pos;
+	}
+	return ((hb_u32)n < cap - pos) ? pos + (hb_u32)n : cap - 1;
+}
+
+/**
+ * printf of the recorded arguments. Each conversion is handed to snprintf
+ * on its own with the length modifier of its recorded slot.
+ */
+static hb_u32 log_expand(char *out, hb_u32 cap, const char *fmt,
+		const mc_log_arg_t *args, hb_u32 argc)
+{
+	char spec[32], conv;
+	hb_u32 pos = 0, next = 0, k;
+	const char *p = fmt;
+
+	while ((*p != '\0') && (pos + 1 < cap)) {
+		if (*p != '%') {
+			out[pos++] = *p++;
+			continue;
+		}
+		if (p[1] == '%') {
+			out[pos++] = '%';
+			p += 2;
+			continue;
+		}
+		k = 0;
+		spec[k++] = *p++;
+		while ((*p != '\0') && (strchr("-+ #0'", *p) != NULL) &&
+			(k < 8)) {
+			spec[k++] = *p++;
+		}
+		/* Width and precision, '*' takes an argument */
+		while ((*p != '\0') && ((strchr("0123456789.", *p) != NULL) ||
+			(*p == '*')) && (k < 20)) {
+			if (*p == '*') {
+				k += (hb_u32)snprintf(spec + k, sizeof(spec) - k, "%d",
+					(next < argc) ? (int)args[next].i : 0);
+				next++;
+				p++;
+			} else {
+				spec[k++] = *p++;
+			}
+		}
+		while ((*p != '\0') && (strchr("hlLqjzt", *p) != NULL)) {
+			p++;
+		}
+		conv = *p;
+		if (conv == '\0') {
+			break;
+		}
+		p++;
+		if (strchr("diuoxX", conv) != NULL) {
+			spec[k++] = 'l';
+			spec[k++] = 'l';
+		} else if (strchr("ceEfFgGaAsp", conv) == NULL) {
+			/* %n and unknown conversions are dropped */
+			continue;
+		}
+		spec[k++] = conv;
+		spec[k] = '\0';
+		pos = log_emit(out, cap, pos, spec, (next < argc) ? &args[next] :
+			NULL, conv);
+		next++;
+	}
+	out[pos] = '\0';
+	return pos;
+}
+
+static hb_u32 log_format(char *out, hb_u32 cap, const mc_log_site_t *site,
+		hb_s32 tid, hb_u64 time_ns, hb_u32 suppressed,
+		const mc_log_arg_t *args, hb_u32 argc)
+{
+	hb_u32 pos = 0;
+	int n;
+
+	if (suppressed > 0) {
+		n = snprintf(out, cap, "%s %u records suppressed by the rate limit\n",
+			TAG, suppressed);
+		pos = ((n > 0) && ((hb_u32)n < cap)) ? (hb_u32)n : 0;
+	}
+	if (log_params.prefix) {
+		n = snprintf(out + pos, cap - pos, "[%llu.%06llu][%d][%s] ",
+			(unsigned long long)(time_ns / 1000000000ULL),
+			(unsigned long long)(time_ns % 1000000000ULL / 1000), tid,
+			((site->level >= 0) && (site->level < MC_LOG_LEVEL_TOTAL)) ?
+			log_level_names[site->level] : "?");
+		pos += ((n > 0) && ((hb_u32)n < cap - pos)) ? (hb_u32)n : 0;
+	}
+	return pos + log_expand(out + pos, cap - pos, site->fmt, args, argc);
+}
+
+static void log_thread_exit(void *arg)
+{
+	log_ring_t *ring = (log_ring_t *)arg;
+
+	__atomic_store_n(&ring->owned, 0, __ATOMIC_RELEASE);
+}
+
+static void *log_flusher(void *arg)
+{
+	(void)arg;
+	for (;;) {
+		usleep(__atomic_load_n(&log_params.flush_interval_ms,
+			__ATOMIC_RELAXED) * 1000);
+		hb_mm_log_flush();
+	}
+	return NULL;
+}
+
+static void log_at_exit(void)
+{
+	hb_mm_log_flush();
+}
+
+static void log_init(void)
+{
+	pthread_t thread;
+
+	pthread_key_create(&log_key, log_thread_exit);
+	if (pthread_create(&thread, NULL, log_flusher, NULL) == 0) {
+		pthread_detach(thread);
+	}
+	atexit(log_at_exit);
+}
+
+static log_ring_t *log_get_ring(void)
+{
+	log_ring_t *ring;
+	hb_s32 owned = 0;
+	hb_u32 size;
+
+	if (log_ring != NULL) {
+		return log_ring;
+	}
+	pthread_once(&log_once, log_init);
+	size = __atomic_load_n(&log_params.ring_size, __ATOMIC_RELAXED);
+	for (ring = __atomic_load_n(&log_rings, __ATOMIC_ACQUIRE); ring != NULL;
+		ring = ring->next) {
+		if (ring->size != size) {
+			continue;
+		}
+		owned = 0;
+		if (__atomic_compare_exchange_n(&ring->owned, &owned, 1, FALSE,
+			__ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+			break;
+		}
+	}
+	if (ring == NULL) {
+		if (posix_memalign((void **)&ring, LOG_CACHE_LINE,
+			sizeof(*ring)) != 0) {
+			return NULL;
+		}
+		memset(ring, 0x00, sizeof(*ring));
+		ring->size = size;
+		ring->data = malloc(ring->size);
+		if (ring->data == NULL) {
+			free(ring);
+			return NULL;
+		}
+		ring->owned = 1;
+		ring->next = __atomic_load_n(&log_rings, __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&log_rings, &ring->next, ring,
+			TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+		}
+	}
+	ring->tid = (hb_s32)syscall(SYS_gettid);
+	pthread_setspecific(log_key, ring);
+	log_ring = ring;
+	return ring;
+}
+
+static hb_bool log_rate_limited(mc_log_site_t *site)
+{
+	hb_u32 limit = __atomic_load_n(&log_params.rate_limit, __ATOMIC_RELAXED);
+	struct timespec tp;
+	hb_u32 now;
+
+	if (limit == 0) {
+		return FALSE;
+	}
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &tp);
+	/* Racing threads may both start the window, a record more is fine */
+	now = (hb_u32)tp.tv_sec;
+	if (__atomic_load_n(&site->window, __ATOMIC_RELAXED) != now) {
+		__atomic_store_n(&site->window, now, __ATOMIC_RELAXED);
+		__atomic_store_n(&site->count, 0, __ATOMIC_RELAXED);
+	}
+	if (__atomic_fetch_add(&site->count, 1, __ATOMIC_RELAXED) < limit) {
+		return FALSE;
+	}
+	__atomic_fetch_add(&site->suppressed, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&log_limited, 1, __ATOMIC_RELAXED);
+	return TRUE;
+}
+
+/* Without a ring the record is formatted and written right away */
+static void log_write_now(mc_log_site_t *site, const mc_log_arg_t *args,
+		hb_u32 argc, hb_u32 suppressed)
+{
+	char line[LOG_LINE_MAX];
+	hb_u32 len;
+
+	len = log_format(line, sizeof(line), site, (hb_s32)syscall(SYS_gettid),
+		log_get_time_ns(), suppressed, args, argc);
+	log_write_fd(log_params.fd, line, len);
+}
+
+void hb_mm_log_write(mc_log_site_t *site, const mc_log_arg_t *args,
+		hb_u32 argc)
+{
+	hb_u32 lens[MC_LOG_MAX_ARGS], need, pos, contiguous, total, i, offset;
+	log_record_t *rec;
+	mc_log_arg_t *slots;
+	log_ring_t *ring;
+	hb_u64 head, tail;
+	hb_u32 suppressed;
+
+	if (log_rate_limited(site)) {
+		return;
+	}
+	argc = (argc < MC_LOG_MAX_ARGS) ? argc : MC_LOG_MAX_ARGS;
+	suppressed = __atomic_exchange_n(&site->suppressed, 0, __ATOMIC_RELAXED);
+	ring = log_get_ring();
+	if (ring == NULL) {
+		log_write_now(site, args, argc, suppressed);
+		return;
+	}
+
+	need = sizeof(log_record_t) + argc * sizeof(mc_log_arg_t);
+	for (i = 0; i < argc; i++) {
+		if ((args[i].type == MC_LOG_ARG_STRING) && (args[i].s != NULL)) {
+			lens[i] = (hb_u32)strnlen(args[i].s, MC_LOG_MAX_STRING - 1);
+			need += lens[i] + 1;
+		}
+	}
+	need = log_align8(need);
+	head = ring->head;
+	tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	pos = (hb_u32)(head & (ring->size - 1));
+	contiguous = ring->size - pos;
+	/* A record never wraps, the rest of the ring is filled up instead */
+	total = (need > contiguous) ? contiguous + need : need;
+	if ((need > ring->size / 4) || (head + total - tail > ring->size)) {
+		ring->dropped++;
+		__atomic_fetch_add(&site->suppressed, suppressed, __ATOMIC_RELAXED);
+		return;
+	}
+	if (need > contiguous) {
+		rec = (log_record_t *)(ring->data + pos);
+		rec->size = contiguous;
+		rec->argc = LOG_RECORD_PAD;
+		pos = 0;
+	}
+
+	rec = (log_record_t *)(ring->data + pos);
+	rec->size = need;
+	rec->argc = (hb_u16)argc;
+	rec->suppressed = suppressed;
+	rec->tid = ring->tid;
+	rec->time_ns = log_get_time_ns();
+	rec->site = site;
+	slots = (mc_log_arg_t *)(rec + 1);
+	offset = sizeof(log_record_t) + argc * sizeof(mc_log_arg_t);
+	for (i = 0; i < argc; i++) {
+		slots[i] = args[i];
+		if ((args[i].type == MC_LOG_ARG_STRING) && (args[i].s != NULL)) {
+			/* The copy is found by its offset, the ring may move */
+			memcpy((hb_u8 *)rec + offset, args[i].s, lens[i]);
+			((hb_u8 *)rec)[offset + lens[i]] = '\0';
+			slots[i].u = offset;
+			offset += lens[i] + 1;
+		} else if (args[i].type == MC_LOG_ARG_STRING) {
+			slots[i].type = MC_LOG_ARG_POINTER;
+		}
+	}
+	ring->written++;
+	__atomic_store_n(&ring->head, head + total, __ATOMIC_RELEASE);
+}
+
+/* The oldest record over all the rings, padding skipped */
+static log_ring_t *log_next_ring(void)
+{
+	log_ring_t *ring, *best = NULL;
+	const log_record_t *rec, *best_rec = NULL;
+	hb_u64 head;
+
+	for (ring = __atomic_load_n(&log_rings, __ATOMIC_ACQUIRE); ring != NULL;
+		ring = ring->next) {
+		head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		rec = NULL;
+		while (ring->tail < head) {
+			rec = (const log_record_t *)(ring->data +
+				(ring->tail & (ring->size - 1)));
+			if (rec->argc != LOG_RECORD_PAD) {
+				break;
+			}
+			__atomic_store_n(&ring->tail, ring->tail + rec->size,
+				__ATOMIC_RELEASE);
+			rec = NULL;
+		}
+		if (rec == NULL) {
+			continue;
+		}
+		if ((best_rec == NULL) || (rec->time_ns < best_rec->time_ns)) {
+			best = ring;
+			best_rec = rec;
+		}
+	}
+	return best;
+}
+
+hb_s32 hb_mm_log_flush(void)
+{
+	mc_log_arg_t args[MC_LOG_MAX_ARGS];
+	const log_record_t *rec;
+	log_ring_t *ring;
+	hb_u32 pos = 0, i;
+	hb_u64 flushed = 0;
+
+	pthread_mutex_lock(&log_flush_lock);
+	while ((ring = log_next_ring()) != NULL) {
+		rec = (const log_record_t *)(ring->data +
+			(ring->tail & (ring->size - 1)));
+		memcpy(args, rec + 1, rec->argc * sizeof(mc_log_arg_t));
+		for (i = 0; i < rec->argc; i++) {
+			if (args[i].type == MC_LOG_ARG_STRING) {
+				args[i].s = (const char *)rec + args[i].u;
+			}
+		}
+		if (pos + LOG_LINE_MAX > sizeof(log_out)) {
+			log_write_fd(log_params.fd, log_out, pos);
+			pos = 0;
+		}
+		pos += log_format(log_out + pos, LOG_LINE_MAX, rec->site, rec->tid,
+			rec->time_ns, rec->suppressed, args, rec->argc);
+		__atomic_store_n(&ring->tail, ring->tail + rec->size,
+			__ATOMIC_RELEASE);
+		flushed++;
+	}
+	if (pos > 0) {
+		log_write_fd(log_params.fd, log_out, pos);
+	}
+	__atomic_fetch_add(&log_flushed, flushed, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&log_flush_lock);
+	return 0;
+}
+
+hb_s32 hb_mm_log_configure(const mc_log_params_t *params)
+{
+	if ((params == NULL) || (params->fd < 0) ||
+		((params->level_mask & ~((1U << MC_LOG_LEVEL_TOTAL) - 1)) != 0) ||
+		(params->ring_size < LOG_RING_MIN) ||
+		(params->ring_size > LOG_RING_MAX) ||
+		((params->ring_size & (params->ring_size - 1)) != 0) ||
+		(params->flush_interval_ms == 0) ||
+		(params->flush_interval_ms > LOG_INTERVAL_MAX)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	/* Records of the old parameters go out with them */
+	hb_mm_log_flush();
+	pthread_mutex_lock(&log_flush_lock);
+	log_params.fd = params->fd;
+	log_params.prefix = params->prefix;
+	__atomic_store_n(&log_params.ring_size, params->ring_size,
+		__ATOMIC_RELAXED);
+	__atomic_store_n(&log_params.rate_limit, params->rate_limit,
+		__ATOMIC_RELAXED);
+	__atomic_store_n(&log_params.flush_interval_ms,
+		params->flush_interval_ms, __ATOMIC_RELAXED);
+	log_params.level_mask = params->level_mask;
+	__atomic_store_n(&hb_mm_log_level_mask, params->level_mask,
+		__ATOMIC_RELAXED);
+	pthread_mutex_unlock(&log_flush_lock);
+	return 0;
+}
+
+hb_s32 hb_mm_log_get_stats(mc_log_stats_t *stats)
+{
+	log_ring_t *ring;
+
+	if (stats == NULL) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	memset(stats, 0x00, sizeof(*stats));
+	for (ring = __atomic_load_n(&log_rings, __ATOMIC_ACQUIRE); ring != NULL;
+		ring = ring->next) {
+		stats->written += __atomic_load_n(&ring->written, __ATOMIC_RELAXED);
+		stats->dropped += __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+		stats->rings++;
+	}
+	stats->limited = __atomic_load_n(&log_limited, __ATOMIC_RELAXED);
+	stats->flushed = __atomic_load_n(&log_flushed, __ATOMIC_RELAXED);
+	return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef MEDIA_LOG_H
+#define MEDIA_LOG_H
+
+#include <stdio.h>
+
+#include "hb_media_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Log levels of the host side media modules. They follow the VPU
+ * library naming so VLOG(ERR, ...) reads the same as in media_codec.c.
+ **/
+enum {
+	NONE = MC_LOG_LEVEL_NONE,
+	INFO = MC_LOG_LEVEL_INFO,
+	WARN = MC_LOG_LEVEL_WARN,
+	ERR = MC_LOG_LEVEL_ERR,
+	TRACE = MC_LOG_LEVEL_TRACE,
+	MAX_LOG_LEVEL = MC_LOG_LEVEL_TOTAL
+};
+
+/* Recorded into the ring of the thread, @see HB_MM_LOG() */
+#ifndef VLOG
+#define VLOG(level, fmt, ...) HB_MM_LOG(level, fmt, ##__VA_ARGS__)
+#endif
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* MEDIA_LOG_H */
@@ -0,0 +1,323 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "hb_media_lowlat.h"
+#include "media_common.h"
+
+#define TAG "[MEDIALOWLAT]"
+
+#define LOWLAT_MIN_VBV_MS 10
+#define LOWLAT_MAX_VBV_MS 3000
+
+struct _mc_lowlat {
+	media_codec_context_t *context;
+	mc_lowlat_params_t params;
+	/* Number of the last intra picture, the refresh cycles start after it */
+	hb_u64 intra_frame;
+	/* An IDR was requested for a loss and hasn't come out yet */
+	hb_bool idr_pending;
+	hb_bool idr_requested;
+	hb_u64 idr_request_frame;
+	/* Sum of the squared picture sizes */
+	hb_u64 sq_bytes;
+	/* Time the link is done with the pictures so far, from the first one */
+	hb_u64 link_free_us;
+	hb_u64 link_delay_us;
+	mc_lowlat_stats_t stats;
+};
+
+static hb_bool lowlat_params_valid(const mc_lowlat_params_t *params)
+{
+	return (params->bit_rate > 0) && (params->bit_rate <= 700000) &&
+		(params->frame_rate > 0) && (params->frame_rate <= 240) &&
+		(params->refresh_frames > 0) && (params->budget_frames > 0) &&
+		(params->budget_frames <= 30);
+}
+
+/* MB or CTU rows of the picture */
+static hb_u32 lowlat_rows(const media_codec_context_t *context)
+{
+	hb_s32 unit = (context->codec_id == MEDIA_CODEC_ID_H264) ? 16 : 64;
+
+	return (hb_u32)((context->video_enc_params.height + unit - 1) / unit);
+}
+
+/* Rows per picture, and the pictures of a cycle that it gives */
+static hb_u32 lowlat_refresh_rows(hb_u32 rows, hb_u32 frames, hb_u32 *cycle)
+{
+	hb_u32 arg = (rows + frames - 1) / frames;
+
+	*cycle = (rows + arg - 1) / arg;
+	return arg;
+}
+
+/* The members of the H264 and H265 CBR parameters are the same */
+#define LOWLAT_SET_CBR(cbr, p, vbv) \
+	do { \
+		(cbr).intra_period = 0; \
+		(cbr).intra_qp = 30; \
+		(cbr).bit_rate = (p)->bit_rate; \
+		(cbr).frame_rate = (p)->frame_rate; \
+		(cbr).initial_rc_qp = 63; \
+		(cbr).vbv_buffer_size = (vbv); \
+		(cbr).min_qp_I = 8; \
+		(cbr).max_qp_I = 51; \
+		(cbr).min_qp_P = 8; \
+		(cbr).max_qp_P = 51; \
+		(cbr).min_qp_B = 8; \
+		(cbr).max_qp_B = 51; \
+		(cbr).hvs_qp_enable = 0; \
+		(cbr).max_delta_qp = 10; \
+		(cbr).qp_map_enable = FALSE; \
+	} while (0)
+
+hb_s32 hb_mm_lowlat_preset(const mc_lowlat_params_t *params,
+		media_codec_context_t *context,
+		mc_video_intra_refresh_params_t *refresh)
+{
+	mc_video_codec_enc_params_t *enc;
+	hb_u32 rows, cycle, vbv;
+
+	if ((params == NULL) || (context == NULL) || (refresh == NULL) ||
+		!lowlat_params_valid(params)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(params=%p, context=%p).\n",
+			TAG, __FUNCTION__, __LINE__, params, context);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (!context->encoder || ((context->codec_id != MEDIA_CODEC_ID_H264) &&
+		(context->codec_id != MEDIA_CODEC_ID_H265))) {
+		VLOG(ERR, "%s <%s:%d> The instance isn't an H264/H265 encoder.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_INSTANCE;
+	}
+	enc = &context->video_enc_params;
+	rows = lowlat_rows(context);
+	if ((enc->height <= 0) || (params->refresh_frames > rows)) {
+		VLOG(ERR, "%s <%s:%d> %u refresh pictures for %u rows.\n",
+			TAG, __FUNCTION__, __LINE__, params->refresh_frames, rows);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	vbv = (params->budget_frames * 1000) / params->frame_rate;
+	vbv = (vbv < LOWLAT_MIN_VBV_MS) ? LOWLAT_MIN_VBV_MS :
+		((vbv > LOWLAT_MAX_VBV_MS) ? LOWLAT_MAX_VBV_MS : vbv);
+	memset(&enc->rc_params, 0x00, sizeof(enc->rc_params));
+	if (context->codec_id == MEDIA_CODEC_ID_H264) {
+		enc->rc_params.mode = MC_AV_RC_MODE_H264CBR;
+		LOWLAT_SET_CBR(enc->rc_params.h264_cbr_params, params, vbv);
+		enc->rc_params.h264_cbr_params.mb_level_rc_enalbe = 1;
+	} else {
+		enc->rc_params.mode = MC_AV_RC_MODE_H265CBR;
+		LOWLAT_SET_CBR(enc->rc_params.h265_cbr_params, params, vbv);
+		enc->rc_params.h265_cbr_params.ctu_level_rc_enalbe = 1;
+	}
+	/* P pictures only, nothing waits for a later picture */
+	enc->gop_params.decoding_refresh_type = 2;
+	enc->gop_params.gop_preset_idx = 2;
+
+	memset(refresh, 0x00, sizeof(*refresh));
+	refresh->intra_refresh_mode = 1;
+	refresh->intra_refresh_arg = lowlat_refresh_rows(rows,
+		params->refresh_frames, &cycle);
+
+	return 0;
+}
+
+hb_s32 hb_mm_lowlat_create(media_codec_context_t *context,
+		const mc_lowlat_params_t *params, mc_lowlat_t **ll)
+{
+	mc_lowlat_t *l;
+	hb_u32 rows;
+
+	if ((context == NULL) || (params == NULL) || (ll == NULL) ||
+		!lowlat_params_valid(params)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(context=%p, params=%p).\n",
+			TAG, __FUNCTION__, __LINE__, context, params);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (!context->encoder || ((context->codec_id != MEDIA_CODEC_ID_H264) &&
+		(context->codec_id != MEDIA_CODEC_ID_H265))) {
+		VLOG(ERR, "%s <%s:%d> The instance isn't an H264/H265 encoder.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_INSTANCE;
+	}
+	rows = lowlat_rows(context);
+	if ((context->video_enc_params.height <= 0) ||
+		(params->refresh_frames > rows)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	l = (mc_lowlat_t *)calloc(1, sizeof(*l));
+	if (l == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	l->context = context;
+	l->params = *params;
+	lowlat_refresh_rows(rows, params->refresh_frames,
+		&l->stats.refresh_frames);
+
+	*ll = l;
+	return 0;
+}
+
+static hb_u32 lowlat_isqrt(hb_u64 v)
+{
+	hb_u64 r = 0, bit = (hb_u64)1 << 62;
+
+	while (bit > v) {
+		bit >>= 2;
+	}
+	while (bit != 0) {
+		if (v >= r + bit) {
+			v -= r + bit;
+			r = (r >> 1) + bit;
+		} else {
+			r >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (hb_u32)r;
+}
+
+static void lowlat_recovered(mc_lowlat_t *ll, hb_bool intra)
+{
+	ll->stats.recovering = FALSE;
+	ll->idr_pending = FALSE;
+	if (intra) {
+		ll->stats.idr_recoveries++;
+	} else {
+		ll->stats.refresh_recoveries++;
+	}
+}
+
+hb_s32 hb_mm_lowlat_update(mc_lowlat_t *ll,
+		const media_codec_output_buffer_info_t *info)
+{
+	const mc_h264_h265_output_stream_info_t *s;
+	mc_lowlat_stats_t *st;
+	hb_u64 n, ready, start, delay, mean, sq;
+	hb_u32 bytes;
+
+	if ((ll == NULL) || (info == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(ll=%p, info=%p).\n",
+			TAG, __FUNCTION__, __LINE__, ll, info);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	s = &info->video_stream_info;
+	st = &ll->stats;
+	n = st->frames;
+
+	if ((s->nalu_type == MC_H264_NALU_TYPE_I) ||
+		(s->nalu_type == MC_H264_NALU_TYPE_IDR) ||
+		(s->nalu_type == MC_H265_NALU_TYPE_IDR)) {
+		ll->intra_frame = n;
+		if (st->recovering) {
+			st->recovery_frame = n;
+			lowlat_recovered(ll, TRUE);
+		}
+	} else if (st->recovering && !ll->idr_pending &&
+		(n >= st->recovery_frame)) {
+		lowlat_recovered(ll, FALSE);
+	}
+
+	bytes = s->enc_pic_byte;
+	st->frames++;
+	st->bytes += bytes;
+	ll->sq_bytes += (hb_u64)bytes * bytes;
+	if (bytes > st->max_frame_bytes) {
+		st->max_frame_bytes = bytes;
+	}
+	mean = st->bytes / st->frames;
+	sq = ll->sq_bytes / st->frames;
+	st->frame_bytes_stddev = (sq > mean * mean) ?
+		lowlat_isqrt(sq - (mean * mean)) : 0;
+
+	/* the picture is ready at its capture time and waits for the link */
+	ready = (n * 1000000) / ll->params.frame_rate;
+	start = (ll->link_free_us > ready) ? ll->link_free_us : ready;
+	ll->link_free_us = start + (((hb_u64)bytes * 8000) / ll->params.bit_rate);
+	delay = ll->link_free_us - ready;
+	ll->link_delay_us += delay;
+	st->avg_link_delay_us = ll->link_delay_us / st->frames;
+	if (delay > st->max_link_delay_us) {
+		st->max_link_delay_us = delay;
+	}
+
+	return 0;
+}
+
+hb_s32 hb_mm_lowlat_report_loss(mc_lowlat_t *ll, hb_u64 frame)
+{
+	mc_lowlat_stats_t *st;
+	hb_u64 pos, cycle, healed, next;
+	hb_s32 ret;
+
+	if ((ll == NULL) || (frame >= ll->stats.frames)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(ll=%p).\n",
+			TAG, __FUNCTION__, __LINE__, ll);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	st = &ll->stats;
+	st->losses++;
+	if ((frame < ll->intra_frame) || ll->idr_pending) {
+		/* an intra picture after it already heals it */
+		return 0;
+	}
+
+	/* the cycles run from the picture after the intra one */
+	next = st->frames;
+	pos = frame - ll->intra_frame;
+	cycle = st->refresh_frames;
+	/* without the intra picture there are no parameter sets either */
+	healed = (pos == 0) ? (hb_u64)-1 :
+		(ll->intra_frame + ((((pos + cycle - 1) / cycle) + 1) * cycle));
+	if (st->recovering && (st->recovery_frame > healed)) {
+		healed = st->recovery_frame;
+	}
+	st->recovering = TRUE;
+	if ((healed != (hb_u64)-1) &&
+		(healed < next + ll->params.max_recovery_frames)) {
+		st->recovery_frame = healed;
+		return 0;
+	}
+	if ((healed != (hb_u64)-1) && ll->idr_requested &&
+		((next - ll->idr_request_frame) < ll->params.min_idr_interval)) {
+		/* too soon for another IDR, the refresh heals it meanwhile */
+		st->recovery_frame = healed;
+		return 0;
+	}
+
+	ret = hb_mm_mc_request_idr_frame(ll->context);
+	if (ret < 0) {
+		VLOG(ERR, "%s <%s:%d> Failed to request an IDR(%d).\n",
+			TAG, __FUNCTION__, __LINE__, ret);
+		st->recovery_frame = healed;
+		return ret;
+	}
+	ll->idr_pending = TRUE;
+	ll->idr_requested = TRUE;
+	ll->idr_request_frame = next;
+	st->recovery_frame = next;
+
+	return 0;
+}
+
+hb_s32 hb_mm_lowlat_get_stats(mc_lowlat_t *ll, mc_lowlat_stats_t *stats)
+{
+	if ((ll == NULL) || (stats == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	*stats = ll->stats;
+
+	return 0;
+}
+
+hb_s32 hb_mm_lowlat_destroy(mc_lowlat_t *ll)
+{
+	if (ll == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	free(ll);
+
+	return 0;
+}
@@ -0,0 +1,218 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "hb_media_ltr.h"
+#include "media_common.h"
+
+#define TAG "[MEDIALTR]"
+
+/* Each picture moves the smoothed shares by 1/8 of the difference */
+#define LTR_SMOOTH_SHIFT 3
+
+struct _mc_ltr {
+	media_codec_context_t *context;
+	mc_ltr_params_t params;
+	/* Last setting sent */
+	mc_video_longterm_ref_mode_t mode;
+	/* Smoothed shares in per mille << LTR_SMOOTH_SHIFT */
+	hb_u32 skip_acc;
+	hb_u32 intra_acc;
+	hb_bool smoothed;
+	/* Static pictures since the last period change */
+	hb_u32 static_run;
+	hb_u32 blocks8;
+	hb_u32 blocks16;
+	mc_ltr_stats_t stats;
+};
+
+static hb_bool ltr_params_valid(const mc_ltr_params_t *params)
+{
+	return (params->static_skip_permille > 0) &&
+		(params->static_skip_permille <= 1000) &&
+		(params->max_intra_permille <= 1000) &&
+		(params->hold_frames > 0) && (params->min_pic_period > 0) &&
+		(params->min_pic_period <= params->max_pic_period) &&
+		(params->max_pic_period <= 0x7FFFFFFF) &&
+		(params->static_using_period <= 0x7FFFFFFF) &&
+		(params->motion_using_period <= 0x7FFFFFFF);
+}
+
+static hb_s32 ltr_apply(mc_ltr_t *ltr, hb_u32 period, hb_u32 using_period)
+{
+	mc_video_longterm_ref_mode_t mode;
+	hb_s32 ret;
+
+	if ((period == ltr->mode.longterm_pic_period) &&
+		(using_period == ltr->mode.longterm_pic_using_period)) {
+		return 0;
+	}
+	mode = ltr->mode;
+	mode.longterm_pic_period = period;
+	mode.longterm_pic_using_period = using_period;
+	ret = hb_mm_mc_set_longterm_ref_mode(ltr->context, &mode);
+	if (ret < 0) {
+		VLOG(ERR, "%s <%s:%d> Failed to set long-term period %u/%u(%d).\n",
+			TAG, __FUNCTION__, __LINE__, period, using_period, ret);
+		ltr->stats.set_failures++;
+		return ret;
+	}
+	ltr->mode = mode;
+	ltr->stats.updates++;
+	ltr->stats.pic_period = period;
+	ltr->stats.using_period = using_period;
+
+	return 0;
+}
+
+hb_s32 hb_mm_ltr_create(media_codec_context_t *context,
+		const mc_ltr_params_t *params, mc_ltr_t **ltr)
+{
+	mc_video_codec_enc_params_t *enc;
+	mc_ltr_t *l;
+	hb_s32 ret;
+
+	if ((context == NULL) || (params == NULL) || (ltr == NULL) ||
+		!ltr_params_valid(params)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(context=%p, params=%p).\n",
+			TAG, __FUNCTION__, __LINE__, context, params);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (!context->encoder || ((context->codec_id != MEDIA_CODEC_ID_H264) &&
+		(context->codec_id != MEDIA_CODEC_ID_H265))) {
+		VLOG(ERR, "%s <%s:%d> The instance isn't an H264/H265 encoder.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_INSTANCE;
+	}
+
+	l = (mc_ltr_t *)calloc(1, sizeof(*l));
+	if (l == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	l->context = context;
+	l->params = *params;
+	ret = hb_mm_mc_get_longterm_ref_mode(context, &l->mode);
+	if (ret < 0) {
+		VLOG(ERR, "%s <%s:%d> Failed to get long-term ref mode(%d).\n",
+			TAG, __FUNCTION__, __LINE__, ret);
+		free(l);
+		return ret;
+	}
+	if (!l->mode.use_longterm) {
+		/* use_longterm can't change in the sequence */
+		VLOG(ERR, "%s <%s:%d> The encoder doesn't use long-term references.\n",
+			TAG, __FUNCTION__, __LINE__);
+		free(l);
+		return HB_MEDIA_ERR_OPERATION_NOT_ALLOWED;
+	}
+	l->stats.pic_period = l->mode.longterm_pic_period;
+	l->stats.using_period = l->mode.longterm_pic_using_period;
+	ret = ltr_apply(l, params->min_pic_period, params->motion_using_period);
+	if (ret < 0) {
+		free(l);
+		return ret;
+	}
+	enc = &context->video_enc_params;
+	l->blocks8 = (hb_u32)(((enc->width + 7) / 8) * ((enc->height + 7) / 8));
+	l->blocks16 = (hb_u32)(((enc->width + 15) / 16) *
+		((enc->height + 15) / 16));
+
+	*ltr = l;
+	return 0;
+}
+
+hb_s32 hb_mm_ltr_set_params(mc_ltr_t *ltr, const mc_ltr_params_t *params)
+{
+	if ((ltr == NULL) || (params == NULL) || !ltr_params_valid(params)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(ltr=%p, params=%p).\n",
+			TAG, __FUNCTION__, __LINE__, ltr, params);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	ltr->params = *params;
+
+	return 0;
+}
+
+static hb_u32 ltr_smooth(hb_u32 acc, hb_u32 permille)
+{
+	return acc - (acc >> LTR_SMOOTH_SHIFT) + permille;
+}
+
+hb_s32 hb_mm_ltr_update(mc_ltr_t *ltr,
+		const media_codec_output_buffer_info_t *info)
+{
+	const mc_h264_h265_output_stream_info_t *s;
+	const mc_ltr_params_t *p;
+	hb_u32 skip, intra, period, cur;
+
+	if ((ltr == NULL) || (info == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(ltr=%p, info=%p).\n",
+			TAG, __FUNCTION__, __LINE__, ltr, info);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	s = &info->video_stream_info;
+	p = &ltr->params;
+
+	ltr->stats.frames++;
+	/* intra pictures tell nothing about the scene and restart the run */
+	if ((s->nalu_type == MC_H264_NALU_TYPE_I) ||
+		(s->nalu_type == MC_H264_NALU_TYPE_IDR) ||
+		(s->nalu_type == MC_H265_NALU_TYPE_IDR)) {
+		ltr->static_run = 0;
+		return 0;
+	}
+	ltr->stats.p_frames++;
+	ltr->stats.p_bytes += s->enc_pic_byte;
+
+	skip = (ltr->blocks8 == 0) ? 0 :
+		(hb_u32)(((hb_u64)s->skip_block_num * 1000) / ltr->blocks8);
+	intra = (ltr->blocks16 == 0) ? 0 :
+		(hb_u32)(((hb_u64)s->intra_block_num * 1000) / ltr->blocks16);
+	skip = (skip > 1000) ? 1000 : skip;
+	intra = (intra > 1000) ? 1000 : intra;
+	if (!ltr->smoothed) {
+		ltr->skip_acc = skip << LTR_SMOOTH_SHIFT;
+		ltr->intra_acc = intra << LTR_SMOOTH_SHIFT;
+		ltr->smoothed = TRUE;
+	} else {
+		ltr->skip_acc = ltr_smooth(ltr->skip_acc, skip);
+		ltr->intra_acc = ltr_smooth(ltr->intra_acc, intra);
+	}
+	ltr->stats.skip_permille = ltr->skip_acc >> LTR_SMOOTH_SHIFT;
+	ltr->stats.intra_permille = ltr->intra_acc >> LTR_SMOOTH_SHIFT;
+
+	if ((ltr->stats.skip_permille < p->static_skip_permille) ||
+		(ltr->stats.intra_permille > p->max_intra_permille)) {
+		ltr->static_run = 0;
+		return ltr_apply(ltr, p->min_pic_period, p->motion_using_period);
+	}
+
+	ltr->stats.static_frames++;
+	if (++ltr->static_run < p->hold_frames) {
+		return 0;
+	}
+	ltr->static_run = 0;
+	cur = ltr->mode.longterm_pic_period;
+	period = (cur < p->min_pic_period) ? p->min_pic_period :
+		((cur > (p->max_pic_period / 2)) ? p->max_pic_period : (cur * 2));
+	return ltr_apply(ltr, period, p->static_using_period);
+}
+
+hb_s32 hb_mm_ltr_get_stats(mc_ltr_t *ltr, mc_ltr_stats_t *stats)
+{
+	if ((ltr == NULL) || (stats == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	*stats = ltr->stats;
+
+	return 0;
+}
+
+hb_s32 hb_mm_ltr_destroy(mc_ltr_t *ltr)
+{
+	if (ltr == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	free(ltr);
+
+	return 0;
+}
@@ -0,0 +1,99 @@
+#include <string.h>
+
+#include "hb_media_nal.h"
+#include "media_common.h"
+
+#define TAG "[MEDIANAL]"
+
+/*
+ * Return the offset of the first 00 00 01 at or after pos, or size if
+ * there is none.
+ */
+static hb_u32 nal_find_start_code(const hb_u8 *data, hb_u32 size, hb_u32 pos)
+{
+	const hb_u8 *p;
+
+	while ((pos + 3U) <= size) {
+		p = (const hb_u8 *)memchr(data + pos + 2U, 0x01, size - pos - 2U);
+		if (p == NULL) {
+			break;
+		}
+		pos = (hb_u32)(p - data) - 2U;
+		if ((data[pos] == 0U) && (data[pos + 1U] == 0U)) {
+			return pos;
+		}
+		pos += 1U;
+	}
+
+	return size;
+}
+
+static hb_s32 nal_get_type(media_codec_id_t codec_id, hb_u8 header)
+{
+	if (codec_id == MEDIA_CODEC_ID_H264) {
+		return (hb_s32)(header & 0x1FU);
+	}
+	return (hb_s32)((header >> 1) & 0x3FU);
+}
+
+hb_s32 hb_mm_nal_next(media_codec_id_t codec_id, const hb_u8 *data,
+		hb_u32 size, hb_u32 *pos, mc_nal_unit_t *nal)
+{
+	hb_u32 start, next, header;
+
+	if ((data == NULL) || (pos == NULL) || (nal == NULL) ||
+		((codec_id != MEDIA_CODEC_ID_H264) &&
+		(codec_id != MEDIA_CODEC_ID_H265))) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(codec=%d, data=%p).\n",
+			TAG, __FUNCTION__, __LINE__, codec_id, data);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	start = nal_find_start_code(data, size, *pos);
+	if (start >= size) {
+		*pos = size;
+		return 0;
+	}
+	header = start + 3U;
+	if ((start > *pos) && (data[start - 1U] == 0U)) {
+		start--;
+	}
+	if (header >= size) {
+		*pos = size;
+		return 0;
+	}
+
+	next = nal_find_start_code(data, size, header);
+	/* a zero before the next start code belongs to a 4 byte start code */
+	if ((next < size) && (next > header) && (data[next - 1U] == 0U)) {
+		next--;
+	}
+
+	nal->offset = start;
+	nal->size = next - start;
+	nal->start_code_size = header - start;
+	nal->type = nal_get_type(codec_id, data[header]);
+	*pos = next;
+
+	return 1;
+}
+
+hb_bool hb_mm_nal_is_param_set(media_codec_id_t codec_id, hb_s32 type)
+{
+	if (codec_id == MEDIA_CODEC_ID_H264) {
+		return (type == MC_H264_NALU_TYPE_SPS) ||
+			(type == MC_H264_NALU_TYPE_PPS);
+	}
+	return (type == MC_H265_NALU_TYPE_VPS) ||
+		(type == MC_H265_NALU_TYPE_SPS) ||
+		(type == MC_H265_NALU_TYPE_PPS);
+}
+
+hb_bool hb_mm_nal_is_key(media_codec_id_t codec_id, hb_s32 type)
+{
+	if (codec_id == MEDIA_CODEC_ID_H264) {
+		return type == MC_H264_NALU_TYPE_IDR;
+	}
+	/* BLA_W_LP(16) .. CRA_NUT(21) are the IRAP pictures */
+	return (type >= 16) && (type <= 21);
+}
@@ -0,0 +1,346 @@
+#include <string.h>
+
+#include "hb_media_pixfmt.h"
+#include "media_common.h"
+#include "media_pixfmt.h"
+#include "media_simd.h"
+
+#define TAG "[MEDIAPIXFMT]"
+
+typedef void (*pf_interleave_fn)(hb_u8 *dst, const hb_u8 *u, const hb_u8 *v,
+		hb_s32 n);
+typedef void (*pf_deinterleave_fn)(hb_u8 *u, hb_u8 *v, const hb_u8 *src,
+		hb_s32 n);
+typedef void (*pf_swap_fn)(hb_u8 *dst, const hb_u8 *src, hb_s32 n);
+
+typedef struct _pf_kernels {
+	pf_interleave_fn interleave;
+	pf_deinterleave_fn deinterleave;
+	pf_swap_fn swap;
+} pf_kernels_t;
+
+/* n is the number of chroma pairs in all kernels */
+static void pf_interleave_c(hb_u8 *dst, const hb_u8 *u, const hb_u8 *v,
+		hb_s32 n)
+{
+	hb_s32 i;
+
+	for (i = 0; i < n; i++) {
+		dst[2 * i] = u[i];
+		dst[(2 * i) + 1] = v[i];
+	}
+}
+
+static void pf_deinterleave_c(hb_u8 *u, hb_u8 *v, const hb_u8 *src, hb_s32 n)
+{
+	hb_s32 i;
+
+	for (i = 0; i < n; i++) {
+		u[i] = src[2 * i];
+		v[i] = src[(2 * i) + 1];
+	}
+}
+
+static void pf_swap_c(hb_u8 *dst, const hb_u8 *src, hb_s32 n)
+{
+	hb_s32 i;
+	hb_u8 t;
+
+	for (i = 0; i < n; i++) {
+		t = src[2 * i];
+		dst[2 * i] = src[(2 * i) + 1];
+		dst[(2 * i) + 1] = t;
+	}
+}
+
+#if defined(MEDIA_SIMD_X86)
+static void pf_interleave_sse2(hb_u8 *dst, const hb_u8 *u, const hb_u8 *v,
+		hb_s32 n)
+{
+	__m128i a, b;
+	hb_s32 i;
+
+	for (i = 0; (i + 16) <= n; i += 16) {
+		a = _mm_loadu_si128((const __m128i *)(u + i));
+		b = _mm_loadu_si128((const __m128i *)(v + i));
+		_mm_storeu_si128((__m128i *)(dst + (2 * i)), _mm_unpacklo_epi8(a, b));
+		_mm_storeu_si128((__m128i *)(dst + (2 * i) + 16),
+			_mm_unpackhi_epi8(a, b));
+	}
+	pf_interleave_c(dst + (2 * i), u + i, v + i, n - i);
+}
+
+static void pf_deinterleave_sse2(hb_u8 *u, hb_u8 *v, const hb_u8 *src,
+		hb_s32 n)
+{
+	const __m128i mask = _mm_set1_epi16(0x00FF);
+	__m128i a, b;
+	hb_s32 i;
+
+	for (i = 0; (i + 16) <= n; i += 16) {
+		a = _mm_loadu_si128((const __m128i *)(src + (2 * i)));
+		b = _mm_loadu_si128((const __m128i *)(src + (2 * i) + 16));
+		_mm_storeu_si128((__m128i *)(u + i), _mm_packus_epi16(
+			_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+		_mm_storeu_si128((__m128i *)(v + i), _mm_packus_epi16(
+			_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+	}
+	pf_deinterleave_c(u + i, v + i, src + (2 * i), n - i);
+}
+
+static void pf_swap_sse2(hb_u8 *dst, const hb_u8 *src, hb_s32 n)
+{
+	__m128i a;
+	hb_s32 i;
+
+	for (i = 0; (i + 8) <= n; i += 8) {
+		a = _mm_loadu_si128((const __m128i *)(src + (2 * i)));
+		_mm_storeu_si128((__m128i *)(dst + (2 * i)),
+			_mm_or_si128(_mm_slli_epi16(a, 8), _mm_srli_epi16(a, 8)));
+	}
+	pf_swap_c(dst + (2 * i), src + (2 * i), n - i);
+}
+
+MEDIA_TARGET_AVX2
+static void pf_interleave_avx2(hb_u8 *dst, const hb_u8 *u, const hb_u8 *v,
+		hb_s32 n)
+{
+	__m256i a, b, lo, hi;
+	hb_s32 i;
+
+	for (i = 0; (i + 32) <= n; i += 32) {
+		a = _mm256_loadu_si256((const __m256i *)(u + i));
+		b = _mm256_loadu_si256((const __m256i *)(v + i));
+		/* unpack works per 128 bit lane, put the lanes back in order */
+		lo = _mm256_unpacklo_epi8(a, b);
+		hi = _mm256_unpackhi_epi8(a, b);
+		_mm256_storeu_si256((__m256i *)(dst + (2 * i)),
+			_mm256_permute2x128_si256(lo, hi, 0x20));
+		_mm256_storeu_si256((__m256i *)(dst + (2 * i) + 32),
+			_mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+	pf_interleave_sse2(dst + (2 * i), u + i, v + i, n - i);
+}
+
+MEDIA_TARGET_AVX2
+static void pf_deinterleave_avx2(hb_u8 *u, hb_u8 *v, const hb_u8 *src,
+		hb_s32 n)
+{
+	const __m256i mask = _mm256_set1_epi16(0x00FF);
+	__m256i a, b;
+	hb_s32 i;
+
+	for (i = 0; (i + 32) <= n; i += 32) {
+		a = _mm256_loadu_si256((const __m256i *)(src + (2 * i)));
+		b = _mm256_loadu_si256((const __m256i *)(src + (2 * i) + 32));
+		/* pack works per 128 bit lane, 0xD8 restores the 64 bit order */
+		_mm256_storeu_si256((__m256i *)(u + i), _mm256_permute4x64_epi64(
+			_mm256_packus_epi16(_mm256_and_si256(a, mask),
+			_mm256_and_si256(b, mask)), 0xD8));
+		_mm256_storeu_si256((__m256i *)(v + i), _mm256_permute4x64_epi64(
+			_mm256_packus_epi16(_mm256_srli_epi16(a, 8),
+			_mm256_srli_epi16(b, 8)), 0xD8));
+	}
+	pf_deinterleave_sse2(u + i, v + i, src + (2 * i), n - i);
+}
+
+MEDIA_TARGET_AVX2
+static void pf_swap_avx2(hb_u8 *dst, const hb_u8 *src, hb_s32 n)
+{
+	__m256i a;
+	hb_s32 i;
+
+	for (i = 0; (i + 16) <= n; i += 16) {
+		a = _mm256_loadu_si256((const __m256i *)(src + (2 * i)));
+		_mm256_storeu_si256((__m256i *)(dst + (2 * i)), _mm256_or_si256(
+			_mm256_slli_epi16(a, 8), _mm256_srli_epi16(a, 8)));
+	}
+	pf_swap_sse2(dst + (2 * i), src + (2 * i), n - i);
+}
+#endif
+
+#if defined(MEDIA_SIMD_NEON)
+static void pf_interleave_neon(hb_u8 *dst, const hb_u8 *u, const hb_u8 *v,
+		hb_s32 n)
+{
+	uint8x16x2_t uv;
+	hb_s32 i;
+
+	for (i = 0; (i + 16) <= n; i += 16) {
+		uv.val[0] = vld1q_u8(u + i);
+		uv.val[1] = vld1q_u8(v + i);
+		vst2q_u8(dst + (2 * i), uv);
+	}
+	pf_interleave_c(dst + (2 * i), u + i, v + i, n - i);
+}
+
+static void pf_deinterleave_neon(hb_u8 *u, hb_u8 *v, const hb_u8 *src,
+		hb_s32 n)
+{
+	uint8x16x2_t uv;
+	hb_s32 i;
+
+	for (i = 0; (i + 16) <= n; i += 16) {
+		uv = vld2q_u8(src + (2 * i));
+		vst1q_u8(u + i, uv.val[0]);
+		vst1q_u8(v + i, uv.val[1]);
+	}
+	pf_deinterleave_c(u + i, v + i, src + (2 * i), n - i);
+}
+
+static void pf_swap_neon(hb_u8 *dst, const hb_u8 *src, hb_s32 n)
+{
+	hb_s32 i;
+
+	for (i = 0; (i + 8) <= n; i += 8) {
+		vst1q_u8(dst + (2 * i), vrev16q_u8(vld1q_u8(src + (2 * i))));
+	}
+	pf_swap_c(dst + (2 * i), src + (2 * i), n - i);
+}
+#endif
+
+static void pf_get_kernels(pf_kernels_t *k)
+{
+	k->interleave = pf_interleave_c;
+	k->deinterleave = pf_deinterleave_c;
+	k->swap = pf_swap_c;
+
+	switch (media_simd_isa()) {
+#if defined(MEDIA_SIMD_X86)
+	case MC_SIMD_ISA_AVX2:
+		k->interleave = pf_interleave_avx2;
+		k->deinterleave = pf_deinterleave_avx2;
+		k->swap = pf_swap_avx2;
+		break;
+	case MC_SIMD_ISA_SSE2:
+		k->interleave = pf_interleave_sse2;
+		k->deinterleave = pf_deinterleave_sse2;
+		k->swap = pf_swap_sse2;
+		break;
+#endif
+#if defined(MEDIA_SIMD_NEON)
+	case MC_SIMD_ISA_NEON:
+		k->interleave = pf_interleave_neon;
+		k->deinterleave = pf_deinterleave_neon;
+		k->swap = pf_swap_neon;
+		break;
+#endif
+	default:
+		break;
+	}
+}
+
+static void pf_copy_plane(hb_u8 *dst, hb_s32 dst_stride, const hb_u8 *src,
+		hb_s32 src_stride, hb_s32 width, hb_s32 height)
+{
+	hb_s32 y;
+
+	if ((dst_stride == width) && (src_stride == width)) {
+		memcpy(dst, src, (size_t)width * (size_t)height);
+		return;
+	}
+	for (y = 0; y < height; y++) {
+		memcpy(dst + ((size_t)y * dst_stride),
+			src + ((size_t)y * src_stride), (size_t)width);
+	}
+}
+
+static hb_bool pf_is_420(mc_pixel_format_t fmt)
+{
+	return (fmt == MC_PIXEL_FORMAT_YUV420P) || (fmt == MC_PIXEL_FORMAT_NV12) ||
+		(fmt == MC_PIXEL_FORMAT_NV21);
+}
+
+void media_pixfmt_layout(mc_video_frame_buffer_info_t *frame,
+		hb_s32 *lstride, hb_s32 *cstride)
+{
+	hb_s32 cw, ch;
+
+	cw = (frame->width + 1) / 2;
+	ch = (frame->height + 1) / 2;
+	*lstride = (frame->stride > 0) ? frame->stride : frame->width;
+	if (frame->vstride > 0) {
+		*cstride = frame->vstride;
+	} else if (frame->pix_fmt == MC_PIXEL_FORMAT_YUV420P) {
+		*cstride = (*lstride / 2 > cw) ? (*lstride / 2) : cw;
+	} else {
+		*cstride = (*lstride > 2 * cw) ? *lstride : (2 * cw);
+	}
+	if (frame->vir_ptr[1] == NULL) {
+		frame->vir_ptr[1] = frame->vir_ptr[0] +
+			((size_t)*lstride * frame->height);
+	}
+	if ((frame->pix_fmt == MC_PIXEL_FORMAT_YUV420P) &&
+		(frame->vir_ptr[2] == NULL)) {
+		frame->vir_ptr[2] = frame->vir_ptr[1] + ((size_t)*cstride * ch);
+	}
+}
+
+hb_s32 hb_mm_pixfmt_convert(mc_pixel_format_t src_fmt,
+		const mc_video_planes_t *src, mc_video_frame_buffer_info_t *dst)
+{
+	mc_pixel_format_t dst_fmt;
+	pf_kernels_t k;
+	hb_s32 width, height, cw, ch, lstride, cstride, y;
+	const hb_u8 *su, *sv;
+	hb_u8 *du, *dv;
+
+	if ((src == NULL) || (dst == NULL) || (src->data[0] == NULL) ||
+		(src->data[1] == NULL) || (dst->vir_ptr[0] == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(src=%p, dst=%p).\n",
+			TAG, __FUNCTION__, __LINE__, src, dst);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	dst_fmt = dst->pix_fmt;
+	width = dst->width;
+	height = dst->height;
+	if (!pf_is_420(src_fmt) || !pf_is_420(dst_fmt) || (width <= 0) ||
+		(height <= 0) || ((src_fmt == MC_PIXEL_FORMAT_YUV420P) &&
+		(src->data[2] == NULL))) {
+		VLOG(ERR, "%s <%s:%d> Unsupported conversion %d->%d(%dx%d).\n",
+			TAG, __FUNCTION__, __LINE__, src_fmt, dst_fmt, width, height);
+		return HB_MEDIA_ERR_UNSUPPORTED_FEATURE;
+	}
+
+	cw = (width + 1) / 2;
+	ch = (height + 1) / 2;
+	media_pixfmt_layout(dst, &lstride, &cstride);
+
+	pf_copy_plane(dst->vir_ptr[0], lstride, src->data[0], src->stride[0],
+		width, height);
+
+	if (src_fmt == dst_fmt) {
+		pf_copy_plane(dst->vir_ptr[1], cstride, src->data[1], src->stride[1],
+			(src_fmt == MC_PIXEL_FORMAT_YUV420P) ? cw : (2 * cw), ch);
+		if (src_fmt == MC_PIXEL_FORMAT_YUV420P) {
+			pf_copy_plane(dst->vir_ptr[2], cstride, src->data[2],
+				src->stride[2], cw, ch);
+		}
+		return 0;
+	}
+
+	pf_get_kernels(&k);
+	for (y = 0; y < ch; y++) {
+		su = src->data[1] + ((size_t)y * src->stride[1]);
+		du = dst->vir_ptr[1] + ((size_t)y * cstride);
+		if (src_fmt == MC_PIXEL_FORMAT_YUV420P) {
+			sv = src->data[2] + ((size_t)y * src->stride[2]);
+			if (dst_fmt == MC_PIXEL_FORMAT_NV12) {
+				k.interleave(du, su, sv, cw);
+			} else {
+				k.interleave(du, sv, su, cw);
+			}
+		} else if (dst_fmt == MC_PIXEL_FORMAT_YUV420P) {
+			dv = dst->vir_ptr[2] + ((size_t)y * cstride);
+			if (src_fmt == MC_PIXEL_FORMAT_NV12) {
+				k.deinterleave(du, dv, su, cw);
+			} else {
+				k.deinterleave(dv, du, su, cw);
+			}
+		} else {
+			k.swap(du, su, cw);
+		}
+	}
+
+	return 0;
+}
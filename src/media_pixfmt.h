@@ -0,0 +1,20 @@
+#ifndef MEDIA_PIXFMT_H
+#define MEDIA_PIXFMT_H
+
+#include "hb_media_pixfmt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Resolve the luma and chroma strides of an encoder input buffer and fill
+ * in vir_ptr[1]/vir_ptr[2] if they are NULL. The format must be 4:2:0.
+ */
+extern void media_pixfmt_layout(mc_video_frame_buffer_info_t *frame,
+		hb_s32 *lstride, hb_s32 *cstride);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* MEDIA_PIXFMT_H */
@@ -0,0 +1,203 @@
+#include <string.h>
+
+#include "hb_media_nal.h"
+#include "hb_media_preview.h"
+#include "media_common.h"
+
+#define TAG "[MEDIAPREVIEW]"
+
+#define PREVIEW_SKIP_NONE 0x00
+#define PREVIEW_SKIP_NON_IRAP 0x01
+#define PREVIEW_SKIP_NON_REF 0x02
+
+/* Speeds are met within 10%, a GOP boundary in the sample costs a picture */
+#define PREVIEW_SLACK_NUM 11
+#define PREVIEW_SLACK_DEN 10
+
+static void pv_count_h264(const hb_u8 *hdr, hb_u32 avail,
+		mc_preview_probe_t *probe)
+{
+	hb_s32 type = hdr[0] & 0x1F;
+
+	/* coded slices, first_mb_in_slice == 0 starts a picture */
+	if ((type < 1) || (type > 5) || (avail < 2) || !(hdr[1] & 0x80)) {
+		return;
+	}
+	probe->pictures++;
+	probe->layer_pictures[0]++;
+	if (type == 5) {
+		probe->key_pictures++;
+	}
+	if (((hdr[0] >> 5) & 0x03) == 0) {
+		probe->non_ref_pictures++;
+	}
+}
+
+static void pv_count_h265(const hb_u8 *hdr, hb_u32 avail,
+		mc_preview_probe_t *probe)
+{
+	hb_s32 type = (hdr[0] >> 1) & 0x3F;
+	hb_u32 tid;
+
+	if (avail < 3) {
+		return;
+	}
+	if (type == 33) {
+		probe->max_sub_layers = ((hdr[2] >> 1) & 0x07) + 1;
+		return;
+	}
+	/* VCL NAL units, first_slice_segment_in_pic_flag starts a picture */
+	if ((type > 31) || !(hdr[2] & 0x80)) {
+		return;
+	}
+	tid = (hdr[1] & 0x07) - 1;
+	if (tid >= MC_PREVIEW_MAX_LAYERS) {
+		return;
+	}
+	probe->pictures++;
+	probe->layer_pictures[tid]++;
+	if (hb_mm_nal_is_key(MEDIA_CODEC_ID_H265, type)) {
+		probe->key_pictures++;
+	}
+	/* TRAIL_N, TSA_N, STSA_N, RADL_N, RASL_N and the reserved _N types */
+	if ((type <= 14) && ((type & 0x01) == 0)) {
+		probe->non_ref_pictures++;
+	}
+}
+
+hb_s32 hb_mm_preview_probe(media_codec_id_t codec_id, const hb_u8 *data,
+		hb_u32 size, mc_preview_probe_t *probe)
+{
+	mc_nal_unit_t nal;
+	hb_u32 pos = 0;
+	hb_s32 ret;
+
+	if ((data == NULL) || (probe == NULL) ||
+		((codec_id != MEDIA_CODEC_ID_H264) &&
+		(codec_id != MEDIA_CODEC_ID_H265))) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(codec=%d, data=%p).\n",
+			TAG, __FUNCTION__, __LINE__, codec_id, data);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	while ((ret = hb_mm_nal_next(codec_id, data, size, &pos, &nal)) == 1) {
+		if (codec_id == MEDIA_CODEC_ID_H264) {
+			pv_count_h264(data + nal.offset + nal.start_code_size,
+				nal.size - nal.start_code_size, probe);
+		} else {
+			pv_count_h265(data + nal.offset + nal.start_code_size,
+				nal.size - nal.start_code_size, probe);
+		}
+	}
+	if (codec_id == MEDIA_CODEC_ID_H264) {
+		probe->max_sub_layers = 1;
+	}
+
+	return (ret < 0) ? ret : 0;
+}
+
+static hb_bool pv_fast_enough(const mc_preview_probe_t *probe,
+		hb_u32 decoded, hb_u32 factor)
+{
+	return ((hb_u64)decoded * factor * PREVIEW_SLACK_DEN) <=
+		((hb_u64)probe->pictures * PREVIEW_SLACK_NUM);
+}
+
+hb_s32 hb_mm_preview_plan(media_codec_id_t codec_id,
+		mc_preview_speed_t speed, const mc_preview_probe_t *probe,
+		mc_preview_plan_t *plan)
+{
+	hb_u32 factor, layers, decoded, best, t, i;
+
+	if ((plan == NULL) || (speed < MC_PREVIEW_SPEED_1X) ||
+		(speed >= MC_PREVIEW_SPEED_TOTAL) ||
+		((codec_id != MEDIA_CODEC_ID_H264) &&
+		(codec_id != MEDIA_CODEC_ID_H265))) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(codec=%d, speed=%d).\n",
+			TAG, __FUNCTION__, __LINE__, codec_id, speed);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	memset(plan, 0x00, sizeof(*plan));
+	if ((probe == NULL) || (probe->pictures == 0)) {
+		if (speed == MC_PREVIEW_SPEED_KEYFRAMES) {
+			plan->skip_mode = PREVIEW_SKIP_NON_IRAP;
+		} else if (speed != MC_PREVIEW_SPEED_1X) {
+			plan->skip_mode = PREVIEW_SKIP_NON_REF;
+		}
+		return 0;
+	}
+
+	plan->decoded_permille = 1000;
+	if (speed == MC_PREVIEW_SPEED_1X) {
+		return 0;
+	}
+	plan->skip_mode = PREVIEW_SKIP_NON_IRAP;
+	best = probe->key_pictures;
+	if (speed != MC_PREVIEW_SPEED_KEYFRAMES) {
+		factor = 1U << speed;
+		decoded = probe->pictures - probe->non_ref_pictures;
+		if (pv_fast_enough(probe, decoded, factor) && (decoded > best)) {
+			plan->skip_mode = PREVIEW_SKIP_NON_REF;
+			best = decoded;
+		}
+		/* the highest temporal layers go first, each one halves a
+		 * dyadic hierarchy */
+		layers = probe->max_sub_layers;
+		for (i = 0; i < MC_PREVIEW_MAX_LAYERS; i++) {
+			if ((probe->layer_pictures[i] > 0) && (i >= layers)) {
+				layers = i + 1;
+			}
+		}
+		for (t = 0; (codec_id == MEDIA_CODEC_ID_H265) && (t + 1 < layers);
+			t++) {
+			for (decoded = 0, i = 0; i <= t; i++) {
+				decoded += probe->layer_pictures[i];
+			}
+			/* equal to skipping non-reference pictures it's still exact */
+			if (pv_fast_enough(probe, decoded, factor) && (decoded >= best)) {
+				plan->skip_mode = PREVIEW_SKIP_NONE;
+				plan->dec_temporal_id_mode = 0;
+				plan->target_dec_temporal_id_plus1 = t + 1;
+				best = decoded;
+			}
+		}
+	}
+	plan->decoded_permille = (hb_u32)(((hb_u64)best * 1000) /
+		probe->pictures);
+
+	return 0;
+}
+
+hb_s32 hb_mm_preview_apply(const mc_preview_plan_t *plan,
+		media_codec_context_t *context)
+{
+	mc_video_codec_dec_params_t *params;
+
+	if ((plan == NULL) || (context == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(plan=%p, context=%p).\n",
+			TAG, __FUNCTION__, __LINE__, plan, context);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (context->encoder) {
+		return HB_MEDIA_ERR_INVALID_INSTANCE;
+	}
+
+	params = &context->video_dec_params;
+	if (context->codec_id == MEDIA_CODEC_ID_H264) {
+		if (plan->target_dec_temporal_id_plus1 != 0) {
+			return HB_MEDIA_ERR_UNSUPPORTED_FEATURE;
+		}
+		params->h264_dec_config.skip_mode = plan->skip_mode;
+	} else if (context->codec_id == MEDIA_CODEC_ID_H265) {
+		params->h265_dec_config.skip_mode = plan->skip_mode;
+		params->h265_dec_config.dec_temporal_id_mode =
+			plan->dec_temporal_id_mode;
+		params->h265_dec_config.target_dec_temporal_id_plus1 =
+			plan->target_dec_temporal_id_plus1;
+	} else {
+		return HB_MEDIA_ERR_UNSUPPORTED_FEATURE;
+	}
+
+	return 0;
+}
@@ -0,0 +1,347 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hb_media_qpmap.h"
+#include "media_block.h"
+#include "media_common.h"
+
+#define TAG "[MEDIAQPMAP]"
+
+#define QPMAP_MAX_POOL_NUM 32
+#define QPMAP_MAX_QP 51
+
+struct _mc_qpmap_generator {
+	mc_qpmap_params_t params;
+	hb_s32 cells_x;
+	hb_s32 cells_y;
+	hb_u32 count;
+	hb_s32 blocks_x;
+	hb_s32 blocks_y;
+	/* Luma of the previous picture */
+	hb_u8 *prev;
+	hb_bool has_prev;
+	/* One block row of the kernels */
+	hb_u32 *sum;
+	hb_u32 *sqsum;
+	hb_u32 *sad;
+	/* Accumulated per map entry */
+	hb_u32 *cell_sum;
+	hb_u32 *cell_sqsum;
+	hb_u32 *cell_sad;
+	hb_u32 *cell_pixels;
+	hb_s32 *cell_log;
+	/* pool_num maps of count entries */
+	hb_u8 *pool;
+	hb_u32 next;
+	mc_qpmap_stats_t stats;
+};
+
+static hb_u64 qpmap_get_time_us(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+	return ((hb_u64)tp.tv_sec * 1000000) + ((hb_u64)tp.tv_nsec / 1000);
+}
+
+static hb_bool qpmap_size_valid(hb_u32 size)
+{
+	return (size == 16) || (size == 32) || (size == 64);
+}
+
+static hb_bool qpmap_geometry_valid(const mc_qpmap_params_t *params)
+{
+	return (params->width > 0) && (params->height > 0) &&
+		qpmap_size_valid(params->align) &&
+		qpmap_size_valid(params->block_size) &&
+		(params->block_size <= params->align);
+}
+
+static hb_bool qpmap_params_valid(const mc_qpmap_params_t *params)
+{
+	return (params->min_qp <= params->base_qp) &&
+		(params->base_qp <= params->max_qp) &&
+		(params->max_qp <= QPMAP_MAX_QP) && (params->aq_strength <= 64) &&
+		(params->static_threshold <= params->motion_threshold) &&
+		(params->static_qp_offset <= QPMAP_MAX_QP) &&
+		(params->motion_qp_offset <= QPMAP_MAX_QP);
+}
+
+/* log2(v) in 1/256, linear between powers of two */
+static hb_s32 qpmap_log2_q8(hb_u32 v)
+{
+	hb_s32 n;
+	hb_u32 frac;
+
+	if (v == 0) {
+		return 0;
+	}
+	n = 31 - __builtin_clz(v);
+	frac = (n >= 8) ? (v >> (n - 8)) : (v << (8 - n));
+	return (n * 256) + (hb_s32)(frac & 0xff);
+}
+
+hb_s32 hb_mm_qpmap_get_count(const mc_qpmap_params_t *params)
+{
+	hb_u32 w, h;
+
+	if ((params == NULL) || !qpmap_geometry_valid(params)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	w = ((hb_u32)params->width + params->align - 1) & ~(params->align - 1);
+	h = ((hb_u32)params->height + params->align - 1) & ~(params->align - 1);
+	if ((w / params->block_size) * (h / params->block_size) >
+		MC_VIDEO_MAX_MB_NUM) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	return (hb_s32)((w / params->block_size) * (h / params->block_size));
+}
+
+hb_s32 hb_mm_qpmap_create(const mc_qpmap_params_t *params,
+		mc_qpmap_generator_t **gen)
+{
+	mc_qpmap_generator_t *g;
+	hb_s32 count;
+
+	count = hb_mm_qpmap_get_count(params);
+	if ((count <= 0) || (gen == NULL) || !qpmap_params_valid(params) ||
+		(params->pool_num == 0) ||
+		(params->pool_num > QPMAP_MAX_POOL_NUM)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(params=%p).\n",
+			TAG, __FUNCTION__, __LINE__, params);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	g = (mc_qpmap_generator_t *)calloc(1, sizeof(*g));
+	if (g == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	g->params = *params;
+	g->count = (hb_u32)count;
+	g->cells_x = (hb_s32)((((hb_u32)params->width + params->align - 1) &
+		~(params->align - 1)) / params->block_size);
+	g->cells_y = count / g->cells_x;
+	g->blocks_x = (params->width + MEDIA_BLOCK_SIZE - 1) / MEDIA_BLOCK_SIZE;
+	g->blocks_y = (params->height + MEDIA_BLOCK_SIZE - 1) / MEDIA_BLOCK_SIZE;
+	g->prev = (hb_u8 *)malloc((size_t)params->width * params->height);
+	g->sum = (hb_u32 *)malloc(sizeof(hb_u32) * 3 * (size_t)g->blocks_x);
+	g->cell_sum = (hb_u32 *)malloc(sizeof(hb_u32) * 5 * (size_t)count);
+	g->pool = (hb_u8 *)malloc((size_t)params->pool_num * (size_t)count);
+	if ((g->prev == NULL) || (g->sum == NULL) || (g->cell_sum == NULL) ||
+		(g->pool == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Failed to allocate the map pool.\n",
+			TAG, __FUNCTION__, __LINE__);
+		hb_mm_qpmap_destroy(g);
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	g->sqsum = g->sum + g->blocks_x;
+	g->sad = g->sqsum + g->blocks_x;
+	g->cell_sqsum = g->cell_sum + count;
+	g->cell_sad = g->cell_sqsum + count;
+	g->cell_pixels = g->cell_sad + count;
+	g->cell_log = (hb_s32 *)(g->cell_pixels + count);
+
+	*gen = g;
+	return 0;
+}
+
+hb_s32 hb_mm_qpmap_set_params(mc_qpmap_generator_t *gen,
+		const mc_qpmap_params_t *params)
+{
+	if ((gen == NULL) || (params == NULL) || !qpmap_params_valid(params) ||
+		(params->width != gen->params.width) ||
+		(params->height != gen->params.height) ||
+		(params->align != gen->params.align) ||
+		(params->block_size != gen->params.block_size) ||
+		(params->pool_num != gen->params.pool_num)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(gen=%p, params=%p).\n",
+			TAG, __FUNCTION__, __LINE__, gen, params);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	gen->params = *params;
+
+	return 0;
+}
+
+/* Run the kernels over the picture and sum the 16x16 blocks per entry */
+static void qpmap_accumulate(mc_qpmap_generator_t *gen, const hb_u8 *luma,
+		hb_s32 stride)
+{
+	const mc_qpmap_params_t *p = &gen->params;
+	media_block_kernels_t k;
+	const hb_u8 *row;
+	hb_s32 bx, by, rows, cols, cell, shift;
+
+	memset(gen->cell_sum, 0x00, sizeof(hb_u32) * 4 * (size_t)gen->count);
+	media_block_get_kernels(&k);
+	shift = __builtin_ctz(p->block_size / MEDIA_BLOCK_SIZE);
+	for (by = 0; by < gen->blocks_y; by++) {
+		rows = p->height - (by * MEDIA_BLOCK_SIZE);
+		rows = (rows > MEDIA_BLOCK_SIZE) ? MEDIA_BLOCK_SIZE : rows;
+		row = luma + ((size_t)by * MEDIA_BLOCK_SIZE * stride);
+		k.var(row, stride, p->width, rows, gen->sum, gen->sqsum);
+		if (gen->has_prev) {
+			k.sad(row, stride, gen->prev + ((size_t)by * MEDIA_BLOCK_SIZE *
+				p->width), p->width, p->width, rows, gen->sad);
+		}
+		cell = (by >> shift) * gen->cells_x;
+		for (bx = 0; bx < gen->blocks_x; bx++) {
+			cols = p->width - (bx * MEDIA_BLOCK_SIZE);
+			cols = (cols > MEDIA_BLOCK_SIZE) ? MEDIA_BLOCK_SIZE : cols;
+			gen->cell_sum[cell + (bx >> shift)] += gen->sum[bx];
+			gen->cell_sqsum[cell + (bx >> shift)] += gen->sqsum[bx];
+			gen->cell_pixels[cell + (bx >> shift)] += (hb_u32)(rows * cols);
+			if (gen->has_prev) {
+				gen->cell_sad[cell + (bx >> shift)] += gen->sad[bx];
+			}
+		}
+	}
+}
+
+static void qpmap_build(mc_qpmap_generator_t *gen, hb_u8 *map)
+{
+	const mc_qpmap_params_t *p = &gen->params;
+	hb_u32 i, n, cells = 0, static_blocks = 0, moving_blocks = 0, mad;
+	hb_u64 var;
+	hb_s64 log_sum = 0, delta, qp_sum = 0;
+	hb_s32 log_avg = 0, qp;
+
+	for (i = 0; i < gen->count; i++) {
+		n = gen->cell_pixels[i];
+		if (n == 0) {
+			continue;
+		}
+		var = (((hb_u64)gen->cell_sqsum[i] * n) -
+			((hb_u64)gen->cell_sum[i] * gen->cell_sum[i])) / ((hb_u64)n * n);
+		gen->cell_log[i] = qpmap_log2_q8((hb_u32)var + 1);
+		log_sum += gen->cell_log[i];
+		cells++;
+	}
+	if (cells > 0) {
+		log_avg = (hb_s32)(log_sum / cells);
+	}
+
+	for (i = 0; i < gen->count; i++) {
+		n = gen->cell_pixels[i];
+		qp = (hb_s32)p->base_qp;
+		if (n > 0) {
+			/* strength is 1/8 QP and the log 1/256, round to a whole QP */
+			delta = (hb_s64)p->aq_strength * (gen->cell_log[i] - log_avg);
+			qp += (hb_s32)((delta >= 0) ? ((delta + 1024) / 2048) :
+				-((-delta + 1024) / 2048));
+			if (gen->has_prev) {
+				mad = (hb_u32)(((hb_u64)gen->cell_sad[i] * 16) / n);
+				if (mad < p->static_threshold) {
+					qp += (hb_s32)p->static_qp_offset;
+					static_blocks++;
+				} else if (mad > p->motion_threshold) {
+					qp -= (hb_s32)p->motion_qp_offset;
+					moving_blocks++;
+				}
+			}
+		}
+		qp = (qp < (hb_s32)p->min_qp) ? (hb_s32)p->min_qp : qp;
+		qp = (qp > (hb_s32)p->max_qp) ? (hb_s32)p->max_qp : qp;
+		map[i] = (hb_u8)qp;
+		qp_sum += qp;
+	}
+
+	gen->stats.last_static_blocks = static_blocks;
+	gen->stats.last_moving_blocks = moving_blocks;
+	gen->stats.last_avg_qp = (hb_u32)((qp_sum * 100) / gen->count);
+}
+
+hb_s32 hb_mm_qpmap_generate(mc_qpmap_generator_t *gen,
+		const hb_u8 *luma, hb_s32 stride, hb_byte *map, hb_u32 *count)
+{
+	const mc_qpmap_params_t *p;
+	hb_u8 *out;
+	hb_u64 start, cost;
+	hb_s32 y;
+
+	if ((gen == NULL) || (luma == NULL) || (map == NULL) ||
+		(count == NULL) || (stride < gen->params.width)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(gen=%p, luma=%p).\n",
+			TAG, __FUNCTION__, __LINE__, gen, luma);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	p = &gen->params;
+
+	start = qpmap_get_time_us();
+	out = gen->pool + ((size_t)gen->next * gen->count);
+	gen->next = (gen->next + 1) % p->pool_num;
+	qpmap_accumulate(gen, luma, stride);
+	qpmap_build(gen, out);
+	for (y = 0; y < p->height; y++) {
+		memcpy(gen->prev + ((size_t)y * p->width),
+			luma + ((size_t)y * stride), (size_t)p->width);
+	}
+	gen->has_prev = TRUE;
+	cost = qpmap_get_time_us() - start;
+	gen->stats.frames++;
+	gen->stats.cost_us += cost;
+	if (cost > gen->stats.max_cost_us) {
+		gen->stats.max_cost_us = cost;
+	}
+
+	*map = out;
+	*count = gen->count;
+	return 0;
+}
+
+hb_s32 hb_mm_qpmap_apply(mc_qpmap_generator_t *gen,
+		media_codec_buffer_t *buffer)
+{
+	mc_video_frame_buffer_info_t *frame;
+	hb_byte map = NULL;
+	hb_u32 count = 0;
+	hb_s32 ret;
+
+	if ((gen == NULL) || (buffer == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(gen=%p, buffer=%p).\n",
+			TAG, __FUNCTION__, __LINE__, gen, buffer);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	frame = &buffer->vframe_buf;
+	if (frame->frame_end) {
+		return 0;
+	}
+
+	ret = hb_mm_qpmap_generate(gen, frame->vir_ptr[0],
+		(frame->stride > 0) ? frame->stride : gen->params.width,
+		&map, &count);
+	if (ret == 0) {
+		frame->qp_map_valid = TRUE;
+		frame->qp_map_array = map;
+		frame->qp_map_array_count = count;
+	}
+
+	return ret;
+}
+
+hb_s32 hb_mm_qpmap_get_stats(mc_qpmap_generator_t *gen,
+		mc_qpmap_stats_t *stats)
+{
+	if ((gen == NULL) || (stats == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	*stats = gen->stats;
+
+	return 0;
+}
+
+hb_s32 hb_mm_qpmap_destroy(mc_qpmap_generator_t *gen)
+{
+	if (gen == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	free(gen->prev);
+	free(gen->sum);
+	free(gen->cell_sum);
+	free(gen->pool);
+	free(gen);
+
+	return 0;
+}
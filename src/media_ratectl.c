@@ -0,0 +1,284 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "hb_media_ratectl.h"
+#include "media_common.h"
+
+#define TAG "[MEDIARATECTL]"
+
+struct _mc_ratectl {
+	media_codec_context_t *context;
+	mc_ratectl_params_t params;
+	/* Last configuration sent, bit_rate points into it */
+	mc_rate_control_params_t rc_params;
+	hb_u32 *bit_rate;
+	/* Picture sizes of the sliding window */
+	hb_u32 window[MC_RATECTL_MAX_WINDOW];
+	hb_u32 window_len;
+	hb_u32 window_pos;
+	hb_u32 window_num;
+	hb_u64 window_bytes;
+	/* The GOP being accounted */
+	hb_u32 gop_num;
+	hb_u64 gop_bytes;
+	hb_u64 gop_qp;
+	hb_u64 gop_intra;
+	hb_u64 gop_skip;
+	hb_u32 blocks8;
+	hb_u32 blocks16;
+	mc_ratectl_stats_t stats;
+};
+
+static hb_u32 *ratectl_bit_rate(mc_rate_control_params_t *rc_params)
+{
+	switch (rc_params->mode) {
+	case MC_AV_RC_MODE_H264CBR:
+		return &rc_params->h264_cbr_params.bit_rate;
+	case MC_AV_RC_MODE_H264AVBR:
+		return &rc_params->h264_avbr_params.bit_rate;
+	case MC_AV_RC_MODE_H265CBR:
+		return &rc_params->h265_cbr_params.bit_rate;
+	case MC_AV_RC_MODE_H265AVBR:
+		return &rc_params->h265_avbr_params.bit_rate;
+	default:
+		return NULL;
+	}
+}
+
+static hb_bool ratectl_params_valid(const mc_ratectl_params_t *params)
+{
+	return (params->ceiling_bit_rate > 0) &&
+		(params->min_bit_rate <= params->target_bit_rate) &&
+		(params->target_bit_rate <= params->ceiling_bit_rate) &&
+		(params->headroom_permille <= 500) &&
+		(params->max_step_permille > 0) &&
+		(params->max_step_permille <= 1000) &&
+		(params->static_skip_permille <= 1000);
+}
+
+/* kbps of bytes spread over num pictures */
+static hb_u32 ratectl_kbps(const mc_ratectl_t *rc, hb_u64 bytes, hb_u32 num)
+{
+	if (num == 0) {
+		return 0;
+	}
+	return (hb_u32)((bytes * 8 * rc->params.frame_rate) /
+		((hb_u64)num * 1000));
+}
+
+hb_s32 hb_mm_ratectl_create(media_codec_context_t *context,
+		const mc_ratectl_params_t *params, mc_ratectl_t **rc)
+{
+	mc_video_codec_enc_params_t *enc;
+	mc_ratectl_t *r;
+	hb_s32 ret;
+
+	if ((context == NULL) || (params == NULL) || (rc == NULL) ||
+		(params->frame_rate == 0) || (params->frame_rate > 240) ||
+		(params->window_ms == 0) || !ratectl_params_valid(params) ||
+		(((hb_u64)params->window_ms * params->frame_rate) >
+		((hb_u64)MC_RATECTL_MAX_WINDOW * 1000))) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(context=%p, params=%p).\n",
+			TAG, __FUNCTION__, __LINE__, context, params);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (!context->encoder) {
+		VLOG(ERR, "%s <%s:%d> The instance isn't an encoder.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_INSTANCE;
+	}
+
+	r = (mc_ratectl_t *)calloc(1, sizeof(*r));
+	if (r == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	r->context = context;
+	r->params = *params;
+	ret = hb_mm_mc_get_rate_control_config(context, &r->rc_params);
+	if (ret < 0) {
+		VLOG(ERR, "%s <%s:%d> Failed to get rate control config(%d).\n",
+			TAG, __FUNCTION__, __LINE__, ret);
+		free(r);
+		return ret;
+	}
+	r->bit_rate = ratectl_bit_rate(&r->rc_params);
+	if (r->bit_rate == NULL) {
+		VLOG(ERR, "%s <%s:%d> Unsupported rate control mode %d.\n",
+			TAG, __FUNCTION__, __LINE__, r->rc_params.mode);
+		free(r);
+		return HB_MEDIA_ERR_UNSUPPORTED_FEATURE;
+	}
+	if (r->rc_params.mode == MC_AV_RC_MODE_H265AVBR) {
+		/* only some chips have it, the window still holds without */
+		ret = hb_mm_mc_set_max_bit_rate_config(context,
+			params->ceiling_bit_rate);
+		if (ret < 0) {
+			VLOG(WARN, "%s <%s:%d> Failed to set max bit rate(%d).\n",
+				TAG, __FUNCTION__, __LINE__, ret);
+		}
+	}
+	enc = &context->video_enc_params;
+	r->window_len = (hb_u32)(((hb_u64)params->window_ms * params->frame_rate +
+		999) / 1000);
+	r->blocks8 = (hb_u32)(((enc->width + 7) / 8) * ((enc->height + 7) / 8));
+	r->blocks16 = (hb_u32)(((enc->width + 15) / 16) *
+		((enc->height + 15) / 16));
+	r->stats.bit_rate = *r->bit_rate;
+
+	*rc = r;
+	return 0;
+}
+
+hb_s32 hb_mm_ratectl_set_params(mc_ratectl_t *rc,
+		const mc_ratectl_params_t *params)
+{
+	if ((rc == NULL) || (params == NULL) || !ratectl_params_valid(params) ||
+		(params->frame_rate != rc->params.frame_rate) ||
+		(params->window_ms != rc->params.window_ms)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(rc=%p, params=%p).\n",
+			TAG, __FUNCTION__, __LINE__, rc, params);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	rc->params = *params;
+
+	return 0;
+}
+
+/*
+ * Steer the window rate to the ceiling minus the headroom. Above it the
+ * bitrate drops in proportion, below it rises back to the target unless
+ * the last GOP was mostly skipped.
+ */
+static void ratectl_adjust(mc_ratectl_t *rc)
+{
+	const mc_ratectl_params_t *p = &rc->params;
+	mc_ratectl_stats_t *stats = &rc->stats;
+	hb_u32 cur, limit, window, step;
+	hb_u64 want;
+	hb_s32 ret;
+
+	stats->gops++;
+	stats->last_gop_bit_rate = ratectl_kbps(rc, rc->gop_bytes, rc->gop_num);
+	stats->last_gop_avg_qp = (hb_u32)(rc->gop_qp / rc->gop_num);
+	stats->last_gop_intra_permille = (rc->blocks16 == 0) ? 0 :
+		(hb_u32)((rc->gop_intra * 1000) / ((hb_u64)rc->gop_num * rc->blocks16));
+	stats->last_gop_skip_permille = (rc->blocks8 == 0) ? 0 :
+		(hb_u32)((rc->gop_skip * 1000) / ((hb_u64)rc->gop_num * rc->blocks8));
+
+	cur = *rc->bit_rate;
+	limit = (hb_u32)(((hb_u64)p->ceiling_bit_rate *
+		(1000 - p->headroom_permille)) / 1000);
+	window = stats->window_bit_rate;
+	if (window > limit) {
+		want = ((hb_u64)cur * limit) / window;
+	} else if ((p->static_skip_permille > 0) &&
+		(stats->last_gop_skip_permille > p->static_skip_permille)) {
+		want = cur;
+	} else {
+		want = (window == 0) ? p->target_bit_rate :
+			((hb_u64)cur * limit) / window;
+	}
+	want = (want > p->target_bit_rate) ? p->target_bit_rate : want;
+	step = (hb_u32)(((hb_u64)cur * p->max_step_permille) / 1000);
+	step = (step == 0) ? 1 : step;
+	if (want + step < cur) {
+		want = cur - step;
+	} else if (want > (hb_u64)cur + step) {
+		want = (hb_u64)cur + step;
+	}
+	want = (want < p->min_bit_rate) ? p->min_bit_rate : want;
+	if (want == cur) {
+		return;
+	}
+
+	*rc->bit_rate = (hb_u32)want;
+	ret = hb_mm_mc_set_rate_control_config(rc->context, &rc->rc_params);
+	if (ret < 0) {
+		VLOG(ERR, "%s <%s:%d> Failed to set bit rate %u(%d).\n",
+			TAG, __FUNCTION__, __LINE__, (hb_u32)want, ret);
+		*rc->bit_rate = cur;
+		stats->set_failures++;
+		return;
+	}
+	if (want < cur) {
+		stats->decreases++;
+	} else {
+		stats->increases++;
+	}
+	stats->bit_rate = (hb_u32)want;
+}
+
+hb_s32 hb_mm_ratectl_update(mc_ratectl_t *rc,
+		const media_codec_output_buffer_info_t *info)
+{
+	const mc_h264_h265_output_stream_info_t *s;
+	hb_bool intra;
+
+	if ((rc == NULL) || (info == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(rc=%p, info=%p).\n",
+			TAG, __FUNCTION__, __LINE__, rc, info);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	s = &info->video_stream_info;
+
+	/* the reported type is I for IDR too, accept both */
+	intra = (s->nalu_type == MC_H264_NALU_TYPE_I) ||
+		(s->nalu_type == MC_H264_NALU_TYPE_IDR) ||
+		(s->nalu_type == MC_H265_NALU_TYPE_IDR);
+	if ((rc->gop_num > 0) && (intra || ((rc->params.gop_frames > 0) &&
+		(rc->gop_num >= rc->params.gop_frames)))) {
+		ratectl_adjust(rc);
+		rc->gop_num = 0;
+		rc->gop_bytes = 0;
+		rc->gop_qp = 0;
+		rc->gop_intra = 0;
+		rc->gop_skip = 0;
+	}
+
+	if (rc->window_num == rc->window_len) {
+		rc->window_bytes -= rc->window[rc->window_pos];
+	} else {
+		rc->window_num++;
+	}
+	rc->window[rc->window_pos] = s->enc_pic_byte;
+	rc->window_bytes += s->enc_pic_byte;
+	rc->window_pos = (rc->window_pos + 1) % rc->window_len;
+
+	rc->gop_num++;
+	rc->gop_bytes += s->enc_pic_byte;
+	rc->gop_qp += s->avg_mb_qp;
+	rc->gop_intra += s->intra_block_num;
+	rc->gop_skip += s->skip_block_num;
+
+	rc->stats.frames++;
+	rc->stats.window_bit_rate = ratectl_kbps(rc, rc->window_bytes,
+		rc->window_num);
+	if (rc->stats.window_bit_rate > rc->stats.max_window_bit_rate) {
+		rc->stats.max_window_bit_rate = rc->stats.window_bit_rate;
+	}
+	if (rc->stats.window_bit_rate > rc->params.ceiling_bit_rate) {
+		rc->stats.overflows++;
+	}
+
+	return 0;
+}
+
+hb_s32 hb_mm_ratectl_get_stats(mc_ratectl_t *rc, mc_ratectl_stats_t *stats)
+{
+	if ((rc == NULL) || (stats == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	*stats = rc->stats;
+
+	return 0;
+}
+
+hb_s32 hb_mm_ratectl_destroy(mc_ratectl_t *rc)
+{
+	if (rc == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	free(rc);
+
+	return 0;
+}
@@ -0,0 +1,391 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "hb_media_nal.h"
+#include "hb_media_ringbuf.h"
+#include "media_common.h"
+
+#define TAG "[MEDIARINGBUF]"
+#define RB_PATH_MAX 512
+#define RB_HEADER_MAX 1024
+#define RB_IOV_NUM 4
+
+typedef struct _rb_frame {
+	hb_u32 offset;
+	hb_u32 size;
+	hb_u64 pts;
+	hb_bool is_idr;
+} rb_frame_t;
+
+struct _mr_ringbuf {
+	mr_ringbuf_params_t params;
+	hb_u8 *arena;
+	rb_frame_t *frames;
+	hb_u32 fhead;
+	hb_u32 fcount;
+	hb_u32 head;
+	hb_u32 bytes;
+	hb_bool waiting_idr;
+
+	/* the latest parameter sets, prepended when a clip lacks them */
+	hb_u8 header[RB_HEADER_MAX];
+	hb_u32 header_size;
+
+	hb_bool clip_pending;
+	hb_u64 clip_end_pts;
+	char clip_path[RB_PATH_MAX];
+
+	mr_ringbuf_stats_t stats;
+};
+
+static rb_frame_t *rb_frame_at(mr_ringbuf_t *rb, hb_u32 i)
+{
+	return &rb->frames[(rb->fhead + i) % rb->params.max_frames];
+}
+
+static hb_bool rb_alloc(mr_ringbuf_t *rb, hb_u32 size, hb_u32 *offset)
+{
+	hb_u32 tail;
+
+	if (rb->fcount == 0U) {
+		rb->head = 0U;
+		*offset = 0U;
+		return size <= rb->params.arena_size;
+	}
+	if (rb->fcount == rb->params.max_frames) {
+		return FALSE;
+	}
+
+	tail = rb_frame_at(rb, 0U)->offset;
+	if (rb->head > tail) {
+		if ((rb->params.arena_size - rb->head) >= size) {
+			*offset = rb->head;
+			return TRUE;
+		}
+		if (tail >= size) {
+			*offset = 0U;
+			return TRUE;
+		}
+		return FALSE;
+	}
+	if ((tail - rb->head) >= size) {
+		*offset = rb->head;
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+static void rb_evict_gop(mr_ringbuf_t *rb)
+{
+	rb_frame_t *frame;
+
+	do {
+		frame = rb_frame_at(rb, 0U);
+		rb->bytes -= frame->size;
+		rb->fhead = (rb->fhead + 1U) % rb->params.max_frames;
+		rb->fcount--;
+	} while ((rb->fcount > 0U) && !rb_frame_at(rb, 0U)->is_idr);
+	rb->stats.gops_evicted++;
+}
+
+static void rb_evict_by_time(mr_ringbuf_t *rb)
+{
+	hb_u64 newest;
+	hb_u32 i;
+
+	if (rb->fcount == 0U) {
+		return;
+	}
+	newest = rb_frame_at(rb, rb->fcount - 1U)->pts;
+	for (i = 1U; i < rb->fcount; i++) {
+		if (!rb_frame_at(rb, i)->is_idr) {
+			continue;
+		}
+		/* drop the oldest GOP only if the rest still covers pre-roll */
+		if ((newest - rb_frame_at(rb, i)->pts) < rb->params.pre_roll_ms) {
+			break;
+		}
+		rb_evict_gop(rb);
+		i = 0U;
+	}
+}
+
+static void rb_cache_header(mr_ringbuf_t *rb, const hb_u8 *data, hb_u32 size)
+{
+	media_codec_id_t codec_id = rb->params.codec_id;
+	mc_nal_unit_t nal;
+	hb_u32 pos = 0U, total = 0U;
+
+	while (hb_mm_nal_next(codec_id, data, size, &pos, &nal) > 0) {
+		if (!hb_mm_nal_is_param_set(codec_id, nal.type)) {
+			if (total > 0U) {
+				break;
+			}
+			continue;
+		}
+		if ((total + nal.size) > RB_HEADER_MAX) {
+			VLOG(WARN, "%s <%s:%d> Parameter sets too large(%u).\n",
+				TAG, __FUNCTION__, __LINE__, total + nal.size);
+			return;
+		}
+		memcpy(rb->header + total, data + nal.offset, nal.size);
+		total += nal.size;
+	}
+	if (total > 0U) {
+		rb->header_size = total;
+	}
+}
+
+static hb_bool rb_has_header(mr_ringbuf_t *rb, const rb_frame_t *frame)
+{
+	mc_nal_unit_t nal;
+	hb_u32 pos = 0U;
+
+	if (hb_mm_nal_next(rb->params.codec_id, rb->arena + frame->offset,
+		frame->size, &pos, &nal) <= 0) {
+		return FALSE;
+	}
+	return hb_mm_nal_is_param_set(rb->params.codec_id, nal.type);
+}
+
+static hb_s32 rb_write_clip(mr_ringbuf_t *rb)
+{
+	struct iovec iov[RB_IOV_NUM];
+	rb_frame_t *frame;
+	hb_u64 total = 0U, done = 0U;
+	hb_s32 iovcnt = 0, fd, i;
+	ssize_t n;
+
+	rb->clip_pending = FALSE;
+	if (rb->fcount == 0U) {
+		return 0;
+	}
+
+	if ((rb->header_size > 0U) && !rb_has_header(rb, rb_frame_at(rb, 0U))) {
+		iov[iovcnt].iov_base = rb->header;
+		iov[iovcnt].iov_len = rb->header_size;
+		iovcnt++;
+	}
+	/* the arena wraps at most once, so there are at most two runs */
+	for (i = 0; i < (hb_s32)rb->fcount; i++) {
+		frame = rb_frame_at(rb, (hb_u32)i);
+		if ((i > 0) && ((hb_u8 *)iov[iovcnt - 1].iov_base +
+			iov[iovcnt - 1].iov_len == rb->arena + frame->offset)) {
+			iov[iovcnt - 1].iov_len += frame->size;
+			continue;
+		}
+		if (iovcnt == RB_IOV_NUM) {
+			return HB_MEDIA_ERR_UNKNOWN;
+		}
+		iov[iovcnt].iov_base = rb->arena + frame->offset;
+		iov[iovcnt].iov_len = frame->size;
+		iovcnt++;
+	}
+	for (i = 0; i < iovcnt; i++) {
+		total += iov[i].iov_len;
+	}
+
+	fd = open(rb->clip_path, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to open clip %s.(%s)\n",
+			TAG, __FUNCTION__, __LINE__, rb->clip_path, strerror(errno));
+		return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+	}
+	i = 0;
+	while (done < total) {
+		n = writev(fd, &iov[i], iovcnt - i);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			VLOG(ERR, "%s <%s:%d> Fail to write clip %s.(%s)\n",
+				TAG, __FUNCTION__, __LINE__, rb->clip_path, strerror(errno));
+			close(fd);
+			return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+		}
+		done += (hb_u64)n;
+		/* short write, skip what's done and retry */
+		while ((i < iovcnt) && ((size_t)n >= iov[i].iov_len)) {
+			n -= (ssize_t)iov[i].iov_len;
+			i++;
+		}
+		if (i < iovcnt) {
+			iov[i].iov_base = (hb_u8 *)iov[i].iov_base + n;
+			iov[i].iov_len -= (size_t)n;
+		}
+	}
+	close(fd);
+
+	rb->stats.clips_written++;
+	rb->stats.last_clip_bytes = total;
+
+	return 0;
+}
+
+hb_s32 hb_mm_rb_create(const mr_ringbuf_params_t *params, mr_ringbuf_t **rb)
+{
+	mr_ringbuf_t *r;
+
+	if ((params == NULL) || (rb == NULL) || (params->arena_size == 0U) ||
+		(params->max_frames == 0U) ||
+		((params->codec_id != MEDIA_CODEC_ID_H264) &&
+		(params->codec_id != MEDIA_CODEC_ID_H265))) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(params=%p, rb=%p).\n",
+			TAG, __FUNCTION__, __LINE__, params, rb);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	r = (mr_ringbuf_t *)calloc(1, sizeof(*r));
+	if (r == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	r->params = *params;
+	r->arena = (hb_u8 *)malloc(params->arena_size);
+	r->frames = (rb_frame_t *)calloc(params->max_frames, sizeof(rb_frame_t));
+	if ((r->arena == NULL) || (r->frames == NULL)) {
+		free(r->arena);
+		free(r->frames);
+		free(r);
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+
+	*rb = r;
+	return 0;
+}
+
+hb_s32 hb_mm_rb_push(mr_ringbuf_t *rb, const hb_u8 *data,
+		hb_u32 size, hb_u64 pts, hb_bool is_idr)
+{
+	rb_frame_t *frame;
+	hb_u32 offset = 0U;
+	hb_s32 ret;
+
+	if ((rb == NULL) || (data == NULL) || (size == 0U)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(rb=%p, data=%p, size=%u).\n",
+			TAG, __FUNCTION__, __LINE__, rb, data, size);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (size > rb->params.arena_size) {
+		VLOG(ERR, "%s <%s:%d> Access unit(%u) is larger than the arena(%u).\n",
+			TAG, __FUNCTION__, __LINE__, size, rb->params.arena_size);
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+
+	if (is_idr) {
+		rb_cache_header(rb, data, size);
+		rb->waiting_idr = FALSE;
+	} else if (rb->waiting_idr || (rb->fcount == 0U)) {
+		/* the held data must always start with an IDR */
+		rb->stats.frames_dropped++;
+		return 0;
+	}
+
+	while (!rb_alloc(rb, size, &offset)) {
+		if (rb->clip_pending) {
+			rb->stats.clips_truncated++;
+			ret = rb_write_clip(rb);
+			if (ret != 0) {
+				return ret;
+			}
+		}
+		rb_evict_gop(rb);
+		if ((rb->fcount == 0U) && !is_idr) {
+			rb->waiting_idr = TRUE;
+			rb->stats.frames_dropped++;
+			return 0;
+		}
+	}
+
+	memcpy(rb->arena + offset, data, size);
+	frame = rb_frame_at(rb, rb->fcount);
+	frame->offset = offset;
+	frame->size = size;
+	frame->pts = pts;
+	frame->is_idr = is_idr;
+	rb->fcount++;
+	rb->head = offset + size;
+	rb->bytes += size;
+
+	if (rb->clip_pending) {
+		if (pts >= rb->clip_end_pts) {
+			return rb_write_clip(rb);
+		}
+	} else {
+		rb_evict_by_time(rb);
+	}
+
+	return 0;
+}
+
+hb_s32 hb_mm_rb_trigger(mr_ringbuf_t *rb, const char *file_name)
+{
+	hb_u64 newest = 0U;
+
+	if ((rb == NULL) || (file_name == NULL) ||
+		(strlen(file_name) >= RB_PATH_MAX)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(rb=%p, file=%p).\n",
+			TAG, __FUNCTION__, __LINE__, rb, file_name);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (rb->clip_pending) {
+		VLOG(ERR, "%s <%s:%d> A clip is already pending(%s).\n",
+			TAG, __FUNCTION__, __LINE__, rb->clip_path);
+		return HB_MEDIA_ERR_OPERATION_NOT_ALLOWED;
+	}
+
+	strncpy(rb->clip_path, file_name, RB_PATH_MAX - 1);
+	rb->clip_path[RB_PATH_MAX - 1] = '\0';
+	if (rb->fcount > 0U) {
+		newest = rb_frame_at(rb, rb->fcount - 1U)->pts;
+	}
+	rb->clip_end_pts = newest + rb->params.post_roll_ms;
+	rb->clip_pending = TRUE;
+
+	if (rb->params.post_roll_ms == 0U) {
+		return rb_write_clip(rb);
+	}
+	return 0;
+}
+
+hb_s32 hb_mm_rb_flush(mr_ringbuf_t *rb)
+{
+	if (rb == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (!rb->clip_pending) {
+		return 0;
+	}
+	return rb_write_clip(rb);
+}
+
+hb_s32 hb_mm_rb_get_stats(mr_ringbuf_t *rb, mr_ringbuf_stats_t *stats)
+{
+	if ((rb == NULL) || (stats == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	rb->stats.frames = rb->fcount;
+	rb->stats.bytes = rb->bytes;
+	rb->stats.duration_ms = 0U;
+	if (rb->fcount > 0U) {
+		rb->stats.duration_ms = rb_frame_at(rb, rb->fcount - 1U)->pts -
+			rb_frame_at(rb, 0U)->pts;
+	}
+	*stats = rb->stats;
+	return 0;
+}
+
+hb_s32 hb_mm_rb_destroy(mr_ringbuf_t *rb)
+{
+	if (rb == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	free(rb->frames);
+	free(rb->arena);
+	free(rb);
+	return 0;
+}
@@ -0,0 +1,837 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "hb_media_scaler.h"
+#include "media_common.h"
+#include "media_pixfmt.h"
+#include "media_simd.h"
+
+#define TAG "[MEDIASCALER]"
+
+/* Largest integer ratio handled by the area filter, keeps sums in 16 bit */
+#define SC_AREA_MAX_RATIO 8
+
+typedef void (*sc_vblend_fn)(hb_u8 *dst, const hb_u8 *a, const hb_u8 *b,
+		hb_s32 f, hb_s32 n);
+typedef void (*sc_vsum_fn)(hb_u16 *acc, const hb_u8 *src, hb_s32 n,
+		hb_bool first);
+typedef void (*sc_half_fn)(hb_u8 *dst, const hb_u8 *a, const hb_u8 *b,
+		hb_s32 n);
+typedef void (*sc_hblend_fn)(hb_u8 *dst, const hb_u16 *pairs,
+		const hb_u8 *frac, hb_s32 n);
+
+typedef struct _sc_kernels {
+	sc_vblend_fn vblend;
+	sc_vsum_fn vsum;
+	sc_half_fn half;
+	sc_half_fn half2;
+	sc_hblend_fn hblend;
+} sc_kernels_t;
+
+/* Source positions of one destination axis, weights are 8 bit */
+typedef struct _sc_axis {
+	hb_s32 *idx0;
+	hb_s32 *idx1;
+	hb_u8 *frac;
+	/* frac with every entry twice, for interleaved chroma */
+	hb_u8 *frac2;
+	/* Leading entries with idx1 == idx0 + 1 */
+	hb_s32 pairs;
+} sc_axis_t;
+
+typedef struct _sc_plane {
+	hb_s32 src_w;
+	hb_s32 src_h;
+	hb_s32 dst_w;
+	hb_s32 dst_h;
+	sc_axis_t x;
+	sc_axis_t y;
+} sc_plane_t;
+
+struct _mc_scaler {
+	mc_scale_filter_t filter;
+	/* Integer ratios when the area filter applies, 0 otherwise */
+	hb_s32 area_x;
+	hb_s32 area_y;
+	sc_plane_t luma;
+	sc_plane_t chroma;
+	/* One blended source row, interleaved chroma is 2 * chroma width */
+	hb_u8 *row;
+	hb_u16 *acc;
+	/* Neighbour pairs of one destination row, low byte is the left one */
+	hb_u16 *pairs;
+	/*
+	 * Scaled picture in the source format when the formats differ, the
+	 * destination size is fixed so it's allocated up front
+	 */
+	hb_u8 *tmp;
+};
+
+/*
+ * a * (256 - f) + b * f fits in 16 bit for f in [1,255], which keeps
+ * every kernel bit exact with the C one.
+ */
+static void sc_vblend_c(hb_u8 *dst, const hb_u8 *a, const hb_u8 *b, hb_s32 f,
+		hb_s32 n)
+{
+	hb_s32 i;
+
+	for (i = 0; i < n; i++) {
+		dst[i] = (hb_u8)(((a[i] * (256 - f)) + (b[i] * f) + 128) >> 8);
+	}
+}
+
+static void sc_vsum_c(hb_u16 *acc, const hb_u8 *src, hb_s32 n, hb_bool first)
+{
+	hb_s32 i;
+
+	if (first) {
+		for (i = 0; i < n; i++) {
+			acc[i] = src[i];
+		}
+		return;
+	}
+	for (i = 0; i < n; i++) {
+		acc[i] = (hb_u16)(acc[i] + src[i]);
+	}
+}
+
+/* 2x2 box of one channel, rounded average of the vertical averages */
+static void sc_half_c(hb_u8 *dst, const hb_u8 *a, const hb_u8 *b, hb_s32 n)
+{
+	hb_s32 i, l, r;
+
+	for (i = 0; i < n; i++) {
+		l = (a[2 * i] + b[2 * i] + 1) >> 1;
+		r = (a[(2 * i) + 1] + b[(2 * i) + 1] + 1) >> 1;
+		dst[i] = (hb_u8)((l + r + 1) >> 1);
+	}
+}
+
+/* 2x2 box of interleaved chroma, n is the number of pairs */
+static void sc_half2_c(hb_u8 *dst, const hb_u8 *a, const hb_u8 *b, hb_s32 n)
+{
+	hb_s32 i, c, l, r;
+
+	for (i = 0; i < n; i++) {
+		for (c = 0; c < 2; c++) {
+			l = (a[(4 * i) + c] + b[(4 * i) + c] + 1) >> 1;
+			r = (a[(4 * i) + c + 2] + b[(4 * i) + c + 2] + 1) >> 1;
+			dst[(2 * i) + c] = (hb_u8)((l + r + 1) >> 1);
+		}
+	}
+}
+
+/* lo * (256 - f) + hi * f is written as lo * 256 + (hi - lo) * f for NEON */
+static void sc_hblend_c(hb_u8 *dst, const hb_u16 *pairs, const hb_u8 *frac,
+		hb_s32 n)
+{
+	hb_s32 i;
+
+	for (i = 0; i < n; i++) {
+		dst[i] = (hb_u8)((((pairs[i] & 0xFF) * (256 - frac[i])) +
+			((pairs[i] >> 8) * frac[i]) + 128) >> 8);
+	}
+}
+
+#if defined(MEDIA_SIMD_X86)
+static void sc_vblend_sse2(hb_u8 *dst, const hb_u8 *a, const hb_u8 *b,
+		hb_s32 f, hb_s32 n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i wa = _mm_set1_epi16((short)(256 - f));
+	const __m128i wb = _mm_set1_epi16((short)f);
+	const __m128i rnd = _mm_set1_epi16(128);
+	__m128i va, vb, lo, hi;
+	hb_s32 i;
+
+	for (i = 0; (i + 16) <= n; i += 16) {
+		va = _mm_loadu_si128((const __m128i *)(a + i));
+		vb = _mm_loadu_si128((const __m128i *)(b + i));
+		lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+			_mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb));
+		hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+			_mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb));
+		lo = _mm_srli_epi16(_mm_add_epi16(lo, rnd), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(hi, rnd), 8);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+	}
+	sc_vblend_c(dst + i, a + i, b + i, f, n - i);
+}
+
+static void sc_vsum_sse2(hb_u16 *acc, const hb_u8 *src, hb_s32 n,
+		hb_bool first)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i v, lo, hi;
+	hb_s32 i;
+
+	for (i = 0; (i + 16) <= n; i += 16) {
+		v = _mm_loadu_si128((const __m128i *)(src + i));
+		lo = _mm_unpacklo_epi8(v, zero);
+		hi = _mm_unpackhi_epi8(v, zero);
+		if (!first) {
+			lo = _mm_add_epi16(lo,
+				_mm_loadu_si128((const __m128i *)(acc + i)));
+			hi = _mm_add_epi16(hi,
+				_mm_loadu_si128((const __m128i *)(acc + i + 8)));
+		}
+		_mm_storeu_si128((__m128i *)(acc + i), lo);
+		_mm_storeu_si128((__m128i *)(acc + i + 8), hi);
+	}
+	sc_vsum_c(acc + i, src + i, n - i, first);
+}
+
+static void sc_half_sse2(hb_u8 *dst, const hb_u8 *a, const hb_u8 *b, hb_s32 n)
+{
+	const __m128i mask = _mm_set1_epi16(0x00FF);
+	const __m128i one = _mm_set1_epi16(1);
+	__m128i v0, v1;
+	hb_s32 i;
+
+	for (i = 0; (i + 16) <= n; i += 16) {
+		v0 = _mm_avg_epu8(_mm_loadu_si128((const __m128i *)(a + (2 * i))),
+			_mm_loadu_si128((const __m128i *)(b + (2 * i))));
+		v1 = _mm_avg_epu8(_mm_loadu_si128((const __m128i *)(a + (2 * i) + 16)),
+			_mm_loadu_si128((const __m128i *)(b + (2 * i) + 16)));
+		v0 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(
+			_mm_and_si128(v0, mask), _mm_srli_epi16(v0, 8)), one), 1);
+		v1 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(
+			_mm_and_si128(v1, mask), _mm_srli_epi16(v1, 8)), one), 1);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(v0, v1));
+	}
+	sc_half_c(dst + i, a + (2 * i), b + (2 * i), n - i);
+}
+
+/* keeps the low 16 bit of each 32 bit lane through the signed pack */
+static void sc_half2_sse2(hb_u8 *dst, const hb_u8 *a, const hb_u8 *b,
+		hb_s32 n)
+{
+	const __m128i mask = _mm_set1_epi32(0x0000FFFF);
+	__m128i v0, v1;
+	hb_s32 i;
+
+	for (i = 0; (i + 8) <= n; i += 8) {
+		v0 = _mm_avg_epu8(_mm_loadu_si128((const __m128i *)(a + (4 * i))),
+			_mm_loadu_si128((const __m128i *)(b + (4 * i))));
+		v1 = _mm_avg_epu8(_mm_loadu_si128((const __m128i *)(a + (4 * i) + 16)),
+			_mm_loadu_si128((const __m128i *)(b + (4 * i) + 16)));
+		v0 = _mm_and_si128(_mm_avg_epu8(v0, _mm_srli_epi32(v0, 16)), mask);
+		v1 = _mm_and_si128(_mm_avg_epu8(v1, _mm_srli_epi32(v1, 16)), mask);
+		v0 = _mm_srai_epi32(_mm_slli_epi32(v0, 16), 16);
+		v1 = _mm_srai_epi32(_mm_slli_epi32(v1, 16), 16);
+		_mm_storeu_si128((__m128i *)(dst + (2 * i)), _mm_packs_epi32(v0, v1));
+	}
+	sc_half2_c(dst + (2 * i), a + (4 * i), b + (4 * i), n - i);
+}
+
+static void sc_hblend_sse2(hb_u8 *dst, const hb_u16 *pairs, const hb_u8 *frac,
+		hb_s32 n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i mask = _mm_set1_epi16(0x00FF);
+	const __m128i full = _mm_set1_epi16(256);
+	const __m128i rnd = _mm_set1_epi16(128);
+	__m128i p0, p1, f0, f1, o0, o1;
+	hb_s32 i;
+
+	for (i = 0; (i + 16) <= n; i += 16) {
+		p0 = _mm_loadu_si128((const __m128i *)(pairs + i));
+		p1 = _mm_loadu_si128((const __m128i *)(pairs + i + 8));
+		f1 = _mm_loadu_si128((const __m128i *)(frac + i));
+		f0 = _mm_unpacklo_epi8(f1, zero);
+		f1 = _mm_unpackhi_epi8(f1, zero);
+		o0 = _mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(p0, mask),
+			_mm_sub_epi16(full, f0)), _mm_mullo_epi16(_mm_srli_epi16(p0, 8), f0));
+		o1 = _mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(p1, mask),
+			_mm_sub_epi16(full, f1)), _mm_mullo_epi16(_mm_srli_epi16(p1, 8), f1));
+		o0 = _mm_srli_epi16(_mm_add_epi16(o0, rnd), 8);
+		o1 = _mm_srli_epi16(_mm_add_epi16(o1, rnd), 8);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(o0, o1));
+	}
+	sc_hblend_c(dst + i, pairs + i, frac + i, n - i);
+}
+
+MEDIA_TARGET_AVX2
+static void sc_vblend_avx2(hb_u8 *dst, const hb_u8 *a, const hb_u8 *b,
+		hb_s32 f, hb_s32 n)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i wa = _mm256_set1_epi16((short)(256 - f));
+	const __m256i wb = _mm256_set1_epi16((short)f);
+	const __m256i rnd = _mm256_set1_epi16(128);
+	__m256i va, vb, lo, hi;
+	hb_s32 i;
+
+	/* unpack and pack both work per 128 bit lane, the order survives */
+	for (i = 0; (i + 32) <= n; i += 32) {
+		va = _mm256_loadu_si256((const __m256i *)(a + i));
+		vb = _mm256_loadu_si256((const __m256i *)(b + i));
+		lo = _mm256_add_epi16(
+			_mm256_mullo_epi16(_mm256_unpacklo_epi8(va, zero), wa),
+			_mm256_mullo_epi16(_mm256_unpacklo_epi8(vb, zero), wb));
+		hi = _mm256_add_epi16(
+			_mm256_mullo_epi16(_mm256_unpackhi_epi8(va, zero), wa),
+			_mm256_mullo_epi16(_mm256_unpackhi_epi8(vb, zero), wb));
+		lo = _mm256_srli_epi16(_mm256_add_epi16(lo, rnd), 8);
+		hi = _mm256_srli_epi16(_mm256_add_epi16(hi, rnd), 8);
+		_mm256_storeu_si256((__m256i *)(dst + i),
+			_mm256_packus_epi16(lo, hi));
+	}
+	sc_vblend_sse2(dst + i, a + i, b + i, f, n - i);
+}
+
+MEDIA_TARGET_AVX2
+static void sc_vsum_avx2(hb_u16 *acc, const hb_u8 *src, hb_s32 n,
+		hb_bool first)
+{
+	__m256i v;
+	hb_s32 i;
+
+	for (i = 0; (i + 16) <= n; i += 16) {
+		v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(src + i)));
+		if (!first) {
+			v = _mm256_add_epi16(v,
+				_mm256_loadu_si256((const __m256i *)(acc + i)));
+		}
+		_mm256_storeu_si256((__m256i *)(acc + i), v);
+	}
+	sc_vsum_c(acc + i, src + i, n - i, first);
+}
+
+MEDIA_TARGET_AVX2
+static void sc_half_avx2(hb_u8 *dst, const hb_u8 *a, const hb_u8 *b, hb_s32 n)
+{
+	const __m256i mask = _mm256_set1_epi16(0x00FF);
+	const __m256i one = _mm256_set1_epi16(1);
+	__m256i v0, v1;
+	hb_s32 i;
+
+	for (i = 0; (i + 32) <= n; i += 32) {
+		v0 = _mm256_avg_epu8(
+			_mm256_loadu_si256((const __m256i *)(a + (2 * i))),
+			_mm256_loadu_si256((const __m256i *)(b + (2 * i))));
+		v1 = _mm256_avg_epu8(
+			_mm256_loadu_si256((const __m256i *)(a + (2 * i) + 32)),
+			_mm256_loadu_si256((const __m256i *)(b + (2 * i) + 32)));
+		v0 = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(
+			_mm256_and_si256(v0, mask), _mm256_srli_epi16(v0, 8)), one), 1);
+		v1 = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(
+			_mm256_and_si256(v1, mask), _mm256_srli_epi16(v1, 8)), one), 1);
+		/* pack works per 128 bit lane, 0xD8 restores the 64 bit order */
+		_mm256_storeu_si256((__m256i *)(dst + i), _mm256_permute4x64_epi64(
+			_mm256_packus_epi16(v0, v1), 0xD8));
+	}
+	sc_half_sse2(dst + i, a + (2 * i), b + (2 * i), n - i);
+}
+
+MEDIA_TARGET_AVX2
+static void sc_half2_avx2(hb_u8 *dst, const hb_u8 *a, const hb_u8 *b,
+		hb_s32 n)
+{
+	const __m256i mask = _mm256_set1_epi32(0x0000FFFF);
+	__m256i v0, v1;
+	hb_s32 i;
+
+	for (i = 0; (i + 16) <= n; i += 16) {
+		v0 = _mm256_avg_epu8(
+			_mm256_loadu_si256((const __m256i *)(a + (4 * i))),
+			_mm256_loadu_si256((const __m256i *)(b + (4 * i))));
+		v1 = _mm256_avg_epu8(
+			_mm256_loadu_si256((const __m256i *)(a + (4 * i) + 32)),
+			_mm256_loadu_si256((const __m256i *)(b + (4 * i) + 32)));
+		v0 = _mm256_and_si256(_mm256_avg_epu8(v0, _mm256_srli_epi32(v0, 16)),
+			mask);
+		v1 = _mm256_and_si256(_mm256_avg_epu8(v1, _mm256_srli_epi32(v1, 16)),
+			mask);
+		v0 = _mm256_srai_epi32(_mm256_slli_epi32(v0, 16), 16);
+		v1 = _mm256_srai_epi32(_mm256_slli_epi32(v1, 16), 16);
+		_mm256_storeu_si256((__m256i *)(dst + (2 * i)),
+			_mm256_permute4x64_epi64(_mm256_packs_epi32(v0, v1), 0xD8));
+	}
+	sc_half2_sse2(dst + (2 * i), a + (4 * i), b + (4 * i), n - i);
+}
+
+MEDIA_TARGET_AVX2
+static void sc_hblend_avx2(hb_u8 *dst, const hb_u16 *pairs, const hb_u8 *frac,
+		hb_s32 n)
+{
+	const __m256i mask = _mm256_set1_epi16(0x00FF);
+	const __m256i full = _mm256_set1_epi16(256);
+	const __m256i rnd = _mm256_set1_epi16(128);
+	__m256i p, f, o;
+	hb_s32 i;
+
+	for (i = 0; (i + 16) <= n; i += 16) {
+		p = _mm256_loadu_si256((const __m256i *)(pairs + i));
+		f = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(frac + i)));
+		o = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_and_si256(p, mask),
+			_mm256_sub_epi16(full, f)),
+			_mm256_mullo_epi16(_mm256_srli_epi16(p, 8), f));
+		o = _mm256_srli_epi16(_mm256_add_epi16(o, rnd), 8);
+		o = _mm256_permute4x64_epi64(_mm256_packus_epi16(o, o), 0xD8);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm256_castsi256_si128(o));
+	}
+	sc_hblend_sse2(dst + i, pairs + i, frac + i, n - i);
+}
+#endif
+
+#if defined(MEDIA_SIMD_NEON)
+static void sc_vblend_neon(hb_u8 *dst, const hb_u8 *a, const hb_u8 *b,
+		hb_s32 f, hb_s32 n)
+{
+	const uint8x8_t wa = vdup_n_u8((hb_u8)(256 - f));
+	const uint8x8_t wb = vdup_n_u8((hb_u8)f);
+	uint8x16_t va, vb;
+	uint16x8_t lo, hi;
+	hb_s32 i;
+
+	/* f is never 0 here, 256 - f fits in 8 bit */
+	for (i = 0; (i + 16) <= n; i += 16) {
+		va = vld1q_u8(a + i);
+		vb = vld1q_u8(b + i);
+		lo = vmlal_u8(vmull_u8(vget_low_u8(va), wa), vget_low_u8(vb), wb);
+		hi = vmlal_u8(vmull_u8(vget_high_u8(va), wa), vget_high_u8(vb), wb);
+		vst1q_u8(dst + i, vcombine_u8(vrshrn_n_u16(lo, 8),
+			vrshrn_n_u16(hi, 8)));
+	}
+	sc_vblend_c(dst + i, a + i, b + i, f, n - i);
+}
+
+static void sc_vsum_neon(hb_u16 *acc, const hb_u8 *src, hb_s32 n,
+		hb_bool first)
+{
+	uint8x16_t v;
+	hb_s32 i;
+
+	for (i = 0; (i + 16) <= n; i += 16) {
+		v = vld1q_u8(src + i);
+		if (first) {
+			vst1q_u16(acc + i, vmovl_u8(vget_low_u8(v)));
+			vst1q_u16(acc + i + 8, vmovl_u8(vget_high_u8(v)));
+		} else {
+			vst1q_u16(acc + i, vaddw_u8(vld1q_u16(acc + i),
+				vget_low_u8(v)));
+			vst1q_u16(acc + i + 8, vaddw_u8(vld1q_u16(acc + i + 8),
+				vget_high_u8(v)));
+		}
+	}
+	sc_vsum_c(acc + i, src + i, n - i, first);
+}
+
+static void sc_half_neon(hb_u8 *dst, const hb_u8 *a, const hb_u8 *b, hb_s32 n)
+{
+	uint8x16x2_t va, vb;
+	hb_s32 i;
+
+	for (i = 0; (i + 16) <= n; i += 16) {
+		va = vld2q_u8(a + (2 * i));
+		vb = vld2q_u8(b + (2 * i));
+		vst1q_u8(dst + i, vrhaddq_u8(vrhaddq_u8(va.val[0], vb.val[0]),
+			vrhaddq_u8(va.val[1], vb.val[1])));
+	}
+	sc_half_c(dst + i, a + (2 * i), b + (2 * i), n - i);
+}
+
+static void sc_half2_neon(hb_u8 *dst, const hb_u8 *a, const hb_u8 *b,
+		hb_s32 n)
+{
+	uint16x8x2_t va, vb;
+	uint8x16_t even, odd;
+	hb_s32 i;
+
+	for (i = 0; (i + 8) <= n; i += 8) {
+		va = vld2q_u16((const uint16_t *)(a + (4 * i)));
+		vb = vld2q_u16((const uint16_t *)(b + (4 * i)));
+		even = vrhaddq_u8(vreinterpretq_u8_u16(va.val[0]),
+			vreinterpretq_u8_u16(vb.val[0]));
+		odd = vrhaddq_u8(vreinterpretq_u8_u16(va.val[1]),
+			vreinterpretq_u8_u16(vb.val[1]));
+		vst1q_u8(dst + (2 * i), vrhaddq_u8(even, odd));
+	}
+	sc_half2_c(dst + (2 * i), a + (4 * i), b + (4 * i), n - i);
+}
+
+static void sc_hblend_neon(hb_u8 *dst, const hb_u16 *pairs, const hb_u8 *frac,
+		hb_s32 n)
+{
+	uint8x8x2_t p;
+	uint8x8_t f;
+	uint16x8_t o;
+	hb_s32 i;
+
+	for (i = 0; (i + 8) <= n; i += 8) {
+		p = vld2_u8((const hb_u8 *)(pairs + i));
+		f = vld1_u8(frac + i);
+		o = vmlsl_u8(vmlal_u8(vshll_n_u8(p.val[0], 8), p.val[1], f),
+			p.val[0], f);
+		vst1_u8(dst + i, vrshrn_n_u16(o, 8));
+	}
+	sc_hblend_c(dst + i, pairs + i, frac + i, n - i);
+}
+#endif
+
+static void sc_get_kernels(sc_kernels_t *k)
+{
+	k->vblend = sc_vblend_c;
+	k->vsum = sc_vsum_c;
+	k->half = sc_half_c;
+	k->half2 = sc_half2_c;
+	k->hblend = sc_hblend_c;
+
+	switch (media_simd_isa()) {
+#if defined(MEDIA_SIMD_X86)
+	case MC_SIMD_ISA_AVX2:
+		k->vblend = sc_vblend_avx2;
+		k->vsum = sc_vsum_avx2;
+		k->half = sc_half_avx2;
+		k->half2 = sc_half2_avx2;
+		k->hblend = sc_hblend_avx2;
+		break;
+	case MC_SIMD_ISA_SSE2:
+		k->vblend = sc_vblend_sse2;
+		k->vsum = sc_vsum_sse2;
+		k->half = sc_half_sse2;
+		k->half2 = sc_half2_sse2;
+		k->hblend = sc_hblend_sse2;
+		break;
+#endif
+#if defined(MEDIA_SIMD_NEON)
+	case MC_SIMD_ISA_NEON:
+		k->vblend = sc_vblend_neon;
+		k->vsum = sc_vsum_neon;
+		k->half = sc_half_neon;
+		k->half2 = sc_half2_neon;
+		k->hblend = sc_hblend_neon;
+		break;
+#endif
+	default:
+		break;
+	}
+}
+
+/* Center aligned source positions in 16.16 fixed point */
+static hb_s32 sc_axis_init(sc_axis_t *axis, hb_s32 src, hb_s32 dst)
+{
+	hb_s64 pos;
+	hb_s32 i, idx;
+
+	axis->idx0 = (hb_s32 *)malloc(sizeof(hb_s32) * (size_t)dst);
+	axis->idx1 = (hb_s32 *)malloc(sizeof(hb_s32) * (size_t)dst);
+	axis->frac = (hb_u8 *)malloc((size_t)dst);
+	axis->frac2 = (hb_u8 *)malloc(2 * (size_t)dst);
+	if ((axis->idx0 == NULL) || (axis->idx1 == NULL) ||
+		(axis->frac == NULL) || (axis->frac2 == NULL)) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	for (i = 0; i < dst; i++) {
+		pos = ((((hb_s64)(2 * i) + 1) * src) << 15) / dst - 32768;
+		if (pos < 0) {
+			pos = 0;
+		}
+		idx = (hb_s32)(pos >> 16);
+		axis->frac[i] = (hb_u8)((pos >> 8) & 0xFF);
+		if (idx >= src - 1) {
+			idx = src - 1;
+			axis->frac[i] = 0;
+		}
+		axis->idx0[i] = idx;
+		axis->idx1[i] = (idx + 1 < src) ? (idx + 1) : idx;
+		axis->frac2[2 * i] = axis->frac[i];
+		axis->frac2[(2 * i) + 1] = axis->frac[i];
+		if (axis->idx1[i] == idx + 1) {
+			axis->pairs = i + 1;
+		}
+	}
+
+	return 0;
+}
+
+static void sc_axis_release(sc_axis_t *axis)
+{
+	free(axis->idx0);
+	free(axis->idx1);
+	free(axis->frac);
+	free(axis->frac2);
+}
+
+static hb_s32 sc_plane_init(sc_plane_t *p, hb_s32 src_w, hb_s32 src_h,
+		hb_s32 dst_w, hb_s32 dst_h)
+{
+	hb_s32 ret;
+
+	p->src_w = src_w;
+	p->src_h = src_h;
+	p->dst_w = dst_w;
+	p->dst_h = dst_h;
+	ret = sc_axis_init(&p->x, src_w, dst_w);
+	if (ret == 0) {
+		ret = sc_axis_init(&p->y, src_h, dst_h);
+	}
+
+	return ret;
+}
+
+/*
+ * Collect both neighbours of every destination sample with one load, then
+ * blend them with the SIMD kernel. The tables are read through locals,
+ * the stores may alias anything.
+ */
+static void sc_hblend(hb_u16 *pairs, const sc_kernels_t *k, hb_u8 *dst,
+		const hb_u8 *row, const sc_axis_t *x, hb_s32 n, hb_s32 channels)
+{
+	const hb_s32 *idx0 = x->idx0, *idx1 = x->idx1;
+	hb_s32 i, a, b;
+
+	if (channels == 1) {
+		for (i = 0; i < x->pairs; i++) {
+			a = idx0[i];
+			pairs[i] = (hb_u16)(row[a] | (row[a + 1] << 8));
+		}
+		for (; i < n; i++) {
+			pairs[i] = (hb_u16)(row[idx0[i]] | (row[idx1[i]] << 8));
+		}
+		k->hblend(dst, pairs, x->frac, n);
+		return;
+	}
+	for (i = 0; i < n; i++) {
+		a = 2 * idx0[i];
+		b = 2 * idx1[i];
+		pairs[2 * i] = (hb_u16)(row[a] | (row[b] << 8));
+		pairs[(2 * i) + 1] = (hb_u16)(row[a + 1] | (row[b + 1] << 8));
+	}
+	k->hblend(dst, pairs, x->frac2, 2 * n);
+}
+
+static void sc_plane_bilinear(mc_scaler_t *sc, const sc_kernels_t *k,
+		const sc_plane_t *p, hb_s32 channels, const hb_u8 *src,
+		hb_s32 src_stride, hb_u8 *dst, hb_s32 dst_stride)
+{
+	const hb_u8 *r0, *r1, *row;
+	hb_s32 y, f;
+	hb_s32 n = p->src_w * channels;
+
+	for (y = 0; y < p->dst_h; y++) {
+		r0 = src + ((size_t)p->y.idx0[y] * src_stride);
+		r1 = src + ((size_t)p->y.idx1[y] * src_stride);
+		f = p->y.frac[y];
+		if (f == 0) {
+			row = r0;
+		} else {
+			k->vblend(sc->row, r0, r1, f, n);
+			row = sc->row;
+		}
+		if (p->dst_w == p->src_w) {
+			memcpy(dst + ((size_t)y * dst_stride), row,
+				(size_t)p->dst_w * channels);
+		} else {
+			sc_hblend(sc->pairs, k, dst + ((size_t)y * dst_stride), row,
+				&p->x, p->dst_w, channels);
+		}
+	}
+}
+
+static void sc_plane_area(mc_scaler_t *sc, const sc_kernels_t *k,
+		const sc_plane_t *p, hb_s32 channels, const hb_u8 *src,
+		hb_s32 src_stride, hb_u8 *dst, hb_s32 dst_stride)
+{
+	hb_s32 rx = sc->area_x, ry = sc->area_y;
+	hb_u32 area = (hb_u32)(rx * ry);
+	hb_u32 recip = (65536 + (area / 2)) / area;
+	hb_s32 x, y, i, c, j;
+	hb_u32 sum;
+	const hb_u16 *acc;
+	sc_half_fn half;
+	hb_u8 *out;
+
+	if ((rx == 2) && (ry == 2)) {
+		half = (channels == 1) ? k->half : k->half2;
+		for (y = 0; y < p->dst_h; y++) {
+			half(dst + ((size_t)y * dst_stride),
+				src + ((size_t)(2 * y) * src_stride),
+				src + ((size_t)((2 * y) + 1) * src_stride), p->dst_w);
+		}
+		return;
+	}
+
+	for (y = 0; y < p->dst_h; y++) {
+		for (i = 0; i < ry; i++) {
+			k->vsum(sc->acc, src + ((size_t)((y * ry) + i) * src_stride),
+				p->dst_w * rx * channels, (i == 0) ? TRUE : FALSE);
+		}
+		out = dst + ((size_t)y * dst_stride);
+		acc = sc->acc;
+		for (x = 0; x < p->dst_w; x++) {
+			for (c = 0; c < channels; c++) {
+				sum = 0;
+				for (j = 0; j < rx; j++) {
+					sum += acc[(j * channels) + c];
+				}
+				out[c] = (hb_u8)(((sum * recip) + 32768) >> 16);
+			}
+			acc += rx * channels;
+			out += channels;
+		}
+	}
+}
+
+static void sc_plane(mc_scaler_t *sc, const sc_kernels_t *k,
+		const sc_plane_t *p, hb_s32 channels, const hb_u8 *src,
+		hb_s32 src_stride, hb_u8 *dst, hb_s32 dst_stride)
+{
+	/* odd chroma sizes don't divide, only the luma ratio decides */
+	if ((sc->area_x > 0) && (p->dst_w * sc->area_x <= p->src_w) &&
+		(p->dst_h * sc->area_y <= p->src_h)) {
+		sc_plane_area(sc, k, p, channels, src, src_stride, dst, dst_stride);
+	} else {
+		sc_plane_bilinear(sc, k, p, channels, src, src_stride, dst,
+			dst_stride);
+	}
+}
+
+static hb_bool sc_is_420(mc_pixel_format_t fmt)
+{
+	return (fmt == MC_PIXEL_FORMAT_YUV420P) || (fmt == MC_PIXEL_FORMAT_NV12) ||
+		(fmt == MC_PIXEL_FORMAT_NV21);
+}
+
+hb_s32 hb_mm_scaler_create(hb_s32 src_width, hb_s32 src_height,
+		hb_s32 dst_width, hb_s32 dst_height, mc_scale_filter_t filter,
+		mc_scaler_t **scaler)
+{
+	mc_scaler_t *sc;
+	hb_s32 ret;
+
+	if ((scaler == NULL) || (src_width <= 0) || (src_height <= 0) ||
+		(dst_width <= 0) || (dst_height <= 0) ||
+		(filter <= MC_SCALE_FILTER_NONE) || (filter >= MC_SCALE_FILTER_TOTAL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(%dx%d->%dx%d, filter=%d).\n",
+			TAG, __FUNCTION__, __LINE__, src_width, src_height, dst_width,
+			dst_height, filter);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	sc = (mc_scaler_t *)calloc(1, sizeof(*sc));
+	if (sc == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	sc->filter = filter;
+	if ((filter == MC_SCALE_FILTER_AREA) && (src_width % dst_width == 0) &&
+		(src_height % dst_height == 0) &&
+		(src_width / dst_width <= SC_AREA_MAX_RATIO) &&
+		(src_height / dst_height <= SC_AREA_MAX_RATIO) &&
+		((src_width > dst_width) || (src_height > dst_height))) {
+		sc->area_x = src_width / dst_width;
+		sc->area_y = src_height / dst_height;
+	}
+	ret = sc_plane_init(&sc->luma, src_width, src_height, dst_width,
+		dst_height);
+	if (ret == 0) {
+		ret = sc_plane_init(&sc->chroma, (src_width + 1) / 2,
+			(src_height + 1) / 2, (dst_width + 1) / 2, (dst_height + 1) / 2);
+	}
+	if (ret == 0) {
+		/* interleaved chroma rows are at most one byte wider than luma */
+		sc->row = (hb_u8 *)malloc((size_t)src_width + 2);
+		sc->acc = (hb_u16 *)malloc(sizeof(hb_u16) * ((size_t)src_width + 2));
+		sc->pairs = (hb_u16 *)malloc(sizeof(hb_u16) *
+			((size_t)dst_width + 2));
+		sc->tmp = (hb_u8 *)malloc(((size_t)sc->luma.dst_w *
+			sc->luma.dst_h) + ((size_t)sc->chroma.dst_w *
+			sc->chroma.dst_h * 2));
+		if ((sc->row == NULL) || (sc->acc == NULL) || (sc->pairs == NULL) ||
+			(sc->tmp == NULL)) {
+			ret = HB_MEDIA_ERR_INSUFFICIENT_RES;
+		}
+	}
+	if (ret != 0) {
+		VLOG(ERR, "%s <%s:%d> Failed to allocate scaler tables.\n",
+			TAG, __FUNCTION__, __LINE__);
+		hb_mm_scaler_destroy(sc);
+		return ret;
+	}
+
+	*scaler = sc;
+	return 0;
+}
+
+hb_s32 hb_mm_scaler_process(mc_scaler_t *scaler, mc_pixel_format_t src_fmt,
+		const mc_video_planes_t *src, mc_video_frame_buffer_info_t *dst)
+{
+	mc_video_frame_buffer_info_t tmp;
+	mc_video_frame_buffer_info_t *out;
+	mc_video_planes_t planes;
+	sc_kernels_t k;
+	hb_s32 lstride, cstride;
+
+	if ((scaler == NULL) || (src == NULL) || (dst == NULL) ||
+		(src->data[0] == NULL) || (src->data[1] == NULL) ||
+		(dst->vir_ptr[0] == NULL) || (dst->width != scaler->luma.dst_w) ||
+		(dst->height != scaler->luma.dst_h)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(scaler=%p, src=%p, dst=%p).\n",
+			TAG, __FUNCTION__, __LINE__, scaler, src, dst);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (!sc_is_420(src_fmt) || !sc_is_420(dst->pix_fmt) ||
+		((src_fmt == MC_PIXEL_FORMAT_YUV420P) && (src->data[2] == NULL))) {
+		VLOG(ERR, "%s <%s:%d> Unsupported scaling %d->%d.\n",
+			TAG, __FUNCTION__, __LINE__, src_fmt, dst->pix_fmt);
+		return HB_MEDIA_ERR_UNSUPPORTED_FEATURE;
+	}
+
+	out = dst;
+	if (dst->pix_fmt != src_fmt) {
+		/* scale in the source format, the conversion is cheaper small */
+		memset(&tmp, 0x00, sizeof(tmp));
+		tmp.width = dst->width;
+		tmp.height = dst->height;
+		tmp.pix_fmt = src_fmt;
+		tmp.vir_ptr[0] = scaler->tmp;
+		out = &tmp;
+	}
+
+	sc_get_kernels(&k);
+	media_pixfmt_layout(out, &lstride, &cstride);
+	sc_plane(scaler, &k, &scaler->luma, 1, src->data[0], src->stride[0],
+		out->vir_ptr[0], lstride);
+	if (src_fmt == MC_PIXEL_FORMAT_YUV420P) {
+		sc_plane(scaler, &k, &scaler->chroma, 1, src->data[1], src->stride[1],
+			out->vir_ptr[1], cstride);
+		sc_plane(scaler, &k, &scaler->chroma, 1, src->data[2], src->stride[2],
+			out->vir_ptr[2], cstride);
+	} else {
+		sc_plane(scaler, &k, &scaler->chroma, 2, src->data[1], src->stride[1],
+			out->vir_ptr[1], cstride);
+	}
+
+	if (out == dst) {
+		return 0;
+	}
+	memset(&planes, 0x00, sizeof(planes));
+	planes.data[0] = tmp.vir_ptr[0];
+	planes.data[1] = tmp.vir_ptr[1];
+	planes.data[2] = tmp.vir_ptr[2];
+	planes.stride[0] = lstride;
+	planes.stride[1] = cstride;
+	planes.stride[2] = cstride;
+
+	return hb_mm_pixfmt_convert(src_fmt, &planes, dst);
+}
+
+hb_s32 hb_mm_scaler_destroy(mc_scaler_t *scaler)
+{
+	if (scaler == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	sc_axis_release(&scaler->luma.x);
+	sc_axis_release(&scaler->luma.y);
+	sc_axis_release(&scaler->chroma.x);
+	sc_axis_release(&scaler->chroma.y);
+	free(scaler->row);
+	free(scaler->acc);
+	free(scaler->pairs);
+	free(scaler->tmp);
+	free(scaler);
+
+	return 0;
+}
@@ -0,0 +1,256 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hb_media_scenecut.h"
+#include "media_block.h"
+#include "media_common.h"
+
+#define TAG "[MEDIASCENECUT]"
+
+/* Histogram of the reduced plane, 4 levels per bin */
+#define SCENECUT_HIST_BINS 64
+
+struct _mc_scenecut_detector {
+	mc_scenecut_params_t params;
+	/* Reduced planes of the current and the previous picture */
+	hb_u8 *cur;
+	hb_u8 *prev;
+	hb_s32 down_w;
+	hb_s32 down_h;
+	hb_u32 hist[2][SCENECUT_HIST_BINS];
+	hb_u32 hist_idx;
+	hb_u32 *sad;
+	hb_bool has_prev;
+	/* Pictures since the last IDR */
+	hb_u32 since_idr;
+	mc_scenecut_stats_t stats;
+};
+
+static hb_u64 scenecut_get_time_us(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+	return ((hb_u64)tp.tv_sec * 1000000) + ((hb_u64)tp.tv_nsec / 1000);
+}
+
+hb_s32 hb_mm_scenecut_create(const mc_scenecut_params_t *params,
+		mc_scenecut_detector_t **det)
+{
+	mc_scenecut_detector_t *d;
+	size_t size;
+
+	if ((params == NULL) || (det == NULL) || (params->width <= 0) ||
+		(params->height <= 0) || (params->hist_threshold > 1000)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(params=%p).\n",
+			TAG, __FUNCTION__, __LINE__, params);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	d = (mc_scenecut_detector_t *)calloc(1, sizeof(*d));
+	if (d == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	d->params = *params;
+	d->down_w = (params->width + MEDIA_BLOCK_DOWN - 1) / MEDIA_BLOCK_DOWN;
+	d->down_h = (params->height + MEDIA_BLOCK_DOWN - 1) / MEDIA_BLOCK_DOWN;
+	size = (size_t)d->down_w * d->down_h;
+	d->cur = (hb_u8 *)malloc(size);
+	d->prev = (hb_u8 *)malloc(size);
+	d->sad = (hb_u32 *)malloc(sizeof(hb_u32) *
+		(size_t)((d->down_w + MEDIA_BLOCK_SIZE - 1) / MEDIA_BLOCK_SIZE));
+	if ((d->cur == NULL) || (d->prev == NULL) || (d->sad == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Failed to allocate the reduced planes.\n",
+			TAG, __FUNCTION__, __LINE__);
+		hb_mm_scenecut_destroy(d);
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+
+	*det = d;
+	return 0;
+}
+
+hb_s32 hb_mm_scenecut_set_params(mc_scenecut_detector_t *det,
+		const mc_scenecut_params_t *params)
+{
+	if ((det == NULL) || (params == NULL) || (params->hist_threshold > 1000) ||
+		(params->width != det->params.width) ||
+		(params->height != det->params.height)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(det=%p, params=%p).\n",
+			TAG, __FUNCTION__, __LINE__, det, params);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	det->params = *params;
+
+	return 0;
+}
+
+/* Reduce the picture into det->cur and build its histogram */
+static void scenecut_reduce(mc_scenecut_detector_t *det,
+		const media_block_kernels_t *k, const hb_u8 *luma, hb_s32 stride)
+{
+	const mc_scenecut_params_t *p = &det->params;
+	hb_u32 *hist = det->hist[det->hist_idx];
+	hb_s32 y, rows;
+	size_t i, size;
+
+	for (y = 0; y < det->down_h; y++) {
+		rows = p->height - (y * MEDIA_BLOCK_DOWN);
+		rows = (rows > MEDIA_BLOCK_DOWN) ? MEDIA_BLOCK_DOWN : rows;
+		k->down(luma + ((size_t)y * MEDIA_BLOCK_DOWN * stride), stride,
+			p->width, rows, det->cur + ((size_t)y * det->down_w));
+	}
+	memset(hist, 0x00, sizeof(det->hist[0]));
+	size = (size_t)det->down_w * det->down_h;
+	for (i = 0; i < size; i++) {
+		hist[det->cur[i] >> 2]++;
+	}
+}
+
+/* Mean absolute difference to the previous reduced plane in 1/16 levels */
+static hb_u32 scenecut_sad_diff(mc_scenecut_detector_t *det,
+		const media_block_kernels_t *k)
+{
+	hb_u64 total = 0;
+	hb_s32 y, x, rows, blocks;
+
+	blocks = (det->down_w + MEDIA_BLOCK_SIZE - 1) / MEDIA_BLOCK_SIZE;
+	for (y = 0; y < det->down_h; y += MEDIA_BLOCK_SIZE) {
+		rows = det->down_h - y;
+		rows = (rows > MEDIA_BLOCK_SIZE) ? MEDIA_BLOCK_SIZE : rows;
+		k->sad(det->cur + ((size_t)y * det->down_w), det->down_w,
+			det->prev + ((size_t)y * det->down_w), det->down_w,
+			det->down_w, rows, det->sad);
+		for (x = 0; x < blocks; x++) {
+			total += det->sad[x];
+		}
+	}
+
+	return (hb_u32)((total * 16) / ((hb_u64)det->down_w * det->down_h));
+}
+
+/* Samples that changed bin in per mille, half the L1 distance */
+static hb_u32 scenecut_hist_diff(mc_scenecut_detector_t *det)
+{
+	const hb_u32 *a = det->hist[det->hist_idx];
+	const hb_u32 *b = det->hist[det->hist_idx ^ 1];
+	hb_u64 total = 0;
+	hb_s32 i;
+
+	for (i = 0; i < SCENECUT_HIST_BINS; i++) {
+		total += (a[i] > b[i]) ? (a[i] - b[i]) : (b[i] - a[i]);
+	}
+
+	return (hb_u32)((total * 500) / ((hb_u64)det->down_w * det->down_h));
+}
+
+hb_s32 hb_mm_scenecut_detect(mc_scenecut_detector_t *det,
+		const hb_u8 *luma, hb_s32 stride, hb_bool *idr)
+{
+	const mc_scenecut_params_t *p;
+	media_block_kernels_t k;
+	hb_u64 start, cost;
+	hb_u8 *tmp;
+	hb_bool cut = FALSE;
+
+	if ((det == NULL) || (luma == NULL) || (idr == NULL) ||
+		(stride < det->params.width)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(det=%p, luma=%p).\n",
+			TAG, __FUNCTION__, __LINE__, det, luma);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	p = &det->params;
+
+	start = scenecut_get_time_us();
+	*idr = FALSE;
+	media_block_get_kernels(&k);
+	scenecut_reduce(det, &k, luma, stride);
+	if (det->has_prev) {
+		det->stats.last_hist_diff = scenecut_hist_diff(det);
+		det->stats.last_sad_diff = scenecut_sad_diff(det, &k);
+		cut = (det->stats.last_hist_diff > p->hist_threshold) &&
+			(det->stats.last_sad_diff > p->sad_threshold);
+		det->since_idr++;
+	}
+	if (cut && (det->since_idr < p->min_cut_interval)) {
+		det->stats.ignored++;
+		cut = FALSE;
+	}
+	if (cut) {
+		det->stats.cuts++;
+		*idr = TRUE;
+	} else if ((p->idr_interval > 0) && (det->since_idr >= p->idr_interval)) {
+		det->stats.periodic++;
+		*idr = TRUE;
+	}
+	if (*idr) {
+		det->since_idr = 0;
+	}
+	det->has_prev = TRUE;
+	tmp = det->prev;
+	det->prev = det->cur;
+	det->cur = tmp;
+	det->hist_idx ^= 1;
+	cost = scenecut_get_time_us() - start;
+	det->stats.frames++;
+	det->stats.cost_us += cost;
+	if (cost > det->stats.max_cost_us) {
+		det->stats.max_cost_us = cost;
+	}
+
+	return 0;
+}
+
+hb_s32 hb_mm_scenecut_apply(mc_scenecut_detector_t *det,
+		media_codec_context_t *context, media_codec_buffer_t *buffer)
+{
+	mc_video_frame_buffer_info_t *frame;
+	hb_bool idr = FALSE;
+	hb_s32 ret;
+
+	if ((det == NULL) || (context == NULL) || (buffer == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(det=%p, context=%p).\n",
+			TAG, __FUNCTION__, __LINE__, det, context);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	frame = &buffer->vframe_buf;
+	if (frame->frame_end) {
+		return 0;
+	}
+
+	ret = hb_mm_scenecut_detect(det, frame->vir_ptr[0],
+		(frame->stride > 0) ? frame->stride : det->params.width, &idr);
+	if ((ret == 0) && idr) {
+		ret = hb_mm_mc_request_idr_frame(context);
+		if (ret > 0) {
+			ret = 0;
+		}
+	}
+
+	return ret;
+}
+
+hb_s32 hb_mm_scenecut_get_stats(mc_scenecut_detector_t *det,
+		mc_scenecut_stats_t *stats)
+{
+	if ((det == NULL) || (stats == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	*stats = det->stats;
+
+	return 0;
+}
+
+hb_s32 hb_mm_scenecut_destroy(mc_scenecut_detector_t *det)
+{
+	if (det == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	free(det->cur);
+	free(det->prev);
+	free(det->sad);
+	free(det);
+
+	return 0;
+}
@@ -0,0 +1,388 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hb_media_segment.h"
+#include "media_common.h"
+
+#define TAG "[MEDIASEGMENT]"
+#define SEG_PATH_MAX 512
+#define SEG_JOB_NUM 16
+
+typedef enum _seg_job_type {
+	SEG_JOB_PREPARE = 0,
+	SEG_JOB_FINALIZE,
+} seg_job_type_t;
+
+typedef struct _seg_job {
+	seg_job_type_t type;
+	hb_u32 index;
+	hb_s32 fd;
+	hb_u64 size;
+	hb_s32 reason;
+} seg_job_t;
+
+struct _mr_segment_writer {
+	mr_segment_params_t params;
+	char pattern[SEG_PATH_MAX];
+
+	/* write path, only touched by the caller thread */
+	hb_s32 fd;
+	hb_u32 index;
+	hb_u64 seg_size;
+	hb_u64 seg_start_pts;
+	hb_bool seg_started;
+	hb_s32 pending_reason;
+	mr_segment_stats_t stats;
+
+	/* shared with the background thread */
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_t thread;
+	seg_job_t jobs[SEG_JOB_NUM];
+	hb_u32 job_head;
+	hb_u32 job_count;
+	hb_s32 next_fd;
+	hb_u32 next_index;
+	hb_bool next_ready;
+	hb_bool quit;
+};
+
+static hb_u64 seg_get_time_us(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+	return ((hb_u64)tp.tv_sec * 1000000U) + ((hb_u64)tp.tv_nsec / 1000U);
+}
+
+static void seg_make_path(const mr_segment_writer_t *writer, hb_u32 index,
+		char *path, size_t size)
+{
+	snprintf(path, size, writer->pattern, index);
+}
+
+static hb_s32 seg_open(mr_segment_writer_t *writer, hb_u32 index)
+{
+	char path[SEG_PATH_MAX];
+	hb_u32 prealloc;
+	hb_s32 fd;
+
+	seg_make_path(writer, index, path, sizeof(path));
+	fd = open(path, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to open segment %s.(%s)\n",
+			TAG, __FUNCTION__, __LINE__, path, strerror(errno));
+		return -1;
+	}
+
+	prealloc = writer->params.prealloc_size;
+	if ((prealloc == 0U) && (writer->params.max_file_size > 0)) {
+		prealloc = (hb_u32)writer->params.max_file_size;
+	}
+	/*
+	 * The tail beyond the written size is zero filled, which is
+	 * trailing_zero_8bits in an Annex-B byte stream, so a segment cut
+	 * by a power loss is still decodable.
+	 */
+	if ((prealloc > 0U) && (fallocate(fd, 0, 0, (off_t)prealloc) != 0)) {
+		VLOG(WARN, "%s <%s:%d> fallocate %u bytes for %s failed.(%s)\n",
+			TAG, __FUNCTION__, __LINE__, prealloc, path, strerror(errno));
+	}
+
+	return fd;
+}
+
+static void seg_finalize(mr_segment_writer_t *writer, const seg_job_t *job)
+{
+	if (ftruncate(job->fd, (off_t)job->size) != 0) {
+		VLOG(WARN, "%s <%s:%d> Fail to trim segment %u.(%s)\n",
+			TAG, __FUNCTION__, __LINE__, job->index, strerror(errno));
+	}
+	if (writer->params.sync_on_close) {
+		(void)fdatasync(job->fd);
+	}
+	close(job->fd);
+
+	if ((writer->params.listener != NULL) && (job->reason != 0)) {
+		writer->params.listener(MR_EVENT_INFO, job->reason,
+			(hb_s32)job->index, writer->params.userdata);
+	}
+}
+
+static void *seg_worker(void *arg)
+{
+	mr_segment_writer_t *writer = (mr_segment_writer_t *)arg;
+	seg_job_t job;
+	hb_s32 fd;
+
+	pthread_mutex_lock(&writer->lock);
+	while (TRUE) {
+		while ((writer->job_count == 0U) && !writer->quit) {
+			pthread_cond_wait(&writer->cond, &writer->lock);
+		}
+		if (writer->job_count == 0U) {
+			break;
+		}
+		job = writer->jobs[writer->job_head];
+		writer->job_head = (writer->job_head + 1U) % SEG_JOB_NUM;
+		writer->job_count--;
+		pthread_cond_broadcast(&writer->cond);
+		pthread_mutex_unlock(&writer->lock);
+
+		if (job.type == SEG_JOB_PREPARE) {
+			fd = seg_open(writer, job.index);
+			pthread_mutex_lock(&writer->lock);
+			writer->next_fd = fd;
+			writer->next_index = job.index;
+			writer->next_ready = TRUE;
+			pthread_cond_broadcast(&writer->cond);
+			pthread_mutex_unlock(&writer->lock);
+		} else {
+			seg_finalize(writer, &job);
+		}
+
+		pthread_mutex_lock(&writer->lock);
+	}
+	pthread_mutex_unlock(&writer->lock);
+
+	return NULL;
+}
+
+/* Must be called with writer->lock held. */
+static void seg_push_job_locked(mr_segment_writer_t *writer,
+		const seg_job_t *job)
+{
+	while (writer->job_count == SEG_JOB_NUM) {
+		pthread_cond_wait(&writer->cond, &writer->lock);
+	}
+	writer->jobs[(writer->job_head + writer->job_count) % SEG_JOB_NUM] = *job;
+	writer->job_count++;
+	pthread_cond_broadcast(&writer->cond);
+}
+
+static hb_s32 seg_rotate(mr_segment_writer_t *writer)
+{
+	seg_job_t job;
+	hb_u64 start = seg_get_time_us();
+	hb_u64 cost;
+	hb_s32 fd;
+
+	pthread_mutex_lock(&writer->lock);
+	if (!writer->next_ready) {
+		writer->stats.late_rotations++;
+		while (!writer->next_ready) {
+			pthread_cond_wait(&writer->cond, &writer->lock);
+		}
+	}
+	fd = writer->next_fd;
+	if (fd < 0) {
+		/*
+		 * The pre-open failed, keep writing the current segment and
+		 * try again for the next IDR.
+		 */
+		writer->next_ready = FALSE;
+		seg_push_job_locked(writer, &(seg_job_t){ .type = SEG_JOB_PREPARE,
+			.index = writer->next_index, .fd = -1 });
+		pthread_mutex_unlock(&writer->lock);
+		writer->stats.failed_rotations++;
+		return 0;
+	}
+
+	memset(&job, 0x00, sizeof(job));
+	job.type = SEG_JOB_FINALIZE;
+	job.index = writer->index;
+	job.fd = writer->fd;
+	job.size = writer->seg_size;
+	job.reason = writer->pending_reason;
+
+	writer->fd = fd;
+	writer->index = writer->next_index;
+	writer->next_fd = -1;
+	writer->next_ready = FALSE;
+
+	/* open the following segment before the old one is flushed */
+	seg_push_job_locked(writer, &(seg_job_t){ .type = SEG_JOB_PREPARE,
+		.index = writer->index + 1U, .fd = -1 });
+	seg_push_job_locked(writer, &job);
+	pthread_mutex_unlock(&writer->lock);
+
+	writer->seg_size = 0U;
+	writer->seg_started = FALSE;
+	writer->pending_reason = 0;
+	writer->stats.rotations++;
+	writer->stats.current_index = writer->index;
+
+	cost = seg_get_time_us() - start;
+	if (cost > writer->stats.max_switch_us) {
+		writer->stats.max_switch_us = (hb_u32)cost;
+	}
+
+	return 0;
+}
+
+hb_s32 hb_mm_seg_create(const mr_segment_params_t *params,
+		mr_segment_writer_t **writer)
+{
+	mr_segment_writer_t *w;
+
+	if ((params == NULL) || (writer == NULL) ||
+		(params->output_file_pattern == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(params=%p, writer=%p).\n",
+			TAG, __FUNCTION__, __LINE__, params, writer);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (strlen(params->output_file_pattern) >= SEG_PATH_MAX) {
+		VLOG(ERR, "%s <%s:%d> Too long file pattern.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	w = (mr_segment_writer_t *)calloc(1, sizeof(*w));
+	if (w == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	w->params = *params;
+	strncpy(w->pattern, params->output_file_pattern, SEG_PATH_MAX - 1);
+	w->params.output_file_pattern = w->pattern;
+	w->index = params->first_index;
+	w->stats.current_index = w->index;
+	w->next_fd = -1;
+	pthread_mutex_init(&w->lock, NULL);
+	pthread_cond_init(&w->cond, NULL);
+
+	w->fd = seg_open(w, w->index);
+	if (w->fd < 0) {
+		pthread_cond_destroy(&w->cond);
+		pthread_mutex_destroy(&w->lock);
+		free(w);
+		return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+	}
+
+	if (pthread_create(&w->thread, NULL, seg_worker, w) != 0) {
+		close(w->fd);
+		pthread_cond_destroy(&w->cond);
+		pthread_mutex_destroy(&w->lock);
+		free(w);
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+
+	pthread_mutex_lock(&w->lock);
+	seg_push_job_locked(w, &(seg_job_t){ .type = SEG_JOB_PREPARE,
+		.index = w->index + 1U, .fd = -1 });
+	pthread_mutex_unlock(&w->lock);
+
+	*writer = w;
+	return 0;
+}
+
+hb_s32 hb_mm_seg_write(mr_segment_writer_t *writer,
+		const hb_u8 *data, hb_u32 size, hb_u64 pts, hb_bool is_idr)
+{
+	const mr_segment_params_t *params;
+	hb_u32 done = 0U;
+	ssize_t n;
+	hb_s32 ret;
+
+	if ((writer == NULL) || ((data == NULL) && (size != 0U))) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(writer=%p, data=%p).\n",
+			TAG, __FUNCTION__, __LINE__, writer, data);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	params = &writer->params;
+
+	if ((writer->pending_reason != 0) && is_idr) {
+		ret = seg_rotate(writer);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	if (!writer->seg_started) {
+		writer->seg_start_pts = pts;
+		writer->seg_started = TRUE;
+	}
+
+	while (done < size) {
+		n = write(writer->fd, data + done, size - done);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			VLOG(ERR, "%s <%s:%d> Fail to write segment %u.(%s)\n",
+				TAG, __FUNCTION__, __LINE__, writer->index, strerror(errno));
+			return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+		}
+		done += (hb_u32)n;
+	}
+	writer->seg_size += size;
+	writer->stats.bytes_written += size;
+	writer->stats.frames_written++;
+
+	if (writer->pending_reason == 0) {
+		if ((params->max_file_size > 0) &&
+			(writer->seg_size >= (hb_u64)params->max_file_size)) {
+			writer->pending_reason = MR_INFO_MAX_FILESIZE_REACHED;
+		} else if ((params->max_file_duration > 0) &&
+			(pts >= writer->seg_start_pts) &&
+			((pts - writer->seg_start_pts) >=
+			(hb_u64)params->max_file_duration)) {
+			writer->pending_reason = MR_INFO_MAX_DURATION_REACHED;
+		}
+	}
+
+	return 0;
+}
+
+hb_s32 hb_mm_seg_get_stats(mr_segment_writer_t *writer,
+		mr_segment_stats_t *stats)
+{
+	if ((writer == NULL) || (stats == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	*stats = writer->stats;
+	return 0;
+}
+
+hb_s32 hb_mm_seg_destroy(mr_segment_writer_t *writer)
+{
+	char path[SEG_PATH_MAX];
+	seg_job_t job;
+
+	if (writer == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	memset(&job, 0x00, sizeof(job));
+	job.type = SEG_JOB_FINALIZE;
+	job.index = writer->index;
+	job.fd = writer->fd;
+	job.size = writer->seg_size;
+
+	pthread_mutex_lock(&writer->lock);
+	seg_push_job_locked(writer, &job);
+	writer->quit = TRUE;
+	pthread_cond_broadcast(&writer->cond);
+	pthread_mutex_unlock(&writer->lock);
+	pthread_join(writer->thread, NULL);
+
+	/* the worker drains the queue, so the pre-opened segment is ready */
+	if (writer->next_ready && (writer->next_fd >= 0)) {
+		close(writer->next_fd);
+		seg_make_path(writer, writer->next_index, path, sizeof(path));
+		unlink(path);
+	}
+
+	pthread_cond_destroy(&writer->cond);
+	pthread_mutex_destroy(&writer->lock);
+	free(writer);
+
+	return 0;
+}
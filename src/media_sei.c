@@ -0,0 +1,366 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hb_media_sei.h"
+#include "media_common.h"
+
+#define TAG "[MEDIASEI]"
+
+#define SEI_UUID_SIZE 16
+/* 32 hex digits and '+' in front of the text */
+#define SEI_PREFIX_SIZE ((SEI_UUID_SIZE * 2) + 1)
+#define SEI_MAGIC "HBM1"
+
+struct _mc_sei_injector {
+	media_codec_context_t *context;
+	mc_sei_params_t params;
+	/* Payloads in use, each until the picture of slot_pts is encoded */
+	hb_u8 pool[MC_SEI_POOL_MAX][MC_SEI_PAYLOAD_MAX];
+	hb_u64 slot_pts[MC_SEI_POOL_MAX];
+	hb_bool slot_used[MC_SEI_POOL_MAX];
+	hb_u32 used;
+	/* Pictures attached */
+	hb_u64 queued;
+	char prefix[SEI_PREFIX_SIZE + 1];
+	mc_sei_stats_t stats;
+};
+
+struct _mc_sei_extractor {
+	media_codec_context_t *context;
+	mc_sei_params_t params;
+	char text[MC_SEI_PAYLOAD_MAX + 1];
+	mc_sei_stats_t stats;
+};
+
+static hb_bool sei_codec_supported(const media_codec_context_t *context)
+{
+	return (context->codec_id == MEDIA_CODEC_ID_H264) ||
+		(context->codec_id == MEDIA_CODEC_ID_H265);
+}
+
+hb_s32 hb_mm_sei_injector_create(media_codec_context_t *context,
+		const mc_sei_params_t *params, mc_sei_injector_t **inj)
+{
+	static const char hex[] = "0123456789abcdef";
+	mc_sei_injector_t *s;
+	hb_u32 i;
+
+	if ((context == NULL) || (params == NULL) || (inj == NULL) ||
+		(params->pool_size == 0) || (params->pool_size > MC_SEI_POOL_MAX)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(context=%p, params=%p).\n",
+			TAG, __FUNCTION__, __LINE__, context, params);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (!context->encoder || !sei_codec_supported(context)) {
+		VLOG(ERR, "%s <%s:%d> The instance isn't an H264/H265 encoder.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_INSTANCE;
+	}
+
+	s = (mc_sei_injector_t *)calloc(1, sizeof(*s));
+	if (s == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	s->context = context;
+	s->params = *params;
+	for (i = 0; i < SEI_UUID_SIZE; i++) {
+		s->prefix[i * 2] = hex[params->uuid[i] >> 4];
+		s->prefix[(i * 2) + 1] = hex[params->uuid[i] & 0x0F];
+	}
+	s->prefix[SEI_UUID_SIZE * 2] = '+';
+
+	*inj = s;
+	return 0;
+}
+
+/* Payload text of the metadata with its terminating zero, 0 if too long */
+static hb_u32 sei_serialize(const mc_sei_injector_t *s,
+		const mc_sei_meta_t *meta, hb_u64 pts, hb_u64 seq, hb_u8 *out)
+{
+	char *p = (char *)out + SEI_PREFIX_SIZE;
+	size_t left = MC_SEI_PAYLOAD_MAX - SEI_PREFIX_SIZE;
+	int n;
+
+	memcpy(out, s->prefix, SEI_PREFIX_SIZE);
+	n = snprintf(p, left, SEI_MAGIC ";s=%llu;p=%llu",
+		(unsigned long long)seq, (unsigned long long)pts);
+	if ((n < 0) || ((size_t)n >= left)) {
+		return 0;
+	}
+	p += n;
+	left -= (size_t)n;
+	if (meta->flags & MC_SEI_META_TIME) {
+		n = snprintf(p, left, ";t=%llu",
+			(unsigned long long)meta->capture_time_us);
+		if ((n < 0) || ((size_t)n >= left)) {
+			return 0;
+		}
+		p += n;
+		left -= (size_t)n;
+	}
+	if (meta->flags & MC_SEI_META_GPS) {
+		n = snprintf(p, left, ";g=%d,%d,%d", meta->latitude_e7,
+			meta->longitude_e7, meta->altitude_mm);
+		if ((n < 0) || ((size_t)n >= left)) {
+			return 0;
+		}
+		p += n;
+		left -= (size_t)n;
+	}
+	if (meta->flags & MC_SEI_META_SENSOR) {
+		n = snprintf(p, left, ";i=%u", meta->sensor_id);
+		if ((n < 0) || ((size_t)n >= left)) {
+			return 0;
+		}
+		p += n;
+	}
+
+	return (hb_u32)((p + 1) - (char *)out);
+}
+
+hb_s32 hb_mm_sei_attach(mc_sei_injector_t *inj,
+		const media_codec_buffer_t *buffer, const mc_sei_meta_t *meta)
+{
+	hb_u32 slot, size;
+	hb_u64 pic;
+	hb_s32 ret;
+
+	if ((inj == NULL) || (buffer == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(inj=%p, buffer=%p).\n",
+			TAG, __FUNCTION__, __LINE__, inj, buffer);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	pic = inj->queued++;
+	if (meta == NULL) {
+		return 0;
+	}
+	if (inj->used == inj->params.pool_size) {
+		inj->stats.pool_exhausted++;
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+
+	/* used < pool_size, so a free slot is left */
+	slot = 0;
+	while (inj->slot_used[slot]) {
+		slot++;
+	}
+	size = sei_serialize(inj, meta, buffer->vframe_buf.pts, pic,
+		inj->pool[slot]);
+	if (size == 0) {
+		VLOG(ERR, "%s <%s:%d> Metadata of picture %llu is too long.\n",
+			TAG, __FUNCTION__, __LINE__, (unsigned long long)pic);
+		inj->stats.insert_failures++;
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	ret = hb_mm_mc_insert_user_data(inj->context, inj->pool[slot], size);
+	if (ret < 0) {
+		VLOG(ERR, "%s <%s:%d> Failed to insert %u bytes user data(%d).\n",
+			TAG, __FUNCTION__, __LINE__, size, ret);
+		inj->stats.insert_failures++;
+		return ret;
+	}
+	inj->slot_pts[slot] = buffer->vframe_buf.pts;
+	inj->slot_used[slot] = TRUE;
+	inj->used++;
+	inj->stats.injected++;
+	if (size > inj->stats.max_payload) {
+		inj->stats.max_payload = size;
+	}
+
+	return 0;
+}
+
+hb_s32 hb_mm_sei_frame_done(mc_sei_injector_t *inj,
+		const media_codec_buffer_t *output)
+{
+	hb_u32 slot;
+
+	if ((inj == NULL) || (output == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (output->vstream_buf.stream_end) {
+		return 0;
+	}
+	/* pictures may leave the encoder out of order, the pts tells which */
+	for (slot = 0; slot < inj->params.pool_size; slot++) {
+		if (inj->slot_used[slot] &&
+			(inj->slot_pts[slot] == output->vstream_buf.pts)) {
+			inj->slot_used[slot] = FALSE;
+			inj->used--;
+			break;
+		}
+	}
+
+	return 0;
+}
+
+hb_s32 hb_mm_sei_injector_get_stats(mc_sei_injector_t *inj,
+		mc_sei_stats_t *stats)
+{
+	if ((inj == NULL) || (stats == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	*stats = inj->stats;
+
+	return 0;
+}
+
+hb_s32 hb_mm_sei_injector_destroy(mc_sei_injector_t *inj)
+{
+	if (inj == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	free(inj);
+
+	return 0;
+}
+
+hb_s32 hb_mm_sei_extractor_create(media_codec_context_t *context,
+		const mc_sei_params_t *params, mc_sei_extractor_t **ext)
+{
+	mc_sei_extractor_t *e;
+
+	if ((context == NULL) || (params == NULL) || (ext == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(context=%p, params=%p).\n",
+			TAG, __FUNCTION__, __LINE__, context, params);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (context->encoder || !sei_codec_supported(context)) {
+		VLOG(ERR, "%s <%s:%d> The instance isn't an H264/H265 decoder.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_INSTANCE;
+	}
+
+	e = (mc_sei_extractor_t *)calloc(1, sizeof(*e));
+	if (e == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	e->context = context;
+	e->params = *params;
+
+	*ext = e;
+	return 0;
+}
+
+/* The ";key=value" fields after the magic, 0 once s and p are found */
+static hb_s32 sei_parse(char *text, mc_sei_meta_t *meta)
+{
+	hb_bool seq = FALSE, pts = FALSE;
+	char *field, *value, *end;
+
+	if (*text == '+') {
+		text++;
+	}
+	if (strncmp(text, SEI_MAGIC, strlen(SEI_MAGIC)) != 0) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	memset(meta, 0x00, sizeof(*meta));
+	field = strchr(text, ';');
+	while (field != NULL) {
+		field++;
+		end = strchr(field, ';');
+		if (end != NULL) {
+			*end = '\0';
+		}
+		if ((field[0] == '\0') || (field[1] != '=')) {
+			return HB_MEDIA_ERR_INVALID_PARAMS;
+		}
+		value = field + 2;
+		switch (field[0]) {
+		case 's':
+			meta->frame_seq = strtoull(value, NULL, 10);
+			seq = TRUE;
+			break;
+		case 'p':
+			meta->pts = strtoull(value, NULL, 10);
+			pts = TRUE;
+			break;
+		case 't':
+			meta->capture_time_us = strtoull(value, NULL, 10);
+			meta->flags |= MC_SEI_META_TIME;
+			break;
+		case 'g':
+			if (sscanf(value, "%d,%d,%d", &meta->latitude_e7,
+				&meta->longitude_e7, &meta->altitude_mm) != 3) {
+				return HB_MEDIA_ERR_INVALID_PARAMS;
+			}
+			meta->flags |= MC_SEI_META_GPS;
+			break;
+		case 'i':
+			meta->sensor_id = (hb_u32)strtoul(value, NULL, 10);
+			meta->flags |= MC_SEI_META_SENSOR;
+			break;
+		default:
+			/* fields of a later version */
+			break;
+		}
+		field = end;
+	}
+
+	return (seq && pts) ? 0 : HB_MEDIA_ERR_INVALID_PARAMS;
+}
+
+hb_s32 hb_mm_sei_extract(mc_sei_extractor_t *ext, mc_sei_meta_t *meta,
+		hb_s32 timeout)
+{
+	mc_user_data_buffer_t user_data;
+	hb_u32 len;
+	hb_s32 ret, parsed;
+
+	if ((ext == NULL) || (meta == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(ext=%p, meta=%p).\n",
+			TAG, __FUNCTION__, __LINE__, ext, meta);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	for (;;) {
+		memset(&user_data, 0x00, sizeof(user_data));
+		ret = hb_mm_mc_get_user_data(ext->context, &user_data, timeout);
+		if (ret < 0) {
+			return ret;
+		}
+		if ((user_data.virt_addr == NULL) ||
+			(user_data.size < SEI_UUID_SIZE) ||
+			(memcmp(user_data.virt_addr, ext->params.uuid,
+			SEI_UUID_SIZE) != 0)) {
+			ext->stats.foreign++;
+			hb_mm_mc_release_user_data(ext->context, &user_data);
+			continue;
+		}
+		/* the text is copied so the buffer goes back at once */
+		len = user_data.size - SEI_UUID_SIZE;
+		len = (len > MC_SEI_PAYLOAD_MAX) ? MC_SEI_PAYLOAD_MAX : len;
+		memcpy(ext->text, user_data.virt_addr + SEI_UUID_SIZE, len);
+		ext->text[len] = '\0';
+		hb_mm_mc_release_user_data(ext->context, &user_data);
+		parsed = sei_parse(ext->text, meta);
+		if (parsed < 0) {
+			ext->stats.malformed++;
+			continue;
+		}
+		ext->stats.extracted++;
+		return 0;
+	}
+}
+
+hb_s32 hb_mm_sei_extractor_get_stats(mc_sei_extractor_t *ext,
+		mc_sei_stats_t *stats)
+{
+	if ((ext == NULL) || (stats == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	*stats = ext->stats;
+
+	return 0;
+}
+
+hb_s32 hb_mm_sei_extractor_destroy(mc_sei_extractor_t *ext)
+{
+	if (ext == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	free(ext);
+
+	return 0;
+}
@@ -0,0 +1,492 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hb_media_session.h"
+#include "media_common.h"
+
+#define TAG "[MEDIASESSION]"
+
+typedef enum _session_slot_state {
+	SESSION_SLOT_FREE = 0,
+	SESSION_SLOT_IDLE,
+	SESSION_SLOT_USED,
+	/* Being set up or recycled without the lock */
+	SESSION_SLOT_BUSY,
+} session_slot_state_t;
+
+typedef struct _session_slot {
+	media_codec_context_t *context;
+	session_slot_state_t state;
+	/* Hand out time, and whether the instance was ready by then */
+	hb_u64 acquire_us;
+	hb_bool ready;
+	hb_bool first_frame;
+	/* Last time it became idle, the oldest idle instance goes first */
+	hb_u64 idle_us;
+} session_slot_t;
+
+struct _mc_session_manager {
+	mc_session_params_t params;
+	pthread_mutex_t lock;
+	session_slot_t slots[MC_SESSION_MAX_INSTANCES];
+	mc_session_stats_t stats;
+};
+
+static hb_u64 session_get_time_us(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+	return ((hb_u64)tp.tv_sec * 1000000) + ((hb_u64)tp.tv_nsec / 1000);
+}
+
+static hb_bool session_check_template(const media_codec_context_t *tmpl)
+{
+	return (tmpl != NULL) && tmpl->encoder &&
+		((tmpl->codec_id == MEDIA_CODEC_ID_H264) ||
+		(tmpl->codec_id == MEDIA_CODEC_ID_H265) ||
+		(tmpl->codec_id == MEDIA_CODEC_ID_MJPEG) ||
+		(tmpl->codec_id == MEDIA_CODEC_ID_JPEG));
+}
+
+static hb_bool session_same_shape(const media_codec_context_t *a,
+		const media_codec_context_t *b)
+{
+	const mc_video_codec_enc_params_t *pa = &a->video_enc_params;
+	const mc_video_codec_enc_params_t *pb = &b->video_enc_params;
+
+	return (a->codec_id == b->codec_id) && (pa->width == pb->width) &&
+		(pa->height == pb->height) && (pa->pix_fmt == pb->pix_fmt) &&
+		(pa->frame_buf_count == pb->frame_buf_count) &&
+		(pa->bitstream_buf_count == pb->bitstream_buf_count) &&
+		(pa->external_frame_buf == pb->external_frame_buf);
+}
+
+static hb_bool session_same_params(const media_codec_context_t *a,
+		const media_codec_context_t *b)
+{
+	return session_same_shape(a, b) && (memcmp(&a->video_enc_params,
+		&b->video_enc_params, sizeof(a->video_enc_params)) == 0);
+}
+
+static void session_release_context(media_codec_context_t *context)
+{
+	hb_s32 ret;
+
+	ret = hb_mm_mc_release(context);
+	if (ret < 0) {
+		VLOG(WARN, "%s <%s:%d> Fail to release instance %d(ret=%d).\n",
+			TAG, __FUNCTION__, __LINE__, context->instance_index, ret);
+	}
+	free(context);
+}
+
+/* Initialize and configure a new instance of the template */
+static hb_s32 session_create_context(const media_codec_context_t *tmpl,
+		media_codec_context_t **context)
+{
+	media_codec_context_t *c;
+	hb_s32 ret;
+
+	c = (media_codec_context_t *)calloc(1, sizeof(*c));
+	if (c == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	c->codec_id = tmpl->codec_id;
+	c->encoder = TRUE;
+	c->video_enc_params = tmpl->video_enc_params;
+	ret = hb_mm_mc_initialize(c);
+	if (ret < 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to initialize the encoder(ret=%d).\n",
+			TAG, __FUNCTION__, __LINE__, ret);
+		free(c);
+		return ret;
+	}
+	ret = hb_mm_mc_configure(c);
+	if (ret < 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to configure the encoder(ret=%d).\n",
+			TAG, __FUNCTION__, __LINE__, ret);
+		session_release_context(c);
+		return ret;
+	}
+
+	*context = c;
+	return 0;
+}
+
+/* Find an idle instance, the same parameters before the same shape */
+static session_slot_t *session_find_idle(mc_session_manager_t *mgr,
+		const media_codec_context_t *tmpl, hb_bool *ready)
+{
+	session_slot_t *slot, *shape = NULL;
+	hb_s32 i;
+
+	for (i = 0; i < MC_SESSION_MAX_INSTANCES; i++) {
+		slot = &mgr->slots[i];
+		if (slot->state != SESSION_SLOT_IDLE) {
+			continue;
+		}
+		if (session_same_params(slot->context, tmpl)) {
+			*ready = TRUE;
+			return slot;
+		}
+		if ((shape == NULL) && session_same_shape(slot->context, tmpl)) {
+			shape = slot;
+		}
+	}
+	*ready = FALSE;
+
+	return shape;
+}
+
+/* A free slot, or the oldest idle one of another shape to evict */
+static session_slot_t *session_find_free(mc_session_manager_t *mgr)
+{
+	session_slot_t *slot, *oldest = NULL;
+	hb_s32 i;
+
+	for (i = 0; i < MC_SESSION_MAX_INSTANCES; i++) {
+		slot = &mgr->slots[i];
+		if (slot->state == SESSION_SLOT_FREE) {
+			return slot;
+		}
+		if ((slot->state == SESSION_SLOT_IDLE) &&
+			((oldest == NULL) || (slot->idle_us < oldest->idle_us))) {
+			oldest = slot;
+		}
+	}
+
+	return oldest;
+}
+
+static session_slot_t *session_find_used(mc_session_manager_t *mgr,
+		const media_codec_context_t *context)
+{
+	hb_s32 i;
+
+	for (i = 0; i < MC_SESSION_MAX_INSTANCES; i++) {
+		if ((mgr->slots[i].state == SESSION_SLOT_USED) &&
+			(mgr->slots[i].context == context)) {
+			return &mgr->slots[i];
+		}
+	}
+
+	return NULL;
+}
+
+hb_s32 hb_mm_session_create(const mc_session_params_t *params,
+		mc_session_manager_t **mgr)
+{
+	mc_session_manager_t *m;
+
+	if ((params == NULL) || (mgr == NULL) ||
+		(params->max_idle > MC_SESSION_MAX_INSTANCES)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(params=%p).\n",
+			TAG, __FUNCTION__, __LINE__, params);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	m = (mc_session_manager_t *)calloc(1, sizeof(*m));
+	if (m == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	m->params = *params;
+	pthread_mutex_init(&m->lock, NULL);
+
+	*mgr = m;
+	return 0;
+}
+
+hb_s32 hb_mm_session_prewarm(mc_session_manager_t *mgr,
+		const media_codec_context_t *tmpl, hb_u32 num)
+{
+	session_slot_t *slot;
+	media_codec_context_t *context = NULL;
+	hb_u32 i, have = 0;
+	hb_s32 ret = 0;
+
+	if ((mgr == NULL) || !session_check_template(tmpl)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(mgr=%p, tmpl=%p).\n",
+			TAG, __FUNCTION__, __LINE__, mgr, tmpl);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	pthread_mutex_lock(&mgr->lock);
+	for (i = 0; i < MC_SESSION_MAX_INSTANCES; i++) {
+		slot = &mgr->slots[i];
+		if ((slot->state == SESSION_SLOT_IDLE) &&
+			session_same_params(slot->context, tmpl)) {
+			have++;
+		}
+	}
+	while ((have < num) && (ret == 0)) {
+		slot = NULL;
+		for (i = 0; i < MC_SESSION_MAX_INSTANCES; i++) {
+			if (mgr->slots[i].state == SESSION_SLOT_FREE) {
+				slot = &mgr->slots[i];
+				break;
+			}
+		}
+		if ((slot == NULL) || (mgr->stats.idle_num >= mgr->params.max_idle)) {
+			VLOG(ERR, "%s <%s:%d> No room for %u idle instances.\n",
+				TAG, __FUNCTION__, __LINE__, num);
+			ret = HB_MEDIA_ERR_INSUFFICIENT_RES;
+			break;
+		}
+		slot->state = SESSION_SLOT_BUSY;
+		pthread_mutex_unlock(&mgr->lock);
+		ret = session_create_context(tmpl, &context);
+		pthread_mutex_lock(&mgr->lock);
+		if (ret == 0) {
+			slot->context = context;
+			slot->state = SESSION_SLOT_IDLE;
+			slot->idle_us = session_get_time_us();
+			mgr->stats.idle_num++;
+			have++;
+		} else {
+			slot->state = SESSION_SLOT_FREE;
+		}
+	}
+	pthread_mutex_unlock(&mgr->lock);
+
+	return ret;
+}
+
+hb_s32 hb_mm_session_acquire(mc_session_manager_t *mgr,
+		const media_codec_context_t *tmpl, media_codec_context_t **context)
+{
+	session_slot_t *slot;
+	media_codec_context_t *evict = NULL, *c = NULL;
+	hb_u64 start, cost;
+	hb_bool ready = FALSE, reuse;
+	hb_s32 ret = 0;
+
+	if ((mgr == NULL) || (context == NULL) || !session_check_template(tmpl)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(mgr=%p, tmpl=%p).\n",
+			TAG, __FUNCTION__, __LINE__, mgr, tmpl);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	start = session_get_time_us();
+	pthread_mutex_lock(&mgr->lock);
+	slot = session_find_idle(mgr, tmpl, &ready);
+	reuse = (slot != NULL);
+	if (!reuse) {
+		slot = session_find_free(mgr);
+		if (slot == NULL) {
+			pthread_mutex_unlock(&mgr->lock);
+			VLOG(ERR, "%s <%s:%d> All %d instances are in use.\n",
+				TAG, __FUNCTION__, __LINE__, MC_SESSION_MAX_INSTANCES);
+			return HB_MEDIA_ERR_NO_FREE_INSTANCE;
+		}
+		if (slot->state == SESSION_SLOT_IDLE) {
+			evict = slot->context;
+			mgr->stats.evicted++;
+		}
+	}
+	if (slot->state == SESSION_SLOT_IDLE) {
+		mgr->stats.idle_num--;
+	}
+	if (ready) {
+		slot->state = SESSION_SLOT_USED;
+		c = slot->context;
+	} else {
+		slot->state = SESSION_SLOT_BUSY;
+	}
+	pthread_mutex_unlock(&mgr->lock);
+
+	if (evict != NULL) {
+		session_release_context(evict);
+	}
+	if (reuse && !ready) {
+		/* same buffers, only the parameters change */
+		c = slot->context;
+		c->video_enc_params = tmpl->video_enc_params;
+		ret = hb_mm_mc_configure(c);
+		if (ret < 0) {
+			VLOG(WARN, "%s <%s:%d> Fail to configure instance %d again"
+				"(ret=%d), initialize a new one.\n", TAG, __FUNCTION__,
+				__LINE__, c->instance_index, ret);
+			session_release_context(c);
+			c = NULL;
+			reuse = FALSE;
+		}
+	}
+	if (!reuse) {
+		ret = session_create_context(tmpl, &c);
+	}
+	cost = session_get_time_us() - start;
+
+	pthread_mutex_lock(&mgr->lock);
+	if (ret < 0) {
+		slot->context = NULL;
+		slot->state = SESSION_SLOT_FREE;
+		if (reuse) {
+			mgr->stats.evicted++;
+		}
+		pthread_mutex_unlock(&mgr->lock);
+		return ret;
+	}
+	slot->context = c;
+	slot->state = SESSION_SLOT_USED;
+	slot->acquire_us = start;
+	slot->ready = ready;
+	slot->first_frame = FALSE;
+	mgr->stats.used_num++;
+	if (ready) {
+		mgr->stats.ready++;
+		mgr->stats.ready_cost_us += cost;
+	} else {
+		if (reuse) {
+			mgr->stats.reconfigured++;
+		} else {
+			mgr->stats.cold++;
+		}
+		mgr->stats.cold_cost_us += cost;
+	}
+	pthread_mutex_unlock(&mgr->lock);
+
+	*context = c;
+	return 0;
+}
+
+hb_s32 hb_mm_session_first_frame(mc_session_manager_t *mgr,
+		media_codec_context_t *context)
+{
+	session_slot_t *slot;
+	hb_u64 ttff;
+
+	if ((mgr == NULL) || (context == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	pthread_mutex_lock(&mgr->lock);
+	slot = session_find_used(mgr, context);
+	if (slot == NULL) {
+		pthread_mutex_unlock(&mgr->lock);
+		return HB_MEDIA_ERR_INVALID_INSTANCE;
+	}
+	if (!slot->first_frame) {
+		slot->first_frame = TRUE;
+		ttff = session_get_time_us() - slot->acquire_us;
+		if (slot->ready) {
+			mgr->stats.ready_ttff_us += ttff;
+			mgr->stats.ready_ttff_num++;
+		} else {
+			mgr->stats.cold_ttff_us += ttff;
+			mgr->stats.cold_ttff_num++;
+		}
+	}
+	pthread_mutex_unlock(&mgr->lock);
+
+	return 0;
+}
+
+hb_s32 hb_mm_session_release(mc_session_manager_t *mgr,
+		media_codec_context_t *context)
+{
+	media_codec_state_t state = MEDIA_CODEC_STATE_NONE;
+	session_slot_t *slot;
+	hb_bool keep, counted;
+	hb_s32 ret = 0;
+
+	if ((mgr == NULL) || (context == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	pthread_mutex_lock(&mgr->lock);
+	slot = session_find_used(mgr, context);
+	if (slot == NULL) {
+		pthread_mutex_unlock(&mgr->lock);
+		VLOG(ERR, "%s <%s:%d> Context %p isn't from the manager.\n",
+			TAG, __FUNCTION__, __LINE__, context);
+		return HB_MEDIA_ERR_INVALID_INSTANCE;
+	}
+	slot->state = SESSION_SLOT_BUSY;
+	mgr->stats.used_num--;
+	keep = (mgr->stats.idle_num < mgr->params.max_idle);
+	counted = keep;
+	if (keep) {
+		/* counted now so concurrent releases respect max_idle */
+		mgr->stats.idle_num++;
+	}
+	pthread_mutex_unlock(&mgr->lock);
+
+	if (keep) {
+		hb_mm_mc_get_state(context, &state);
+		if ((state == MEDIA_CODEC_STATE_STARTED) ||
+			(state == MEDIA_CODEC_STATE_PAUSED)) {
+			ret = hb_mm_mc_stop(context);
+		}
+		if (ret >= 0) {
+			ret = hb_mm_mc_configure(context);
+		}
+		if (ret < 0) {
+			VLOG(WARN, "%s <%s:%d> Fail to recycle instance %d(ret=%d).\n",
+				TAG, __FUNCTION__, __LINE__, context->instance_index, ret);
+			keep = FALSE;
+		}
+	}
+	if (!keep) {
+		session_release_context(context);
+	}
+
+	pthread_mutex_lock(&mgr->lock);
+	if (keep) {
+		slot->state = SESSION_SLOT_IDLE;
+		slot->idle_us = session_get_time_us();
+	} else {
+		if (counted) {
+			mgr->stats.idle_num--;
+		}
+		slot->context = NULL;
+		slot->state = SESSION_SLOT_FREE;
+		mgr->stats.evicted++;
+	}
+	pthread_mutex_unlock(&mgr->lock);
+
+	return 0;
+}
+
+hb_s32 hb_mm_session_get_stats(mc_session_manager_t *mgr,
+		mc_session_stats_t *stats)
+{
+	if ((mgr == NULL) || (stats == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	pthread_mutex_lock(&mgr->lock);
+	*stats = mgr->stats;
+	pthread_mutex_unlock(&mgr->lock);
+
+	return 0;
+}
+
+hb_s32 hb_mm_session_destroy(mc_session_manager_t *mgr)
+{
+	hb_s32 i;
+
+	if (mgr == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	pthread_mutex_lock(&mgr->lock);
+	if (mgr->stats.used_num > 0) {
+		pthread_mutex_unlock(&mgr->lock);
+		VLOG(ERR, "%s <%s:%d> %u instances are still in use.\n",
+			TAG, __FUNCTION__, __LINE__, mgr->stats.used_num);
+		return HB_MEDIA_ERR_OPERATION_NOT_ALLOWED;
+	}
+	pthread_mutex_unlock(&mgr->lock);
+	for (i = 0; i < MC_SESSION_MAX_INSTANCES; i++) {
+		if (mgr->slots[i].state == SESSION_SLOT_IDLE) {
+			session_release_context(mgr->slots[i].context);
+		}
+	}
+	pthread_mutex_destroy(&mgr->lock);
+	free(mgr);
+
+	return 0;
+}
@@ -0,0 +1,69 @@
+#include "media_common.h"
+#include "media_simd.h"
+
+static mc_simd_isa_t g_simd_detected = MC_SIMD_ISA_NONE;
+static mc_simd_isa_t g_simd_cap = MC_SIMD_ISA_NONE;
+
+static mc_simd_isa_t simd_detect(void)
+{
+#if defined(MEDIA_SIMD_NEON)
+	return MC_SIMD_ISA_NEON;
+#elif defined(MEDIA_SIMD_X86)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return MC_SIMD_ISA_AVX2;
+	}
+	return MC_SIMD_ISA_SSE2;
+#else
+	return MC_SIMD_ISA_C;
+#endif
+}
+
+mc_simd_isa_t media_simd_isa(void)
+{
+	mc_simd_isa_t isa = g_simd_detected;
+	mc_simd_isa_t cap = g_simd_cap;
+
+	if (isa == MC_SIMD_ISA_NONE) {
+		isa = simd_detect();
+		g_simd_detected = isa;
+	}
+	if (cap == MC_SIMD_ISA_NONE) {
+		return isa;
+	}
+	/* NEON and the x86 sets never mix, the C kernels are always there */
+	if ((cap == MC_SIMD_ISA_C) || ((isa == MC_SIMD_ISA_NEON) !=
+		(cap == MC_SIMD_ISA_NEON))) {
+		return MC_SIMD_ISA_C;
+	}
+	return (cap < isa) ? cap : isa;
+}
+
+mc_simd_isa_t hb_mm_simd_get_isa(void)
+{
+	return media_simd_isa();
+}
+
+void hb_mm_simd_set_isa(mc_simd_isa_t isa)
+{
+	if ((isa < MC_SIMD_ISA_NONE) || (isa >= MC_SIMD_ISA_TOTAL)) {
+		isa = MC_SIMD_ISA_NONE;
+	}
+	g_simd_cap = isa;
+}
+
+const char *hb_mm_simd_isa_name(mc_simd_isa_t isa)
+{
+	switch (isa) {
+	case MC_SIMD_ISA_C:
+		return "c";
+	case MC_SIMD_ISA_SSE2:
+		return "sse2";
+	case MC_SIMD_ISA_AVX2:
+		return "avx2";
+	case MC_SIMD_ISA_NEON:
+		return "neon";
+	default:
+		return "none";
+	}
+}
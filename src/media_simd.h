@@ -0,0 +1,26 @@
+#ifndef MEDIA_SIMD_H
+#define MEDIA_SIMD_H
+
+#include "hb_media_simd.h"
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#define MEDIA_SIMD_NEON 1
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(__SSE2__)
+#define MEDIA_SIMD_X86 1
+#include <immintrin.h>
+/* AVX2 kernels are built per function and picked at run time */
+#define MEDIA_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* The instruction set the kernels should use for this call. */
+extern mc_simd_isa_t media_simd_isa(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* MEDIA_SIMD_H */
@@ -0,0 +1,245 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hb_media_simulcast.h"
+#include "media_common.h"
+
+#define TAG "[MEDIASIMULCAST]"
+
+typedef struct _sc_output {
+	media_codec_context_t *context;
+	/* NULL when the instance encodes at the source size */
+	mc_scaler_t *scaler;
+	media_codec_buffer_t buffer;
+	hb_bool held;
+} sc_output_t;
+
+struct _mc_simulcast {
+	mc_simulcast_params_t params;
+	sc_output_t outputs[MC_SIMULCAST_MAX_OUTPUTS];
+	hb_s32 num;
+	mc_simulcast_stats_t stats;
+};
+
+static hb_u64 sc_get_time_us(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+	return ((hb_u64)tp.tv_sec * 1000000) + ((hb_u64)tp.tv_nsec / 1000);
+}
+
+/* Dequeue every missing input buffer, keep the ones already held */
+static hb_s32 sc_dequeue_all(mc_simulcast_t *sc)
+{
+	sc_output_t *out;
+	hb_s32 i, ret;
+
+	for (i = 0; i < sc->num; i++) {
+		out = &sc->outputs[i];
+		if (out->held) {
+			continue;
+		}
+		memset(&out->buffer, 0x00, sizeof(out->buffer));
+		ret = hb_mm_mc_dequeue_input_buffer(out->context, &out->buffer,
+			sc->params.timeout);
+		if (ret != 0) {
+			return ret;
+		}
+		out->held = TRUE;
+	}
+
+	return 0;
+}
+
+static hb_s32 sc_queue_all(mc_simulcast_t *sc)
+{
+	sc_output_t *out;
+	hb_s32 i, ret = 0, err;
+
+	for (i = 0; i < sc->num; i++) {
+		out = &sc->outputs[i];
+		err = hb_mm_mc_queue_input_buffer(out->context, &out->buffer,
+			sc->params.timeout);
+		if (err != 0) {
+			VLOG(ERR, "%s <%s:%d> Failed to queue input buffer of instance "
+				"%d(%d).\n", TAG, __FUNCTION__, __LINE__, i, err);
+			ret = err;
+		}
+		out->held = FALSE;
+	}
+
+	return ret;
+}
+
+hb_s32 hb_mm_simulcast_create(const mc_simulcast_params_t *params,
+		media_codec_context_t **contexts, hb_s32 num, mc_simulcast_t **sc)
+{
+	mc_video_codec_enc_params_t *enc;
+	mc_simulcast_t *s;
+	hb_s32 i, ret;
+
+	if ((params == NULL) || (contexts == NULL) || (sc == NULL) ||
+		(num <= 0) || (num > MC_SIMULCAST_MAX_OUTPUTS) ||
+		(params->src_width <= 0) || (params->src_height <= 0)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(params=%p, num=%d).\n",
+			TAG, __FUNCTION__, __LINE__, params, num);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	for (i = 0; i < num; i++) {
+		if ((contexts[i] == NULL) || !contexts[i]->encoder) {
+			VLOG(ERR, "%s <%s:%d> Instance %d isn't an encoder.\n",
+				TAG, __FUNCTION__, __LINE__, i);
+			return HB_MEDIA_ERR_INVALID_INSTANCE;
+		}
+	}
+
+	s = (mc_simulcast_t *)calloc(1, sizeof(*s));
+	if (s == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	s->params = *params;
+	s->num = num;
+	for (i = 0; i < num; i++) {
+		s->outputs[i].context = contexts[i];
+		enc = &contexts[i]->video_enc_params;
+		if ((enc->width == params->src_width) &&
+			(enc->height == params->src_height)) {
+			continue;
+		}
+		ret = hb_mm_scaler_create(params->src_width, params->src_height,
+			enc->width, enc->height, params->filter, &s->outputs[i].scaler);
+		if (ret != 0) {
+			hb_mm_simulcast_destroy(s);
+			return ret;
+		}
+	}
+
+	*sc = s;
+	return 0;
+}
+
+hb_s32 hb_mm_simulcast_feed(mc_simulcast_t *sc, mc_pixel_format_t src_fmt,
+		const mc_video_planes_t *src, hb_u64 pts)
+{
+	mc_video_codec_enc_params_t *enc;
+	mc_video_frame_buffer_info_t *frame;
+	sc_output_t *out;
+	hb_u64 start, cost;
+	hb_s32 i, ret;
+
+	if ((sc == NULL) || (src == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(sc=%p, src=%p).\n",
+			TAG, __FUNCTION__, __LINE__, sc, src);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	ret = sc_dequeue_all(sc);
+	if (ret != 0) {
+		sc->stats.stalls++;
+		return ret;
+	}
+
+	for (i = 0; i < sc->num; i++) {
+		out = &sc->outputs[i];
+		enc = &out->context->video_enc_params;
+		frame = &out->buffer.vframe_buf;
+		if ((frame->width <= 0) || (frame->height <= 0)) {
+			frame->width = enc->width;
+			frame->height = enc->height;
+		}
+		frame->pix_fmt = enc->pix_fmt;
+		start = sc_get_time_us();
+		if (out->scaler != NULL) {
+			ret = hb_mm_scaler_process(out->scaler, src_fmt, src, frame);
+		} else {
+			ret = hb_mm_pixfmt_convert(src_fmt, src, frame);
+		}
+		cost = sc_get_time_us() - start;
+		if (ret != 0) {
+			/* the buffers stay held and get the next picture */
+			VLOG(ERR, "%s <%s:%d> Failed to scale for instance %d(%d).\n",
+				TAG, __FUNCTION__, __LINE__, i, ret);
+			return ret;
+		}
+		sc->stats.scale_us[i] += cost;
+		if (cost > sc->stats.max_scale_us[i]) {
+			sc->stats.max_scale_us[i] = cost;
+		}
+		frame->pts = pts;
+		frame->frame_end = FALSE;
+	}
+
+	ret = sc_queue_all(sc);
+	if (ret == 0) {
+		sc->stats.frames++;
+	}
+
+	return ret;
+}
+
+hb_s32 hb_mm_simulcast_end(mc_simulcast_t *sc)
+{
+	hb_s32 i, ret;
+
+	if (sc == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	ret = sc_dequeue_all(sc);
+	if (ret != 0) {
+		return ret;
+	}
+	for (i = 0; i < sc->num; i++) {
+		sc->outputs[i].buffer.vframe_buf.size = 0;
+		sc->outputs[i].buffer.vframe_buf.frame_end = TRUE;
+	}
+
+	return sc_queue_all(sc);
+}
+
+hb_s32 hb_mm_simulcast_get_stats(mc_simulcast_t *sc,
+		mc_simulcast_stats_t *stats)
+{
+	if ((sc == NULL) || (stats == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	*stats = sc->stats;
+
+	return 0;
+}
+
+hb_s32 hb_mm_simulcast_destroy(mc_simulcast_t *sc)
+{
+	sc_output_t *out;
+	hb_s32 i, ret;
+
+	if (sc == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	/* buffers held after a stall go back to their encoders empty */
+	for (i = 0; i < sc->num; i++) {
+		out = &sc->outputs[i];
+		if (!out->held) {
+			continue;
+		}
+		out->buffer.vframe_buf.size = 0;
+		out->buffer.vframe_buf.frame_end = FALSE;
+		ret = hb_mm_mc_queue_input_buffer(out->context, &out->buffer,
+			sc->params.timeout);
+		if (ret != 0) {
+			VLOG(ERR, "%s <%s:%d> Failed to give back input buffer of "
+				"instance %d(%d).\n", TAG, __FUNCTION__, __LINE__, i, ret);
+		}
+		out->held = FALSE;
+	}
+	for (i = 0; i < MC_SIMULCAST_MAX_OUTPUTS; i++) {
+		if (sc->outputs[i].scaler != NULL) {
+			hb_mm_scaler_destroy(sc->outputs[i].scaler);
+		}
+	}
+	free(sc);
+
+	return 0;
+}
@@ -0,0 +1,219 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hb_media_skip.h"
+#include "media_block.h"
+#include "media_common.h"
+
+#define TAG "[MEDIASKIP]"
+
+struct _mc_skip_detector {
+	mc_skip_params_t params;
+	/* Luma of the last encoded picture */
+	hb_u8 *ref;
+	hb_bool has_ref;
+	hb_u32 *sad;
+	hb_s32 blocks_x;
+	hb_s32 blocks_y;
+	hb_u32 skip_run;
+	mc_skip_stats_t stats;
+};
+
+static hb_u64 skip_get_time_us(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+	return ((hb_u64)tp.tv_sec * 1000000) + ((hb_u64)tp.tv_nsec / 1000);
+}
+
+static hb_bool skip_params_valid(const mc_skip_params_t *params)
+{
+	return (params->block_sad_threshold > 0) &&
+		(params->changed_permille <= 1000);
+}
+
+/*
+ * Count the changed blocks, stopping once the limit is passed. Moving
+ * pictures cost one block row more than the limit, not the whole picture.
+ */
+static hb_u32 skip_count_changed(mc_skip_detector_t *det, const hb_u8 *luma,
+		hb_s32 stride, hb_u32 limit)
+{
+	const mc_skip_params_t *p = &det->params;
+	media_block_kernels_t k;
+	hb_s32 bx, by, rows, cols;
+	hb_u32 changed = 0, thr;
+
+	media_block_get_kernels(&k);
+	for (by = 0; by < det->blocks_y; by++) {
+		rows = p->height - (by * MEDIA_BLOCK_SIZE);
+		rows = (rows > MEDIA_BLOCK_SIZE) ? MEDIA_BLOCK_SIZE : rows;
+		k.sad(luma + ((size_t)by * MEDIA_BLOCK_SIZE * stride), stride,
+			det->ref + ((size_t)by * MEDIA_BLOCK_SIZE * p->width), p->width,
+			p->width, rows, det->sad);
+		for (bx = 0; bx < det->blocks_x; bx++) {
+			cols = p->width - (bx * MEDIA_BLOCK_SIZE);
+			cols = (cols > MEDIA_BLOCK_SIZE) ? MEDIA_BLOCK_SIZE : cols;
+			thr = (hb_u32)(((hb_u64)p->block_sad_threshold * rows * cols) /
+				(MEDIA_BLOCK_SIZE * MEDIA_BLOCK_SIZE));
+			if (det->sad[bx] > thr) {
+				changed++;
+			}
+		}
+		if (changed > limit) {
+			break;
+		}
+	}
+
+	return changed;
+}
+
+hb_s32 hb_mm_skip_create(const mc_skip_params_t *params,
+		mc_skip_detector_t **det)
+{
+	mc_skip_detector_t *d;
+
+	if ((params == NULL) || (det == NULL) || (params->width <= 0) ||
+		(params->height <= 0) || !skip_params_valid(params)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(params=%p).\n",
+			TAG, __FUNCTION__, __LINE__, params);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	d = (mc_skip_detector_t *)calloc(1, sizeof(*d));
+	if (d == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	d->params = *params;
+	d->blocks_x = (params->width + MEDIA_BLOCK_SIZE - 1) / MEDIA_BLOCK_SIZE;
+	d->blocks_y = (params->height + MEDIA_BLOCK_SIZE - 1) / MEDIA_BLOCK_SIZE;
+	d->ref = (hb_u8 *)malloc((size_t)params->width * params->height);
+	d->sad = (hb_u32 *)malloc(sizeof(hb_u32) * (size_t)d->blocks_x);
+	if ((d->ref == NULL) || (d->sad == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Failed to allocate the reference picture.\n",
+			TAG, __FUNCTION__, __LINE__);
+		hb_mm_skip_destroy(d);
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+
+	*det = d;
+	return 0;
+}
+
+hb_s32 hb_mm_skip_set_params(mc_skip_detector_t *det,
+		const mc_skip_params_t *params)
+{
+	if ((det == NULL) || (params == NULL) || !skip_params_valid(params) ||
+		(params->width != det->params.width) ||
+		(params->height != det->params.height)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(det=%p, params=%p).\n",
+			TAG, __FUNCTION__, __LINE__, det, params);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	det->params = *params;
+
+	return 0;
+}
+
+hb_s32 hb_mm_skip_detect(mc_skip_detector_t *det, const hb_u8 *luma,
+		hb_s32 stride, hb_bool *skip)
+{
+	const mc_skip_params_t *p;
+	hb_u64 start, cost;
+	hb_u32 limit, changed;
+	hb_s32 y;
+
+	if ((det == NULL) || (luma == NULL) || (skip == NULL) ||
+		(stride < det->params.width)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(det=%p, luma=%p).\n",
+			TAG, __FUNCTION__, __LINE__, det, luma);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	p = &det->params;
+
+	start = skip_get_time_us();
+	*skip = FALSE;
+	if (det->has_ref) {
+		limit = (hb_u32)(((hb_u64)det->blocks_x * det->blocks_y *
+			p->changed_permille) / 1000);
+		changed = skip_count_changed(det, luma, stride, limit);
+		det->stats.last_changed_blocks = changed;
+		if (changed <= limit) {
+			if ((p->max_skip_frames == 0) ||
+				(det->skip_run < p->max_skip_frames)) {
+				*skip = TRUE;
+			} else {
+				det->stats.forced++;
+			}
+		}
+	}
+	if (*skip) {
+		det->skip_run++;
+		det->stats.skipped++;
+	} else {
+		det->skip_run = 0;
+		for (y = 0; y < p->height; y++) {
+			memcpy(det->ref + ((size_t)y * p->width),
+				luma + ((size_t)y * stride), (size_t)p->width);
+		}
+		det->has_ref = TRUE;
+	}
+	cost = skip_get_time_us() - start;
+	det->stats.frames++;
+	det->stats.cost_us += cost;
+	if (cost > det->stats.max_cost_us) {
+		det->stats.max_cost_us = cost;
+	}
+
+	return 0;
+}
+
+hb_s32 hb_mm_skip_apply(mc_skip_detector_t *det,
+		media_codec_context_t *context, media_codec_buffer_t *buffer)
+{
+	mc_video_frame_buffer_info_t *frame;
+	hb_bool skip = FALSE;
+	hb_s32 ret;
+
+	if ((det == NULL) || (context == NULL) || (buffer == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(det=%p, context=%p).\n",
+			TAG, __FUNCTION__, __LINE__, det, context);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	frame = &buffer->vframe_buf;
+	if (frame->frame_end) {
+		return 0;
+	}
+
+	ret = hb_mm_skip_detect(det, frame->vir_ptr[0],
+		(frame->stride > 0) ? frame->stride : det->params.width, &skip);
+	if ((ret == 0) && skip) {
+		ret = hb_mm_mc_skip_pic(context, frame->src_idx);
+	}
+
+	return ret;
+}
+
+hb_s32 hb_mm_skip_get_stats(mc_skip_detector_t *det, mc_skip_stats_t *stats)
+{
+	if ((det == NULL) || (stats == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	*stats = det->stats;
+
+	return 0;
+}
+
+hb_s32 hb_mm_skip_destroy(mc_skip_detector_t *det)
+{
+	if (det == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	free(det->ref);
+	free(det->sad);
+	free(det);
+
+	return 0;
+}
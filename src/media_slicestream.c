@@ -0,0 +1,411 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "hb_media_nal.h"
+#include "hb_media_slicestream.h"
+#include "media_common.h"
+
+#define TAG "[MEDIASLICESTREAM]"
+
+#define SS_RTP_HEADER_SIZE 12
+#define SS_RTP_DEFAULT_MTU 1400
+#define SS_RTP_MIN_MTU 64
+#define SS_RTP_MAX_MTU 65507
+/* FU-A indicator and header of H264, payload header and FU header of H265 */
+#define SS_FU_HEADER_MAX 3
+#define SS_H264_FU_A 28
+#define SS_H265_FU 49
+
+struct _mc_slicestream {
+	mc_slicestream_params_t params;
+	/* The picture frame_index is sent and not completed yet */
+	hb_bool open;
+	hb_u32 frame_index;
+	hb_u32 slices;
+	hb_u32 offset;
+	hb_bool key;
+	hb_u16 rtp_seq;
+	hb_u8 header[MC_SLICESTREAM_HEADER_SIZE];
+	hb_u8 rtp_header[SS_RTP_HEADER_SIZE + SS_FU_HEADER_MAX];
+	mc_slicestream_stats_t stats;
+};
+
+static void ss_put32(hb_u8 *p, hb_u32 v)
+{
+	p[0] = (hb_u8)(v >> 24);
+	p[1] = (hb_u8)(v >> 16);
+	p[2] = (hb_u8)(v >> 8);
+	p[3] = (hb_u8)v;
+}
+
+static hb_u32 ss_get32(const hb_u8 *p)
+{
+	return ((hb_u32)p[0] << 24) | ((hb_u32)p[1] << 16) |
+		((hb_u32)p[2] << 8) | (hb_u32)p[3];
+}
+
+hb_s32 hb_mm_slicestream_create(const mc_slicestream_params_t *params,
+		mc_slicestream_t **stream)
+{
+	mc_slicestream_t *s;
+
+	if ((params == NULL) || (stream == NULL) || (params->fd < 0) ||
+		(params->sink < MC_SLICESTREAM_SINK_FILE) ||
+		(params->sink >= MC_SLICESTREAM_SINK_TOTAL) ||
+		((params->codec_id != MEDIA_CODEC_ID_H264) &&
+		(params->codec_id != MEDIA_CODEC_ID_H265))) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(params=%p, stream=%p).\n",
+			TAG, __FUNCTION__, __LINE__, params, stream);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if ((params->sink == MC_SLICESTREAM_SINK_RTP) &&
+		(((params->mtu != 0) && ((params->mtu < SS_RTP_MIN_MTU) ||
+		(params->mtu > SS_RTP_MAX_MTU))) || (params->payload_type < 96) ||
+		(params->payload_type > 127))) {
+		VLOG(ERR, "%s <%s:%d> Invalid RTP mtu %u or payload type %u.\n",
+			TAG, __FUNCTION__, __LINE__, params->mtu, params->payload_type);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	s = (mc_slicestream_t *)calloc(1, sizeof(*s));
+	if (s == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	s->params = *params;
+	if (s->params.mtu == 0) {
+		s->params.mtu = SS_RTP_DEFAULT_MTU;
+	}
+
+	*stream = s;
+	return 0;
+}
+
+/* Write all of the vectors, a stream socket can take less at once */
+static hb_s32 ss_writev(mc_slicestream_t *s, struct iovec *iov, int iovcnt)
+{
+	ssize_t n;
+	int i = 0;
+
+	while (i < iovcnt) {
+		n = writev(s->params.fd, &iov[i], iovcnt - i);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			VLOG(ERR, "%s <%s:%d> Fail to write fd %d.(%s)\n",
+				TAG, __FUNCTION__, __LINE__, s->params.fd, strerror(errno));
+			s->stats.write_errors++;
+			return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+		}
+		while ((i < iovcnt) && ((size_t)n >= iov[i].iov_len)) {
+			n -= (ssize_t)iov[i].iov_len;
+			i++;
+		}
+		if (i < iovcnt) {
+			iov[i].iov_base = (hb_u8 *)iov[i].iov_base + n;
+			iov[i].iov_len -= (size_t)n;
+		}
+	}
+
+	return 0;
+}
+
+static hb_s32 ss_send_packet(mc_slicestream_t *s, hb_u32 timestamp,
+		hb_bool marker, hb_u32 fu_size, const hb_u8 *payload, hb_u32 size)
+{
+	hb_u8 *h = s->rtp_header;
+	struct iovec iov[2];
+
+	h[0] = 0x80;
+	h[1] = (hb_u8)((marker ? 0x80 : 0x00) | s->params.payload_type);
+	h[2] = (hb_u8)(s->rtp_seq >> 8);
+	h[3] = (hb_u8)s->rtp_seq;
+	ss_put32(h + 4, timestamp);
+	ss_put32(h + 8, s->params.ssrc);
+	s->rtp_seq++;
+	s->stats.packets++;
+
+	iov[0].iov_base = h;
+	iov[0].iov_len = SS_RTP_HEADER_SIZE + fu_size;
+	iov[1].iov_base = (void *)payload;
+	iov[1].iov_len = size;
+	return ss_writev(s, iov, 2);
+}
+
+/* One NAL unit, without its start code, in one packet or in fragments */
+static hb_s32 ss_send_nal(mc_slicestream_t *s, hb_u32 timestamp,
+		hb_bool marker, const hb_u8 *nal, hb_u32 size)
+{
+	hb_u32 max = s->params.mtu - SS_RTP_HEADER_SIZE;
+	hb_u8 *fu = s->rtp_header + SS_RTP_HEADER_SIZE;
+	hb_u8 unit[SS_FU_HEADER_MAX];
+	hb_u32 fu_size, chunk;
+	hb_bool first = TRUE;
+	hb_s32 ret;
+
+	if (size <= max) {
+		return ss_send_packet(s, timestamp, marker, 0, nal, size);
+	}
+
+	/* the NAL unit header goes into the FU headers */
+	if (s->params.codec_id == MEDIA_CODEC_ID_H264) {
+		unit[0] = (hb_u8)((nal[0] & 0xE0) | SS_H264_FU_A);
+		unit[1] = (hb_u8)(nal[0] & 0x1F);
+		fu_size = 2;
+		nal += 1;
+		size -= 1;
+	} else {
+		unit[0] = (hb_u8)((nal[0] & 0x81) | (SS_H265_FU << 1));
+		unit[1] = nal[1];
+		unit[2] = (hb_u8)((nal[0] >> 1) & 0x3F);
+		fu_size = 3;
+		nal += 2;
+		size -= 2;
+	}
+	s->stats.fragmented_units++;
+	while (size > 0) {
+		chunk = (size > (max - fu_size)) ? (max - fu_size) : size;
+		memcpy(fu, unit, fu_size);
+		/* start and end bits of the FU header */
+		if (first) {
+			fu[fu_size - 1] |= 0x80;
+		}
+		if (chunk == size) {
+			fu[fu_size - 1] |= 0x40;
+		}
+		ret = ss_send_packet(s, timestamp, (chunk == size) && marker,
+			fu_size, nal, chunk);
+		if (ret < 0) {
+			return ret;
+		}
+		nal += chunk;
+		size -= chunk;
+		first = FALSE;
+	}
+
+	return 0;
+}
+
+/* The marker bit goes on the last packet of the picture */
+static hb_s32 ss_send_rtp(mc_slicestream_t *s, const hb_u8 *data,
+		hb_u32 size, hb_u64 pts, hb_bool last)
+{
+	hb_u32 timestamp = (hb_u32)(pts * 90);
+	mc_nal_unit_t cur, nal;
+	hb_u32 pos = 0;
+	hb_s32 ret, more;
+
+	more = hb_mm_nal_next(s->params.codec_id, data, size, &pos, &nal);
+	while (more == 1) {
+		cur = nal;
+		more = hb_mm_nal_next(s->params.codec_id, data, size, &pos, &nal);
+		if (more < 0) {
+			return more;
+		}
+		ret = ss_send_nal(s, timestamp, last && (more == 0),
+			data + cur.offset + cur.start_code_size,
+			cur.size - cur.start_code_size);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	return (more < 0) ? more : 0;
+}
+
+static void ss_pack_header(hb_u8 *p, const mc_slice_info_t *slice)
+{
+	ss_put32(p, MC_SLICESTREAM_HEADER_MAGIC);
+	ss_put32(p + 4, slice->frame_index);
+	ss_put32(p + 8, slice->slice_idx);
+	ss_put32(p + 12, slice->slice_count);
+	ss_put32(p + 16, slice->slice_num);
+	ss_put32(p + 20, slice->offset);
+	ss_put32(p + 24, slice->size);
+	ss_put32(p + 28, (hb_u32)(slice->pts >> 32));
+	ss_put32(p + 32, (hb_u32)slice->pts);
+	ss_put32(p + 36, (slice->last ? 0x01U : 0x00U) |
+		(slice->key ? 0x02U : 0x00U));
+}
+
+hb_s32 hb_mm_slicestream_parse_header(const hb_u8 *data,
+		mc_slice_info_t *slice)
+{
+	hb_u32 flags;
+
+	if ((data == NULL) || (slice == NULL) ||
+		(ss_get32(data) != MC_SLICESTREAM_HEADER_MAGIC)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	memset(slice, 0x00, sizeof(*slice));
+	slice->frame_index = ss_get32(data + 4);
+	slice->slice_idx = ss_get32(data + 8);
+	slice->slice_count = ss_get32(data + 12);
+	slice->slice_num = ss_get32(data + 16);
+	slice->offset = ss_get32(data + 20);
+	slice->size = ss_get32(data + 24);
+	slice->pts = ((hb_u64)ss_get32(data + 28) << 32) | ss_get32(data + 32);
+	flags = ss_get32(data + 36);
+	slice->last = (flags & 0x01U) ? TRUE : FALSE;
+	slice->key = (flags & 0x02U) ? TRUE : FALSE;
+
+	return 0;
+}
+
+/* Slices of the picture the output information reports, 0 if unknown */
+static hb_u32 ss_slice_num(const mc_slicestream_t *s,
+		const media_codec_output_buffer_info_t *info)
+{
+	const mc_h264_h265_output_stream_info_t *v;
+	hb_u32 num;
+
+	if (info == NULL) {
+		return 0;
+	}
+	v = &info->video_stream_info;
+	if (s->params.codec_id == MEDIA_CODEC_ID_H265) {
+		num = v->independent_slice_num + v->dependent_slice_num;
+		if (num != 0) {
+			return num;
+		}
+	}
+	return v->slice_num;
+}
+
+hb_s32 hb_mm_slicestream_write(mc_slicestream_t *stream,
+		const media_codec_buffer_t *buffer,
+		const media_codec_output_buffer_info_t *info,
+		mc_slice_info_t *slice)
+{
+	media_codec_id_t codec_id;
+	mc_slicestream_stats_t *st;
+	mc_slice_info_t si;
+	mc_nal_unit_t nal;
+	struct iovec iov[2];
+	const hb_u8 *data;
+	hb_u32 size, pos = 0, vcl = 0, num;
+	hb_bool key = FALSE;
+	hb_s32 ret;
+
+	if ((stream == NULL) || (buffer == NULL) ||
+		((buffer->vstream_buf.vir_ptr == NULL) &&
+		(buffer->vstream_buf.size != 0))) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(stream=%p, buffer=%p).\n",
+			TAG, __FUNCTION__, __LINE__, stream, buffer);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	data = buffer->vstream_buf.vir_ptr;
+	size = buffer->vstream_buf.size;
+	if (size == 0) {
+		return 0;
+	}
+	codec_id = stream->params.codec_id;
+	st = &stream->stats;
+
+	while ((ret = hb_mm_nal_next(codec_id, data, size, &pos, &nal)) == 1) {
+		if (((codec_id == MEDIA_CODEC_ID_H264) && (nal.type >= 1) &&
+			(nal.type <= 5)) ||
+			((codec_id == MEDIA_CODEC_ID_H265) && (nal.type <= 31))) {
+			vcl++;
+			key = key || hb_mm_nal_is_key(codec_id, nal.type);
+		}
+	}
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* a first slice while slices of the last picture are missing */
+	if (stream->open && (stream->slices > 0) && (vcl > 0) && (info != NULL) &&
+		(info->video_stream_info.slice_idx == 0)) {
+		st->incomplete_frames++;
+		stream->frame_index++;
+		stream->open = FALSE;
+	}
+	if (!stream->open) {
+		stream->open = TRUE;
+		stream->slices = 0;
+		stream->offset = 0;
+		stream->key = FALSE;
+	}
+	stream->key = stream->key || key;
+	num = ss_slice_num(stream, info);
+	if (num < (stream->slices + vcl)) {
+		/* whole pictures or a slice number the buffer exceeds */
+		num = stream->slices + vcl;
+	}
+
+	memset(&si, 0x00, sizeof(si));
+	si.frame_index = stream->frame_index;
+	si.pts = buffer->vstream_buf.pts;
+	si.slice_idx = stream->slices;
+	si.slice_count = vcl;
+	si.slice_num = num;
+	si.offset = stream->offset;
+	si.size = size;
+	si.last = (vcl > 0) && ((stream->slices + vcl) >= num);
+	si.key = stream->key;
+
+	switch (stream->params.sink) {
+	case MC_SLICESTREAM_SINK_SOCKET:
+		ss_pack_header(stream->header, &si);
+		iov[0].iov_base = stream->header;
+		iov[0].iov_len = MC_SLICESTREAM_HEADER_SIZE;
+		iov[1].iov_base = (void *)data;
+		iov[1].iov_len = size;
+		ret = ss_writev(stream, iov, 2);
+		break;
+	case MC_SLICESTREAM_SINK_RTP:
+		ret = ss_send_rtp(stream, data, size, si.pts, si.last);
+		break;
+	default:
+		iov[0].iov_base = (void *)data;
+		iov[0].iov_len = size;
+		ret = ss_writev(stream, iov, 1);
+		break;
+	}
+	if (ret < 0) {
+		return ret;
+	}
+
+	stream->slices += vcl;
+	stream->offset += size;
+	st->buffers++;
+	st->bytes += size;
+	if (si.last) {
+		st->frames++;
+		if (stream->slices > st->max_slices) {
+			st->max_slices = stream->slices;
+		}
+		stream->frame_index++;
+		stream->open = FALSE;
+	}
+	if (slice != NULL) {
+		*slice = si;
+	}
+
+	return 0;
+}
+
+hb_s32 hb_mm_slicestream_get_stats(mc_slicestream_t *stream,
+		mc_slicestream_stats_t *stats)
+{
+	if ((stream == NULL) || (stats == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	*stats = stream->stats;
+
+	return 0;
+}
+
+hb_s32 hb_mm_slicestream_destroy(mc_slicestream_t *stream)
+{
+	if (stream == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	free(stream);
+
+	return 0;
+}
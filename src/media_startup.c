@@ -0,0 +1,323 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hb_media_bufpool.h"
+#include "hb_media_config.h"
+#include "hb_media_startup.h"
+#include "media_common.h"
+
+#define TAG "[MEDIASTARTUP]"
+
+/* Output dequeues of timeout ms waited for the first picture */
+#define STARTUP_OUTPUT_TRIES 100
+
+typedef struct _startup_job {
+	const mc_startup_params_t *params;
+	mc_config_snapshot_t snap;
+	hb_bool has_snap;
+	/* Bytes of a YUV420 picture of the context, read ahead of the codec */
+	hb_u32 frame_size;
+	hb_s32 fd;
+	hb_u8 *staged;
+	hb_u32 staged_size;
+	hb_s32 input_ret;
+	hb_s32 prewarm_ret;
+} startup_job_t;
+
+static hb_u64 startup_get_time_us(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+	return ((hb_u64)tp.tv_sec * 1000000) + ((hb_u64)tp.tv_nsec / 1000);
+}
+
+static hb_s32 startup_read(hb_s32 fd, hb_u8 *buf, hb_u32 size, hb_u32 *got)
+{
+	ssize_t n;
+
+	*got = 0;
+	while (*got < size) {
+		n = read(fd, buf + *got, size - *got);
+		if ((n < 0) && (errno == EINTR)) {
+			continue;
+		}
+		if (n < 0) {
+			VLOG(ERR, "%s <%s:%d> Fail to read input(%s).\n",
+				TAG, __FUNCTION__, __LINE__, strerror(errno));
+			return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+		}
+		if (n == 0) {
+			break;
+		}
+		*got += (hb_u32)n;
+	}
+	return 0;
+}
+
+/* Snapshot parsing, then the input file and its first picture */
+static void *startup_prepare_input(void *arg)
+{
+	startup_job_t *job = (startup_job_t *)arg;
+	const mc_startup_params_t *params = job->params;
+	const mc_video_codec_enc_params_t *enc;
+
+	if (params->config_file != NULL) {
+		job->input_ret = hb_mm_config_load(params->config_file, &job->snap);
+		if (job->input_ret != 0) {
+			return NULL;
+		}
+		job->has_snap = TRUE;
+		enc = &job->snap.enc_params;
+		job->frame_size = (hb_u32)enc->width * (hb_u32)enc->height * 3 / 2;
+	}
+	if (params->input_file == NULL) {
+		return NULL;
+	}
+	job->fd = open(params->input_file, O_RDONLY | O_CLOEXEC);
+	if (job->fd < 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to open %s(%s).\n",
+			TAG, __FUNCTION__, __LINE__, params->input_file,
+			strerror(errno));
+		job->input_ret = HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+		return NULL;
+	}
+	if (job->frame_size == 0) {
+		return NULL;
+	}
+	job->staged = malloc(job->frame_size);
+	if (job->staged == NULL) {
+		VLOG(ERR, "%s <%s:%d> Fail to allocate %u bytes.\n",
+			TAG, __FUNCTION__, __LINE__, job->frame_size);
+		job->input_ret = HB_MEDIA_ERR_INSUFFICIENT_RES;
+		return NULL;
+	}
+	job->input_ret = startup_read(job->fd, job->staged, job->frame_size,
+		&job->staged_size);
+	return NULL;
+}
+
+static void *startup_prewarm(void *arg)
+{
+	startup_job_t *job = (startup_job_t *)arg;
+	const mc_startup_params_t *params = job->params;
+
+	if (params->prewarm_num > 0) {
+		job->prewarm_ret = hb_mm_bufpool_prewarm(params->prewarm_size,
+			params->prewarm_align, params->prewarm_num);
+	}
+	return NULL;
+}
+
+/* The staged picture first, the rest of the buffer from the file */
+static hb_s32 startup_fill_input(startup_job_t *job,
+		media_codec_buffer_t *buffer)
+{
+	hb_u8 *dst = buffer->vframe_buf.vir_ptr[0];
+	hb_u32 size = (hb_u32)buffer->vframe_buf.size, copied, got;
+
+	if (job->fd < 0) {
+		return 0;
+	}
+	copied = (job->staged_size < size) ? job->staged_size : size;
+	if (copied > 0) {
+		memcpy(dst, job->staged, copied);
+	}
+	return startup_read(job->fd, dst + copied, size - copied, &got);
+}
+
+/* The first output without stream_end is kept for the caller. */
+static hb_s32 startup_first_output(media_codec_context_t *context,
+		hb_s32 timeout, media_codec_buffer_t *buffer,
+		media_codec_output_buffer_info_t *info)
+{
+	hb_s32 ret = HB_MEDIA_ERR_WAIT_TIMEOUT, i;
+
+	for (i = 0; i < STARTUP_OUTPUT_TRIES; i++) {
+		memset(buffer, 0x00, sizeof(*buffer));
+		memset(info, 0x00, sizeof(*info));
+		ret = hb_mm_mc_dequeue_output_buffer(context, buffer, info,
+			timeout);
+		if (ret == HB_MEDIA_ERR_WAIT_TIMEOUT) {
+			continue;
+		}
+		if ((ret != 0) || !buffer->vstream_buf.stream_end) {
+			break;
+		}
+		ret = hb_mm_mc_queue_output_buffer(context, buffer, timeout);
+		if (ret != 0) {
+			break;
+		}
+		ret = HB_MEDIA_ERR_WAIT_TIMEOUT;
+	}
+	if (ret != 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to get the first output(ret=%d).\n",
+			TAG, __FUNCTION__, __LINE__, ret);
+	}
+	return ret;
+}
+
+hb_s32 hb_mm_startup_run(media_codec_context_t *context,
+		const mc_startup_params_t *params, hb_s32 *input_fd,
+		media_codec_buffer_t *output,
+		media_codec_output_buffer_info_t *output_info,
+		mc_startup_stats_t *stats)
+{
+	mc_av_codec_startup_params_t startup;
+	media_codec_buffer_t buffer;
+	pthread_t input_thread, prewarm_thread;
+	hb_bool input_started = FALSE, prewarm_started = FALSE;
+	hb_bool initialized = FALSE, started = FALSE;
+	startup_job_t job;
+	hb_u64 begin, now;
+	hb_s32 ret;
+
+	if ((context == NULL) || (params == NULL) || (input_fd == NULL) ||
+		(output == NULL) || (output_info == NULL) || (stats == NULL) ||
+		(params->timeout <= 0)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters.\n",
+			TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	memset(stats, 0x00, sizeof(*stats));
+	memset(&job, 0x00, sizeof(job));
+	job.params = params;
+	job.fd = -1;
+	job.frame_size = (hb_u32)context->video_enc_params.width *
+		(hb_u32)context->video_enc_params.height * 3 / 2;
+	*input_fd = -1;
+	begin = startup_get_time_us();
+
+	if (params->early_start) {
+		/* Serial again if a helper can't be started */
+		input_started = (pthread_create(&input_thread, NULL,
+			startup_prepare_input, &job) == 0);
+		prewarm_started = (pthread_create(&prewarm_thread, NULL,
+			startup_prewarm, &job) == 0);
+	}
+	if (!input_started) {
+		startup_prepare_input(&job);
+	}
+	if (!prewarm_started) {
+		startup_prewarm(&job);
+	}
+	if (!params->early_start) {
+		if (job.has_snap) {
+			context->codec_id = job.snap.codec_id;
+			context->encoder = TRUE;
+			context->video_enc_params = job.snap.enc_params;
+		}
+		now = startup_get_time_us();
+		stats->prepare_us = now - begin;
+		begin = now;
+		ret = (job.input_ret != 0) ? job.input_ret : job.prewarm_ret;
+		if (ret != 0) {
+			goto ERR;
+		}
+	}
+
+	ret = hb_mm_mc_initialize(context);
+	initialized = (ret == 0);
+	now = startup_get_time_us();
+	stats->initialize_us = now - begin;
+	begin = now;
+	if (input_started) {
+		pthread_join(input_thread, NULL);
+	}
+	if (prewarm_started) {
+		pthread_join(prewarm_thread, NULL);
+	}
+	if (params->early_start) {
+		now = startup_get_time_us();
+		stats->prepare_us = now - begin;
+		begin = now;
+	}
+	if (ret != 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to initialize(ret=%d).\n",
+			TAG, __FUNCTION__, __LINE__, ret);
+		goto ERR;
+	}
+	ret = (job.input_ret != 0) ? job.input_ret : job.prewarm_ret;
+	if (ret != 0) {
+		goto ERR;
+	}
+
+	if (job.has_snap) {
+		ret = hb_mm_config_apply(context, &job.snap);
+	} else {
+		ret = hb_mm_mc_configure(context);
+	}
+	now = startup_get_time_us();
+	stats->configure_us = now - begin;
+	begin = now;
+	if (ret != 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to configure(ret=%d).\n",
+			TAG, __FUNCTION__, __LINE__, ret);
+		goto ERR;
+	}
+
+	memset(&startup, 0x00, sizeof(startup));
+	ret = hb_mm_mc_start(context, &startup);
+	started = (ret == 0);
+	now = startup_get_time_us();
+	stats->start_us = now - begin;
+	begin = now;
+	if (ret != 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to start(ret=%d).\n",
+			TAG, __FUNCTION__, __LINE__, ret);
+		goto ERR;
+	}
+
+	memset(&buffer, 0x00, sizeof(buffer));
+	ret = hb_mm_mc_dequeue_input_buffer(context, &buffer, params->timeout);
+	if (ret == 0) {
+		ret = startup_fill_input(&job, &buffer);
+	}
+	now = startup_get_time_us();
+	stats->first_input_us = now - begin;
+	begin = now;
+	if (ret == 0) {
+		ret = hb_mm_mc_queue_input_buffer(context, &buffer, params->timeout);
+	}
+	if (ret == 0) {
+		ret = startup_first_output(context, params->timeout, output,
+			output_info);
+	}
+	if (ret != 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to encode the first picture(ret=%d).\n",
+			TAG, __FUNCTION__, __LINE__, ret);
+		goto ERR;
+	}
+	now = startup_get_time_us();
+	stats->first_output_us = now - begin;
+	stats->total_us = stats->prepare_us + stats->initialize_us +
+		stats->configure_us + stats->start_us + stats->first_input_us +
+		stats->first_output_us;
+
+	*input_fd = job.fd;
+	free(job.staged);
+	hb_mm_config_release(&job.snap);
+	return 0;
+
+ERR:
+	if (started) {
+		hb_mm_mc_stop(context);
+	}
+	if (initialized) {
+		hb_mm_mc_release(context);
+	}
+	if (job.fd >= 0) {
+		close(job.fd);
+	}
+	free(job.staged);
+	hb_mm_config_release(&job.snap);
+	return ret;
+}
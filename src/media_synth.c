@@ -0,0 +1,401 @@
+#include <string.h>
+
+#include "hb_media_synth.h"
+#include "media_common.h"
+#include "media_pixfmt.h"
+#include "media_simd.h"
+
+#define TAG "[MEDIASYNTH]"
+
+#define SYNTH_MAX_MOTION 64
+
+/* start and step are 8.8 fixed point luma levels, wrapping at 256 */
+typedef void (*synth_ramp_fn)(hb_u8 *dst, hb_s32 n, hb_u16 start, hb_u16 step);
+/* n is the number of chroma pairs */
+typedef void (*synth_pair_fn)(hb_u8 *dst, hb_s32 n, hb_u8 first, hb_u8 second);
+/* Four xorshift32 lanes give 16 noise bytes per step */
+typedef void (*synth_noise_fn)(hb_u8 *dst, hb_s32 n, hb_u32 state[4],
+		hb_u32 amp);
+
+typedef struct _sy_kernels {
+	synth_ramp_fn ramp;
+	synth_pair_fn pair;
+	synth_noise_fn noise;
+} synth_kernels_t;
+
+typedef struct _sy_scene {
+	hb_u32 seed;
+	/* Frames since the scene started */
+	hb_u32 age;
+	hb_u16 base;
+	hb_u16 step_x;
+	hb_u16 step_y;
+	hb_s32 shift;
+	hb_u8 u;
+	hb_u8 v;
+} synth_scene_t;
+
+static void synth_ramp_c(hb_u8 *dst, hb_s32 n, hb_u16 start, hb_u16 step)
+{
+	hb_s32 i;
+
+	for (i = 0; i < n; i++) {
+		dst[i] = (hb_u8)((hb_u16)(start + (hb_u32)step * (hb_u32)i) >> 8);
+	}
+}
+
+static void synth_pair_c(hb_u8 *dst, hb_s32 n, hb_u8 first, hb_u8 second)
+{
+	hb_s32 i;
+
+	for (i = 0; i < n; i++) {
+		dst[2 * i] = first;
+		dst[(2 * i) + 1] = second;
+	}
+}
+
+static void synth_noise_c(hb_u8 *dst, hb_s32 n, hb_u32 state[4], hb_u32 amp)
+{
+	hb_u8 r[16];
+	hb_s32 i, j, k, p;
+
+	for (i = 0; i < n; i += 16) {
+		for (k = 0; k < 4; k++) {
+			state[k] ^= state[k] << 13;
+			state[k] ^= state[k] >> 17;
+			state[k] ^= state[k] << 5;
+			for (j = 0; j < 4; j++) {
+				r[(4 * k) + j] = (hb_u8)(state[k] >> (8 * j));
+			}
+		}
+		for (j = 0; (j < 16) && ((i + j) < n); j++) {
+			p = (hb_s32)dst[i + j] + (hb_s32)((r[j] * (2 * amp + 1)) >> 8) -
+				(hb_s32)amp;
+			dst[i + j] = (hb_u8)((p < 0) ? 0 : ((p > 255) ? 255 : p));
+		}
+	}
+}
+
+#if defined(MEDIA_SIMD_X86)
+static void synth_ramp_sse2(hb_u8 *dst, hb_s32 n, hb_u16 start, hb_u16 step)
+{
+	const __m128i inc = _mm_set1_epi16((short)(step * 16));
+	__m128i v0, v1;
+	hb_s32 i;
+
+	v0 = _mm_add_epi16(_mm_set1_epi16((short)start), _mm_mullo_epi16(
+		_mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7), _mm_set1_epi16((short)step)));
+	v1 = _mm_add_epi16(v0, _mm_set1_epi16((short)(step * 8)));
+	for (i = 0; (i + 16) <= n; i += 16) {
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(
+			_mm_srli_epi16(v0, 8), _mm_srli_epi16(v1, 8)));
+		v0 = _mm_add_epi16(v0, inc);
+		v1 = _mm_add_epi16(v1, inc);
+	}
+	synth_ramp_c(dst + i, n - i, (hb_u16)(start + (hb_u32)step * (hb_u32)i),
+		step);
+}
+
+static void synth_pair_sse2(hb_u8 *dst, hb_s32 n, hb_u8 first, hb_u8 second)
+{
+	const __m128i pair = _mm_set1_epi16((short)(first | (second << 8)));
+	hb_s32 i;
+
+	for (i = 0; (i + 8) <= n; i += 8) {
+		_mm_storeu_si128((__m128i *)(dst + (2 * i)), pair);
+	}
+	synth_pair_c(dst + (2 * i), n - i, first, second);
+}
+
+static void synth_noise_sse2(hb_u8 *dst, hb_s32 n, hb_u32 state[4], hb_u32 amp)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i mul = _mm_set1_epi16((short)(2 * amp + 1));
+	const __m128i off = _mm_set1_epi16((short)amp);
+	__m128i st, p, lo, hi;
+	hb_s32 i;
+
+	st = _mm_loadu_si128((const __m128i *)state);
+	for (i = 0; (i + 16) <= n; i += 16) {
+		st = _mm_xor_si128(st, _mm_slli_epi32(st, 13));
+		st = _mm_xor_si128(st, _mm_srli_epi32(st, 17));
+		st = _mm_xor_si128(st, _mm_slli_epi32(st, 5));
+		p = _mm_loadu_si128((const __m128i *)(dst + i));
+		lo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(st, zero), mul),
+			8);
+		hi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(st, zero), mul),
+			8);
+		lo = _mm_sub_epi16(_mm_add_epi16(_mm_unpacklo_epi8(p, zero), lo), off);
+		hi = _mm_sub_epi16(_mm_add_epi16(_mm_unpackhi_epi8(p, zero), hi), off);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+	}
+	_mm_storeu_si128((__m128i *)state, st);
+	synth_noise_c(dst + i, n - i, state, amp);
+}
+
+MEDIA_TARGET_AVX2
+static void synth_ramp_avx2(hb_u8 *dst, hb_s32 n, hb_u16 start, hb_u16 step)
+{
+	const __m256i inc = _mm256_set1_epi16((short)(step * 32));
+	__m256i v0, v1;
+	hb_s32 i;
+
+	v0 = _mm256_add_epi16(_mm256_set1_epi16((short)start),
+		_mm256_mullo_epi16(_mm256_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+		10, 11, 12, 13, 14, 15), _mm256_set1_epi16((short)step)));
+	v1 = _mm256_add_epi16(v0, _mm256_set1_epi16((short)(step * 16)));
+	for (i = 0; (i + 32) <= n; i += 32) {
+		/* pack works per 128 bit lane, 0xD8 restores the 64 bit order */
+		_mm256_storeu_si256((__m256i *)(dst + i), _mm256_permute4x64_epi64(
+			_mm256_packus_epi16(_mm256_srli_epi16(v0, 8),
+			_mm256_srli_epi16(v1, 8)), 0xD8));
+		v0 = _mm256_add_epi16(v0, inc);
+		v1 = _mm256_add_epi16(v1, inc);
+	}
+	synth_ramp_sse2(dst + i, n - i, (hb_u16)(start + (hb_u32)step * (hb_u32)i),
+		step);
+}
+#endif
+
+#if defined(MEDIA_SIMD_NEON)
+static void synth_ramp_neon(hb_u8 *dst, hb_s32 n, hb_u16 start, hb_u16 step)
+{
+	static const hb_u16 lanes[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+	const uint16x8_t inc = vdupq_n_u16((hb_u16)(step * 16));
+	uint16x8_t v0, v1;
+	hb_s32 i;
+
+	v0 = vmlaq_n_u16(vdupq_n_u16(start), vld1q_u16(lanes), step);
+	v1 = vaddq_u16(v0, vdupq_n_u16((hb_u16)(step * 8)));
+	for (i = 0; (i + 16) <= n; i += 16) {
+		vst1q_u8(dst + i, vcombine_u8(vshrn_n_u16(v0, 8),
+			vshrn_n_u16(v1, 8)));
+		v0 = vaddq_u16(v0, inc);
+		v1 = vaddq_u16(v1, inc);
+	}
+	synth_ramp_c(dst + i, n - i, (hb_u16)(start + (hb_u32)step * (hb_u32)i),
+		step);
+}
+
+static void synth_pair_neon(hb_u8 *dst, hb_s32 n, hb_u8 first, hb_u8 second)
+{
+	const uint8x16_t pair = vreinterpretq_u8_u16(vdupq_n_u16(
+		(hb_u16)(first | (second << 8))));
+	hb_s32 i;
+
+	for (i = 0; (i + 8) <= n; i += 8) {
+		vst1q_u8(dst + (2 * i), pair);
+	}
+	synth_pair_c(dst + (2 * i), n - i, first, second);
+}
+
+static void synth_noise_neon(hb_u8 *dst, hb_s32 n, hb_u32 state[4], hb_u32 amp)
+{
+	const uint8x8_t mul = vdup_n_u8((hb_u8)(2 * amp + 1));
+	const int16x8_t off = vdupq_n_s16((hb_s16)amp);
+	uint32x4_t st;
+	uint8x16_t r, p;
+	int16x8_t lo, hi;
+	hb_s32 i;
+
+	st = vld1q_u32(state);
+	for (i = 0; (i + 16) <= n; i += 16) {
+		st = veorq_u32(st, vshlq_n_u32(st, 13));
+		st = veorq_u32(st, vshrq_n_u32(st, 17));
+		st = veorq_u32(st, vshlq_n_u32(st, 5));
+		r = vreinterpretq_u8_u32(st);
+		p = vld1q_u8(dst + i);
+		lo = vreinterpretq_s16_u16(vaddq_u16(vmovl_u8(vget_low_u8(p)),
+			vshrq_n_u16(vmull_u8(vget_low_u8(r), mul), 8)));
+		hi = vreinterpretq_s16_u16(vaddq_u16(vmovl_u8(vget_high_u8(p)),
+			vshrq_n_u16(vmull_u8(vget_high_u8(r), mul), 8)));
+		vst1q_u8(dst + i, vcombine_u8(vqmovun_s16(vsubq_s16(lo, off)),
+			vqmovun_s16(vsubq_s16(hi, off))));
+	}
+	vst1q_u32(state, st);
+	synth_noise_c(dst + i, n - i, state, amp);
+}
+#endif
+
+static void synth_get_kernels(synth_kernels_t *k)
+{
+	k->ramp = synth_ramp_c;
+	k->pair = synth_pair_c;
+	k->noise = synth_noise_c;
+
+	switch (media_simd_isa()) {
+#if defined(MEDIA_SIMD_X86)
+	case MC_SIMD_ISA_AVX2:
+		k->ramp = synth_ramp_avx2;
+		k->pair = synth_pair_sse2;
+		k->noise = synth_noise_sse2;
+		break;
+	case MC_SIMD_ISA_SSE2:
+		k->ramp = synth_ramp_sse2;
+		k->pair = synth_pair_sse2;
+		k->noise = synth_noise_sse2;
+		break;
+#endif
+#if defined(MEDIA_SIMD_NEON)
+	case MC_SIMD_ISA_NEON:
+		k->ramp = synth_ramp_neon;
+		k->pair = synth_pair_neon;
+		k->noise = synth_noise_neon;
+		break;
+#endif
+	default:
+		break;
+	}
+}
+
+static hb_u32 synth_hash(hb_u32 a, hb_u32 b)
+{
+	hb_u32 h = a ^ (b * 0x9E3779B1U);
+
+	h ^= h >> 16;
+	h *= 0x85EBCA6BU;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35U;
+	return h ^ (h >> 16);
+}
+
+/* Signed value in [-range, range] */
+static hb_s32 synth_hash_range(hb_u32 a, hb_u32 b, hb_u32 range)
+{
+	return (hb_s32)(synth_hash(a, b) % (2 * range + 1)) - (hb_s32)range;
+}
+
+static void synth_get_scene(const mc_synth_params_t *params, hb_u32 frame,
+		synth_scene_t *scene)
+{
+	hb_u32 index = 0, start = 0, i;
+
+	for (i = 0; i < params->scene_cut_num; i++) {
+		if (params->scene_cuts[i] > frame) {
+			break;
+		}
+		if (params->scene_cuts[i] > 0) {
+			index++;
+			start = params->scene_cuts[i];
+		}
+	}
+	scene->seed = synth_hash(params->seed, index);
+	scene->age = frame - start;
+	scene->base = (hb_u16)synth_hash(scene->seed, 1);
+	scene->step_x = (hb_u16)(64 + synth_hash(scene->seed, 2) % 449);
+	scene->step_y = (hb_u16)(synth_hash(scene->seed, 3) % 257);
+	scene->shift = synth_hash_range(scene->seed, 4, params->motion);
+	scene->u = (hb_u8)(64 + synth_hash(scene->seed, 5) % 128);
+	scene->v = (hb_u8)(64 + synth_hash(scene->seed, 6) % 128);
+}
+
+/* Position on [0, range] bouncing off both ends */
+static hb_s32 synth_bounce(hb_s32 start, hb_s32 velocity, hb_u32 age,
+		hb_s32 range)
+{
+	hb_s64 period = 2 * (hb_s64)range, p;
+
+	if (range <= 0) {
+		return 0;
+	}
+	p = ((hb_s64)start + (hb_s64)velocity * age) % period;
+	if (p < 0) {
+		p += period;
+	}
+	return (hb_s32)((p > range) ? (period - p) : p);
+}
+
+static void synth_fill_chroma(const synth_kernels_t *k,
+		mc_video_frame_buffer_info_t *dst, hb_s32 cstride, hb_s32 x,
+		hb_s32 y, hb_s32 w, hb_s32 h, hb_u8 u, hb_u8 v)
+{
+	hb_s32 row;
+
+	for (row = y; row < y + h; row++) {
+		if (dst->pix_fmt == MC_PIXEL_FORMAT_YUV420P) {
+			memset(dst->vir_ptr[1] + (size_t)row * cstride + x, u, (size_t)w);
+			memset(dst->vir_ptr[2] + (size_t)row * cstride + x, v, (size_t)w);
+		} else if (dst->pix_fmt == MC_PIXEL_FORMAT_NV12) {
+			k->pair(dst->vir_ptr[1] + (size_t)row * cstride + 2 * x, w, u, v);
+		} else {
+			k->pair(dst->vir_ptr[1] + (size_t)row * cstride + 2 * x, w, v, u);
+		}
+	}
+}
+
+hb_s32 hb_mm_synth_fill(const mc_synth_params_t *params, hb_u32 frame,
+		mc_video_frame_buffer_info_t *dst)
+{
+	synth_kernels_t k;
+	synth_scene_t scene;
+	hb_s32 width, height, lstride, cstride, y, bw, bh, bx, by;
+	hb_u32 b, h, state[4], i;
+	hb_u8 *luma;
+
+	if ((params == NULL) || (dst == NULL) || (dst->vir_ptr[0] == NULL) ||
+		(params->block_num > MC_SYNTH_MAX_BLOCKS) ||
+		((params->block_num > 0) && (params->block_size == 0)) ||
+		(params->motion > SYNTH_MAX_MOTION) ||
+		(params->noise > MC_SYNTH_MAX_NOISE) ||
+		((params->scene_cut_num > 0) && (params->scene_cuts == NULL))) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(params=%p, dst=%p).\n",
+			TAG, __FUNCTION__, __LINE__, params, dst);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	width = dst->width;
+	height = dst->height;
+	if (((dst->pix_fmt != MC_PIXEL_FORMAT_YUV420P) &&
+		(dst->pix_fmt != MC_PIXEL_FORMAT_NV12) &&
+		(dst->pix_fmt != MC_PIXEL_FORMAT_NV21)) || (width <= 0) ||
+		(height <= 0)) {
+		VLOG(ERR, "%s <%s:%d> Unsupported picture %d(%dx%d).\n",
+			TAG, __FUNCTION__, __LINE__, dst->pix_fmt, width, height);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	media_pixfmt_layout(dst, &lstride, &cstride);
+	synth_get_kernels(&k);
+	synth_get_scene(params, frame, &scene);
+
+	/* The gradient scrolls horizontally by the scene shift */
+	luma = dst->vir_ptr[0];
+	for (y = 0; y < height; y++) {
+		k.ramp(luma + (size_t)y * lstride, width, (hb_u16)(scene.base +
+			(hb_u32)scene.step_y * (hb_u32)y - (hb_u32)scene.step_x *
+			(hb_u32)scene.shift * scene.age), scene.step_x);
+	}
+	synth_fill_chroma(&k, dst, cstride, 0, 0, (width + 1) / 2, (height + 1) / 2,
+		scene.u, scene.v);
+
+	bw = ((hb_s32)params->block_size < width) ?
+		(hb_s32)params->block_size : width;
+	bh = ((hb_s32)params->block_size < height) ?
+		(hb_s32)params->block_size : height;
+	for (b = 0; b < params->block_num; b++) {
+		h = synth_hash(scene.seed, 16 + b);
+		bx = synth_bounce(
+			(hb_s32)(synth_hash(h, 1) % (hb_u32)(width - bw + 1)),
+			synth_hash_range(h, 2, params->motion), scene.age, width - bw);
+		by = synth_bounce(
+			(hb_s32)(synth_hash(h, 3) % (hb_u32)(height - bh + 1)),
+			synth_hash_range(h, 4, params->motion), scene.age, height - bh);
+		for (y = by; y < by + bh; y++) {
+			memset(luma + (size_t)y * lstride + bx, (hb_u8)synth_hash(h, 5),
+				(size_t)bw);
+		}
+		synth_fill_chroma(&k, dst, cstride, bx / 2, by / 2,
+			(bx + bw + 1) / 2 - bx / 2, (by + bh + 1) / 2 - by / 2,
+			(hb_u8)synth_hash(h, 6), (hb_u8)synth_hash(h, 7));
+	}
+
+	if (params->noise > 0) {
+		for (y = 0; y < height; y++) {
+			/* xorshift32 never leaves 0, the lanes start odd */
+			for (i = 0; i < 4; i++) {
+				state[i] = synth_hash(params->seed ^ frame,
+					((hb_u32)y << 2) | i) | 1;
+			}
+			k.noise(luma + (size_t)y * lstride, width, state, params->noise);
+		}
+	}
+	return 0;
+}
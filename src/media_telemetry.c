@@ -0,0 +1,364 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hb_media_telemetry.h"
+#include "media_common.h"
+
+#define TAG "[MEDIATELEMETRY]"
+
+#define TELEMETRY_MAGIC 0x4c544248U /* "HBTL" */
+#define TELEMETRY_VERSION 1U
+#define TELEMETRY_HEADER_SIZE 4096U
+#define TELEMETRY_NAME_LEN 16
+
+typedef struct _telemetry_column_desc {
+	char name[TELEMETRY_NAME_LEN];
+	/* Bytes per value and offset of the column inside a chunk */
+	hb_u32 width;
+	hb_u32 offset;
+} telemetry_column_desc_t;
+
+/* Little endian on disk, the host and the SoC agree */
+typedef struct _telemetry_header {
+	hb_u32 magic;
+	hb_u32 version;
+	hb_u32 header_size;
+	hb_u32 chunk_frames;
+	hb_u32 chunk_size;
+	hb_u32 column_num;
+	hb_u64 capacity;
+	/* Published with release order after the columns are written */
+	hb_u64 frames;
+	/* CLOCK_REALTIME of the creation in us */
+	hb_u64 create_time_us;
+	telemetry_column_desc_t columns[MC_TELEMETRY_COLUMN_TOTAL];
+} telemetry_header_t;
+
+struct _mc_telemetry_writer {
+	hb_s32 fd;
+	hb_u8 *map;
+	size_t map_size;
+	telemetry_header_t *header;
+	hb_u64 frames;
+	mc_telemetry_stats_t stats;
+};
+
+struct _mc_telemetry_reader {
+	hb_s32 fd;
+	const hb_u8 *map;
+	size_t map_size;
+	const telemetry_header_t *header;
+};
+
+static const struct {
+	const char *name;
+	hb_u32 width;
+} telemetry_columns[MC_TELEMETRY_COLUMN_TOTAL] = {
+	{"queue_us", 8},
+	{"dequeue_us", 8},
+	{"frame_cycle", 4},
+	{"enc_pic_byte", 4},
+	{"avg_mb_qp", 1},
+	{"nalu_type", 1},
+	{"pic_skipped", 1},
+	{"temporal_id", 1},
+};
+
+static size_t telemetry_file_size(const telemetry_header_t *header,
+		hb_u64 frames)
+{
+	hb_u64 chunks;
+
+	chunks = (frames + header->chunk_frames - 1) / header->chunk_frames;
+	return (size_t)(header->header_size + (chunks * header->chunk_size));
+}
+
+static void telemetry_init_header(telemetry_header_t *header,
+		hb_u64 capacity)
+{
+	struct timespec tp;
+	hb_u32 i, offset = 0;
+
+	header->magic = TELEMETRY_MAGIC;
+	header->version = TELEMETRY_VERSION;
+	header->header_size = TELEMETRY_HEADER_SIZE;
+	header->chunk_frames = MC_TELEMETRY_CHUNK_FRAMES;
+	header->column_num = MC_TELEMETRY_COLUMN_TOTAL;
+	header->capacity = capacity;
+	header->frames = 0;
+	clock_gettime(CLOCK_REALTIME, &tp);
+	header->create_time_us = ((hb_u64)tp.tv_sec * 1000000) +
+		((hb_u64)tp.tv_nsec / 1000);
+	/* widest columns first, every column stays naturally aligned */
+	for (i = 0; i < MC_TELEMETRY_COLUMN_TOTAL; i++) {
+		strncpy(header->columns[i].name, telemetry_columns[i].name,
+			TELEMETRY_NAME_LEN - 1);
+		header->columns[i].width = telemetry_columns[i].width;
+		header->columns[i].offset = offset;
+		offset += telemetry_columns[i].width * MC_TELEMETRY_CHUNK_FRAMES;
+	}
+	header->chunk_size = offset;
+}
+
+hb_s32 hb_mm_telemetry_create(const char *path, hb_u64 capacity,
+		mc_telemetry_writer_t **writer)
+{
+	mc_telemetry_writer_t *w;
+	telemetry_header_t header;
+
+	if ((path == NULL) || (writer == NULL) || (capacity == 0)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(path=%p, capacity=%llu).\n",
+			TAG, __FUNCTION__, __LINE__, path, (unsigned long long)capacity);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	memset(&header, 0x00, sizeof(header));
+	telemetry_init_header(&header, capacity);
+	w = (mc_telemetry_writer_t *)calloc(1, sizeof(*w));
+	if (w == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	w->map = MAP_FAILED;
+	w->map_size = telemetry_file_size(&header, capacity);
+	w->fd = open(path, O_CREAT | O_RDWR | O_TRUNC | O_CLOEXEC, 0644);
+	if (w->fd < 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to open %s.(%s)\n",
+			TAG, __FUNCTION__, __LINE__, path, strerror(errno));
+		free(w);
+		return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+	}
+	/* sparse, only the chunks that get written take space */
+	if (ftruncate(w->fd, (off_t)w->map_size) == 0) {
+		w->map = (hb_u8 *)mmap(NULL, w->map_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED, w->fd, 0);
+	}
+	if (w->map == MAP_FAILED) {
+		VLOG(ERR, "%s <%s:%d> Fail to map %zu bytes of %s.(%s)\n",
+			TAG, __FUNCTION__, __LINE__, w->map_size, path, strerror(errno));
+		close(w->fd);
+		free(w);
+		return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+	}
+	w->header = (telemetry_header_t *)w->map;
+	memcpy(w->header, &header, sizeof(header));
+
+	*writer = w;
+	return 0;
+}
+
+hb_s32 hb_mm_telemetry_write(mc_telemetry_writer_t *writer,
+		const media_codec_output_buffer_info_t *info, hb_u64 queue_us,
+		hb_u64 dequeue_us)
+{
+	const mc_h264_h265_output_stream_info_t *s;
+	const telemetry_column_desc_t *c;
+	hb_u8 *chunk;
+	hb_u32 idx;
+
+	if ((writer == NULL) || (info == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (writer->frames >= writer->header->capacity) {
+		writer->stats.dropped++;
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	s = &info->video_stream_info;
+	c = writer->header->columns;
+
+	chunk = writer->map + TELEMETRY_HEADER_SIZE + ((writer->frames /
+		MC_TELEMETRY_CHUNK_FRAMES) * writer->header->chunk_size);
+	idx = (hb_u32)(writer->frames % MC_TELEMETRY_CHUNK_FRAMES);
+	((hb_u64 *)(chunk + c[MC_TELEMETRY_COLUMN_QUEUE_US].offset))[idx] =
+		queue_us;
+	((hb_u64 *)(chunk + c[MC_TELEMETRY_COLUMN_DEQUEUE_US].offset))[idx] =
+		dequeue_us;
+	((hb_u32 *)(chunk + c[MC_TELEMETRY_COLUMN_FRAME_CYCLE].offset))[idx] =
+		s->frame_cycle;
+	((hb_u32 *)(chunk + c[MC_TELEMETRY_COLUMN_ENC_PIC_BYTE].offset))[idx] =
+		s->enc_pic_byte;
+	chunk[c[MC_TELEMETRY_COLUMN_AVG_MB_QP].offset + idx] =
+		(hb_u8)s->avg_mb_qp;
+	chunk[c[MC_TELEMETRY_COLUMN_NALU_TYPE].offset + idx] =
+		(hb_u8)(hb_s8)s->nalu_type;
+	chunk[c[MC_TELEMETRY_COLUMN_PIC_SKIPPED].offset + idx] =
+		(hb_u8)s->pic_skipped;
+	chunk[c[MC_TELEMETRY_COLUMN_TEMPORAL_ID].offset + idx] =
+		(hb_u8)s->temporal_id;
+
+	writer->frames++;
+	__atomic_store_n(&writer->header->frames, writer->frames,
+		__ATOMIC_RELEASE);
+	writer->stats.frames++;
+
+	return 0;
+}
+
+hb_s32 hb_mm_telemetry_get_stats(mc_telemetry_writer_t *writer,
+		mc_telemetry_stats_t *stats)
+{
+	if ((writer == NULL) || (stats == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	*stats = writer->stats;
+
+	return 0;
+}
+
+hb_s32 hb_mm_telemetry_destroy(mc_telemetry_writer_t *writer)
+{
+	size_t size;
+	hb_s32 ret = 0;
+
+	if (writer == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	size = telemetry_file_size(writer->header, writer->frames);
+	munmap(writer->map, writer->map_size);
+	if (ftruncate(writer->fd, (off_t)size) != 0) {
+		VLOG(ERR, "%s <%s:%d> Fail to cut the file to %zu bytes.(%s)\n",
+			TAG, __FUNCTION__, __LINE__, size, strerror(errno));
+		ret = HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+	}
+	close(writer->fd);
+	free(writer);
+
+	return ret;
+}
+
+/*
+ * Every column must lie inside a chunk as the library lays it out, so a
+ * corrupt header can't send the reader outside the mapping.
+ */
+static hb_bool telemetry_header_valid(const telemetry_header_t *h)
+{
+	const telemetry_column_desc_t *col;
+	hb_u32 i;
+
+	if ((h->magic != TELEMETRY_MAGIC) || (h->version != TELEMETRY_VERSION) ||
+		(h->header_size != TELEMETRY_HEADER_SIZE) ||
+		(h->chunk_frames != MC_TELEMETRY_CHUNK_FRAMES) ||
+		(h->column_num != MC_TELEMETRY_COLUMN_TOTAL) ||
+		(h->chunk_size == 0U)) {
+		return FALSE;
+	}
+	for (i = 0; i < MC_TELEMETRY_COLUMN_TOTAL; i++) {
+		col = &h->columns[i];
+		if ((col->width != telemetry_columns[i].width) ||
+			((hb_u64)col->offset + ((hb_u64)col->width *
+			MC_TELEMETRY_CHUNK_FRAMES) > h->chunk_size)) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+hb_s32 hb_mm_telemetry_open(const char *path, mc_telemetry_reader_t **reader)
+{
+	mc_telemetry_reader_t *r;
+	const telemetry_header_t *h;
+	struct stat st;
+
+	if ((path == NULL) || (reader == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	r = (mc_telemetry_reader_t *)calloc(1, sizeof(*r));
+	if (r == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	r->fd = open(path, O_RDONLY | O_CLOEXEC);
+	if ((r->fd < 0) || (fstat(r->fd, &st) != 0) ||
+		(st.st_size < (off_t)TELEMETRY_HEADER_SIZE)) {
+		VLOG(ERR, "%s <%s:%d> Fail to open %s.(%s)\n",
+			TAG, __FUNCTION__, __LINE__, path, strerror(errno));
+		if (r->fd >= 0) {
+			close(r->fd);
+		}
+		free(r);
+		return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+	}
+	r->map_size = (size_t)st.st_size;
+	r->map = (const hb_u8 *)mmap(NULL, r->map_size, PROT_READ, MAP_SHARED,
+		r->fd, 0);
+	if (r->map == MAP_FAILED) {
+		VLOG(ERR, "%s <%s:%d> Fail to map %s.(%s)\n",
+			TAG, __FUNCTION__, __LINE__, path, strerror(errno));
+		close(r->fd);
+		free(r);
+		return HB_MEDIA_ERR_FILE_OPERATION_FAILURE;
+	}
+	h = (const telemetry_header_t *)r->map;
+	r->header = h;
+	if (!telemetry_header_valid(h)) {
+		VLOG(ERR, "%s <%s:%d> %s isn't a telemetry file of version %u.\n",
+			TAG, __FUNCTION__, __LINE__, path, TELEMETRY_VERSION);
+		hb_mm_telemetry_close(r);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	*reader = r;
+	return 0;
+}
+
+hb_s32 hb_mm_telemetry_get_frames(mc_telemetry_reader_t *reader,
+		hb_u64 *frames)
+{
+	hb_u64 n, max;
+
+	if ((reader == NULL) || (frames == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	n = __atomic_load_n(&reader->header->frames, __ATOMIC_ACQUIRE);
+	/* a file cut short by a crash holds fewer chunks than the count */
+	max = ((reader->map_size - TELEMETRY_HEADER_SIZE) /
+		reader->header->chunk_size) * MC_TELEMETRY_CHUNK_FRAMES;
+	*frames = (n > max) ? max : n;
+
+	return 0;
+}
+
+hb_s32 hb_mm_telemetry_get_column(mc_telemetry_reader_t *reader,
+		mc_telemetry_column_t column, hb_u64 chunk, const void **data,
+		hb_u32 *num)
+{
+	hb_u64 frames = 0, first;
+
+	if ((reader == NULL) || (data == NULL) || (num == NULL) ||
+		(column <= MC_TELEMETRY_COLUMN_NONE) ||
+		(column >= MC_TELEMETRY_COLUMN_TOTAL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	hb_mm_telemetry_get_frames(reader, &frames);
+	first = chunk * MC_TELEMETRY_CHUNK_FRAMES;
+	if (first >= frames) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	*data = reader->map + TELEMETRY_HEADER_SIZE +
+		(chunk * reader->header->chunk_size) +
+		reader->header->columns[column].offset;
+	*num = (frames - first > MC_TELEMETRY_CHUNK_FRAMES) ?
+		MC_TELEMETRY_CHUNK_FRAMES : (hb_u32)(frames - first);
+	return 0;
+}
+
+hb_s32 hb_mm_telemetry_close(mc_telemetry_reader_t *reader)
+{
+	if (reader == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	munmap((void *)reader->map, reader->map_size);
+	close(reader->fd);
+	free(reader);
+
+	return 0;
+}
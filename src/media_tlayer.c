@@ -0,0 +1,210 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "hb_media_nal.h"
+#include "hb_media_tlayer.h"
+#include "media_common.h"
+
+#define TAG "[MEDIATLAYER]"
+
+#define TLAYER_MAX_QP 51
+
+struct _mc_tlayer_dropper {
+	mc_tlayer_drop_params_t params;
+	/* Pictures since the last key picture, for H264 */
+	hb_u32 index;
+	mc_tlayer_drop_stats_t stats;
+};
+
+static hb_u32 tl_ctz(hb_u32 n)
+{
+	hb_u32 c = 0;
+
+	while ((n & 0x01) == 0) {
+		n >>= 1;
+		c++;
+	}
+	return c;
+}
+
+hb_u32 hb_mm_tlayer_get_id(hb_u32 layers, hb_u32 index)
+{
+	hb_u32 n;
+
+	if ((layers <= 1) || (layers > MC_TLAYER_MAX_LAYERS)) {
+		return 0;
+	}
+	n = index & ((1U << (layers - 1)) - 1);
+	return (n == 0) ? 0 : (layers - 1 - tl_ctz(n));
+}
+
+hb_s32 hb_mm_tlayer_build_gop(const mc_tlayer_gop_params_t *params,
+		mc_video_gop_params_t *gop)
+{
+	mc_video_custom_gop_pic_params_t *pic;
+	hb_u32 size, poc, qp;
+
+	if ((params == NULL) || (gop == NULL) || (params->layers == 0) ||
+		(params->layers > MC_TLAYER_MAX_LAYERS) ||
+		(params->base_qp > TLAYER_MAX_QP) ||
+		(params->qp_step > TLAYER_MAX_QP)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(params=%p, gop=%p).\n",
+			TAG, __FUNCTION__, __LINE__, params, gop);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	size = 1U << (params->layers - 1);
+	memset(gop->custom_gop_pic_param, 0x00,
+		sizeof(gop->custom_gop_pic_param));
+	gop->gop_preset_idx = 0;
+	gop->custom_gop_size = size;
+	for (poc = 1; poc <= size; poc++) {
+		pic = &gop->custom_gop_pic_param[poc - 1];
+		pic->pic_type = 1;
+		pic->poc_offset = poc;
+		pic->temporal_id = hb_mm_tlayer_get_id(params->layers, poc);
+		qp = params->base_qp + (pic->temporal_id * params->qp_step);
+		pic->pic_qp = (qp > TLAYER_MAX_QP) ? TLAYER_MAX_QP : qp;
+		/* the closest earlier picture of a lower layer, 0 is the last
+		 * picture of the previous GOP */
+		pic->num_ref_picL0 = 0;
+		pic->ref_pocL0 = poc - (1U << tl_ctz(poc));
+		pic->ref_pocL1 = 0;
+	}
+
+	return 0;
+}
+
+hb_s32 hb_mm_tlayer_dropper_create(const mc_tlayer_drop_params_t *params,
+		mc_tlayer_dropper_t **dropper)
+{
+	mc_tlayer_dropper_t *d;
+
+	if ((params == NULL) || (dropper == NULL) || (params->layers == 0) ||
+		(params->layers > MC_TLAYER_MAX_LAYERS) ||
+		(params->low_watermark >= params->high_watermark) ||
+		((params->codec_id != MEDIA_CODEC_ID_H264) &&
+		(params->codec_id != MEDIA_CODEC_ID_H265))) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(params=%p).\n",
+			TAG, __FUNCTION__, __LINE__, params);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	d = (mc_tlayer_dropper_t *)calloc(1, sizeof(*d));
+	if (d == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	d->params = *params;
+
+	*dropper = d;
+	return 0;
+}
+
+/*
+ * Temporal id of the first slice, -1 for pictures without one. An H264
+ * picture other pictures may refer to is flagged as reference.
+ */
+static hb_s32 tl_parse_id(mc_tlayer_dropper_t *d, const hb_u8 *data,
+		hb_u32 size, hb_s32 *tid, hb_bool *reference)
+{
+	media_codec_id_t codec_id = d->params.codec_id;
+	mc_nal_unit_t nal;
+	const hb_u8 *hdr;
+	hb_u32 pos = 0;
+	hb_s32 ret;
+
+	*tid = -1;
+	*reference = FALSE;
+	while ((ret = hb_mm_nal_next(codec_id, data, size, &pos, &nal)) == 1) {
+		hdr = data + nal.offset + nal.start_code_size;
+		if (codec_id == MEDIA_CODEC_ID_H264) {
+			if ((nal.type < 1) || (nal.type > 5)) {
+				continue;
+			}
+			if (nal.type == 5) {
+				d->index = 0;
+			}
+			*tid = (hb_s32)hb_mm_tlayer_get_id(d->params.layers, d->index);
+			*reference = ((hdr[0] & 0x60) != 0);
+			d->index++;
+			return 0;
+		}
+		if ((nal.type > 31) || ((nal.size - nal.start_code_size) < 2)) {
+			continue;
+		}
+		*tid = (hdr[1] & 0x07) - 1;
+		return 0;
+	}
+
+	return ret;
+}
+
+hb_s32 hb_mm_tlayer_dropper_check(mc_tlayer_dropper_t *dropper,
+		const hb_u8 *data, hb_u32 size, hb_u32 backlog, hb_bool *drop)
+{
+	mc_tlayer_drop_stats_t *st;
+	hb_bool reference;
+	hb_s32 tid, ret;
+
+	if ((dropper == NULL) || (data == NULL) || (drop == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	*drop = FALSE;
+	ret = tl_parse_id(dropper, data, size, &tid, &reference);
+	if ((ret < 0) || (tid < 0)) {
+		return (ret < 0) ? ret : 0;
+	}
+	if (tid >= MC_TLAYER_MAX_LAYERS) {
+		tid = MC_TLAYER_MAX_LAYERS - 1;
+	}
+
+	st = &dropper->stats;
+	st->pictures++;
+	if ((backlog >= dropper->params.high_watermark) &&
+		((st->level + 1) < dropper->params.layers)) {
+		st->level++;
+		if (st->level > st->max_level) {
+			st->max_level = st->level;
+		}
+	} else if ((backlog <= dropper->params.low_watermark) &&
+		(st->level > 0) && (tid == 0)) {
+		/* the pictures after a layer 0 one only refer back to it */
+		st->level--;
+	}
+
+	if ((tid > 0) && ((hb_u32)tid >= (dropper->params.layers - st->level))) {
+		if (reference) {
+			/* a counted H264 layer may be wrong, a reference stays */
+			st->ref_kept++;
+			return 0;
+		}
+		*drop = TRUE;
+		st->dropped++;
+		st->layer_dropped[tid]++;
+		st->dropped_bytes += size;
+	}
+
+	return 0;
+}
+
+hb_s32 hb_mm_tlayer_dropper_get_stats(mc_tlayer_dropper_t *dropper,
+		mc_tlayer_drop_stats_t *stats)
+{
+	if ((dropper == NULL) || (stats == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	*stats = dropper->stats;
+
+	return 0;
+}
+
+hb_s32 hb_mm_tlayer_dropper_destroy(mc_tlayer_dropper_t *dropper)
+{
+	if (dropper == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	free(dropper);
+
+	return 0;
+}
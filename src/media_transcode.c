@@ -0,0 +1,262 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "hb_media_transcode.h"
+#include "media_common.h"
+
+#define TAG "[MEDIATRANSCODE]"
+
+typedef struct _tc_slot {
+	/* Decoded frame behind the encoder input buffer of this src_idx */
+	media_codec_buffer_t frame;
+	hb_bool used;
+} transcode_slot_t;
+
+struct _mc_transcode {
+	mc_transcode_params_t params;
+	media_codec_context_t *decoder;
+	media_codec_context_t *encoder;
+	transcode_slot_t slots[MC_TRANSCODE_MAX_INFLIGHT];
+	media_codec_buffer_t input;
+	hb_bool held;
+	/* The last decoded frame was seen, the end of stream is due */
+	hb_bool dec_end;
+	mc_transcode_stats_t stats;
+};
+
+static hb_s32 transcode_release_slot(mc_transcode_t *tc, transcode_slot_t *slot)
+{
+	hb_s32 ret;
+
+	if (!slot->used) {
+		return 0;
+	}
+	slot->used = FALSE;
+	tc->stats.inflight--;
+	tc->stats.released++;
+	ret = hb_mm_mc_queue_output_buffer(tc->decoder, &slot->frame,
+		tc->params.timeout);
+	if (ret != 0) {
+		VLOG(ERR, "%s <%s:%d> Failed to return decoded frame(%d).\n",
+			TAG, __FUNCTION__, __LINE__, ret);
+	}
+
+	return ret;
+}
+
+/* Take an encoder input buffer, its previous decoded frame is consumed */
+static hb_s32 transcode_dequeue_input(mc_transcode_t *tc)
+{
+	hb_s32 ret, idx;
+
+	if (tc->held) {
+		return 0;
+	}
+	memset(&tc->input, 0x00, sizeof(tc->input));
+	ret = hb_mm_mc_dequeue_input_buffer(tc->encoder, &tc->input,
+		tc->params.timeout);
+	if (ret != 0) {
+		tc->stats.encoder_stalls++;
+		return ret;
+	}
+	/* a buffer without a slot goes back empty, the next pump takes another */
+	idx = tc->input.vframe_buf.src_idx;
+	if ((idx < 0) || (idx >= MC_TRANSCODE_MAX_INFLIGHT)) {
+		VLOG(ERR, "%s <%s:%d> Invalid input buffer index %d.\n",
+			TAG, __FUNCTION__, __LINE__, idx);
+		tc->input.vframe_buf.size = 0;
+		tc->input.vframe_buf.frame_end = FALSE;
+		ret = hb_mm_mc_queue_input_buffer(tc->encoder, &tc->input,
+			tc->params.timeout);
+		if (ret != 0) {
+			VLOG(ERR, "%s <%s:%d> Failed to give back input buffer(%d).\n",
+				TAG, __FUNCTION__, __LINE__, ret);
+		}
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	tc->held = TRUE;
+
+	return transcode_release_slot(tc, &tc->slots[idx]);
+}
+
+static hb_s32 transcode_queue_end(mc_transcode_t *tc)
+{
+	hb_s32 ret;
+
+	tc->input.vframe_buf.size = 0;
+	tc->input.vframe_buf.frame_end = TRUE;
+	ret = hb_mm_mc_queue_input_buffer(tc->encoder, &tc->input,
+		tc->params.timeout);
+	if (ret != 0) {
+		VLOG(ERR, "%s <%s:%d> Failed to queue end of stream(%d).\n",
+			TAG, __FUNCTION__, __LINE__, ret);
+		return ret;
+	}
+	tc->held = FALSE;
+	tc->stats.eos = TRUE;
+
+	return 0;
+}
+
+hb_s32 hb_mm_transcode_create(const mc_transcode_params_t *params,
+		media_codec_context_t *decoder, media_codec_context_t *encoder,
+		mc_transcode_t **tc)
+{
+	mc_transcode_t *t;
+
+	if ((params == NULL) || (decoder == NULL) || (encoder == NULL) ||
+		(tc == NULL)) {
+		VLOG(ERR, "%s <%s:%d> Invalid parameters(params=%p, tc=%p).\n",
+			TAG, __FUNCTION__, __LINE__, params, tc);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (decoder->encoder || !encoder->encoder ||
+		!encoder->video_enc_params.external_frame_buf) {
+		VLOG(ERR, "%s <%s:%d> Need a decoder and an encoder with external "
+			"frame buffers.\n", TAG, __FUNCTION__, __LINE__);
+		return HB_MEDIA_ERR_INVALID_INSTANCE;
+	}
+	if ((encoder->video_enc_params.frame_buf_count == 0) ||
+		(encoder->video_enc_params.frame_buf_count >
+		MC_TRANSCODE_MAX_INFLIGHT) ||
+		(decoder->video_dec_params.frame_buf_count <=
+		encoder->video_enc_params.frame_buf_count)) {
+		VLOG(ERR, "%s <%s:%d> Invalid frame buffer count(dec=%u, enc=%u).\n",
+			TAG, __FUNCTION__, __LINE__,
+			decoder->video_dec_params.frame_buf_count,
+			encoder->video_enc_params.frame_buf_count);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	t = (mc_transcode_t *)calloc(1, sizeof(*t));
+	if (t == NULL) {
+		return HB_MEDIA_ERR_INSUFFICIENT_RES;
+	}
+	t->params = *params;
+	t->decoder = decoder;
+	t->encoder = encoder;
+
+	*tc = t;
+	return 0;
+}
+
+hb_s32 hb_mm_transcode_pump(mc_transcode_t *tc)
+{
+	mc_video_codec_enc_params_t *enc;
+	mc_video_frame_buffer_info_t *src, *dst;
+	media_codec_output_buffer_info_t info;
+	media_codec_buffer_t frame;
+	transcode_slot_t *slot;
+	hb_s32 ret, i;
+
+	if (tc == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	if (tc->stats.eos) {
+		return HB_MEDIA_ERR_OPERATION_NOT_ALLOWED;
+	}
+
+	ret = transcode_dequeue_input(tc);
+	if (ret != 0) {
+		return ret;
+	}
+	if (tc->dec_end) {
+		return transcode_queue_end(tc);
+	}
+
+	memset(&frame, 0x00, sizeof(frame));
+	memset(&info, 0x00, sizeof(info));
+	ret = hb_mm_mc_dequeue_output_buffer(tc->decoder, &frame, &info,
+		tc->params.timeout);
+	if (ret != 0) {
+		/* the input buffer stays held for the next decoded frame */
+		tc->stats.decoder_stalls++;
+		return ret;
+	}
+	src = &frame.vframe_buf;
+	if (src->frame_end) {
+		tc->dec_end = TRUE;
+	}
+	if (src->size == 0) {
+		ret = hb_mm_mc_queue_output_buffer(tc->decoder, &frame,
+			tc->params.timeout);
+		if ((ret == 0) && tc->dec_end) {
+			ret = transcode_queue_end(tc);
+		}
+		return ret;
+	}
+
+	enc = &tc->encoder->video_enc_params;
+	if ((src->width != enc->width) || (src->height != enc->height) ||
+		(src->pix_fmt != enc->pix_fmt)) {
+		VLOG(ERR, "%s <%s:%d> Decoded frame %dx%d(%d) doesn't match the "
+			"encoder %dx%d(%d).\n", TAG, __FUNCTION__, __LINE__,
+			src->width, src->height, src->pix_fmt, enc->width, enc->height,
+			enc->pix_fmt);
+		hb_mm_mc_queue_output_buffer(tc->decoder, &frame, tc->params.timeout);
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+
+	/* only the addresses move, the planes stay where the decoder put them */
+	dst = &tc->input.vframe_buf;
+	for (i = 0; i < 3; i++) {
+		dst->vir_ptr[i] = src->vir_ptr[i];
+		dst->phy_ptr[i] = src->phy_ptr[i];
+		dst->fd[i] = src->fd[i];
+		dst->compSize[i] = src->compSize[i];
+	}
+	dst->size = src->size;
+	dst->width = src->width;
+	dst->height = src->height;
+	dst->pix_fmt = src->pix_fmt;
+	dst->stride = src->stride;
+	dst->vstride = src->vstride;
+	dst->pts = src->pts;
+	dst->frame_end = FALSE;
+	ret = hb_mm_mc_queue_input_buffer(tc->encoder, &tc->input,
+		tc->params.timeout);
+	if (ret != 0) {
+		VLOG(ERR, "%s <%s:%d> Failed to queue decoded frame(%d).\n",
+			TAG, __FUNCTION__, __LINE__, ret);
+		hb_mm_mc_queue_output_buffer(tc->decoder, &frame, tc->params.timeout);
+		return ret;
+	}
+	tc->held = FALSE;
+
+	slot = &tc->slots[dst->src_idx];
+	slot->frame = frame;
+	slot->used = TRUE;
+	tc->stats.frames++;
+	tc->stats.inflight++;
+	if (tc->stats.inflight > tc->stats.max_inflight) {
+		tc->stats.max_inflight = tc->stats.inflight;
+	}
+
+	return 0;
+}
+
+hb_s32 hb_mm_transcode_get_stats(mc_transcode_t *tc,
+		mc_transcode_stats_t *stats)
+{
+	if ((tc == NULL) || (stats == NULL)) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	*stats = tc->stats;
+
+	return 0;
+}
+
+hb_s32 hb_mm_transcode_destroy(mc_transcode_t *tc)
+{
+	hb_s32 i;
+
+	if (tc == NULL) {
+		return HB_MEDIA_ERR_INVALID_PARAMS;
+	}
+	for (i = 0; i < MC_TRANSCODE_MAX_INFLIGHT; i++) {
+		transcode_release_slot(tc, &tc->slots[i]);
+	}
+	free(tc);
+
+	return 0;
+}